@@ -4,6 +4,8 @@
  */
 
 #include "effect_syntax_tree.hpp"
+#include <cmath>
+#include <cstring>
 #include <algorithm>
 
 namespace reshadefx
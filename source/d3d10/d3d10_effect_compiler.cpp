@@ -196,6 +196,7 @@ namespace reshade::d3d10
 		_runtime(runtime),
 		_ast(ast),
 		_errors(errors),
+		_uniform_usage(ast),
 		_skip_shader_optimization(skipoptimization)
 	{
 #if RESHADE_DUMP_NATIVE_SHADERS
@@ -210,13 +211,16 @@ namespace reshade::d3d10
 
 	bool d3d10_effect_compiler::run()
 	{
-		_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_47.dll");
-
-		if (_d3dcompiler_module == nullptr)
+		// The library is kept loaded by the runtime, since techniques are only compiled once they are first enabled
+		if (_runtime->_d3d_compiler == nullptr)
+		{
+			_runtime->_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+		}
+		if (_runtime->_d3d_compiler == nullptr)
 		{
-			_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_43.dll");
+			_runtime->_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
 		}
-		if (_d3dcompiler_module == nullptr)
+		if (_runtime->_d3d_compiler == nullptr)
 		{
 			_errors += "Unable to load D3DCompiler library. Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.\n";
 			return false;
@@ -262,18 +266,8 @@ namespace reshade::d3d10
 		{
 			_constant_buffer_size = roundto16(_constant_buffer_size);
 			_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
-
-			const CD3D10_BUFFER_DESC globals_desc(static_cast<UINT>(_constant_buffer_size), D3D10_BIND_CONSTANT_BUFFER, D3D10_USAGE_DYNAMIC, D3D10_CPU_ACCESS_WRITE);
-			const D3D10_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data(), static_cast<UINT>(_constant_buffer_size) };
-
-			com_ptr<ID3D10Buffer> constant_buffer;
-			_runtime->_device->CreateBuffer(&globals_desc, &globals_initial, &constant_buffer);
-
-			_runtime->_constant_buffers.push_back(std::move(constant_buffer));
 		}
 
-		FreeLibrary(_d3dcompiler_module);
-
 		return _success;
 	}
 
@@ -1699,24 +1693,6 @@ namespace reshade::d3d10
 	}
 	void d3d10_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
-		visit(_global_uniforms, node->type);
-
-		_global_uniforms << ' ' << node->unique_name;
-
-		if (node->type.is_array())
-		{
-			_global_uniforms << '[';
-
-			if (node->type.array_length > 0)
-			{
-				_global_uniforms << node->type.array_length;
-			}
-
-			_global_uniforms << ']';
-		}
-
-		_global_uniforms << ";\n";
-
 		uniform obj;
 		obj.name = node->name;
 		obj.unique_name = node->unique_name;
@@ -1747,6 +1723,8 @@ namespace reshade::d3d10
 			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
 		}
 
+		_uniform_storage_offsets[node] = obj.storage_offset;
+
 		_runtime->add_uniform(std::move(obj));
 	}
 	void d3d10_effect_compiler::visit_technique(const technique_declaration_node *node)
@@ -1764,16 +1742,80 @@ namespace reshade::d3d10
 		query_desc.Query = D3D10_QUERY_TIMESTAMP_DISJOINT;
 		_runtime->_device->CreateQuery(&query_desc, &obj_data->timestamp_disjoint);
 
-		if (_constant_buffer_size != 0)
+		// Lay out a compact constant buffer containing only the uniforms this technique actually references
+		const auto layout = layout_uniform_block(_uniform_usage.find(node), uniform_packing::constant_buffer);
+
+		std::stringstream uniforms;
+		std::vector<size_t> storage_offsets;
+
+		uniforms << "cbuffer __GLOBAL__ : register(b0)\n{\n";
+
+		for (auto uniform : layout.uniforms)
+		{
+			visit(uniforms, uniform->type);
+
+			uniforms << ' ' << uniform->unique_name;
+
+			if (uniform->type.is_array())
+			{
+				uniforms << '[' << uniform->type.array_length << ']';
+			}
+
+			uniforms << ";\n";
+
+			storage_offsets.push_back(_uniform_storage_offsets.at(uniform));
+		}
+
+		uniforms << "};\n";
+
+		// Other uniforms may still be referenced by functions this technique does not use, so declare them as plain variables to keep the code valid
+		for (auto variable : _ast.variables)
+		{
+			if (_uniform_storage_offsets.count(variable) && std::find(layout.uniforms.begin(), layout.uniforms.end(), variable) == layout.uniforms.end())
+			{
+				uniforms << "static ";
+
+				visit(uniforms, variable->type, false);
+
+				uniforms << ' ' << variable->unique_name;
+
+				if (variable->type.is_array())
+				{
+					uniforms << '[' << variable->type.array_length << ']';
+				}
+
+				uniforms << ";\n";
+			}
+		}
+
+		_technique_uniforms = uniforms.str();
+		_shader_source.reset();
+
+		if (layout.size != 0)
 		{
+			const CD3D10_BUFFER_DESC globals_desc(static_cast<UINT>(layout.size), D3D10_BIND_CONSTANT_BUFFER, D3D10_USAGE_DYNAMIC, D3D10_CPU_ACCESS_WRITE);
+
+			com_ptr<ID3D10Buffer> constant_buffer;
+			const HRESULT hr = _runtime->_device->CreateBuffer(&globals_desc, nullptr, &constant_buffer);
+
+			if (FAILED(hr))
+			{
+				error(node->location, "'CreateBuffer' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+				return;
+			}
+
 			obj.uniform_storage_index = _runtime->_constant_buffers.size();
-			obj.uniform_storage_offset = _uniform_storage_offset;
+			obj.uniform_block_size = layout.size;
+			obj.uniform_block_ranges = build_uniform_copy_ranges(layout, storage_offsets);
+
+			_runtime->_constant_buffers.push_back(std::move(constant_buffer));
 		}
 
 		for (auto pass : node->pass_list)
 		{
 			obj.passes.emplace_back(std::make_unique<d3d10_pass_data>());
 			visit_pass(pass, *static_cast<d3d10_pass_data *>(obj.passes.back().get()));
+			obj.pass_texture_usage.push_back(analyze_texture_access(_uniform_usage, pass));
 		}
 
 		_runtime->add_technique(std::move(obj));
@@ -1785,6 +1827,7 @@ namespace reshade::d3d10
 		pass.viewport.MinDepth = 0.0f;
 		pass.viewport.MaxDepth = 1.0f;
 		pass.clear_render_targets = node->clear_render_targets;
+		pass.back_buffer_usage = analyze_back_buffer_access(_uniform_usage, node);
 		ZeroMemory(pass.render_targets, sizeof(pass.render_targets));
 		ZeroMemory(pass.render_target_resources, sizeof(pass.render_target_resources));
 		pass.shader_resources = _runtime->_effect_shader_resources;
@@ -1928,6 +1971,8 @@ namespace reshade::d3d10
 				}
 			}
 		}
+
+		pass.update_view_resources();
 	}
 	void d3d10_effect_compiler::visit_pass_shader(const function_declaration_node *node, const std::string &shadertype, d3d10_pass_data &pass)
 	{
@@ -1959,48 +2004,54 @@ namespace reshade::d3d10
 				break;
 		}
 
-		std::string source =
-			"#pragma warning(disable: 3571)\n"
-			"struct __sampler2D { Texture2D t; SamplerState s; };\n"
-			"inline float4 __tex2D(__sampler2D s, float2 c) { return s.t.Sample(s.s, c); }\n"
-			"inline float4 __tex2Dfetch(__sampler2D s, int4 c) { return s.t.Load(c.xyw); }\n"
-			"inline float4 __tex2Dgrad(__sampler2D s, float2 c, float2 ddx, float2 ddy) { return s.t.SampleGrad(s.s, c, ddx, ddy); }\n"
-			"inline float4 __tex2Dlod(__sampler2D s, float4 c) { return s.t.SampleLevel(s.s, c.xy, c.w); }\n"
-			"inline float4 __tex2Dlodoffset(__sampler2D s, float4 c, int2 offset) { return s.t.SampleLevel(s.s, c.xy, c.w, offset); }\n"
-			"inline float4 __tex2Doffset(__sampler2D s, float2 c, int2 offset) { return s.t.Sample(s.s, c, offset); }\n"
-			"inline float4 __tex2Dproj(__sampler2D s, float4 c) { return s.t.Sample(s.s, c.xy / c.w); }\n"
-			"inline int2 __tex2Dsize(__sampler2D s, int lod) { uint w, h, l; s.t.GetDimensions(lod, w, h, l); return int2(w, h); }\n";
-
-		if (featurelevel >= D3D10_FEATURE_LEVEL_10_1)
-		{
-			source +=
-				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return s.t.Gather(s.s, c); }\n"
-				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return s.t.Gather(s.s, c, offset); }\n";
-		}
-		else
+		// The source is identical for all shaders in a technique, so only generate it once and share it between passes
+		if (_shader_source == nullptr)
 		{
+			std::string source =
+				"#pragma warning(disable: 3571)\n"
+				"struct __sampler2D { Texture2D t; SamplerState s; };\n"
+				"inline float4 __tex2D(__sampler2D s, float2 c) { return s.t.Sample(s.s, c); }\n"
+				"inline float4 __tex2Dfetch(__sampler2D s, int4 c) { return s.t.Load(c.xyw); }\n"
+				"inline float4 __tex2Dgrad(__sampler2D s, float2 c, float2 ddx, float2 ddy) { return s.t.SampleGrad(s.s, c, ddx, ddy); }\n"
+				"inline float4 __tex2Dlod(__sampler2D s, float4 c) { return s.t.SampleLevel(s.s, c.xy, c.w); }\n"
+				"inline float4 __tex2Dlodoffset(__sampler2D s, float4 c, int2 offset) { return s.t.SampleLevel(s.s, c.xy, c.w, offset); }\n"
+				"inline float4 __tex2Doffset(__sampler2D s, float2 c, int2 offset) { return s.t.Sample(s.s, c, offset); }\n"
+				"inline float4 __tex2Dproj(__sampler2D s, float4 c) { return s.t.Sample(s.s, c.xy / c.w); }\n"
+				"inline int2 __tex2Dsize(__sampler2D s, int lod) { uint w, h, l; s.t.GetDimensions(lod, w, h, l); return int2(w, h); }\n";
+
+			if (featurelevel >= D3D10_FEATURE_LEVEL_10_1)
+			{
+				source +=
+					"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return s.t.Gather(s.s, c); }\n"
+					"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return s.t.Gather(s.s, c, offset); }\n";
+			}
+			else
+			{
+				source +=
+					"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0).r); }\n"
+					"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0, offset).r); }\n";
+			}
+
 			source +=
-				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0).r); }\n"
-				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0, offset).r); }\n";
-		}
+				"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0).g); }\n"
+				"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0, offset).g); }\n"
+				"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0).b); }\n"
+				"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0, offset).b); }\n"
+				"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0).a); }\n"
+				"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0, offset).a); }\n";
+
+			source += _technique_uniforms;
 
-		source +=
-			"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0).g); }\n"
-			"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0, offset).g); }\n"
-			"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0).b); }\n"
-			"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0, offset).b); }\n"
-			"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0).a); }\n"
-			"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0, offset).a); }\n";
+			for (const auto &samplerdesc : _runtime->_effect_sampler_descs)
+			{
+				source += "SamplerState __SamplerState" + std::to_string(samplerdesc.second) + " : register(s" + std::to_string(samplerdesc.second) + ");\n";
+			}
 
-		source += "cbuffer __GLOBAL__ : register(b0)\n{\n" + _global_uniforms.str() + "};\n";
+			source += _global_code.str();
 
-		for (const auto &samplerdesc : _runtime->_effect_sampler_descs)
-		{
-			source += "SamplerState __SamplerState" + std::to_string(samplerdesc.second) + " : register(s" + std::to_string(samplerdesc.second) + ");\n";
+			_shader_source = std::make_shared<const std::string>(std::move(source));
 		}
 
-		source += _global_code.str();
-
 #if RESHADE_DUMP_NATIVE_SHADERS
 		if (!_dumped_shaders.count(node->unique_name))
 		{
@@ -2008,48 +2059,24 @@ namespace reshade::d3d10
 
 			if (dumpfile.is_open())
 			{
-				dumpfile << "#ifdef RESHADE_SHADER_" << shadertype << "_" << node->unique_name << std::endl << source << "#endif" << std::endl << std::endl;
+				dumpfile << "#ifdef RESHADE_SHADER_" << shadertype << "_" << node->unique_name << std::endl << *_shader_source << "#endif" << std::endl << std::endl;
 
 				_dumped_shaders.insert(node->unique_name);
 			}
 		}
 #endif
 
-		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		com_ptr<ID3DBlob> compiled, errors;
-
-		if (_skip_shader_optimization)
-		{
-			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
-		}
-
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
-		HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &compiled, &errors);
-
-		if (errors != nullptr)
-		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
-		}
-
-		if (FAILED(hr))
-		{
-			error(node->location, "internal shader compilation failed");
-			return;
-		}
+		// Compilation is deferred until the technique is first enabled, so just store everything needed for it
+		const unsigned int index = shadertype == "vs" ? 0 : 1;
 
-		if (shadertype == "vs")
-		{
-			hr = _runtime->_device->CreateVertexShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.vertex_shader);
-		}
-		else if (shadertype == "ps")
-		{
-			hr = _runtime->_device->CreatePixelShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.pixel_shader);
-		}
+		pass.shader_source = _shader_source;
+		pass.shader_entry_points[index] = node->unique_name;
+		pass.shader_profiles[index] = profile;
+		pass.shader_compile_flags = D3DCOMPILE_ENABLE_STRICTNESS;
 
-		if (FAILED(hr))
+		if (_skip_shader_optimization)
 		{
-			error(node->location, "'CreateShader' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-			return;
+			pass.shader_compile_flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 	}
 }
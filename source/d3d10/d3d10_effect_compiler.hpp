@@ -5,7 +5,8 @@
 
 #pragma once
 
-#include "effect_syntax_tree.hpp"
+#include "effect_uniform_usage.hpp"
+#include <memory>
 #include <sstream>
 #include <unordered_set>
 
@@ -68,10 +69,13 @@ namespace reshade::d3d10
 		bool _success = true;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
-		std::stringstream _global_code, _global_uniforms;
+		reshadefx::uniform_usage _uniform_usage;
+		std::stringstream _global_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _uniform_storage_offsets;
+		std::string _technique_uniforms;
 		bool _skip_shader_optimization, _is_in_parameter_block = false, _is_in_function_block = false;
 		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0;
-		HMODULE _d3dcompiler_module = nullptr;
+		std::shared_ptr<const std::string> _shader_source;
 #if RESHADE_DUMP_NATIVE_SHADERS
 		filesystem::path _dump_filename;
 		std::unordered_set<std::string> _dumped_shaders;
@@ -11,6 +11,7 @@
 #include "resource_loading.hpp"
 #include <imgui.h>
 #include <algorithm>
+#include <d3dcompiler.h>
 
 namespace reshade::d3d10
 {
@@ -18,6 +19,31 @@ namespace reshade::d3d10
 	extern DXGI_FORMAT make_format_normal(DXGI_FORMAT format);
 	extern DXGI_FORMAT make_format_typeless(DXGI_FORMAT format);
 
+	// Resolve the resources the views of a pass belong to, which the state cache uses to detect when a texture is bound for reading and writing at the same time
+	void d3d10_pass_data::update_view_resources()
+	{
+		for (UINT i = 0; i < D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+		{
+			render_target_view_resources[i].reset();
+
+			if (render_targets[i] != nullptr)
+			{
+				render_targets[i]->GetResource(&render_target_view_resources[i]);
+			}
+		}
+
+		shader_resource_view_resources.clear();
+		shader_resource_view_resources.resize(shader_resources.size());
+
+		for (size_t i = 0; i < shader_resources.size(); i++)
+		{
+			if (shader_resources[i] != nullptr)
+			{
+				shader_resources[i]->GetResource(&shader_resource_view_resources[i]);
+			}
+		}
+	}
+
 	d3d10_runtime::d3d10_runtime(ID3D10Device1 *device, IDXGISwapChain *swapchain) :
 		runtime(device->GetFeatureLevel()), _device(device), _swapchain(swapchain),
 		_stateblock(device)
@@ -45,6 +71,11 @@ namespace reshade::d3d10
 		_vendor_id = adapter_desc.VendorId;
 		_device_id = adapter_desc.DeviceId;
 
+		// Ignore depth buffers whose aspect ratio or size is too different from the back buffer, e.g. shadow maps
+		_depth_buffer_selector.settings().max_aspect_ratio_difference = 0.1f;
+		_depth_buffer_selector.settings().min_scale = 0.5f;
+		_depth_buffer_selector.settings().max_scale = 2.0f;
+
 		subscribe_to_menu("DX10", [this]() { draw_debug_menu(); });
 		subscribe_to_load_config([this](const ini_file& config) {
 			config.get("DX10_BUFFER_DETECTION", "DepthBufferRetrievalMode", depth_buffer_before_clear);
@@ -106,8 +137,8 @@ namespace reshade::d3d10
 			_backbuffer_resolved = _backbuffer;
 		}
 
-		// Create back buffer shader texture
-		texdesc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
+		// Create back buffer shader texture, which passes may also render to when ping-ponging with the second one created below
+		texdesc.BindFlags = D3D10_BIND_SHADER_RESOURCE | D3D10_BIND_RENDER_TARGET;
 
 		hr = _device->CreateTexture2D(&texdesc, nullptr, &_backbuffer_texture);
 
@@ -155,6 +186,38 @@ namespace reshade::d3d10
 			return false;
 		}
 
+		hr = _device->CreateTexture2D(&texdesc, nullptr, &_backbuffer_texture_pingpong);
+
+		if (FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create back buffer ping-pong texture ("
+				"Width = " << texdesc.Width << ", "
+				"Height = " << texdesc.Height << ", "
+				"Format = " << texdesc.Format << ")! HRESULT is '" << std::hex << hr << std::dec << "'.";
+			return false;
+		}
+
+		for (int srgb = 0; srgb < 2; srgb++)
+		{
+			D3D10_SHADER_RESOURCE_VIEW_DESC srvdesc = { };
+			srvdesc.Format = srgb ? make_format_srgb(texdesc.Format) : make_format_normal(texdesc.Format);
+			srvdesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2D;
+			srvdesc.Texture2D.MipLevels = texdesc.MipLevels;
+
+			D3D10_RENDER_TARGET_VIEW_DESC rtdesc = { };
+			rtdesc.Format = srvdesc.Format;
+			rtdesc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2D;
+
+			if (FAILED(hr = _device->CreateShaderResourceView(_backbuffer_texture_pingpong.get(), &srvdesc, &_backbuffer_texture_pingpong_srv[srgb])) ||
+				FAILED(hr = _device->CreateRenderTargetView(_backbuffer_texture.get(), &rtdesc, &_backbuffer_texture_rtv[srgb])) ||
+				FAILED(hr = _device->CreateRenderTargetView(_backbuffer_texture_pingpong.get(), &rtdesc, &_backbuffer_texture_pingpong_rtv[srgb])))
+			{
+				LOG(ERROR) << "Failed to create back buffer ping-pong views ("
+					"Format = " << srvdesc.Format << ")! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
+			}
+		}
+
 		D3D10_RENDER_TARGET_VIEW_DESC rtdesc = { };
 		rtdesc.Format = make_format_normal(texdesc.Format);
 		rtdesc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2D;
@@ -439,6 +502,23 @@ namespace reshade::d3d10
 		_width = desc.BufferDesc.Width;
 		_height = desc.BufferDesc.Height;
 		_backbuffer_format = desc.BufferDesc.Format;
+
+		// Effects can rely on the color they write being clamped only if the back buffer has a normalized format
+		switch (_backbuffer_format)
+		{
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8X8_UNORM:
+			case DXGI_FORMAT_R10G10B10A2_UNORM:
+				_is_backbuffer_normalized = true;
+				break;
+			default:
+				_is_backbuffer_normalized = false;
+				break;
+		}
+
 		_is_multisampling_enabled = desc.SampleDesc.Count > 1;
 		_input = input::register_window(desc.OutputWindow);
 
@@ -462,15 +542,28 @@ namespace reshade::d3d10
 
 		runtime::on_reset();
 
+		if (_d3d_compiler != nullptr)
+		{
+			FreeLibrary(_d3d_compiler);
+			_d3d_compiler = nullptr;
+		}
+
 		// Destroy resources
 		_backbuffer.reset();
 		_backbuffer_resolved.reset();
 		_backbuffer_texture.reset();
+		_backbuffer_texture_pingpong.reset();
 		_backbuffer_texture_srv[0].reset();
 		_backbuffer_texture_srv[1].reset();
+		_backbuffer_texture_pingpong_srv[0].reset();
+		_backbuffer_texture_pingpong_srv[1].reset();
 		_backbuffer_rtv[0].reset();
 		_backbuffer_rtv[1].reset();
 		_backbuffer_rtv[2].reset();
+		_backbuffer_texture_rtv[0].reset();
+		_backbuffer_texture_rtv[1].reset();
+		_backbuffer_texture_pingpong_rtv[0].reset();
+		_backbuffer_texture_pingpong_rtv[1].reset();
 
 		_depthstencil.reset();
 		_depthstencil_replacement.reset();
@@ -550,6 +643,9 @@ namespace reshade::d3d10
 		// Capture device state
 		_stateblock.capture();
 
+		// The application may have changed any state since the last frame
+		_state_cache.invalidate();
+
 		// Disable unused pipeline stages
 		_device->GSSetShader(nullptr);
 
@@ -578,7 +674,17 @@ namespace reshade::d3d10
 			_device->VSSetSamplers(0, static_cast<UINT>(_effect_sampler_states.size()), reinterpret_cast<ID3D10SamplerState *const *>(_effect_sampler_states.data()));
 			_device->PSSetSamplers(0, static_cast<UINT>(_effect_sampler_states.size()), reinterpret_cast<ID3D10SamplerState *const *>(_effect_sampler_states.data()));
 
+			_back_buffer_planner.begin_frame();
+
 			on_present_effect();
+
+			// Passes may have left the final image in one of the back buffer textures
+			const int final_surface = _back_buffer_planner.end_frame();
+
+			if (final_surface > 0)
+			{
+				_device->CopyResource(_backbuffer_resolved.get(), final_surface == 1 ? _backbuffer_texture.get() : _backbuffer_texture_pingpong.get());
+			}
 		}
 
 		// Apply presenting
@@ -699,7 +805,27 @@ namespace reshade::d3d10
 	{
 		return d3d10_effect_compiler(this, ast, errors, false).run();
 	}
-	bool d3d10_runtime::update_texture(texture &texture, const uint8_t *data)
+	upload_layout d3d10_runtime::get_upload_layout(const texture &texture) const
+	{
+		upload_layout layout;
+		layout.levels = texture.levels;
+
+		// The 8-bit formats with fewer channels are tightly packed
+		switch (texture.format)
+		{
+			case texture_format::r8:
+				layout.bytes_per_pixel = 1;
+				break;
+			case texture_format::rg8:
+				layout.bytes_per_pixel = 2;
+				break;
+			default:
+				break;
+		}
+
+		return layout;
+	}
+	bool d3d10_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
 	{
 		if (texture.impl_reference != texture_reference::none)
 		{
@@ -711,41 +837,167 @@ namespace reshade::d3d10
 		assert(data != nullptr);
 		assert(texture_impl != nullptr);
 
-		switch (texture.format)
+		// The texture loader already converted the data and generated all mipmap levels, so there is nothing left to do but copy them
+		for (UINT level = 0; level < std::min(static_cast<UINT>(levels.size()), texture.levels); level++)
 		{
-			case texture_format::r8:
+			_device->UpdateSubresource(texture_impl->texture.get(), level, nullptr, data + levels[level].offset, static_cast<UINT>(levels[level].row_pitch), static_cast<UINT>(levels[level].row_pitch * levels[level].height));
+		}
+
+		return true;
+	}
+	bool d3d10_runtime::alias_texture(texture &texture, const texture &owner)
+	{
+		const auto texture_impl = texture.impl->as<d3d10_tex_data>();
+		const auto owner_impl = owner.impl->as<d3d10_tex_data>();
+
+		if (texture_impl == nullptr || owner_impl == nullptr)
+		{
+			return false;
+		}
+
+		// Render target views are only created for the formats a texture is rendered with, so the owner may be missing some
+		for (unsigned int i = 0; i < 2; i++)
+		{
+			if (texture_impl->rtv[i] == nullptr || owner_impl->rtv[i] != nullptr)
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k++)
-					data2[k] = data[i];
-				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width, texture.width * texture.height);
-				break;
+				continue;
 			}
-			case texture_format::rg8:
+
+			D3D10_RENDER_TARGET_VIEW_DESC rtvdesc;
+			texture_impl->rtv[i]->GetDesc(&rtvdesc);
+
+			const HRESULT hr = _device->CreateRenderTargetView(owner_impl->texture.get(), &rtvdesc, &owner_impl->rtv[i]);
+
+			if (FAILED(hr))
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height * 2);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k += 2)
-					data2[k] = data[i],
-					data2[k + 1] = data[i + 1];
-				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width * 2, texture.width * texture.height * 2);
-				break;
+				LOG(ERROR) << "Failed to create render target view for texture '" << owner.name << "'! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
 			}
-			default:
+		}
+
+		// Passes hold their own references to the views, so replace them everywhere
+		const auto replace_views = [texture_impl, owner_impl](auto first, auto last) {
+			for (unsigned int i = 0; i < 2; i++)
 			{
-				_device->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data, texture.width * 4, texture.width * texture.height * 4);
-				break;
+				if (texture_impl->srv[i] != nullptr)
+				{
+					std::replace(first, last, texture_impl->srv[i], owner_impl->srv[i]);
+				}
+			}
+		};
+
+		replace_views(_effect_shader_resources.begin(), _effect_shader_resources.end());
+
+		for (auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<d3d10_pass_data>();
+
+				replace_views(pass.shader_resources.begin(), pass.shader_resources.end());
+				replace_views(std::begin(pass.render_target_resources), std::end(pass.render_target_resources));
+
+				for (unsigned int i = 0; i < 2; i++)
+				{
+					if (texture_impl->rtv[i] != nullptr)
+					{
+						std::replace(std::begin(pass.render_targets), std::end(pass.render_targets), texture_impl->rtv[i], owner_impl->rtv[i]);
+					}
+				}
+
+				// Passes bind the views of all textures, so one rendering to the shared memory may now bind it for sampling too, which is not allowed
+				const bool renders_to_owner =
+					(owner_impl->rtv[0] != nullptr && std::find(std::begin(pass.render_targets), std::end(pass.render_targets), owner_impl->rtv[0]) != std::end(pass.render_targets)) ||
+					(owner_impl->rtv[1] != nullptr && std::find(std::begin(pass.render_targets), std::end(pass.render_targets), owner_impl->rtv[1]) != std::end(pass.render_targets));
+
+				if (renders_to_owner)
+				{
+					for (auto &srv : pass.shader_resources)
+					{
+						if (srv != nullptr && (srv == owner_impl->srv[0] || srv == owner_impl->srv[1]))
+						{
+							srv.reset();
+						}
+					}
+				}
+
+				pass.update_view_resources();
 			}
 		}
 
-		if (texture.levels > 1)
+		texture_impl->texture = owner_impl->texture;
+		texture_impl->srv[0] = owner_impl->srv[0];
+		texture_impl->srv[1] = owner_impl->srv[1];
+		texture_impl->rtv[0] = owner_impl->rtv[0];
+		texture_impl->rtv[1] = owner_impl->rtv[1];
+
+		return true;
+	}
+
+	bool d3d10_runtime::compile_technique(const std::vector<base_object *> &passes) const
+	{
+		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
+
+		if (D3DCompile == nullptr)
 		{
-			_device->GenerateMips(texture_impl->srv[0].get());
+			return false;
+		}
+
+		for (const auto pass_object : passes)
+		{
+			const auto pass = pass_object->as<d3d10_pass_data>();
+
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				if (pass->shader_entry_points[i].empty())
+				{
+					continue;
+				}
+
+				com_ptr<ID3DBlob> errors;
+				const HRESULT hr = D3DCompile(pass->shader_source->c_str(), pass->shader_source->size(), nullptr, nullptr, nullptr, pass->shader_entry_points[i].c_str(), pass->shader_profiles[i].c_str(), pass->shader_compile_flags, 0, &pass->shader_bytecode[i], &errors);
+
+				if (FAILED(hr))
+				{
+					LOG(ERROR) << "Failed to compile shader '" << pass->shader_entry_points[i] << "':\n" << (errors != nullptr ? static_cast<const char *>(errors->GetBufferPointer()) : "");
+					return false;
+				}
+			}
 		}
 
 		return true;
 	}
+	bool d3d10_runtime::create_technique_shaders(technique &technique)
+	{
+		for (const auto &pass_object : technique.passes)
+		{
+			const auto pass = pass_object->as<d3d10_pass_data>();
+
+			HRESULT hr = S_OK;
 
-	void d3d10_runtime::render_technique(const technique &technique)
+			if (pass->shader_bytecode[0] != nullptr)
+			{
+				hr = _device->CreateVertexShader(pass->shader_bytecode[0]->GetBufferPointer(), pass->shader_bytecode[0]->GetBufferSize(), &pass->vertex_shader);
+			}
+			if (SUCCEEDED(hr) && pass->shader_bytecode[1] != nullptr)
+			{
+				hr = _device->CreatePixelShader(pass->shader_bytecode[1]->GetBufferPointer(), pass->shader_bytecode[1]->GetBufferSize(), &pass->pixel_shader);
+			}
+
+			// The bytecode is no longer needed once the shader objects exist
+			pass->shader_bytecode[0].reset();
+			pass->shader_bytecode[1].reset();
+
+			if (FAILED(hr))
+			{
+				LOG(ERROR) << "Failed to create shaders for technique '" << technique.name << "'! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
+			}
+		}
+
+		return true;
+	}
+	void d3d10_runtime::render_technique(technique &technique)
 	{
 		d3d10_technique_data &technique_data = *technique.impl->as<d3d10_technique_data>();
 
@@ -760,73 +1012,162 @@ namespace reshade::d3d10
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
-			void *data = nullptr;
-			D3D10_BUFFER_DESC desc = { };
 			const auto constant_buffer = _constant_buffers[technique.uniform_storage_index].get();
 
-			constant_buffer->GetDesc(&desc);
-			const HRESULT hr = constant_buffer->Map(D3D10_MAP_WRITE_DISCARD, 0, &data);
-
-			if (SUCCEEDED(hr))
+			// Each technique owns its constant buffer, so it keeps its contents as long as no uniform in it changed
+			if (update_uniform_block(technique, _dirty_uniform_ranges))
 			{
-				CopyMemory(data, get_uniform_value_storage().data() + technique.uniform_storage_offset, desc.ByteWidth);
+				void *data = nullptr;
+
+				const HRESULT hr = constant_buffer->Map(D3D10_MAP_WRITE_DISCARD, 0, &data);
 
-				constant_buffer->Unmap();
+				if (SUCCEEDED(hr))
+				{
+					// Discarding invalidates the entire buffer, so always rewrite all of it
+					for (const auto &range : technique.uniform_block_ranges)
+					{
+						CopyMemory(static_cast<uint8_t *>(data) + range.block_offset, get_uniform_value_storage().data() + range.storage_offset, range.size);
+					}
+
+					constant_buffer->Unmap();
+				}
+				else
+				{
+					LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+
+					technique.uniform_block_generation = 0;
+				}
 			}
-			else
+
+			if (_state_cache.set_constant_buffer(reinterpret_cast<uintptr_t>(constant_buffer)))
 			{
-				LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				_device->VSSetConstantBuffers(0, 1, &constant_buffer);
+				_device->PSSetConstantBuffers(0, 1, &constant_buffer);
 			}
-
-			_device->VSSetConstantBuffers(0, 1, &constant_buffer);
-			_device->PSSetConstantBuffers(0, 1, &constant_buffer);
 		}
 
+		// Views are bound from the shadow state, so that slots the cache unbound to resolve hazards are included
+		const auto bind_shader_resources = [this](const state_slot_range &range) {
+			const auto views = reinterpret_cast<ID3D10ShaderResourceView *const *>(_state_cache.shader_resources() + range.first);
+			_device->VSSetShaderResources(range.first, range.count, views);
+			_device->PSSetShaderResources(range.first, range.count, views);
+		};
+		const auto bind_render_targets = [this]() {
+			_device->OMSetRenderTargets(D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D10RenderTargetView *const *>(_state_cache.render_targets()), reinterpret_cast<ID3D10DepthStencilView *>(_state_cache.depth_stencil()));
+		};
+
 		for (const auto &pass_object : technique.passes)
 		{
 			const d3d10_pass_data &pass = *pass_object->as<d3d10_pass_data>();
 
 			// Setup states
-			_device->VSSetShader(pass.vertex_shader.get());
-			_device->PSSetShader(pass.pixel_shader.get());
+			if (_state_cache.set_shaders(reinterpret_cast<uintptr_t>(pass.vertex_shader.get()), reinterpret_cast<uintptr_t>(pass.pixel_shader.get())))
+			{
+				_device->VSSetShader(pass.vertex_shader.get());
+				_device->PSSetShader(pass.pixel_shader.get());
+			}
 
-			_device->OMSetBlendState(pass.blend_state.get(), nullptr, D3D10_DEFAULT_SAMPLE_MASK);
-			_device->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			if (_state_cache.set_blend_state(reinterpret_cast<uintptr_t>(pass.blend_state.get())))
+			{
+				_device->OMSetBlendState(pass.blend_state.get(), nullptr, D3D10_DEFAULT_SAMPLE_MASK);
+			}
+			if (_state_cache.set_depth_stencil_state(reinterpret_cast<uintptr_t>(pass.depth_stencil_state.get()), pass.stencil_reference))
+			{
+				_device->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			}
 
-			// Save back buffer of previous pass
-			_device->CopyResource(_backbuffer_texture.get(), _backbuffer_resolved.get());
+			// Only copy the back buffer when the pass samples it and no texture holds the current contents, otherwise ping-pong between the back buffer textures
+			const auto step = _back_buffer_planner.plan_pass(pass.back_buffer_usage);
 
-			// Setup shader resources
-			_device->VSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), reinterpret_cast<ID3D10ShaderResourceView *const *>(pass.shader_resources.data()));
-			_device->PSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), reinterpret_cast<ID3D10ShaderResourceView *const *>(pass.shader_resources.data()));
+			ID3D10Texture2D *const surfaces[3] = { _backbuffer_resolved.get(), _backbuffer_texture.get(), _backbuffer_texture_pingpong.get() };
 
-			// Setup render targets
-			if (pass.viewport.Width == _width && pass.viewport.Height == _height)
+			if (step.copy_source >= 0)
 			{
-				_device->OMSetRenderTargets(D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D10RenderTargetView *const *>(pass.render_targets), _default_depthstencil.get());
+				_device->CopyResource(surfaces[step.copy_destination], surfaces[step.copy_source]);
+			}
 
-				if (!is_default_depthstencil_cleared)
-				{
-					is_default_depthstencil_cleared = true;
+			ID3D10RenderTargetView *render_targets[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			ID3D10Resource *render_target_view_resources[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
+
+			for (UINT i = 0; i < D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+			{
+				render_targets[i] = pass.render_targets[i].get();
+				render_target_view_resources[i] = pass.render_target_view_resources[i].get();
+			}
 
-					_device->ClearDepthStencilView(_default_depthstencil.get(), D3D10_CLEAR_DEPTH | D3D10_CLEAR_STENCIL, 1.0f, 0);
+			if (step.write_surface > 0)
+			{
+				const int srgb = pass.render_targets[0] == _backbuffer_rtv[1] ? 1 : 0;
+
+				render_targets[0] = step.write_surface == 1 ? _backbuffer_texture_rtv[srgb].get() : _backbuffer_texture_pingpong_rtv[srgb].get();
+				render_target_view_resources[0] = surfaces[step.write_surface];
+			}
+
+			// Setup render targets before shader resources, so that textures the previous pass rendered to are no longer bound for output when they are sampled
+			const bool is_viewport_sized = pass.viewport.Width == _width && pass.viewport.Height == _height;
+
+			state_slot_range unbound_shader_resources;
+
+			if (_state_cache.set_render_targets(reinterpret_cast<const uintptr_t *>(render_targets), reinterpret_cast<const uintptr_t *>(render_target_view_resources), D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<uintptr_t>(is_viewport_sized ? _default_depthstencil.get() : nullptr), unbound_shader_resources))
+			{
+				if (unbound_shader_resources.count != 0)
+				{
+					bind_shader_resources(unbound_shader_resources);
 				}
+
+				bind_render_targets();
 			}
-			else
+
+			if (is_viewport_sized && !is_default_depthstencil_cleared)
+			{
+				is_default_depthstencil_cleared = true;
+
+				_device->ClearDepthStencilView(_default_depthstencil.get(), D3D10_CLEAR_DEPTH | D3D10_CLEAR_STENCIL, 1.0f, 0);
+			}
+
+			if (_state_cache.set_viewport(pass.viewport.Width, pass.viewport.Height))
+			{
+				_device->RSSetViewports(1, &pass.viewport);
+			}
+
+			// Setup shader resources
+			ID3D10ShaderResourceView *shader_resources[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+			ID3D10Resource *shader_resource_view_resources[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+			const UINT shader_resource_count = std::min(static_cast<UINT>(pass.shader_resources.size()), static_cast<UINT>(D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT));
+
+			for (UINT i = 0; i < shader_resource_count; i++)
+			{
+				shader_resources[i] = pass.shader_resources[i].get();
+				shader_resource_view_resources[i] = pass.shader_resource_view_resources[i].get();
+			}
+
+			if (step.read_surface == 2)
 			{
-				_device->OMSetRenderTargets(D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D10RenderTargetView *const *>(pass.render_targets), nullptr);
+				shader_resources[0] = _backbuffer_texture_pingpong_srv[0].get();
+				shader_resources[1] = _backbuffer_texture_pingpong_srv[1].get();
+				shader_resource_view_resources[0] = shader_resource_view_resources[1] = _backbuffer_texture_pingpong.get();
 			}
 
-			_device->RSSetViewports(1, &pass.viewport);
+			bool unbound_render_targets;
+			const auto changed_shader_resources = _state_cache.set_shader_resources(reinterpret_cast<const uintptr_t *>(shader_resources), reinterpret_cast<const uintptr_t *>(shader_resource_view_resources), shader_resource_count, unbound_render_targets);
+
+			if (unbound_render_targets)
+			{
+				bind_render_targets();
+			}
+			if (changed_shader_resources.count != 0)
+			{
+				bind_shader_resources(changed_shader_resources);
+			}
 
 			if (pass.clear_render_targets)
 			{
-				for (const auto &target : pass.render_targets)
+				for (const auto target : render_targets)
 				{
 					if (target != nullptr)
 					{
 						const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-						_device->ClearRenderTargetView(target.get(), color);
+						_device->ClearRenderTargetView(target, color);
 					}
 				}
 			}
@@ -837,17 +1178,11 @@ namespace reshade::d3d10
 			_vertices += 3;
 			_drawcalls += 1;
 
-			// Reset render targets
-			_device->OMSetRenderTargets(0, nullptr, nullptr);
-
-			// Reset shader resources
-			ID3D10ShaderResourceView *null[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { nullptr };
-			_device->VSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), null);
-			_device->PSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), null);
-
 			// Update shader resources
-			for (const auto &resource : pass.render_target_resources)
+			for (UINT i = 0; i < D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
 			{
+				const auto &resource = pass.render_target_resources[i];
+
 				if (resource == nullptr)
 				{
 					continue;
@@ -858,6 +1193,12 @@ namespace reshade::d3d10
 
 				if (resource_desc.Texture2D.MipLevels > 1)
 				{
+					// Render targets stay bound until the next pass changes them, but mipmaps cannot be generated while the texture is bound for output
+					if (_state_cache.unbind_render_target_resource(reinterpret_cast<uintptr_t>(pass.render_target_view_resources[i].get())))
+					{
+						bind_render_targets();
+					}
+
 					_device->GenerateMips(resource.get());
 				}
 			}
@@ -1018,6 +1359,7 @@ namespace reshade::d3d10
 				runtime::save_config();
 				_current_tracker.reset();
 				create_depthstencil_replacement(nullptr, nullptr);
+				_depth_buffer_selector.reset();
 				return;
 			}
 
@@ -1168,6 +1510,7 @@ namespace reshade::d3d10
 			{
 				traffic = 0;
 				create_depthstencil_replacement(nullptr, nullptr);
+				_depth_buffer_selector.reset();
 				return;
 			}
 			else
@@ -1197,11 +1540,19 @@ namespace reshade::d3d10
 			return;
 		}
 
-		const auto best_snapshot = tracker.find_best_snapshot(_width, _height);
+		_depth_buffer_selector.begin_frame(_width, _height);
+		tracker.add_depth_buffers(_depth_buffer_selector);
+		_depth_buffer_selector.end_frame(tracker.total_drawcalls());
+
+		const auto best_match = reinterpret_cast<ID3D10DepthStencilView *>(_depth_buffer_selector.selected());
 
-		if (best_snapshot.depthstencil != nullptr)
+		if (best_match != nullptr && _depthstencil != best_match)
 		{
-			create_depthstencil_replacement(best_snapshot.depthstencil, best_snapshot.texture.get());
+			// The selected view may not have been used this frame, in which case it may no longer exist, so only switch to views the tracker still references
+			if (const auto best_snapshot = tracker.find_snapshot(best_match); best_snapshot != nullptr && best_snapshot->texture != nullptr)
+			{
+				create_depthstencil_replacement(best_match, best_snapshot->texture.get());
+			}
 		}
 	}
 
@@ -1337,8 +1688,15 @@ namespace reshade::d3d10
 		// Update effect textures
 		_effect_shader_resources[2] = _depthstencil_texture_srv;
 		for (const auto &technique : _techniques)
-			for (const auto &pass : technique.passes)
-				pass->as<d3d10_pass_data>()->shader_resources[2] = _depthstencil_texture_srv;
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<d3d10_pass_data>();
+
+				pass.shader_resources[2] = _depthstencil_texture_srv;
+				pass.update_view_resources();
+			}
+		}
 
 		return true;
 	}
@@ -7,6 +7,8 @@
 
 #include <d3d10_1.h>
 #include "runtime.hpp"
+#include "render_graph.hpp"
+#include "render_state_cache.hpp"
 #include "d3d10_stateblock.hpp"
 #include "draw_call_tracker.hpp"
 
@@ -26,10 +28,20 @@ namespace reshade::d3d10
 		com_ptr<ID3D10DepthStencilState> depth_stencil_state;
 		UINT stencil_reference;
 		bool clear_render_targets;
+		back_buffer_access back_buffer_usage;
 		com_ptr<ID3D10RenderTargetView> render_targets[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		com_ptr<ID3D10ShaderResourceView> render_target_resources[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		D3D10_VIEWPORT viewport;
 		std::vector<com_ptr<ID3D10ShaderResourceView>> shader_resources;
+		// Resources the views above belong to, which are resolved whenever the views change, so that binding them does not have to query every view again
+		com_ptr<ID3D10Resource> render_target_view_resources[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
+		std::vector<com_ptr<ID3D10Resource>> shader_resource_view_resources;
+		std::shared_ptr<const std::string> shader_source;
+		std::string shader_entry_points[2], shader_profiles[2];
+		UINT shader_compile_flags = 0;
+		com_ptr<ID3DBlob> shader_bytecode[2];
+
+		void update_view_resources();
 	};
 	struct d3d10_technique_data : base_object
 	{
@@ -52,9 +64,13 @@ namespace reshade::d3d10
 
 		void capture_frame(uint8_t *buffer) const override;
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
-		bool update_texture(texture &texture, const uint8_t *data) override;
+		upload_layout get_upload_layout(const texture &texture) const override;
+		bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) override;
+		bool alias_texture(texture &texture, const texture &owner) override;
 
-		void render_technique(const technique &technique) override;
+		bool compile_technique(const std::vector<base_object *> &passes) const override;
+		bool create_technique_shaders(technique &technique) override;
+		void render_technique(technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
 #if RESHADE_DX10_CAPTURE_DEPTH_BUFFERS
@@ -64,13 +80,16 @@ namespace reshade::d3d10
 		com_ptr<ID3D10Device1> _device;
 		com_ptr<IDXGISwapChain> _swapchain;
 
-		com_ptr<ID3D10Texture2D> _backbuffer_texture;
-		com_ptr<ID3D10RenderTargetView> _backbuffer_rtv[3];
-		com_ptr<ID3D10ShaderResourceView> _backbuffer_texture_srv[2], _depthstencil_texture_srv;
+		com_ptr<ID3D10Texture2D> _backbuffer_texture, _backbuffer_texture_pingpong;
+		com_ptr<ID3D10RenderTargetView> _backbuffer_rtv[3], _backbuffer_texture_rtv[2], _backbuffer_texture_pingpong_rtv[2];
+		com_ptr<ID3D10ShaderResourceView> _backbuffer_texture_srv[2], _backbuffer_texture_pingpong_srv[2], _depthstencil_texture_srv;
+		back_buffer_planner _back_buffer_planner { 2, true };
 		std::vector<com_ptr<ID3D10SamplerState>> _effect_sampler_states;
 		std::unordered_map<size_t, size_t> _effect_sampler_descs;
 		std::vector<com_ptr<ID3D10ShaderResourceView>> _effect_shader_resources;
 		std::vector<com_ptr<ID3D10Buffer>> _constant_buffers;
+		std::vector<uniform_copy_range> _dirty_uniform_ranges;
+		HMODULE _d3d_compiler = nullptr;
 
 		bool depth_buffer_before_clear = false;
 		bool extended_depth_buffer_detection = false;
@@ -109,6 +128,7 @@ namespace reshade::d3d10
 		bool _is_multisampling_enabled = false;
 		DXGI_FORMAT _backbuffer_format = DXGI_FORMAT_UNKNOWN;
 		d3d10_stateblock _stateblock;
+		render_state_cache _state_cache;
 		com_ptr<ID3D10Texture2D> _backbuffer, _backbuffer_resolved;
 		com_ptr<ID3D10DepthStencilView> _depthstencil, _depthstencil_replacement;
 		ID3D10DepthStencilView *_best_depth_stencil_overwrite = nullptr;
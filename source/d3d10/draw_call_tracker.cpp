@@ -1,6 +1,5 @@
 #include "draw_call_tracker.hpp"
 #include "log.hpp"
-#include <math.h>
 
 namespace reshade::d3d10
 {
@@ -246,12 +245,8 @@ namespace reshade::d3d10
 		}
 	}
 
-	draw_call_tracker::intermediate_snapshot_info draw_call_tracker::find_best_snapshot(UINT width, UINT height)
+	void draw_call_tracker::add_depth_buffers(depth_buffer_selector &selector)
 	{
-		const float aspect_ratio = float(width) / float(height);
-
-		intermediate_snapshot_info best_snapshot;
-
 		for (auto &[depthstencil, snapshot] : _counters_per_used_depthstencil)
 		{
 			if (snapshot.stats.drawcalls == 0 || snapshot.stats.vertices == 0)
@@ -275,24 +270,21 @@ namespace reshade::d3d10
 
 			assert((desc.BindFlags & D3D10_BIND_DEPTH_STENCIL) != 0);
 
-			// Check aspect ratio
-			const float width_factor = desc.Width != width ? float(width) / desc.Width : 1.0f;
-			const float height_factor = desc.Height != height ? float(height) / desc.Height : 1.0f;
-			const float texture_aspect_ratio = float(desc.Width) / float(desc.Height);
-
-			if (fabs(texture_aspect_ratio - aspect_ratio) > 0.1f || width_factor > 2.0f || height_factor > 2.0f || width_factor < 0.5f || height_factor < 0.5f)
-			{
-				// No match, not a good fit
-				continue;
-			}
-
-			if (snapshot.stats.drawcalls >= best_snapshot.stats.drawcalls)
+			selector.add_depth_buffer({ reinterpret_cast<uintptr_t>(depthstencil.get()), desc.Width, desc.Height, static_cast<uint32_t>(desc.Format), snapshot.stats.drawcalls, snapshot.stats.vertices });
+		}
+	}
+	const draw_call_tracker::intermediate_snapshot_info *draw_call_tracker::find_snapshot(ID3D10DepthStencilView *depthstencil) const
+	{
+		// Compare addresses instead of using 'find', which would add a reference to a view that may no longer exist
+		for (const auto &[key, snapshot] : _counters_per_used_depthstencil)
+		{
+			if (key == depthstencil)
 			{
-				best_snapshot = snapshot;
+				return &snapshot;
 			}
 		}
 
-		return best_snapshot;
+		return nullptr;
 	}
 
 	void draw_call_tracker::keep_cleared_depth_textures()
@@ -3,6 +3,7 @@
 #include <d3d10.h>
 #include <map>
 #include "com_ptr.hpp"
+#include "depth_buffer_selector.hpp"
 
 #define RESHADE_DX10_CAPTURE_DEPTH_BUFFERS 1
 #define RESHADE_DX10_CAPTURE_CONSTANT_BUFFERS 0
@@ -56,7 +57,8 @@ namespace reshade::d3d10
 
 		void keep_cleared_depth_textures();
 
-		intermediate_snapshot_info find_best_snapshot(UINT width, UINT height);
+		void add_depth_buffers(depth_buffer_selector &selector);
+		const intermediate_snapshot_info *find_snapshot(ID3D10DepthStencilView *depthstencil) const;
 		ID3D10Texture2D *find_best_cleared_depth_buffer_texture(UINT depth_buffer_clearing_number);
 #endif
 
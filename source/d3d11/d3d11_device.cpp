@@ -9,44 +9,136 @@
 #include "../dxgi/dxgi_device.hpp"
 #include "draw_call_tracker.hpp"
 
-void D3D11Device::add_commandlist_trackers(ID3D11CommandList* command_list, const reshade::d3d11::draw_call_tracker &tracker_source)
+// Draw call statistics recorded into a command list. These are attached to the command list as private data, so that no global lookup table is needed and they are released together with it.
+struct __declspec(uuid("C2F8A074-3EB8-4BF7-9FFF-A767B2DA1ED1")) commandlist_tracker : IUnknown
 {
-	assert(command_list != nullptr);
+	SLIST_ENTRY _pool_entry;
+	LONG _ref = 1;
+	reshade::d3d11::draw_call_tracker _tracker;
+
+	static commandlist_tracker *acquire();
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObj) override
+	{
+		if (ppvObj == nullptr)
+		{
+			return E_POINTER;
+		}
+		else if (riid == __uuidof(this) || riid == __uuidof(IUnknown))
+		{
+			AddRef();
+
+			*ppvObj = this;
+
+			return S_OK;
+		}
+
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return InterlockedIncrement(&_ref);
+	}
+	ULONG STDMETHODCALLTYPE Release() override;
+};
 
-	const std::lock_guard<std::mutex> lock(_trackers_per_commandlist_mutex);
+// Trackers of released command lists are recycled through a lock-free list, so that their containers do not have to be allocated again every frame
+// The application may still release command lists after this module was shut down, so the pool is only closed on unload and its members stay valid after that (they are trivially destructible).
+static struct commandlist_tracker_pool
+{
+	commandlist_tracker_pool()
+	{
+		InitializeSListHead(&head);
+	}
+	~commandlist_tracker_pool()
+	{
+		closed.store(true);
 
-	// Merges the counters in counters_source in the counters_per_commandlist for the command list specified
-	const auto it = _trackers_per_commandlist.find(command_list);
+		clear();
+	}
 
-	if (it == _trackers_per_commandlist.end())
+	void clear()
 	{
-		_trackers_per_commandlist.emplace(command_list, tracker_source);
+		while (const auto entry = InterlockedPopEntrySList(&head))
+		{
+			delete CONTAINING_RECORD(entry, commandlist_tracker, _pool_entry);
+		}
 	}
-	else
+
+	SLIST_HEADER head;
+	std::atomic<bool> closed = false;
+} s_commandlist_tracker_pool;
+
+commandlist_tracker *commandlist_tracker::acquire()
+{
+	if (const auto entry = InterlockedPopEntrySList(&s_commandlist_tracker_pool.head))
 	{
-		it->second.merge(tracker_source);
+		const auto tracker = CONTAINING_RECORD(entry, commandlist_tracker, _pool_entry);
+		tracker->_ref = 1;
+		return tracker;
 	}
+
+	return new commandlist_tracker();
 }
-void D3D11Device::merge_commandlist_trackers(ID3D11CommandList* command_list, reshade::d3d11::draw_call_tracker &tracker_destination)
+ULONG STDMETHODCALLTYPE commandlist_tracker::Release()
+{
+	const ULONG ref = InterlockedDecrement(&_ref);
+
+	if (ref == 0)
+	{
+		if (s_commandlist_tracker_pool.closed.load())
+		{
+			delete this;
+			return ref;
+		}
+
+		// Keep the containers, but drop all references to device objects before the tracker is reused
+		_tracker.reset();
+
+		InterlockedPushEntrySList(&s_commandlist_tracker_pool.head, &_pool_entry);
+
+		// The pool may have been closed in the meantime, in which case nobody would pick up the tracker again
+		if (s_commandlist_tracker_pool.closed.load())
+		{
+			s_commandlist_tracker_pool.clear();
+		}
+	}
+
+	return ref;
+}
+
+void D3D11Device::add_commandlist_trackers(ID3D11CommandList *command_list, reshade::d3d11::draw_call_tracker &tracker_source)
 {
 	assert(command_list != nullptr);
 
-	const std::lock_guard<std::mutex> lock(_trackers_per_commandlist_mutex);
+	commandlist_tracker *const tracker = commandlist_tracker::acquire();
 
-	// Merges the counters logged for the specified command list in the counters destination tracker specified
-	const auto it = _trackers_per_commandlist.find(command_list);
+	// Moves the counters into the tracker, which leaves the source with the empty containers of a recycled one
+	tracker_source.move_into(tracker->_tracker);
+
+	// The command list keeps a reference to the tracker until it is destroyed
+	command_list->SetPrivateDataInterface(__uuidof(commandlist_tracker), tracker);
+
+	tracker->Release();
+}
+void D3D11Device::merge_commandlist_trackers(ID3D11CommandList *command_list, reshade::d3d11::draw_call_tracker &tracker_destination)
+{
+	assert(command_list != nullptr);
+
+	commandlist_tracker *tracker = nullptr;
+	UINT size = sizeof(tracker);
 
-	if (it != _trackers_per_commandlist.end())
+	// Merges the counters logged for the specified command list in the counters destination tracker specified
+	if (SUCCEEDED(command_list->GetPrivateData(__uuidof(commandlist_tracker), &size, &tracker)) && tracker != nullptr)
 	{
-		tracker_destination.merge(it->second);
+		tracker_destination.merge(tracker->_tracker);
+
+		tracker->Release();
 	}
 }
 
 void D3D11Device::clear_drawcall_stats()
 {
-	const std::lock_guard<std::mutex> lock(_trackers_per_commandlist_mutex);
-
-	_trackers_per_commandlist.clear();
 	_clear_DSV_iter = 1;
 }
 
@@ -88,11 +88,12 @@ bool D3D11DeviceContext::save_depth_texture(ID3D11DepthStencilView *pDepthStenci
 
 void D3D11DeviceContext::track_active_rendertargets(UINT NumViews, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView)
 {
-	if (pDepthStencilView == nullptr)
-		return;
-
-	if (_device->_runtimes.empty())
+	if (pDepthStencilView == nullptr || _device->_runtimes.empty())
+	{
+		// Draw calls are not counted until a depth stencil is bound again
+		_draw_call_tracker.untrack_rendertargets();
 		return;
+	}
 
 	const auto runtime = _device->_runtimes.front();
 
@@ -254,14 +255,17 @@ void STDMETHODCALLTYPE D3D11DeviceContext::PSSetShaderResources(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::PSSetShader(ID3D11PixelShader *pPixelShader, ID3D11ClassInstance *const *ppClassInstances, UINT NumClassInstances)
 {
+	_state_tracker.ps_set_shader(pPixelShader, NumClassInstances);
 	_orig->PSSetShader(pPixelShader, ppClassInstances, NumClassInstances);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::PSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *const *ppSamplers)
 {
+	_state_tracker.ps_set_samplers(StartSlot, NumSamplers, ppSamplers);
 	_orig->PSSetSamplers(StartSlot, NumSamplers, ppSamplers);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::VSSetShader(ID3D11VertexShader *pVertexShader, ID3D11ClassInstance *const *ppClassInstances, UINT NumClassInstances)
 {
+	_state_tracker.vs_set_shader(pVertexShader, NumClassInstances);
 	_orig->VSSetShader(pVertexShader, ppClassInstances, NumClassInstances);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DrawIndexed(UINT IndexCount, UINT StartIndexLocation, INT BaseVertexLocation)
@@ -292,6 +296,7 @@ void STDMETHODCALLTYPE D3D11DeviceContext::PSSetConstantBuffers(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::IASetInputLayout(ID3D11InputLayout *pInputLayout)
 {
+	_state_tracker.ia_set_input_layout(pInputLayout);
 	_orig->IASetInputLayout(pInputLayout);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::IASetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer *const *ppVertexBuffers, const UINT *pStrides, const UINT *pOffsets)
@@ -318,10 +323,12 @@ void STDMETHODCALLTYPE D3D11DeviceContext::GSSetConstantBuffers(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::GSSetShader(ID3D11GeometryShader *pShader, ID3D11ClassInstance *const *ppClassInstances, UINT NumClassInstances)
 {
+	_state_tracker.gs_set_shader(pShader, NumClassInstances);
 	_orig->GSSetShader(pShader, ppClassInstances, NumClassInstances);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology)
 {
+	_state_tracker.ia_set_primitive_topology(Topology);
 	_orig->IASetPrimitiveTopology(Topology);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::VSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
@@ -330,6 +337,7 @@ void STDMETHODCALLTYPE D3D11DeviceContext::VSSetShaderResources(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::VSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *const *ppSamplers)
 {
+	_state_tracker.vs_set_samplers(StartSlot, NumSamplers, ppSamplers);
 	_orig->VSSetSamplers(StartSlot, NumSamplers, ppSamplers);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::Begin(ID3D11Asynchronous *pAsync)
@@ -366,16 +374,22 @@ void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargets(UINT NumViews, ID3
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView, UINT UAVStartSlot, UINT NumUAVs, ID3D11UnorderedAccessView *const *ppUnorderedAccessViews, const UINT *pUAVInitialCounts)
 {
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
-	track_active_rendertargets(NumRTVs, ppRenderTargetViews, pDepthStencilView);
+	// Only the unordered access views change in that case, the render targets stay bound
+	if (NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+	{
+		track_active_rendertargets(NumRTVs, ppRenderTargetViews, pDepthStencilView);
+	}
 #endif
 	_orig->OMSetRenderTargetsAndUnorderedAccessViews(NumRTVs, ppRenderTargetViews, pDepthStencilView, UAVStartSlot, NumUAVs, ppUnorderedAccessViews, pUAVInitialCounts);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetBlendState(ID3D11BlendState *pBlendState, const FLOAT BlendFactor[4], UINT SampleMask)
 {
+	_state_tracker.om_set_blend_state(pBlendState, BlendFactor, SampleMask);
 	_orig->OMSetBlendState(pBlendState, BlendFactor, SampleMask);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetDepthStencilState(ID3D11DepthStencilState *pDepthStencilState, UINT StencilRef)
 {
+	_state_tracker.om_set_depth_stencil_state(pDepthStencilState, StencilRef);
 	_orig->OMSetDepthStencilState(pDepthStencilState, StencilRef);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::SOSetTargets(UINT NumBuffers, ID3D11Buffer *const *ppSOTargets, const UINT *pOffsets)
@@ -407,14 +421,17 @@ void STDMETHODCALLTYPE D3D11DeviceContext::DispatchIndirect(ID3D11Buffer *pBuffe
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::RSSetState(ID3D11RasterizerState *pRasterizerState)
 {
+	_state_tracker.rs_set_state(pRasterizerState);
 	_orig->RSSetState(pRasterizerState);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::RSSetViewports(UINT NumViewports, const D3D11_VIEWPORT *pViewports)
 {
+	_state_tracker.rs_set_viewports(NumViewports, pViewports);
 	_orig->RSSetViewports(NumViewports, pViewports);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::RSSetScissorRects(UINT NumRects, const D3D11_RECT *pRects)
 {
+	_state_tracker.rs_set_scissor_rects(NumRects, pRects);
 	_orig->RSSetScissorRects(NumRects, pRects);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::CopySubresourceRegion(ID3D11Resource *pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ, ID3D11Resource *pSrcResource, UINT SrcSubresource, const D3D11_BOX *pSrcBox)
@@ -476,6 +493,15 @@ void STDMETHODCALLTYPE D3D11DeviceContext::ExecuteCommandList(ID3D11CommandList
 	}
 
 	_orig->ExecuteCommandList(pCommandList, RestoreContextState);
+
+	// Without restoring, the context is left in its default state afterwards
+	if (!RestoreContextState)
+	{
+		_state_tracker.clear_state();
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		_draw_call_tracker.untrack_rendertargets();
+#endif
+	}
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::HSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
@@ -483,6 +509,7 @@ void STDMETHODCALLTYPE D3D11DeviceContext::HSSetShaderResources(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::HSSetShader(ID3D11HullShader *pHullShader, ID3D11ClassInstance *const *ppClassInstances, UINT NumClassInstances)
 {
+	_state_tracker.hs_set_shader(pHullShader, NumClassInstances);
 	_orig->HSSetShader(pHullShader, ppClassInstances, NumClassInstances);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::HSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *const *ppSamplers)
@@ -499,6 +526,7 @@ void STDMETHODCALLTYPE D3D11DeviceContext::DSSetShaderResources(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DSSetShader(ID3D11DomainShader *pDomainShader, ID3D11ClassInstance *const *ppClassInstances, UINT NumClassInstances)
 {
+	_state_tracker.ds_set_shader(pDomainShader, NumClassInstances);
 	_orig->DSSetShader(pDomainShader, ppClassInstances, NumClassInstances);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::DSSetSamplers(UINT StartSlot, UINT NumSamplers, ID3D11SamplerState *const *ppSamplers)
@@ -683,6 +711,10 @@ void STDMETHODCALLTYPE D3D11DeviceContext::CSGetConstantBuffers(UINT StartSlot,
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearState()
 {
+	_state_tracker.clear_state();
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+	_draw_call_tracker.untrack_rendertargets();
+#endif
 	_orig->ClearState();
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::Flush()
@@ -697,6 +729,14 @@ HRESULT STDMETHODCALLTYPE D3D11DeviceContext::FinishCommandList(BOOL RestoreDefe
 {
 	const HRESULT hr = _orig->FinishCommandList(RestoreDeferredContextState, ppCommandList);
 
+	if (!RestoreDeferredContextState)
+	{
+		_state_tracker.clear_state();
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		_draw_call_tracker.untrack_rendertargets();
+#endif
+	}
+
 	if (SUCCEEDED(hr) && ppCommandList != nullptr)
 	{
 		_device->add_commandlist_trackers(*ppCommandList, _draw_call_tracker);
@@ -812,7 +852,28 @@ void STDMETHODCALLTYPE D3D11DeviceContext::SwapDeviceContextState(ID3DDeviceCont
 {
 	assert(_interface_version >= 1);
 
+	_state_tracker.invalidate();
+
 	static_cast<ID3D11DeviceContext1 *>(_orig)->SwapDeviceContextState(pState, ppPreviousState);
+
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+	// The state swapped in comes with its own render targets, so track those instead of the ones that were bound before
+	// This queries the device context once per swap, which is rare compared to draw calls
+	com_ptr<ID3D11DepthStencilView> depthstencil;
+	ID3D11RenderTargetView *targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = { nullptr };
+
+	_orig->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, targets, &depthstencil);
+
+	track_active_rendertargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, targets, depthstencil.get());
+
+	for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+	{
+		if (targets[i] != nullptr)
+		{
+			targets[i]->Release();
+		}
+	}
+#endif
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearView(ID3D11View *pView, const FLOAT Color[4], const D3D11_RECT *pRect, UINT NumRects)
 {
@@ -8,6 +8,7 @@
 #include <atomic>
 #include "d3d11.hpp"
 #include "draw_call_tracker.hpp"
+#include "state_tracker.hpp"
 
 struct D3D11DeviceContext : ID3D11DeviceContext3
 {
@@ -205,4 +206,5 @@ struct D3D11DeviceContext : ID3D11DeviceContext3
 	unsigned int _interface_version;
 	D3D11Device *const _device;
 	reshade::d3d11::draw_call_tracker _draw_call_tracker;
+	reshade::d3d11::state_tracker _state_tracker;
 };
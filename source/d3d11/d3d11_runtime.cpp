@@ -11,6 +11,7 @@
 #include "resource_loading.hpp"
 #include <imgui.h>
 #include <algorithm>
+#include <d3dcompiler.h>
 
 namespace reshade::d3d11
 {
@@ -18,6 +19,31 @@ namespace reshade::d3d11
 	extern DXGI_FORMAT make_format_normal(DXGI_FORMAT format);
 	extern DXGI_FORMAT make_format_typeless(DXGI_FORMAT format);
 
+	// Resolve the resources the views of a pass belong to, which the state cache uses to detect when a texture is bound for reading and writing at the same time
+	void d3d11_pass_data::update_view_resources()
+	{
+		for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+		{
+			render_target_view_resources[i].reset();
+
+			if (render_targets[i] != nullptr)
+			{
+				render_targets[i]->GetResource(&render_target_view_resources[i]);
+			}
+		}
+
+		shader_resource_view_resources.clear();
+		shader_resource_view_resources.resize(shader_resources.size());
+
+		for (size_t i = 0; i < shader_resources.size(); i++)
+		{
+			if (shader_resources[i] != nullptr)
+			{
+				shader_resources[i]->GetResource(&shader_resource_view_resources[i]);
+			}
+		}
+	}
+
 	d3d11_runtime::d3d11_runtime(ID3D11Device *device, IDXGISwapChain *swapchain) :
 		runtime(device->GetFeatureLevel()), _device(device), _swapchain(swapchain),
 		_stateblock(device)
@@ -47,6 +73,11 @@ namespace reshade::d3d11
 		_vendor_id = adapter_desc.VendorId;
 		_device_id = adapter_desc.DeviceId;
 
+		// Ignore depth buffers whose aspect ratio or size is too different from the back buffer, e.g. shadow maps
+		_depth_buffer_selector.settings().max_aspect_ratio_difference = 0.1f;
+		_depth_buffer_selector.settings().min_scale = 0.5f;
+		_depth_buffer_selector.settings().max_scale = 2.0f;
+
 		subscribe_to_menu("DX11", [this]() { draw_debug_menu(); });
 		subscribe_to_load_config([this](const ini_file& config) {
 			config.get("DX11_BUFFER_DETECTION", "DepthBufferRetrievalMode", depth_buffer_before_clear);
@@ -108,8 +139,8 @@ namespace reshade::d3d11
 			_backbuffer_resolved = _backbuffer;
 		}
 
-		// Create back buffer shader texture
-		texdesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		// Create back buffer shader texture, which passes may also render to when ping-ponging with the second one created below
+		texdesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
 
 		hr = _device->CreateTexture2D(&texdesc, nullptr, &_backbuffer_texture);
 
@@ -157,6 +188,38 @@ namespace reshade::d3d11
 			return false;
 		}
 
+		hr = _device->CreateTexture2D(&texdesc, nullptr, &_backbuffer_texture_pingpong);
+
+		if (FAILED(hr))
+		{
+			LOG(ERROR) << "Failed to create back buffer ping-pong texture ("
+				"Width = " << texdesc.Width << ", "
+				"Height = " << texdesc.Height << ", "
+				"Format = " << texdesc.Format << ")! HRESULT is '" << std::hex << hr << std::dec << "'.";
+			return false;
+		}
+
+		for (int srgb = 0; srgb < 2; srgb++)
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc = { };
+			srvdesc.Format = srgb ? make_format_srgb(texdesc.Format) : make_format_normal(texdesc.Format);
+			srvdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvdesc.Texture2D.MipLevels = texdesc.MipLevels;
+
+			D3D11_RENDER_TARGET_VIEW_DESC rtdesc = { };
+			rtdesc.Format = srvdesc.Format;
+			rtdesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+
+			if (FAILED(hr = _device->CreateShaderResourceView(_backbuffer_texture_pingpong.get(), &srvdesc, &_backbuffer_texture_pingpong_srv[srgb])) ||
+				FAILED(hr = _device->CreateRenderTargetView(_backbuffer_texture.get(), &rtdesc, &_backbuffer_texture_rtv[srgb])) ||
+				FAILED(hr = _device->CreateRenderTargetView(_backbuffer_texture_pingpong.get(), &rtdesc, &_backbuffer_texture_pingpong_rtv[srgb])))
+			{
+				LOG(ERROR) << "Failed to create back buffer ping-pong views ("
+					"Format = " << srvdesc.Format << ")! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
+			}
+		}
+
 		D3D11_RENDER_TARGET_VIEW_DESC rtdesc = { };
 		rtdesc.Format = make_format_normal(texdesc.Format);
 		rtdesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
@@ -439,6 +502,23 @@ namespace reshade::d3d11
 		_width = desc.BufferDesc.Width;
 		_height = desc.BufferDesc.Height;
 		_backbuffer_format = desc.BufferDesc.Format;
+
+		// Effects can rely on the color they write being clamped only if the back buffer has a normalized format
+		switch (_backbuffer_format)
+		{
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8X8_UNORM:
+			case DXGI_FORMAT_R10G10B10A2_UNORM:
+				_is_backbuffer_normalized = true;
+				break;
+			default:
+				_is_backbuffer_normalized = false;
+				break;
+		}
+
 		_is_multisampling_enabled = desc.SampleDesc.Count > 1;
 		_input = input::register_window(desc.OutputWindow);
 
@@ -465,6 +545,12 @@ namespace reshade::d3d11
 
 		runtime::on_reset();
 
+		if (_d3d_compiler != nullptr)
+		{
+			FreeLibrary(_d3d_compiler);
+			_d3d_compiler = nullptr;
+		}
+
 		// Reset reference count to make UnrealEngine happy
 		_backbuffer->AddRef();
 
@@ -472,11 +558,18 @@ namespace reshade::d3d11
 		_backbuffer.reset();
 		_backbuffer_resolved.reset();
 		_backbuffer_texture.reset();
+		_backbuffer_texture_pingpong.reset();
 		_backbuffer_texture_srv[0].reset();
 		_backbuffer_texture_srv[1].reset();
+		_backbuffer_texture_pingpong_srv[0].reset();
+		_backbuffer_texture_pingpong_srv[1].reset();
 		_backbuffer_rtv[0].reset();
 		_backbuffer_rtv[1].reset();
 		_backbuffer_rtv[2].reset();
+		_backbuffer_texture_rtv[0].reset();
+		_backbuffer_texture_rtv[1].reset();
+		_backbuffer_texture_pingpong_rtv[0].reset();
+		_backbuffer_texture_pingpong_rtv[1].reset();
 
 		_depthstencil.reset();
 		_depthstencil_replacement.reset();
@@ -518,7 +611,7 @@ namespace reshade::d3d11
 		_effect_shader_resources[1] = _backbuffer_texture_srv[1];
 		_effect_shader_resources[2] = _depthstencil_texture_srv;
 	}
-	void d3d11_runtime::on_present(draw_call_tracker &tracker)
+	void d3d11_runtime::on_present(draw_call_tracker &tracker, state_tracker &app_state)
 	{
 		if (!is_initialized())
 			return;
@@ -554,7 +647,25 @@ namespace reshade::d3d11
 		}
 
 		// Capture device state
-		_stateblock.capture(_immediate_context.get());
+		if (!app_state.is_valid())
+		{
+			app_state.synchronize(_immediate_context.get());
+		}
+
+		if (app_state.uses_class_instances())
+		{
+			_stateblock.capture(_immediate_context.get());
+		}
+		else
+		{
+			// Only the slots the runtime binds below have to be restored
+			_stateblock.capture(_immediate_context.get(), app_state,
+				std::max(static_cast<UINT>(_effect_sampler_states.size()), 1u),
+				std::max(static_cast<UINT>(_effect_shader_resources.size()), 1u));
+		}
+
+		// The application may have changed any state since the last frame
+		_state_cache.invalidate();
 
 		// Disable unused pipeline stages
 		_immediate_context->HSSetShader(nullptr, nullptr, 0);
@@ -586,7 +697,17 @@ namespace reshade::d3d11
 			_immediate_context->VSSetSamplers(0, static_cast<UINT>(_effect_sampler_states.size()), reinterpret_cast<ID3D11SamplerState *const *>(_effect_sampler_states.data()));
 			_immediate_context->PSSetSamplers(0, static_cast<UINT>(_effect_sampler_states.size()), reinterpret_cast<ID3D11SamplerState *const *>(_effect_sampler_states.data()));
 
+			_back_buffer_planner.begin_frame();
+
 			on_present_effect();
+
+			// Passes may have left the final image in one of the back buffer textures
+			const int final_surface = _back_buffer_planner.end_frame();
+
+			if (final_surface > 0)
+			{
+				_immediate_context->CopyResource(_backbuffer_resolved.get(), final_surface == 1 ? _backbuffer_texture.get() : _backbuffer_texture_pingpong.get());
+			}
 		}
 
 		// Apply presenting
@@ -690,7 +811,27 @@ namespace reshade::d3d11
 	{
 		return d3d11_effect_compiler(this, ast, errors, false).run();
 	}
-	bool d3d11_runtime::update_texture(texture &texture, const uint8_t *data)
+	upload_layout d3d11_runtime::get_upload_layout(const texture &texture) const
+	{
+		upload_layout layout;
+		layout.levels = texture.levels;
+
+		// The 8-bit formats with fewer channels are tightly packed
+		switch (texture.format)
+		{
+			case texture_format::r8:
+				layout.bytes_per_pixel = 1;
+				break;
+			case texture_format::rg8:
+				layout.bytes_per_pixel = 2;
+				break;
+			default:
+				break;
+		}
+
+		return layout;
+	}
+	bool d3d11_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
 	{
 		if (texture.impl_reference != texture_reference::none)
 		{
@@ -702,41 +843,167 @@ namespace reshade::d3d11
 		assert(data != nullptr);
 		assert(texture_impl != nullptr);
 
-		switch (texture.format)
+		// The texture loader already converted the data and generated all mipmap levels, so there is nothing left to do but copy them
+		for (UINT level = 0; level < std::min(static_cast<UINT>(levels.size()), texture.levels); level++)
 		{
-			case texture_format::r8:
+			_immediate_context->UpdateSubresource(texture_impl->texture.get(), level, nullptr, data + levels[level].offset, static_cast<UINT>(levels[level].row_pitch), static_cast<UINT>(levels[level].row_pitch * levels[level].height));
+		}
+
+		return true;
+	}
+	bool d3d11_runtime::alias_texture(texture &texture, const texture &owner)
+	{
+		const auto texture_impl = texture.impl->as<d3d11_tex_data>();
+		const auto owner_impl = owner.impl->as<d3d11_tex_data>();
+
+		if (texture_impl == nullptr || owner_impl == nullptr)
+		{
+			return false;
+		}
+
+		// Render target views are only created for the formats a texture is rendered with, so the owner may be missing some
+		for (unsigned int i = 0; i < 2; i++)
+		{
+			if (texture_impl->rtv[i] == nullptr || owner_impl->rtv[i] != nullptr)
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k++)
-					data2[k] = data[i];
-				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width, texture.width * texture.height);
-				break;
+				continue;
 			}
-			case texture_format::rg8:
+
+			D3D11_RENDER_TARGET_VIEW_DESC rtvdesc;
+			texture_impl->rtv[i]->GetDesc(&rtvdesc);
+
+			const HRESULT hr = _device->CreateRenderTargetView(owner_impl->texture.get(), &rtvdesc, &owner_impl->rtv[i]);
+
+			if (FAILED(hr))
 			{
-				std::vector<uint8_t> data2(texture.width * texture.height * 2);
-				for (size_t i = 0, k = 0; i < texture.width * texture.height * 4; i += 4, k += 2)
-					data2[k] = data[i],
-					data2[k + 1] = data[i + 1];
-				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data2.data(), texture.width * 2, texture.width * texture.height * 2);
-				break;
+				LOG(ERROR) << "Failed to create render target view for texture '" << owner.name << "'! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
 			}
-			default:
+		}
+
+		// Passes hold their own references to the views, so replace them everywhere
+		const auto replace_views = [texture_impl, owner_impl](auto first, auto last) {
+			for (unsigned int i = 0; i < 2; i++)
 			{
-				_immediate_context->UpdateSubresource(texture_impl->texture.get(), 0, nullptr, data, texture.width * 4, texture.width * texture.height * 4);
-				break;
+				if (texture_impl->srv[i] != nullptr)
+				{
+					std::replace(first, last, texture_impl->srv[i], owner_impl->srv[i]);
+				}
+			}
+		};
+
+		replace_views(_effect_shader_resources.begin(), _effect_shader_resources.end());
+
+		for (auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<d3d11_pass_data>();
+
+				replace_views(pass.shader_resources.begin(), pass.shader_resources.end());
+				replace_views(std::begin(pass.render_target_resources), std::end(pass.render_target_resources));
+
+				for (unsigned int i = 0; i < 2; i++)
+				{
+					if (texture_impl->rtv[i] != nullptr)
+					{
+						std::replace(std::begin(pass.render_targets), std::end(pass.render_targets), texture_impl->rtv[i], owner_impl->rtv[i]);
+					}
+				}
+
+				// Passes bind the views of all textures, so one rendering to the shared memory may now bind it for sampling too, which is not allowed
+				const bool renders_to_owner =
+					(owner_impl->rtv[0] != nullptr && std::find(std::begin(pass.render_targets), std::end(pass.render_targets), owner_impl->rtv[0]) != std::end(pass.render_targets)) ||
+					(owner_impl->rtv[1] != nullptr && std::find(std::begin(pass.render_targets), std::end(pass.render_targets), owner_impl->rtv[1]) != std::end(pass.render_targets));
+
+				if (renders_to_owner)
+				{
+					for (auto &srv : pass.shader_resources)
+					{
+						if (srv != nullptr && (srv == owner_impl->srv[0] || srv == owner_impl->srv[1]))
+						{
+							srv.reset();
+						}
+					}
+				}
+
+				pass.update_view_resources();
 			}
 		}
 
-		if (texture.levels > 1)
+		texture_impl->texture = owner_impl->texture;
+		texture_impl->srv[0] = owner_impl->srv[0];
+		texture_impl->srv[1] = owner_impl->srv[1];
+		texture_impl->rtv[0] = owner_impl->rtv[0];
+		texture_impl->rtv[1] = owner_impl->rtv[1];
+
+		return true;
+	}
+
+	bool d3d11_runtime::compile_technique(const std::vector<base_object *> &passes) const
+	{
+		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
+
+		if (D3DCompile == nullptr)
 		{
-			_immediate_context->GenerateMips(texture_impl->srv[0].get());
+			return false;
+		}
+
+		for (const auto pass_object : passes)
+		{
+			const auto pass = pass_object->as<d3d11_pass_data>();
+
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				if (pass->shader_entry_points[i].empty())
+				{
+					continue;
+				}
+
+				com_ptr<ID3DBlob> errors;
+				const HRESULT hr = D3DCompile(pass->shader_source->c_str(), pass->shader_source->size(), nullptr, nullptr, nullptr, pass->shader_entry_points[i].c_str(), pass->shader_profiles[i].c_str(), pass->shader_compile_flags, 0, &pass->shader_bytecode[i], &errors);
+
+				if (FAILED(hr))
+				{
+					LOG(ERROR) << "Failed to compile shader '" << pass->shader_entry_points[i] << "':\n" << (errors != nullptr ? static_cast<const char *>(errors->GetBufferPointer()) : "");
+					return false;
+				}
+			}
 		}
 
 		return true;
 	}
+	bool d3d11_runtime::create_technique_shaders(technique &technique)
+	{
+		for (const auto &pass_object : technique.passes)
+		{
+			const auto pass = pass_object->as<d3d11_pass_data>();
 
-	void d3d11_runtime::render_technique(const technique &technique)
+			HRESULT hr = S_OK;
+
+			if (pass->shader_bytecode[0] != nullptr)
+			{
+				hr = _device->CreateVertexShader(pass->shader_bytecode[0]->GetBufferPointer(), pass->shader_bytecode[0]->GetBufferSize(), nullptr, &pass->vertex_shader);
+			}
+			if (SUCCEEDED(hr) && pass->shader_bytecode[1] != nullptr)
+			{
+				hr = _device->CreatePixelShader(pass->shader_bytecode[1]->GetBufferPointer(), pass->shader_bytecode[1]->GetBufferSize(), nullptr, &pass->pixel_shader);
+			}
+
+			// The bytecode is no longer needed once the shader objects exist
+			pass->shader_bytecode[0].reset();
+			pass->shader_bytecode[1].reset();
+
+			if (FAILED(hr))
+			{
+				LOG(ERROR) << "Failed to create shaders for technique '" << technique.name << "'! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
+			}
+		}
+
+		return true;
+	}
+	void d3d11_runtime::render_technique(technique &technique)
 	{
 		d3d11_technique_data &technique_data = *technique.impl->as<d3d11_technique_data>();
 
@@ -752,70 +1019,161 @@ namespace reshade::d3d11
 		if (technique.uniform_storage_index >= 0)
 		{
 			const auto constant_buffer = _constant_buffers[technique.uniform_storage_index].get();
-			D3D11_MAPPED_SUBRESOURCE mapped;
-
-			const HRESULT hr = _immediate_context->Map(constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
 
-			if (SUCCEEDED(hr))
+			// Each technique owns its constant buffer, so it keeps its contents as long as no uniform in it changed
+			if (update_uniform_block(technique, _dirty_uniform_ranges))
 			{
-				CopyMemory(mapped.pData, get_uniform_value_storage().data() + technique.uniform_storage_offset, mapped.RowPitch);
+				D3D11_MAPPED_SUBRESOURCE mapped;
 
-				_immediate_context->Unmap(constant_buffer, 0);
+				const HRESULT hr = _immediate_context->Map(constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+
+				if (SUCCEEDED(hr))
+				{
+					// Discarding invalidates the entire buffer, so always rewrite all of it
+					for (const auto &range : technique.uniform_block_ranges)
+					{
+						CopyMemory(static_cast<uint8_t *>(mapped.pData) + range.block_offset, get_uniform_value_storage().data() + range.storage_offset, range.size);
+					}
+
+					_immediate_context->Unmap(constant_buffer, 0);
+				}
+				else
+				{
+					LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+
+					technique.uniform_block_generation = 0;
+				}
 			}
-			else
+
+			if (_state_cache.set_constant_buffer(reinterpret_cast<uintptr_t>(constant_buffer)))
 			{
-				LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+				_immediate_context->VSSetConstantBuffers(0, 1, &constant_buffer);
+				_immediate_context->PSSetConstantBuffers(0, 1, &constant_buffer);
 			}
-
-			_immediate_context->VSSetConstantBuffers(0, 1, &constant_buffer);
-			_immediate_context->PSSetConstantBuffers(0, 1, &constant_buffer);
 		}
 
+		// Views are bound from the shadow state, so that slots the cache unbound to resolve hazards are included
+		const auto bind_shader_resources = [this](const state_slot_range &range) {
+			const auto views = reinterpret_cast<ID3D11ShaderResourceView *const *>(_state_cache.shader_resources() + range.first);
+			_immediate_context->VSSetShaderResources(range.first, range.count, views);
+			_immediate_context->PSSetShaderResources(range.first, range.count, views);
+		};
+		const auto bind_render_targets = [this]() {
+			_immediate_context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D11RenderTargetView *const *>(_state_cache.render_targets()), reinterpret_cast<ID3D11DepthStencilView *>(_state_cache.depth_stencil()));
+		};
+
 		for (const auto &pass_object : technique.passes)
 		{
 			const d3d11_pass_data &pass = *pass_object->as<d3d11_pass_data>();
 
 			// Setup states
-			_immediate_context->VSSetShader(pass.vertex_shader.get(), nullptr, 0);
-			_immediate_context->PSSetShader(pass.pixel_shader.get(), nullptr, 0);
+			if (_state_cache.set_shaders(reinterpret_cast<uintptr_t>(pass.vertex_shader.get()), reinterpret_cast<uintptr_t>(pass.pixel_shader.get())))
+			{
+				_immediate_context->VSSetShader(pass.vertex_shader.get(), nullptr, 0);
+				_immediate_context->PSSetShader(pass.pixel_shader.get(), nullptr, 0);
+			}
 
-			_immediate_context->OMSetBlendState(pass.blend_state.get(), nullptr, D3D11_DEFAULT_SAMPLE_MASK);
-			_immediate_context->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			if (_state_cache.set_blend_state(reinterpret_cast<uintptr_t>(pass.blend_state.get())))
+			{
+				_immediate_context->OMSetBlendState(pass.blend_state.get(), nullptr, D3D11_DEFAULT_SAMPLE_MASK);
+			}
+			if (_state_cache.set_depth_stencil_state(reinterpret_cast<uintptr_t>(pass.depth_stencil_state.get()), pass.stencil_reference))
+			{
+				_immediate_context->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			}
 
-			// Save back buffer of previous pass
-			_immediate_context->CopyResource(_backbuffer_texture.get(), _backbuffer_resolved.get());
+			// Only copy the back buffer when the pass samples it and no texture holds the current contents, otherwise ping-pong between the back buffer textures
+			const auto step = _back_buffer_planner.plan_pass(pass.back_buffer_usage);
 
-			// Setup shader resources
-			_immediate_context->VSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), reinterpret_cast<ID3D11ShaderResourceView *const *>(pass.shader_resources.data()));
-			_immediate_context->PSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), reinterpret_cast<ID3D11ShaderResourceView *const *>(pass.shader_resources.data()));
+			ID3D11Texture2D *const surfaces[3] = { _backbuffer_resolved.get(), _backbuffer_texture.get(), _backbuffer_texture_pingpong.get() };
 
-			// Setup render targets
-			if (static_cast<UINT>(pass.viewport.Width) == _width && static_cast<UINT>(pass.viewport.Height) == _height)
+			if (step.copy_source >= 0)
 			{
-				_immediate_context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D11RenderTargetView *const *>(pass.render_targets), _default_depthstencil.get());
+				_immediate_context->CopyResource(surfaces[step.copy_destination], surfaces[step.copy_source]);
+			}
 
-				if (!is_default_depthstencil_cleared)
-				{
-					is_default_depthstencil_cleared = true;
+			ID3D11RenderTargetView *render_targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			ID3D11Resource *render_target_view_resources[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+
+			for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+			{
+				render_targets[i] = pass.render_targets[i].get();
+				render_target_view_resources[i] = pass.render_target_view_resources[i].get();
+			}
 
-					_immediate_context->ClearDepthStencilView(_default_depthstencil.get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+			if (step.write_surface > 0)
+			{
+				const int srgb = pass.render_targets[0] == _backbuffer_rtv[1] ? 1 : 0;
+
+				render_targets[0] = step.write_surface == 1 ? _backbuffer_texture_rtv[srgb].get() : _backbuffer_texture_pingpong_rtv[srgb].get();
+				render_target_view_resources[0] = surfaces[step.write_surface];
+			}
+
+			// Setup render targets before shader resources, so that textures the previous pass rendered to are no longer bound for output when they are sampled
+			const bool is_viewport_sized = static_cast<UINT>(pass.viewport.Width) == _width && static_cast<UINT>(pass.viewport.Height) == _height;
+
+			state_slot_range unbound_shader_resources;
+
+			if (_state_cache.set_render_targets(reinterpret_cast<const uintptr_t *>(render_targets), reinterpret_cast<const uintptr_t *>(render_target_view_resources), D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<uintptr_t>(is_viewport_sized ? _default_depthstencil.get() : nullptr), unbound_shader_resources))
+			{
+				if (unbound_shader_resources.count != 0)
+				{
+					bind_shader_resources(unbound_shader_resources);
 				}
+
+				bind_render_targets();
 			}
-			else
+
+			if (is_viewport_sized && !is_default_depthstencil_cleared)
+			{
+				is_default_depthstencil_cleared = true;
+
+				_immediate_context->ClearDepthStencilView(_default_depthstencil.get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+			}
+
+			if (_state_cache.set_viewport(static_cast<uint32_t>(pass.viewport.Width), static_cast<uint32_t>(pass.viewport.Height)))
+			{
+				_immediate_context->RSSetViewports(1, &pass.viewport);
+			}
+
+			// Setup shader resources
+			ID3D11ShaderResourceView *shader_resources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+			ID3D11Resource *shader_resource_view_resources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+			const UINT shader_resource_count = std::min(static_cast<UINT>(pass.shader_resources.size()), static_cast<UINT>(D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT));
+
+			for (UINT i = 0; i < shader_resource_count; i++)
 			{
-				_immediate_context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D11RenderTargetView *const *>(pass.render_targets), nullptr);
+				shader_resources[i] = pass.shader_resources[i].get();
+				shader_resource_view_resources[i] = pass.shader_resource_view_resources[i].get();
 			}
 
-			_immediate_context->RSSetViewports(1, &pass.viewport);
+			if (step.read_surface == 2)
+			{
+				shader_resources[0] = _backbuffer_texture_pingpong_srv[0].get();
+				shader_resources[1] = _backbuffer_texture_pingpong_srv[1].get();
+				shader_resource_view_resources[0] = shader_resource_view_resources[1] = _backbuffer_texture_pingpong.get();
+			}
+
+			bool unbound_render_targets;
+			const auto changed_shader_resources = _state_cache.set_shader_resources(reinterpret_cast<const uintptr_t *>(shader_resources), reinterpret_cast<const uintptr_t *>(shader_resource_view_resources), shader_resource_count, unbound_render_targets);
+
+			if (unbound_render_targets)
+			{
+				bind_render_targets();
+			}
+			if (changed_shader_resources.count != 0)
+			{
+				bind_shader_resources(changed_shader_resources);
+			}
 
 			if (pass.clear_render_targets)
 			{
-				for (const auto &target : pass.render_targets)
+				for (const auto target : render_targets)
 				{
 					if (target != nullptr)
 					{
 						const float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-						_immediate_context->ClearRenderTargetView(target.get(), color);
+						_immediate_context->ClearRenderTargetView(target, color);
 					}
 				}
 			}
@@ -826,17 +1184,11 @@ namespace reshade::d3d11
 			_vertices += 3;
 			_drawcalls += 1;
 
-			// Reset render targets
-			_immediate_context->OMSetRenderTargets(0, nullptr, nullptr);
-
-			// Reset shader resources
-			ID3D11ShaderResourceView *null[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { nullptr };
-			_immediate_context->VSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), null);
-			_immediate_context->PSSetShaderResources(0, static_cast<UINT>(pass.shader_resources.size()), null);
-
 			// Update shader resources
-			for (const auto &resource : pass.render_target_resources)
+			for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
 			{
+				const auto &resource = pass.render_target_resources[i];
+
 				if (resource == nullptr)
 				{
 					continue;
@@ -847,6 +1199,12 @@ namespace reshade::d3d11
 
 				if (resource_desc.Texture2D.MipLevels > 1)
 				{
+					// Render targets stay bound until the next pass changes them, but mipmaps cannot be generated while the texture is bound for output
+					if (_state_cache.unbind_render_target_resource(reinterpret_cast<uintptr_t>(pass.render_target_view_resources[i].get())))
+					{
+						bind_render_targets();
+					}
+
 					_immediate_context->GenerateMips(resource.get());
 				}
 			}
@@ -1010,6 +1368,7 @@ namespace reshade::d3d11
 				runtime::save_config();
 				_current_tracker.reset();
 				create_depthstencil_replacement(nullptr, nullptr);
+				_depth_buffer_selector.reset();
 				return;
 			}
 
@@ -1060,8 +1419,10 @@ namespace reshade::d3d11
 				ImGui::Spacing();
 				ImGui::TextUnformatted("Depth Buffers: (intermediate buffer draw calls in parentheses)");
 
-				for (const auto &[depthstencil, snapshot] : _current_tracker.depth_buffer_counters())
+				for (const auto &snapshot : _current_tracker.depth_buffer_counters())
 				{
+					const auto &depthstencil = snapshot.depthstencil;
+
 					char label[512] = "";
 					sprintf_s(label, "%s0x%p", (depthstencil == _depthstencil ? "> " : "  "), depthstencil.get());
 
@@ -1160,6 +1521,7 @@ namespace reshade::d3d11
 			{
 				traffic = 0;
 				create_depthstencil_replacement(nullptr, nullptr);
+				_depth_buffer_selector.reset();
 				return;
 			}
 			else
@@ -1189,11 +1551,19 @@ namespace reshade::d3d11
 			return;
 		}
 
-		const auto best_snapshot = tracker.find_best_snapshot(_width, _height);
+		_depth_buffer_selector.begin_frame(_width, _height);
+		tracker.add_depth_buffers(_depth_buffer_selector);
+		_depth_buffer_selector.end_frame(tracker.total_drawcalls());
+
+		const auto best_match = reinterpret_cast<ID3D11DepthStencilView *>(_depth_buffer_selector.selected());
 
-		if (best_snapshot.depthstencil != nullptr)
+		if (best_match != nullptr && _depthstencil != best_match)
 		{
-			create_depthstencil_replacement(best_snapshot.depthstencil, best_snapshot.texture.get());
+			// The selected view may not have been used this frame, in which case it may no longer exist, so only switch to views the tracker still references
+			if (const auto best_snapshot = tracker.find_snapshot(best_match); best_snapshot != nullptr && best_snapshot->texture != nullptr)
+			{
+				create_depthstencil_replacement(best_snapshot->depthstencil.get(), best_snapshot->texture.get());
+			}
 		}
 	}
 
@@ -1329,8 +1699,15 @@ namespace reshade::d3d11
 		// Update effect textures
 		_effect_shader_resources[2] = _depthstencil_texture_srv;
 		for (const auto &technique : _techniques)
-			for (const auto &pass : technique.passes)
-				pass->as<d3d11_pass_data>()->shader_resources[2] = _depthstencil_texture_srv;
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<d3d11_pass_data>();
+
+				pass.shader_resources[2] = _depthstencil_texture_srv;
+				pass.update_view_resources();
+			}
+		}
 
 		return true;
 	}
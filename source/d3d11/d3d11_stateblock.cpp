@@ -4,6 +4,8 @@
  */
 
 #include "d3d11_stateblock.hpp"
+#include <assert.h>
+#include <algorithm>
 
 namespace reshade::d3d11
 {
@@ -16,6 +18,16 @@ namespace reshade::d3d11
 			object = nullptr;
 		}
 	}
+	template <typename T>
+	static inline void add_reference(T *&object, T *value)
+	{
+		object = value;
+
+		if (object != nullptr)
+		{
+			object->AddRef();
+		}
+	}
 
 	d3d11_stateblock::d3d11_stateblock(ID3D11Device *device)
 	{
@@ -33,17 +45,14 @@ namespace reshade::d3d11
 	{
 		_device_context = devicecontext;
 
+		_num_vertex_buffers = _device_feature_level > D3D_FEATURE_LEVEL_10_0 ? D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT : D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		_num_constant_buffers = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+		_num_samplers = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+		_num_shader_resources = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+
 		_device_context->IAGetPrimitiveTopology(&_ia_primitive_topology);
 		_device_context->IAGetInputLayout(&_ia_input_layout);
-
-		if (_device_feature_level > D3D_FEATURE_LEVEL_10_0)
-		{
-			_device_context->IAGetVertexBuffers(0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
-		else
-		{
-			_device_context->IAGetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
+		_device_context->IAGetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 
 		_device_context->IAGetIndexBuffer(&_ia_index_buffer, &_ia_index_format, &_ia_index_offset);
 
@@ -84,19 +93,68 @@ namespace reshade::d3d11
 		_device_context->OMGetDepthStencilState(&_om_depth_stencil_state, &_om_stencil_ref);
 		_device_context->OMGetRenderTargets(ARRAYSIZE(_om_render_targets), _om_render_targets, &_om_depth_stencil);
 	}
-	void d3d11_stateblock::apply_and_release()
+	void d3d11_stateblock::capture(ID3D11DeviceContext *devicecontext, const state_tracker &state, UINT num_samplers, UINT num_shader_resources)
 	{
-		_device_context->IASetPrimitiveTopology(_ia_primitive_topology);
-		_device_context->IASetInputLayout(_ia_input_layout);
+		// Class instances are not tracked, so these have to be captured from the device context instead
+		assert(!state.uses_class_instances());
+
+		_device_context = devicecontext;
+
+		_num_vertex_buffers = 1;
+		_num_constant_buffers = 1;
+		_num_samplers = std::min(num_samplers, UINT(D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT));
+		_num_shader_resources = std::min(num_shader_resources, UINT(D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT));
 
-		if (_device_feature_level > D3D_FEATURE_LEVEL_10_0)
+		// Buffers and views can be unbound implicitly when they are bound for output elsewhere, so they are not tracked and have to be queried
+		_ia_primitive_topology = state._ia_primitive_topology;
+		add_reference(_ia_input_layout, state._ia_input_layout);
+		_device_context->IAGetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
+		_device_context->IAGetIndexBuffer(&_ia_index_buffer, &_ia_index_format, &_ia_index_offset);
+
+		add_reference(_rs_state, state._rs_state);
+		_rs_num_viewports = state._rs_num_viewports;
+		std::copy_n(state._rs_viewports, _rs_num_viewports, _rs_viewports);
+		_rs_num_scissor_rects = state._rs_num_scissor_rects;
+		std::copy_n(state._rs_scissor_rects, _rs_num_scissor_rects, _rs_scissor_rects);
+
+		_vs_num_class_instances = 0;
+		add_reference(_vs, state._vs);
+		_device_context->VSGetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		for (UINT i = 0; i < _num_samplers; i++)
 		{
-			_device_context->IASetVertexBuffers(0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
+			add_reference(_vs_sampler_states[i], state._vs_sampler_states[i]);
 		}
-		else
+		_device_context->VSGetShaderResources(0, _num_shader_resources, _vs_shader_resources);
+
+		_hs_num_class_instances = 0;
+		add_reference(_hs, state._hs);
+		_ds_num_class_instances = 0;
+		add_reference(_ds, state._ds);
+		_gs_num_class_instances = 0;
+		add_reference(_gs, state._gs);
+
+		_ps_num_class_instances = 0;
+		add_reference(_ps, state._ps);
+		_device_context->PSGetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		for (UINT i = 0; i < _num_samplers; i++)
 		{
-			_device_context->IASetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
+			add_reference(_ps_sampler_states[i], state._ps_sampler_states[i]);
 		}
+		_device_context->PSGetShaderResources(0, _num_shader_resources, _ps_shader_resources);
+
+		add_reference(_om_blend_state, state._om_blend_state);
+		std::copy_n(state._om_blend_factor, 4, _om_blend_factor);
+		_om_sample_mask = state._om_sample_mask;
+		add_reference(_om_depth_stencil_state, state._om_depth_stencil_state);
+		_om_stencil_ref = state._om_stencil_ref;
+		_device_context->OMGetRenderTargets(ARRAYSIZE(_om_render_targets), _om_render_targets, &_om_depth_stencil);
+	}
+	void d3d11_stateblock::apply_and_release()
+	{
+		_device_context->IASetPrimitiveTopology(_ia_primitive_topology);
+		_device_context->IASetInputLayout(_ia_input_layout);
+
+		_device_context->IASetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 
 		_device_context->IASetIndexBuffer(_ia_index_buffer, _ia_index_format, _ia_index_offset);
 
@@ -105,9 +163,9 @@ namespace reshade::d3d11
 		_device_context->RSSetScissorRects(_rs_num_scissor_rects, _rs_scissor_rects);
 
 		_device_context->VSSetShader(_vs, _vs_class_instances, _vs_num_class_instances);
-		_device_context->VSSetConstantBuffers(0, ARRAYSIZE(_vs_constant_buffers), _vs_constant_buffers);
-		_device_context->VSSetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
-		_device_context->VSSetShaderResources(0, ARRAYSIZE(_vs_shader_resources), _vs_shader_resources);
+		_device_context->VSSetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		_device_context->VSSetSamplers(0, _num_samplers, _vs_sampler_states);
+		_device_context->VSSetShaderResources(0, _num_shader_resources, _vs_shader_resources);
 
 		if (_device_feature_level >= D3D_FEATURE_LEVEL_10_0)
 		{
@@ -122,9 +180,9 @@ namespace reshade::d3d11
 		}
 
 		_device_context->PSSetShader(_ps, _ps_class_instances, _ps_num_class_instances);
-		_device_context->PSSetConstantBuffers(0, ARRAYSIZE(_ps_constant_buffers), _ps_constant_buffers);
-		_device_context->PSSetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
-		_device_context->PSSetShaderResources(0, ARRAYSIZE(_ps_shader_resources), _ps_shader_resources);
+		_device_context->PSSetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		_device_context->PSSetSamplers(0, _num_samplers, _ps_sampler_states);
+		_device_context->PSSetShaderResources(0, _num_shader_resources, _ps_shader_resources);
 
 		_device_context->OMSetBlendState(_om_blend_state, _om_blend_factor, _om_sample_mask);
 		_device_context->OMSetDepthStencilState(_om_depth_stencil_state, _om_stencil_ref);
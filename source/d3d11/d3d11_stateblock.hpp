@@ -7,6 +7,7 @@
 
 #include <d3d11_1.h>
 #include <com_ptr.hpp>
+#include "state_tracker.hpp"
 
 namespace reshade::d3d11
 {
@@ -17,6 +18,14 @@ namespace reshade::d3d11
 		~d3d11_stateblock();
 
 		void capture(ID3D11DeviceContext *devicecontext);
+		/// <summary>
+		/// Capture shaders and state objects from a shadow copy and only query buffers and views from the device context. Only the state the runtime overwrites is restored afterwards.
+		/// </summary>
+		/// <param name="devicecontext">The device context the state belongs to.</param>
+		/// <param name="state">The tracked state of the device context.</param>
+		/// <param name="num_samplers">The number of sampler slots to restore, starting at the first one.</param>
+		/// <param name="num_shader_resources">The number of shader resource slots to restore, starting at the first one.</param>
+		void capture(ID3D11DeviceContext *devicecontext, const state_tracker &state, UINT num_samplers, UINT num_shader_resources);
 		void apply_and_release();
 
 	private:
@@ -25,6 +34,7 @@ namespace reshade::d3d11
 		D3D_FEATURE_LEVEL _device_feature_level;
 		com_ptr<ID3D11Device> _device;
 		com_ptr<ID3D11DeviceContext> _device_context;
+		UINT _num_vertex_buffers, _num_constant_buffers, _num_samplers, _num_shader_resources;
 		ID3D11InputLayout *_ia_input_layout;
 		D3D11_PRIMITIVE_TOPOLOGY _ia_primitive_topology;
 		ID3D11Buffer *_ia_vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
@@ -1,19 +1,36 @@
 #include "draw_call_tracker.hpp"
 #include "log.hpp"
-#include <math.h>
+#include <algorithm>
 
 namespace reshade::d3d11
 {
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+	static inline size_t depthstencil_hash(ID3D11DepthStencilView *depthstencil)
+	{
+		// Views are heap allocated, so the lowest bits of their address carry little information
+		const size_t address = reinterpret_cast<uintptr_t>(depthstencil) >> 4;
+
+		return address ^ (address >> 7) ^ (address >> 15);
+	}
+#endif
+
 	void draw_call_tracker::merge(const draw_call_tracker& source)
 	{
 		_global_counter.vertices += source.total_vertices();
 		_global_counter.drawcalls += source.total_drawcalls();
 
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
-		for (const auto &[depthstencil, snapshot] : source._counters_per_used_depthstencil)
+		for (const auto &snapshot : source._counters_per_used_depthstencil)
 		{
-			_counters_per_used_depthstencil[depthstencil].stats.vertices += snapshot.stats.vertices;
-			_counters_per_used_depthstencil[depthstencil].stats.drawcalls += snapshot.stats.drawcalls;
+			UINT index = find_depthstencil(snapshot.depthstencil.get());
+
+			if (index == invalid_index)
+			{
+				index = add_depthstencil(snapshot.depthstencil.get());
+			}
+
+			_counters_per_used_depthstencil[index].stats.vertices += snapshot.stats.vertices;
+			_counters_per_used_depthstencil[index].stats.drawcalls += snapshot.stats.drawcalls;
 		}
 
 		for (auto source_entry : source._cleared_depth_textures)
@@ -42,14 +59,52 @@ namespace reshade::d3d11
 		_global_counter.vertices = 0;
 		_global_counter.drawcalls = 0;
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		// The bound render targets stay active across frames, so keep their entry around
+		intermediate_snapshot_info active_snapshot;
+
+		if (_active_depthstencil != invalid_index)
+		{
+			active_snapshot = std::move(_counters_per_used_depthstencil[_active_depthstencil]);
+		}
+
 		_counters_per_used_depthstencil.clear();
+		std::fill(_depthstencil_indices.begin(), _depthstencil_indices.end(), invalid_index);
 		_cleared_depth_textures.clear();
+
+		if (active_snapshot.depthstencil != nullptr)
+		{
+			restore_active_snapshot(std::move(active_snapshot));
+		}
 #endif
 #if RESHADE_DX11_CAPTURE_CONSTANT_BUFFERS
 		_counters_per_constant_buffer.clear();
 #endif
 	}
 
+	void draw_call_tracker::move_into(draw_call_tracker &destination)
+	{
+		// Swap the containers instead of copying them, so that the destination receives all statistics and this tracker reuses its empty containers
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		destination.untrack_rendertargets();
+#endif
+		destination.reset();
+
+		std::swap(*this, destination);
+
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		// The bound render targets are still active on this tracker
+		if (destination._active_depthstencil != invalid_index)
+		{
+			restore_active_snapshot(intermediate_snapshot_info(destination._counters_per_used_depthstencil[destination._active_depthstencil]));
+
+			_num_active_views = destination._num_active_views;
+			std::copy_n(destination._active_views, _num_active_views, _active_views);
+
+			destination.untrack_rendertargets();
+		}
+#endif
+	}
+
 	void draw_call_tracker::on_map(ID3D11Resource *resource)
 	{
 		UNREFERENCED_PARAMETER(resource);
@@ -73,37 +128,24 @@ namespace reshade::d3d11
 		_global_counter.drawcalls += 1;
 
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
-		com_ptr<ID3D11RenderTargetView> targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
-		com_ptr<ID3D11DepthStencilView> depthstencil;
-
-		context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, reinterpret_cast<ID3D11RenderTargetView **>(targets), &depthstencil);
-
-		if (depthstencil == nullptr)
-			// This is a draw call with no depth stencil
-			return;
-
-		if (const auto intermediate_snapshot = _counters_per_used_depthstencil.find(depthstencil); intermediate_snapshot != _counters_per_used_depthstencil.end())
+		// Draw calls without a tracked depth stencil are not counted per depth stencil
+		if (_active_depthstencil != invalid_index)
 		{
-			intermediate_snapshot->second.stats.vertices += vertices;
-			intermediate_snapshot->second.stats.drawcalls += 1;
+			intermediate_snapshot_info &intermediate_snapshot = _counters_per_used_depthstencil[_active_depthstencil];
 
-			// Find the render targets, if they exist, and update their counts
-			for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+			intermediate_snapshot.stats.vertices += vertices;
+			intermediate_snapshot.stats.drawcalls += 1;
+
+			for (UINT i = 0; i < _num_active_views; i++)
 			{
 				// Ignore empty slots
-				if (targets[i] == nullptr)
+				if (_active_views[i] == invalid_index)
 					continue;
 
-				if (const auto it = intermediate_snapshot->second.additional_views.find(targets[i].get()); it != intermediate_snapshot->second.additional_views.end())
-				{
-					it->second.vertices += vertices;
-					it->second.drawcalls += 1;
-				}
-				else
-				{
-					// This shouldn't happen - it means somehow someone has called 'on_draw' with a render target without calling 'track_rendertargets' first
-					LOG(ERROR) << "Draw has been called on an untracked render target.";
-				}
+				draw_stats &view_stats = intermediate_snapshot.additional_views[_active_views[i]].second;
+
+				view_stats.vertices += vertices;
+				view_stats.drawcalls += 1;
 			}
 		}
 #endif
@@ -197,27 +239,58 @@ namespace reshade::d3d11
 	}
 	bool draw_call_tracker::check_depthstencil(ID3D11DepthStencilView *depthstencil) const
 	{
-		return _counters_per_used_depthstencil.find(depthstencil) != _counters_per_used_depthstencil.end();
+		return find_depthstencil(depthstencil) != invalid_index;
 	}
 
 	void draw_call_tracker::track_rendertargets(int depth_buffer_texture_format, ID3D11DepthStencilView *depthstencil, UINT num_views, ID3D11RenderTargetView *const *views)
 	{
 		assert(depthstencil != nullptr);
 
-		if (!check_depth_texture_format(depth_buffer_texture_format, depthstencil))
+		untrack_rendertargets();
+
+		UINT index = find_depthstencil(depthstencil);
+
+		// The format only has to be checked the first time a depth stencil is used during a frame
+		if (index == invalid_index)
 		{
-			return;
+			if (!check_depth_texture_format(depth_buffer_texture_format, depthstencil))
+			{
+				return;
+			}
+
+			index = add_depthstencil(depthstencil);
 		}
 
-		if (_counters_per_used_depthstencil[depthstencil].depthstencil == nullptr)
-			_counters_per_used_depthstencil[depthstencil].depthstencil = depthstencil;
+		_active_depthstencil = index;
+		_num_active_views = std::min(num_views, UINT(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT));
 
-		for (UINT i = 0; i < num_views; i++)
+		auto &additional_views = _counters_per_used_depthstencil[index].additional_views;
+
+		for (UINT i = 0; i < _num_active_views; i++)
 		{
+			_active_views[i] = invalid_index;
+
+			if (views == nullptr || views[i] == nullptr)
+				continue;
+
+			const auto it = std::find_if(additional_views.begin(), additional_views.end(), [view = views[i]](const auto &entry) { return entry.first == view; });
+
+			_active_views[i] = static_cast<UINT>(it - additional_views.begin());
+
 			// If the render target isn't being tracked, this will create it
-			_counters_per_used_depthstencil[depthstencil].additional_views[views[i]].drawcalls += 1;
+			if (it == additional_views.end())
+			{
+				additional_views.emplace_back(views[i], draw_stats());
+			}
+
+			additional_views[_active_views[i]].second.drawcalls += 1;
 		}
 	}
+	void draw_call_tracker::untrack_rendertargets()
+	{
+		_active_depthstencil = invalid_index;
+		_num_active_views = 0;
+	}
 	void draw_call_tracker::track_depth_texture(int depth_buffer_texture_format, UINT index, com_ptr<ID3D11Texture2D> src_texture, com_ptr<ID3D11DepthStencilView> src_depthstencil, com_ptr<ID3D11Texture2D> dest_texture, bool cleared)
 	{
 		// Function that keeps track of a cleared depth texture in an ordered map in order to retrieve it at the final rendering stage
@@ -246,13 +319,9 @@ namespace reshade::d3d11
 		}
 	}
 
-	draw_call_tracker::intermediate_snapshot_info draw_call_tracker::find_best_snapshot(UINT width, UINT height)
+	void draw_call_tracker::add_depth_buffers(depth_buffer_selector &selector)
 	{
-		const float aspect_ratio = float(width) / float(height);
-
-		intermediate_snapshot_info best_snapshot;
-
-		for (auto &[depthstencil, snapshot] : _counters_per_used_depthstencil)
+		for (auto &snapshot : _counters_per_used_depthstencil)
 		{
 			if (snapshot.stats.drawcalls == 0 || snapshot.stats.vertices == 0)
 			{
@@ -262,7 +331,7 @@ namespace reshade::d3d11
 			if (snapshot.texture == nullptr)
 			{
 				com_ptr<ID3D11Resource> resource;
-				depthstencil->GetResource(&resource);
+				snapshot.depthstencil->GetResource(&resource);
 
 				if (FAILED(resource->QueryInterface(&snapshot.texture)))
 				{
@@ -275,24 +344,14 @@ namespace reshade::d3d11
 
 			assert((desc.BindFlags & D3D11_BIND_DEPTH_STENCIL) != 0);
 
-			// Check aspect ratio
-			const float width_factor = desc.Width != width ? float(width) / desc.Width : 1.0f;
-			const float height_factor = desc.Height != height ? float(height) / desc.Height : 1.0f;
-			const float texture_aspect_ratio = float(desc.Width) / float(desc.Height);
-
-			if (fabs(texture_aspect_ratio - aspect_ratio) > 0.1f || width_factor > 2.0f || height_factor > 2.0f || width_factor < 0.5f || height_factor < 0.5f)
-			{
-				// No match, not a good fit
-				continue;
-			}
-
-			if (snapshot.stats.drawcalls >= best_snapshot.stats.drawcalls)
-			{
-				best_snapshot = snapshot;
-			}
+			selector.add_depth_buffer({ reinterpret_cast<uintptr_t>(snapshot.depthstencil.get()), desc.Width, desc.Height, static_cast<uint32_t>(desc.Format), snapshot.stats.drawcalls, snapshot.stats.vertices });
 		}
+	}
+	const draw_call_tracker::intermediate_snapshot_info *draw_call_tracker::find_snapshot(ID3D11DepthStencilView *depthstencil) const
+	{
+		const UINT index = find_depthstencil(depthstencil);
 
-		return best_snapshot;
+		return index != invalid_index ? &_counters_per_used_depthstencil[index] : nullptr;
 	}
 
 	void draw_call_tracker::keep_cleared_depth_textures()
@@ -351,5 +410,73 @@ namespace reshade::d3d11
 
 		return best_match;
 	}
+
+	void draw_call_tracker::restore_active_snapshot(intermediate_snapshot_info &&snapshot)
+	{
+		snapshot.stats = draw_stats();
+
+		for (auto &view : snapshot.additional_views)
+		{
+			view.second = draw_stats();
+		}
+
+		_active_depthstencil = add_depthstencil(snapshot.depthstencil.get());
+		_counters_per_used_depthstencil[_active_depthstencil] = std::move(snapshot);
+	}
+	UINT draw_call_tracker::find_depthstencil(ID3D11DepthStencilView *depthstencil) const
+	{
+		if (_depthstencil_indices.empty())
+		{
+			return invalid_index;
+		}
+
+		const size_t mask = _depthstencil_indices.size() - 1;
+
+		for (size_t slot = depthstencil_hash(depthstencil) & mask;; slot = (slot + 1) & mask)
+		{
+			const UINT index = _depthstencil_indices[slot];
+
+			if (index == invalid_index || _counters_per_used_depthstencil[index].depthstencil == depthstencil)
+			{
+				return index;
+			}
+		}
+	}
+	UINT draw_call_tracker::add_depthstencil(ID3D11DepthStencilView *depthstencil)
+	{
+		assert(find_depthstencil(depthstencil) == invalid_index);
+
+		const UINT index = static_cast<UINT>(_counters_per_used_depthstencil.size());
+
+		_counters_per_used_depthstencil.emplace_back().depthstencil = depthstencil;
+
+		// Keep the table at most half full, so that probe sequences stay short
+		if (_depthstencil_indices.size() < 2 * _counters_per_used_depthstencil.size())
+		{
+			_depthstencil_indices.assign(std::max(size_t(16), 2 * _depthstencil_indices.size()), invalid_index);
+
+			for (UINT i = 0; i < index; i++)
+			{
+				insert_depthstencil_index(i);
+			}
+		}
+
+		insert_depthstencil_index(index);
+
+		return index;
+	}
+	void draw_call_tracker::insert_depthstencil_index(UINT index)
+	{
+		const size_t mask = _depthstencil_indices.size() - 1;
+
+		size_t slot = depthstencil_hash(_counters_per_used_depthstencil[index].depthstencil.get()) & mask;
+
+		while (_depthstencil_indices[slot] != invalid_index)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		_depthstencil_indices[slot] = index;
+	}
 #endif
 }
@@ -2,7 +2,9 @@
 
 #include <d3d11.h>
 #include <map>
+#include <vector>
 #include "com_ptr.hpp"
+#include "depth_buffer_selector.hpp"
 
 #define RESHADE_DX11_CAPTURE_DEPTH_BUFFERS 1
 #define RESHADE_DX11_CAPTURE_CONSTANT_BUFFERS 0
@@ -24,10 +26,10 @@ namespace reshade::d3d11
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
 		struct intermediate_snapshot_info
 		{
-			ID3D11DepthStencilView *depthstencil = nullptr; // No need to use a 'com_ptr' here since '_counters_per_used_depthstencil' already keeps a reference
+			com_ptr<ID3D11DepthStencilView> depthstencil;
 			draw_stats stats;
 			com_ptr<ID3D11Texture2D> texture;
-			std::map<ID3D11RenderTargetView *, draw_stats> additional_views;
+			std::vector<std::pair<ID3D11RenderTargetView *, draw_stats>> additional_views;
 		};
 #endif
 
@@ -44,6 +46,7 @@ namespace reshade::d3d11
 
 		void merge(const draw_call_tracker &source);
 		void reset();
+		void move_into(draw_call_tracker &destination);
 
 		void on_map(ID3D11Resource *pResource);
 		void on_draw(ID3D11DeviceContext *context, UINT vertices);
@@ -52,15 +55,26 @@ namespace reshade::d3d11
 		bool check_depth_texture_format(int depth_buffer_texture_format, ID3D11DepthStencilView *pDepthStencilView);
 		bool check_depthstencil(ID3D11DepthStencilView *depthstencil) const;
 		void track_rendertargets(int depth_buffer_texture_format, ID3D11DepthStencilView *depthstencil, UINT num_views, ID3D11RenderTargetView *const *views);
+		void untrack_rendertargets();
 		void track_depth_texture(int depth_buffer_texture_format, UINT index, com_ptr<ID3D11Texture2D> src_texture, com_ptr<ID3D11DepthStencilView> src_depthstencil, com_ptr<ID3D11Texture2D> dest_texture, bool cleared);
 
 		void keep_cleared_depth_textures();
 
-		intermediate_snapshot_info find_best_snapshot(UINT width, UINT height);
+		void add_depth_buffers(depth_buffer_selector &selector);
+		const intermediate_snapshot_info *find_snapshot(ID3D11DepthStencilView *depthstencil) const;
 		ID3D11Texture2D *find_best_cleared_depth_buffer_texture(UINT depth_buffer_clearing_number);
 #endif
 
 	private:
+		static constexpr UINT invalid_index = ~0u;
+
+#if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
+		void restore_active_snapshot(intermediate_snapshot_info &&snapshot);
+		UINT find_depthstencil(ID3D11DepthStencilView *depthstencil) const;
+		UINT add_depthstencil(ID3D11DepthStencilView *depthstencil);
+		void insert_depthstencil_index(UINT index);
+#endif
+
 		struct depth_texture_save_info
 		{
 			com_ptr<ID3D11Texture2D> src_texture;
@@ -72,8 +86,14 @@ namespace reshade::d3d11
 
 		draw_stats _global_counter;
 #if RESHADE_DX11_CAPTURE_DEPTH_BUFFERS
-		// Use "std::map" instead of "std::unordered_map" so that the iteration order is guaranteed
-		std::map<com_ptr<ID3D11DepthStencilView>, intermediate_snapshot_info> _counters_per_used_depthstencil;
+		// Entries are stored in the order the depth-stencil views were first used, so that the iteration order is guaranteed
+		std::vector<intermediate_snapshot_info> _counters_per_used_depthstencil;
+		// Open addressing hash table with linear probing which maps a depth-stencil view to its index in '_counters_per_used_depthstencil'
+		std::vector<UINT> _depthstencil_indices;
+		// Indices of the currently bound depth-stencil view and render target views, so that draw calls do not have to query the device context
+		UINT _active_depthstencil = invalid_index;
+		UINT _num_active_views = 0;
+		UINT _active_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		std::map<UINT, depth_texture_save_info> _cleared_depth_textures;
 #endif
 #if RESHADE_DX11_CAPTURE_CONSTANT_BUFFERS
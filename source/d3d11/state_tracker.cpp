@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "state_tracker.hpp"
+#include <algorithm>
+
+namespace reshade::d3d11
+{
+	// The device context keeps bound objects alive, so the references the query added can be dropped right away
+	template <typename T>
+	static inline void release_reference(T *object)
+	{
+		if (object != nullptr)
+		{
+			object->Release();
+		}
+	}
+	template <typename T, size_t SLOTS>
+	static inline void release_references(T *(&objects)[SLOTS])
+	{
+		for (const auto object : objects)
+		{
+			release_reference(object);
+		}
+	}
+
+	state_tracker::state_tracker()
+	{
+		clear_state();
+	}
+
+	bool state_tracker::uses_class_instances() const
+	{
+		return _vs_num_class_instances != 0 || _hs_num_class_instances != 0 || _ds_num_class_instances != 0 || _gs_num_class_instances != 0 || _ps_num_class_instances != 0;
+	}
+
+	void state_tracker::synchronize(ID3D11DeviceContext *devicecontext)
+	{
+		ID3D11ClassInstance *class_instances[256];
+
+		devicecontext->IAGetPrimitiveTopology(&_ia_primitive_topology);
+		devicecontext->IAGetInputLayout(&_ia_input_layout);
+		release_reference(_ia_input_layout);
+
+		devicecontext->RSGetState(&_rs_state);
+		release_reference(_rs_state);
+		_rs_num_viewports = max_viewports;
+		devicecontext->RSGetViewports(&_rs_num_viewports, _rs_viewports);
+		_rs_num_scissor_rects = max_viewports;
+		devicecontext->RSGetScissorRects(&_rs_num_scissor_rects, _rs_scissor_rects);
+
+		const auto get_shader = [&class_instances](auto get, auto &shader, UINT &num_class_instances) {
+			num_class_instances = ARRAYSIZE(class_instances);
+			get(&shader, class_instances, &num_class_instances);
+			release_reference(shader);
+
+			for (UINT i = 0; i < num_class_instances; i++)
+			{
+				release_reference(class_instances[i]);
+			}
+		};
+
+		get_shader([devicecontext](auto... args) { devicecontext->VSGetShader(args...); }, _vs, _vs_num_class_instances);
+		get_shader([devicecontext](auto... args) { devicecontext->HSGetShader(args...); }, _hs, _hs_num_class_instances);
+		get_shader([devicecontext](auto... args) { devicecontext->DSGetShader(args...); }, _ds, _ds_num_class_instances);
+		get_shader([devicecontext](auto... args) { devicecontext->GSGetShader(args...); }, _gs, _gs_num_class_instances);
+		get_shader([devicecontext](auto... args) { devicecontext->PSGetShader(args...); }, _ps, _ps_num_class_instances);
+
+		devicecontext->VSGetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
+		release_references(_vs_sampler_states);
+		devicecontext->PSGetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
+		release_references(_ps_sampler_states);
+
+		devicecontext->OMGetBlendState(&_om_blend_state, _om_blend_factor, &_om_sample_mask);
+		release_reference(_om_blend_state);
+		devicecontext->OMGetDepthStencilState(&_om_depth_stencil_state, &_om_stencil_ref);
+		release_reference(_om_depth_stencil_state);
+
+		_valid = true;
+	}
+
+	void state_tracker::clear_state()
+	{
+		_vs_num_class_instances = _hs_num_class_instances = _ds_num_class_instances = _gs_num_class_instances = _ps_num_class_instances = 0;
+
+		_ia_input_layout = nullptr;
+		_ia_primitive_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+		_vs = nullptr;
+		std::fill_n(_vs_sampler_states, ARRAYSIZE(_vs_sampler_states), nullptr);
+		_hs = nullptr;
+		_ds = nullptr;
+		_gs = nullptr;
+
+		_rs_state = nullptr;
+		_rs_num_viewports = 0;
+		_rs_num_scissor_rects = 0;
+
+		_ps = nullptr;
+		std::fill_n(_ps_sampler_states, ARRAYSIZE(_ps_sampler_states), nullptr);
+
+		_om_blend_state = nullptr;
+		std::fill_n(_om_blend_factor, 4, 1.0f);
+		_om_sample_mask = D3D11_DEFAULT_SAMPLE_MASK;
+		_om_depth_stencil_state = nullptr;
+		_om_stencil_ref = 0;
+
+		_valid = true;
+	}
+
+	void state_tracker::vs_set_shader(ID3D11VertexShader *shader, UINT num_class_instances)
+	{
+		_vs = shader;
+		_vs_num_class_instances = num_class_instances;
+	}
+	void state_tracker::hs_set_shader(ID3D11HullShader *shader, UINT num_class_instances)
+	{
+		_hs = shader;
+		_hs_num_class_instances = num_class_instances;
+	}
+	void state_tracker::ds_set_shader(ID3D11DomainShader *shader, UINT num_class_instances)
+	{
+		_ds = shader;
+		_ds_num_class_instances = num_class_instances;
+	}
+	void state_tracker::gs_set_shader(ID3D11GeometryShader *shader, UINT num_class_instances)
+	{
+		_gs = shader;
+		_gs_num_class_instances = num_class_instances;
+	}
+	void state_tracker::ps_set_shader(ID3D11PixelShader *shader, UINT num_class_instances)
+	{
+		_ps = shader;
+		_ps_num_class_instances = num_class_instances;
+	}
+
+	void state_tracker::rs_set_viewports(UINT num_viewports, const D3D11_VIEWPORT *viewports)
+	{
+		_rs_num_viewports = std::min(num_viewports, max_viewports);
+
+		if (viewports != nullptr)
+		{
+			std::copy_n(viewports, _rs_num_viewports, _rs_viewports);
+		}
+	}
+	void state_tracker::rs_set_scissor_rects(UINT num_rects, const D3D11_RECT *rects)
+	{
+		_rs_num_scissor_rects = std::min(num_rects, max_viewports);
+
+		if (rects != nullptr)
+		{
+			std::copy_n(rects, _rs_num_scissor_rects, _rs_scissor_rects);
+		}
+	}
+
+	void state_tracker::om_set_blend_state(ID3D11BlendState *state, const FLOAT blend_factor[4], UINT sample_mask)
+	{
+		_om_blend_state = state;
+		_om_sample_mask = sample_mask;
+
+		// A missing blend factor means the default one
+		if (blend_factor != nullptr)
+		{
+			std::copy_n(blend_factor, 4, _om_blend_factor);
+		}
+		else
+		{
+			std::fill_n(_om_blend_factor, 4, 1.0f);
+		}
+	}
+	void state_tracker::om_set_depth_stencil_state(ID3D11DepthStencilState *state, UINT stencil_ref)
+	{
+		_om_depth_stencil_state = state;
+		_om_stencil_ref = stencil_ref;
+	}
+}
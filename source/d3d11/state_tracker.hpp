@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <d3d11.h>
+
+namespace reshade::d3d11
+{
+	/// <summary>
+	/// Shadow copy of the pipeline state an application bound on a device context. The device context proxy updates it with every call it forwards, so that the state the runtime overwrites can be saved without querying the device.
+	/// Only the shaders and state objects the runtime changes while rendering are tracked. It holds no references, since the device context keeps every bound object alive and never unbinds these implicitly.
+	/// Buffers and views are not tracked, because binding a resource for output silently unbinds it from all input slots, which would leave stale pointers behind. Those have to be queried from the device context instead.
+	/// </summary>
+	class state_tracker
+	{
+		friend class d3d11_stateblock;
+
+	public:
+		static constexpr UINT max_viewports = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+
+		state_tracker();
+
+		/// <summary>
+		/// Returns whether the tracked state matches the device context. It does not after the state was changed by something other than the proxy.
+		/// </summary>
+		bool is_valid() const { return _valid; }
+		/// <summary>
+		/// Mark the tracked state as out of date, e.g. after the runtime changed bindings of the application.
+		/// </summary>
+		void invalidate() { _valid = false; }
+		/// <summary>
+		/// Returns whether any shader stage has class instances bound, which are not tracked.
+		/// </summary>
+		bool uses_class_instances() const;
+		/// <summary>
+		/// Read the current state from the device context, which makes the tracked state valid again.
+		/// </summary>
+		/// <param name="devicecontext">The device context to query.</param>
+		void synchronize(ID3D11DeviceContext *devicecontext);
+
+		/// <summary>
+		/// Reset to the default state of a device context, e.g. after 'ID3D11DeviceContext::ClearState'.
+		/// </summary>
+		void clear_state();
+
+		void ia_set_input_layout(ID3D11InputLayout *input_layout) { _ia_input_layout = input_layout; }
+		void ia_set_primitive_topology(D3D11_PRIMITIVE_TOPOLOGY topology) { _ia_primitive_topology = topology; }
+
+		void vs_set_shader(ID3D11VertexShader *shader, UINT num_class_instances);
+		void vs_set_samplers(UINT start_slot, UINT num_samplers, ID3D11SamplerState *const *samplers) { set_slots(_vs_sampler_states, start_slot, num_samplers, samplers); }
+		void hs_set_shader(ID3D11HullShader *shader, UINT num_class_instances);
+		void ds_set_shader(ID3D11DomainShader *shader, UINT num_class_instances);
+		void gs_set_shader(ID3D11GeometryShader *shader, UINT num_class_instances);
+		void ps_set_shader(ID3D11PixelShader *shader, UINT num_class_instances);
+		void ps_set_samplers(UINT start_slot, UINT num_samplers, ID3D11SamplerState *const *samplers) { set_slots(_ps_sampler_states, start_slot, num_samplers, samplers); }
+
+		void rs_set_state(ID3D11RasterizerState *state) { _rs_state = state; }
+		void rs_set_viewports(UINT num_viewports, const D3D11_VIEWPORT *viewports);
+		void rs_set_scissor_rects(UINT num_rects, const D3D11_RECT *rects);
+
+		void om_set_blend_state(ID3D11BlendState *state, const FLOAT blend_factor[4], UINT sample_mask);
+		void om_set_depth_stencil_state(ID3D11DepthStencilState *state, UINT stencil_ref);
+
+	private:
+		template <typename T, size_t SLOTS>
+		void set_slots(T *(&slots)[SLOTS], UINT start_slot, UINT num_objects, T *const *objects)
+		{
+			for (UINT i = 0; i < num_objects && start_slot + i < SLOTS; i++)
+			{
+				slots[start_slot + i] = objects != nullptr ? objects[i] : nullptr;
+			}
+		}
+
+		bool _valid = true;
+		UINT _vs_num_class_instances, _hs_num_class_instances, _ds_num_class_instances, _gs_num_class_instances, _ps_num_class_instances;
+		ID3D11InputLayout *_ia_input_layout;
+		D3D11_PRIMITIVE_TOPOLOGY _ia_primitive_topology;
+		ID3D11VertexShader *_vs;
+		ID3D11SamplerState *_vs_sampler_states[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		ID3D11HullShader *_hs;
+		ID3D11DomainShader *_ds;
+		ID3D11GeometryShader *_gs;
+		ID3D11RasterizerState *_rs_state;
+		UINT _rs_num_viewports;
+		D3D11_VIEWPORT _rs_viewports[max_viewports];
+		UINT _rs_num_scissor_rects;
+		D3D11_RECT _rs_scissor_rects[max_viewports];
+		ID3D11PixelShader *_ps;
+		ID3D11SamplerState *_ps_sampler_states[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		ID3D11BlendState *_om_blend_state;
+		FLOAT _om_blend_factor[4];
+		UINT _om_sample_mask;
+		ID3D11DepthStencilState *_om_depth_stencil_state;
+		UINT _om_stencil_ref;
+	};
+}
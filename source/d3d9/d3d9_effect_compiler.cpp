@@ -148,6 +148,7 @@ namespace reshade::d3d9
 		_runtime(runtime),
 		_ast(ast),
 		_errors(errors),
+		_uniform_usage(ast),
 		_skip_shader_optimization(skipoptimization),
 		_current_function(nullptr)
 	{
@@ -163,13 +164,16 @@ namespace reshade::d3d9
 
 	bool d3d9_effect_compiler::run()
 	{
-		_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_47.dll");
-
-		if (_d3dcompiler_module == nullptr)
+		// The library is kept loaded by the runtime, since techniques are only compiled once they are first enabled
+		if (_runtime->_d3d_compiler == nullptr)
+		{
+			_runtime->_d3d_compiler = LoadLibraryW(L"d3dcompiler_47.dll");
+		}
+		if (_runtime->_d3d_compiler == nullptr)
 		{
-			_d3dcompiler_module = LoadLibraryW(L"d3dcompiler_43.dll");
+			_runtime->_d3d_compiler = LoadLibraryW(L"d3dcompiler_43.dll");
 		}
-		if (_d3dcompiler_module == nullptr)
+		if (_runtime->_d3d_compiler == nullptr)
 		{
 			_errors += "Unable to load D3DCompiler library. Make sure you have the DirectX end-user runtime (June 2010) installed or a newer version of the library in the application directory.\n";
 			return false;
@@ -220,8 +224,6 @@ namespace reshade::d3d9
 			visit_technique(technique);
 		}
 
-		FreeLibrary(_d3dcompiler_module);
-
 		return _success;
 	}
 
@@ -1575,26 +1577,6 @@ namespace reshade::d3d9
 	}
 	void d3d9_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
-		auto type = node->type;
-		type.basetype = type_node::datatype_float;
-		visit(_global_code, type);
-
-		_global_code << ' ' << node->unique_name;
-
-		if (node->type.is_array())
-		{
-			_global_code << '[';
-
-			if (node->type.array_length > 0)
-			{
-				_global_code << node->type.array_length;
-			}
-
-			_global_code << ']';
-		}
-
-		_global_code << " : register(c" << _constant_register_count << ");\n";
-
 		uniform obj;
 		obj.name = node->name;
 		obj.unique_name = node->unique_name;
@@ -1628,6 +1610,8 @@ namespace reshade::d3d9
 			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
 		}
 
+		_uniform_storage_offsets[node] = obj.storage_offset;
+
 		_runtime->add_uniform(std::move(obj));
 	}
 	void d3d9_effect_compiler::visit_technique(const technique_declaration_node *node)
@@ -1636,16 +1620,65 @@ namespace reshade::d3d9
 		obj.name = node->name;
 		obj.annotations = node->annotation_list;
 
-		if (_constant_register_count != 0)
+		// Lay out a compact register block containing only the uniforms this technique actually references
+		const auto layout = layout_uniform_block(_uniform_usage.find(node), uniform_packing::constant_registers);
+
+		std::stringstream uniforms;
+		std::vector<size_t> storage_offsets;
+
+		for (size_t i = 0; i < layout.uniforms.size(); i++)
+		{
+			auto type = layout.uniforms[i]->type;
+			type.basetype = type_node::datatype_float;
+			visit(uniforms, type);
+
+			uniforms << ' ' << layout.uniforms[i]->unique_name;
+
+			if (type.is_array())
+			{
+				uniforms << '[' << type.array_length << ']';
+			}
+
+			uniforms << " : register(c" << (layout.offsets[i] / 16) << ");\n";
+
+			storage_offsets.push_back(_uniform_storage_offsets.at(layout.uniforms[i]));
+		}
+
+		// Other uniforms may still be referenced by functions this technique does not use, so declare them as plain variables to keep the code valid
+		for (auto variable : _ast.variables)
+		{
+			if (_uniform_storage_offsets.count(variable) && std::find(layout.uniforms.begin(), layout.uniforms.end(), variable) == layout.uniforms.end())
+			{
+				auto type = variable->type;
+				type.basetype = type_node::datatype_float;
+				type.qualifiers = type_node::qualifier_static;
+				visit(uniforms, type);
+
+				uniforms << ' ' << variable->unique_name;
+
+				if (type.is_array())
+				{
+					uniforms << '[' << type.array_length << ']';
+				}
+
+				uniforms << ";\n";
+			}
+		}
+
+		_technique_uniforms = uniforms.str();
+
+		if (layout.size != 0)
 		{
-			obj.uniform_storage_index = _constant_register_count;
-			obj.uniform_storage_offset = _uniform_storage_offset;
+			obj.uniform_storage_index = layout.size / 16;
+			obj.uniform_block_size = layout.size;
+			obj.uniform_block_ranges = build_uniform_copy_ranges(layout, storage_offsets);
 		}
 
 		for (auto pass : node->pass_list)
 		{
 			obj.passes.emplace_back(std::make_unique<d3d9_pass_data>());
 			visit_pass(pass, *static_cast<d3d9_pass_data *>(obj.passes.back().get()));
+			obj.pass_texture_usage.push_back(analyze_texture_access(_uniform_usage, pass));
 		}
 
 		_runtime->add_technique(std::move(obj));
@@ -1654,6 +1687,7 @@ namespace reshade::d3d9
 	{
 		pass.render_targets[0] = _runtime->_backbuffer_resolved.get();
 		pass.clear_render_targets = node->clear_render_targets;
+		pass.back_buffer_usage = analyze_back_buffer_access(_uniform_usage, node);
 
 		std::string samplers[2];
 		const char shader_types[2][3] = { "vs", "ps" };
@@ -1707,72 +1741,93 @@ namespace reshade::d3d9
 		}
 
 		const auto &device = _runtime->_device;
-		const HRESULT hr = device->BeginStateBlock();
 
-		if (FAILED(hr))
-		{
-			error(node->location, "internal pass stateblock creation failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-			return;
+		const std::pair<D3DRENDERSTATETYPE, DWORD> render_states[] = {
+			{ D3DRS_ZENABLE, FALSE },
+			{ D3DRS_SPECULARENABLE, FALSE },
+			{ D3DRS_FILLMODE, D3DFILL_SOLID },
+			{ D3DRS_SHADEMODE, D3DSHADE_GOURAUD },
+			{ D3DRS_ZWRITEENABLE, TRUE },
+			{ D3DRS_ALPHATESTENABLE, FALSE },
+			{ D3DRS_LASTPIXEL, TRUE },
+			{ D3DRS_SRCBLEND, static_cast<DWORD>(literal_to_blend_func(node->src_blend)) },
+			{ D3DRS_DESTBLEND, static_cast<DWORD>(literal_to_blend_func(node->dest_blend)) },
+			{ D3DRS_ALPHAREF, 0 },
+			{ D3DRS_ALPHAFUNC, D3DCMP_ALWAYS },
+			{ D3DRS_DITHERENABLE, FALSE },
+			{ D3DRS_FOGSTART, 0 },
+			{ D3DRS_FOGEND, 1 },
+			{ D3DRS_FOGDENSITY, 1 },
+			{ D3DRS_ALPHABLENDENABLE, static_cast<DWORD>(node->blend_enable) },
+			{ D3DRS_DEPTHBIAS, 0 },
+			{ D3DRS_STENCILENABLE, static_cast<DWORD>(node->stencil_enable) },
+			{ D3DRS_STENCILPASS, static_cast<DWORD>(literal_to_stencil_op(node->stencil_op_pass)) },
+			{ D3DRS_STENCILFAIL, static_cast<DWORD>(literal_to_stencil_op(node->stencil_op_fail)) },
+			{ D3DRS_STENCILZFAIL, static_cast<DWORD>(literal_to_stencil_op(node->stencil_op_depth_fail)) },
+			{ D3DRS_STENCILFUNC, static_cast<DWORD>(node->stencil_comparison_func) },
+			{ D3DRS_STENCILREF, static_cast<DWORD>(node->stencil_reference_value) },
+			{ D3DRS_STENCILMASK, static_cast<DWORD>(node->stencil_read_mask) },
+			{ D3DRS_STENCILWRITEMASK, static_cast<DWORD>(node->stencil_write_mask) },
+			{ D3DRS_TEXTUREFACTOR, 0xFFFFFFFF },
+			{ D3DRS_LOCALVIEWER, TRUE },
+			{ D3DRS_EMISSIVEMATERIALSOURCE, D3DMCS_MATERIAL },
+			{ D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_MATERIAL },
+			{ D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_COLOR1 },
+			{ D3DRS_SPECULARMATERIALSOURCE, D3DMCS_COLOR2 },
+			{ D3DRS_COLORWRITEENABLE, static_cast<DWORD>(node->color_write_mask) },
+			{ D3DRS_BLENDOP, static_cast<DWORD>(node->blend_op) },
+			{ D3DRS_SCISSORTESTENABLE, FALSE },
+			{ D3DRS_SLOPESCALEDEPTHBIAS, 0 },
+			{ D3DRS_ANTIALIASEDLINEENABLE, FALSE },
+			{ D3DRS_TWOSIDEDSTENCILMODE, FALSE },
+			{ D3DRS_CCW_STENCILFAIL, D3DSTENCILOP_KEEP },
+			{ D3DRS_CCW_STENCILZFAIL, D3DSTENCILOP_KEEP },
+			{ D3DRS_CCW_STENCILPASS, D3DSTENCILOP_KEEP },
+			{ D3DRS_CCW_STENCILFUNC, D3DCMP_ALWAYS },
+			{ D3DRS_COLORWRITEENABLE1, 0x0000000F },
+			{ D3DRS_COLORWRITEENABLE2, 0x0000000F },
+			{ D3DRS_COLORWRITEENABLE3, 0x0000000F },
+			{ D3DRS_BLENDFACTOR, 0xFFFFFFFF },
+			{ D3DRS_SRGBWRITEENABLE, static_cast<DWORD>(node->srgb_write_enable) },
+			{ D3DRS_SEPARATEALPHABLENDENABLE, FALSE },
+			{ D3DRS_SRCBLENDALPHA, static_cast<DWORD>(literal_to_blend_func(node->src_blend_alpha)) },
+			{ D3DRS_DESTBLENDALPHA, static_cast<DWORD>(literal_to_blend_func(node->dest_blend_alpha)) },
+			{ D3DRS_BLENDOPALPHA, static_cast<DWORD>(node->blend_op_alpha) },
+			{ D3DRS_FOGENABLE, FALSE },
+			{ D3DRS_CULLMODE, D3DCULL_NONE },
+			{ D3DRS_LIGHTING, FALSE },
+		};
+
+		// Passes with the same render states share a stateblock, so that the runtime can skip applying it again for consecutive passes
+		std::vector<DWORD> render_state_values;
+		render_state_values.reserve(_countof(render_states));
+
+		for (const auto &state : render_states)
+		{
+			render_state_values.push_back(state.second);
+		}
+
+		auto &stateblock = _stateblocks[render_state_values];
+
+		if (stateblock == nullptr)
+		{
+			const HRESULT hr = device->BeginStateBlock();
+
+			if (FAILED(hr))
+			{
+				error(node->location, "internal pass stateblock creation failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+				return;
+			}
+
+			for (const auto &state : render_states)
+			{
+				device->SetRenderState(state.first, state.second);
+			}
+
+			device->EndStateBlock(&stateblock);
 		}
 
-		device->SetVertexShader(pass.vertex_shader.get());
-		device->SetPixelShader(pass.pixel_shader.get());
-
-		device->SetRenderState(D3DRS_ZENABLE, false);
-		device->SetRenderState(D3DRS_SPECULARENABLE, false);
-		device->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
-		device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
-		device->SetRenderState(D3DRS_ZWRITEENABLE, true);
-		device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
-		device->SetRenderState(D3DRS_LASTPIXEL, true);
-		device->SetRenderState(D3DRS_SRCBLEND, literal_to_blend_func(node->src_blend));
-		device->SetRenderState(D3DRS_DESTBLEND, literal_to_blend_func(node->dest_blend));
-		device->SetRenderState(D3DRS_ALPHAREF, 0);
-		device->SetRenderState(D3DRS_ALPHAFUNC, D3DCMP_ALWAYS);
-		device->SetRenderState(D3DRS_DITHERENABLE, false);
-		device->SetRenderState(D3DRS_FOGSTART, 0);
-		device->SetRenderState(D3DRS_FOGEND, 1);
-		device->SetRenderState(D3DRS_FOGDENSITY, 1);
-		device->SetRenderState(D3DRS_ALPHABLENDENABLE, node->blend_enable);
-		device->SetRenderState(D3DRS_DEPTHBIAS, 0);
-		device->SetRenderState(D3DRS_STENCILENABLE, node->stencil_enable);
-		device->SetRenderState(D3DRS_STENCILPASS, literal_to_stencil_op(node->stencil_op_pass));
-		device->SetRenderState(D3DRS_STENCILFAIL, literal_to_stencil_op(node->stencil_op_fail));
-		device->SetRenderState(D3DRS_STENCILZFAIL, literal_to_stencil_op(node->stencil_op_depth_fail));
-		device->SetRenderState(D3DRS_STENCILFUNC, static_cast<D3DCMPFUNC>(node->stencil_comparison_func));
-		device->SetRenderState(D3DRS_STENCILREF, node->stencil_reference_value);
-		device->SetRenderState(D3DRS_STENCILMASK, node->stencil_read_mask);
-		device->SetRenderState(D3DRS_STENCILWRITEMASK, node->stencil_write_mask);
-		device->SetRenderState(D3DRS_TEXTUREFACTOR, 0xFFFFFFFF);
-		device->SetRenderState(D3DRS_LOCALVIEWER, true);
-		device->SetRenderState(D3DRS_EMISSIVEMATERIALSOURCE, D3DMCS_MATERIAL);
-		device->SetRenderState(D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_MATERIAL);
-		device->SetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_COLOR1);
-		device->SetRenderState(D3DRS_SPECULARMATERIALSOURCE, D3DMCS_COLOR2);
-		device->SetRenderState(D3DRS_COLORWRITEENABLE, node->color_write_mask);
-		device->SetRenderState(D3DRS_BLENDOP, static_cast<D3DBLENDOP>(node->blend_op));
-		device->SetRenderState(D3DRS_SCISSORTESTENABLE, false);
-		device->SetRenderState(D3DRS_SLOPESCALEDEPTHBIAS, 0);
-		device->SetRenderState(D3DRS_ANTIALIASEDLINEENABLE, false);
-		device->SetRenderState(D3DRS_TWOSIDEDSTENCILMODE, false);
-		device->SetRenderState(D3DRS_CCW_STENCILFAIL, D3DSTENCILOP_KEEP);
-		device->SetRenderState(D3DRS_CCW_STENCILZFAIL, D3DSTENCILOP_KEEP);
-		device->SetRenderState(D3DRS_CCW_STENCILPASS, D3DSTENCILOP_KEEP);
-		device->SetRenderState(D3DRS_CCW_STENCILFUNC, D3DCMP_ALWAYS);
-		device->SetRenderState(D3DRS_COLORWRITEENABLE1, 0x0000000F);
-		device->SetRenderState(D3DRS_COLORWRITEENABLE2, 0x0000000F);
-		device->SetRenderState(D3DRS_COLORWRITEENABLE3, 0x0000000F);
-		device->SetRenderState(D3DRS_BLENDFACTOR, 0xFFFFFFFF);
-		device->SetRenderState(D3DRS_SRGBWRITEENABLE, node->srgb_write_enable);
-		device->SetRenderState(D3DRS_SEPARATEALPHABLENDENABLE, false);
-		device->SetRenderState(D3DRS_SRCBLENDALPHA, literal_to_blend_func(node->src_blend_alpha));
-		device->SetRenderState(D3DRS_DESTBLENDALPHA, literal_to_blend_func(node->dest_blend_alpha));
-		device->SetRenderState(D3DRS_BLENDOPALPHA, static_cast<D3DBLENDOP>(node->blend_op_alpha));
-		device->SetRenderState(D3DRS_FOGENABLE, false);
-		device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
-		device->SetRenderState(D3DRS_LIGHTING, false);
-
-		device->EndStateBlock(&pass.stateblock);
+		pass.stateblock = stateblock;
 
 		D3DCAPS9 caps;
 		device->GetDeviceCaps(&caps);
@@ -1831,6 +1886,7 @@ namespace reshade::d3d9
 		}
 
 		source << samplers;
+		source << _technique_uniforms;
 		source << _global_code.str();
 
 		for (auto dependency : _functions.at(node).dependencies)
@@ -2028,7 +2084,7 @@ namespace reshade::d3d9
 
 		source << "}\n";
 
-		const std::string source_str = source.str();
+		std::string source_str = source.str();
 
 #if RESHADE_DUMP_NATIVE_SHADERS
 		if (!_dumped_shaders.count(node->unique_name))
@@ -2044,41 +2100,12 @@ namespace reshade::d3d9
 		}
 #endif
 
-		UINT flags = 0;
-		com_ptr<ID3DBlob> compiled, errors;
+		// Compilation is deferred until the technique is first enabled, so just store the source code for it
+		pass.shader_sources[shadertype == "vs" ? 0 : 1] = std::move(source_str);
 
 		if (_skip_shader_optimization)
 		{
-			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
-		}
-
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
-		HRESULT hr = D3DCompile(source_str.c_str(), source_str.size(), nullptr, nullptr, nullptr, "__main", (shadertype + "_3_0").c_str(), flags, 0, &compiled, &errors);
-
-		if (errors != nullptr)
-		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
-		}
-
-		if (FAILED(hr))
-		{
-			error(node->location, "internal shader compilation failed");
-			return;
-		}
-
-		if (shadertype == "vs")
-		{
-			hr = _runtime->_device->CreateVertexShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.vertex_shader);
-		}
-		else if (shadertype == "ps")
-		{
-			hr = _runtime->_device->CreatePixelShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.pixel_shader);
-		}
-
-		if (FAILED(hr))
-		{
-			error(node->location, "internal shader creation failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-			return;
+			pass.shader_compile_flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 	}
 }
@@ -5,7 +5,8 @@
 
 #pragma once
 
-#include "effect_syntax_tree.hpp"
+#include "effect_uniform_usage.hpp"
+#include <map>
 #include <sstream>
 #include <unordered_set>
 
@@ -76,13 +77,16 @@ namespace reshade::d3d9
 		bool _success = true;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
+		reshadefx::uniform_usage _uniform_usage;
 		size_t _uniform_storage_offset = 0, _constant_register_count = 0;
-		std::stringstream _global_code, _global_uniforms;
+		std::stringstream _global_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _uniform_storage_offsets;
+		std::string _technique_uniforms;
 		bool _skip_shader_optimization;
 		const reshadefx::nodes::function_declaration_node *_current_function;
 		std::unordered_map<std::string, d3d9_sampler> _samplers;
 		std::unordered_map<const reshadefx::nodes::function_declaration_node *, function> _functions;
-		HMODULE _d3dcompiler_module = nullptr;
+		std::map<std::vector<DWORD>, com_ptr<IDirect3DStateBlock9>> _stateblocks;
 #if RESHADE_DUMP_NATIVE_SHADERS
 		filesystem::path _dump_filename;
 		std::unordered_set<std::string> _dumped_shaders;
@@ -10,6 +10,7 @@
 #include "input.hpp"
 #include <imgui.h>
 #include <algorithm>
+#include <d3dcompiler.h>
 
 const auto D3DFMT_INTZ = static_cast<D3DFORMAT>(MAKEFOURCC('I', 'N', 'T', 'Z'));
 const auto D3DFMT_DF16 = static_cast<D3DFORMAT>(MAKEFOURCC('D', 'F', '1', '6'));
@@ -273,6 +274,12 @@ namespace reshade::d3d9
 
 		runtime::on_reset();
 
+		if (_d3d_compiler != nullptr)
+		{
+			FreeLibrary(_d3d_compiler);
+			_d3d_compiler = nullptr;
+		}
+
 		// Destroy resources
 		_app_state.reset();
 
@@ -348,6 +355,9 @@ namespace reshade::d3d9
 		// Apply post processing
 		if (is_effect_loaded())
 		{
+			// The application may have changed any state since the last frame
+			_state_cache.invalidate();
+
 			_device->SetRenderTarget(0, _backbuffer_resolved.get());
 			_device->SetDepthStencilSurface(nullptr);
 
@@ -355,7 +365,11 @@ namespace reshade::d3d9
 			_device->SetStreamSource(0, _effect_triangle_buffer.get(), 0, sizeof(float));
 			_device->SetVertexDeclaration(_effect_triangle_layout.get());
 
+			_back_buffer_planner.begin_frame();
+
 			on_present_effect();
+
+			_back_buffer_planner.end_frame();
 		}
 
 		// Apply presenting
@@ -529,7 +543,30 @@ namespace reshade::d3d9
 	{
 		return d3d9_effect_compiler(this, ast, errors, false).run();
 	}
-	bool d3d9_runtime::update_texture(texture &texture, const uint8_t *data)
+	upload_layout d3d9_runtime::get_upload_layout(const texture &texture) const
+	{
+		// Textures with mipmaps generate them automatically, so only the first level is uploaded
+		upload_layout layout;
+
+		// The 8-bit formats are created as 32bpp BGRA textures
+		switch (texture.format)
+		{
+			case texture_format::r8:
+				layout.channels[0] = -1, layout.channels[1] = -1, layout.channels[2] = 0, layout.channels[3] = -1;
+				break;
+			case texture_format::rg8:
+				layout.channels[0] = -1, layout.channels[1] = 1, layout.channels[2] = 0, layout.channels[3] = -1;
+				break;
+			case texture_format::rgba8:
+				layout.channels[0] = 2, layout.channels[1] = 1, layout.channels[2] = 0, layout.channels[3] = 3;
+				break;
+			default:
+				break;
+		}
+
+		return layout;
+	}
+	bool d3d9_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
 	{
 		if (texture.impl_reference != texture_reference::none)
 		{
@@ -538,7 +575,7 @@ namespace reshade::d3d9
 
 		const auto texture_impl = texture.impl->as<d3d9_tex_data>();
 
-		assert(data != nullptr);
+		assert(data != nullptr && !levels.empty());
 		assert(texture_impl != nullptr);
 
 		D3DSURFACE_DESC desc;
@@ -563,35 +600,14 @@ namespace reshade::d3d9
 			return false;
 		}
 
-		const UINT size = std::min(texture.width * 4, static_cast<UINT>(mapped_rect.Pitch)) * texture.height;
+		// The data was already converted to the texture format by the texture loader, so it only has to be copied row by row
+		const upload_level &level = levels[0];
+		const size_t row_size = std::min(level.row_pitch, static_cast<size_t>(mapped_rect.Pitch));
 		auto mapped_data = static_cast<BYTE *>(mapped_rect.pBits);
 
-		switch (texture.format)
+		for (UINT y = 0; y < std::min(level.height, desc.Height); y++, mapped_data += mapped_rect.Pitch)
 		{
-			case texture_format::r8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = 0,
-					mapped_data[1] = 0,
-					mapped_data[2] = data[i],
-					mapped_data[3] = 0;
-				break;
-			case texture_format::rg8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = 0,
-					mapped_data[1] = data[i + 1],
-					mapped_data[2] = data[i],
-					mapped_data[3] = 0;
-				break;
-			case texture_format::rgba8:
-				for (UINT i = 0; i < size; i += 4, mapped_data += 4)
-					mapped_data[0] = data[i + 2],
-					mapped_data[1] = data[i + 1],
-					mapped_data[2] = data[i],
-					mapped_data[3] = data[i + 3];
-				break;
-			default:
-				std::memcpy(mapped_data, data, size);
-				break;
+			std::memcpy(mapped_data, data + level.offset + y * level.row_pitch, row_size);
 		}
 
 		mem_texture->UnlockRect(0);
@@ -658,44 +674,165 @@ namespace reshade::d3d9
 
 		return true;
 	}
+	bool d3d9_runtime::alias_texture(texture &texture, const texture &owner)
+	{
+		const auto texture_impl = texture.impl->as<d3d9_tex_data>();
+		const auto owner_impl = owner.impl->as<d3d9_tex_data>();
+
+		if (texture_impl == nullptr || owner_impl == nullptr)
+		{
+			return false;
+		}
+
+		// Samplers reference the texture data and pick up the change, but render targets are bound through their surface directly
+		for (auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<d3d9_pass_data>();
+
+				std::replace(std::begin(pass.render_targets), std::end(pass.render_targets), texture_impl->surface.get(), owner_impl->surface.get());
+			}
+		}
+
+		texture_impl->texture = owner_impl->texture;
+		texture_impl->surface = owner_impl->surface;
+
+		return true;
+	}
 
-	void d3d9_runtime::render_technique(const technique &technique)
+	bool d3d9_runtime::compile_technique(const std::vector<base_object *> &passes) const
+	{
+		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3d_compiler, "D3DCompile"));
+
+		if (D3DCompile == nullptr)
+		{
+			return false;
+		}
+
+		const char *const profiles[2] = { "vs_3_0", "ps_3_0" };
+
+		for (const auto pass_object : passes)
+		{
+			const auto pass = pass_object->as<d3d9_pass_data>();
+
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				if (pass->shader_sources[i].empty())
+				{
+					continue;
+				}
+
+				com_ptr<ID3DBlob> errors;
+				const HRESULT hr = D3DCompile(pass->shader_sources[i].c_str(), pass->shader_sources[i].size(), nullptr, nullptr, nullptr, "__main", profiles[i], pass->shader_compile_flags, 0, &pass->shader_bytecode[i], &errors);
+
+				if (FAILED(hr))
+				{
+					LOG(ERROR) << "Failed to compile shader:\n" << (errors != nullptr ? static_cast<const char *>(errors->GetBufferPointer()) : "");
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+	bool d3d9_runtime::create_technique_shaders(technique &technique)
+	{
+		for (const auto &pass_object : technique.passes)
+		{
+			const auto pass = pass_object->as<d3d9_pass_data>();
+
+			HRESULT hr = D3D_OK;
+
+			if (pass->shader_bytecode[0] != nullptr)
+			{
+				hr = _device->CreateVertexShader(static_cast<const DWORD *>(pass->shader_bytecode[0]->GetBufferPointer()), &pass->vertex_shader);
+			}
+			if (SUCCEEDED(hr) && pass->shader_bytecode[1] != nullptr)
+			{
+				hr = _device->CreatePixelShader(static_cast<const DWORD *>(pass->shader_bytecode[1]->GetBufferPointer()), &pass->pixel_shader);
+			}
+
+			// The bytecode is no longer needed once the shader objects exist
+			pass->shader_bytecode[0].reset();
+			pass->shader_bytecode[1].reset();
+
+			if (FAILED(hr))
+			{
+				LOG(ERROR) << "Failed to create shaders for technique '" << technique.name << "'! HRESULT is '" << std::hex << hr << std::dec << "'.";
+				return false;
+			}
+		}
+
+		return true;
+	}
+	void d3d9_runtime::render_technique(technique &technique)
 	{
 		bool is_default_depthstencil_cleared = false;
 
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
-			const auto uniform_storage_data = reinterpret_cast<const float *>(get_uniform_value_storage().data() + technique.uniform_storage_offset);
-			_device->SetVertexShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
-			_device->SetPixelShaderConstantF(0, uniform_storage_data, static_cast<UINT>(technique.uniform_storage_index));
+			// Gather the uniforms referenced by this technique into its compact register block
+			_uniform_block_data.resize(technique.uniform_block_size / sizeof(float));
+
+			for (const auto &range : technique.uniform_block_ranges)
+			{
+				CopyMemory(reinterpret_cast<uint8_t *>(_uniform_block_data.data()) + range.block_offset, get_uniform_value_storage().data() + range.storage_offset, range.size);
+			}
+
+			_device->SetVertexShaderConstantF(0, _uniform_block_data.data(), static_cast<UINT>(technique.uniform_storage_index));
+			_device->SetPixelShaderConstantF(0, _uniform_block_data.data(), static_cast<UINT>(technique.uniform_storage_index));
 		}
 
 		for (const auto &pass_object : technique.passes)
 		{
 			const d3d9_pass_data &pass = *pass_object->as<d3d9_pass_data>();
 
-			// Setup states
-			pass.stateblock->Apply();
+			// Setup states, unless the previous pass already applied the same stateblock
+			if (_state_cache.set_state_block(reinterpret_cast<uintptr_t>(pass.stateblock.get())))
+			{
+				pass.stateblock->Apply();
+			}
 
-			// Save back buffer of previous pass
-			_device->StretchRect(_backbuffer_resolved.get(), nullptr, _backbuffer_texture_surface.get(), nullptr, D3DTEXF_NONE);
+			if (_state_cache.set_shaders(reinterpret_cast<uintptr_t>(pass.vertex_shader.get()), reinterpret_cast<uintptr_t>(pass.pixel_shader.get())))
+			{
+				_device->SetVertexShader(pass.vertex_shader.get());
+				_device->SetPixelShader(pass.pixel_shader.get());
+			}
 
-			// Setup shader resources
+			// Save back buffer of previous pass, but only if this pass samples it and it changed since the last copy
+			if (_back_buffer_planner.plan_pass(pass.back_buffer_usage).copy_source >= 0)
+			{
+				_device->StretchRect(_backbuffer_resolved.get(), nullptr, _backbuffer_texture_surface.get(), nullptr, D3DTEXF_NONE);
+			}
+
+			// Setup shader resources, skipping textures and sampler states which the previous passes already set
 			for (DWORD sampler = 0; sampler < pass.sampler_count; sampler++)
 			{
-				_device->SetTexture(sampler, pass.samplers[sampler].texture->texture.get());
+				IDirect3DTexture9 *const texture = pass.samplers[sampler].texture->texture.get();
+
+				if (_state_cache.set_shader_resource(sampler, reinterpret_cast<uintptr_t>(texture)))
+				{
+					_device->SetTexture(sampler, texture);
+				}
 
 				for (DWORD state = D3DSAMP_ADDRESSU; state <= D3DSAMP_SRGBTEXTURE; state++)
 				{
-					_device->SetSamplerState(sampler, static_cast<D3DSAMPLERSTATETYPE>(state), pass.samplers[sampler].states[state]);
+					if (_state_cache.set_sampler_state(sampler, state, pass.samplers[sampler].states[state]))
+					{
+						_device->SetSamplerState(sampler, static_cast<D3DSAMPLERSTATETYPE>(state), pass.samplers[sampler].states[state]);
+					}
 				}
 			}
 
 			// Setup render targets
 			for (DWORD target = 0; target < _num_simultaneous_rendertargets; target++)
 			{
-				_device->SetRenderTarget(target, pass.render_targets[target]);
+				if (_state_cache.set_render_target(target, reinterpret_cast<uintptr_t>(pass.render_targets[target])))
+				{
+					_device->SetRenderTarget(target, pass.render_targets[target]);
+				}
 			}
 
 			D3DVIEWPORT9 viewport;
@@ -706,7 +843,12 @@ namespace reshade::d3d9
 
 			const bool is_viewport_sized = viewport.Width == _width && viewport.Height == _height;
 
-			_device->SetDepthStencilSurface(is_viewport_sized ? _default_depthstencil.get() : nullptr);
+			IDirect3DSurface9 *const depthstencil = is_viewport_sized ? _default_depthstencil.get() : nullptr;
+
+			if (_state_cache.set_depth_stencil(reinterpret_cast<uintptr_t>(depthstencil)))
+			{
+				_device->SetDepthStencilSurface(depthstencil);
+			}
 
 			if (is_viewport_sized && !is_default_depthstencil_cleared)
 			{
@@ -887,6 +1029,7 @@ namespace reshade::d3d9
 			{
 				traffic = 0;
 				create_depthstencil_replacement(nullptr);
+				_depth_buffer_selector.reset();
 				return;
 			}
 			else
@@ -900,8 +1043,7 @@ namespace reshade::d3d9
 			return;
 		}
 
-		depth_source_info best_info = { 0 };
-		IDirect3DSurface9 *best_match = nullptr;
+		_depth_buffer_selector.begin_frame(_width, _height);
 
 		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end();)
 		{
@@ -912,6 +1054,8 @@ namespace reshade::d3d9
 			{
 				depthstencil->Release();
 
+				_depth_buffer_selector.remove_depth_buffer(reinterpret_cast<uintptr_t>(depthstencil));
+
 				it = _depth_source_table.erase(it);
 				continue;
 			}
@@ -920,23 +1064,23 @@ namespace reshade::d3d9
 				++it;
 			}
 
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if ((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls)))
-			{
-				best_match = depthstencil;
-				best_info = depthstencil_info;
-			}
+			// Surfaces are filtered by size when they are first bound already
+			_depth_buffer_selector.add_depth_buffer({ reinterpret_cast<uintptr_t>(depthstencil), depthstencil_info.width, depthstencil_info.height, 0, depthstencil_info.drawcall_count, depthstencil_info.vertices_count });
 
 			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
 		}
 
-		if (best_match != nullptr && _depthstencil != best_match)
+		_depth_buffer_selector.end_frame(_drawcalls);
+
+		if (_depth_buffer_selector.has_selection())
 		{
-			create_depthstencil_replacement(best_match);
+			// Selected surfaces are still in the table, which keeps them alive
+			const auto best_match = reinterpret_cast<IDirect3DSurface9 *>(_depth_buffer_selector.selected());
+
+			if (_depthstencil != best_match)
+			{
+				create_depthstencil_replacement(best_match);
+			}
 		}
 	}
 
@@ -6,7 +6,10 @@
 #pragma once
 
 #include <d3d9.h>
+#include <d3dcommon.h>
 #include "runtime.hpp"
+#include "render_graph.hpp"
+#include "render_state_cache.hpp"
 #include "com_ptr.hpp"
 
 namespace reshade::d3d9
@@ -30,7 +33,11 @@ namespace reshade::d3d9
 		DWORD sampler_count = 0;
 		com_ptr<IDirect3DStateBlock9> stateblock;
 		bool clear_render_targets = false;
+		back_buffer_access back_buffer_usage;
 		IDirect3DSurface9 *render_targets[8] = { };
+		std::string shader_sources[2];
+		UINT shader_compile_flags = 0;
+		com_ptr<ID3DBlob> shader_bytecode[2];
 	};
 
 	class d3d9_runtime : public runtime
@@ -47,10 +54,14 @@ namespace reshade::d3d9
 
 		void capture_frame(uint8_t *buffer) const override;
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
-		bool update_texture(texture &texture, const uint8_t *data) override;
+		upload_layout get_upload_layout(const texture &texture) const override;
+		bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) override;
+		bool alias_texture(texture &texture, const texture &owner) override;
 		bool update_texture_reference(texture &texture, texture_reference id);
 
-		void render_technique(const technique &technique) override;
+		bool compile_technique(const std::vector<base_object *> &passes) const override;
+		bool create_technique_shaders(technique &technique) override;
+		void render_technique(technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
 		com_ptr<IDirect3D9> _d3d;
@@ -61,7 +72,9 @@ namespace reshade::d3d9
 		com_ptr<IDirect3DSurface9> _backbuffer_resolved;
 		com_ptr<IDirect3DTexture9> _backbuffer_texture;
 		com_ptr<IDirect3DSurface9> _backbuffer_texture_surface;
+		back_buffer_planner _back_buffer_planner { 1, false };
 		com_ptr<IDirect3DTexture9> _depthstencil_texture;
+		HMODULE _d3d_compiler = nullptr;
 
 	private:
 		struct depth_source_info
@@ -87,6 +100,7 @@ namespace reshade::d3d9
 		bool _is_multisampling_enabled = false;
 		D3DFORMAT _backbuffer_format = D3DFMT_UNKNOWN;
 		com_ptr<IDirect3DStateBlock9> _app_state;
+		render_state_cache _state_cache;
 		com_ptr<IDirect3DSurface9> _depthstencil;
 		com_ptr<IDirect3DSurface9> _depthstencil_replacement;
 		com_ptr<IDirect3DSurface9> _default_depthstencil;
@@ -94,6 +108,7 @@ namespace reshade::d3d9
 
 		com_ptr<IDirect3DVertexBuffer9> _effect_triangle_buffer;
 		com_ptr<IDirect3DVertexDeclaration9> _effect_triangle_layout;
+		std::vector<float> _uniform_block_data;
 
 		com_ptr<IDirect3DStateBlock9> _imgui_state;
 		com_ptr<IDirect3DVertexBuffer9> _imgui_vertex_buffer;
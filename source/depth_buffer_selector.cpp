@@ -0,0 +1,486 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "depth_buffer_selector.hpp"
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+
+namespace reshade
+{
+	static const char trace_magic[4] = { 'R', 'S', 'D', 'T' };
+	static const uint32_t trace_version = 1;
+
+	static void write_uint(std::ostream &stream, uint64_t value, unsigned int size)
+	{
+		char bytes[8];
+
+		for (unsigned int i = 0; i < size; i++)
+		{
+			bytes[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+		}
+
+		stream.write(bytes, size);
+	}
+	static bool read_uint(std::istream &stream, uint64_t &value, unsigned int size)
+	{
+		unsigned char bytes[8];
+
+		if (!stream.read(reinterpret_cast<char *>(bytes), size))
+		{
+			return false;
+		}
+
+		value = 0;
+
+		for (unsigned int i = 0; i < size; i++)
+		{
+			value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+		}
+
+		return true;
+	}
+	static bool read_uint32(std::istream &stream, uint32_t &value)
+	{
+		uint64_t value64;
+
+		if (!read_uint(stream, value64, 4))
+		{
+			return false;
+		}
+
+		value = static_cast<uint32_t>(value64);
+
+		return true;
+	}
+
+	static inline size_t hash_handle(uint64_t handle)
+	{
+		// Handles are often addresses, whose lowest bits carry little information
+		return static_cast<size_t>(((handle ^ (handle >> 29)) * 0x9E3779B97F4A7C15ull) >> 32);
+	}
+
+	void depth_buffer_trace::clear()
+	{
+		_frames.clear();
+		_depth_buffers.clear();
+	}
+	void depth_buffer_trace::begin_frame(uint32_t width, uint32_t height)
+	{
+		frame &frame = _frames.emplace_back();
+		frame.width = width;
+		frame.height = height;
+		frame.first_depth_buffer = static_cast<uint32_t>(_depth_buffers.size());
+	}
+	void depth_buffer_trace::add_depth_buffer(const depth_buffer_stats &stats)
+	{
+		_depth_buffers.push_back(stats);
+		_frames.back().num_depth_buffers++;
+	}
+	void depth_buffer_trace::end_frame(uint32_t total_drawcalls)
+	{
+		_frames.back().total_drawcalls = total_drawcalls;
+
+		if (_stream != nullptr)
+		{
+			write_frame(*_stream, _frames.back());
+
+			// The containers keep their capacity, so streaming does not allocate after the first frames
+			clear();
+		}
+	}
+
+	bool depth_buffer_trace::save(std::ostream &stream) const
+	{
+		stream.write(trace_magic, sizeof(trace_magic));
+		write_uint(stream, trace_version, 4);
+
+		for (const frame &frame : _frames)
+		{
+			write_frame(stream, frame);
+		}
+
+		return stream.good();
+	}
+	bool depth_buffer_trace::stream_to(std::ostream *stream)
+	{
+		_stream = stream;
+
+		if (stream == nullptr)
+		{
+			return true;
+		}
+
+		const bool result = save(*stream);
+
+		clear();
+
+		return result;
+	}
+	void depth_buffer_trace::write_frame(std::ostream &stream, const frame &frame) const
+	{
+		write_uint(stream, frame.width, 4);
+		write_uint(stream, frame.height, 4);
+		write_uint(stream, frame.total_drawcalls, 4);
+		write_uint(stream, frame.num_depth_buffers, 4);
+
+		for (uint32_t i = 0; i < frame.num_depth_buffers; i++)
+		{
+			const depth_buffer_stats &stats = _depth_buffers[frame.first_depth_buffer + i];
+
+			write_uint(stream, stats.handle, 8);
+			write_uint(stream, stats.width, 4);
+			write_uint(stream, stats.height, 4);
+			write_uint(stream, stats.format, 4);
+			write_uint(stream, stats.drawcalls, 4);
+			write_uint(stream, stats.vertices, 4);
+		}
+	}
+	bool depth_buffer_trace::load(std::istream &stream)
+	{
+		_stream = nullptr;
+
+		clear();
+
+		char magic[sizeof(trace_magic)];
+		uint32_t version;
+
+		if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), trace_magic) ||
+			!read_uint32(stream, version) || version != trace_version)
+		{
+			return false;
+		}
+
+		for (frame frame; read_uint32(stream, frame.width);)
+		{
+			uint32_t num_depth_buffers;
+
+			if (!read_uint32(stream, frame.height) || !read_uint32(stream, frame.total_drawcalls) || !read_uint32(stream, num_depth_buffers))
+			{
+				clear();
+				return false;
+			}
+
+			begin_frame(frame.width, frame.height);
+
+			for (uint32_t i = 0; i < num_depth_buffers; i++)
+			{
+				depth_buffer_stats stats;
+
+				if (!read_uint(stream, stats.handle, 8) ||
+					!read_uint32(stream, stats.width) || !read_uint32(stream, stats.height) || !read_uint32(stream, stats.format) ||
+					!read_uint32(stream, stats.drawcalls) || !read_uint32(stream, stats.vertices))
+				{
+					clear();
+					return false;
+				}
+
+				add_depth_buffer(stats);
+			}
+
+			end_frame(frame.total_drawcalls);
+		}
+
+		return stream.eof();
+	}
+
+	depth_buffer_selector::depth_buffer_selector(const depth_buffer_selector_settings &settings) :
+		_settings(settings)
+	{
+	}
+
+	void depth_buffer_selector::reset()
+	{
+		_candidates.clear();
+		_frame_candidates.clear();
+		std::fill(_table.begin(), _table.end(), no_candidate);
+		_selected = no_candidate;
+	}
+	void depth_buffer_selector::remove_depth_buffer(uint64_t handle)
+	{
+		if (const uint32_t index = find(handle); index != no_candidate)
+		{
+			erase(index);
+			rebuild_table();
+		}
+	}
+
+	void depth_buffer_selector::begin_frame(uint32_t width, uint32_t height)
+	{
+		_frame_index++;
+		_frame_width = width;
+		_frame_height = height;
+		_frame_candidates.clear();
+
+		if (_trace != nullptr)
+		{
+			_trace->begin_frame(width, height);
+		}
+	}
+	void depth_buffer_selector::add_depth_buffer(const depth_buffer_stats &stats)
+	{
+		if (_trace != nullptr)
+		{
+			_trace->add_depth_buffer(stats);
+		}
+
+		uint32_t index = find(stats.handle);
+
+		if (index == no_candidate)
+		{
+			index = insert(stats.handle);
+		}
+
+		candidate &candidate = _candidates[index];
+
+		if (candidate.last_frame != _frame_index)
+		{
+			const float score = current_score(candidate);
+
+			candidate.stats = stats;
+			// Remember the score from before this frame, so that it can be updated once all statistics are known
+			candidate.score = score;
+			candidate.last_frame = _frame_index;
+
+			_frame_candidates.push_back(index);
+		}
+		else
+		{
+			candidate.stats.drawcalls += stats.drawcalls;
+			candidate.stats.vertices += stats.vertices;
+		}
+	}
+	bool depth_buffer_selector::end_frame(uint32_t total_drawcalls)
+	{
+		if (_trace != nullptr)
+		{
+			_trace->end_frame(total_drawcalls);
+		}
+
+		const float frame_aspect_ratio = _frame_height != 0 ? float(_frame_width) / float(_frame_height) : 0.0f;
+
+		uint32_t best = no_candidate;
+
+		for (const uint32_t index : _frame_candidates)
+		{
+			candidate &candidate = _candidates[index];
+			const depth_buffer_stats &stats = candidate.stats;
+
+			candidate.matches_frame = true;
+
+			// Depth buffers with unknown dimensions are not filtered
+			if (stats.width != 0 && stats.height != 0 && _frame_width != 0 && _frame_height != 0)
+			{
+				const float width_factor = float(_frame_width) / float(stats.width);
+				const float height_factor = float(_frame_height) / float(stats.height);
+				const float aspect_ratio = float(stats.width) / float(stats.height);
+
+				candidate.matches_frame =
+					std::abs(aspect_ratio - frame_aspect_ratio) <= _settings.max_aspect_ratio_difference &&
+					width_factor >= _settings.min_scale && width_factor <= _settings.max_scale &&
+					height_factor >= _settings.min_scale && height_factor <= _settings.max_scale;
+			}
+
+			// Prefer depth buffers with many vertices spread across few draw calls
+			float frame_score = 0.0f;
+
+			if (candidate.matches_frame && stats.drawcalls != 0)
+			{
+				const float drawcall_share = total_drawcalls != 0 ? std::min(float(stats.drawcalls) / float(total_drawcalls), 1.0f) : 1.0f;
+
+				frame_score = float(stats.vertices) * (1.2f - drawcall_share);
+			}
+
+			// Depth buffers seen for the first time start out with their current score instead of ramping up
+			candidate.score = candidate.score_frame == 0 ? frame_score : candidate.score + (frame_score - candidate.score) * _settings.smoothing;
+			candidate.score_frame = _frame_index;
+
+			if (candidate.matches_frame && candidate.score > 0.0f && (best == no_candidate || candidate.score > _candidates[best].score))
+			{
+				best = index;
+			}
+		}
+
+		bool changed = false;
+
+		if (best != no_candidate && best != _selected)
+		{
+			candidate &challenger = _candidates[best];
+
+			if (_selected == no_candidate)
+			{
+				_selected = best;
+				changed = true;
+			}
+			else if (challenger.score > current_score(_candidates[_selected]) * _settings.switch_threshold)
+			{
+				// Only switch once the other depth buffer was ahead for several consecutive frames
+				challenger.frames_ahead = challenger.ahead_frame + 1 == _frame_index ? challenger.frames_ahead + 1 : 1;
+				challenger.ahead_frame = _frame_index;
+
+				if (challenger.frames_ahead >= _settings.switch_frames)
+				{
+					challenger.frames_ahead = 0;
+
+					_selected = best;
+					changed = true;
+				}
+			}
+		}
+
+		if (_settings.expire_frames != 0 && _frame_index % _settings.expire_frames == 0)
+		{
+			expire();
+		}
+
+		return changed;
+	}
+
+	void depth_buffer_selector::replay(const depth_buffer_trace &trace, std::vector<uint64_t> *selections)
+	{
+		for (const depth_buffer_trace::frame &frame : trace.frames())
+		{
+			begin_frame(frame.width, frame.height);
+
+			const depth_buffer_stats *const depth_buffers = trace.depth_buffers(frame);
+
+			for (uint32_t i = 0; i < frame.num_depth_buffers; i++)
+			{
+				add_depth_buffer(depth_buffers[i]);
+			}
+
+			end_frame(frame.total_drawcalls);
+
+			if (selections != nullptr)
+			{
+				selections->push_back(selected());
+			}
+		}
+	}
+
+	uint32_t depth_buffer_selector::find(uint64_t handle) const
+	{
+		if (_table.empty())
+		{
+			return no_candidate;
+		}
+
+		const size_t mask = _table.size() - 1;
+
+		for (size_t slot = hash_handle(handle) & mask;; slot = (slot + 1) & mask)
+		{
+			const uint32_t index = _table[slot];
+
+			if (index == no_candidate || _candidates[index].stats.handle == handle)
+			{
+				return index;
+			}
+		}
+	}
+	uint32_t depth_buffer_selector::insert(uint64_t handle)
+	{
+		const uint32_t index = static_cast<uint32_t>(_candidates.size());
+
+		_candidates.emplace_back().stats.handle = handle;
+
+		// Keep the table at most half full, so that probe sequences stay short
+		if (_table.size() < 2 * _candidates.size())
+		{
+			rebuild_table();
+		}
+		else
+		{
+			const size_t mask = _table.size() - 1;
+
+			size_t slot = hash_handle(handle) & mask;
+
+			while (_table[slot] != no_candidate)
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			_table[slot] = index;
+		}
+
+		return index;
+	}
+	void depth_buffer_selector::erase(uint32_t index)
+	{
+		const uint32_t last = static_cast<uint32_t>(_candidates.size() - 1);
+
+		if (_selected == index)
+		{
+			_selected = no_candidate;
+		}
+
+		// Move the last candidate into the free spot and update all references to it
+		_frame_candidates.erase(std::remove(_frame_candidates.begin(), _frame_candidates.end(), index), _frame_candidates.end());
+		std::replace(_frame_candidates.begin(), _frame_candidates.end(), last, index);
+
+		if (index != last)
+		{
+			_candidates[index] = _candidates[last];
+
+			if (_selected == last)
+			{
+				_selected = index;
+			}
+		}
+
+		_candidates.pop_back();
+	}
+	void depth_buffer_selector::rebuild_table()
+	{
+		size_t size = std::max(_table.size(), size_t(16));
+
+		while (size < 2 * _candidates.size())
+		{
+			size *= 2;
+		}
+
+		_table.assign(size, no_candidate);
+
+		const size_t mask = size - 1;
+
+		for (uint32_t index = 0; index < _candidates.size(); index++)
+		{
+			size_t slot = hash_handle(_candidates[index].stats.handle) & mask;
+
+			while (_table[slot] != no_candidate)
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			_table[slot] = index;
+		}
+	}
+	void depth_buffer_selector::expire()
+	{
+		bool erased = false;
+
+		for (uint32_t index = static_cast<uint32_t>(_candidates.size()); index-- > 0;)
+		{
+			// The selected depth buffer is kept until another one replaces it
+			if (index != _selected && _candidates[index].last_frame + _settings.expire_frames < _frame_index)
+			{
+				erase(index);
+				erased = true;
+			}
+		}
+
+		if (erased)
+		{
+			rebuild_table();
+		}
+	}
+	float depth_buffer_selector::current_score(const candidate &candidate) const
+	{
+		// Frames without statistics count as frames with a score of zero
+		const uint64_t missed_frames = _frame_index - candidate.score_frame - (candidate.score_frame == _frame_index ? 0 : 1);
+
+		return candidate.score * std::pow(1.0f - _settings.smoothing, static_cast<float>(std::min(missed_frames, uint64_t(64))));
+	}
+}
@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// Statistics of a single depth buffer the application rendered to during a frame.
+	/// </summary>
+	struct depth_buffer_stats
+	{
+		/// <summary>
+		/// Opaque handle identifying the depth buffer, e.g. the address of its view or its object name.
+		/// </summary>
+		uint64_t handle = 0;
+		/// <summary>
+		/// Dimensions of the depth buffer, or zero if they are not known.
+		/// </summary>
+		uint32_t width = 0, height = 0;
+		/// <summary>
+		/// Backend specific format of the depth buffer. It is only recorded and not interpreted.
+		/// </summary>
+		uint32_t format = 0;
+		/// <summary>
+		/// Number of draw calls, or the index of the last draw call in the frame, depending on what the backend tracks.
+		/// </summary>
+		uint32_t drawcalls = 0;
+		/// <summary>
+		/// Number of vertices drawn.
+		/// </summary>
+		uint32_t vertices = 0;
+	};
+
+	/// <summary>
+	/// Settings which control which depth buffers are considered and how quickly the selection changes.
+	/// </summary>
+	struct depth_buffer_selector_settings
+	{
+		/// <summary>
+		/// Maximum difference between the aspect ratio of a depth buffer and the one of the frame.
+		/// </summary>
+		float max_aspect_ratio_difference = 1e+9f;
+		/// <summary>
+		/// Allowed range of the ratio between the frame dimensions and the depth buffer dimensions.
+		/// </summary>
+		float min_scale = 0.0f, max_scale = 1e+9f;
+		/// <summary>
+		/// Weight of the newest statistics in the smoothed score of a depth buffer, between zero (never changes) and one (no smoothing).
+		/// </summary>
+		float smoothing = 0.5f;
+		/// <summary>
+		/// Factor by which the score of another depth buffer has to exceed the one of the selected depth buffer before it is considered better.
+		/// </summary>
+		float switch_threshold = 1.1f;
+		/// <summary>
+		/// Number of consecutive frames another depth buffer has to be better before the selection changes.
+		/// </summary>
+		unsigned int switch_frames = 2;
+		/// <summary>
+		/// Number of frames after which a depth buffer that no longer received statistics is forgotten.
+		/// </summary>
+		unsigned int expire_frames = 60;
+	};
+
+	/// <summary>
+	/// A recording of the statistics passed to a <see cref="depth_buffer_selector"/>, which can be saved and replayed on any platform.
+	/// The binary format is a "RSDT" magic and a version number, followed by one record per frame. Each record holds the frame dimensions, the total number of draw calls and the number of depth buffers, followed by their statistics. All values are stored as little-endian integers.
+	/// </summary>
+	class depth_buffer_trace
+	{
+	public:
+		struct frame
+		{
+			uint32_t width = 0, height = 0;
+			uint32_t total_drawcalls = 0;
+			uint32_t first_depth_buffer = 0, num_depth_buffers = 0;
+		};
+
+		/// <summary>
+		/// Returns the recorded frames.
+		/// </summary>
+		const std::vector<frame> &frames() const { return _frames; }
+		/// <summary>
+		/// Returns the statistics of the depth buffers of a recorded frame.
+		/// </summary>
+		const depth_buffer_stats *depth_buffers(const frame &frame) const { return _depth_buffers.data() + frame.first_depth_buffer; }
+
+		/// <summary>
+		/// Remove all recorded frames.
+		/// </summary>
+		void clear();
+		/// <summary>
+		/// Start recording a new frame.
+		/// </summary>
+		void begin_frame(uint32_t width, uint32_t height);
+		/// <summary>
+		/// Record the statistics of a depth buffer in the current frame.
+		/// </summary>
+		void add_depth_buffer(const depth_buffer_stats &stats);
+		/// <summary>
+		/// Finish recording the current frame.
+		/// </summary>
+		void end_frame(uint32_t total_drawcalls);
+
+		/// <summary>
+		/// Write all recorded frames to a binary stream.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if writing failed.</returns>
+		bool save(std::ostream &stream) const;
+		/// <summary>
+		/// Write every frame to a binary stream as soon as it is finished instead of keeping it in memory, so that long recordings do not grow without bound. The header is written right away, followed by all frames recorded so far.
+		/// Pass <c>nullptr</c> to keep frames in memory again. The stream has to stay valid until then.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if writing failed.</returns>
+		bool stream_to(std::ostream *stream);
+		/// <summary>
+		/// Replace the recorded frames with the ones read from a binary stream.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if the stream does not contain a valid trace.</returns>
+		bool load(std::istream &stream);
+
+	private:
+		void write_frame(std::ostream &stream, const frame &frame) const;
+
+		std::vector<frame> _frames;
+		std::vector<depth_buffer_stats> _depth_buffers;
+		std::ostream *_stream = nullptr;
+	};
+
+	/// <summary>
+	/// Backend independent selection of the depth buffer which most likely contains the scene depth. It keeps a smoothed score for every depth buffer and only changes the selection once another one was better for several frames, so that it does not flicker between depth buffers.
+	/// Only the depth buffers passed in during a frame are updated, so the cost does not depend on how many were seen before.
+	/// </summary>
+	class depth_buffer_selector
+	{
+	public:
+		explicit depth_buffer_selector(const depth_buffer_selector_settings &settings = depth_buffer_selector_settings());
+
+		/// <summary>
+		/// Returns the active settings.
+		/// </summary>
+		depth_buffer_selector_settings &settings() { return _settings; }
+
+		/// <summary>
+		/// Forget all depth buffers and the current selection.
+		/// </summary>
+		void reset();
+		/// <summary>
+		/// Forget a depth buffer, e.g. because it was destroyed. Deselects it if it was selected.
+		/// </summary>
+		void remove_depth_buffer(uint64_t handle);
+
+		/// <summary>
+		/// Start a new frame.
+		/// </summary>
+		/// <param name="width">The width of the back buffer.</param>
+		/// <param name="height">The height of the back buffer.</param>
+		void begin_frame(uint32_t width, uint32_t height);
+		/// <summary>
+		/// Pass in the statistics of a depth buffer for the current frame. Statistics passed in several times for the same depth buffer are added up.
+		/// </summary>
+		void add_depth_buffer(const depth_buffer_stats &stats);
+		/// <summary>
+		/// Finish the current frame and update the selection.
+		/// </summary>
+		/// <param name="total_drawcalls">The total number of draw calls in the frame.</param>
+		/// <returns><c>true</c> if the selection changed, <c>false</c> otherwise.</returns>
+		bool end_frame(uint32_t total_drawcalls);
+
+		/// <summary>
+		/// Returns whether a depth buffer is selected.
+		/// </summary>
+		bool has_selection() const { return _selected != no_candidate; }
+		/// <summary>
+		/// Returns the handle of the selected depth buffer. Only valid if <see cref="has_selection"/> is <c>true</c>.
+		/// </summary>
+		uint64_t selected() const { return has_selection() ? _candidates[_selected].stats.handle : 0; }
+		/// <summary>
+		/// Returns the last statistics passed in for the selected depth buffer.
+		/// </summary>
+		const depth_buffer_stats &selected_stats() const { return _candidates[_selected].stats; }
+
+		/// <summary>
+		/// Record all statistics passed in from now on to the specified trace, or stop recording if it is <c>nullptr</c>.
+		/// </summary>
+		void record(depth_buffer_trace *trace) { _trace = trace; }
+		/// <summary>
+		/// Feed all frames of a trace to this selector.
+		/// </summary>
+		/// <param name="trace">The trace to replay.</param>
+		/// <param name="selections">A list which receives the selected handle after each frame, or zero for frames without a selection.</param>
+		void replay(const depth_buffer_trace &trace, std::vector<uint64_t> *selections = nullptr);
+
+	private:
+		static constexpr uint32_t no_candidate = ~0u;
+
+		struct candidate
+		{
+			depth_buffer_stats stats;
+			float score = 0.0f;
+			// Frame in which the score was last updated
+			uint64_t score_frame = 0;
+			// Frame in which statistics were last passed in
+			uint64_t last_frame = 0;
+			// Number of consecutive frames this candidate was better than the selected one, up to frame 'ahead_frame'
+			unsigned int frames_ahead = 0;
+			uint64_t ahead_frame = 0;
+			bool matches_frame = false;
+		};
+
+		uint32_t find(uint64_t handle) const;
+		uint32_t insert(uint64_t handle);
+		void erase(uint32_t index);
+		void rebuild_table();
+		void expire();
+		float current_score(const candidate &candidate) const;
+
+		depth_buffer_selector_settings _settings;
+		std::vector<candidate> _candidates;
+		// Open addressing hash table with linear probing which maps a handle to its index in '_candidates'
+		std::vector<uint32_t> _table;
+		// Candidates that received statistics during the current frame
+		std::vector<uint32_t> _frame_candidates;
+		uint32_t _selected = no_candidate;
+		uint64_t _frame_index = 0;
+		uint32_t _frame_width = 0, _frame_height = 0;
+		depth_buffer_trace *_trace = nullptr;
+	};
+}
@@ -6,6 +6,7 @@
 #include "log.hpp"
 #include "filesystem.hpp"
 #include "input.hpp"
+#include "ini_file.hpp"
 #include "runtime.hpp"
 #include "hook_manager.hpp"
 #include "version.h"
@@ -198,6 +199,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 	FreeLibrary(opengl_module);
 #endif
 
+	log::close();
+
 	return static_cast<int>(msg.wParam);
 }
 
@@ -243,7 +246,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 			input::uninstall();
 			hooks::uninstall();
 
+			// Write configuration and preset files that were changed since the last frame
+			ini_file::flush_cache();
+
 			LOG(INFO) << "Exited.";
+
+			log::close();
 			break;
 		}
 	}
@@ -23,7 +23,7 @@ void DXGISwapChain::perform_present(UINT PresentFlags)
 			break;
 		case 11:
 			assert(_runtime != nullptr);
-			std::static_pointer_cast<reshade::d3d11::d3d11_runtime>(_runtime)->on_present(static_cast<D3D11Device *>(_direct3d_device)->_immediate_context->_draw_call_tracker);
+			std::static_pointer_cast<reshade::d3d11::d3d11_runtime>(_runtime)->on_present(static_cast<D3D11Device *>(_direct3d_device)->_immediate_context->_draw_call_tracker, static_cast<D3D11Device *>(_direct3d_device)->_immediate_context->_state_tracker);
 			clear_drawcall_stats();
 			break;
 		}
@@ -0,0 +1,699 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_pass_fusion.hpp"
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace reshadefx
+{
+	using namespace nodes;
+
+	using visit_callback = std::function<void(node *)>;
+
+	static void visit(statement_node *node, const visit_callback &callback);
+	static void visit(expression_node *node, const visit_callback &callback)
+	{
+		if (node == nullptr)
+		{
+			return;
+		}
+
+		callback(node);
+
+		switch (node->id)
+		{
+			case nodeid::unary_expression:
+				visit(static_cast<unary_expression_node *>(node)->operand, callback);
+				break;
+			case nodeid::binary_expression:
+				visit(static_cast<binary_expression_node *>(node)->operands[0], callback);
+				visit(static_cast<binary_expression_node *>(node)->operands[1], callback);
+				break;
+			case nodeid::intrinsic_expression:
+				for (auto argument : static_cast<intrinsic_expression_node *>(node)->arguments)
+				{
+					visit(argument, callback);
+				}
+				break;
+			case nodeid::conditional_expression:
+			{
+				const auto conditional_node = static_cast<conditional_expression_node *>(node);
+				visit(conditional_node->condition, callback);
+				visit(conditional_node->expression_when_true, callback);
+				visit(conditional_node->expression_when_false, callback);
+				break;
+			}
+			case nodeid::assignment_expression:
+				visit(static_cast<assignment_expression_node *>(node)->left, callback);
+				visit(static_cast<assignment_expression_node *>(node)->right, callback);
+				break;
+			case nodeid::expression_sequence:
+				for (auto expression : static_cast<expression_sequence_node *>(node)->expression_list)
+				{
+					visit(expression, callback);
+				}
+				break;
+			case nodeid::call_expression:
+				for (auto argument : static_cast<call_expression_node *>(node)->arguments)
+				{
+					visit(argument, callback);
+				}
+				break;
+			case nodeid::constructor_expression:
+				for (auto argument : static_cast<constructor_expression_node *>(node)->arguments)
+				{
+					visit(argument, callback);
+				}
+				break;
+			case nodeid::swizzle_expression:
+				visit(static_cast<swizzle_expression_node *>(node)->operand, callback);
+				break;
+			case nodeid::field_expression:
+				visit(static_cast<field_expression_node *>(node)->operand, callback);
+				break;
+			case nodeid::initializer_list:
+				for (auto value : static_cast<initializer_list_node *>(node)->values)
+				{
+					visit(value, callback);
+				}
+				break;
+		}
+	}
+	static void visit(statement_node *node, const visit_callback &callback)
+	{
+		if (node == nullptr)
+		{
+			return;
+		}
+
+		callback(node);
+
+		switch (node->id)
+		{
+			case nodeid::compound_statement:
+				for (auto statement : static_cast<compound_statement_node *>(node)->statement_list)
+				{
+					visit(statement, callback);
+				}
+				break;
+			case nodeid::declarator_list:
+				for (auto declarator : static_cast<declarator_list_node *>(node)->declarator_list)
+				{
+					visit(declarator->initializer_expression, callback);
+				}
+				break;
+			case nodeid::expression_statement:
+				visit(static_cast<expression_statement_node *>(node)->expression, callback);
+				break;
+			case nodeid::if_statement:
+			{
+				const auto if_node = static_cast<if_statement_node *>(node);
+				visit(if_node->condition, callback);
+				visit(if_node->statement_when_true, callback);
+				visit(if_node->statement_when_false, callback);
+				break;
+			}
+			case nodeid::switch_statement:
+			{
+				const auto switch_node = static_cast<switch_statement_node *>(node);
+				visit(switch_node->test_expression, callback);
+
+				for (auto case_node : switch_node->case_list)
+				{
+					visit(case_node, callback);
+				}
+				break;
+			}
+			case nodeid::case_statement:
+				visit(static_cast<case_statement_node *>(node)->statement_list, callback);
+				break;
+			case nodeid::for_statement:
+			{
+				const auto for_node = static_cast<for_statement_node *>(node);
+				visit(for_node->init_statement, callback);
+				visit(for_node->condition, callback);
+				visit(for_node->increment_expression, callback);
+				visit(for_node->statement_list, callback);
+				break;
+			}
+			case nodeid::while_statement:
+			{
+				const auto while_node = static_cast<while_statement_node *>(node);
+				visit(while_node->condition, callback);
+				visit(while_node->statement_list, callback);
+				break;
+			}
+			case nodeid::return_statement:
+				visit(static_cast<return_statement_node *>(node)->return_value, callback);
+				break;
+		}
+	}
+
+	static function_declaration_node *find_function(const syntax_tree &ast, const function_declaration_node *function)
+	{
+		const auto it = std::find(ast.functions.begin(), ast.functions.end(), function);
+
+		return it != ast.functions.end() ? *it : nullptr;
+	}
+	static std::vector<function_declaration_node *> find_reachable_functions(const syntax_tree &ast, function_declaration_node *function)
+	{
+		std::vector<function_declaration_node *> reached;
+		std::vector<function_declaration_node *> queue = { function };
+		std::unordered_set<const function_declaration_node *> visited;
+
+		while (!queue.empty())
+		{
+			const auto current = queue.back();
+			queue.pop_back();
+
+			if (current == nullptr || !visited.insert(current).second)
+			{
+				continue;
+			}
+
+			reached.push_back(current);
+
+			visit(current->definition, [&ast, &queue](node *node) {
+				if (node->id == nodeid::call_expression)
+				{
+					queue.push_back(find_function(ast, static_cast<call_expression_node *>(node)->callee));
+				}
+			});
+		}
+
+		return reached;
+	}
+
+	static bool is_back_buffer_sampler(const variable_declaration_node *variable)
+	{
+		return variable != nullptr && variable->type.is_sampler() && variable->properties.texture != nullptr &&
+			(variable->properties.texture->semantic == "COLOR" || variable->properties.texture->semantic == "SV_TARGET");
+	}
+	static bool is_same_type(const type_node &lhs, const type_node &rhs)
+	{
+		return lhs.basetype == rhs.basetype && lhs.rows == rhs.rows && lhs.cols == rhs.cols && lhs.array_length == rhs.array_length && lhs.definition == rhs.definition;
+	}
+	static bool renders_to_back_buffer_only(const pass_declaration_node *pass)
+	{
+		// Every pixel has to be replaced by the color the pixel shader returns, so that it does not matter what was there before
+		return !pass->blend_enable && !pass->stencil_enable && pass->color_write_mask == 0xF &&
+			pass->vertex_shader != nullptr && pass->pixel_shader != nullptr &&
+			std::all_of(std::begin(pass->render_targets), std::end(pass->render_targets), [](const variable_declaration_node *target) { return target == nullptr; });
+	}
+	static bool is_color_entry_point(const function_declaration_node *function)
+	{
+		const auto &type = function->return_type;
+
+		if (!type.is_floating_point() || type.rows != 4 || type.cols != 1 || type.is_array() ||
+			(function->return_semantic != "SV_TARGET" && function->return_semantic != "SV_TARGET0" && function->return_semantic != "COLOR" && function->return_semantic != "COLOR0"))
+		{
+			return false;
+		}
+
+		return std::all_of(function->parameter_list.begin(), function->parameter_list.end(), [](const variable_declaration_node *parameter) {
+			return !parameter->type.has_qualifier(type_node::qualifier_out) && !parameter->type.is_struct() && !parameter->semantic.empty();
+		});
+	}
+	static bool may_discard(const syntax_tree &ast, function_declaration_node *function)
+	{
+		bool discards = false;
+
+		for (auto reached : find_reachable_functions(ast, function))
+		{
+			visit(reached->definition, [&discards](node *node) {
+				discards |= node->id == nodeid::return_statement && static_cast<return_statement_node *>(node)->is_discard;
+			});
+		}
+
+		return discards;
+	}
+	static size_t count_references(const syntax_tree &ast, const function_declaration_node *function)
+	{
+		size_t references = 0;
+
+		for (auto technique : ast.techniques)
+		{
+			for (auto pass : technique->pass_list)
+			{
+				references += (pass->vertex_shader == function ? 1 : 0) + (pass->pixel_shader == function ? 1 : 0);
+			}
+		}
+
+		for (auto caller : ast.functions)
+		{
+			visit(caller->definition, [function, &references](node *node) {
+				references += node->id == nodeid::call_expression && static_cast<call_expression_node *>(node)->callee == function ? 1 : 0;
+			});
+		}
+
+		return references;
+	}
+
+	static const variable_declaration_node *find_root_variable(const expression_node *node)
+	{
+		while (node != nullptr)
+		{
+			switch (node->id)
+			{
+				case nodeid::lvalue_expression:
+					return static_cast<const lvalue_expression_node *>(node)->reference;
+				case nodeid::swizzle_expression:
+					node = static_cast<const swizzle_expression_node *>(node)->operand;
+					break;
+				case nodeid::field_expression:
+					node = static_cast<const field_expression_node *>(node)->operand;
+					break;
+				case nodeid::binary_expression:
+					if (static_cast<const binary_expression_node *>(node)->op != binary_expression_node::element_extract)
+					{
+						return nullptr;
+					}
+					node = static_cast<const binary_expression_node *>(node)->operands[0];
+					break;
+				default:
+					return nullptr;
+			}
+		}
+
+		return nullptr;
+	}
+	static bool is_modified(function_declaration_node *function, const variable_declaration_node *variable)
+	{
+		bool modified = false;
+
+		visit(function->definition, [variable, &modified](node *node) {
+			switch (node->id)
+			{
+				case nodeid::assignment_expression:
+					modified |= find_root_variable(static_cast<assignment_expression_node *>(node)->left) == variable;
+					break;
+				case nodeid::unary_expression:
+				{
+					const auto unary_node = static_cast<unary_expression_node *>(node);
+					modified |= unary_node->op >= unary_expression_node::pre_increase && unary_node->op <= unary_expression_node::post_decrease && find_root_variable(unary_node->operand) == variable;
+					break;
+				}
+				case nodeid::intrinsic_expression:
+				{
+					const auto intrinsic_node = static_cast<intrinsic_expression_node *>(node);
+
+					// These are the only intrinsics with output arguments, which always follow the first one
+					if (intrinsic_node->op == intrinsic_expression_node::sincos || intrinsic_node->op == intrinsic_expression_node::modf || intrinsic_node->op == intrinsic_expression_node::frexp)
+					{
+						modified |= std::any_of(intrinsic_node->arguments + 1, intrinsic_node->arguments + 4, [variable](const expression_node *argument) { return find_root_variable(argument) == variable; });
+					}
+					break;
+				}
+				case nodeid::call_expression:
+				{
+					const auto call_node = static_cast<call_expression_node *>(node);
+
+					for (size_t i = 0; i < call_node->arguments.size() && i < call_node->callee->parameter_list.size(); i++)
+					{
+						modified |= call_node->callee->parameter_list[i]->type.has_qualifier(type_node::qualifier_out) && find_root_variable(call_node->arguments[i]) == variable;
+					}
+					break;
+				}
+			}
+		});
+
+		return modified;
+	}
+	static bool is_same_semantic(const std::string &lhs, const std::string &rhs)
+	{
+		// A semantic without an index refers to the first one
+		return lhs == rhs || lhs + '0' == rhs || lhs == rhs + '0';
+	}
+	static bool outputs_screen_texcoord(const function_declaration_node *vertex_shader, const std::string &semantic)
+	{
+		// Only the full screen triangle of 'PostProcessVS' from ReShade.fxh is known to pass texture coordinates that point to the center of the current pixel, any other vertex shader may transform them
+		if (vertex_shader == nullptr || vertex_shader->name != "PostProcessVS" || vertex_shader->parameter_list.size() != 3)
+		{
+			return false;
+		}
+
+		const auto vertex_id = vertex_shader->parameter_list[0];
+		const auto position = vertex_shader->parameter_list[1];
+		const auto texcoord = vertex_shader->parameter_list[2];
+
+		return
+			vertex_id->semantic == "SV_VERTEXID" && !vertex_id->type.has_qualifier(type_node::qualifier_out) &&
+			position->semantic == "SV_POSITION" && position->type.has_qualifier(type_node::qualifier_out) &&
+			is_same_semantic(texcoord->semantic, semantic) && texcoord->type.has_qualifier(type_node::qualifier_out) &&
+			texcoord->type.is_floating_point() && texcoord->type.rows == 2 && texcoord->type.cols == 1 && !texcoord->type.is_array();
+	}
+	static bool samples_current_pixel(const function_declaration_node *vertex_shader, function_declaration_node *function, const intrinsic_expression_node *sample)
+	{
+		const expression_node *coordinate = sample->arguments[1];
+
+		if (coordinate == nullptr)
+		{
+			return false;
+		}
+
+		// The back buffer only has a single level, but only accept an explicit zero anyway to be safe
+		if (sample->op == intrinsic_expression_node::texture_level)
+		{
+			if (coordinate->id != nodeid::constructor_expression)
+			{
+				return false;
+			}
+
+			const auto &arguments = static_cast<const constructor_expression_node *>(coordinate)->arguments;
+
+			if (arguments.empty() || !std::all_of(arguments.begin() + 1, arguments.end(), [](const expression_node *argument) {
+				return argument->id == nodeid::literal_expression && argument->type.is_scalar() && static_cast<const literal_expression_node *>(argument)->value_int[0] == 0;
+			}))
+			{
+				return false;
+			}
+
+			coordinate = arguments[0];
+		}
+
+		if (coordinate->id != nodeid::lvalue_expression)
+		{
+			return false;
+		}
+
+		// Texture coordinates passed in from the full screen triangle point to the center of the current pixel, as long as the shader does not change them
+		const auto parameter = static_cast<const lvalue_expression_node *>(coordinate)->reference;
+
+		return
+			std::find(function->parameter_list.begin(), function->parameter_list.end(), parameter) != function->parameter_list.end() &&
+			parameter->semantic.compare(0, 8, "TEXCOORD") == 0 && outputs_screen_texcoord(vertex_shader, parameter->semantic) &&
+			parameter->type.is_floating_point() && parameter->type.rows == 2 && parameter->type.cols == 1 && !parameter->type.is_array() &&
+			!is_modified(function, parameter);
+	}
+	static bool find_current_pixel_samples(const syntax_tree &ast, const function_declaration_node *vertex_shader, function_declaration_node *function, bool srgb, std::vector<intrinsic_expression_node *> &samples)
+	{
+		size_t references = 0;
+
+		visit(function->definition, [vertex_shader, function, srgb, &samples, &references](node *node) {
+			if (node->id == nodeid::lvalue_expression)
+			{
+				references += is_back_buffer_sampler(static_cast<lvalue_expression_node *>(node)->reference) ? 1 : 0;
+			}
+			else if (node->id == nodeid::intrinsic_expression)
+			{
+				const auto sample = static_cast<intrinsic_expression_node *>(node);
+
+				if ((sample->op != intrinsic_expression_node::texture && sample->op != intrinsic_expression_node::texture_level) ||
+					sample->arguments[0] == nullptr || sample->arguments[0]->id != nodeid::lvalue_expression)
+				{
+					return;
+				}
+
+				const auto sampler = static_cast<const lvalue_expression_node *>(sample->arguments[0])->reference;
+
+				// Writing to an sRGB target and sampling through an sRGB view cancel each other out, but a mismatch would change the color
+				if (is_back_buffer_sampler(sampler) && sampler->properties.srgb_texture == srgb && samples_current_pixel(vertex_shader, function, sample))
+				{
+					samples.push_back(sample);
+				}
+			}
+		});
+
+		// Any other access to the back buffer would see the contents from before the first pass, so give up in that case
+		if (samples.empty() || samples.size() != references)
+		{
+			return false;
+		}
+
+		for (auto callee : find_reachable_functions(ast, function))
+		{
+			if (callee == function)
+			{
+				continue;
+			}
+
+			visit(callee->definition, [&references](node *node) {
+				references += node->id == nodeid::lvalue_expression && is_back_buffer_sampler(static_cast<lvalue_expression_node *>(node)->reference) ? 1 : 0;
+			});
+		}
+
+		return samples.size() == references;
+	}
+
+	static lvalue_expression_node *make_reference(syntax_tree &ast, const variable_declaration_node *variable)
+	{
+		const auto node = ast.make_node<lvalue_expression_node>(variable->location);
+		node->reference = variable;
+		node->type = variable->type;
+
+		return node;
+	}
+	static variable_declaration_node *make_parameter(syntax_tree &ast, const variable_declaration_node *parameter, const std::string &name)
+	{
+		const auto node = ast.make_node<variable_declaration_node>(parameter->location);
+		node->name = node->unique_name = name;
+		node->type = parameter->type;
+		node->semantic = parameter->semantic;
+		node->initializer_expression = nullptr;
+
+		return node;
+	}
+	static call_expression_node *make_call(syntax_tree &ast, const function_declaration_node *callee, const std::vector<expression_node *> &arguments)
+	{
+		const auto node = ast.make_node<call_expression_node>(callee->location);
+		node->callee_name = callee->name;
+		node->callee = callee;
+		node->type = callee->return_type;
+		node->arguments = arguments;
+
+		return node;
+	}
+
+	static void replace_operand(node *parent, const expression_node *from, expression_node *to)
+	{
+		const auto replace = [from, to](expression_node *&operand) {
+			if (operand == from)
+			{
+				operand = to;
+			}
+		};
+
+		switch (parent->id)
+		{
+			case nodeid::unary_expression:
+				replace(static_cast<unary_expression_node *>(parent)->operand);
+				break;
+			case nodeid::binary_expression:
+				replace(static_cast<binary_expression_node *>(parent)->operands[0]);
+				replace(static_cast<binary_expression_node *>(parent)->operands[1]);
+				break;
+			case nodeid::intrinsic_expression:
+				for (auto &argument : static_cast<intrinsic_expression_node *>(parent)->arguments)
+				{
+					replace(argument);
+				}
+				break;
+			case nodeid::conditional_expression:
+			{
+				const auto conditional_node = static_cast<conditional_expression_node *>(parent);
+				replace(conditional_node->condition);
+				replace(conditional_node->expression_when_true);
+				replace(conditional_node->expression_when_false);
+				break;
+			}
+			case nodeid::assignment_expression:
+				replace(static_cast<assignment_expression_node *>(parent)->left);
+				replace(static_cast<assignment_expression_node *>(parent)->right);
+				break;
+			case nodeid::expression_sequence:
+				for (auto &expression : static_cast<expression_sequence_node *>(parent)->expression_list)
+				{
+					replace(expression);
+				}
+				break;
+			case nodeid::call_expression:
+				for (auto &argument : static_cast<call_expression_node *>(parent)->arguments)
+				{
+					replace(argument);
+				}
+				break;
+			case nodeid::constructor_expression:
+				for (auto &argument : static_cast<constructor_expression_node *>(parent)->arguments)
+				{
+					replace(argument);
+				}
+				break;
+			case nodeid::swizzle_expression:
+				replace(static_cast<swizzle_expression_node *>(parent)->operand);
+				break;
+			case nodeid::field_expression:
+				replace(static_cast<field_expression_node *>(parent)->operand);
+				break;
+			case nodeid::initializer_list:
+				for (auto &value : static_cast<initializer_list_node *>(parent)->values)
+				{
+					replace(value);
+				}
+				break;
+			case nodeid::declarator_list:
+				for (auto declarator : static_cast<declarator_list_node *>(parent)->declarator_list)
+				{
+					replace(declarator->initializer_expression);
+				}
+				break;
+			case nodeid::expression_statement:
+				replace(static_cast<expression_statement_node *>(parent)->expression);
+				break;
+			case nodeid::if_statement:
+				replace(static_cast<if_statement_node *>(parent)->condition);
+				break;
+			case nodeid::switch_statement:
+				replace(static_cast<switch_statement_node *>(parent)->test_expression);
+				break;
+			case nodeid::for_statement:
+				replace(static_cast<for_statement_node *>(parent)->condition);
+				replace(static_cast<for_statement_node *>(parent)->increment_expression);
+				break;
+			case nodeid::while_statement:
+				replace(static_cast<while_statement_node *>(parent)->condition);
+				break;
+			case nodeid::return_statement:
+				replace(static_cast<return_statement_node *>(parent)->return_value);
+				break;
+		}
+	}
+
+	static bool fuse(syntax_tree &ast, const pass_declaration_node *first, pass_declaration_node *second, bool clamp_color)
+	{
+		if (!renders_to_back_buffer_only(first) || !renders_to_back_buffer_only(second) || first->vertex_shader != second->vertex_shader)
+		{
+			return false;
+		}
+
+		const auto first_function = find_function(ast, first->pixel_shader);
+		const auto second_function = find_function(ast, second->pixel_shader);
+
+		if (first_function == nullptr || second_function == nullptr || first_function == second_function ||
+			!is_color_entry_point(first_function) || !is_color_entry_point(second_function))
+		{
+			return false;
+		}
+
+		// The second pixel shader is rewritten in place, so it may not be used anywhere else
+		if (count_references(ast, second_function) != 1 || may_discard(ast, first_function) || may_discard(ast, second_function))
+		{
+			return false;
+		}
+
+		std::vector<intrinsic_expression_node *> samples;
+
+		if (!find_current_pixel_samples(ast, second->vertex_shader, second_function, first->srgb_write_enable, samples))
+		{
+			return false;
+		}
+
+		// The new entry point takes the inputs of both pixel shaders, which are matched by their semantic
+		std::vector<variable_declaration_node *> parameters;
+		std::vector<expression_node *> first_arguments, second_arguments;
+
+		for (auto parameter : second_function->parameter_list)
+		{
+			parameters.push_back(make_parameter(ast, parameter, parameter->name));
+			second_arguments.push_back(make_reference(ast, parameters.back()));
+		}
+
+		for (auto parameter : first_function->parameter_list)
+		{
+			const auto it = std::find_if(parameters.begin(), parameters.end(), [parameter](const variable_declaration_node *existing) { return existing->semantic == parameter->semantic; });
+
+			if (it == parameters.end())
+			{
+				parameters.push_back(make_parameter(ast, parameter, parameter->name + '_' + std::to_string(parameters.size())));
+				first_arguments.push_back(make_reference(ast, parameters.back()));
+			}
+			else if (is_same_type((*it)->type, parameter->type))
+			{
+				first_arguments.push_back(make_reference(ast, *it));
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		// Pass the color of the first pixel shader to the second one instead of letting it sample the back buffer
+		const auto color = ast.make_node<variable_declaration_node>(second_function->location);
+		color->name = color->unique_name = "__fused_color";
+		color->type = first_function->return_type;
+		color->type.qualifiers = type_node::qualifier_in;
+		color->initializer_expression = nullptr;
+
+		second_function->parameter_list.push_back(color);
+
+		for (auto sample : samples)
+		{
+			if (clamp_color)
+			{
+				// Writing to a normalized back buffer clamps the color, so do the same when reading it from the parameter
+				sample->op = intrinsic_expression_node::saturate;
+				sample->arguments[0] = make_reference(ast, color);
+				sample->arguments[1] = sample->arguments[2] = sample->arguments[3] = nullptr;
+			}
+			else
+			{
+				const auto reference = make_reference(ast, color);
+
+				visit(second_function->definition, [sample, reference](node *node) {
+					replace_operand(node, sample, reference);
+				});
+			}
+		}
+
+		second_arguments.push_back(make_call(ast, first_function, first_arguments));
+
+		const auto return_statement = ast.make_node<return_statement_node>(second_function->location);
+		return_statement->is_discard = false;
+		return_statement->return_value = make_call(ast, second_function, second_arguments);
+
+		const auto fused_function = ast.make_node<function_declaration_node>(second_function->location);
+		fused_function->name = first_function->name + '_' + second_function->name;
+		fused_function->unique_name = second_function->unique_name + "_fused" + std::to_string(ast.functions.size());
+		fused_function->return_type = second_function->return_type;
+		fused_function->return_semantic = second_function->return_semantic;
+		fused_function->parameter_list = std::move(parameters);
+		fused_function->definition = ast.make_node<compound_statement_node>(second_function->location);
+		fused_function->definition->statement_list.push_back(return_statement);
+
+		// Functions are generated in order, so it has to follow the two it calls
+		ast.functions.push_back(fused_function);
+
+		second->pixel_shader = fused_function;
+
+		return true;
+	}
+
+	size_t fuse_passes(syntax_tree &ast, bool clamp_color)
+	{
+		size_t fused_count = 0;
+
+		for (auto technique : ast.techniques)
+		{
+			auto &passes = technique->pass_list;
+
+			for (size_t i = 1; i < passes.size();)
+			{
+				// The second pass keeps its state and gets a new pixel shader which does the work of both, so the first one can be removed
+				if (fuse(ast, passes[i - 1], passes[i], clamp_color))
+				{
+					passes.erase(passes.begin() + i - 1);
+					fused_count++;
+				}
+				else
+				{
+					i++;
+				}
+			}
+		}
+
+		return fused_count;
+	}
+}
@@ -0,0 +1,20 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_syntax_tree.hpp"
+
+namespace reshadefx
+{
+	/// <summary>
+	/// Merge consecutive passes of a technique into a single pass where possible. Two passes are merged if both render to the back buffer with 'PostProcessVS' as vertex shader and the second one only samples the output of the first at the current pixel.
+	/// The pixel shader of the second pass is rewritten to take the color of the first as a parameter and a new entry point is added that calls both, which saves a full screen draw and a back buffer copy per merged pass.
+	/// </summary>
+	/// <param name="ast">The abstract syntax tree of the effect, which is modified in place.</param>
+	/// <param name="clamp_color">Set to <c>true</c> if the back buffer has a normalized format, which clamps the color written by the first pass to the [0, 1] range.</param>
+	/// <returns>The number of passes that were merged into others.</returns>
+	size_t fuse_passes(syntax_tree &ast, bool clamp_color);
+}
@@ -6,6 +6,8 @@
 #include "effect_preprocessor.hpp"
 #include <fstream>
 #include <assert.h>
+#include <iterator>
+#include <algorithm>
 
 namespace reshadefx
 {
@@ -44,7 +46,7 @@ namespace reshadefx
 
 	bool preprocessor::run(const filesystem::path &file_path)
 	{
-		std::ifstream file(file_path.wstring());
+		std::ifstream file(file_path.native());
 
 		if (!file.is_open())
 		{
@@ -607,7 +609,7 @@ namespace reshadefx
 
 		if (it == _filecache.end())
 		{
-			std::ifstream file(filepath.wstring());
+			std::ifstream file(filepath.native());
 
 			if (!file.is_open())
 			{
@@ -669,7 +671,7 @@ namespace reshadefx
 		// Run shunting-yard algorithm
 		while (!peek(tokenid::end_of_line))
 		{
-			if (stack_count >= _countof(stack) || rpn_count >= _countof(rpn))
+			if (stack_count >= std::size(stack) || rpn_count >= std::size(rpn))
 			{
 				error(current_token().location, "expression evaluator ran out of stack space");
 				return false;
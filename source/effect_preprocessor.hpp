@@ -41,7 +41,7 @@ namespace reshadefx
 	private:
 		struct if_level
 		{
-			token token;
+			reshadefx::token token;
 			bool value, skipping;
 			if_level *parent;
 		};
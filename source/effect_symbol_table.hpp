@@ -6,6 +6,7 @@
 #pragma once
 
 #include <stack>
+#include <vector>
 #include <unordered_map>
 #include <string>
 
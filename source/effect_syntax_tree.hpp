@@ -7,6 +7,7 @@
 
 #include "effect_syntax_tree_nodes.hpp"
 #include <list>
+#include <algorithm>
 
 namespace reshadefx
 {
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cfloat>
 #include "variant.hpp"
 #include "source_location.hpp"
 #include "runtime_objects.hpp"
@@ -54,7 +55,7 @@ namespace reshadefx
 
 	public:
 		const nodeid id;
-		location location;
+		reshadefx::location location;
 
 	protected:
 		explicit node(nodeid id) : id(id), location() { }
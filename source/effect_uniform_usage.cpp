@@ -0,0 +1,493 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_uniform_usage.hpp"
+#include <algorithm>
+
+namespace reshadefx
+{
+	using namespace nodes;
+
+	static inline size_t align(size_t offset, size_t alignment)
+	{
+		return alignment != 0 && offset % alignment != 0 ? offset + alignment - offset % alignment : offset;
+	}
+
+	uniform_usage::uniform_usage(const syntax_tree &ast)
+	{
+		for (auto variable : ast.variables)
+		{
+			if (variable->type.is_texture())
+			{
+				continue;
+			}
+			else if (variable->type.is_sampler())
+			{
+				_samplers.insert(variable);
+				continue;
+			}
+
+			if (variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				_uniform_indices[variable] = _uniforms.size();
+				_uniforms.push_back(variable);
+			}
+			else if (variable->initializer_expression != nullptr)
+			{
+				// Global variables are visible to every shader, so anything their initializers reference is used by all of them
+				visit(_global_references, variable->initializer_expression);
+			}
+		}
+
+		for (auto function : ast.functions)
+		{
+			visit(_functions[function], function->definition);
+		}
+	}
+
+	std::vector<const variable_declaration_node *> uniform_usage::find(const function_declaration_node *function) const
+	{
+		std::vector<bool> used(_uniforms.size());
+		std::unordered_set<const function_declaration_node *> visited;
+
+		collect(function, used, visited);
+
+		return sorted(used);
+	}
+	std::vector<const variable_declaration_node *> uniform_usage::find(const pass_declaration_node *pass) const
+	{
+		std::vector<bool> used(_uniforms.size());
+		std::unordered_set<const function_declaration_node *> visited;
+
+		collect(pass->vertex_shader, used, visited);
+		collect(pass->pixel_shader, used, visited);
+
+		return sorted(used);
+	}
+	std::vector<const variable_declaration_node *> uniform_usage::find(const technique_declaration_node *technique) const
+	{
+		std::vector<bool> used(_uniforms.size());
+		std::unordered_set<const function_declaration_node *> visited;
+
+		for (auto pass : technique->pass_list)
+		{
+			collect(pass->vertex_shader, used, visited);
+			collect(pass->pixel_shader, used, visited);
+		}
+
+		return sorted(used);
+	}
+
+	std::vector<const variable_declaration_node *> uniform_usage::find_samplers(const pass_declaration_node *pass) const
+	{
+		std::vector<const function_info *> reached;
+		std::unordered_set<const function_declaration_node *> visited;
+
+		collect(pass->vertex_shader, reached, visited);
+		collect(pass->pixel_shader, reached, visited);
+
+		std::unordered_set<const variable_declaration_node *> samplers;
+
+		for (auto info : reached)
+		{
+			samplers.insert(info->samplers.begin(), info->samplers.end());
+		}
+
+		return std::vector<const variable_declaration_node *>(samplers.begin(), samplers.end());
+	}
+	bool uniform_usage::may_discard(const function_declaration_node *function) const
+	{
+		std::vector<const function_info *> reached;
+		std::unordered_set<const function_declaration_node *> visited;
+
+		collect(function, reached, visited);
+
+		return std::any_of(reached.begin(), reached.end(), [](const function_info *info) { return info->discards; });
+	}
+
+	void uniform_usage::visit(function_info &info, const statement_node *node)
+	{
+		if (node == nullptr)
+		{
+			return;
+		}
+
+		switch (node->id)
+		{
+			case nodeid::compound_statement:
+				for (auto statement : static_cast<const compound_statement_node *>(node)->statement_list)
+				{
+					visit(info, statement);
+				}
+				break;
+			case nodeid::declarator_list:
+				for (auto declarator : static_cast<const declarator_list_node *>(node)->declarator_list)
+				{
+					visit(info, declarator->initializer_expression);
+				}
+				break;
+			case nodeid::expression_statement:
+				visit(info, static_cast<const expression_statement_node *>(node)->expression);
+				break;
+			case nodeid::if_statement:
+			{
+				const auto if_node = static_cast<const if_statement_node *>(node);
+				visit(info, if_node->condition);
+				visit(info, if_node->statement_when_true);
+				visit(info, if_node->statement_when_false);
+				break;
+			}
+			case nodeid::switch_statement:
+			{
+				const auto switch_node = static_cast<const switch_statement_node *>(node);
+				visit(info, switch_node->test_expression);
+
+				for (auto case_node : switch_node->case_list)
+				{
+					visit(info, case_node);
+				}
+				break;
+			}
+			case nodeid::case_statement:
+				visit(info, static_cast<const case_statement_node *>(node)->statement_list);
+				break;
+			case nodeid::for_statement:
+			{
+				const auto for_node = static_cast<const for_statement_node *>(node);
+				visit(info, for_node->init_statement);
+				visit(info, for_node->condition);
+				visit(info, for_node->increment_expression);
+				visit(info, for_node->statement_list);
+				break;
+			}
+			case nodeid::while_statement:
+			{
+				const auto while_node = static_cast<const while_statement_node *>(node);
+				visit(info, while_node->condition);
+				visit(info, while_node->statement_list);
+				break;
+			}
+			case nodeid::return_statement:
+				info.discards |= static_cast<const return_statement_node *>(node)->is_discard;
+				visit(info, static_cast<const return_statement_node *>(node)->return_value);
+				break;
+		}
+	}
+	void uniform_usage::visit(function_info &info, const expression_node *node)
+	{
+		if (node == nullptr)
+		{
+			return;
+		}
+
+		switch (node->id)
+		{
+			case nodeid::lvalue_expression:
+			{
+				const auto reference = static_cast<const lvalue_expression_node *>(node)->reference;
+
+				if (_uniform_indices.count(reference))
+				{
+					info.uniforms.insert(reference);
+				}
+				else if (_samplers.count(reference))
+				{
+					info.samplers.insert(reference);
+				}
+				break;
+			}
+			case nodeid::unary_expression:
+				visit(info, static_cast<const unary_expression_node *>(node)->operand);
+				break;
+			case nodeid::binary_expression:
+				visit(info, static_cast<const binary_expression_node *>(node)->operands[0]);
+				visit(info, static_cast<const binary_expression_node *>(node)->operands[1]);
+				break;
+			case nodeid::intrinsic_expression:
+				for (auto argument : static_cast<const intrinsic_expression_node *>(node)->arguments)
+				{
+					visit(info, argument);
+				}
+				break;
+			case nodeid::conditional_expression:
+			{
+				const auto conditional_node = static_cast<const conditional_expression_node *>(node);
+				visit(info, conditional_node->condition);
+				visit(info, conditional_node->expression_when_true);
+				visit(info, conditional_node->expression_when_false);
+				break;
+			}
+			case nodeid::assignment_expression:
+				visit(info, static_cast<const assignment_expression_node *>(node)->left);
+				visit(info, static_cast<const assignment_expression_node *>(node)->right);
+				break;
+			case nodeid::expression_sequence:
+				for (auto expression : static_cast<const expression_sequence_node *>(node)->expression_list)
+				{
+					visit(info, expression);
+				}
+				break;
+			case nodeid::call_expression:
+			{
+				const auto call_node = static_cast<const call_expression_node *>(node);
+				info.callees.insert(call_node->callee);
+
+				for (auto argument : call_node->arguments)
+				{
+					visit(info, argument);
+				}
+				break;
+			}
+			case nodeid::constructor_expression:
+				for (auto argument : static_cast<const constructor_expression_node *>(node)->arguments)
+				{
+					visit(info, argument);
+				}
+				break;
+			case nodeid::swizzle_expression:
+				visit(info, static_cast<const swizzle_expression_node *>(node)->operand);
+				break;
+			case nodeid::field_expression:
+				visit(info, static_cast<const field_expression_node *>(node)->operand);
+				break;
+			case nodeid::initializer_list:
+				for (auto value : static_cast<const initializer_list_node *>(node)->values)
+				{
+					visit(info, value);
+				}
+				break;
+		}
+	}
+	void uniform_usage::collect(const function_declaration_node *function, std::vector<const function_info *> &reached, std::unordered_set<const function_declaration_node *> &visited) const
+	{
+		if (function == nullptr)
+		{
+			return;
+		}
+
+		std::vector<const function_declaration_node *> queue = { function };
+
+		while (!queue.empty())
+		{
+			const auto current = queue.back();
+			queue.pop_back();
+
+			if (!visited.insert(current).second)
+			{
+				continue;
+			}
+
+			const auto it = _functions.find(current);
+
+			if (it == _functions.end())
+			{
+				continue;
+			}
+
+			reached.push_back(&it->second);
+
+			queue.insert(queue.end(), it->second.callees.begin(), it->second.callees.end());
+		}
+	}
+	void uniform_usage::collect(const function_declaration_node *function, std::vector<bool> &used, std::unordered_set<const function_declaration_node *> &visited) const
+	{
+		if (function == nullptr)
+		{
+			return;
+		}
+
+		std::vector<const function_info *> reached = { &_global_references };
+
+		collect(function, reached, visited);
+
+		for (auto callee : _global_references.callees)
+		{
+			collect(callee, reached, visited);
+		}
+
+		for (auto info : reached)
+		{
+			for (auto uniform : info->uniforms)
+			{
+				used[_uniform_indices.at(uniform)] = true;
+			}
+		}
+	}
+	std::vector<const variable_declaration_node *> uniform_usage::sorted(const std::vector<bool> &used) const
+	{
+		std::vector<const variable_declaration_node *> result;
+
+		for (size_t i = 0; i < used.size(); i++)
+		{
+			if (used[i])
+			{
+				result.push_back(_uniforms[i]);
+			}
+		}
+
+		return result;
+	}
+
+	size_t uniform_storage_size(const variable_declaration_node *node)
+	{
+		return node->type.rows * node->type.cols * std::max(1, node->type.array_length) * 4;
+	}
+
+	// Matrices are kept row by row in uniform storage, so a row is the unit that is placed into a register
+	static size_t uniform_vector_size(const variable_declaration_node *node)
+	{
+		return (node->type.is_matrix() ? node->type.cols : node->type.rows) * 4;
+	}
+	static size_t uniform_vector_count(const variable_declaration_node *node)
+	{
+		return (node->type.is_matrix() ? node->type.rows : 1) * std::max(1, node->type.array_length);
+	}
+
+	uniform_block_layout layout_uniform_block(const std::vector<const variable_declaration_node *> &uniforms, uniform_packing packing)
+	{
+		uniform_block_layout layout;
+		layout.uniforms = uniforms;
+		layout.offsets.reserve(uniforms.size());
+
+		for (auto uniform : uniforms)
+		{
+			const size_t vector_size = uniform_vector_size(uniform);
+			const size_t vector_count = uniform_vector_count(uniform);
+
+			// Array elements and matrix rows each start in a new 16 byte register in all packing rules
+			if (vector_count > 1 || uniform->type.is_array())
+			{
+				layout.size = align(layout.size, 16);
+				layout.offsets.push_back(layout.size);
+
+				// Only std140 pads the last register, the others may put the next variable into its remaining space
+				layout.size += (vector_count - 1) * 16 + (packing == uniform_packing::std140 ? 16 : vector_size);
+				continue;
+			}
+
+			switch (packing)
+			{
+				case uniform_packing::constant_buffer:
+					if (layout.size % 16 != 0 && layout.size % 16 + vector_size > 16)
+					{
+						layout.size = align(layout.size, 16);
+					}
+					break;
+				case uniform_packing::constant_registers:
+					layout.size = align(layout.size, 16);
+					break;
+				case uniform_packing::std140:
+					layout.size = align(layout.size, vector_size == 12 ? 16 : vector_size);
+					break;
+			}
+
+			layout.offsets.push_back(layout.size);
+			layout.size += vector_size;
+		}
+
+		// Constant buffers and registers are always a multiple of 16 bytes in size
+		if (packing != uniform_packing::std140)
+		{
+			layout.size = align(layout.size, 16);
+		}
+
+		return layout;
+	}
+
+	std::vector<reshade::uniform_copy_range> build_uniform_copy_ranges(const uniform_block_layout &layout, const std::vector<size_t> &storage_offsets)
+	{
+		std::vector<reshade::uniform_copy_range> ranges;
+
+		for (size_t i = 0; i < layout.uniforms.size(); i++)
+		{
+			const size_t vector_size = uniform_vector_size(layout.uniforms[i]);
+			const size_t vector_count = uniform_vector_count(layout.uniforms[i]);
+
+			// Uniform storage is tightly packed, so every register of an array or matrix is copied separately, unless the registers are full anyway
+			for (size_t k = 0; k < vector_count; k++)
+			{
+				const size_t storage_offset = storage_offsets[i] + k * vector_size;
+				const size_t block_offset = layout.offsets[i] + k * 16;
+
+				if (!ranges.empty() &&
+					ranges.back().storage_offset + ranges.back().size == storage_offset &&
+					ranges.back().block_offset + ranges.back().size == block_offset)
+				{
+					ranges.back().size += vector_size;
+				}
+				else
+				{
+					ranges.push_back({ storage_offset, block_offset, vector_size });
+				}
+			}
+		}
+
+		return ranges;
+	}
+
+	static bool overwrites_render_targets(const uniform_usage &usage, const pass_declaration_node *pass)
+	{
+		// The full screen triangle covers every pixel, so the previous contents only matter if it is blended with them or not all pixels pass or are written
+		return pass->clear_render_targets || (
+			!pass->blend_enable &&
+			!pass->stencil_enable &&
+			pass->color_write_mask == 0xF &&
+			!usage.may_discard(pass->pixel_shader));
+	}
+
+	reshade::back_buffer_access analyze_back_buffer_access(const uniform_usage &usage, const pass_declaration_node *pass)
+	{
+		reshade::back_buffer_access access;
+
+		for (auto sampler : usage.find_samplers(pass))
+		{
+			const auto texture = sampler->properties.texture;
+
+			if (texture != nullptr && (texture->semantic == "COLOR" || texture->semantic == "SV_TARGET"))
+			{
+				access.reads = true;
+				break;
+			}
+		}
+
+		access.writes = pass->render_targets[0] == nullptr;
+
+		// Other render targets may shrink the viewport, so the back buffer is only overwritten completely if there are none
+		if (access.writes)
+		{
+			access.overwrites = overwrites_render_targets(usage, pass) &&
+				std::all_of(pass->render_targets + 1, pass->render_targets + 8, [](const variable_declaration_node *target) { return target == nullptr; });
+		}
+
+		return access;
+	}
+	reshade::texture_access analyze_texture_access(const uniform_usage &usage, const pass_declaration_node *pass)
+	{
+		reshade::texture_access access;
+
+		for (auto sampler : usage.find_samplers(pass))
+		{
+			const auto texture = sampler->properties.texture;
+
+			// Textures with a semantic reference the back or depth buffer, which are not owned by the effect
+			if (texture != nullptr && texture->semantic.empty() && std::find(access.reads.begin(), access.reads.end(), texture->unique_name) == access.reads.end())
+			{
+				access.reads.push_back(texture->unique_name);
+			}
+		}
+
+		for (auto target : pass->render_targets)
+		{
+			if (target != nullptr)
+			{
+				access.writes.push_back(target->unique_name);
+			}
+		}
+
+		access.overwrites = !access.writes.empty() && overwrites_render_targets(usage, pass);
+
+		return access;
+	}
+}
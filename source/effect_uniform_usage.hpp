@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_syntax_tree.hpp"
+#include <unordered_set>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// The packing rules used to lay out uniform variables in a constant block.
+	/// </summary>
+	enum class uniform_packing
+	{
+		/// <summary>
+		/// HLSL constant buffer rules: A variable may not straddle a 16 byte boundary unless it starts on one.
+		/// </summary>
+		constant_buffer,
+		/// <summary>
+		/// Shader model 3 constant registers: Every variable starts in a new 16 byte register.
+		/// </summary>
+		constant_registers,
+		/// <summary>
+		/// GLSL std140 rules: Variables are aligned to their size, three-component vectors to the size of four components.
+		/// </summary>
+		std140,
+	};
+
+	/// <summary>
+	/// A compact constant block containing a subset of the uniform variables of an effect.
+	/// </summary>
+	struct uniform_block_layout
+	{
+		std::vector<const nodes::variable_declaration_node *> uniforms;
+		std::vector<size_t> offsets;
+		size_t size = 0;
+	};
+
+	/// <summary>
+	/// Analyzer which finds the uniform variables and samplers referenced by shader entry points, including the ones referenced through called functions.
+	/// </summary>
+	class uniform_usage
+	{
+	public:
+		/// <summary>
+		/// Construct a new analyzer for the specified effect and gather the direct references of all its functions.
+		/// </summary>
+		/// <param name="ast">The abstract syntax tree of the effect.</param>
+		explicit uniform_usage(const syntax_tree &ast);
+
+		/// <summary>
+		/// Find all uniform variables referenced by a function.
+		/// </summary>
+		/// <param name="function">The entry point function to analyze.</param>
+		/// <returns>A list of the referenced uniform variables, in declaration order.</returns>
+		std::vector<const nodes::variable_declaration_node *> find(const nodes::function_declaration_node *function) const;
+		/// <summary>
+		/// Find all uniform variables referenced by the vertex or pixel shader of a pass.
+		/// </summary>
+		/// <param name="pass">The pass to analyze.</param>
+		/// <returns>A list of the referenced uniform variables, in declaration order.</returns>
+		std::vector<const nodes::variable_declaration_node *> find(const nodes::pass_declaration_node *pass) const;
+		/// <summary>
+		/// Find all uniform variables referenced by any pass in a technique.
+		/// </summary>
+		/// <param name="technique">The technique to analyze.</param>
+		/// <returns>A list of the referenced uniform variables, in declaration order.</returns>
+		std::vector<const nodes::variable_declaration_node *> find(const nodes::technique_declaration_node *technique) const;
+		/// <summary>
+		/// Find all samplers referenced by the vertex or pixel shader of a pass.
+		/// </summary>
+		/// <param name="pass">The pass to analyze.</param>
+		/// <returns>A list of the referenced samplers, in no particular order.</returns>
+		std::vector<const nodes::variable_declaration_node *> find_samplers(const nodes::pass_declaration_node *pass) const;
+		/// <summary>
+		/// Check whether a function or any function it calls contains a discard statement.
+		/// </summary>
+		/// <param name="function">The entry point function to analyze.</param>
+		bool may_discard(const nodes::function_declaration_node *function) const;
+
+	private:
+		struct function_info
+		{
+			bool discards = false;
+			std::unordered_set<const nodes::variable_declaration_node *> uniforms, samplers;
+			std::unordered_set<const nodes::function_declaration_node *> callees;
+		};
+
+		void visit(function_info &info, const nodes::statement_node *node);
+		void visit(function_info &info, const nodes::expression_node *node);
+		void collect(const nodes::function_declaration_node *function, std::vector<const function_info *> &reached, std::unordered_set<const nodes::function_declaration_node *> &visited) const;
+		void collect(const nodes::function_declaration_node *function, std::vector<bool> &used, std::unordered_set<const nodes::function_declaration_node *> &visited) const;
+		std::vector<const nodes::variable_declaration_node *> sorted(const std::vector<bool> &used) const;
+
+		std::vector<const nodes::variable_declaration_node *> _uniforms;
+		std::unordered_map<const nodes::variable_declaration_node *, size_t> _uniform_indices;
+		std::unordered_map<const nodes::function_declaration_node *, function_info> _functions;
+		function_info _global_references;
+		std::unordered_set<const nodes::variable_declaration_node *> _samplers;
+	};
+
+	/// <summary>
+	/// Calculate the size of a uniform variable in bytes, excluding any padding.
+	/// </summary>
+	/// <param name="node">The uniform variable declaration.</param>
+	size_t uniform_storage_size(const nodes::variable_declaration_node *node);
+	/// <summary>
+	/// Lay out the specified uniform variables in a compact constant block, in the order they are passed in.
+	/// </summary>
+	/// <param name="uniforms">The uniform variables to put into the block.</param>
+	/// <param name="packing">The packing rules of the target shading language.</param>
+	uniform_block_layout layout_uniform_block(const std::vector<const nodes::variable_declaration_node *> &uniforms, uniform_packing packing);
+	/// <summary>
+	/// Build the list of copies necessary to fill a constant block from uniform storage. Ranges that are adjacent in both are merged into a single copy.
+	/// </summary>
+	/// <param name="layout">The layout of the constant block.</param>
+	/// <param name="storage_offsets">The offsets of the variables in uniform storage, in the same order as in the layout.</param>
+	std::vector<reshade::uniform_copy_range> build_uniform_copy_ranges(const uniform_block_layout &layout, const std::vector<size_t> &storage_offsets);
+	/// <summary>
+	/// Determine how a pass accesses the back buffer, so that the runtime can plan when it has to be copied.
+	/// </summary>
+	/// <param name="usage">The analyzer for the effect the pass is part of.</param>
+	/// <param name="pass">The pass to analyze.</param>
+	reshade::back_buffer_access analyze_back_buffer_access(const uniform_usage &usage, const nodes::pass_declaration_node *pass);
+	/// <summary>
+	/// Determine which textures declared by the effect a pass samples and renders to, so that the runtime can find out how long their contents have to be kept.
+	/// </summary>
+	/// <param name="usage">The analyzer for the effect the pass is part of.</param>
+	/// <param name="pass">The pass to analyze.</param>
+	reshade::texture_access analyze_texture_access(const uniform_usage &usage, const nodes::pass_declaration_node *pass);
+}
@@ -107,6 +107,40 @@ namespace reshade::filesystem
 	{
 		return GetFileAttributesW(path.wstring().c_str()) != INVALID_FILE_ATTRIBUTES;
 	}
+	uint64_t last_write_time(const path &path)
+	{
+		file_info info;
+
+		if (!get_file_info(path, info))
+		{
+			return 0;
+		}
+
+		return info.last_write_time;
+	}
+	bool get_file_info(const path &path, file_info &info)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+		if (!GetFileAttributesExW(path.wstring().c_str(), GetFileExInfoStandard, &attributes))
+		{
+			return false;
+		}
+
+		info.file_path = path;
+		info.last_write_time = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+		info.size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+
+		return true;
+	}
+	bool replace_file(const path &source_path, const path &target_path)
+	{
+		return MoveFileExW(source_path.wstring().c_str(), target_path.wstring().c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+	}
+	bool remove(const path &path)
+	{
+		return DeleteFileW(path.wstring().c_str()) != FALSE;
+	}
 	path resolve(const path &filename, const std::vector<path> &paths)
 	{
 		for (const auto &path : paths)
@@ -197,6 +231,38 @@ namespace reshade::filesystem
 
 		FindClose(handle);
 
+		return result;
+	}
+	std::vector<file_info> list_files_with_info(const path &path, const std::string &mask)
+	{
+		WIN32_FIND_DATAW ffd;
+
+		const HANDLE handle = FindFirstFileW((path / mask).wstring().c_str(), &ffd);
+
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return { };
+		}
+
+		std::vector<file_info> result;
+
+		do
+		{
+			if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				continue;
+			}
+
+			// The find data already contains the file attributes, so they do not have to be queried for every file separately
+			file_info &info = result.emplace_back();
+			info.file_path = path / filesystem::path(ffd.cFileName);
+			info.last_write_time = (static_cast<uint64_t>(ffd.ftLastWriteTime.dwHighDateTime) << 32) | ffd.ftLastWriteTime.dwLowDateTime;
+			info.size = (static_cast<uint64_t>(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow;
+		}
+		while (FindNextFileW(handle, &ffd));
+
+		FindClose(handle);
+
 		return result;
 	}
 }
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <ostream>
+#include <cstdint>
 
 namespace reshade::filesystem
 {
@@ -33,6 +34,12 @@ namespace reshade::filesystem
 		std::string &string() { return _data; }
 		const std::string &string() const { return _data; }
 		std::wstring wstring() const;
+		// File streams take wide strings on Windows, so this returns the string type they expect on the current platform
+#ifdef _WIN32
+		std::wstring native() const { return wstring(); }
+#else
+		const std::string &native() const { return _data; }
+#endif
 
 		friend std::ostream &operator<<(std::ostream &stream, const path &path);
 
@@ -55,7 +62,24 @@ namespace reshade::filesystem
 		std::string _data;
 	};
 
+	struct file_info
+	{
+		path file_path;
+		uint64_t last_write_time = 0, size = 0;
+	};
+
 	bool exists(const path &path);
+	uint64_t last_write_time(const path &path);
+	/// <summary>
+	/// Query the modification time and size of a file with a single call.
+	/// </summary>
+	/// <returns><c>true</c> on success, or <c>false</c> if the file does not exist.</returns>
+	bool get_file_info(const path &path, file_info &info);
+	/// <summary>
+	/// Move a file to a new path, replacing any file that already exists there in a single step.
+	/// </summary>
+	bool replace_file(const path &source_path, const path &target_path);
+	bool remove(const path &path);
 	path resolve(const path &filename, const std::vector<path> &paths);
 	path absolute(const path &filename, const path &parent_path);
 
@@ -63,4 +87,5 @@ namespace reshade::filesystem
 	path get_special_folder_path(special_folder id);
 
 	std::vector<path> list_files(const path &path, const std::string &mask = "*", bool recursive = false);
+	std::vector<file_info> list_files_with_info(const path &path, const std::string &mask = "*");
 }
@@ -0,0 +1,310 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Implementation of the file system functions for platforms other than Windows, so that code using them can be built and tested there
+#ifndef _WIN32
+
+#include "filesystem.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cstring>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace reshade::filesystem
+{
+	static bool is_separator(char c)
+	{
+		return c == '/' || c == '\\';
+	}
+	// Returns the offset of the file name in a path, which is the part after the last separator
+	static size_t filename_offset(const std::string &data)
+	{
+		const size_t offset = data.find_last_of("/\\");
+		return offset != std::string::npos ? offset + 1 : 0;
+	}
+	// Returns the offset of the extension in a path, or its size if the file name has no extension
+	static size_t extension_offset(const std::string &data)
+	{
+		const size_t offset = data.rfind('.');
+		return offset != std::string::npos && offset >= filename_offset(data) ? offset : data.size();
+	}
+
+	path::path(const std::string &data) : _data(data)
+	{
+	}
+	path::path(const std::wstring &data)
+	{
+		// Wide strings are UTF-32 on these platforms
+		for (const wchar_t c : data)
+		{
+			const uint32_t code_point = static_cast<uint32_t>(c);
+
+			if (code_point < 0x80)
+			{
+				_data += static_cast<char>(code_point);
+			}
+			else if (code_point < 0x800)
+			{
+				_data += static_cast<char>(0xC0 | (code_point >> 6));
+				_data += static_cast<char>(0x80 | (code_point & 0x3F));
+			}
+			else if (code_point < 0x10000)
+			{
+				_data += static_cast<char>(0xE0 | (code_point >> 12));
+				_data += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+				_data += static_cast<char>(0x80 | (code_point & 0x3F));
+			}
+			else
+			{
+				_data += static_cast<char>(0xF0 | (code_point >> 18));
+				_data += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+				_data += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+				_data += static_cast<char>(0x80 | (code_point & 0x3F));
+			}
+		}
+	}
+
+	bool path::operator==(const path &other) const
+	{
+		return _data == other._data;
+	}
+	bool path::operator!=(const path &other) const
+	{
+		return !operator==(other);
+	}
+
+	std::wstring path::wstring() const
+	{
+		std::wstring data;
+
+		for (size_t i = 0; i < _data.size();)
+		{
+			const unsigned char lead = static_cast<unsigned char>(_data[i++]);
+			const unsigned int length = lead < 0x80 ? 0 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : 3;
+
+			uint32_t code_point = length == 0 ? lead : lead & (0x3F >> length);
+			for (unsigned int k = 0; k < length && i < _data.size(); k++)
+				code_point = (code_point << 6) | (static_cast<unsigned char>(_data[i++]) & 0x3F);
+
+			data += static_cast<wchar_t>(code_point);
+		}
+
+		return data;
+	}
+
+	std::ostream &operator<<(std::ostream &stream, const path &path)
+	{
+		std::string result = path.string();
+
+		// Hide the user name, like on Windows
+		if (const char *const username = std::getenv("USER"); username != nullptr && username[0] != '\0')
+		{
+			const std::string mask(std::strlen(username), '*');
+
+			for (size_t start_pos = 0; (start_pos = result.find(username, start_pos)) != std::string::npos; start_pos += mask.size())
+			{
+				result.replace(start_pos, mask.size(), mask);
+			}
+		}
+
+		return stream << '\'' << result << '\'';
+	}
+
+	bool path::is_absolute() const
+	{
+		return !_data.empty() && is_separator(_data[0]);
+	}
+
+	path path::parent_path() const
+	{
+		size_t offset = filename_offset(_data);
+
+		// Keep the separator of the root directory, but drop all others
+		while (offset > 1 && is_separator(_data[offset - 1]))
+			offset--;
+
+		return _data.substr(0, offset);
+	}
+	path path::filename() const
+	{
+		return _data.substr(filename_offset(_data));
+	}
+	path path::filename_without_extension() const
+	{
+		const size_t offset = filename_offset(_data);
+		return _data.substr(offset, extension_offset(_data) - offset);
+	}
+	path path::extension() const
+	{
+		return _data.substr(extension_offset(_data));
+	}
+
+	path &path::replace_extension(const path &extension)
+	{
+		_data.erase(extension_offset(_data));
+		_data += extension._data;
+		return *this;
+	}
+
+	path path::operator/(const path &more) const
+	{
+		if (_data.empty())
+			return more;
+		if (more._data.empty())
+			return *this;
+
+		return is_separator(_data.back()) ? _data + more._data : _data + '/' + more._data;
+	}
+
+	bool exists(const path &path)
+	{
+		struct stat attributes;
+		return stat(path.string().c_str(), &attributes) == 0;
+	}
+	uint64_t last_write_time(const path &path)
+	{
+		file_info info;
+
+		if (!get_file_info(path, info))
+		{
+			return 0;
+		}
+
+		return info.last_write_time;
+	}
+	bool get_file_info(const path &path, file_info &info)
+	{
+		struct stat attributes;
+
+		if (stat(path.string().c_str(), &attributes) != 0)
+		{
+			return false;
+		}
+
+		info.file_path = path;
+		// Use the full resolution, so that writes in quick succession still change the time
+		info.last_write_time = static_cast<uint64_t>(attributes.st_mtim.tv_sec) * 1000000000 + attributes.st_mtim.tv_nsec;
+		info.size = static_cast<uint64_t>(attributes.st_size);
+
+		return true;
+	}
+	bool replace_file(const path &source_path, const path &target_path)
+	{
+		return std::rename(source_path.string().c_str(), target_path.string().c_str()) == 0;
+	}
+	bool remove(const path &path)
+	{
+		return std::remove(path.string().c_str()) == 0;
+	}
+	path resolve(const path &filename, const std::vector<path> &paths)
+	{
+		for (const auto &path : paths)
+		{
+			auto result = absolute(filename, path);
+
+			if (exists(result))
+			{
+				return result;
+			}
+		}
+
+		return filename;
+	}
+	path absolute(const path &filename, const path &parent_path)
+	{
+		if (filename.is_absolute())
+			return filename;
+
+		return parent_path / filename;
+	}
+
+	path get_module_path(void *)
+	{
+		char result[PATH_MAX] = { };
+		const ssize_t length = readlink("/proc/self/exe", result, sizeof(result) - 1);
+
+		return std::string(result, length > 0 ? length : 0);
+	}
+	path get_special_folder_path(special_folder id)
+	{
+		switch (id)
+		{
+		case special_folder::app_data:
+			if (const char *const home = std::getenv("HOME"); home != nullptr)
+				return path(home) / ".config";
+			break;
+		case special_folder::system:
+		case special_folder::windows:
+			break;
+		}
+
+		return path();
+	}
+
+	std::vector<path> list_files(const path &path, const std::string &mask, bool recursive)
+	{
+		DIR *const directory = opendir(path.string().c_str());
+
+		if (directory == nullptr)
+		{
+			return { };
+		}
+
+		std::vector<filesystem::path> result;
+
+		while (const dirent *const entry = readdir(directory))
+		{
+			const filesystem::path filename(entry->d_name);
+
+			if (filename.string() == "." || filename.string() == "..")
+			{
+				continue;
+			}
+
+			struct stat attributes;
+			if (stat((path / filename).string().c_str(), &attributes) != 0)
+			{
+				continue;
+			}
+
+			if (S_ISDIR(attributes.st_mode))
+			{
+				if (recursive)
+				{
+					const auto recursive_result = list_files(path / filename, mask, true);
+					result.insert(result.end(), recursive_result.begin(), recursive_result.end());
+				}
+			}
+			else if (fnmatch(mask.c_str(), entry->d_name, 0) == 0)
+			{
+				result.push_back(path / filename);
+			}
+		}
+
+		closedir(directory);
+
+		return result;
+	}
+	std::vector<file_info> list_files_with_info(const path &path, const std::string &mask)
+	{
+		std::vector<file_info> result;
+
+		for (const filesystem::path &file_path : list_files(path, mask, false))
+		{
+			if (file_info info; get_file_info(file_path, info))
+			{
+				result.push_back(std::move(info));
+			}
+		}
+
+		return result;
+	}
+}
+
+#endif
@@ -3,6 +3,8 @@
  * License: https://github.com/crosire/reshade#license
  */
 
+#if RESHADE_GUI
+
 #include "log.hpp"
 #include "version.h"
 #include "runtime.hpp"
@@ -128,6 +130,12 @@ namespace reshade
 					"This might take a while. The application could become unresponsive for some time.",
 					static_cast<unsigned int>(_reload_remaining_effects));
 			}
+			else if (_reload_remaining_textures != 0)
+			{
+				ImGui::Text(
+					"Loading (%u textures remaining) ...",
+					static_cast<unsigned int>(_reload_remaining_textures));
+			}
 			else
 			{
 				ImGui::Text(
@@ -138,9 +146,7 @@ namespace reshade
 					keyboard_keys[_menu_key_data[0]]);
 			}
 
-			if (const auto it = std::find_if(reshade::log::lines.rbegin(), reshade::log::lines.rend(), [](const std::string &line) {
-					return line.find("error") != std::string::npos;
-				}); it != reshade::log::lines.rend())
+			if (reshade::log::lines.count(reshade::log::level::error) != 0)
 			{
 				ImGui::SetWindowSize(ImVec2(_width - 20.0f, ImGui::GetFrameHeightWithSpacing() * 4));
 
@@ -822,6 +828,7 @@ namespace reshade
 			ImGui::TextUnformatted("FPS:");
 			ImGui::TextUnformatted("Post-Processing:");
 			ImGui::TextUnformatted("Draw Calls:");
+			ImGui::TextUnformatted("Constant Uploads:");
 			ImGui::Text("Frame %llu:", _framecount + 1);
 			ImGui::TextUnformatted("Timer:");
 			ImGui::TextUnformatted("Network:");
@@ -836,6 +843,7 @@ namespace reshade
 			ImGui::Text("%.2f", _imgui_context->IO.Framerate);
 			ImGui::Text("%f ms (CPU)", (post_processing_time_cpu * 1e-6f));
 			ImGui::Text("%u (%u vertices)", _drawcalls, _vertices);
+			ImGui::Text("%u (%u skipped)", _uniform_uploads, _uniform_uploads_skipped);
 			ImGui::Text("%f ms", _last_frame_duration.count() * 1e-6f);
 			ImGui::Text("%f ms", std::fmod(std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count() * 1e-6f, 16777216.0f));
 			ImGui::Text("%u B", g_network_traffic);
@@ -882,7 +890,7 @@ namespace reshade
 					continue;
 				}
 
-				ImGui::Text("%ux%u +%u ", texture.width, texture.height, (texture.levels - 1));
+				ImGui::Text("%ux%u +%u %s", texture.width, texture.height, (texture.levels - 1), texture.aliased ? "(shared)" : "");
 			}
 
 			ImGui::EndGroup();
@@ -924,7 +932,11 @@ namespace reshade
 
 			for (const auto &technique : _techniques)
 			{
-				if (technique.enabled)
+				if (technique.enabled && !technique.compiled)
+				{
+					ImGui::TextUnformatted("Compiling ...");
+				}
+				else if (technique.enabled)
 				{
 					ImGui::Text("%f ms (CPU)", (technique.average_cpu_duration * 1e-6f));
 				}
@@ -967,34 +979,52 @@ namespace reshade
 		static ImGuiTextFilter filter; // TODO: Better make this a member of the runtime class, in case there are multiple instances.
 		filter.Draw("Filter (inc, -exc)", -150);
 
-		std::vector<std::string> lines;
-		for (auto &line : reshade::log::lines)
-			if (filter.PassFilter(line.c_str()))
-				lines.push_back(line);
+		// Only lines added since the last frame have to be filtered, unless the filter changed
+		if (_log_filter_text != filter.InputBuf)
+		{
+			_log_filter_text = filter.InputBuf;
+			_log_filtered_lines.clear();
+			_log_filtered_end_index = 0;
+		}
+
+		const uint64_t begin_index = reshade::log::lines.begin_index();
+
+		while (!_log_filtered_lines.empty() && _log_filtered_lines.front() < begin_index)
+		{
+			_log_filtered_lines.pop_front();
+		}
+
+		reshade::log::lines.for_each(_log_filtered_end_index, [this](uint64_t index, const reshade::log::line &line) {
+			if (filter.PassFilter(line.text.c_str(), line.text.c_str() + line.text.size()))
+				_log_filtered_lines.push_back(index);
+			_log_filtered_end_index = index + 1;
+		});
 
 		ImGui::BeginChild("log");
 
-		ImGuiListClipper clipper(static_cast<int>(lines.size()), ImGui::GetTextLineHeightWithSpacing());
+		ImGuiListClipper clipper(static_cast<int>(_log_filtered_lines.size()), ImGui::GetTextLineHeightWithSpacing());
 
-		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
-		{
+		// Only the visible lines are looked up and submitted
+		std::vector<uint64_t> visible_lines(_log_filtered_lines.begin() + clipper.DisplayStart, _log_filtered_lines.begin() + clipper.DisplayEnd);
+
+		reshade::log::lines.for_each(visible_lines.data(), visible_lines.size(), [this](uint64_t, const reshade::log::line &line) {
 			ImVec4 textcol(1, 1, 1, 1);
 
-			if (lines[i].find("ERROR |") != std::string::npos)
+			if (line.level == reshade::log::level::error)
 				textcol = ImVec4(1, 0, 0, 1);
-			else if (lines[i].find("WARN  |") != std::string::npos)
+			else if (line.level == reshade::log::level::warning)
 				textcol = ImVec4(1, 1, 0, 1);
-			else if (lines[i].find("DEBUG |") != std::string::npos)
+			else if (line.level == reshade::log::level::debug)
 				textcol = ImColor(100, 100, 255);
 
 			ImGui::PushStyleColor(ImGuiCol_Text, textcol);
 			if (_log_wordwrap) ImGui::PushTextWrapPos();
 
-			ImGui::TextUnformatted(lines[i].c_str());
+			ImGui::TextUnformatted(line.text.c_str(), line.text.c_str() + line.text.size());
 
 			if (_log_wordwrap) ImGui::PopTextWrapPos();
 			ImGui::PopStyleColor();
-		}
+		});
 
 		clipper.End();
 
@@ -1438,3 +1468,5 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 		}
 	}
 }
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "hook_exports.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::hooks
+{
+	std::vector<std::pair<module_export, hook::address>> match_exports(const std::vector<module_export> &target_exports, std::vector<module_export> replacement_exports)
+	{
+		const auto name_less = [](const module_export &lhs, const module_export &rhs) {
+			return std::strcmp(lhs.name, rhs.name) < 0;
+		};
+
+		// Sort replacement exports by name, so that each target export is matched with a binary search instead of comparing it against all of them
+		replacement_exports.erase(std::remove_if(replacement_exports.begin(), replacement_exports.end(),
+			[](const auto &symbol) { return symbol.name == nullptr; }), replacement_exports.end());
+		std::sort(replacement_exports.begin(), replacement_exports.end(), name_less);
+
+		std::vector<std::pair<module_export, hook::address>> matches;
+		matches.reserve(std::min(target_exports.size(), replacement_exports.size()));
+
+		for (const auto &symbol : target_exports)
+		{
+			if (symbol.name == nullptr || symbol.address == nullptr)
+			{
+				continue;
+			}
+
+			// Find appropriate replacement
+			const auto it = std::lower_bound(replacement_exports.cbegin(), replacement_exports.cend(), symbol, name_less);
+
+			// Filter uninteresting functions
+			if (it != replacement_exports.cend() && std::strcmp(it->name, symbol.name) == 0 &&
+				std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") != 0 &&
+				std::strcmp(symbol.name, "DXGIDumpJournal") != 0)
+			{
+				matches.emplace_back(symbol, it->address);
+			}
+		}
+
+		return matches;
+	}
+}
@@ -0,0 +1,31 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "hook.hpp"
+#include <vector>
+#include <utility>
+
+namespace reshade::hooks
+{
+	/// <summary>
+	/// A single entry of the export table of a module.
+	/// </summary>
+	struct module_export
+	{
+		hook::address address;
+		const char *name;
+		unsigned short ordinal;
+	};
+
+	/// <summary>
+	/// Find the exports of a target module which the replacement module exports a function with the same name for.
+	/// </summary>
+	/// <param name="target_exports">The export table of the module to hook.</param>
+	/// <param name="replacement_exports">The export table of the module containing the hook functions. It does not need to be sorted.</param>
+	/// <returns>A list of the matching target exports together with the address of their replacement, in the order of the target export table.</returns>
+	std::vector<std::pair<module_export, hook::address>> match_exports(const std::vector<module_export> &target_exports, std::vector<module_export> replacement_exports);
+}
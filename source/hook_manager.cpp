@@ -5,8 +5,11 @@
 
 #include "log.hpp"
 #include "hook_manager.hpp"
+#include "hook_exports.hpp"
+#include "hook_table.hpp"
 #include <assert.h>
 #include <mutex>
+#include <chrono>
 #include <algorithm>
 #include <tuple>
 #include <vector>
@@ -15,6 +18,9 @@
 
 extern HMODULE g_module_handle;
 
+using reshade::hooks::module_export;
+using reshade::hooks::match_exports;
+
 namespace
 {
 	enum class hook_method
@@ -23,13 +29,6 @@ namespace
 		function_hook,
 		vtable_hook
 	};
-	struct module_export
-	{
-		reshade::hook::address address;
-		const char *name;
-		unsigned short ordinal;
-	};
-
 	inline auto load_module(const reshade::filesystem::path &path)
 	{
 		return LoadLibraryW(path.wstring().c_str());
@@ -76,13 +75,14 @@ namespace
 
 		return exports;
 	}
-
 	reshade::filesystem::path s_export_hook_path;
 	std::vector<std::tuple<const char *, reshade::hook, hook_method>> s_hooks; std::mutex s_mutex_hooks;
+	// Maps a replacement to its hook, so that 'reshade::hooks::call' does not have to lock. Only changed with 's_mutex_hooks' held.
+	reshade::hooks::hook_table s_hook_table;
 	std::vector<reshade::filesystem::path> s_delayed_hook_paths; std::mutex s_mutex_delayed_hook_paths;
 	std::unordered_map<reshade::hook::address, reshade::hook::address *> s_vtable_addresses; std::mutex s_mutex_vtable_addresses;
 
-	bool install_internal(const char *name, reshade::hook &hook, hook_method method)
+	bool create_internal(const char *name, reshade::hook &hook, hook_method method)
 	{
 #if RESHADE_VERBOSE_LOG
 		LOG(DEBUG) << "Installing hook for '" << name << "' at 0x" << hook.target << " with 0x" << hook.replacement << " using method " << static_cast<int>(method) << " ...";
@@ -134,8 +134,19 @@ namespace
 		LOG(DEBUG) << "> Succeeded.";
 #endif
 
+		return true;
+	}
+	bool install_internal(const char *name, reshade::hook &hook, hook_method method)
+	{
+		if (!create_internal(name, hook, method))
+		{
+			return false;
+		}
+
 		{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
 			s_hooks.push_back(std::make_tuple(name, hook, method));
+
+			s_hook_table.insert(hook);
 		}
 
 		return true;
@@ -145,6 +156,8 @@ namespace
 		assert(target_module != nullptr);
 		assert(replacement_module != nullptr);
 
+		const auto start_time = std::chrono::high_resolution_clock::now();
+
 		// Load export tables
 		const auto target_exports = get_module_exports(target_module);
 		const auto replacement_exports = get_module_exports(replacement_module);
@@ -156,64 +169,56 @@ namespace
 			return false;
 		}
 
-		size_t install_count = 0;
-		std::vector<std::tuple<const char *, reshade::hook::address, reshade::hook::address>> matches;
-		matches.reserve(replacement_exports.size());
+		const auto matches = match_exports(target_exports, replacement_exports);
 
 #if RESHADE_VERBOSE_LOG
 		LOG(DEBUG) << "> Dumping matches in export table:";
 		LOG(DEBUG) << "  +--------------------+---------+----------------------------------------------------+";
 		LOG(DEBUG) << "  | Address            | Ordinal | Name                                               |";
 		LOG(DEBUG) << "  +--------------------+---------+----------------------------------------------------+";
-#endif
 
-		// Analyze export table
-		for (const auto &symbol : target_exports)
+		for (const auto &[symbol, replacement] : matches)
 		{
-			if (symbol.name == nullptr || symbol.address == nullptr)
-			{
-				continue;
-			}
-
-			// Find appropriate replacement
-			const auto it = std::find_if(replacement_exports.cbegin(), replacement_exports.cend(),
-				[&symbol](const auto &moduleexport) {
-					return std::strcmp(moduleexport.name, symbol.name) == 0;
-				});
-
-			// Filter uninteresting functions
-			if (it != replacement_exports.cend() &&
-				std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") != 0 &&
-				std::strcmp(symbol.name, "DXGIDumpJournal") != 0)
-			{
-#if RESHADE_VERBOSE_LOG
-				LOG(DEBUG) << "  | 0x" << std::setw(16) << symbol.address << " | " << std::setw(7) << symbol.ordinal << " | " << std::setw(50) << symbol.name << " |";
-#endif
-
-				matches.push_back(std::make_tuple(symbol.name, symbol.address, it->address));
-			}
+			LOG(DEBUG) << "  | 0x" << std::setw(16) << symbol.address << " | " << std::setw(7) << symbol.ordinal << " | " << std::setw(50) << symbol.name << " |";
 		}
 
-#if RESHADE_VERBOSE_LOG
 		LOG(DEBUG) << "  +--------------------+---------+----------------------------------------------------+";
 #endif
 		LOG(INFO) << "> Found " << matches.size() << " match(es). Installing ...";
 
-		// Hook matching exports
-		for (const auto &match : matches)
+		// Hook matching exports and register them all at once afterwards, instead of taking the lock and growing the lookup table for every single one
+		std::vector<std::pair<const char *, reshade::hook>> hooks;
+		hooks.reserve(matches.size());
+
+		for (const auto &[symbol, replacement] : matches)
 		{
 			reshade::hook hook;
-			hook.target = std::get<1>(match);
+			hook.target = symbol.address;
 			hook.trampoline = hook.target;
-			hook.replacement = std::get<2>(match);
+			hook.replacement = replacement;
+
+			if (create_internal(symbol.name, hook, method))
+			{
+				hooks.emplace_back(symbol.name, hook);
+			}
+		}
+
+		{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
+			s_hooks.reserve(s_hooks.size() + hooks.size());
 
-			if (install_internal(std::get<0>(match), hook, method))
+			for (const auto &[name, hook] : hooks)
 			{
-				install_count++;
+				s_hooks.push_back(std::make_tuple(name, hook, method));
+
+				s_hook_table.insert(hook);
 			}
 		}
 
-		return install_count != 0;
+		const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time);
+
+		LOG(INFO) << "> Installed " << hooks.size() << " hook(s) in " << (duration.count() / 1000.0) << " ms.";
+
+		return !hooks.empty();
 	}
 	bool uninstall_internal(const char *name, reshade::hook &hook, hook_method method)
 	{
@@ -284,13 +289,8 @@ namespace
 	}
 
 	reshade::hook find_internal(reshade::hook::address replacement)
-	{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
-		const auto it = std::find_if(s_hooks.cbegin(), s_hooks.cend(),
-			[replacement](const auto &hook) {
-				return std::get<1>(hook).replacement == replacement;
-			});
-
-		return it != s_hooks.cend() ? std::get<1>(*it) : reshade::hook { };
+	{
+		return s_hook_table.find(replacement);
 	}
 	template <typename T>
 	inline T call_unchecked(T replacement)
@@ -474,13 +474,19 @@ void reshade::hooks::uninstall()
 	}
 
 	s_hooks.clear();
+
+	{ const std::lock_guard<std::mutex> lock(s_mutex_hooks);
+		// This waits for hooked calls which are still probing the table on other threads before freeing it
+		s_hook_table.clear();
+	}
 }
 void reshade::hooks::register_module(const filesystem::path &target_path)
 {
-	install("LoadLibraryA", reinterpret_cast<hook::address>(&LoadLibraryA), reinterpret_cast<hook::address>(&HookLoadLibraryA), true);
-	install("LoadLibraryExA", reinterpret_cast<hook::address>(&LoadLibraryExA), reinterpret_cast<hook::address>(&HookLoadLibraryExA), true);
-	install("LoadLibraryW", reinterpret_cast<hook::address>(&LoadLibraryW), reinterpret_cast<hook::address>(&HookLoadLibraryW), true);
-	install("LoadLibraryExW", reinterpret_cast<hook::address>(&LoadLibraryExW), reinterpret_cast<hook::address>(&HookLoadLibraryExW), true);
+	// Enable all four hooks in a single batch
+	install("LoadLibraryA", reinterpret_cast<hook::address>(&LoadLibraryA), reinterpret_cast<hook::address>(&HookLoadLibraryA));
+	install("LoadLibraryExA", reinterpret_cast<hook::address>(&LoadLibraryExA), reinterpret_cast<hook::address>(&HookLoadLibraryExA));
+	install("LoadLibraryW", reinterpret_cast<hook::address>(&LoadLibraryW), reinterpret_cast<hook::address>(&HookLoadLibraryW));
+	install("LoadLibraryExW", reinterpret_cast<hook::address>(&LoadLibraryExW), reinterpret_cast<hook::address>(&HookLoadLibraryExW));
 
 	hook::apply_queued_actions();
 
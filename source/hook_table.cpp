@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "hook_table.hpp"
+#include <thread>
+#include <cstdint>
+
+namespace reshade::hooks
+{
+	static inline size_t hash_replacement(hook::address replacement)
+	{
+		const uint64_t address = reinterpret_cast<uintptr_t>(replacement);
+
+		return static_cast<size_t>(((address ^ (address >> 15)) * 0x9E3779B97F4A7C15ull) >> 32);
+	}
+
+	hook_table::~hook_table()
+	{
+		clear();
+	}
+
+	bool hook_table::insert(const hook &hook)
+	{
+		storage *const current = _storage.load(std::memory_order_relaxed);
+
+		// Keep the table at most half full, so that probe sequences stay short
+		if (current != nullptr && 2 * (_count + 1) <= current->mask + 1)
+		{
+			if (!insert(*current, hook.replacement, hook.target, hook.trampoline))
+			{
+				return false;
+			}
+
+			_count++;
+			return true;
+		}
+
+		auto new_storage = std::make_unique<storage>(current != nullptr ? 2 * (current->mask + 1) : 1024);
+
+		if (current != nullptr)
+		{
+			for (size_t slot = 0; slot <= current->mask; slot++)
+			{
+				const entry &entry = current->entries[slot];
+
+				if (const auto replacement = entry.replacement.load(std::memory_order_relaxed); replacement != nullptr)
+				{
+					insert(*new_storage, replacement, entry.target, entry.trampoline);
+				}
+			}
+		}
+
+		const bool inserted = insert(*new_storage, hook.replacement, hook.target, hook.trampoline);
+
+		replace(new_storage.release());
+
+		if (inserted)
+		{
+			_count++;
+		}
+
+		return inserted;
+	}
+	bool hook_table::insert(storage &storage, hook::address replacement, hook::address target, hook::address trampoline)
+	{
+		for (size_t slot = hash_replacement(replacement) & storage.mask;; slot = (slot + 1) & storage.mask)
+		{
+			entry &entry = storage.entries[slot];
+			const auto key = entry.replacement.load(std::memory_order_relaxed);
+
+			// Keep the first hook installed for a replacement, same as a search through the list would find
+			if (key == replacement)
+			{
+				return false;
+			}
+
+			if (key == nullptr)
+			{
+				entry.target = target;
+				entry.trampoline = trampoline;
+				entry.replacement.store(replacement, std::memory_order_release);
+
+				return true;
+			}
+		}
+	}
+
+	hook hook_table::find(hook::address replacement) const
+	{
+		// Announce the lookup before reading the storage, so that 'replace' either waits for it or this sees the new storage
+		_num_readers.fetch_add(1, std::memory_order_seq_cst);
+
+		hook result;
+
+		if (const storage *const current = _storage.load(std::memory_order_seq_cst); current != nullptr)
+		{
+			for (size_t slot = hash_replacement(replacement) & current->mask;; slot = (slot + 1) & current->mask)
+			{
+				const entry &entry = current->entries[slot];
+				const auto key = entry.replacement.load(std::memory_order_acquire);
+
+				if (key == replacement)
+				{
+					result = hook { entry.target, entry.trampoline, replacement };
+					break;
+				}
+				if (key == nullptr)
+				{
+					break;
+				}
+			}
+		}
+
+		_num_readers.fetch_sub(1, std::memory_order_release);
+
+		return result;
+	}
+
+	void hook_table::clear()
+	{
+		replace(nullptr);
+
+		_count = 0;
+	}
+	void hook_table::replace(storage *new_storage)
+	{
+		storage *const old_storage = _storage.exchange(new_storage, std::memory_order_seq_cst);
+
+		if (old_storage == nullptr)
+		{
+			return;
+		}
+
+		// Lookups only take a few nanoseconds and never block, so this does not have to wait long
+		while (_num_readers.load(std::memory_order_seq_cst) != 0)
+		{
+			std::this_thread::yield();
+		}
+
+		delete old_storage;
+	}
+}
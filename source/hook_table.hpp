@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "hook.hpp"
+#include <atomic>
+#include <memory>
+
+namespace reshade::hooks
+{
+	/// <summary>
+	/// Open addressing hash table with linear probing which maps the replacement of a hook to the hook, so that resolving a trampoline does not have to lock.
+	/// There may only be a single thread changing the table at a time, but any number of threads looking up hooks concurrently. Entries are never changed after they were published.
+	/// </summary>
+	class hook_table
+	{
+	public:
+		hook_table() = default;
+		~hook_table();
+
+		hook_table(const hook_table &) = delete;
+		hook_table &operator=(const hook_table &) = delete;
+
+		/// <summary>
+		/// Returns the number of hooks in the table.
+		/// </summary>
+		size_t size() const { return _count; }
+
+		/// <summary>
+		/// Add a hook to the table. Growing the table waits for lookups that are still probing the old one to finish before freeing it.
+		/// </summary>
+		/// <param name="hook">The hook to add.</param>
+		/// <returns><c>true</c> if the hook was added, <c>false</c> if there already is a hook for the same replacement, which is kept.</returns>
+		bool insert(const hook &hook);
+		/// <summary>
+		/// Find the hook for a replacement function.
+		/// </summary>
+		/// <param name="replacement">The address of the replacement function.</param>
+		/// <returns>The hook, or an empty one if there is none for the replacement.</returns>
+		hook find(hook::address replacement) const;
+
+		/// <summary>
+		/// Remove all hooks and free the table, after waiting for lookups on other threads that are still probing it.
+		/// </summary>
+		void clear();
+
+	private:
+		struct entry
+		{
+			// Written last, so that readers never see a key without its trampoline
+			std::atomic<hook::address> replacement = nullptr;
+			hook::address target = nullptr;
+			hook::address trampoline = nullptr;
+		};
+		struct storage
+		{
+			explicit storage(size_t size) : mask(size - 1), entries(new entry[size]) { }
+
+			const size_t mask;
+			const std::unique_ptr<entry[]> entries;
+		};
+
+		static bool insert(storage &storage, hook::address replacement, hook::address target, hook::address trampoline);
+
+		// Unpublish the current storage and free it once no lookup reads it anymore
+		void replace(storage *storage);
+
+		size_t _count = 0;
+		std::atomic<storage *> _storage = nullptr;
+		// Number of lookups currently in progress, which may still be probing a storage that was just replaced
+		mutable std::atomic<size_t> _num_readers = 0;
+	};
+}
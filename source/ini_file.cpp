@@ -3,44 +3,170 @@
  * License: https://github.com/crosire/reshade#license
  */
 
+#include "log.hpp"
 #include "ini_file.hpp"
+#include <mutex>
+#include <atomic>
 #include <fstream>
 
 namespace reshade
 {
-	static inline void trim(std::string &str, const char *chars = " \t")
+	// The parsed contents of an ini file. All strings point into the file contents, so parsing only allocates the entry list and index.
+	struct ini_data
 	{
-		str.erase(0, str.find_first_not_of(chars));
-		str.erase(str.find_last_not_of(chars) + 1);
-	}
-	static inline std::string trim(const std::string &str, const char *chars = " \t")
+		struct entry
+		{
+			std::string_view section, key, value;
+		};
+		struct occurrences
+		{
+			uint32_t first, last;
+		};
+
+		std::string text;
+		// All entries in the order they appear in the file
+		std::vector<entry> entries;
+		// Maps section and key to the indices of their first and last entry
+		std::unordered_map<std::pair<std::string_view, std::string_view>, occurrences, ini_key_hash> index;
+
+		void parse();
+
+		const occurrences *find(std::string_view section, std::string_view key) const
+		{
+			const auto it = index.find({ section, key });
+			return it != index.end() ? &it->second : nullptr;
+		}
+	};
+
+	// A cached file, which is only read again once its modification time or size changes
+	struct ini_cache_entry
+	{
+		uint64_t write_time = 0, size = 0;
+		std::shared_ptr<const ini_data> data;
+		// Set when 'data' holds changes that were not written to disk yet
+		bool dirty = false;
+		// Value of 's_cache_tick' when the entry was last used, to find the least recently used one
+		uint64_t last_used = 0;
+	};
+
+	// Maximum number of files kept in the cache, so that switching through many presets does not keep all of them in memory
+	static constexpr size_t s_cache_capacity = 64;
+
+	static std::mutex s_cache_mutex;
+	static std::unordered_map<std::string, ini_cache_entry> s_cache;
+	static uint64_t s_cache_tick = 0;
+	// Checked without holding the lock, so that flushing every frame is cheap when nothing changed
+	static std::atomic<bool> s_cache_dirty = false;
+
+	static inline std::string_view trim(std::string_view str, const char *chars = " \t")
 	{
-		std::string res(str);
-		trim(res, chars);
-		return res;
+		const size_t first = str.find_first_not_of(chars);
+
+		if (first == std::string_view::npos)
+		{
+			return std::string_view();
+		}
+
+		return str.substr(first, str.find_last_not_of(chars) - first + 1);
 	}
 
-	ini_file::ini_file(const filesystem::path &path) : _path(path), _save_path(path)
+	static void write_value(std::string &text, const variant &value)
 	{
-		load();
+		size_t i = 0;
+
+		for (const auto &item : value.data())
+		{
+			if (i++ != 0)
+			{
+				text += ',';
+			}
+
+			text += item;
+		}
 	}
-	ini_file::ini_file(const filesystem::path &path, const filesystem::path &save_path) : _path(path), _save_path(save_path)
+
+	// Returns the cache entry for a path, evicting the least recently used entries if the cache is full. Must be called while holding 's_cache_mutex'.
+	static ini_cache_entry &find_cache_entry(const std::string &path)
 	{
-		load();
+		auto it = s_cache.find(path);
+
+		if (it == s_cache.end())
+		{
+			while (s_cache.size() >= s_cache_capacity)
+			{
+				auto oldest = s_cache.end();
+
+				// Entries with changes that were not written yet cannot be dropped
+				for (auto entry = s_cache.begin(); entry != s_cache.end(); ++entry)
+					if (!entry->second.dirty && (oldest == s_cache.end() || entry->second.last_used < oldest->second.last_used))
+						oldest = entry;
+
+				if (oldest == s_cache.end())
+					break;
+
+				s_cache.erase(oldest);
+			}
+
+			it = s_cache.emplace(path, ini_cache_entry()).first;
+		}
+
+		it->second.last_used = ++s_cache_tick;
+
+		return it->second;
 	}
-	ini_file::~ini_file()
+
+	// Write the contents of a cache entry to disk. Must be called while holding 's_cache_mutex'.
+	static bool write_cache_entry(const filesystem::path &path, ini_cache_entry &cache_entry)
 	{
-		save();
+		const std::string &text = cache_entry.data->text;
+
+		// Write to a temporary file first and then replace the original, so that it is never left partially written
+		const filesystem::path temp_path = path + ".tmp";
+
+		{
+			std::ofstream file(temp_path.native(), std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(text.data(), text.size());
+
+			if (!file.flush())
+			{
+				LOG(ERROR) << "Failed to write " << temp_path << '.';
+				return false;
+			}
+		}
+
+		if (!filesystem::replace_file(temp_path, path))
+		{
+			LOG(ERROR) << "Failed to replace " << path << '.';
+			filesystem::remove(temp_path);
+			return false;
+		}
+
+		// Remember the modification time of the new contents, so they do not have to be read again
+		if (filesystem::file_info info; filesystem::get_file_info(path, info))
+		{
+			cache_entry.write_time = info.last_write_time;
+			cache_entry.size = info.size;
+		}
+
+		return true;
 	}
 
-	void ini_file::load()
+	void ini_data::parse()
 	{
-		std::string line, section;
-		std::ifstream file(_path.wstring());
+		std::string_view section;
 
-		while (std::getline(file, line))
+		entries.clear();
+
+		for (size_t offset = 0, end; offset < text.size(); offset = end + 1)
 		{
-			trim(line);
+			end = text.find('\n', offset);
+
+			if (end == std::string::npos)
+			{
+				end = text.size();
+			}
+
+			const std::string_view line = trim(std::string_view(text).substr(offset, end - offset), " \t\r");
 
 			if (line.empty() || line[0] == ';' || line[0] == '/')
 			{
@@ -57,30 +183,136 @@ namespace reshade
 			// Read section content
 			const auto assign_index = line.find('=');
 
-			if (assign_index != std::string::npos)
+			if (assign_index != std::string_view::npos)
+			{
+				entries.push_back({ section, trim(line.substr(0, assign_index)), trim(line.substr(assign_index + 1)) });
+			}
+			else
 			{
-				const auto key = trim(line.substr(0, assign_index));
-				const auto value = trim(line.substr(assign_index + 1));
-				std::vector<std::string> value_splitted;
+				entries.push_back({ section, line, "0" });
+			}
+		}
 
-				for (size_t i = 0, len = value.size(), found; i < len; i = found + 1)
-				{
-					found = value.find_first_of(',', i);
+		index.clear();
+		index.reserve(entries.size());
 
-					if (found == std::string::npos)
-						found = len;
+		for (uint32_t i = 0; i < entries.size(); i++)
+		{
+			const auto insert = index.emplace(std::make_pair(entries[i].section, entries[i].key), occurrences { i, i });
 
-					value_splitted.push_back(value.substr(i, found - i));
-				}
+			if (!insert.second)
+			{
+				insert.first->second.last = i;
+			}
+		}
+	}
 
-				_sections[section][key] = value_splitted;
+	ini_file::ini_file(const filesystem::path &path) : _path(path), _save_path(path)
+	{
+		load();
+	}
+	ini_file::ini_file(const filesystem::path &path, const filesystem::path &save_path) : _path(path), _save_path(save_path)
+	{
+		load();
+	}
+	ini_file::~ini_file()
+	{
+		save();
+	}
+
+	void ini_file::flush_cache()
+	{
+		if (!s_cache_dirty.exchange(false))
+		{
+			return;
+		}
+
+		const std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		for (auto &[path, cache_entry] : s_cache)
+		{
+			if (!cache_entry.dirty)
+			{
+				continue;
 			}
-			else
+
+			cache_entry.dirty = false;
+
+			if (!write_cache_entry(path, cache_entry))
 			{
-				_sections[section][line] = 0;
+				// Read the file again the next time it is opened, since the cached contents do not match it
+				cache_entry.data.reset();
 			}
 		}
 	}
+	void ini_file::clear_cache()
+	{
+		flush_cache();
+
+		const std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		s_cache.clear();
+	}
+
+	bool ini_file::has_pending_changes(const filesystem::path &path)
+	{
+		if (!s_cache_dirty.load())
+		{
+			return false;
+		}
+
+		const std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		const auto it = s_cache.find(path.string());
+
+		return it != s_cache.end() && it->second.dirty;
+	}
+
+	void ini_file::load()
+	{
+		static const auto s_empty_data = std::make_shared<const ini_data>();
+
+		const std::lock_guard<std::mutex> lock(s_cache_mutex);
+
+		const auto it = s_cache.find(_path.string());
+
+		// Changes that were not written yet replace what is on disk
+		if (it != s_cache.end() && it->second.dirty)
+		{
+			it->second.last_used = ++s_cache_tick;
+			_data = it->second.data;
+			return;
+		}
+
+		filesystem::file_info info;
+
+		if (!filesystem::get_file_info(_path, info))
+		{
+			_data = s_empty_data;
+			return;
+		}
+
+		auto &cache_entry = it != s_cache.end() ? it->second : find_cache_entry(_path.string());
+		cache_entry.last_used = ++s_cache_tick;
+
+		if (cache_entry.data == nullptr || cache_entry.write_time != info.last_write_time || cache_entry.size != info.size)
+		{
+			const auto data = std::make_shared<ini_data>();
+
+			// Read the entire file at once and parse it in place
+			std::ifstream file(_path.native(), std::ios::in | std::ios::binary);
+			data->text.resize(static_cast<size_t>(info.size));
+			file.read(&data->text[0], data->text.size());
+			data->text.resize(static_cast<size_t>(file.gcount()));
+			data->parse();
+
+			cache_entry.write_time = info.last_write_time;
+			cache_entry.size = info.size;
+			cache_entry.data = data;
+		}
+
+		_data = cache_entry.data;
+	}
 	void ini_file::save() const
 	{
 		if (!_modified)
@@ -88,63 +320,170 @@ namespace reshade
 			return;
 		}
 
-		std::ofstream file(_save_path.wstring());
+		std::string text;
+		std::vector<bool> written_changes(_changes.size());
 
-		const auto it = _sections.find("");
+		const auto write_section = [this, &text, &written_changes](std::string_view section) {
+			if (!section.empty())
+			{
+				text += '[';
+				text += section;
+				text += "]\n";
+			}
 
-		if (it != _sections.end())
-		{
-			for (const auto &section_line : it->second)
+			// Write existing keys in file order, with the value they were changed to
+			for (uint32_t i = 0; i < _data->entries.size(); i++)
 			{
-				file << section_line.first << '=';
+				const auto &entry = _data->entries[i];
+
+				// Only write a key at its first occurrence, with the value of its last occurrence
+				if (entry.section != section)
+				{
+					continue;
+				}
 
-				size_t i = 0;
+				const auto occurrences = _data->find(entry.section, entry.key);
 
-				for (const auto &item : section_line.second.data())
+				if (occurrences->first != i)
 				{
-					if (i++ != 0)
-					{
-						file << ',';
-					}
+					continue;
+				}
 
-					file << item;
+				text += entry.key;
+				text += '=';
+
+				if (const auto change = _change_indices.find({ section, entry.key }); change != _change_indices.end())
+				{
+					written_changes[change->second] = true;
+					text += _changes[change->second].value;
+				}
+				else
+				{
+					text += _data->entries[occurrences->last].value;
 				}
 
-				file << std::endl;
+				text += '\n';
 			}
 
-			file << std::endl;
-		}
+			// Write keys that were added afterwards
+			for (size_t i = 0; i < _changes.size(); i++)
+			{
+				if (written_changes[i] || _changes[i].section != section)
+				{
+					continue;
+				}
+
+				written_changes[i] = true;
 
-		for (const auto &section : _sections)
+				text += _changes[i].key;
+				text += '=';
+				text += _changes[i].value;
+				text += '\n';
+			}
+
+			text += '\n';
+		};
+
+		// Collect all sections in the order they first appear, starting with the global one
+		std::vector<std::string_view> sections;
+		const auto add_section = [&sections](std::string_view section) {
+			if (std::find(sections.begin(), sections.end(), section) == sections.end())
+				sections.push_back(section);
+		};
+
+		for (const auto &entry : _data->entries)
 		{
-			if (section.first.empty())
+			if (entry.section.empty())
 			{
-				continue;
+				add_section(entry.section);
+				break;
+			}
+		}
+		for (const auto &change : _changes)
+		{
+			if (change.section.empty())
+			{
+				add_section(change.section);
+				break;
 			}
+		}
+
+		for (const auto &entry : _data->entries)
+		{
+			add_section(entry.section);
+		}
+		for (const auto &change : _changes)
+		{
+			add_section(change.section);
+		}
+
+		for (const auto &section : sections)
+		{
+			write_section(section);
+		}
 
-			file << '[' << section.first << ']' << std::endl;
+		const std::lock_guard<std::mutex> lock(s_cache_mutex);
 
-			for (const auto &section_line : section.second)
+		auto &cache_entry = find_cache_entry(_save_path.string());
+
+		// Skip writing if the file already has these contents, or they are already waiting to be written
+		if (cache_entry.data != nullptr && cache_entry.data->text == text)
+		{
+			if (filesystem::file_info info; cache_entry.dirty ||
+				(filesystem::get_file_info(_save_path, info) && info.last_write_time == cache_entry.write_time && info.size == cache_entry.size))
 			{
-				file << section_line.first << '=';
+				return;
+			}
+		}
 
-				size_t i = 0;
+		// Hand the new contents to the cache, which writes them to disk on the next flush, so that saving several times in a frame only writes once
+		const auto data = std::make_shared<ini_data>();
+		data->text = std::move(text);
+		data->parse();
 
-				for (const auto &item : section_line.second.data())
-				{
-					if (i++ != 0)
-					{
-						file << ',';
-					}
+		cache_entry.data = data;
+		cache_entry.dirty = true;
 
-					file << item;
-				}
+		s_cache_dirty.store(true);
+	}
 
-				file << std::endl;
+	bool ini_file::find(std::string_view section, std::string_view key, std::string_view &value) const
+	{
+		if (!_changes.empty())
+		{
+			if (const auto change = _change_indices.find({ section, key }); change != _change_indices.end())
+			{
+				value = _changes[change->second].value;
+				return true;
 			}
+		}
+
+		const auto occurrences = _data->find(section, key);
 
-			file << std::endl;
+		if (occurrences == nullptr)
+		{
+			return false;
 		}
+
+		// The last occurrence of a key wins
+		value = _data->entries[occurrences->last].value;
+		return true;
+	}
+	void ini_file::set_value(const std::string &section, const std::string &key, const variant &value)
+	{
+		_modified = true;
+
+		std::string text;
+		write_value(text, value);
+
+		if (const auto change = _change_indices.find({ section, key }); change != _change_indices.end())
+		{
+			_changes[change->second].value = std::move(text);
+			return;
+		}
+
+		const change &added = _changes.emplace_back(change { section, key, std::move(text) });
+
+		_change_indices.emplace(std::make_pair(std::string_view(added.section), std::string_view(added.key)), _changes.size() - 1);
 	}
 }
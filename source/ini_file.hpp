@@ -5,12 +5,35 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <cstdlib>
+#include <algorithm>
+#include <string_view>
 #include <unordered_map>
 #include "variant.hpp"
 #include "filesystem.hpp"
 
 namespace reshade
 {
+	struct ini_data;
+
+	/// <summary>
+	/// Hash of a section and key pair, used to look up values without building a combined string.
+	/// </summary>
+	struct ini_key_hash
+	{
+		size_t operator()(const std::pair<std::string_view, std::string_view> &key) const
+		{
+			const size_t section_hash = std::hash<std::string_view>()(key.first);
+			return section_hash ^ (std::hash<std::string_view>()(key.second) + 0x9e3779b9 + (section_hash << 6) + (section_hash >> 2));
+		}
+	};
+
+	/// <summary>
+	/// An ini file, which is read when it is opened. Changes are handed to a cache when it is closed and written to disk by <see cref="flush_cache"/>.
+	/// Parsed files are cached by path and modification time, so opening the same unchanged file again does not read it from disk.
+	/// </summary>
 	class ini_file
 	{
 	public:
@@ -18,98 +41,191 @@ namespace reshade
 		explicit ini_file(const filesystem::path &path, const filesystem::path &save_path);
 		~ini_file();
 
-		template <typename T>
-		void get(const std::string &section, const std::string &key, T &value) const
+		/// <summary>
+		/// Write all files that were changed since the last call to disk. This is called once per frame and on shutdown.
+		/// </summary>
+		static void flush_cache();
+		/// <summary>
+		/// Write all changed files to disk and drop all cached contents.
+		/// </summary>
+		static void clear_cache();
+		/// <summary>
+		/// Returns whether changes to the specified file were saved, but not written to disk yet.
+		/// </summary>
+		static bool has_pending_changes(const filesystem::path &path);
+
+		/// <summary>
+		/// Returns whether the specified key exists in the specified section.
+		/// </summary>
+		bool has(std::string_view section, std::string_view key) const
 		{
-			const auto it1 = _sections.find(section);
-
-			if (it1 == _sections.end())
-			{
-				return;
-			}
+			std::string_view data;
+			return find(section, key, data);
+		}
 
-			const auto it2 = it1->second.find(key);
+		/// <summary>
+		/// Read a value. Reading numbers and views does not allocate. Views point into the file contents and stay valid until this object is destroyed or the key is set again.
+		/// The value is left untouched if the key does not exist.
+		/// </summary>
+		template <typename T>
+		void get(std::string_view section, std::string_view key, T &value) const
+		{
+			std::string_view data;
 
-			if (it2 == it1->second.end())
+			if (!find(section, key, data))
 			{
 				return;
 			}
 
-			value = it2->second.as<T>();
+			value = convert<T>(data.substr(0, data.find(',')));
 		}
 		template <typename T, size_t SIZE>
-		void get(const std::string &section, const std::string &key, T(&values)[SIZE]) const
+		void get(std::string_view section, std::string_view key, T(&values)[SIZE]) const
 		{
-			const auto it1 = _sections.find(section);
+			std::string_view data;
 
-			if (it1 == _sections.end())
+			if (!find(section, key, data))
 			{
 				return;
 			}
 
-			const auto it2 = it1->second.find(key);
-
-			if (it2 == it1->second.end())
-			{
-				return;
-			}
+			size_t i = 0;
+			for_each_element(data, [&values, &i](std::string_view element) {
+				if (i < SIZE)
+					values[i++] = convert<T>(element);
+			});
 
-			for (size_t i = 0; i < SIZE; i++)
+			// Elements missing from the value are reset
+			for (; i < SIZE; i++)
 			{
-				values[i] = it2->second.as<T>(i);
+				values[i] = T();
 			}
 		}
 		template <typename T>
-		void get(const std::string &section, const std::string &key, std::vector<T> &values) const
+		void get(std::string_view section, std::string_view key, std::vector<T> &values) const
 		{
-			const auto it1 = _sections.find(section);
-
-			if (it1 == _sections.end())
-			{
-				return;
-			}
-
-			const auto it2 = it1->second.find(key);
+			std::string_view data;
 
-			if (it2 == it1->second.end())
+			if (!find(section, key, data))
 			{
 				return;
 			}
 
 			values.clear();
 
-			for (size_t i = 0; i < it2->second.data().size(); i++)
-			{
-				values.emplace_back(it2->second.as<T>(i));
-			}
+			for_each_element(data, [&values](std::string_view element) {
+				values.emplace_back(convert<T>(element));
+			});
 		}
 		template <typename T>
 		void set(const std::string &section, const std::string &key, const T &value)
 		{
-			_modified = true;
-			_sections[section][key] = value;
+			set_value(section, key, variant(value));
 		}
 		template <typename T, size_t SIZE>
 		void set(const std::string &section, const std::string &key, const T(&values)[SIZE])
 		{
-			_modified = true;
-			_sections[section][key] = values;
+			set_value(section, key, variant(values));
 		}
 		template <typename T, size_t SIZE>
 		void set(const std::string &section, const std::string &key, const std::vector<T> &values)
 		{
-			_modified = true;
-			_sections[section][key] = values;
+			set_value(section, key, variant(values));
 		}
 
 	private:
+		struct change
+		{
+			std::string section, key;
+			// The value as it is written to the file, with elements separated by commas
+			std::string value;
+		};
+
+		// Convert a single element of a value. Numbers are parsed from a copy on the stack, so this does not allocate.
+		template <typename T>
+		static T convert(std::string_view element);
+		// Call the function with every comma separated element of a value
+		template <typename F>
+		static void for_each_element(std::string_view value, F func)
+		{
+			for (size_t i = 0, found; i < value.size(); i = found + 1)
+			{
+				found = std::min(value.find(',', i), value.size());
+				func(value.substr(i, found - i));
+			}
+		}
+
 		void load();
 		void save() const;
 
+		bool find(std::string_view section, std::string_view key, std::string_view &value) const;
+		void set_value(const std::string &section, const std::string &key, const variant &value);
+
 		bool _modified = false;
 		filesystem::path _path;
 		filesystem::path _save_path;
-		using section = std::unordered_map<std::string, variant>;
-		std::unordered_map<std::string, section> _sections;
+		// Parsed contents of the file, which are shared with other instances opening the same file
+		std::shared_ptr<const ini_data> _data;
+		// Values set on this instance, in the order they were first set, and a lookup table from section and key to their index
+		// This is a deque, so that the keys of the lookup table, which point into the entries, stay valid when more are added
+		std::deque<change> _changes;
+		std::unordered_map<std::pair<std::string_view, std::string_view>, size_t, ini_key_hash> _change_indices;
 	};
+
+	template <>
+	inline std::string_view ini_file::convert<std::string_view>(std::string_view element)
+	{
+		return element;
+	}
+	template <>
+	inline std::string ini_file::convert<std::string>(std::string_view element)
+	{
+		return std::string(element);
+	}
+	template <>
+	inline filesystem::path ini_file::convert<filesystem::path>(std::string_view element)
+	{
+		return std::string(element);
+	}
+	template <>
+	inline long ini_file::convert<long>(std::string_view element)
+	{
+		char buffer[32];
+		buffer[element.copy(buffer, sizeof(buffer) - 1)] = '\0';
+		return std::strtol(buffer, nullptr, 10);
+	}
+	template <>
+	inline unsigned long ini_file::convert<unsigned long>(std::string_view element)
+	{
+		char buffer[32];
+		buffer[element.copy(buffer, sizeof(buffer) - 1)] = '\0';
+		return std::strtoul(buffer, nullptr, 10);
+	}
+	template <>
+	inline int ini_file::convert<int>(std::string_view element)
+	{
+		return static_cast<int>(convert<long>(element));
+	}
+	template <>
+	inline unsigned int ini_file::convert<unsigned int>(std::string_view element)
+	{
+		return static_cast<unsigned int>(convert<unsigned long>(element));
+	}
+	template <>
+	inline bool ini_file::convert<bool>(std::string_view element)
+	{
+		return convert<int>(element) != 0 || element == "true" || element == "True" || element == "TRUE";
+	}
+	template <>
+	inline double ini_file::convert<double>(std::string_view element)
+	{
+		char buffer[64];
+		buffer[element.copy(buffer, sizeof(buffer) - 1)] = '\0';
+		return std::strtod(buffer, nullptr);
+	}
+	template <>
+	inline float ini_file::convert<float>(std::string_view element)
+	{
+		return static_cast<float>(convert<double>(element));
+	}
 }
@@ -14,14 +14,151 @@
 
 namespace reshade
 {
+	// Data of a registered window which is shared between the threads retrieving its messages and the thread rendering to it.
+	// It lives in a table that only ever grows and is never freed, so that the message hook can access it without holding a lock, even while the window is unregistered.
+	struct input_window
+	{
+		std::atomic<HWND> window = nullptr;
+		std::atomic<bool> block_mouse = false, block_keyboard = false;
+		std::atomic<uint64_t> frame_count = 0;
+		// Messages for a window are retrieved on the thread that created it, but raw input can be rerouted from other windows, so producers are serialized by a lock which is practically never contended
+		std::atomic_flag producer_lock = ATOMIC_FLAG_INIT;
+		// Last mouse position that was queued, used to skip redundant mouse move events
+		POINT last_mouse_position = { LONG_MIN, LONG_MIN };
+		input_event_queue queue;
+	};
+
+	// Result of looking up the input window a message is sent to
+	struct input_window_lookup
+	{
+		HWND hwnd = nullptr;
+		unsigned int generation = 0;
+		input_window *window = nullptr;
+		// The window the entry belonged to at the time of the lookup, which tells whether the entry was reused since
+		HWND window_hwnd = nullptr;
+		bool is_raw_input_window = false;
+		unsigned int raw_input_flags = 0;
+	};
+
 	static std::mutex s_mutex;
 	static std::unordered_map<HWND, unsigned int> s_raw_input_windows;
 	static std::unordered_map<HWND, std::weak_ptr<input>> s_windows;
+	// Block of entries in the window table. Another block is appended when all entries are in use, which readers can follow without a lock, since blocks are never removed.
+	struct input_window_block
+	{
+		input_window windows[16];
+		std::atomic<input_window_block *> next = nullptr;
+	};
+
+	static input_window_block s_input_windows;
+	// Incremented whenever a window is registered or unregistered, which invalidates all cached lookups
+	static std::atomic<unsigned int> s_generation = 1;
+	// Messages are usually retrieved for only a few windows per thread, so a small cache avoids the lock and the window enumeration for nearly all of them
+	static thread_local input_window_lookup t_lookup_cache[4];
+	static thread_local unsigned int t_lookup_cache_next = 0;
+
+	template <typename F>
+	static input_window *find_input_window_if(F predicate)
+	{
+		for (auto block = &s_input_windows; block != nullptr; block = block->next.load(std::memory_order_acquire))
+		{
+			for (auto &data : block->windows)
+			{
+				if (predicate(data))
+				{
+					return &data;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+	static input_window *find_input_window(HWND hwnd)
+	{
+		return find_input_window_if([hwnd](const input_window &data) { return data.window.load(std::memory_order_relaxed) == hwnd; });
+	}
+	static input_window *find_most_active_input_window()
+	{
+		input_window *result = nullptr;
+		uint64_t result_frame_count = 0;
+
+		find_input_window_if([&result, &result_frame_count](input_window &data) {
+			if (data.window.load(std::memory_order_relaxed) == nullptr)
+			{
+				return false;
+			}
+
+			if (const uint64_t frame_count = data.frame_count.load(std::memory_order_relaxed);
+				result == nullptr || frame_count > result_frame_count)
+			{
+				result = &data;
+				result_frame_count = frame_count;
+			}
+
+			return false;
+		});
+
+		return result;
+	}
+	static const input_window_lookup &lookup_input_window(HWND hwnd)
+	{
+		const unsigned int generation = s_generation.load(std::memory_order_acquire);
+
+		for (const auto &lookup : t_lookup_cache)
+		{
+			if (lookup.hwnd == hwnd && lookup.generation == generation)
+			{
+				return lookup;
+			}
+		}
+
+		const std::lock_guard<std::mutex> lock(s_mutex);
+
+		auto &lookup = t_lookup_cache[t_lookup_cache_next++ % ARRAYSIZE(t_lookup_cache)];
+		lookup.hwnd = hwnd;
+		lookup.generation = s_generation.load(std::memory_order_relaxed);
+
+		// Look up the window in the list of known input windows
+		lookup.window = find_input_window(hwnd);
+
+		if (lookup.window == nullptr)
+		{
+			// Walk through the window chain and until an known window is found
+			EnumChildWindows(hwnd, [](HWND hwnd, LPARAM lparam) -> BOOL {
+				auto &window = *reinterpret_cast<input_window **>(lparam);
+				// Return true to continue enumeration
+				return (window = find_input_window(hwnd)) == nullptr;
+			}, reinterpret_cast<LPARAM>(&lookup.window));
+		}
+
+		lookup.window_hwnd = lookup.window != nullptr ? lookup.window->window.load(std::memory_order_relaxed) : nullptr;
+
+		const auto raw_input_window = s_raw_input_windows.find(hwnd);
+		lookup.is_raw_input_window = raw_input_window != s_raw_input_windows.end();
+		lookup.raw_input_flags = lookup.is_raw_input_window ? raw_input_window->second : 0;
+
+		return lookup;
+	}
 
 	input::input(window_handle window) : _window(window)
 	{
 		assert(window != nullptr);
 	}
+	input::~input()
+	{
+		if (_window_data == nullptr)
+		{
+			return;
+		}
+
+		const std::lock_guard<std::mutex> lock(s_mutex);
+
+		_window_data->block_mouse.store(false, std::memory_order_relaxed);
+		_window_data->block_keyboard.store(false, std::memory_order_relaxed);
+		_window_data->window.store(nullptr, std::memory_order_relaxed);
+
+		s_generation.fetch_add(1, std::memory_order_release);
+	}
 
 	void input::register_window_with_raw_input(window_handle window, bool no_legacy_keyboard, bool no_legacy_mouse)
 	{
@@ -34,34 +171,78 @@ namespace reshade
 		{
 			insert.first->second |= flags;
 		}
+
+		s_generation.fetch_add(1, std::memory_order_release);
 	}
 	std::shared_ptr<input> input::register_window(window_handle window)
 	{
 		const std::lock_guard<std::mutex> lock(s_mutex);
 
+		// Remove any expired entry from the list
+		for (auto it = s_windows.begin(); it != s_windows.end();)
+			it->second.expired() ? it = s_windows.erase(it) : ++it;
+
 		const auto insert = s_windows.emplace(static_cast<HWND>(window), std::weak_ptr<input>());
 
-		if (insert.second || insert.first->second.expired())
+		if (!insert.second)
 		{
+			return insert.first->second.lock();
+		}
+
 #if RESHADE_VERBOSE_LOG
-			LOG(DEBUG) << "Starting input capture for window " << window << " ...";
+		LOG(DEBUG) << "Starting input capture for window " << window << " ...";
 #endif
 
-			const auto instance = std::make_shared<input>(window);
+		const auto instance = std::make_shared<input>(window);
 
-			insert.first->second = instance;
+		insert.first->second = instance;
 
-			return instance;
-		}
-		else
+		// Find a free entry in the window table, which receives the input events from now on
+		input_window *data = find_input_window(nullptr);
+
+		if (data == nullptr)
 		{
-			return insert.first->second.lock();
+			// All entries are in use, so append another block to the table (this is only ever done with the lock held, so there is a single writer)
+			auto last_block = &s_input_windows;
+			while (last_block->next.load(std::memory_order_relaxed) != nullptr)
+				last_block = last_block->next.load(std::memory_order_relaxed);
+
+			const auto block = new input_window_block();
+			last_block->next.store(block, std::memory_order_release);
+
+			data = &block->windows[0];
 		}
+
+		// Reset the entry under the producer lock, so that a producer which still holds a stale lookup of it either finishes before or sees the new window and drops its events
+		while (data->producer_lock.test_and_set(std::memory_order_acquire))
+			continue;
+		data->last_mouse_position = { LONG_MIN, LONG_MIN };
+		data->queue.clear();
+		data->frame_count.store(0, std::memory_order_relaxed);
+		data->window.store(static_cast<HWND>(window), std::memory_order_relaxed);
+		data->producer_lock.clear(std::memory_order_release);
+
+		instance->_window_data = data;
+
+		s_generation.fetch_add(1, std::memory_order_release);
+
+		return instance;
 	}
 	void input::uninstall()
 	{
+		const std::lock_guard<std::mutex> lock(s_mutex);
+
 		s_windows.clear();
 		s_raw_input_windows.clear();
+
+		find_input_window_if([](input_window &data) {
+			data.block_mouse.store(false, std::memory_order_relaxed);
+			data.block_keyboard.store(false, std::memory_order_relaxed);
+			data.window.store(nullptr, std::memory_order_relaxed);
+			return false;
+		});
+
+		s_generation.fetch_add(1, std::memory_order_release);
 	}
 
 	bool input::handle_window_message(const void *message_data)
@@ -79,34 +260,20 @@ namespace reshade
 			return false;
 		}
 
-		const std::lock_guard<std::mutex> lock(s_mutex);
-
-		// Remove any expired entry from the list
-		for (auto it = s_windows.begin(); it != s_windows.end();)
-			it->second.expired() ? it = s_windows.erase(it) : ++it;
+		const input_window_lookup lookup = lookup_input_window(details.hwnd);
 
-		// Look up the window in the list of known input windows
-		auto input_window = s_windows.find(details.hwnd);
-		const auto raw_input_window = s_raw_input_windows.find(details.hwnd);
+		input_window *data = lookup.window;
+		HWND window = lookup.window_hwnd;
 
-		if (input_window == s_windows.end())
-		{
-			// Walk through the window chain and until an known window is found
-			EnumChildWindows(details.hwnd, [](HWND hwnd, LPARAM lparam) -> BOOL {
-				auto &input_window = *reinterpret_cast<decltype(s_windows)::iterator *>(lparam);
-				// Return true to continue enumeration
-				return (input_window = s_windows.find(hwnd)) == s_windows.end();
-			}, reinterpret_cast<LPARAM>(&input_window));
-		}
-
-		if (input_window == s_windows.end() && raw_input_window != s_raw_input_windows.end())
+		if (data == nullptr && lookup.is_raw_input_window)
 		{
 			// Reroute this raw input message to the window with the most rendering
-			input_window = std::max_element(s_windows.begin(), s_windows.end(),
-				[](auto lhs, auto rhs) { return lhs.second.lock()->_frame_count < rhs.second.lock()->_frame_count; });
+			data = find_most_active_input_window();
+			window = data != nullptr ? data->window.load(std::memory_order_relaxed) : nullptr;
 		}
 
-		if (input_window == s_windows.end())
+		// The window may have been unregistered since the lookup
+		if (data == nullptr || window == nullptr || data->window.load(std::memory_order_relaxed) != window)
 		{
 			return false;
 		}
@@ -114,14 +281,16 @@ namespace reshade
 		RAWINPUT raw_data = {};
 		UINT raw_data_size = sizeof(raw_data);
 
-		const auto input_lock = input_window->second.lock();
-		input &input = *input_lock;
+		// A single message results in at most a mouse move, a change to every mouse button and a wheel event
+		input_event events[8];
+		unsigned int num_events = 0;
+		const auto add_event = [&events, &num_events](input_event_type type, int32_t value) {
+			assert(num_events < ARRAYSIZE(events));
+			events[num_events++] = { type, value, 0, 0 };
+		};
 
 		// Calculate window client mouse position
-		ScreenToClient(static_cast<HWND>(input._window), &details.pt);
-
-		input._mouse_position[0] = details.pt.x;
-		input._mouse_position[1] = details.pt.y;
+		ScreenToClient(window, &details.pt);
 
 		switch (details.message)
 		{
@@ -137,96 +306,119 @@ namespace reshade
 					case RIM_TYPEMOUSE:
 						is_mouse_message = true;
 
-						if (raw_input_window != s_raw_input_windows.end() && (raw_input_window->second & 0x2) == 0)
+						if (lookup.is_raw_input_window && (lookup.raw_input_flags & 0x2) == 0)
 							break;
 
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN)
-							input._mouse_buttons[0] = 0x88;
+							add_event(input_event_type::mouse_button_down, 0);
 						else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP)
-							input._mouse_buttons[0] = 0x08;
+							add_event(input_event_type::mouse_button_up, 0);
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN)
-							input._mouse_buttons[1] = 0x88;
+							add_event(input_event_type::mouse_button_down, 1);
 						else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_UP)
-							input._mouse_buttons[1] = 0x08;
+							add_event(input_event_type::mouse_button_up, 1);
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN)
-							input._mouse_buttons[2] = 0x88;
+							add_event(input_event_type::mouse_button_down, 2);
 						else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_UP)
-							input._mouse_buttons[2] = 0x08;
+							add_event(input_event_type::mouse_button_up, 2);
 
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_4_DOWN)
-							input._mouse_buttons[3] = 0x88;
+							add_event(input_event_type::mouse_button_down, 3);
 						else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_4_UP)
-							input._mouse_buttons[3] = 0x08;
+							add_event(input_event_type::mouse_button_up, 3);
 
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_5_DOWN)
-							input._mouse_buttons[4] = 0x88;
+							add_event(input_event_type::mouse_button_down, 4);
 						else if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_BUTTON_5_UP)
-							input._mouse_buttons[4] = 0x08;
+							add_event(input_event_type::mouse_button_up, 4);
 
 						if (raw_data.data.mouse.usButtonFlags & RI_MOUSE_WHEEL)
-							input._mouse_wheel_delta += static_cast<short>(raw_data.data.mouse.usButtonData) / WHEEL_DELTA;
+							add_event(input_event_type::mouse_wheel, static_cast<short>(raw_data.data.mouse.usButtonData) / WHEEL_DELTA);
 						break;
 					case RIM_TYPEKEYBOARD:
 						is_keyboard_message = true;
 
-						if (raw_input_window != s_raw_input_windows.end() && (raw_input_window->second & 0x1) == 0)
+						if (lookup.is_raw_input_window && (lookup.raw_input_flags & 0x1) == 0)
 							break;
 
 						if (raw_data.data.keyboard.VKey != 0xFF)
-							input._keys[raw_data.data.keyboard.VKey] = (raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0 ? 0x88 : 0x08;
+							add_event((raw_data.data.keyboard.Flags & RI_KEY_BREAK) == 0 ? input_event_type::key_down : input_event_type::key_up, raw_data.data.keyboard.VKey);
 						break;
 				}
 				break;
 			case WM_CHAR:
-				input._text_input += static_cast<wchar_t>(details.wParam);
+				add_event(input_event_type::character, static_cast<wchar_t>(details.wParam));
 				break;
 			case WM_KEYDOWN:
 			case WM_SYSKEYDOWN:
-				input._keys[details.wParam] = 0x88;
+				add_event(input_event_type::key_down, static_cast<int32_t>(details.wParam));
 				break;
 			case WM_KEYUP:
 			case WM_SYSKEYUP:
-				input._keys[details.wParam] = 0x08;
+				add_event(input_event_type::key_up, static_cast<int32_t>(details.wParam));
 				break;
 			case WM_LBUTTONDOWN:
-				input._mouse_buttons[0] = 0x88;
+				add_event(input_event_type::mouse_button_down, 0);
 				break;
 			case WM_LBUTTONUP:
-				input._mouse_buttons[0] = 0x08;
+				add_event(input_event_type::mouse_button_up, 0);
 				break;
 			case WM_RBUTTONDOWN:
-				input._mouse_buttons[1] = 0x88;
+				add_event(input_event_type::mouse_button_down, 1);
 				break;
 			case WM_RBUTTONUP:
-				input._mouse_buttons[1] = 0x08;
+				add_event(input_event_type::mouse_button_up, 1);
 				break;
 			case WM_MBUTTONDOWN:
-				input._mouse_buttons[2] = 0x88;
+				add_event(input_event_type::mouse_button_down, 2);
 				break;
 			case WM_MBUTTONUP:
-				input._mouse_buttons[2] = 0x08;
+				add_event(input_event_type::mouse_button_up, 2);
 				break;
 			case WM_MOUSEWHEEL:
-				input._mouse_wheel_delta += GET_WHEEL_DELTA_WPARAM(details.wParam) / WHEEL_DELTA;
+				add_event(input_event_type::mouse_wheel, GET_WHEEL_DELTA_WPARAM(details.wParam) / WHEEL_DELTA);
 				break;
 			case WM_XBUTTONDOWN:
 				assert(HIWORD(details.wParam) < 3);
-				input._mouse_buttons[2 + HIWORD(details.wParam)] = 0x88;
+				add_event(input_event_type::mouse_button_down, 2 + HIWORD(details.wParam));
 				break;
 			case WM_XBUTTONUP:
 				assert(HIWORD(details.wParam) < 3);
-				input._mouse_buttons[2 + HIWORD(details.wParam)] = 0x08;
+				add_event(input_event_type::mouse_button_up, 2 + HIWORD(details.wParam));
 				break;
 		}
 
-		return (is_mouse_message && input._block_mouse) || (is_keyboard_message && input._block_keyboard);
+		while (data->producer_lock.test_and_set(std::memory_order_acquire))
+			continue;
+
+		// The entry may have been released and reused for another window since the lookup, in which case the events must not end up in its queue
+		if (data->window.load(std::memory_order_relaxed) != window)
+		{
+			data->producer_lock.clear(std::memory_order_release);
+			return false;
+		}
+
+		if (details.pt.x != data->last_mouse_position.x || details.pt.y != data->last_mouse_position.y)
+		{
+			data->last_mouse_position = details.pt;
+			data->queue.push({ input_event_type::mouse_move, 0, details.pt.x, details.pt.y });
+		}
+
+		for (unsigned int i = 0; i < num_events; i++)
+		{
+			data->queue.push(events[i]);
+		}
+
+		data->producer_lock.clear(std::memory_order_release);
+
+		return (is_mouse_message && data->block_mouse.load(std::memory_order_relaxed)) || (is_keyboard_message && data->block_keyboard.load(std::memory_order_relaxed));
 	}
 
 	bool input::is_key_down(unsigned int keycode) const
 	{
 		assert(keycode < 256);
 
-		return (_keys[keycode] & 0x80) == 0x80;
+		return (_state.keys[keycode] & 0x80) == 0x80;
 	}
 	bool input::is_key_down(unsigned int keycode, bool ctrl, bool shift, bool alt) const
 	{
@@ -236,7 +428,7 @@ namespace reshade
 	{
 		assert(keycode < 256);
 
-		return (_keys[keycode] & 0x88) == 0x88;
+		return (_state.keys[keycode] & 0x88) == 0x88;
 	}
 	bool input::is_key_pressed(unsigned int keycode, bool ctrl, bool shift, bool alt) const
 	{
@@ -246,7 +438,7 @@ namespace reshade
 	{
 		assert(keycode < 256);
 
-		return (_keys[keycode] & 0x88) == 0x08;
+		return (_state.keys[keycode] & 0x88) == 0x08;
 	}
 	bool input::is_any_key_down() const
 	{
@@ -296,19 +488,19 @@ namespace reshade
 	{
 		assert(button < 5);
 
-		return (_mouse_buttons[button] & 0x80) == 0x80;
+		return (_state.mouse_buttons[button] & 0x80) == 0x80;
 	}
 	bool input::is_mouse_button_pressed(unsigned int button) const
 	{
 		assert(button < 5);
 
-		return (_mouse_buttons[button] & 0x88) == 0x88;
+		return (_state.mouse_buttons[button] & 0x88) == 0x88;
 	}
 	bool input::is_mouse_button_released(unsigned int button) const
 	{
 		assert(button < 5);
 
-		return (_mouse_buttons[button] & 0x88) == 0x08;
+		return (_state.mouse_buttons[button] & 0x88) == 0x08;
 	}
 	bool input::is_any_mouse_button_down() const
 	{
@@ -351,6 +543,11 @@ namespace reshade
 	{
 		_block_mouse = enable;
 
+		if (_window_data != nullptr)
+		{
+			_window_data->block_mouse.store(enable, std::memory_order_relaxed);
+		}
+
 		if (enable)
 		{
 			ClipCursor(nullptr);
@@ -359,58 +556,57 @@ namespace reshade
 	void input::block_keyboard_input(bool enable)
 	{
 		_block_keyboard = enable;
+
+		if (_window_data != nullptr)
+		{
+			_window_data->block_keyboard.store(enable, std::memory_order_relaxed);
+		}
 	}
 
 	static inline bool is_blocking_mouse_input()
 	{
-		const auto predicate = [](auto input_window) {
-			return !input_window.second.expired() && input_window.second.lock()->is_blocking_mouse_input();
+		const auto predicate = [](const input_window &data) {
+			return data.window.load(std::memory_order_relaxed) != nullptr && data.block_mouse.load(std::memory_order_relaxed);
 		};
 
-		return std::any_of(reshade::s_windows.cbegin(), reshade::s_windows.cend(), predicate);
+		return reshade::find_input_window_if(predicate) != nullptr;
 	}
 	static inline bool is_blocking_keyboard_input()
 	{
-		const auto predicate = [](auto input_window) {
-			return !input_window.second.expired() && input_window.second.lock()->is_blocking_keyboard_input();
+		const auto predicate = [](const input_window &data) {
+			return data.window.load(std::memory_order_relaxed) != nullptr && data.block_keyboard.load(std::memory_order_relaxed);
 		};
 
-		return std::any_of(reshade::s_windows.cbegin(), reshade::s_windows.cend(), predicate);
+		return reshade::find_input_window_if(predicate) != nullptr;
 	}
 
 	void input::next_frame()
 	{
-		_frame_count++;
+		_state.next_frame();
 
-		for (auto &state : _keys)
+		// Fold all events received since the last frame into the state
+		if (_window_data != nullptr)
 		{
-			state &= ~0x8;
-		}
-		for (auto &state : _mouse_buttons)
-		{
-			state &= ~0x8;
-		}
+			_state.apply(_window_data->queue);
 
-		_text_input.clear();
-		_mouse_wheel_delta = 0;
-		_last_mouse_position[0] = _mouse_position[0];
-		_last_mouse_position[1] = _mouse_position[1];
+			_window_data->frame_count.fetch_add(1, std::memory_order_relaxed);
+		}
 
 		// Update caps lock state
-		_keys[VK_CAPITAL] |= GetKeyState(VK_CAPITAL) & 0x1;
+		_state.keys[VK_CAPITAL] |= GetKeyState(VK_CAPITAL) & 0x1;
 
 		// Update modifier key state
-		if ((_keys[VK_MENU] & 0x88) != 0 &&
+		if ((_state.keys[VK_MENU] & 0x88) != 0 &&
 			(GetKeyState(VK_MENU) & 0x8000) == 0)
 		{
-			_keys[VK_MENU] = 0x08;
+			_state.keys[VK_MENU] = 0x08;
 		}
 
 		// Update print screen state
-		if ((_keys[VK_SNAPSHOT] & 0x80) == 0 &&
+		if ((_state.keys[VK_SNAPSHOT] & 0x80) == 0 &&
 			(GetAsyncKeyState(VK_SNAPSHOT) & 0x8000) != 0)
 		{
-			_keys[VK_SNAPSHOT] = 0x88;
+			_state.keys[VK_SNAPSHOT] = 0x88;
 		}
 	}
 }
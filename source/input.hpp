@@ -5,17 +5,20 @@
 
 #pragma once
 
+#include "input_queue.hpp"
 #include <memory>
-#include <string>
 
 namespace reshade
 {
+	struct input_window;
+
 	class input
 	{
 	public:
 		using window_handle = void *;
 
 		explicit input(window_handle window);
+		~input();
 
 		static void register_window_with_raw_input(window_handle window, bool no_legacy_keyboard, bool no_legacy_mouse);
 		static std::shared_ptr<input> register_window(window_handle window);
@@ -37,12 +40,12 @@ namespace reshade
 		bool is_any_mouse_button_down() const;
 		bool is_any_mouse_button_pressed() const;
 		bool is_any_mouse_button_released() const;
-		short mouse_wheel_delta() const { return _mouse_wheel_delta; }
-		int mouse_movement_delta_x() const { return _mouse_position[0] - _last_mouse_position[0]; }
-		int mouse_movement_delta_y() const { return _mouse_position[1] - _last_mouse_position[1]; }
-		unsigned int mouse_position_x() const { return _mouse_position[0]; }
-		unsigned int mouse_position_y() const { return _mouse_position[1]; }
-		const std::wstring &text_input() const { return _text_input; }
+		short mouse_wheel_delta() const { return _state.mouse_wheel_delta; }
+		int mouse_movement_delta_x() const { return _state.mouse_position[0] - _state.last_mouse_position[0]; }
+		int mouse_movement_delta_y() const { return _state.mouse_position[1] - _state.last_mouse_position[1]; }
+		unsigned int mouse_position_x() const { return _state.mouse_position[0]; }
+		unsigned int mouse_position_y() const { return _state.mouse_position[1]; }
+		const std::wstring &text_input() const { return _state.text_input; }
 
 		void block_mouse_input(bool enable);
 		void block_keyboard_input(bool enable);
@@ -50,18 +53,21 @@ namespace reshade
 		bool is_blocking_mouse_input() const { return _block_mouse; }
 		bool is_blocking_keyboard_input() const { return _block_keyboard; }
 
+		/// <summary>
+		/// Apply all input events received since the last call and reset the state that only applies to a single frame.
+		/// </summary>
 		void next_frame();
 
+		/// <summary>
+		/// Queue the input events contained in a window message. This is called for every message the application retrieves, so it does not take any locks in the common case.
+		/// </summary>
+		/// <returns><c>true</c> if the message should be hidden from the application, <c>false</c> otherwise.</returns>
 		static bool handle_window_message(const void *message_data);
 
 	private:
 		window_handle _window;
+		input_window *_window_data = nullptr;
 		bool _block_mouse = false, _block_keyboard = false;
-		uint8_t _keys[256] = { }, _mouse_buttons[5] = { };
-		short _mouse_wheel_delta = 0;
-		unsigned int _mouse_position[2] = { };
-		unsigned int _last_mouse_position[2] = { };
-		uint64_t _frame_count = 0;
-		std::wstring _text_input;
+		input_state _state;
 	};
 }
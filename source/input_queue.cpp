@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "input_queue.hpp"
+
+namespace reshade
+{
+	static_assert((input_event_queue::capacity & (input_event_queue::capacity - 1)) == 0, "queue capacity has to be a power of two");
+
+	bool input_event_queue::push(const input_event &event)
+	{
+		const uint32_t tail = _tail.load(std::memory_order_relaxed);
+
+		if (tail - _head.load(std::memory_order_acquire) == capacity)
+		{
+			_overflow.store(true, std::memory_order_relaxed);
+
+			return false;
+		}
+
+		_events[tail & (capacity - 1)] = event;
+
+		// Publish the event to the consuming thread
+		_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+	bool input_event_queue::pop(input_event &event)
+	{
+		const uint32_t head = _head.load(std::memory_order_relaxed);
+
+		if (head == _tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		event = _events[head & (capacity - 1)];
+
+		// Hand the slot back to the producing thread
+		_head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+	void input_event_queue::clear()
+	{
+		_head.store(_tail.load(std::memory_order_acquire), std::memory_order_release);
+		_overflow.store(false, std::memory_order_relaxed);
+	}
+
+	bool input_event_queue::check_and_reset_overflow()
+	{
+		return _overflow.exchange(false, std::memory_order_relaxed);
+	}
+
+	void input_state::next_frame()
+	{
+		for (auto &state : keys)
+		{
+			state &= ~0x8;
+		}
+		for (auto &state : mouse_buttons)
+		{
+			state &= ~0x8;
+		}
+
+		text_input.clear();
+		mouse_wheel_delta = 0;
+		last_mouse_position[0] = mouse_position[0];
+		last_mouse_position[1] = mouse_position[1];
+	}
+
+	void input_state::apply(const input_event &event)
+	{
+		switch (event.type)
+		{
+			case input_event_type::key_down:
+				if (event.value >= 0 && event.value < 256)
+					keys[event.value] = 0x88;
+				break;
+			case input_event_type::key_up:
+				if (event.value >= 0 && event.value < 256)
+					keys[event.value] = 0x08;
+				break;
+			case input_event_type::mouse_button_down:
+				if (event.value >= 0 && event.value < 5)
+					mouse_buttons[event.value] = 0x88;
+				break;
+			case input_event_type::mouse_button_up:
+				if (event.value >= 0 && event.value < 5)
+					mouse_buttons[event.value] = 0x08;
+				break;
+			case input_event_type::mouse_wheel:
+				mouse_wheel_delta += static_cast<short>(event.value);
+				break;
+			case input_event_type::mouse_move:
+				mouse_position[0] = event.x;
+				mouse_position[1] = event.y;
+				break;
+			case input_event_type::character:
+				text_input += static_cast<wchar_t>(event.value);
+				break;
+		}
+	}
+	void input_state::apply(input_event_queue &queue)
+	{
+		// Check before popping, so that an overflow which happens while popping is handled in the next frame, after the dropped events would have been applied
+		const bool overflow = queue.check_and_reset_overflow();
+
+		for (input_event event; queue.pop(event);)
+		{
+			apply(event);
+		}
+
+		if (overflow)
+		{
+			for (auto &state : keys)
+			{
+				if (state & 0x80)
+					state = 0x08;
+			}
+			for (auto &state : mouse_buttons)
+			{
+				if (state & 0x80)
+					state = 0x08;
+			}
+		}
+	}
+}
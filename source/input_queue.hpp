@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace reshade
+{
+	enum class input_event_type : uint8_t
+	{
+		key_down,
+		key_up,
+		mouse_button_down,
+		mouse_button_up,
+		mouse_wheel,
+		mouse_move,
+		character,
+	};
+
+	/// <summary>
+	/// A single input event, as extracted from a window message.
+	/// </summary>
+	struct input_event
+	{
+		input_event_type type;
+		/// <summary>
+		/// The virtual key code, mouse button index, wheel delta in notches or character, depending on the event type.
+		/// </summary>
+		int32_t value;
+		/// <summary>
+		/// The mouse position in client coordinates for mouse move events.
+		/// </summary>
+		int32_t x, y;
+	};
+
+	/// <summary>
+	/// A fixed size ring buffer of input events, with a single thread pushing events and a single thread popping them.
+	/// </summary>
+	class input_event_queue
+	{
+	public:
+		static constexpr uint32_t capacity = 1024;
+
+		/// <summary>
+		/// Append an event to the queue. Must only be called from the producing thread.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if the queue is full and the event was dropped.</returns>
+		bool push(const input_event &event);
+		/// <summary>
+		/// Remove the oldest event from the queue. Must only be called from the consuming thread.
+		/// </summary>
+		/// <returns><c>true</c> if an event was removed, <c>false</c> if the queue is empty.</returns>
+		bool pop(input_event &event);
+		/// <summary>
+		/// Discard all events currently in the queue. Must only be called from the consuming thread.
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Returns whether any events were dropped since the last call and resets that state. Must only be called from the consuming thread.
+		/// </summary>
+		bool check_and_reset_overflow();
+
+	private:
+		// Both indices increase monotonically and wrap around at the integer limit, which works because the capacity is a power of two
+		alignas(64) std::atomic<uint32_t> _head = 0;
+		alignas(64) std::atomic<uint32_t> _tail = 0;
+		std::atomic<bool> _overflow = false;
+		input_event _events[capacity];
+	};
+
+	/// <summary>
+	/// The keyboard and mouse state of a window. Bit 0x80 of a key or mouse button state means it is down and bit 0x08 means it changed this frame.
+	/// </summary>
+	struct input_state
+	{
+		uint8_t keys[256] = { }, mouse_buttons[5] = { };
+		short mouse_wheel_delta = 0;
+		unsigned int mouse_position[2] = { };
+		unsigned int last_mouse_position[2] = { };
+		std::wstring text_input;
+
+		/// <summary>
+		/// Reset all state that only applies to a single frame.
+		/// </summary>
+		void next_frame();
+
+		/// <summary>
+		/// Update the state with a single event.
+		/// </summary>
+		void apply(const input_event &event);
+		/// <summary>
+		/// Update the state with all events in a queue, in the order they were pushed. If the queue overflowed, all keys and mouse buttons are released, so that none get stuck because their release event was dropped.
+		/// </summary>
+		void apply(input_event_queue &queue);
+	};
+}
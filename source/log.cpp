@@ -5,72 +5,311 @@
 
 #include "log.hpp"
 #include <mutex>
-#include <assert.h>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <utf8/unchecked.h>
 #include <Windows.h>
 
 namespace reshade::log
 {
-	std::ofstream stream;
-	std::ostringstream linestream;
-	std::vector<std::string> lines;
-	static std::mutex s_mutex;
+	line_buffer lines(4096);
+	static std::ofstream s_stream;
+	static record_queue s_queue;
+	static std::mutex s_writer_mutex;
+	// Thread currently holding 's_writer_mutex', so that a crash while writing does not wait for itself
+	static std::atomic<DWORD> s_writer_owner = 0;
+	static HANDLE s_writer_thread = nullptr;
+	static HANDLE s_writer_event = nullptr;
+	static HANDLE s_writer_stopped_event = nullptr;
+	static std::atomic<bool> s_writer_stop = false;
+	static std::atomic<unsigned int> s_flush_interval = 500;
+	static LPTOP_LEVEL_EXCEPTION_FILTER s_previous_exception_filter = nullptr;
+	static thread_local std::ostringstream t_stream;
+	static thread_local bool t_stream_in_use = false;
 
-	message::message(level level)
+	// The writer thread may have been terminated while holding the lock during process exit, so do not wait for it forever
+	static bool try_lock_writer(unsigned int max_attempts)
 	{
-		SYSTEMTIME time;
-		GetLocalTime(&time);
+		if (s_writer_owner.load(std::memory_order_relaxed) == GetCurrentThreadId())
+		{
+			return false;
+		}
 
-		const char level_names[][6] = { "ERROR", "WARN ", "INFO ", "DEBUG" };
-		assert(static_cast<unsigned int>(level) - 1 < _countof(level_names));
+		for (unsigned int attempt = 0; !s_writer_mutex.try_lock(); attempt++)
+		{
+			if (attempt >= max_attempts)
+			{
+				return false;
+			}
 
-		// Lock the stream until the message is complete
-		s_mutex.lock();
+			Sleep(1);
+		}
 
-		// Start a new line
-		linestream.str("");
-		linestream.clear();
+		s_writer_owner.store(GetCurrentThreadId(), std::memory_order_relaxed);
+		return true;
+	}
+	static void lock_writer()
+	{
+		s_writer_mutex.lock();
+		s_writer_owner.store(GetCurrentThreadId(), std::memory_order_relaxed);
+	}
+	static void unlock_writer()
+	{
+		s_writer_owner.store(0, std::memory_order_relaxed);
+		s_writer_mutex.unlock();
+	}
+
+	// Write the prefix of a line in the log file into a fixed buffer and return its length
+	static int format_prefix(char (&prefix)[64], uint64_t timestamp, DWORD thread_id, level level)
+	{
+		FILETIME utc_time, local_time;
+		utc_time.dwLowDateTime = static_cast<DWORD>(timestamp);
+		utc_time.dwHighDateTime = static_cast<DWORD>(timestamp >> 32);
+		SYSTEMTIME time = {};
+		FileTimeToLocalFileTime(&utc_time, &local_time);
+		FileTimeToSystemTime(&local_time, &time);
 
-		stream << std::right << std::setfill('0')
 #if RESHADE_VERBOSE_LOG
-			<< std::setw(4) << time.wYear << '-'
-			<< std::setw(2) << time.wMonth << '-'
-			<< std::setw(2) << time.wDay << 'T'
+		return sprintf_s(prefix, "%04u-%02u-%02uT%02u:%02u:%02u:%03u [%05lu] | %s | ",
+			time.wYear, time.wMonth, time.wDay,
+#else
+		return sprintf_s(prefix, "%02u:%02u:%02u:%03u [%05lu] | %s | ",
 #endif
-			<< std::setw(2) << time.wHour << ':'
-			<< std::setw(2) << time.wMinute << ':'
-			<< std::setw(2) << time.wSecond << ':'
-			<< std::setw(3) << time.wMilliseconds << ' '
-			<< '[' << std::setw(5) << GetCurrentThreadId() << ']' << std::setfill(' ')
-			<< " | "
-			<< level_names[static_cast<unsigned int>(level) - 1] << " | " << std::left;
-		linestream
-			<< level_names[static_cast<unsigned int>(level) - 1] << " | ";
+			time.wHour, time.wMinute, time.wSecond, time.wMilliseconds, thread_id, level_name(level));
+	}
+
+	// Write all queued records to the log file. Must be called while holding 's_writer_mutex'.
+	// This does not allocate, since it also runs after a crash: records are read in place and the file stream buffers the output.
+	static void write_queued_records(bool force_flush)
+	{
+		bool flush = force_flush || s_flush_interval.load(std::memory_order_relaxed) == 0;
+
+		for (const record *record; (record = s_queue.front()) != nullptr; s_queue.pop_front())
+		{
+			char prefix[64];
+			const int prefix_length = format_prefix(prefix, record->time, record->thread_id, record->level);
+
+			s_stream.write(prefix, std::max(prefix_length, 0));
+			s_stream.write(record->text.data(), record->text.size());
+			s_stream.put('\n');
+
+			flush |= record->level == level::error;
+
+			lines.push_back(record->level, record->text);
+		}
+
+		if (flush)
+		{
+			s_stream.flush();
+		}
+	}
+
+	static DWORD WINAPI writer_thread_main(LPVOID)
+	{
+		while (!s_writer_stop.load(std::memory_order_relaxed))
+		{
+			const unsigned int interval = s_flush_interval.load(std::memory_order_relaxed);
+
+			// Wait until a producer asks for the queue to be written or the flush interval elapsed
+			WaitForSingleObject(s_writer_event, interval != 0 ? interval : INFINITE);
+
+			lock_writer();
+
+			// Always flush here, since this is only reached after an error, when the queue filled up or when the interval elapsed
+			write_queued_records(true);
+
+			unlock_writer();
+		}
+
+		SetEvent(s_writer_stopped_event);
+
+		// Exit right away instead of returning, since the module may be unloaded as soon as the event is signaled
+		ExitThread(0);
+	}
+
+	static LONG WINAPI unhandled_exception_filter(EXCEPTION_POINTERS *exception_info)
+	{
+		// Make sure all messages leading up to the crash end up in the log file, followed by where it crashed
+		// The heap may be corrupted at this point, so everything here works on fixed buffers and does not wait long for other threads
+		if (try_lock_writer(10))
+		{
+			write_queued_records(false);
+
+			FILETIME time;
+			GetSystemTimeAsFileTime(&time);
+
+			char prefix[64];
+			const int prefix_length = format_prefix(prefix, (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime, GetCurrentThreadId(), level::error);
+			char message[128];
+			const int message_length = sprintf_s(message, "Unhandled exception 0x%08lX at address %p.\n",
+				exception_info->ExceptionRecord->ExceptionCode, exception_info->ExceptionRecord->ExceptionAddress);
+
+			s_stream.write(prefix, std::max(prefix_length, 0));
+			s_stream.write(message, std::max(message_length, 0));
+			s_stream.flush();
+
+			unlock_writer();
+		}
+
+		return s_previous_exception_filter != nullptr ? s_previous_exception_filter(exception_info) : EXCEPTION_CONTINUE_SEARCH;
+	}
+
+	message::message(level level) : _level(level)
+	{
+		FILETIME time;
+		GetSystemTimeAsFileTime(&time);
+		_time = (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+
+		// Format into the staging stream of this thread, unless a message is logged while formatting another one
+		if (!t_stream_in_use)
+		{
+			t_stream_in_use = true;
+			_stream = &t_stream;
+		}
+		else
+		{
+			_nested_stream = std::make_unique<std::ostringstream>();
+			_stream = _nested_stream.get();
+		}
+
+		_stream->str(std::string());
+		_stream->clear();
+		_stream->flags(std::ios_base::showbase | std::ios_base::left | std::ios_base::dec);
+		_stream->fill(' ');
 	}
 	message::~message()
 	{
-		// Finish the line
-		stream << std::endl;
-		linestream << std::endl;
+		record record = { _level, _time, GetCurrentThreadId(), _stream->str() };
 
-		lines.push_back(linestream.str());
+		if (_stream == &t_stream)
+		{
+			t_stream_in_use = false;
+		}
 
-		// The message is finished, we can unlock the stream
-		s_mutex.unlock();
+		bool wake_writer = _level == level::error || s_flush_interval.load(std::memory_order_relaxed) == 0;
+
+		while (!try_enqueue(record))
+		{
+			// The queue is full, so help the writer thread empty it. This also keeps logging working before that thread started running, e.g. while the loader lock is held.
+			if (try_lock_writer(0))
+			{
+				write_queued_records(false);
+				unlock_writer();
+			}
+			else
+			{
+				Sleep(0);
+			}
+
+			wake_writer = false;
+		}
+
+		// Wake up the writer early when the queue is getting full
+		if (!wake_writer)
+		{
+			wake_writer = s_queue.size() >= record_queue::capacity / 2;
+		}
+
+		if (wake_writer && s_writer_event != nullptr)
+		{
+			SetEvent(s_writer_event);
+		}
+	}
+
+	message &message::operator<<(const std::wstring &message)
+	{
+		static_assert(sizeof(std::wstring::value_type) == sizeof(uint16_t), "expected 'std::wstring' to use UTF-16 encoding");
+		std::string utf8_message;
+		utf8_message.reserve(message.size());
+		utf8::unchecked::utf16to8(message.begin(), message.end(), std::back_inserter(utf8_message));
+		return operator<<(utf8_message);
+	}
+	message &message::operator<<(const wchar_t *message)
+	{
+		static_assert(sizeof(wchar_t) == sizeof(uint16_t), "expected 'wchar_t' to use UTF-16 encoding");
+		std::string utf8_message;
+		utf8::unchecked::utf16to8(message, message + wcslen(message), std::back_inserter(utf8_message));
+		return operator<<(utf8_message);
 	}
 
 	bool open(const filesystem::path &path)
 	{
-		stream.open(path.wstring(), std::ios::out | std::ios::trunc);
+		const std::lock_guard<std::mutex> lock(s_writer_mutex);
 
-		if (!stream.is_open())
+		s_stream.open(path.wstring(), std::ios::out | std::ios::trunc);
+
+		if (!s_stream.is_open())
 		{
 			return false;
 		}
 
-		stream.setf(std::ios_base::showbase);
+		s_stream.flush();
+
+		if (s_writer_thread == nullptr)
+		{
+			s_writer_stop.store(false, std::memory_order_relaxed);
+			s_writer_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+			s_writer_stopped_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+			// Use a native thread, since this is called from 'DllMain', where the thread only starts running once the loader lock is released
+			s_writer_thread = CreateThread(nullptr, 0, &writer_thread_main, nullptr, 0, nullptr);
 
-		stream.flush();
+			s_previous_exception_filter = SetUnhandledExceptionFilter(&unhandled_exception_filter);
+		}
 
 		return true;
 	}
+	void flush()
+	{
+		if (!try_lock_writer(100))
+		{
+			return;
+		}
+
+		write_queued_records(true);
+
+		unlock_writer();
+	}
+	void close()
+	{
+		if (s_writer_thread != nullptr)
+		{
+			// The thread is already gone if the process is exiting
+			if (WaitForSingleObject(s_writer_thread, 0) == WAIT_TIMEOUT)
+			{
+				s_writer_stop.store(true, std::memory_order_relaxed);
+				SetEvent(s_writer_event);
+
+				// Cannot wait for the thread itself, since that would deadlock on the loader lock when called from 'DllMain'
+				WaitForSingleObject(s_writer_stopped_event, 1000);
+			}
+
+			SetUnhandledExceptionFilter(s_previous_exception_filter);
+
+			CloseHandle(s_writer_thread);
+			CloseHandle(s_writer_event);
+			CloseHandle(s_writer_stopped_event);
+			s_writer_thread = s_writer_event = s_writer_stopped_event = nullptr;
+		}
+
+		flush();
+
+		const std::lock_guard<std::mutex> lock(s_writer_mutex);
+
+		s_stream.close();
+	}
+
+	unsigned int flush_interval()
+	{
+		return s_flush_interval.load(std::memory_order_relaxed);
+	}
+	void set_flush_interval(unsigned int milliseconds)
+	{
+		s_flush_interval.store(milliseconds, std::memory_order_relaxed);
+
+		if (s_writer_event != nullptr)
+		{
+			SetEvent(s_writer_event);
+		}
+	}
 }
@@ -5,10 +5,10 @@
 
 #pragma once
 
-#include <fstream>
+#include <memory>
 #include <iomanip>
 #include <sstream>
-#include <utf8/unchecked.h>
+#include "log_queue.hpp"
 #include "filesystem.hpp"
 
 #define LOG(LEVEL) LOG_##LEVEL()
@@ -19,17 +19,10 @@
 
 namespace reshade::log
 {
-	enum class level
-	{
-		info = 3,
-		error = 1,
-		warning = 2,
-		debug = 4,
-	};
-
-	extern std::ofstream stream;
-	extern std::ostringstream linestream;
-	extern std::vector<std::string> lines;
+	/// <summary>
+	/// The most recent lines that were written to the log, e.g. to show them in the overlay.
+	/// </summary>
+	extern line_buffer lines;
 
 	struct message
 	{
@@ -39,39 +32,48 @@ namespace reshade::log
 		template <typename T>
 		inline message &operator<<(const T &value)
 		{
-			stream << value;
-			linestream << value;
+			*_stream << value;
 			return *this;
 		}
 
-		template <>
-		inline message &operator<<(const std::wstring &message)
-		{
-			static_assert(sizeof(std::wstring::value_type) == sizeof(uint16_t), "expected 'std::wstring' to use UTF-16 encoding");
-			std::string utf8_message;
-			utf8_message.reserve(message.size());
-			utf8::unchecked::utf16to8(message.begin(), message.end(), std::back_inserter(utf8_message));
-			return operator<<(utf8_message);
-		}
-
 		inline message &operator<<(const char *message)
 		{
-			stream << message;
-			linestream << message;
+			*_stream << message;
 			return *this;
 		}
-		inline message &operator<<(const wchar_t *message)
-		{
-			static_assert(sizeof(wchar_t) == sizeof(uint16_t), "expected 'wchar_t' to use UTF-16 encoding");
-			std::string utf8_message;
-			utf8::unchecked::utf16to8(message, message + wcslen(message), std::back_inserter(utf8_message));
-			return operator<<(utf8_message);
-		}
+
+		// Wide strings are converted to UTF-8
+		message &operator<<(const std::wstring &message);
+		message &operator<<(const wchar_t *message);
+
+	private:
+		level _level;
+		uint64_t _time;
+		// Points to the staging stream of the calling thread, or to '_nested_stream' if that is already in use by an outer message
+		std::ostringstream *_stream;
+		std::unique_ptr<std::ostringstream> _nested_stream;
 	};
 
 	/// <summary>
-	/// Open a log file for writing.
+	/// Open a log file for writing and start the background thread which writes queued messages to it.
 	/// </summary>
 	/// <param name="path">The path to the log file.</param>
 	bool open(const filesystem::path &path);
+	/// <summary>
+	/// Write all queued messages to the log file and flush it to disk. This happens automatically after errors and when the application crashes.
+	/// </summary>
+	void flush();
+	/// <summary>
+	/// Stop the background thread, write all queued messages and close the log file.
+	/// </summary>
+	void close();
+
+	/// <summary>
+	/// Returns the interval at which queued messages are written and flushed to the log file, in milliseconds.
+	/// </summary>
+	unsigned int flush_interval();
+	/// <summary>
+	/// Set the interval at which queued messages are written and flushed to the log file, in milliseconds. Zero writes every message as soon as possible.
+	/// </summary>
+	void set_flush_interval(unsigned int milliseconds);
 }
@@ -0,0 +1,254 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "log_queue.hpp"
+#include <cstring>
+#include <iterator>
+#include <assert.h>
+
+namespace reshade::log
+{
+	static_assert((record_queue::capacity & (record_queue::capacity - 1)) == 0, "queue capacity has to be a power of two");
+
+	static const char level_names[][6] = { "ERROR", "WARN ", "INFO ", "DEBUG" };
+
+	const char *level_name(level level)
+	{
+		assert(static_cast<unsigned int>(level) - 1 < std::size(level_names));
+
+		return level_names[static_cast<unsigned int>(level) - 1];
+	}
+
+	bool record_queue::try_enqueue(record &record)
+	{
+		size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+
+		for (entry *entry;;)
+		{
+			entry = &_entries[pos & (capacity - 1)];
+
+			const size_t lap = pos & ~(capacity - 1);
+			const size_t sequence = entry->sequence.load(std::memory_order_acquire);
+			const intptr_t difference = static_cast<intptr_t>(sequence - lap);
+
+			if (difference == 0)
+			{
+				// The entry is free, so try to claim it
+				if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					// This frees the text of the record that was in this entry during the previous lap, so the consumer never has to
+					entry->record = std::move(record);
+					// Hand the entry over to the consumer
+					entry->sequence.store(lap + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer did not yet free this entry, so the queue is full
+				return false;
+			}
+			else
+			{
+				// Another producer claimed this entry first
+				pos = _enqueue_pos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	const record *record_queue::front() const
+	{
+		const size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+		const entry &entry = _entries[pos & (capacity - 1)];
+
+		const size_t lap = pos & ~(capacity - 1);
+
+		if (entry.sequence.load(std::memory_order_acquire) != lap + 1)
+		{
+			// The next entry was not published yet
+			return nullptr;
+		}
+
+		return &entry.record;
+	}
+	void record_queue::pop_front()
+	{
+		const size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+		entry &entry = _entries[pos & (capacity - 1)];
+
+		const size_t lap = pos & ~(capacity - 1);
+		assert(entry.sequence.load(std::memory_order_relaxed) == lap + 1);
+
+		// Hand the entry back to the producers
+		entry.sequence.store(lap + capacity, std::memory_order_release);
+
+		_dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+	}
+
+	size_t record_queue::size() const
+	{
+		return _enqueue_pos.load(std::memory_order_relaxed) - _dequeue_pos.load(std::memory_order_relaxed);
+	}
+
+	line_buffer::line_buffer(size_t capacity) : _capacity(capacity), _slots(new slot[capacity])
+	{
+		assert(capacity != 0);
+
+		for (size_t i = 0; i < capacity; i++)
+		{
+			// No line has index zero minus one, so this marks the slot as empty
+			_slots[i].sequence.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void line_buffer::clear()
+	{
+		uint64_t clear_index = _clear_index.load(std::memory_order_relaxed);
+		const uint64_t end_index = _end_index.load(std::memory_order_acquire);
+
+		// Never move the start backwards when another thread cleared concurrently
+		while (clear_index < end_index && !_clear_index.compare_exchange_weak(clear_index, end_index, std::memory_order_release, std::memory_order_relaxed))
+			continue;
+	}
+	void line_buffer::push_back(level level, const std::string &message)
+	{
+		const char *const name = level_name(level);
+		const size_t name_length = std::strlen(name);
+
+		uint64_t index = _end_index.load(std::memory_order_relaxed);
+
+		for (size_t offset = 0;; index++)
+		{
+			const size_t next = std::min(message.find('\n', offset), message.size());
+
+			slot &slot = _slots[index % _capacity];
+
+			// Mark the slot as being written, so that readers of the line it held before discard what they copied
+			slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			char text[max_line_length];
+			size_t length = 0;
+			const auto append = [&text, &length](const char *data, size_t size) {
+				size = std::min(size, max_line_length - length);
+				std::memcpy(text + length, data, size);
+				length += size;
+			};
+			append(name, name_length);
+			append(" | ", 3);
+			append(message.data() + offset, next - offset);
+			std::memset(text + length, 0, sizeof(text) - length);
+
+			for (size_t i = 0; i < words_per_line && i * sizeof(uint64_t) < length; i++)
+			{
+				uint64_t word;
+				std::memcpy(&word, text + i * sizeof(uint64_t), sizeof(word));
+				slot.text[i].store(word, std::memory_order_relaxed);
+			}
+
+			slot.level.store(static_cast<uint32_t>(level), std::memory_order_relaxed);
+			slot.length.store(static_cast<uint32_t>(length), std::memory_order_relaxed);
+
+			for (size_t i = 0; i < num_levels; i++)
+			{
+				slot.level_counts_before[i].store(_level_counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+
+			slot.sequence.store(index * 2 + 2, std::memory_order_release);
+
+			_level_counts[static_cast<unsigned int>(level)].fetch_add(1, std::memory_order_relaxed);
+
+			// Publish the line only after it is complete, so readers never see a slot that was not written yet
+			_end_index.store(index + 1, std::memory_order_release);
+
+			// Stop at the end, ignoring the empty line after a trailing line break
+			if (next + 1 >= message.size())
+			{
+				break;
+			}
+
+			offset = next + 1;
+		}
+	}
+
+	uint64_t line_buffer::begin_index() const
+	{
+		const uint64_t end_index = _end_index.load(std::memory_order_acquire);
+
+		return std::max(_clear_index.load(std::memory_order_acquire), end_index >= _capacity ? end_index - _capacity : 0);
+	}
+	uint64_t line_buffer::end_index() const
+	{
+		return _end_index.load(std::memory_order_acquire);
+	}
+	size_t line_buffer::count(level level) const
+	{
+		for (uint64_t count_before;;)
+		{
+			const uint64_t begin_index = this->begin_index();
+			const uint64_t end_index = this->end_index();
+
+			if (begin_index >= end_index)
+			{
+				return 0;
+			}
+
+			// Load the total after the end index, so that it includes at least all lines up to there
+			const uint64_t total = _level_counts[static_cast<unsigned int>(level)].load(std::memory_order_relaxed);
+
+			// Try again with the new oldest line if this one was replaced in the meantime
+			if (read_level_count_before(begin_index, level, count_before))
+			{
+				return static_cast<size_t>(total - count_before);
+			}
+		}
+	}
+
+	bool line_buffer::read(uint64_t index, line &line) const
+	{
+		const slot &slot = _slots[index % _capacity];
+
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != index * 2 + 2)
+		{
+			return false;
+		}
+
+		const uint32_t length = std::min<uint32_t>(slot.length.load(std::memory_order_relaxed), max_line_length);
+		const uint32_t level = slot.level.load(std::memory_order_relaxed);
+
+		uint64_t text[words_per_line];
+		for (size_t i = 0; i < words_per_line && i * sizeof(uint64_t) < length; i++)
+		{
+			text[i] = slot.text[i].load(std::memory_order_relaxed);
+		}
+
+		// Check that the writer did not start replacing the line while it was copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+		{
+			return false;
+		}
+
+		line.level = static_cast<log::level>(level);
+		line.text.assign(reinterpret_cast<const char *>(text), length);
+		return true;
+	}
+	bool line_buffer::read_level_count_before(uint64_t index, level level, uint64_t &count) const
+	{
+		const slot &slot = _slots[index % _capacity];
+
+		const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence != index * 2 + 2)
+		{
+			return false;
+		}
+
+		count = slot.level_counts_before[static_cast<unsigned int>(level)].load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == sequence;
+	}
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+namespace reshade::log
+{
+	enum class level
+	{
+		info = 3,
+		error = 1,
+		warning = 2,
+		debug = 4,
+	};
+
+	/// <summary>
+	/// Returns the name of a level as it appears in front of every line, padded to the same length for all levels.
+	/// </summary>
+	const char *level_name(level level);
+
+	/// <summary>
+	/// A message which was finished on the calling thread and is waiting to be written.
+	/// </summary>
+	struct record
+	{
+		log::level level;
+		uint64_t time;
+		uint32_t thread_id;
+		std::string text;
+	};
+
+	/// <summary>
+	/// A bounded queue of records with any number of threads adding records and a single thread removing them, which never blocks.
+	/// A zero initialized queue is valid, so records can be added before anything was set up.
+	/// </summary>
+	class record_queue
+	{
+	public:
+		static constexpr size_t capacity = 4096;
+
+		/// <summary>
+		/// Append a record to the queue. Can be called from any thread.
+		/// </summary>
+		/// <param name="record">The record to add. It is moved into the queue on success and left as is otherwise.</param>
+		/// <returns><c>true</c> on success, <c>false</c> if the queue is full.</returns>
+		bool try_enqueue(record &record);
+
+		/// <summary>
+		/// Returns the oldest record in the queue, or <c>nullptr</c> if it is empty. Must only be called from the consuming thread.
+		/// The record stays valid until <see cref="pop_front"/> is called.
+		/// </summary>
+		const record *front() const;
+		/// <summary>
+		/// Remove the oldest record from the queue. This does not free its text, so it is also safe to call after a crash. Must only be called from the consuming thread.
+		/// </summary>
+		void pop_front();
+
+		/// <summary>
+		/// Returns the number of records added but not yet removed. This is only a snapshot when other threads add records at the same time.
+		/// </summary>
+		size_t size() const;
+
+	private:
+		// Entry of the queue. The sequence number is relative to the start of the lap around the queue a position belongs to: zero means the entry is free, one means it holds a record and the queue capacity means it was freed for the next lap.
+		struct entry
+		{
+			std::atomic<size_t> sequence;
+			log::record record;
+		};
+
+		std::atomic<size_t> _enqueue_pos;
+		// Only modified by the consuming thread
+		std::atomic<size_t> _dequeue_pos;
+		entry _entries[capacity];
+	};
+
+	/// <summary>
+	/// A single line of a log message.
+	/// </summary>
+	struct line
+	{
+		log::level level;
+		std::string text;
+	};
+
+	/// <summary>
+	/// A bounded list of the most recent log lines, which drops the oldest line when full.
+	/// Lines are numbered in the order they were added, so the index of a line stays the same until it is dropped. This lets viewers update their state incrementally.
+	/// Lines are stored in fixed size slots, which readers copy out without ever blocking the writer. A reader skips a line that is replaced while it is copying it, just like one that was dropped before.
+	/// </summary>
+	class line_buffer
+	{
+	public:
+		/// <summary>
+		/// The maximum length of a line in bytes. Longer lines are truncated.
+		/// </summary>
+		static constexpr size_t max_line_length = 512;
+
+		explicit line_buffer(size_t capacity);
+
+		/// <summary>
+		/// Remove all lines. Can be called from any thread.
+		/// </summary>
+		void clear();
+		/// <summary>
+		/// Append a message, split into one line per line break. Each line is prefixed with the level name and replaces the oldest one if the buffer is full.
+		/// Must only be called from a single thread at a time.
+		/// </summary>
+		void push_back(level level, const std::string &message);
+
+		/// <summary>
+		/// Returns the index of the oldest line that was not dropped yet.
+		/// </summary>
+		uint64_t begin_index() const;
+		/// <summary>
+		/// Returns the index the next line added will get.
+		/// </summary>
+		uint64_t end_index() const;
+		/// <summary>
+		/// Returns the number of lines with the specified level. This is only a snapshot when lines are added at the same time.
+		/// </summary>
+		size_t count(level level) const;
+
+		/// <summary>
+		/// Call the specified function for every line starting at the specified index, oldest first.
+		/// </summary>
+		template <typename F>
+		void for_each(uint64_t first_index, F func) const
+		{
+			line line;
+			const uint64_t end_index = this->end_index();
+
+			for (uint64_t index = std::max(first_index, begin_index()); index < end_index; index++)
+			{
+				if (read(index, line))
+				{
+					func(index, line);
+				}
+			}
+		}
+		/// <summary>
+		/// Call the specified function for every line in a list of indices. Lines that were dropped already are skipped.
+		/// </summary>
+		template <typename F>
+		void for_each(const uint64_t *indices, size_t num_indices, F func) const
+		{
+			line line;
+			const uint64_t begin_index = this->begin_index();
+
+			for (size_t i = 0; i < num_indices; i++)
+			{
+				if (indices[i] >= begin_index && read(indices[i], line))
+				{
+					func(indices[i], line);
+				}
+			}
+		}
+
+	private:
+		static constexpr size_t num_levels = 5;
+		static constexpr size_t words_per_line = max_line_length / sizeof(uint64_t);
+
+		// The text is stored in atomic words, so that readers may copy it while the writer replaces it, and then find out from the sequence number whether they got a consistent copy
+		struct slot
+		{
+			// Twice the line index plus two once the line is complete, or twice the line index plus one while it is being written
+			std::atomic<uint64_t> sequence;
+			std::atomic<uint32_t> level, length;
+			// Number of lines with each level that were added before this one, so that the lines of a level since any index can be counted
+			std::atomic<uint64_t> level_counts_before[num_levels];
+			std::atomic<uint64_t> text[words_per_line];
+		};
+
+		bool read(uint64_t index, line &line) const;
+		bool read_level_count_before(uint64_t index, level level, uint64_t &count) const;
+
+		size_t _capacity;
+		std::unique_ptr<slot[]> _slots;
+		std::atomic<uint64_t> _end_index = 0;
+		std::atomic<uint64_t> _clear_index = 0;
+		// Number of lines with each level that were added so far, only modified by the writing thread
+		std::atomic<uint64_t> _level_counts[num_levels] = { };
+	};
+}
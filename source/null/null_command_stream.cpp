@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "null_command_stream.hpp"
+#include <assert.h>
+#include <algorithm>
+
+namespace reshade::null
+{
+	void null_command_stream::begin_frame()
+	{
+		_frame_offsets.push_back(_commands.size());
+	}
+	void null_command_stream::clear()
+	{
+		_commands.clear();
+		_payload.clear();
+		_frame_offsets.clear();
+	}
+
+	void null_command_stream::record(null_command_type type, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+	{
+		_commands.push_back({ type, { arg0, arg1, arg2, arg3 } });
+	}
+	void null_command_stream::record_list(null_command_type type, const uint32_t *objects, uint32_t count, uint32_t arg2)
+	{
+		_commands.push_back({ type, { static_cast<uint32_t>(_payload.size()), count, arg2, 0 } });
+		_payload.insert(_payload.end(), objects, objects + count);
+	}
+
+	const null_command *null_command_stream::frame(size_t frame, size_t &count) const
+	{
+		assert(frame < _frame_offsets.size());
+
+		const size_t begin = _frame_offsets[frame];
+		const size_t end = frame + 1 < _frame_offsets.size() ? _frame_offsets[frame + 1] : _commands.size();
+
+		count = end - begin;
+
+		return _commands.data() + begin;
+	}
+
+	null_frame_statistics null_command_stream::analyze(size_t frame) const
+	{
+		null_frame_statistics statistics;
+
+		// The bound state is unknown at the start of a frame, so the first bind of each kind is never redundant
+		const null_command *bound[null_command_type_count] = { };
+
+		replay(frame, [this, &statistics, &bound](const null_command &command) {
+			const size_t type = static_cast<size_t>(command.type);
+
+			statistics.command_counts[type]++;
+
+			switch (command.type)
+			{
+				case null_command_type::bind_shaders:
+				case null_command_type::bind_blend_state:
+				case null_command_type::bind_depth_stencil_state:
+				case null_command_type::bind_rasterizer_state:
+				case null_command_type::bind_constant_buffer:
+				case null_command_type::bind_vertex_buffer:
+				case null_command_type::bind_index_buffer:
+				case null_command_type::set_viewport:
+				case null_command_type::set_scissor:
+					if (bound[type] != nullptr && std::equal(command.args, command.args + 4, bound[type]->args))
+					{
+						statistics.redundant_binds++;
+					}
+					bound[type] = &command;
+					break;
+				case null_command_type::bind_samplers:
+				case null_command_type::bind_shader_resources:
+				case null_command_type::bind_render_targets:
+					if (bound[type] != nullptr && bound[type]->args[1] == command.args[1] && bound[type]->args[2] == command.args[2] &&
+						std::equal(payload(command), payload(command) + command.args[1], payload(*bound[type])))
+					{
+						statistics.redundant_binds++;
+					}
+					bound[type] = &command;
+					break;
+				case null_command_type::update_buffer:
+					statistics.bytes_uploaded += command.args[2];
+					break;
+				case null_command_type::update_texture:
+					statistics.bytes_uploaded += command.args[1];
+					break;
+				case null_command_type::copy_texture:
+					statistics.copies++;
+					break;
+				default:
+					break;
+			}
+		});
+
+		return statistics;
+	}
+}
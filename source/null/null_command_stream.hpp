@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace reshade::null
+{
+	/// <summary>
+	/// Type of a recorded backend command. The meaning of the arguments is listed next to each type.
+	/// </summary>
+	enum class null_command_type : uint8_t
+	{
+		bind_shaders, // vertex shader, pixel shader
+		bind_blend_state, // blend state
+		bind_depth_stencil_state, // depth-stencil state, stencil reference value
+		bind_rasterizer_state, // rasterizer state
+		bind_samplers, // payload offset, sampler count
+		bind_shader_resources, // payload offset, view count, first slot
+		bind_render_targets, // payload offset, view count, depth-stencil view
+		bind_constant_buffer, // buffer
+		bind_vertex_buffer, // buffer
+		bind_index_buffer, // buffer
+		set_viewport, // width, height
+		set_scissor, // left, top, right, bottom
+		update_buffer, // buffer, offset, size
+		update_texture, // texture, size, mipmap level
+		copy_texture, // destination texture, source texture
+		clear_render_target, // view
+		clear_depth_stencil, // view
+		generate_mipmaps, // view
+		draw, // vertex count, first vertex
+		draw_indexed, // index count, first index, base vertex
+	};
+
+	const size_t null_command_type_count = static_cast<size_t>(null_command_type::draw_indexed) + 1;
+
+	struct null_command
+	{
+		null_command_type type;
+		uint32_t args[4];
+	};
+
+	/// <summary>
+	/// Summary of the commands recorded during a single frame.
+	/// </summary>
+	struct null_frame_statistics
+	{
+		size_t command_counts[null_command_type_count] = { };
+		/// <summary>
+		/// Number of bind commands which set the exact same state that was already bound.
+		/// </summary>
+		size_t redundant_binds = 0;
+		/// <summary>
+		/// Number of texture copies.
+		/// </summary>
+		size_t copies = 0;
+		/// <summary>
+		/// Number of bytes written to buffers and textures.
+		/// </summary>
+		size_t bytes_uploaded = 0;
+	};
+
+	/// <summary>
+	/// A compact in-memory stream of backend commands, split into frames. Commands which bind a list of objects store it in a separate payload array.
+	/// </summary>
+	class null_command_stream
+	{
+	public:
+		/// <summary>
+		/// Start recording a new frame.
+		/// </summary>
+		void begin_frame();
+		/// <summary>
+		/// Remove all recorded frames.
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Record a command with fixed arguments.
+		/// </summary>
+		void record(null_command_type type, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0, uint32_t arg3 = 0);
+		/// <summary>
+		/// Record a command which binds a list of objects. The list is stored in the payload and referenced by the first two arguments.
+		/// </summary>
+		void record_list(null_command_type type, const uint32_t *objects, uint32_t count, uint32_t arg2 = 0);
+
+		/// <summary>
+		/// Returns the number of recorded frames.
+		/// </summary>
+		size_t frame_count() const { return _frame_offsets.size(); }
+		/// <summary>
+		/// Returns the commands of a recorded frame.
+		/// </summary>
+		/// <param name="frame">The index of the frame.</param>
+		/// <param name="count">A variable which receives the number of commands.</param>
+		const null_command *frame(size_t frame, size_t &count) const;
+		/// <summary>
+		/// Returns the list of objects a command recorded with <see cref="record_list"/> binds.
+		/// </summary>
+		const uint32_t *payload(const null_command &command) const { return _payload.data() + command.args[0]; }
+
+		/// <summary>
+		/// Count the commands, redundant binds, copies and uploads of a recorded frame.
+		/// </summary>
+		/// <param name="frame">The index of the frame.</param>
+		null_frame_statistics analyze(size_t frame) const;
+
+		/// <summary>
+		/// Feed all commands of a recorded frame to a callback in order.
+		/// </summary>
+		/// <param name="frame">The index of the frame.</param>
+		/// <param name="callback">The function called with each command.</param>
+		template <typename F>
+		void replay(size_t frame, F &&callback) const
+		{
+			size_t count;
+			const null_command *const commands = this->frame(frame, count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				callback(commands[i]);
+			}
+		}
+
+	private:
+		std::vector<null_command> _commands;
+		std::vector<uint32_t> _payload;
+		std::vector<size_t> _frame_offsets;
+	};
+}
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "null_runtime.hpp"
+#include "null_effect_compiler.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::null
+{
+	using namespace reshadefx;
+	using namespace reshadefx::nodes;
+
+	static inline size_t roundto16(size_t size)
+	{
+		return (size + 15) & ~15;
+	}
+	template <typename T>
+	static size_t hash_desc(const T &desc)
+	{
+		size_t desc_hash = 2166136261;
+		for (size_t i = 0; i < sizeof(desc); ++i)
+			desc_hash = (desc_hash * 16777619) ^ reinterpret_cast<const uint8_t *>(&desc)[i];
+		return desc_hash;
+	}
+	static uint32_t find_or_create_state(null_runtime *runtime, std::unordered_map<size_t, uint32_t> &states, size_t desc_hash)
+	{
+		// Graphics APIs return the same state object for identical descriptions, so do the same to keep redundant binds detectable
+		auto it = states.find(desc_hash);
+
+		if (it == states.end())
+		{
+			it = states.emplace(desc_hash, runtime->create_object()).first;
+		}
+
+		return it->second;
+	}
+
+	null_effect_compiler::null_effect_compiler(null_runtime *runtime, const syntax_tree &ast, std::string &errors) :
+		_runtime(runtime),
+		_ast(ast),
+		_errors(errors),
+		_uniform_usage(ast)
+	{
+	}
+
+	bool null_effect_compiler::run()
+	{
+		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
+
+		for (auto uniform : _ast.variables)
+		{
+			if (uniform->type.is_texture())
+			{
+				visit_texture(uniform);
+			}
+			else if (uniform->type.is_sampler())
+			{
+				visit_sampler(uniform);
+			}
+			else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				visit_uniform(uniform);
+			}
+		}
+		for (auto technique : _ast.techniques)
+		{
+			visit_technique(technique);
+		}
+
+		if (_constant_buffer_size != 0)
+		{
+			_constant_buffer_size = roundto16(_constant_buffer_size);
+			_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
+		}
+
+		return _success;
+	}
+
+	void null_effect_compiler::error(const location &location, const std::string &message)
+	{
+		_success = false;
+
+		_errors += location.source + "(" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): error: " + message + '\n';
+	}
+
+	void null_effect_compiler::visit_texture(const variable_declaration_node *node)
+	{
+		const auto existing_texture = _runtime->find_texture(node->unique_name);
+
+		if (existing_texture != nullptr)
+		{
+			if (!node->semantic.empty() && node->semantic != "COLOR" && node->semantic != "SV_TARGET" && node->semantic != "DEPTH" && node->semantic != "SV_DEPTH")
+			{
+				error(node->location, "invalid semantic");
+			}
+			else if (node->semantic.empty() && (
+				existing_texture->width != node->properties.width ||
+				existing_texture->height != node->properties.height ||
+				existing_texture->levels != node->properties.levels ||
+				existing_texture->format != node->properties.format))
+			{
+				error(node->location, existing_texture->effect_filename + " already created a texture with the same name but different dimensions; textures are shared across all effects, so either rename the variable or adjust the dimensions so they match");
+			}
+			return;
+		}
+
+		texture obj;
+		obj.name = node->name;
+		obj.unique_name = node->unique_name;
+		obj.annotations = node->annotation_list;
+		obj.width = node->properties.width;
+		obj.height = node->properties.height;
+		obj.levels = node->properties.levels;
+		obj.format = node->properties.format;
+
+		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
+		{
+			obj.width = _runtime->frame_width();
+			obj.height = _runtime->frame_height();
+			obj.impl_reference = texture_reference::back_buffer;
+		}
+		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		{
+			obj.width = _runtime->frame_width();
+			obj.height = _runtime->frame_height();
+			obj.impl_reference = texture_reference::depth_buffer;
+		}
+		else if (!node->semantic.empty())
+		{
+			error(node->location, "invalid semantic");
+			return;
+		}
+		else
+		{
+			obj.impl = std::make_unique<null_tex_data>();
+			const auto obj_data = obj.impl->as<null_tex_data>();
+
+			obj_data->texture = _runtime->create_object();
+			obj_data->levels = obj.levels;
+			obj_data->srv[0] = _runtime->create_view(obj_data->texture);
+			_runtime->_effect_shader_resources.push_back(obj_data->srv[0]);
+
+			// Only the 8-bit RGBA and block compressed formats have an sRGB variant that needs its own view
+			if (obj.format == texture_format::rgba8 || obj.format == texture_format::dxt1 || obj.format == texture_format::dxt3 || obj.format == texture_format::dxt5)
+			{
+				obj_data->srv[1] = _runtime->create_view(obj_data->texture);
+				_runtime->_effect_shader_resources.push_back(obj_data->srv[1]);
+			}
+			else
+			{
+				obj_data->srv[1] = obj_data->srv[0];
+			}
+		}
+
+		_runtime->add_texture(std::move(obj));
+	}
+	void null_effect_compiler::visit_sampler(const variable_declaration_node *node)
+	{
+		struct
+		{
+			unsigned int filter, address_u, address_v, address_w;
+			float lod_bias, min_lod, max_lod;
+		} desc;
+		desc.filter = static_cast<unsigned int>(node->properties.filter);
+		desc.address_u = static_cast<unsigned int>(node->properties.address_u);
+		desc.address_v = static_cast<unsigned int>(node->properties.address_v);
+		desc.address_w = static_cast<unsigned int>(node->properties.address_w);
+		desc.lod_bias = node->properties.lod_bias;
+		desc.min_lod = node->properties.min_lod;
+		desc.max_lod = node->properties.max_lod;
+
+		const auto texture = _runtime->find_texture(node->properties.texture->unique_name);
+
+		if (texture == nullptr)
+		{
+			error(node->location, "texture '" + node->properties.texture->name + "' for sampler '" + node->name + "' is missing due to previous error");
+			return;
+		}
+
+		const size_t desc_hash = hash_desc(desc);
+
+		if (_runtime->_effect_sampler_descs.find(desc_hash) == _runtime->_effect_sampler_descs.end())
+		{
+			_runtime->_effect_sampler_states.push_back(_runtime->create_object());
+			_runtime->_effect_sampler_descs.emplace(desc_hash, _runtime->_effect_sampler_states.size() - 1);
+		}
+	}
+	void null_effect_compiler::visit_uniform(const variable_declaration_node *node)
+	{
+		uniform obj;
+		obj.name = node->name;
+		obj.unique_name = node->unique_name;
+		obj.basetype = obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
+		obj.rows = node->type.rows;
+		obj.columns = node->type.cols;
+		obj.elements = node->type.array_length;
+		obj.storage_size = node->type.rows * node->type.cols * std::max(1u, obj.elements) * 4;
+		obj.annotations = node->annotation_list;
+
+		const size_t alignment = 16 - (_constant_buffer_size % 16);
+		_constant_buffer_size += (obj.storage_size > alignment && (alignment != 16 || obj.storage_size <= 16)) ? obj.storage_size + alignment : obj.storage_size;
+		obj.storage_offset = _uniform_storage_offset + _constant_buffer_size - obj.storage_size;
+
+		auto &uniform_storage = _runtime->get_uniform_value_storage();
+
+		if (_uniform_storage_offset + _constant_buffer_size >= uniform_storage.size())
+		{
+			uniform_storage.resize(uniform_storage.size() + 128);
+		}
+
+		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
+		{
+			std::memcpy(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
+		}
+		else
+		{
+			std::memset(uniform_storage.data() + obj.storage_offset, 0, obj.storage_size);
+		}
+
+		_uniform_storage_offsets[node] = obj.storage_offset;
+
+		_runtime->add_uniform(std::move(obj));
+	}
+	void null_effect_compiler::visit_technique(const technique_declaration_node *node)
+	{
+		technique obj;
+		obj.name = node->name;
+		obj.annotations = node->annotation_list;
+
+		// Lay out a compact constant buffer containing only the uniforms this technique actually references
+		const auto layout = layout_uniform_block(_uniform_usage.find(node), uniform_packing::constant_buffer);
+
+		if (layout.size != 0)
+		{
+			std::vector<size_t> storage_offsets;
+
+			for (auto uniform : layout.uniforms)
+			{
+				storage_offsets.push_back(_uniform_storage_offsets.at(uniform));
+			}
+
+			obj.uniform_storage_index = _runtime->_constant_buffers.size();
+			obj.uniform_block_size = layout.size;
+			obj.uniform_block_ranges = build_uniform_copy_ranges(layout, storage_offsets);
+
+			_runtime->_constant_buffers.push_back(_runtime->create_object());
+		}
+
+		for (auto pass : node->pass_list)
+		{
+			obj.passes.emplace_back(std::make_unique<null_pass_data>());
+			visit_pass(pass, *static_cast<null_pass_data *>(obj.passes.back().get()));
+			obj.pass_texture_usage.push_back(analyze_texture_access(_uniform_usage, pass));
+		}
+
+		_runtime->add_technique(std::move(obj));
+	}
+	void null_effect_compiler::visit_pass(const pass_declaration_node *node, null_pass_data &pass)
+	{
+		pass.clear_render_targets = node->clear_render_targets;
+		pass.back_buffer_usage = analyze_back_buffer_access(_uniform_usage, node);
+		pass.shader_resources = _runtime->_effect_shader_resources;
+
+		// Every pass compiles its own shaders, like in the other renderers
+		if (node->vertex_shader != nullptr)
+		{
+			pass.vertex_shader = _runtime->create_object();
+		}
+		if (node->pixel_shader != nullptr)
+		{
+			pass.pixel_shader = _runtime->create_object();
+		}
+
+		const int target_index = node->srgb_write_enable ? 1 : 0;
+		pass.render_targets[0] = _runtime->_backbuffer_rtv[target_index];
+
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (node->render_targets[i] == nullptr)
+			{
+				continue;
+			}
+
+			const auto texture = _runtime->find_texture(node->render_targets[i]->unique_name);
+
+			if (texture == nullptr || texture->impl == nullptr)
+			{
+				error(node->location, "texture not found");
+				return;
+			}
+
+			const auto texture_impl = texture->impl->as<null_tex_data>();
+
+			if (pass.viewport_width != 0 && pass.viewport_height != 0 && (texture->width != pass.viewport_width || texture->height != pass.viewport_height))
+			{
+				error(node->location, "cannot use multiple rendertargets with different sized textures");
+				return;
+			}
+			else
+			{
+				pass.viewport_width = texture->width;
+				pass.viewport_height = texture->height;
+			}
+
+			if (texture_impl->rtv[target_index] == 0)
+			{
+				texture_impl->rtv[target_index] = _runtime->create_view(texture_impl->texture);
+			}
+
+			pass.render_targets[i] = texture_impl->rtv[target_index];
+			pass.render_target_resources[i] = texture_impl;
+		}
+
+		if (pass.viewport_width == 0 && pass.viewport_height == 0)
+		{
+			pass.viewport_width = _runtime->frame_width();
+			pass.viewport_height = _runtime->frame_height();
+		}
+
+		struct
+		{
+			unsigned int enable, read_mask, write_mask, func, pass_op, fail_op, depth_fail_op;
+		} depth_stencil_desc;
+		depth_stencil_desc.enable = node->stencil_enable;
+		depth_stencil_desc.read_mask = node->stencil_read_mask;
+		depth_stencil_desc.write_mask = node->stencil_write_mask;
+		depth_stencil_desc.func = node->stencil_comparison_func;
+		depth_stencil_desc.pass_op = node->stencil_op_pass;
+		depth_stencil_desc.fail_op = node->stencil_op_fail;
+		depth_stencil_desc.depth_fail_op = node->stencil_op_depth_fail;
+
+		pass.depth_stencil_state = find_or_create_state(_runtime, _runtime->_effect_depth_stencil_states, hash_desc(depth_stencil_desc));
+		pass.stencil_reference = node->stencil_reference_value;
+
+		struct
+		{
+			unsigned int write_mask, enable, op, op_alpha, src, dest, src_alpha, dest_alpha;
+		} blend_desc;
+		blend_desc.write_mask = node->color_write_mask;
+		blend_desc.enable = node->blend_enable;
+		blend_desc.op = node->blend_op;
+		blend_desc.op_alpha = node->blend_op_alpha;
+		blend_desc.src = node->src_blend;
+		blend_desc.dest = node->dest_blend;
+		blend_desc.src_alpha = node->src_blend_alpha;
+		blend_desc.dest_alpha = node->dest_blend_alpha;
+
+		pass.blend_state = find_or_create_state(_runtime, _runtime->_effect_blend_states, hash_desc(blend_desc));
+
+		// Textures that are rendered to cannot be bound for sampling at the same time
+		for (auto &srv : pass.shader_resources)
+		{
+			for (const auto resource : pass.render_target_resources)
+			{
+				if (resource != nullptr && (srv == resource->srv[0] || srv == resource->srv[1]))
+				{
+					srv = 0;
+					break;
+				}
+			}
+		}
+	}
+}
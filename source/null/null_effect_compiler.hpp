@@ -0,0 +1,44 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_uniform_usage.hpp"
+
+namespace reshade::null
+{
+	#pragma region Forward Declarations
+	struct null_pass_data;
+	class null_runtime;
+	#pragma endregion
+
+	/// <summary>
+	/// Creates the textures, uniforms and techniques of an effect for the null runtime. It assigns object identifiers the same way the Direct3D 11 compiler creates objects, but generates no shader code.
+	/// </summary>
+	class null_effect_compiler
+	{
+	public:
+		null_effect_compiler(null_runtime *runtime, const reshadefx::syntax_tree &ast, std::string &errors);
+
+		bool run();
+
+	private:
+		void error(const reshadefx::location &location, const std::string &message);
+
+		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
+		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, null_pass_data &pass);
+
+		null_runtime *_runtime;
+		bool _success = true;
+		const reshadefx::syntax_tree &_ast;
+		std::string &_errors;
+		reshadefx::uniform_usage _uniform_usage;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _uniform_storage_offsets;
+		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0;
+	};
+}
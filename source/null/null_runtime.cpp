@@ -0,0 +1,427 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "input.hpp"
+#include "null_runtime.hpp"
+#include "null_effect_compiler.hpp"
+#include <assert.h>
+#include <cstring>
+#include <algorithm>
+#if RESHADE_GUI
+#include <imgui.h>
+#endif
+
+namespace reshade::null
+{
+	null_runtime::null_runtime() : runtime(0xc000)
+	{
+		_input = std::make_shared<input>(nullptr);
+	}
+
+	bool null_runtime::on_init(unsigned int width, unsigned int height)
+	{
+		_width = width;
+		_height = height;
+
+		// Create the same objects as the Direct3D 11 runtime, in the same order
+		_object_count = 0;
+		_view_resources.clear();
+		_backbuffer = create_object();
+		_backbuffer_rtv[0] = create_view(_backbuffer);
+		_backbuffer_rtv[1] = create_view(_backbuffer);
+
+		_backbuffer_texture = create_object();
+		_backbuffer_texture_pingpong = create_object();
+
+		for (unsigned int i = 0; i < 2; i++)
+		{
+			_backbuffer_texture_srv[i] = create_view(_backbuffer_texture);
+			_backbuffer_texture_rtv[i] = create_view(_backbuffer_texture);
+			_backbuffer_texture_pingpong_srv[i] = create_view(_backbuffer_texture_pingpong);
+			_backbuffer_texture_pingpong_rtv[i] = create_view(_backbuffer_texture_pingpong);
+		}
+
+		_depthstencil_texture_srv = create_object();
+		_default_depthstencil = create_object();
+		_effect_rasterizer_state = create_object();
+
+#if RESHADE_GUI
+		_imgui_vertex_shader = create_object();
+		_imgui_pixel_shader = create_object();
+		_imgui_constant_buffer = create_object();
+		_imgui_texture_sampler = create_object();
+		_imgui_rasterizer_state = create_object();
+		_imgui_blend_state = create_object();
+		_imgui_depthstencil_state = create_object();
+
+		int font_atlas_width, font_atlas_height;
+		unsigned char *font_atlas_pixels;
+
+		ImGui::SetCurrentContext(_imgui_context);
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&font_atlas_pixels, &font_atlas_width, &font_atlas_height);
+
+		auto font_atlas = std::make_unique<null_tex_data>();
+		font_atlas->texture = create_object();
+		font_atlas->srv[0] = font_atlas->srv[1] = create_view(font_atlas->texture);
+
+		_imgui_font_atlas_texture = std::move(font_atlas);
+#endif
+
+		return runtime::on_init();
+	}
+	void null_runtime::on_reset()
+	{
+		runtime::on_reset();
+
+#if RESHADE_GUI
+		_imgui_vertex_buffer = _imgui_index_buffer = 0;
+		_imgui_vertex_buffer_size = _imgui_index_buffer_size = 0;
+#endif
+	}
+	void null_runtime::on_reset_effect()
+	{
+		runtime::on_reset_effect();
+
+		_effect_sampler_descs.clear();
+		_effect_sampler_states.clear();
+		_effect_blend_states.clear();
+		_effect_depth_stencil_states.clear();
+		_constant_buffers.clear();
+
+		_effect_shader_resources.resize(3);
+		_effect_shader_resources[0] = _backbuffer_texture_srv[0];
+		_effect_shader_resources[1] = _backbuffer_texture_srv[1];
+		_effect_shader_resources[2] = _depthstencil_texture_srv;
+	}
+	void null_runtime::on_present()
+	{
+		if (!is_initialized())
+			return;
+
+		// There are no application draw calls, so the statistics only count what the runtime itself issues
+		_vertices = 0;
+		_drawcalls = 0;
+
+		_commands.begin_frame();
+
+		// Apply post processing
+		if (is_effect_loaded())
+		{
+			// The user interface was rendered with other states at the end of the last frame
+			_state_cache.invalidate();
+
+			// Setup real back buffer
+			_commands.record_list(null_command_type::bind_render_targets, &_backbuffer_rtv[0], 1);
+			_commands.record(null_command_type::bind_rasterizer_state, _effect_rasterizer_state);
+
+			// Setup samplers
+			_commands.record_list(null_command_type::bind_samplers, _effect_sampler_states.data(), static_cast<uint32_t>(_effect_sampler_states.size()));
+
+			_back_buffer_planner.begin_frame();
+
+			on_present_effect();
+
+			// Passes may have left the final image in one of the back buffer textures
+			const int final_surface = _back_buffer_planner.end_frame();
+
+			if (final_surface > 0)
+			{
+				_commands.record(null_command_type::copy_texture, _backbuffer, final_surface == 1 ? _backbuffer_texture : _backbuffer_texture_pingpong);
+			}
+		}
+
+		// Apply presenting
+		runtime::on_present();
+	}
+
+	uint32_t null_runtime::create_view(uint32_t resource)
+	{
+		const uint32_t view = create_object();
+		_view_resources[view] = resource;
+
+		return view;
+	}
+	uint32_t null_runtime::get_view_resource(uint32_t view) const
+	{
+		const auto it = _view_resources.find(view);
+
+		return it != _view_resources.end() ? it->second : view;
+	}
+
+	void null_runtime::capture_frame(uint8_t *buffer) const
+	{
+		// Nothing is ever rendered, so the frame is always black
+		std::memset(buffer, 0, _width * _height * 4);
+	}
+	bool null_runtime::load_effect(const reshadefx::syntax_tree &ast, std::string &errors)
+	{
+		return null_effect_compiler(this, ast, errors).run();
+	}
+	upload_layout null_runtime::get_upload_layout(const texture &texture) const
+	{
+		upload_layout layout;
+		layout.levels = texture.levels;
+
+		return layout;
+	}
+	bool null_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
+	{
+		if (texture.impl_reference != texture_reference::none)
+		{
+			return false;
+		}
+
+		const auto texture_impl = texture.impl->as<null_tex_data>();
+
+		assert(data != nullptr);
+		assert(texture_impl != nullptr);
+
+		// Every mipmap level is uploaded, instead of generating them on the device
+		for (uint32_t level = 0; level < std::min(static_cast<uint32_t>(levels.size()), texture.levels); level++)
+		{
+			_commands.record(null_command_type::update_texture, texture_impl->texture, static_cast<uint32_t>(levels[level].row_pitch * levels[level].height), level);
+		}
+
+		return true;
+	}
+
+	void null_runtime::render_technique(technique &technique)
+	{
+		bool is_default_depthstencil_cleared = false;
+
+		// Setup shader constants
+		if (technique.uniform_storage_index >= 0)
+		{
+			const uint32_t constant_buffer = _constant_buffers[technique.uniform_storage_index];
+
+			// Each technique owns its constant buffer, so it keeps its contents as long as no uniform in it changed
+			if (update_uniform_block(technique, _dirty_uniform_ranges))
+			{
+				// Discarding invalidates the entire buffer, so always rewrite all of it
+				for (const auto &range : technique.uniform_block_ranges)
+				{
+					_commands.record(null_command_type::update_buffer, constant_buffer, static_cast<uint32_t>(range.block_offset), static_cast<uint32_t>(range.size));
+				}
+			}
+
+			if (_state_cache.set_constant_buffer(constant_buffer))
+			{
+				_commands.record(null_command_type::bind_constant_buffer, constant_buffer);
+			}
+		}
+
+		// Views are bound from the shadow state, so that slots the cache unbound to resolve hazards are included
+		const auto bind_shader_resources = [this](const state_slot_range &range) {
+			const uintptr_t *const views = _state_cache.shader_resources() + range.first;
+			const std::vector<uint32_t> objects(views, views + range.count);
+			_commands.record_list(null_command_type::bind_shader_resources, objects.data(), range.count, range.first);
+		};
+		const auto bind_render_targets = [this]() {
+			const uintptr_t *const views = _state_cache.render_targets();
+			const uint32_t objects[8] = {
+				static_cast<uint32_t>(views[0]), static_cast<uint32_t>(views[1]), static_cast<uint32_t>(views[2]), static_cast<uint32_t>(views[3]),
+				static_cast<uint32_t>(views[4]), static_cast<uint32_t>(views[5]), static_cast<uint32_t>(views[6]), static_cast<uint32_t>(views[7]) };
+			_commands.record_list(null_command_type::bind_render_targets, objects, 8, static_cast<uint32_t>(_state_cache.depth_stencil()));
+		};
+
+		for (const auto &pass_object : technique.passes)
+		{
+			const null_pass_data &pass = *pass_object->as<null_pass_data>();
+
+			// Setup states
+			if (_state_cache.set_shaders(pass.vertex_shader, pass.pixel_shader))
+			{
+				_commands.record(null_command_type::bind_shaders, pass.vertex_shader, pass.pixel_shader);
+			}
+
+			if (_state_cache.set_blend_state(pass.blend_state))
+			{
+				_commands.record(null_command_type::bind_blend_state, pass.blend_state);
+			}
+			if (_state_cache.set_depth_stencil_state(pass.depth_stencil_state, pass.stencil_reference))
+			{
+				_commands.record(null_command_type::bind_depth_stencil_state, pass.depth_stencil_state, pass.stencil_reference);
+			}
+
+			// Only copy the back buffer when the pass samples it and no texture holds the current contents, otherwise ping-pong between the back buffer textures
+			const auto step = _back_buffer_planner.plan_pass(pass.back_buffer_usage);
+
+			const uint32_t surfaces[3] = { _backbuffer, _backbuffer_texture, _backbuffer_texture_pingpong };
+
+			if (step.copy_source >= 0)
+			{
+				_commands.record(null_command_type::copy_texture, surfaces[step.copy_destination], surfaces[step.copy_source]);
+			}
+
+			uintptr_t render_targets[8];
+
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				render_targets[i] = pass.render_targets[i];
+			}
+
+			if (step.write_surface > 0)
+			{
+				const int srgb = pass.render_targets[0] == _backbuffer_rtv[1] ? 1 : 0;
+
+				render_targets[0] = step.write_surface == 1 ? _backbuffer_texture_rtv[srgb] : _backbuffer_texture_pingpong_rtv[srgb];
+			}
+
+			uintptr_t render_target_view_resources[8];
+
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				render_target_view_resources[i] = get_view_resource(static_cast<uint32_t>(render_targets[i]));
+			}
+
+			// Setup render targets before shader resources, so that textures the previous pass rendered to are no longer bound for output when they are sampled
+			const bool is_viewport_sized = pass.viewport_width == _width && pass.viewport_height == _height;
+
+			state_slot_range unbound_shader_resources;
+
+			if (_state_cache.set_render_targets(render_targets, render_target_view_resources, 8, is_viewport_sized ? _default_depthstencil : 0, unbound_shader_resources))
+			{
+				if (unbound_shader_resources.count != 0)
+				{
+					bind_shader_resources(unbound_shader_resources);
+				}
+
+				bind_render_targets();
+			}
+
+			if (is_viewport_sized && !is_default_depthstencil_cleared)
+			{
+				is_default_depthstencil_cleared = true;
+
+				_commands.record(null_command_type::clear_depth_stencil, _default_depthstencil);
+			}
+
+			if (_state_cache.set_viewport(pass.viewport_width, pass.viewport_height))
+			{
+				_commands.record(null_command_type::set_viewport, pass.viewport_width, pass.viewport_height);
+			}
+
+			// Setup shader resources
+			std::vector<uintptr_t> shader_resources(pass.shader_resources.begin(), pass.shader_resources.end());
+
+			if (step.read_surface == 2)
+			{
+				shader_resources[0] = _backbuffer_texture_pingpong_srv[0];
+				shader_resources[1] = _backbuffer_texture_pingpong_srv[1];
+			}
+
+			std::vector<uintptr_t> shader_resource_view_resources(shader_resources.size());
+
+			for (size_t i = 0; i < shader_resources.size(); i++)
+			{
+				shader_resource_view_resources[i] = get_view_resource(static_cast<uint32_t>(shader_resources[i]));
+			}
+
+			bool unbound_render_targets;
+			const auto changed_shader_resources = _state_cache.set_shader_resources(shader_resources.data(), shader_resource_view_resources.data(), static_cast<unsigned int>(shader_resources.size()), unbound_render_targets);
+
+			if (unbound_render_targets)
+			{
+				bind_render_targets();
+			}
+			if (changed_shader_resources.count != 0)
+			{
+				bind_shader_resources(changed_shader_resources);
+			}
+
+			if (pass.clear_render_targets)
+			{
+				for (const auto target : render_targets)
+				{
+					if (target != 0)
+					{
+						_commands.record(null_command_type::clear_render_target, static_cast<uint32_t>(target));
+					}
+				}
+			}
+
+			// Draw triangle
+			_commands.record(null_command_type::draw, 3, 0);
+
+			_vertices += 3;
+			_drawcalls += 1;
+
+			// Update shader resources
+			for (const auto resource : pass.render_target_resources)
+			{
+				if (resource != nullptr && resource->levels > 1)
+				{
+					// Render targets stay bound until the next pass changes them, but mipmaps cannot be generated while the texture is bound for output
+					if (_state_cache.unbind_render_target_resource(resource->texture))
+					{
+						bind_render_targets();
+					}
+
+					_commands.record(null_command_type::generate_mipmaps, resource->srv[0]);
+				}
+			}
+		}
+	}
+#if RESHADE_GUI
+	void null_runtime::render_imgui_draw_data(ImDrawData *draw_data)
+	{
+		// Create and grow vertex/index buffers if needed
+		if (_imgui_vertex_buffer == 0 ||
+			_imgui_vertex_buffer_size < draw_data->TotalVtxCount)
+		{
+			_imgui_vertex_buffer = create_object();
+			_imgui_vertex_buffer_size = draw_data->TotalVtxCount + 5000;
+		}
+		if (_imgui_index_buffer == 0 ||
+			_imgui_index_buffer_size < draw_data->TotalIdxCount)
+		{
+			_imgui_index_buffer = create_object();
+			_imgui_index_buffer_size = draw_data->TotalIdxCount + 10000;
+		}
+
+		_commands.record(null_command_type::update_buffer, _imgui_vertex_buffer, 0, static_cast<uint32_t>(draw_data->TotalVtxCount * sizeof(ImDrawVert)));
+		_commands.record(null_command_type::update_buffer, _imgui_index_buffer, 0, static_cast<uint32_t>(draw_data->TotalIdxCount * sizeof(ImDrawIdx)));
+
+		// Setup orthographic projection matrix
+		_commands.record(null_command_type::update_buffer, _imgui_constant_buffer, 0, 16 * sizeof(float));
+
+		// Setup render state
+		_commands.record_list(null_command_type::bind_render_targets, &_backbuffer_rtv[0], 1);
+		_commands.record(null_command_type::set_viewport, _width, _height);
+		_commands.record(null_command_type::bind_blend_state, _imgui_blend_state);
+		_commands.record(null_command_type::bind_depth_stencil_state, _imgui_depthstencil_state, 0);
+		_commands.record(null_command_type::bind_rasterizer_state, _imgui_rasterizer_state);
+		_commands.record(null_command_type::bind_vertex_buffer, _imgui_vertex_buffer);
+		_commands.record(null_command_type::bind_index_buffer, _imgui_index_buffer);
+		_commands.record(null_command_type::bind_shaders, _imgui_vertex_shader, _imgui_pixel_shader);
+		_commands.record(null_command_type::bind_constant_buffer, _imgui_constant_buffer);
+		_commands.record_list(null_command_type::bind_samplers, &_imgui_texture_sampler, 1);
+
+		// Render command lists
+		uint32_t vtx_offset = 0, idx_offset = 0;
+
+		for (int n = 0; n < draw_data->CmdListsCount; n++)
+		{
+			const ImDrawList *const cmd_list = draw_data->CmdLists[n];
+
+			for (const ImDrawCmd *cmd = cmd_list->CmdBuffer.begin(); cmd != cmd_list->CmdBuffer.end(); idx_offset += cmd->ElemCount, cmd++)
+			{
+				const uint32_t texture_view = static_cast<const null_tex_data *>(cmd->TextureId)->srv[0];
+
+				_commands.record_list(null_command_type::bind_shader_resources, &texture_view, 1);
+				_commands.record(null_command_type::set_scissor,
+					static_cast<uint32_t>(cmd->ClipRect.x),
+					static_cast<uint32_t>(cmd->ClipRect.y),
+					static_cast<uint32_t>(cmd->ClipRect.z),
+					static_cast<uint32_t>(cmd->ClipRect.w));
+
+				_commands.record(null_command_type::draw_indexed, cmd->ElemCount, idx_offset, vtx_offset);
+			}
+
+			vtx_offset += static_cast<uint32_t>(cmd_list->VtxBuffer.size());
+		}
+	}
+#endif
+}
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "runtime.hpp"
+#include "render_graph.hpp"
+#include "render_state_cache.hpp"
+#include "null_command_stream.hpp"
+
+namespace reshade::null
+{
+	struct null_tex_data : base_object
+	{
+		uint32_t texture = 0;
+		uint32_t srv[2] = { }, rtv[2] = { };
+		unsigned int levels = 1;
+	};
+	struct null_pass_data : base_object
+	{
+		uint32_t vertex_shader = 0, pixel_shader = 0;
+		uint32_t blend_state = 0, depth_stencil_state = 0;
+		uint32_t stencil_reference = 0;
+		bool clear_render_targets = true;
+		back_buffer_access back_buffer_usage;
+		uint32_t render_targets[8] = { };
+		const null_tex_data *render_target_resources[8] = { };
+		uint32_t viewport_width = 0, viewport_height = 0;
+		std::vector<uint32_t> shader_resources;
+	};
+
+	/// <summary>
+	/// A runtime which does not call any graphics API, but records every command the other renderers would issue into a command stream instead.
+	/// It runs the same scheduling logic as the Direct3D 11 runtime, so that it can be benchmarked and analyzed on any platform.
+	/// </summary>
+	class null_runtime : public runtime
+	{
+	public:
+		null_runtime();
+
+		bool on_init(unsigned int width, unsigned int height);
+		void on_reset();
+		void on_reset_effect() override;
+		void on_present();
+
+		void capture_frame(uint8_t *buffer) const override;
+		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
+		upload_layout get_upload_layout(const texture &texture) const override;
+		bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) override;
+
+		void render_technique(technique &technique) override;
+#if RESHADE_GUI
+		void render_imgui_draw_data(ImDrawData *data) override;
+#endif
+
+		/// <summary>
+		/// Returns the commands recorded so far, one frame per call to "on_present".
+		/// </summary>
+		const null_command_stream &commands() const { return _commands; }
+		/// <summary>
+		/// Remove all recorded commands.
+		/// </summary>
+		void clear_commands() { _commands.clear(); }
+
+		/// <summary>
+		/// Create a new object identifier. Identifiers are assigned in order starting at one, so that recordings of the same effects are comparable.
+		/// </summary>
+		uint32_t create_object() { return ++_object_count; }
+		/// <summary>
+		/// Create a new object identifier for a view and remember the resource it belongs to, so that the state cache can detect read/write hazards.
+		/// </summary>
+		uint32_t create_view(uint32_t resource);
+		/// <summary>
+		/// Returns the resource a view was created for, or the view itself if it has none.
+		/// </summary>
+		uint32_t get_view_resource(uint32_t view) const;
+
+		uint32_t _backbuffer_rtv[2] = { }, _backbuffer_texture_srv[2] = { }, _backbuffer_texture_pingpong_srv[2] = { };
+		uint32_t _backbuffer_texture_rtv[2] = { }, _backbuffer_texture_pingpong_rtv[2] = { };
+		uint32_t _backbuffer = 0, _backbuffer_texture = 0, _backbuffer_texture_pingpong = 0;
+		back_buffer_planner _back_buffer_planner { 2, true };
+		uint32_t _depthstencil_texture_srv = 0;
+		std::vector<uint32_t> _effect_sampler_states;
+		std::unordered_map<size_t, size_t> _effect_sampler_descs;
+		std::unordered_map<size_t, uint32_t> _effect_blend_states, _effect_depth_stencil_states;
+		std::vector<uint32_t> _effect_shader_resources;
+		std::vector<uint32_t> _constant_buffers;
+		std::vector<uniform_copy_range> _dirty_uniform_ranges;
+
+	private:
+		null_command_stream _commands;
+		uint32_t _object_count = 0;
+		std::unordered_map<uint32_t, uint32_t> _view_resources;
+		render_state_cache _state_cache;
+		uint32_t _default_depthstencil = 0;
+		uint32_t _effect_rasterizer_state = 0;
+#if RESHADE_GUI
+		uint32_t _imgui_vertex_buffer = 0, _imgui_index_buffer = 0, _imgui_constant_buffer = 0;
+		uint32_t _imgui_vertex_shader = 0, _imgui_pixel_shader = 0;
+		uint32_t _imgui_texture_sampler = 0, _imgui_rasterizer_state = 0, _imgui_blend_state = 0, _imgui_depthstencil_state = 0;
+		int _imgui_vertex_buffer_size = 0, _imgui_index_buffer_size = 0;
+#endif
+	};
+}
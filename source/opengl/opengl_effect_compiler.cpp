@@ -381,6 +381,7 @@ namespace reshade::opengl
 		_success(true),
 		_ast(ast),
 		_errors(errors),
+		_uniform_usage(ast),
 		_current_function(nullptr)
 	{
 #if RESHADE_DUMP_NATIVE_SHADERS
@@ -440,22 +441,6 @@ namespace reshade::opengl
 			visit_technique(technique);
 		}
 
-		if (_uniform_buffer_size != 0)
-		{
-			GLuint ubo = 0;
-			glGenBuffers(1, &ubo);
-
-			GLint previous = 0;
-			glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &previous);
-
-			glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-			glBufferData(GL_UNIFORM_BUFFER, _uniform_buffer_size, _runtime->get_uniform_value_storage().data() + _uniform_storage_offset, GL_DYNAMIC_DRAW);
-
-			glBindBuffer(GL_UNIFORM_BUFFER, previous);
-
-			_runtime->_effect_ubos.emplace_back(ubo, _uniform_buffer_size);
-		}
-
 		return _success;
 	}
 
@@ -2170,24 +2155,6 @@ namespace reshade::opengl
 	}
 	void opengl_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
-		visit(_global_uniforms, node->type, true, false);
-
-		_global_uniforms << ' ' << escape_name(node->unique_name);
-
-		if (node->type.is_array())
-		{
-			_global_uniforms << '[';
-
-			if (node->type.array_length > 0)
-			{
-				_global_uniforms << node->type.array_length;
-			}
-
-			_global_uniforms << ']';
-		}
-
-		_global_uniforms << ";\n";
-
 		uniform obj;
 		obj.name = node->name;
 		obj.unique_name = node->unique_name;
@@ -2227,6 +2194,8 @@ namespace reshade::opengl
 			std::memset(uniform_storage.data() + obj.storage_offset, 0, obj.storage_size);
 		}
 
+		_uniform_storage_offsets[node] = obj.storage_offset;
+
 		_runtime->add_uniform(std::move(obj));
 	}
 	void opengl_effect_compiler::visit_technique(const technique_declaration_node *node)
@@ -2239,16 +2208,80 @@ namespace reshade::opengl
 		const auto obj_data = obj.impl->as<opengl_technique_data>();
 		glGenQueries(1, &obj_data->query);
 
-		if (_uniform_buffer_size != 0)
+		// Lay out a compact uniform block containing only the uniforms this technique actually references
+		const auto layout = layout_uniform_block(_uniform_usage.find(node), uniform_packing::std140);
+
+		std::stringstream uniforms;
+		std::vector<size_t> storage_offsets;
+
+		if (!layout.uniforms.empty())
+		{
+			uniforms << "layout(std140, binding = 0) uniform _GLOBAL_\n{\n";
+
+			for (auto uniform : layout.uniforms)
+			{
+				visit(uniforms, uniform->type, true, false);
+
+				uniforms << ' ' << escape_name(uniform->unique_name);
+
+				if (uniform->type.is_array())
+				{
+					uniforms << '[' << uniform->type.array_length << ']';
+				}
+
+				uniforms << ";\n";
+
+				storage_offsets.push_back(_uniform_storage_offsets.at(uniform));
+			}
+
+			uniforms << "};\n";
+		}
+
+		// Other uniforms may still be referenced by functions this technique does not use, so declare them as plain variables to keep the code valid
+		for (auto variable : _ast.variables)
+		{
+			if (_uniform_storage_offsets.count(variable) && std::find(layout.uniforms.begin(), layout.uniforms.end(), variable) == layout.uniforms.end())
+			{
+				visit(uniforms, variable->type, false, false);
+
+				uniforms << ' ' << escape_name(variable->unique_name);
+
+				if (variable->type.is_array())
+				{
+					uniforms << '[' << variable->type.array_length << ']';
+				}
+
+				uniforms << ";\n";
+			}
+		}
+
+		_technique_uniforms = uniforms.str();
+
+		if (layout.size != 0)
 		{
+			GLuint ubo = 0;
+			glGenBuffers(1, &ubo);
+
+			GLint previous = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &previous);
+
+			glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+			glBufferData(GL_UNIFORM_BUFFER, layout.size, nullptr, GL_DYNAMIC_DRAW);
+
+			glBindBuffer(GL_UNIFORM_BUFFER, previous);
+
 			obj.uniform_storage_index = _runtime->_effect_ubos.size();
-			obj.uniform_storage_offset = _uniform_storage_offset;
+			obj.uniform_block_size = layout.size;
+			obj.uniform_block_ranges = build_uniform_copy_ranges(layout, storage_offsets);
+
+			_runtime->_effect_ubos.emplace_back(ubo, layout.size);
 		}
 
 		for (auto pass : node->pass_list)
 		{
 			obj.passes.emplace_back(std::make_unique<opengl_pass_data>());
 			visit_pass(pass, *static_cast<opengl_pass_data *>(obj.passes.back().get()));
+			obj.pass_texture_usage.push_back(analyze_texture_access(_uniform_usage, pass));
 		}
 
 		_runtime->add_technique(std::move(obj));
@@ -2276,6 +2309,7 @@ namespace reshade::opengl
 		pass.stencil_reference = node->stencil_reference_value;
 		pass.srgb = node->srgb_write_enable;
 		pass.clear_render_targets = node->clear_render_targets;
+		pass.back_buffer_usage = analyze_back_buffer_access(_uniform_usage, node);
 
 		glGenFramebuffers(1, &pass.fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, pass.fbo);
@@ -2338,53 +2372,19 @@ namespace reshade::opengl
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		GLuint shaders[2] = { 0, 0 };
-		GLenum shader_types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+		const GLenum shader_types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
 		const function_declaration_node *shader_functions[2] = { node->vertex_shader, node->pixel_shader };
 
-		pass.program = glCreateProgram();
-
+		// Compilation and linking is deferred until the technique is first enabled, so just store the source code for it
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			if (shader_functions[i] != nullptr)
 			{
-				shaders[i] = glCreateShader(shader_types[i]);
-
-				visit_pass_shader(shader_functions[i], shader_types[i], shaders[i]);
-
-				glAttachShader(pass.program, shaders[i]);
+				visit_pass_shader(shader_functions[i], shader_types[i], pass.shader_sources[i]);
 			}
 		}
-
-		glLinkProgram(pass.program);
-
-		for (unsigned int i = 0; i < 2; i++)
-		{
-			glDetachShader(pass.program, shaders[i]);
-			glDeleteShader(shaders[i]);
-		}
-
-		GLint status = GL_FALSE;
-
-		glGetProgramiv(pass.program, GL_LINK_STATUS, &status);
-
-		if (status == GL_FALSE)
-		{
-			GLint logsize = 0;
-			glGetProgramiv(pass.program, GL_INFO_LOG_LENGTH, &logsize);
-
-			std::string log(logsize, '\0');
-			glGetProgramInfoLog(pass.program, logsize, nullptr, &log.front());
-
-			glDeleteProgram(pass.program);
-			pass.program = 0;
-
-			_errors += log;
-			error(node->location, "program linking failed");
-			return;
-		}
 	}
-	void opengl_effect_compiler::visit_pass_shader(const function_declaration_node *node, unsigned int shadertype, unsigned int &shader)
+	void opengl_effect_compiler::visit_pass_shader(const function_declaration_node *node, unsigned int shadertype, std::string &shader_source)
 	{
 		std::stringstream source;
 
@@ -2405,10 +2405,7 @@ namespace reshade::opengl
 			"vec4 _texelFetch(sampler2D s, ivec4 c) { return texelFetch(s, c.xy - ivec2(vec2(0, 1.0 - 1.0 / exp2(float(c.w))) * textureSize(s, 0)), c.w); }\n"
 			"#define _textureLodOffset(s, c, offset) textureLodOffset(s, (c).xy, (c).w, offset)\n";
 
-		if (_uniform_buffer_size != 0)
-		{
-			source << "layout(std140, binding = 0) uniform _GLOBAL_\n{\n" << _global_uniforms.str() << "};\n";
-		}
+		source << _technique_uniforms;
 
 		if (shadertype != GL_FRAGMENT_SHADER)
 		{
@@ -2649,10 +2646,7 @@ namespace reshade::opengl
 
 		source << "}\n";
 
-		GLint status = GL_FALSE;
-		const std::string source_str = source.str();
-		const GLchar *src = source_str.c_str();
-		const GLsizei len = static_cast<GLsizei>(source_str.size());
+		shader_source = source.str();
 
 #if RESHADE_DUMP_NATIVE_SHADERS
 		if (!_dumped_shaders.count(node->unique_name))
@@ -2661,28 +2655,12 @@ namespace reshade::opengl
 
 			if (dumpfile.is_open())
 			{
-				dumpfile << "#ifdef RESHADE_SHADER_" << shadertype << "_" << node->unique_name << std::endl << source_str << "#endif" << std::endl << std::endl;
+				dumpfile << "#ifdef RESHADE_SHADER_" << shadertype << "_" << node->unique_name << std::endl << shader_source << "#endif" << std::endl << std::endl;
 
 				_dumped_shaders.insert(node->unique_name);
 			}
 		}
 #endif
-
-		glShaderSource(shader, 1, &src, &len);
-		glCompileShader(shader);
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-
-		if (status == GL_FALSE)
-		{
-			GLint logsize = 0;
-			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logsize);
-
-			std::string log(logsize, '\0');
-			glGetShaderInfoLog(shader, logsize, nullptr, &log.front());
-
-			_errors += log;
-			error(node->location, "internal shader compilation failed");
-		}
 	}
 	void opengl_effect_compiler::visit_shader_param(std::stringstream &output, type_node type, unsigned int qualifier, const std::string &name, const std::string &semantic, unsigned int shadertype)
 	{
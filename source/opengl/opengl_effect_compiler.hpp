@@ -5,7 +5,7 @@
 
 #pragma once
 
-#include "effect_syntax_tree.hpp"
+#include "effect_uniform_usage.hpp"
 #include <sstream>
 #include <unordered_set>
 
@@ -63,7 +63,7 @@ namespace reshade::opengl
 		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
 		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, opengl_pass_data &pass);
-		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, unsigned int shadertype, unsigned int &shader);
+		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, unsigned int shadertype, std::string &shader_source);
 		void visit_shader_param(std::stringstream &output, reshadefx::nodes::type_node type, unsigned int qualifier, const std::string &name, const std::string &semantic, unsigned int shadertype);
 
 		struct function
@@ -76,7 +76,10 @@ namespace reshade::opengl
 		bool _success;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
-		std::stringstream _global_code, _global_uniforms;
+		reshadefx::uniform_usage _uniform_usage;
+		std::stringstream _global_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _uniform_storage_offsets;
+		std::string _technique_uniforms;
 		const reshadefx::nodes::function_declaration_node *_current_function;
 		std::unordered_map<const reshadefx::nodes::function_declaration_node *, function> _functions;
 		GLintptr _uniform_storage_offset = 0, _uniform_buffer_size = 0;
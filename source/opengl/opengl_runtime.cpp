@@ -9,6 +9,7 @@
 #include "input.hpp"
 #include <imgui.h>
 #include <assert.h>
+#include <algorithm>
 
 namespace reshade::opengl
 {
@@ -106,6 +107,10 @@ namespace reshade::opengl
 				_vendor_id = 0x8086;
 			}
 		}
+
+		// Only depth buffers with about the size of the back buffer can be copied into the depth texture
+		_depth_buffer_selector.settings().min_scale = 0.95f;
+		_depth_buffer_selector.settings().max_scale = 1.05f;
 	}
 
 	bool opengl_runtime::init_backbuffer_texture()
@@ -477,7 +482,11 @@ namespace reshade::opengl
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 			// Apply post processing
+			_back_buffer_planner.begin_frame();
+
 			on_present_effect();
+
+			_back_buffer_planner.end_frame();
 		}
 
 		// Reset render target and copy to frame buffer
@@ -624,7 +633,16 @@ namespace reshade::opengl
 	{
 		return opengl_effect_compiler(this, ast, errors).run();
 	}
-	bool opengl_runtime::update_texture(texture &texture, const uint8_t *data)
+	upload_layout opengl_runtime::get_upload_layout(const texture &texture) const
+	{
+		upload_layout layout;
+		layout.levels = texture.levels;
+		// Textures are stored upside down in OpenGL
+		layout.flip_vertically = true;
+
+		return layout;
+	}
+	bool opengl_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
 	{
 		if (texture.impl_reference != texture_reference::none)
 		{
@@ -645,28 +663,12 @@ namespace reshade::opengl
 		GLint previous = 0;
 		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
 
-		// Flip image data vertically
-		unsigned int stride = texture.width * 4;
-		std::vector<uint8_t> data_flipped(data, data + stride * texture.height);
-		const auto temp = static_cast<uint8_t *>(alloca(stride));
-
-		for (unsigned int y = 0; 2 * y < texture.height; y++)
-		{
-			const auto line1 = data_flipped.data() + stride * (y);
-			const auto line2 = data_flipped.data() + stride * (texture.height - 1 - y);
-
-			std::memcpy(temp, line1, stride);
-			std::memcpy(line1, line2, stride);
-			std::memcpy(line2, temp, stride);
-		}
-
-		// Bind and update texture
+		// Bind and update texture, the texture loader already flipped the image data and generated all mipmap levels
 		glBindTexture(GL_TEXTURE_2D, texture_impl->id[0]);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height, GL_RGBA, GL_UNSIGNED_BYTE, data_flipped.data());
 
-		if (texture.levels > 1)
+		for (GLint level = 0; level < static_cast<GLint>(std::min(static_cast<GLuint>(levels.size()), texture.levels)); level++)
 		{
-			glGenerateMipmap(GL_TEXTURE_2D);
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levels[level].width, levels[level].height, GL_RGBA, GL_UNSIGNED_BYTE, data + levels[level].offset);
 		}
 
 		glBindTexture(GL_TEXTURE_2D, previous);
@@ -714,8 +716,135 @@ namespace reshade::opengl
 
 		return true;
 	}
+	bool opengl_runtime::alias_texture(texture &texture, const texture &owner)
+	{
+		const auto texture_impl = texture.impl->as<opengl_tex_data>();
+		const auto owner_impl = owner.impl->as<opengl_tex_data>();
+
+		if (texture_impl == nullptr || owner_impl == nullptr || !texture_impl->should_delete)
+		{
+			return false;
+		}
+
+		// Samplers reference the texture data and pick up the change, but the frame buffers of passes rendering to the texture have to be updated
+		for (auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				auto &pass = *pass_object->as<opengl_pass_data>();
+
+				for (GLuint i = 0; i < 8; i++)
+				{
+					for (unsigned int k = 0; k < 2; k++)
+					{
+						if (pass.draw_textures[i] == 0 || pass.draw_textures[i] != texture_impl->id[k])
+						{
+							continue;
+						}
+
+						pass.draw_textures[i] = owner_impl->id[k];
+
+						glBindFramebuffer(GL_FRAMEBUFFER, pass.fbo);
+						glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, owner_impl->id[k], 0);
+						break;
+					}
+				}
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		glDeleteTextures(2, texture_impl->id);
+
+		texture_impl->id[0] = owner_impl->id[0];
+		texture_impl->id[1] = owner_impl->id[1];
+		texture_impl->should_delete = false;
+
+		return true;
+	}
 
-	void opengl_runtime::render_technique(const technique &technique)
+	bool opengl_runtime::create_technique_shaders(technique &technique)
+	{
+		const GLenum shader_types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+		for (const auto &pass_object : technique.passes)
+		{
+			const auto pass = pass_object->as<opengl_pass_data>();
+
+			// OpenGL objects can only be created on the thread the context is current on, so everything happens here rather than on a worker thread
+			GLuint shaders[2] = { 0, 0 };
+			GLint status = GL_FALSE;
+
+			pass->program = glCreateProgram();
+
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				if (pass->shader_sources[i].empty())
+				{
+					continue;
+				}
+
+				const GLchar *src = pass->shader_sources[i].c_str();
+				const GLsizei len = static_cast<GLsizei>(pass->shader_sources[i].size());
+
+				shaders[i] = glCreateShader(shader_types[i]);
+				glShaderSource(shaders[i], 1, &src, &len);
+				glCompileShader(shaders[i]);
+				glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &status);
+
+				if (status == GL_FALSE)
+				{
+					GLint logsize = 0;
+					glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &logsize);
+
+					std::string log(logsize, '\0');
+					glGetShaderInfoLog(shaders[i], logsize, nullptr, &log.front());
+
+					LOG(ERROR) << "Failed to compile shader for technique '" << technique.name << "':\n" << log;
+				}
+
+				glAttachShader(pass->program, shaders[i]);
+			}
+
+			glLinkProgram(pass->program);
+
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				glDetachShader(pass->program, shaders[i]);
+				glDeleteShader(shaders[i]);
+			}
+
+			glGetProgramiv(pass->program, GL_LINK_STATUS, &status);
+
+			if (status == GL_FALSE)
+			{
+				GLint logsize = 0;
+				glGetProgramiv(pass->program, GL_INFO_LOG_LENGTH, &logsize);
+
+				std::string log(logsize, '\0');
+				glGetProgramInfoLog(pass->program, logsize, nullptr, &log.front());
+
+				LOG(ERROR) << "Failed to link program for technique '" << technique.name << "':\n" << log;
+
+				// Delete the programs of all passes, including those that linked successfully, so that nothing leaks when compilation is attempted again
+				for (const auto &other_pass_object : technique.passes)
+				{
+					const auto other_pass = other_pass_object->as<opengl_pass_data>();
+
+					if (other_pass->program != 0)
+					{
+						glDeleteProgram(other_pass->program);
+						other_pass->program = 0;
+					}
+				}
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+	void opengl_runtime::render_technique(technique &technique)
 	{
 		opengl_technique_data &technique_data = *technique.impl->as<opengl_technique_data>();
 
@@ -730,20 +859,31 @@ namespace reshade::opengl
 		if (technique.uniform_storage_index >= 0)
 		{
 			glBindBufferBase(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.uniform_storage_index].first);
-			glBufferSubData(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.uniform_storage_index].second, get_uniform_value_storage().data() + technique.uniform_storage_offset);
+
+			// Each technique owns its uniform buffer, so only the ranges that changed since the last upload have to be updated
+			if (update_uniform_block(technique, _dirty_uniform_ranges))
+			{
+				for (const auto &range : _dirty_uniform_ranges)
+				{
+					glBufferSubData(GL_UNIFORM_BUFFER, range.block_offset, range.size, get_uniform_value_storage().data() + range.storage_offset);
+				}
+			}
 		}
 
 		for (const auto &pass_object : technique.passes)
 		{
 			const opengl_pass_data &pass = *pass_object->as<opengl_pass_data>();
 
-			// Save frame buffer of previous pass
-			glDisable(GL_FRAMEBUFFER_SRGB);
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, _default_backbuffer_fbo);
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _blit_fbo);
-			glReadBuffer(GL_COLOR_ATTACHMENT0);
-			glDrawBuffer(GL_COLOR_ATTACHMENT0);
-			glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			// Save frame buffer of previous pass, but only if this pass samples it and it changed since the last copy
+			if (_back_buffer_planner.plan_pass(pass.back_buffer_usage).copy_source >= 0)
+			{
+				glDisable(GL_FRAMEBUFFER_SRGB);
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, _default_backbuffer_fbo);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _blit_fbo);
+				glReadBuffer(GL_COLOR_ATTACHMENT0);
+				glDrawBuffer(GL_COLOR_ATTACHMENT0);
+				glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
 
 			// Setup states
 			glUseProgram(pass.program);
@@ -894,6 +1034,7 @@ namespace reshade::opengl
 				traffic = 0;
 				_depth_source = 0;
 				create_depth_texture(0, 0, GL_NONE);
+				_depth_buffer_selector.reset();
 				return;
 			}
 			else
@@ -902,33 +1043,20 @@ namespace reshade::opengl
 			}
 		}
 
-		GLuint best_match = 0;
-		depth_source_info best_info = { 0, 0, 0, GL_NONE };
+		_depth_buffer_selector.begin_frame(_width, _height);
 
-		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end(); ++it)
+		for (auto &[depthstencil, depthstencil_info] : _depth_source_table)
 		{
-			const auto depthstencil = it->first;
-			auto &depthstencil_info = it->second;
-
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if (((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls))) &&
-				((depthstencil_info.width > _width * 0.95 && depthstencil_info.width < _width * 1.05) && (depthstencil_info.height > _height * 0.95 && depthstencil_info.height < _height * 1.05)))
-			{
-				best_match = depthstencil;
-				best_info = depthstencil_info;
-			}
+			_depth_buffer_selector.add_depth_buffer({ depthstencil, depthstencil_info.width, depthstencil_info.height, static_cast<uint32_t>(depthstencil_info.format), depthstencil_info.drawcall_count, depthstencil_info.vertices_count });
 
 			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
 		}
 
-		if (best_match == 0)
-		{
-			best_info = _depth_source_table.at(0);
-		}
+		_depth_buffer_selector.end_frame(_drawcalls);
+
+		// Fall back to the default depth buffer if no other one was found
+		GLuint best_match = static_cast<GLuint>(_depth_buffer_selector.selected());
+		const depth_source_info &best_info = _depth_source_table.at(best_match);
 
 		if (_depth_source != best_match || _depth_texture == 0)
 		{
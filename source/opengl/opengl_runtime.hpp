@@ -6,6 +6,7 @@
 #pragma once
 
 #include "runtime.hpp"
+#include "render_graph.hpp"
 #include "opengl_stateblock.hpp"
 
 namespace reshade::opengl
@@ -42,6 +43,8 @@ namespace reshade::opengl
 		GLenum blend_eq_color = GL_NONE, blend_eq_alpha = GL_NONE, blend_src = GL_NONE, blend_dest = GL_NONE, blend_src_alpha = GL_NONE, blend_dest_alpha = GL_NONE;
 		GLboolean color_mask[4] = { };
 		bool srgb = false, blend = false, stencil_test = false, clear_render_targets = true;
+		back_buffer_access back_buffer_usage;
+		std::string shader_sources[2];
 	};
 	struct opengl_technique_data : base_object
 	{
@@ -76,10 +79,13 @@ namespace reshade::opengl
 
 		void capture_frame(uint8_t *buffer) const override;
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
-		bool update_texture(texture &texture, const uint8_t *data) override;
+		upload_layout get_upload_layout(const texture &texture) const override;
+		bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) override;
+		bool alias_texture(texture &texture, const texture &owner) override;
 		bool update_texture_reference(texture &texture, texture_reference id);
 
-		void render_technique(const technique &technique) override;
+		bool create_technique_shaders(technique &technique) override;
+		void render_technique(technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
 		HDC _hdc;
@@ -87,9 +93,11 @@ namespace reshade::opengl
 		GLuint _reference_count = 1, _current_vertex_count = 0;
 		GLuint _default_backbuffer_fbo = 0, _default_backbuffer_rbo[2] = { }, _backbuffer_texture[2] = { };
 		GLuint _depth_source_fbo = 0, _depth_source = 0, _depth_texture = 0, _blit_fbo = 0;
+		back_buffer_planner _back_buffer_planner { 1, false };
 		std::vector<struct opengl_sampler> _effect_samplers;
 		GLuint _default_vao = 0;
 		std::vector<std::pair<GLuint, GLsizeiptr>> _effect_ubos;
+		std::vector<uniform_copy_range> _dirty_uniform_ranges;
 
 	private:
 		struct depth_source_info
@@ -10,7 +10,7 @@
 #include <memory>
 #include <unordered_set>
 
-extern std::unordered_map<HDC, reshade::opengl::opengl_runtime *> g_opengl_runtimes;
+extern thread_local reshade::opengl::opengl_runtime *g_current_runtime;
 
 HOOK_EXPORT void WINAPI glAccum(GLenum op, GLfloat value)
 {
@@ -42,9 +42,9 @@ HOOK_EXPORT void WINAPI glArrayElement(GLint i)
 
 HOOK_EXPORT void WINAPI glBegin(GLenum mode)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count = 0;
+		runtime->_current_vertex_count = 0;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glBegin);
@@ -431,9 +431,9 @@ HOOK_EXPORT void WINAPI glDisableClientState(GLenum array)
 
 HOOK_EXPORT void WINAPI glDrawArrays(GLenum mode, GLint first, GLsizei count)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		runtime->on_draw_call(count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawArrays);
@@ -448,9 +448,9 @@ extern "C"  void WINAPI glDrawArraysIndirect(GLenum mode, const GLvoid *indirect
 }
 extern "C"  void WINAPI glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstanced);
@@ -459,9 +459,9 @@ extern "C"  void WINAPI glDrawArraysInstanced(GLenum mode, GLint first, GLsizei
 }
 extern "C"  void WINAPI glDrawArraysInstancedARB(GLenum mode, GLint first, GLsizei count, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedARB);
@@ -470,9 +470,9 @@ extern "C"  void WINAPI glDrawArraysInstancedARB(GLenum mode, GLint first, GLsiz
 }
 extern "C"  void WINAPI glDrawArraysInstancedEXT(GLenum mode, GLint first, GLsizei count, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedEXT);
@@ -481,9 +481,9 @@ extern "C"  void WINAPI glDrawArraysInstancedEXT(GLenum mode, GLint first, GLsiz
 }
 extern "C"  void WINAPI glDrawArraysInstancedBaseInstance(GLenum mode, GLint first, GLsizei count, GLsizei primcount, GLuint baseinstance)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedBaseInstance);
@@ -500,9 +500,9 @@ HOOK_EXPORT void WINAPI glDrawBuffer(GLenum mode)
 
 HOOK_EXPORT void WINAPI glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		runtime->on_draw_call(count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElements);
@@ -511,9 +511,9 @@ HOOK_EXPORT void WINAPI glDrawElements(GLenum mode, GLsizei count, GLenum type,
 }
 extern "C"  void WINAPI glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLint basevertex)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		runtime->on_draw_call(count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsBaseVertex);
@@ -528,9 +528,9 @@ extern "C"  void WINAPI glDrawElementsIndirect(GLenum mode, GLenum type, const G
 }
 extern "C"  void WINAPI glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstanced);
@@ -539,9 +539,9 @@ extern "C"  void WINAPI glDrawElementsInstanced(GLenum mode, GLsizei count, GLen
 }
 extern "C"  void WINAPI glDrawElementsInstancedARB(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedARB);
@@ -550,9 +550,9 @@ extern "C"  void WINAPI glDrawElementsInstancedARB(GLenum mode, GLsizei count, G
 }
 extern "C"  void WINAPI glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedEXT);
@@ -561,9 +561,9 @@ extern "C"  void WINAPI glDrawElementsInstancedEXT(GLenum mode, GLsizei count, G
 }
 extern "C"  void WINAPI glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount, GLint basevertex)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseVertex);
@@ -572,9 +572,9 @@ extern "C"  void WINAPI glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei c
 }
 extern "C"  void WINAPI glDrawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount, GLuint baseinstance)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseInstance);
@@ -583,9 +583,9 @@ extern "C"  void WINAPI glDrawElementsInstancedBaseInstance(GLenum mode, GLsizei
 }
 extern "C"  void WINAPI glDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount, GLint basevertex, GLuint baseinstance)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		runtime->on_draw_call(primcount * count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseVertexBaseInstance);
@@ -602,9 +602,9 @@ HOOK_EXPORT void WINAPI glDrawPixels(GLsizei width, GLsizei height, GLenum forma
 
 extern "C"  void WINAPI glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const GLvoid *indices)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		runtime->on_draw_call(count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawRangeElements);
@@ -613,9 +613,9 @@ extern "C"  void WINAPI glDrawRangeElements(GLenum mode, GLuint start, GLuint en
 }
 extern "C"  void WINAPI glDrawRangeElementsBaseVertex(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const GLvoid *indices, GLint basevertex)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		runtime->on_draw_call(count);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glDrawRangeElementsBaseVertex);
@@ -661,9 +661,9 @@ HOOK_EXPORT void WINAPI glEnd()
 
 	trampoline();
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_draw_call(it->second->_current_vertex_count);
+		runtime->on_draw_call(runtime->_current_vertex_count);
 	}
 }
 
@@ -800,9 +800,9 @@ extern "C"  void WINAPI glFramebufferRenderbuffer(GLenum target, GLenum attachme
 
 	trampoline(target, attachment, renderbuffertarget, renderbuffer);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
+		runtime->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
 	}
 }
 extern "C"  void WINAPI glFramebufferRenderbufferEXT(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
@@ -811,9 +811,9 @@ extern "C"  void WINAPI glFramebufferRenderbufferEXT(GLenum target, GLenum attac
 
 	trampoline(target, attachment, renderbuffertarget, renderbuffer);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
+		runtime->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -822,9 +822,9 @@ extern "C"  void WINAPI glFramebufferTexture(GLenum target, GLenum attachment, G
 
 	trampoline(target, attachment, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTextureARB(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -833,9 +833,9 @@ extern "C"  void WINAPI glFramebufferTextureARB(GLenum target, GLenum attachment
 
 	trampoline(target, attachment, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTextureEXT(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -844,9 +844,9 @@ extern "C"  void WINAPI glFramebufferTextureEXT(GLenum target, GLenum attachment
 
 	trampoline(target, attachment, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture1D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -855,9 +855,9 @@ extern "C"  void WINAPI glFramebufferTexture1D(GLenum target, GLenum attachment,
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture1DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -866,9 +866,9 @@ extern "C"  void WINAPI glFramebufferTexture1DEXT(GLenum target, GLenum attachme
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -877,9 +877,9 @@ extern "C"  void WINAPI glFramebufferTexture2D(GLenum target, GLenum attachment,
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture2DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -888,9 +888,9 @@ extern "C"  void WINAPI glFramebufferTexture2DEXT(GLenum target, GLenum attachme
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture3D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLint zoffset)
@@ -899,9 +899,9 @@ extern "C"  void WINAPI glFramebufferTexture3D(GLenum target, GLenum attachment,
 
 	trampoline(target, attachment, textarget, texture, level, zoffset);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTexture3DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLint zoffset)
@@ -910,9 +910,9 @@ extern "C"  void WINAPI glFramebufferTexture3DEXT(GLenum target, GLenum attachme
 
 	trampoline(target, attachment, textarget, texture, level, zoffset);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -921,9 +921,9 @@ extern "C"  void WINAPI glFramebufferTextureLayer(GLenum target, GLenum attachme
 
 	trampoline(target, attachment, texture, level, layer);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTextureLayerARB(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -932,9 +932,9 @@ extern "C"  void WINAPI glFramebufferTextureLayerARB(GLenum target, GLenum attac
 
 	trampoline(target, attachment, texture, level, layer);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 extern "C"  void WINAPI glFramebufferTextureLayerEXT(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -943,9 +943,9 @@ extern "C"  void WINAPI glFramebufferTextureLayerEXT(GLenum target, GLenum attac
 
 	trampoline(target, attachment, texture, level, layer);
 
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 
@@ -1481,7 +1481,7 @@ HOOK_EXPORT void WINAPI glMultMatrixf(const GLfloat *m)
 
 extern "C"  void WINAPI glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1490,7 +1490,7 @@ extern "C"  void WINAPI glMultiDrawArrays(GLenum mode, const GLint *first, const
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		runtime->on_draw_call(totalcount);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawArrays);
@@ -1505,7 +1505,7 @@ extern "C"  void WINAPI glMultiDrawArraysIndirect(GLenum mode, const void *indir
 }
 extern "C"  void WINAPI glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type, const GLvoid *const *indices, GLsizei drawcount)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1514,7 +1514,7 @@ extern "C"  void WINAPI glMultiDrawElements(GLenum mode, const GLsizei *count, G
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		runtime->on_draw_call(totalcount);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawElements);
@@ -1523,7 +1523,7 @@ extern "C"  void WINAPI glMultiDrawElements(GLenum mode, const GLsizei *count, G
 }
 extern "C"  void WINAPI glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type, const GLvoid *const *indices, GLsizei drawcount, const GLint *basevertex)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1532,7 +1532,7 @@ extern "C"  void WINAPI glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		runtime->on_draw_call(totalcount);
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawElementsBaseVertex);
@@ -2452,9 +2452,9 @@ HOOK_EXPORT void WINAPI glTranslatef(GLfloat x, GLfloat y, GLfloat z)
 
 HOOK_EXPORT void WINAPI glVertex2d(GLdouble x, GLdouble y)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2d);
@@ -2463,9 +2463,9 @@ HOOK_EXPORT void WINAPI glVertex2d(GLdouble x, GLdouble y)
 }
 HOOK_EXPORT void WINAPI glVertex2dv(const GLdouble *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2dv);
@@ -2474,9 +2474,9 @@ HOOK_EXPORT void WINAPI glVertex2dv(const GLdouble *v)
 }
 HOOK_EXPORT void WINAPI glVertex2f(GLfloat x, GLfloat y)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2f);
@@ -2485,9 +2485,9 @@ HOOK_EXPORT void WINAPI glVertex2f(GLfloat x, GLfloat y)
 }
 HOOK_EXPORT void WINAPI glVertex2fv(const GLfloat *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2fv);
@@ -2496,9 +2496,9 @@ HOOK_EXPORT void WINAPI glVertex2fv(const GLfloat *v)
 }
 HOOK_EXPORT void WINAPI glVertex2i(GLint x, GLint y)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2i);
@@ -2507,9 +2507,9 @@ HOOK_EXPORT void WINAPI glVertex2i(GLint x, GLint y)
 }
 HOOK_EXPORT void WINAPI glVertex2iv(const GLint *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2iv);
@@ -2518,9 +2518,9 @@ HOOK_EXPORT void WINAPI glVertex2iv(const GLint *v)
 }
 HOOK_EXPORT void WINAPI glVertex2s(GLshort x, GLshort y)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2s);
@@ -2529,9 +2529,9 @@ HOOK_EXPORT void WINAPI glVertex2s(GLshort x, GLshort y)
 }
 HOOK_EXPORT void WINAPI glVertex2sv(const GLshort *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		runtime->_current_vertex_count += 2;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex2sv);
@@ -2540,9 +2540,9 @@ HOOK_EXPORT void WINAPI glVertex2sv(const GLshort *v)
 }
 HOOK_EXPORT void WINAPI glVertex3d(GLdouble x, GLdouble y, GLdouble z)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3d);
@@ -2551,9 +2551,9 @@ HOOK_EXPORT void WINAPI glVertex3d(GLdouble x, GLdouble y, GLdouble z)
 }
 HOOK_EXPORT void WINAPI glVertex3dv(const GLdouble *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3dv);
@@ -2562,9 +2562,9 @@ HOOK_EXPORT void WINAPI glVertex3dv(const GLdouble *v)
 }
 HOOK_EXPORT void WINAPI glVertex3f(GLfloat x, GLfloat y, GLfloat z)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3f);
@@ -2573,9 +2573,9 @@ HOOK_EXPORT void WINAPI glVertex3f(GLfloat x, GLfloat y, GLfloat z)
 }
 HOOK_EXPORT void WINAPI glVertex3fv(const GLfloat *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3fv);
@@ -2584,9 +2584,9 @@ HOOK_EXPORT void WINAPI glVertex3fv(const GLfloat *v)
 }
 HOOK_EXPORT void WINAPI glVertex3i(GLint x, GLint y, GLint z)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3i);
@@ -2595,9 +2595,9 @@ HOOK_EXPORT void WINAPI glVertex3i(GLint x, GLint y, GLint z)
 }
 HOOK_EXPORT void WINAPI glVertex3iv(const GLint *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3iv);
@@ -2606,9 +2606,9 @@ HOOK_EXPORT void WINAPI glVertex3iv(const GLint *v)
 }
 HOOK_EXPORT void WINAPI glVertex3s(GLshort x, GLshort y, GLshort z)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3s);
@@ -2617,9 +2617,9 @@ HOOK_EXPORT void WINAPI glVertex3s(GLshort x, GLshort y, GLshort z)
 }
 HOOK_EXPORT void WINAPI glVertex3sv(const GLshort *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		runtime->_current_vertex_count += 3;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex3sv);
@@ -2628,9 +2628,9 @@ HOOK_EXPORT void WINAPI glVertex3sv(const GLshort *v)
 }
 HOOK_EXPORT void WINAPI glVertex4d(GLdouble x, GLdouble y, GLdouble z, GLdouble w)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4d);
@@ -2639,9 +2639,9 @@ HOOK_EXPORT void WINAPI glVertex4d(GLdouble x, GLdouble y, GLdouble z, GLdouble
 }
 HOOK_EXPORT void WINAPI glVertex4dv(const GLdouble *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4dv);
@@ -2650,9 +2650,9 @@ HOOK_EXPORT void WINAPI glVertex4dv(const GLdouble *v)
 }
 HOOK_EXPORT void WINAPI glVertex4f(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4f);
@@ -2661,9 +2661,9 @@ HOOK_EXPORT void WINAPI glVertex4f(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 }
 HOOK_EXPORT void WINAPI glVertex4fv(const GLfloat *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4fv);
@@ -2672,9 +2672,9 @@ HOOK_EXPORT void WINAPI glVertex4fv(const GLfloat *v)
 }
 HOOK_EXPORT void WINAPI glVertex4i(GLint x, GLint y, GLint z, GLint w)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4i);
@@ -2683,9 +2683,9 @@ HOOK_EXPORT void WINAPI glVertex4i(GLint x, GLint y, GLint z, GLint w)
 }
 HOOK_EXPORT void WINAPI glVertex4iv(const GLint *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4iv);
@@ -2694,9 +2694,9 @@ HOOK_EXPORT void WINAPI glVertex4iv(const GLint *v)
 }
 HOOK_EXPORT void WINAPI glVertex4s(GLshort x, GLshort y, GLshort z, GLshort w)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4s);
@@ -2705,9 +2705,9 @@ HOOK_EXPORT void WINAPI glVertex4s(GLshort x, GLshort y, GLshort z, GLshort w)
 }
 HOOK_EXPORT void WINAPI glVertex4sv(const GLshort *v)
 {
-	if (const auto it = g_opengl_runtimes.find(wglGetCurrentDC()); it != g_opengl_runtimes.end())
+	if (const auto runtime = g_current_runtime; runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		runtime->_current_vertex_count += 4;
 	}
 
 	static const auto trampoline = reshade::hooks::call(&glVertex4sv);
@@ -20,6 +20,8 @@ static std::unordered_map<HWND, RECT> s_window_rects;
 static std::unordered_set<HDC> s_pbuffer_device_contexts;
 static std::unordered_map<HGLRC, HGLRC> s_shared_contexts;
 std::unordered_map<HDC, reshade::opengl::opengl_runtime *> g_opengl_runtimes;
+// Runtime of the device context that is current on the calling thread, so that hooks called on every draw do not have to look it up
+thread_local reshade::opengl::opengl_runtime *g_current_runtime = nullptr;
 
 HOOK_EXPORT int   WINAPI wglChoosePixelFormat(HDC hdc, const PIXELFORMATDESCRIPTOR *ppfd)
 {
@@ -591,6 +593,9 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 		}
 	}
 
+	// A failed call leaves no context current either, so always reset the cached runtime
+	g_current_runtime = nullptr;
+
 	if (!trampoline(hdc, hglrc))
 	{
 		LOG(WARNING) << "> 'wglMakeCurrent' failed with error code " << (GetLastError() & 0xFFFF) << "!";
@@ -609,6 +614,8 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 	{
 		it->second->_reference_count++;
 
+		g_current_runtime = it->second;
+
 		LOG(INFO) << "> Switched to existing runtime " << it->second << ".";
 	}
 	else
@@ -728,6 +735,8 @@ HOOK_EXPORT BOOL  WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 
 			g_opengl_runtimes[hdc] = runtime;
 
+			g_current_runtime = runtime;
+
 			LOG(INFO) << "> Switched to new runtime " << runtime << ".";
 		}
 		else
@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "preset_index.hpp"
+#include <fstream>
+#include <algorithm>
+
+namespace reshade
+{
+	static const char index_magic[4] = { 'R', 'S', 'P', 'I' };
+	static const uint32_t index_version = 1;
+
+	static void write_uint(std::ostream &stream, uint64_t value, unsigned int size)
+	{
+		char bytes[8];
+
+		for (unsigned int i = 0; i < size; i++)
+		{
+			bytes[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+		}
+
+		stream.write(bytes, size);
+	}
+	static bool read_uint(std::istream &stream, uint64_t &value, unsigned int size)
+	{
+		unsigned char bytes[8];
+
+		if (!stream.read(reinterpret_cast<char *>(bytes), size))
+		{
+			return false;
+		}
+
+		value = 0;
+
+		for (unsigned int i = 0; i < size; i++)
+		{
+			value |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+		}
+
+		return true;
+	}
+
+	bool preset_index::is_preset(const filesystem::path &path)
+	{
+		std::ifstream file(path.native(), std::ios::in | std::ios::binary);
+
+		bool result = false;
+
+		for (std::string line; std::getline(file, line);)
+		{
+			const size_t first = line.find_first_not_of(" \t");
+
+			if (first == std::string::npos)
+			{
+				continue;
+			}
+
+			// The global section ends at the first section, so there is no need to look any further
+			if (line[first] == '[')
+			{
+				break;
+			}
+
+			if (line.compare(first, 10, "Techniques") != 0)
+			{
+				continue;
+			}
+
+			const size_t assign_index = line.find_first_not_of(" \t", first + 10);
+
+			if (assign_index == std::string::npos || line[assign_index] != '=')
+			{
+				continue;
+			}
+
+			// The last occurrence of a key wins, so keep going
+			result = line.find_first_not_of(" \t\r", assign_index + 1) != std::string::npos;
+		}
+
+		return result;
+	}
+
+	std::vector<filesystem::path> preset_index::update(const std::vector<filesystem::file_info> &files)
+	{
+		std::vector<filesystem::path> presets;
+		std::unordered_map<std::string, entry> entries;
+		entries.reserve(files.size());
+
+		for (const auto &file : files)
+		{
+			std::string key = file.file_path.string();
+			entry entry;
+
+			if (const auto it = _entries.find(key); it != _entries.end() && it->second.last_write_time == file.last_write_time && it->second.size == file.size)
+			{
+				entry = it->second;
+			}
+			else
+			{
+				entry.last_write_time = file.last_write_time;
+				entry.size = file.size;
+				entry.is_preset = is_preset(file.file_path);
+
+				_modified = true;
+			}
+
+			if (entry.is_preset)
+			{
+				presets.push_back(file.file_path);
+			}
+
+			entries.emplace(std::move(key), entry);
+		}
+
+		// Files that no longer exist are dropped from the index
+		if (entries.size() != _entries.size())
+		{
+			_modified = true;
+		}
+
+		_entries = std::move(entries);
+
+		return presets;
+	}
+
+	bool preset_index::save(std::ostream &stream) const
+	{
+		stream.write(index_magic, sizeof(index_magic));
+		write_uint(stream, index_version, 4);
+		write_uint(stream, _entries.size(), 4);
+
+		for (const auto &[path, entry] : _entries)
+		{
+			write_uint(stream, path.size(), 4);
+			stream.write(path.data(), path.size());
+			write_uint(stream, entry.last_write_time, 8);
+			write_uint(stream, entry.size, 8);
+			write_uint(stream, entry.is_preset ? 1 : 0, 1);
+		}
+
+		return stream.good();
+	}
+	bool preset_index::load(std::istream &stream)
+	{
+		_entries.clear();
+		_modified = true;
+
+		char magic[sizeof(index_magic)];
+		uint64_t version, count;
+
+		if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), index_magic) ||
+			!read_uint(stream, version, 4) || version != index_version || !read_uint(stream, count, 4))
+		{
+			return false;
+		}
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			uint64_t path_length, is_preset;
+			std::string path;
+			entry entry;
+
+			// Paths on Windows are limited to 32767 characters, so anything longer means the index is corrupted
+			if (!read_uint(stream, path_length, 4) || path_length == 0 || path_length > 32767)
+			{
+				_entries.clear();
+				return false;
+			}
+
+			path.resize(static_cast<size_t>(path_length));
+
+			if (!stream.read(&path[0], path.size()) ||
+				!read_uint(stream, entry.last_write_time, 8) || !read_uint(stream, entry.size, 8) || !read_uint(stream, is_preset, 1))
+			{
+				_entries.clear();
+				return false;
+			}
+
+			entry.is_preset = is_preset != 0;
+
+			_entries.emplace(std::move(path), entry);
+		}
+
+		_modified = false;
+
+		return true;
+	}
+}
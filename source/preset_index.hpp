@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <iosfwd>
+#include <unordered_map>
+#include "filesystem.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// A persistent record of which files are presets, so that only files which were added or changed since have to be read again to find out.
+	/// The binary format is a "RSPI" magic and a version number, followed by the number of files and one record per file. Each record holds the length of the path, the path as UTF-8, the last write time and size of the file and whether it is a preset. All values are stored as little-endian integers.
+	/// </summary>
+	class preset_index
+	{
+	public:
+		/// <summary>
+		/// Returns whether a file is a preset, which is the case if it lists techniques in its global section.
+		/// This only scans the lines up to the first section instead of parsing the whole file.
+		/// </summary>
+		static bool is_preset(const filesystem::path &path);
+
+		/// <summary>
+		/// Returns whether the index changed since it was loaded and should be saved again.
+		/// </summary>
+		bool modified() const { return _modified; }
+
+		/// <summary>
+		/// Update the index to contain exactly the specified files and return which of them are presets.
+		/// Only files which are not in the index yet or whose last write time or size changed are read.
+		/// </summary>
+		/// <param name="files">The files to check, together with their last write time and size.</param>
+		/// <returns>The paths of all presets among the files, in the same order.</returns>
+		std::vector<filesystem::path> update(const std::vector<filesystem::file_info> &files);
+
+		/// <summary>
+		/// Write the index to a binary stream.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if writing failed.</returns>
+		bool save(std::ostream &stream) const;
+		/// <summary>
+		/// Replace the index with the one read from a binary stream.
+		/// </summary>
+		/// <returns><c>true</c> on success, <c>false</c> if the stream does not contain a valid index.</returns>
+		bool load(std::istream &stream);
+
+	private:
+		struct entry
+		{
+			uint64_t last_write_time = 0, size = 0;
+			bool is_preset = false;
+		};
+
+		std::unordered_map<std::string, entry> _entries;
+		bool _modified = false;
+	};
+}
@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "render_graph.hpp"
+#include <assert.h>
+#include <numeric>
+#include <algorithm>
+
+namespace reshade
+{
+	back_buffer_planner::back_buffer_planner(unsigned int texture_count, bool render_to_textures) :
+		_surface_count(texture_count + 1),
+		_render_to_textures(render_to_textures)
+	{
+		assert(texture_count > 0 && _surface_count <= 32);
+	}
+
+	void back_buffer_planner::begin_frame()
+	{
+		_valid_surfaces = 1;
+		_copies = _passes = 0;
+	}
+	back_buffer_step back_buffer_planner::plan_pass(const back_buffer_access &access)
+	{
+		back_buffer_step step;
+
+		const auto copy = [this, &step](int source, int destination)
+		{
+			assert(step.copy_source < 0);
+
+			step.copy_source = source;
+			step.copy_destination = destination;
+
+			_valid_surfaces |= 1 << destination;
+			_copies++;
+		};
+		const auto first_valid = [this]()
+		{
+			int surface = 0;
+			while ((_valid_surfaces & (1 << surface)) == 0)
+				surface++;
+			return surface;
+		};
+
+		_passes++;
+
+		if (access.reads)
+		{
+			step.read_surface = find_valid_texture(-1);
+
+			// None of the textures is up to date, so copy the current contents into one
+			if (step.read_surface < 0)
+			{
+				copy(first_valid(), 1);
+
+				step.read_surface = 1;
+			}
+		}
+
+		if (access.writes)
+		{
+			if (!_render_to_textures)
+			{
+				// Passes always render to the back buffer, which therefore always holds the current contents
+				step.write_surface = 0;
+			}
+			else if (access.overwrites)
+			{
+				// Previous contents do not matter, so render to a texture that is not sampled, which lets the next pass sample it without a copy
+				step.write_surface = 0;
+
+				for (int surface = 1; surface < static_cast<int>(_surface_count); surface++)
+				{
+					if (surface != step.read_surface)
+					{
+						step.write_surface = surface;
+						break;
+					}
+				}
+			}
+			else
+			{
+				// The pass blends with the previous contents, so it has to render to a surface which holds them, but is not sampled at the same time
+				if ((_valid_surfaces & 1) != 0)
+				{
+					step.write_surface = 0;
+				}
+				else
+				{
+					step.write_surface = find_valid_texture(step.read_surface);
+				}
+
+				// Otherwise restore the contents to the back buffer, which has to end up with them anyway
+				if (step.write_surface < 0)
+				{
+					copy(first_valid(), 0);
+
+					step.write_surface = 0;
+				}
+			}
+
+			_valid_surfaces = 1 << step.write_surface;
+		}
+
+		return step;
+	}
+	int back_buffer_planner::end_frame()
+	{
+		if ((_valid_surfaces & 1) != 0)
+		{
+			return -1;
+		}
+
+		_copies++;
+
+		return find_valid_texture(-1);
+	}
+
+	int back_buffer_planner::find_valid_texture(int exclude) const
+	{
+		for (int surface = 1; surface < static_cast<int>(_surface_count); surface++)
+		{
+			if (surface != exclude && (_valid_surfaces & (1 << surface)) != 0)
+			{
+				return surface;
+			}
+		}
+
+		return -1;
+	}
+
+	texture_alias_planner::texture_alias_planner(std::vector<texture_alias_desc> textures) :
+		_textures(std::move(textures)),
+		_lifetimes(_textures.size())
+	{
+	}
+
+	void texture_alias_planner::begin_technique()
+	{
+		_technique++;
+	}
+	void texture_alias_planner::add_pass(const std::vector<size_t> &reads, const std::vector<size_t> &writes, bool overwrites)
+	{
+		_pass++;
+
+		// Samplers are read before the render targets are written, so a texture that is sampled first has to keep the contents from before
+		for (size_t index : reads)
+		{
+			access(index, false);
+		}
+		for (size_t index : writes)
+		{
+			access(index, overwrites);
+		}
+	}
+
+	std::vector<size_t> texture_alias_planner::plan() const
+	{
+		std::vector<size_t> owners(_textures.size());
+		std::iota(owners.begin(), owners.end(), size_t(0));
+
+		std::vector<size_t> transient;
+
+		for (size_t index = 0; index < _textures.size(); index++)
+		{
+			if (_lifetimes[index].used && !_lifetimes[index].persistent && !_textures[index].pinned)
+			{
+				transient.push_back(index);
+			}
+		}
+
+		// Assigning memory in the order the lifetimes start uses the minimal amount of allocations for each group of compatible textures
+		std::stable_sort(transient.begin(), transient.end(), [this](size_t lhs, size_t rhs) {
+			return _lifetimes[lhs].first_pass < _lifetimes[rhs].first_pass;
+		});
+
+		struct allocation
+		{
+			size_t owner, last_pass;
+		};
+
+		std::vector<allocation> allocations;
+
+		for (size_t index : transient)
+		{
+			const auto &desc = _textures[index];
+			const auto &lifetime = _lifetimes[index];
+
+			const auto it = std::find_if(allocations.begin(), allocations.end(), [this, &desc, &lifetime](const allocation &allocation) {
+				const auto &owner_desc = _textures[allocation.owner];
+
+				return allocation.last_pass < lifetime.first_pass &&
+					owner_desc.width == desc.width &&
+					owner_desc.height == desc.height &&
+					owner_desc.levels == desc.levels &&
+					owner_desc.format == desc.format;
+			});
+
+			if (it != allocations.end())
+			{
+				owners[index] = it->owner;
+				it->last_pass = lifetime.last_pass;
+			}
+			else
+			{
+				allocations.push_back({ index, lifetime.last_pass });
+			}
+		}
+
+		return owners;
+	}
+
+	void texture_alias_planner::access(size_t index, bool overwrites)
+	{
+		assert(index < _lifetimes.size());
+
+		auto &lifetime = _lifetimes[index];
+
+		if (!lifetime.used)
+		{
+			lifetime.used = true;
+			lifetime.technique = _technique;
+			lifetime.first_pass = _pass;
+			lifetime.persistent = !overwrites;
+		}
+		else if (lifetime.technique != _technique)
+		{
+			// The contents may be passed on between techniques, which can be toggled independently, so they have to be kept
+			lifetime.persistent = true;
+		}
+
+		lifetime.last_pass = _pass;
+	}
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "runtime_objects.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// The operations a backend has to perform before rendering a pass.
+	/// </summary>
+	struct back_buffer_step
+	{
+		/// <summary>
+		/// Surface to copy from and to before the pass, or -1 if no copy is necessary.
+		/// </summary>
+		int copy_source = -1, copy_destination = -1;
+		/// <summary>
+		/// Surface that has to be bound in place of the back buffer texture for sampling, or -1 if the pass does not sample the back buffer.
+		/// </summary>
+		int read_surface = -1;
+		/// <summary>
+		/// Surface that has to be bound in place of the back buffer render target, or -1 if the pass does not render to the back buffer.
+		/// </summary>
+		int write_surface = -1;
+	};
+
+	/// <summary>
+	/// Planner which keeps track of which surfaces hold the current back buffer contents and schedules the minimal amount of copies between them.
+	/// Surface 0 is the back buffer itself, which can only be rendered to. All other surfaces are textures that can be sampled.
+	/// </summary>
+	class back_buffer_planner
+	{
+	public:
+		/// <summary>
+		/// Construct a new planner.
+		/// </summary>
+		/// <param name="texture_count">The number of textures available in addition to the back buffer.</param>
+		/// <param name="render_to_textures">Whether passes may render to these textures instead of the back buffer, which allows ping-ponging between them instead of copying.</param>
+		back_buffer_planner(unsigned int texture_count, bool render_to_textures);
+
+		/// <summary>
+		/// Start a new frame. The back buffer holds the current contents, all textures are stale.
+		/// </summary>
+		void begin_frame();
+		/// <summary>
+		/// Schedule the next pass.
+		/// </summary>
+		/// <param name="access">The way the pass accesses the back buffer.</param>
+		back_buffer_step plan_pass(const back_buffer_access &access);
+		/// <summary>
+		/// Finish the current frame.
+		/// </summary>
+		/// <returns>The surface that has to be copied to the back buffer, or -1 if it already holds the current contents.</returns>
+		int end_frame();
+
+		/// <summary>
+		/// Return the number of copies scheduled in the current frame.
+		/// </summary>
+		unsigned int copies() const { return _copies; }
+		/// <summary>
+		/// Return the number of copies skipped in the current frame, compared to copying the back buffer before every pass.
+		/// </summary>
+		unsigned int elided_copies() const { return _passes > _copies ? _passes - _copies : 0; }
+
+	private:
+		int find_valid_texture(int exclude) const;
+
+		unsigned int _surface_count;
+		bool _render_to_textures;
+		unsigned int _valid_surfaces = 1;
+		unsigned int _copies = 0, _passes = 0;
+	};
+
+	/// <summary>
+	/// The properties of a texture that decide whether it can share memory with another one.
+	/// </summary>
+	struct texture_alias_desc
+	{
+		unsigned int width = 0, height = 0, levels = 0;
+		texture_format format = texture_format::unknown;
+		/// <summary>
+		/// Whether the texture has to keep its own memory regardless of how it is used, e.g. because its contents were loaded from an image file.
+		/// </summary>
+		bool pinned = false;
+	};
+
+	/// <summary>
+	/// Planner which finds textures that only hold intermediate results inside a single technique and lets those with the same dimensions and format share memory when their lifetimes do not overlap.
+	/// A texture is transient if it is only accessed by one technique and completely overwritten before it is sampled. All other textures may carry their contents across techniques or frames and keep their own memory.
+	/// </summary>
+	class texture_alias_planner
+	{
+	public:
+		/// <summary>
+		/// Construct a new planner.
+		/// </summary>
+		/// <param name="textures">The textures to plan memory for. They are referenced by their index in this list.</param>
+		explicit texture_alias_planner(std::vector<texture_alias_desc> textures);
+
+		/// <summary>
+		/// Start the next technique. Techniques have to be added in the order they are rendered.
+		/// </summary>
+		void begin_technique();
+		/// <summary>
+		/// Add the next pass of the current technique.
+		/// </summary>
+		/// <param name="reads">The textures the pass samples.</param>
+		/// <param name="writes">The textures the pass renders to.</param>
+		/// <param name="overwrites">Whether the pass replaces the previous contents of the textures it renders to completely.</param>
+		void add_pass(const std::vector<size_t> &reads, const std::vector<size_t> &writes, bool overwrites);
+
+		/// <summary>
+		/// Assign memory to all textures.
+		/// </summary>
+		/// <returns>A list with the index of the texture whose memory each texture uses, which is its own index for textures that keep their memory.</returns>
+		std::vector<size_t> plan() const;
+
+	private:
+		struct lifetime
+		{
+			bool used = false, persistent = false;
+			size_t technique = 0, first_pass = 0, last_pass = 0;
+		};
+
+		void access(size_t index, bool overwrites);
+
+		std::vector<texture_alias_desc> _textures;
+		std::vector<lifetime> _lifetimes;
+		size_t _technique = 0, _pass = 0;
+	};
+}
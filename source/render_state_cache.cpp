@@ -0,0 +1,264 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "render_state_cache.hpp"
+#include <assert.h>
+#include <iterator>
+#include <algorithm>
+
+namespace reshade
+{
+	// Value of every slot whose state is not known, which never compares equal to an actual handle
+	static const uintptr_t unknown_handle = ~uintptr_t(0);
+	static const uint64_t unknown_value = ~uint64_t(0);
+
+	render_state_cache::render_state_cache()
+	{
+		invalidate();
+	}
+
+	void render_state_cache::invalidate()
+	{
+		_vertex_shader = _pixel_shader = unknown_value;
+		_state_block = unknown_value;
+		_blend_state = unknown_value;
+		_depth_stencil_state = _stencil_reference = unknown_value;
+		_constant_buffer = unknown_value;
+		_viewport = unknown_value;
+
+		for (auto &states : _sampler_states)
+		{
+			std::fill(std::begin(states), std::end(states), unknown_value);
+		}
+
+		std::fill(std::begin(_shader_resources), std::end(_shader_resources), unknown_handle);
+		std::fill(std::begin(_shader_resource_resources), std::end(_shader_resource_resources), 0);
+		std::fill(std::begin(_render_targets), std::end(_render_targets), unknown_handle);
+		std::fill(std::begin(_render_target_resources), std::end(_render_target_resources), 0);
+		_depth_stencil = unknown_handle;
+	}
+
+	bool render_state_cache::set_shaders(uintptr_t vertex_shader, uintptr_t pixel_shader)
+	{
+		// Evaluate both, so that the shadow state is updated even if the first one changed
+		const bool vertex_shader_changed = update(_vertex_shader, vertex_shader);
+		const bool pixel_shader_changed = update(_pixel_shader, pixel_shader);
+
+		return vertex_shader_changed || pixel_shader_changed;
+	}
+	bool render_state_cache::set_state_block(uintptr_t state_block)
+	{
+		return update(_state_block, state_block);
+	}
+	bool render_state_cache::set_blend_state(uintptr_t blend_state)
+	{
+		return update(_blend_state, blend_state);
+	}
+	bool render_state_cache::set_depth_stencil_state(uintptr_t depth_stencil_state, uint32_t stencil_reference)
+	{
+		const bool state_changed = update(_depth_stencil_state, depth_stencil_state);
+		const bool reference_changed = update(_stencil_reference, stencil_reference);
+
+		return state_changed || reference_changed;
+	}
+	bool render_state_cache::set_constant_buffer(uintptr_t buffer)
+	{
+		return update(_constant_buffer, buffer);
+	}
+	bool render_state_cache::set_viewport(uint32_t width, uint32_t height)
+	{
+		return update(_viewport, (static_cast<uint64_t>(width) << 32) | height);
+	}
+	bool render_state_cache::set_sampler_state(unsigned int slot, unsigned int state, uint32_t value)
+	{
+		assert(slot < max_samplers && state < max_sampler_states);
+
+		return update(_sampler_states[slot][state], value);
+	}
+
+	state_slot_range render_state_cache::set_shader_resources(const uintptr_t *views, const uintptr_t *resources, unsigned int count, bool &unbound_render_targets)
+	{
+		state_slot_range range;
+		unbound_render_targets = false;
+
+		for (unsigned int slot = 0; slot < count && slot < max_shader_resources; slot++)
+		{
+			if (_shader_resources[slot] == views[slot])
+			{
+				continue;
+			}
+
+			const uintptr_t resource = views[slot] != 0 ? resources[slot] : 0;
+
+			if (unbind_render_target_resource(resource))
+			{
+				unbound_render_targets = true;
+			}
+
+			_shader_resources[slot] = views[slot];
+			_shader_resource_resources[slot] = resource;
+
+			extend_range(range, slot);
+		}
+
+		finish_shader_resource_range(range);
+
+		return range;
+	}
+	bool render_state_cache::set_render_targets(const uintptr_t *views, const uintptr_t *resources, unsigned int count, uintptr_t depth_stencil, state_slot_range &unbound_shader_resources)
+	{
+		bool changed = _depth_stencil != depth_stencil;
+		_depth_stencil = depth_stencil;
+
+		unbound_shader_resources = state_slot_range();
+
+		for (unsigned int slot = 0; slot < max_render_targets; slot++)
+		{
+			const uintptr_t view = slot < count ? views[slot] : 0;
+
+			if (_render_targets[slot] == view)
+			{
+				continue;
+			}
+
+			const uintptr_t resource = view != 0 ? resources[slot] : 0;
+
+			unbind_shader_resource(resource, unbound_shader_resources);
+
+			_render_targets[slot] = view;
+			_render_target_resources[slot] = resource;
+
+			changed = true;
+		}
+
+		finish_shader_resource_range(unbound_shader_resources);
+
+		return changed;
+	}
+
+	bool render_state_cache::set_shader_resource(unsigned int slot, uintptr_t view)
+	{
+		assert(slot < max_shader_resources);
+
+		if (_shader_resources[slot] == view)
+		{
+			return false;
+		}
+
+		_shader_resources[slot] = view;
+		_shader_resource_resources[slot] = 0;
+
+		return true;
+	}
+	bool render_state_cache::set_render_target(unsigned int slot, uintptr_t view)
+	{
+		assert(slot < max_render_targets);
+
+		if (_render_targets[slot] == view)
+		{
+			return false;
+		}
+
+		_render_targets[slot] = view;
+		_render_target_resources[slot] = 0;
+
+		return true;
+	}
+	bool render_state_cache::set_depth_stencil(uintptr_t view)
+	{
+		if (_depth_stencil == view)
+		{
+			return false;
+		}
+
+		_depth_stencil = view;
+
+		return true;
+	}
+
+	bool render_state_cache::unbind_render_target_resource(uintptr_t resource)
+	{
+		if (resource == 0)
+		{
+			return false;
+		}
+
+		bool unbound = false;
+
+		for (unsigned int slot = 0; slot < max_render_targets; slot++)
+		{
+			if (_render_target_resources[slot] == resource)
+			{
+				_render_targets[slot] = 0;
+				_render_target_resources[slot] = 0;
+
+				unbound = true;
+			}
+		}
+
+		// The caller binds all render targets again, so slots with unknown contents end up unbound too
+		if (unbound)
+		{
+			std::replace(std::begin(_render_targets), std::end(_render_targets), unknown_handle, uintptr_t(0));
+
+			if (_depth_stencil == unknown_handle)
+			{
+				_depth_stencil = 0;
+			}
+		}
+
+		return unbound;
+	}
+
+	bool render_state_cache::update(uint64_t &current, uint64_t value)
+	{
+		if (current == value)
+		{
+			return false;
+		}
+
+		current = value;
+
+		return true;
+	}
+	void render_state_cache::extend_range(state_slot_range &range, unsigned int slot)
+	{
+		if (range.count == 0)
+		{
+			range.first = slot;
+			range.count = 1;
+		}
+		else
+		{
+			const unsigned int last = std::max(range.first + range.count, slot + 1);
+
+			range.first = std::min(range.first, slot);
+			range.count = last - range.first;
+		}
+	}
+	void render_state_cache::unbind_shader_resource(uintptr_t resource, state_slot_range &range)
+	{
+		if (resource == 0)
+		{
+			return;
+		}
+
+		for (unsigned int slot = 0; slot < max_shader_resources; slot++)
+		{
+			if (_shader_resource_resources[slot] == resource)
+			{
+				_shader_resources[slot] = 0;
+				_shader_resource_resources[slot] = 0;
+
+				extend_range(range, slot);
+			}
+		}
+	}
+	void render_state_cache::finish_shader_resource_range(const state_slot_range &range)
+	{
+		// The caller binds the whole range again, so slots with unknown contents in between end up unbound
+		std::replace(_shader_resources + range.first, _shader_resources + range.first + range.count, unknown_handle, uintptr_t(0));
+	}
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// A range of consecutive slots that changed and have to be bound again.
+	/// </summary>
+	struct state_slot_range
+	{
+		unsigned int first = 0, count = 0;
+	};
+
+	/// <summary>
+	/// Shadow copy of the device state the runtimes bind for rendering effects. It filters out binds which would not change anything and tracks which resources are bound for reading and writing, so that they only have to be unbound when there is an actual hazard.
+	/// All objects are identified by opaque handles (usually their address), so that the filtering does not depend on any graphics API. A handle of zero means nothing is bound.
+	/// </summary>
+	class render_state_cache
+	{
+	public:
+		static const unsigned int max_shader_resources = 128;
+		static const unsigned int max_render_targets = 8;
+		static const unsigned int max_samplers = 16;
+		static const unsigned int max_sampler_states = 16;
+
+		render_state_cache();
+
+		/// <summary>
+		/// Forget all tracked state. Call this whenever something else may have changed the device state, so that the next binds are not filtered.
+		/// </summary>
+		void invalidate();
+
+		/// <summary>
+		/// Track a change to the bound shaders.
+		/// </summary>
+		/// <returns><c>true</c> if the shaders have to be bound, <c>false</c> if they already are.</returns>
+		bool set_shaders(uintptr_t vertex_shader, uintptr_t pixel_shader);
+		/// <summary>
+		/// Track a change to the state block, for APIs which record the fixed-function state of a pass into a single object.
+		/// </summary>
+		/// <returns><c>true</c> if the state block has to be applied, <c>false</c> if it already is.</returns>
+		bool set_state_block(uintptr_t state_block);
+		/// <summary>
+		/// Track a change to the bound blend state.
+		/// </summary>
+		/// <returns><c>true</c> if the state has to be bound, <c>false</c> if it already is.</returns>
+		bool set_blend_state(uintptr_t blend_state);
+		/// <summary>
+		/// Track a change to the bound depth-stencil state.
+		/// </summary>
+		/// <returns><c>true</c> if the state has to be bound, <c>false</c> if it already is.</returns>
+		bool set_depth_stencil_state(uintptr_t depth_stencil_state, uint32_t stencil_reference);
+		/// <summary>
+		/// Track a change to the constant buffer bound to the first slot.
+		/// </summary>
+		/// <returns><c>true</c> if the buffer has to be bound, <c>false</c> if it already is.</returns>
+		bool set_constant_buffer(uintptr_t buffer);
+		/// <summary>
+		/// Track a change to the viewport.
+		/// </summary>
+		/// <returns><c>true</c> if the viewport has to be set, <c>false</c> if it already is.</returns>
+		bool set_viewport(uint32_t width, uint32_t height);
+		/// <summary>
+		/// Track a change to a single sampler state value, for APIs which set them individually.
+		/// </summary>
+		/// <returns><c>true</c> if the value has to be set, <c>false</c> if it already is.</returns>
+		bool set_sampler_state(unsigned int slot, unsigned int state, uint32_t value);
+
+		/// <summary>
+		/// Track a change to the views bound for sampling. A resource which is still bound for rendering is unbound from output first, since it cannot be read and written at the same time.
+		/// </summary>
+		/// <param name="views">The views to bind to the first slots. Slots after them are left as they are.</param>
+		/// <param name="resources">The handles of the resources the views belong to, one per view.</param>
+		/// <param name="count">The number of views.</param>
+		/// <param name="unbound_render_targets">A variable which is set to <c>true</c> if render targets were unbound and have to be bound again from <see cref="render_targets"/> before the views.</param>
+		/// <returns>The slots which have to be bound again from <see cref="shader_resources"/>.</returns>
+		state_slot_range set_shader_resources(const uintptr_t *views, const uintptr_t *resources, unsigned int count, bool &unbound_render_targets);
+		/// <summary>
+		/// Track a change to the render targets and depth-stencil view. A resource which is still bound for sampling is unbound from input first, since it cannot be read and written at the same time.
+		/// </summary>
+		/// <param name="views">The render target views to bind. All slots after them are unbound.</param>
+		/// <param name="resources">The handles of the resources the render target views belong to, one per view.</param>
+		/// <param name="count">The number of render target views.</param>
+		/// <param name="depth_stencil">The depth-stencil view to bind.</param>
+		/// <param name="unbound_shader_resources">A variable which receives the sampling slots that were unbound and have to be bound again from <see cref="shader_resources"/> before the render targets.</param>
+		/// <returns><c>true</c> if the render targets have to be bound again from <see cref="render_targets"/>, <c>false</c> if they already are.</returns>
+		bool set_render_targets(const uintptr_t *views, const uintptr_t *resources, unsigned int count, uintptr_t depth_stencil, state_slot_range &unbound_shader_resources);
+
+		/// <summary>
+		/// Track a change to a single texture slot, for APIs which bind them individually. Hazards are not tracked for these.
+		/// </summary>
+		/// <returns><c>true</c> if the texture has to be bound, <c>false</c> if it already is.</returns>
+		bool set_shader_resource(unsigned int slot, uintptr_t view);
+		/// <summary>
+		/// Track a change to a single render target slot, for APIs which bind them individually. Hazards are not tracked for these.
+		/// </summary>
+		/// <returns><c>true</c> if the render target has to be bound, <c>false</c> if it already is.</returns>
+		bool set_render_target(unsigned int slot, uintptr_t view);
+		/// <summary>
+		/// Track a change to the depth-stencil view only.
+		/// </summary>
+		/// <returns><c>true</c> if the view has to be bound, <c>false</c> if it already is.</returns>
+		bool set_depth_stencil(uintptr_t view);
+
+		/// <summary>
+		/// Unbind a resource from all render target slots, e.g. before generating its mipmaps.
+		/// </summary>
+		/// <param name="resource">The handle of the resource.</param>
+		/// <returns><c>true</c> if it was bound and the render targets have to be bound again from <see cref="render_targets"/>, <c>false</c> otherwise.</returns>
+		bool unbind_render_target_resource(uintptr_t resource);
+
+		/// <summary>
+		/// Returns the views currently bound for sampling, one per slot.
+		/// </summary>
+		const uintptr_t *shader_resources() const { return _shader_resources; }
+		/// <summary>
+		/// Returns the render target views currently bound, one per slot.
+		/// </summary>
+		const uintptr_t *render_targets() const { return _render_targets; }
+		/// <summary>
+		/// Returns the depth-stencil view currently bound.
+		/// </summary>
+		uintptr_t depth_stencil() const { return _depth_stencil; }
+
+	private:
+		static bool update(uint64_t &current, uint64_t value);
+		static void extend_range(state_slot_range &range, unsigned int slot);
+		void unbind_shader_resource(uintptr_t resource, state_slot_range &range);
+		void finish_shader_resource_range(const state_slot_range &range);
+
+		uint64_t _vertex_shader, _pixel_shader;
+		uint64_t _state_block;
+		uint64_t _blend_state;
+		uint64_t _depth_stencil_state, _stencil_reference;
+		uint64_t _constant_buffer;
+		uint64_t _viewport;
+		uint64_t _sampler_states[max_samplers][max_sampler_states];
+		uintptr_t _shader_resources[max_shader_resources], _shader_resource_resources[max_shader_resources];
+		uintptr_t _render_targets[max_render_targets], _render_target_resources[max_render_targets];
+		uintptr_t _depth_stencil;
+	};
+}
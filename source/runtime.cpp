@@ -6,19 +6,26 @@
 #include "log.hpp"
 #include "version.h"
 #include "runtime.hpp"
+#include "render_graph.hpp"
 #include "effect_parser.hpp"
+#include "effect_pass_fusion.hpp"
 #include "effect_preprocessor.hpp"
 #include "input.hpp"
 #include "ini_file.hpp"
+#include "preset_index.hpp"
 #include <assert.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <fstream>
 #include <algorithm>
 #include <unordered_set>
+#include <stb_image_write.h>
+#if RESHADE_GUI
 #include <imgui.h>
 #include <imgui_internal.h>
-#include <stb_image.h>
-#include <stb_image_dds.h>
-#include <stb_image_write.h>
-#include <stb_image_resize.h>
+#endif
 
 namespace reshade
 {
@@ -28,7 +35,9 @@ namespace reshade
 		_renderer_id(renderer),
 		_start_time(std::chrono::high_resolution_clock::now()),
 		_last_frame_duration(std::chrono::milliseconds(1)),
+#if RESHADE_GUI
 		_imgui_context(ImGui::CreateContext()),
+#endif
 		_effect_search_paths({ s_reshade_dll_path.parent_path() }),
 		_texture_search_paths({ s_reshade_dll_path.parent_path() }),
 		_preprocessor_definitions({
@@ -52,6 +61,7 @@ namespace reshade
 		if (!filesystem::exists(_configuration_path))
 			_configuration_path = s_reshade_dll_path.parent_path() / "ReShade.ini";
 
+#if RESHADE_GUI
 		_needs_update = check_for_update(_latest_version);
 
 		auto &imgui_io = _imgui_context->IO;
@@ -94,29 +104,38 @@ namespace reshade
 			imgui_io.Fonts->AddFontFromFileTTF(font_path.string().c_str(), 18.0f);
 		else
 			imgui_io.Fonts->AddFontDefault();
+#endif
 
 		load_config();
 
+		register_builtin_uniform_sources();
+
+#if RESHADE_GUI
 		subscribe_to_menu("Home", [this]() { draw_overlay_menu_home(); });
 		subscribe_to_menu("Settings", [this]() { draw_overlay_menu_settings(); });
 		subscribe_to_menu("Statistics", [this]() { draw_overlay_menu_statistics(); });
 		subscribe_to_menu("Log", [this]() { draw_overlay_menu_log(); });
 		subscribe_to_menu("About", [this]() { draw_overlay_menu_about(); });
+#endif
 	}
 	runtime::~runtime()
 	{
+#if RESHADE_GUI
 		ImGui::DestroyContext(_imgui_context);
+#endif
 
 		assert(!_is_initialized && _techniques.empty());
 	}
 
 	bool runtime::on_init()
 	{
+#if RESHADE_GUI
 		// Finish initializing ImGui
 		auto &imgui_io = _imgui_context->IO;
 		imgui_io.DisplaySize.x = static_cast<float>(_width);
 		imgui_io.DisplaySize.y = static_cast<float>(_height);
 		imgui_io.Fonts->TexID = _imgui_font_atlas_texture.get();
+#endif
 
 		LOG(INFO) << "Recreated runtime environment on runtime " << this << ".";
 
@@ -139,6 +158,7 @@ namespace reshade
 			return;
 		}
 
+#if RESHADE_GUI
 		// Reset ImGui settings
 		auto &imgui_io = _imgui_context->IO;
 		imgui_io.DisplaySize.x = 0;
@@ -146,18 +166,51 @@ namespace reshade
 		imgui_io.Fonts->TexID = nullptr;
 
 		_imgui_font_atlas_texture.reset();
+#endif
 
 		LOG(INFO) << "Destroyed runtime environment on runtime " << this << ".";
 
+		// Frames of the depth buffer trace are written as they finish, so only make sure they reached the file
+		if (_depth_buffer_trace_file.is_open())
+		{
+			_depth_buffer_trace_file.flush();
+		}
+
+		ini_file::flush_cache();
+
+		_depth_buffer_selector.reset();
+
 		_width = _height = 0;
 		_is_initialized = false;
 	}
 	void runtime::on_reset_effect()
 	{
+		// Shader compilation may still be in progress on a worker thread, which accesses the pass objects, so wait for it to finish before destroying them
+		for (auto &technique : _techniques)
+		{
+			if (technique.compile_task.valid())
+			{
+				technique.compile_task.wait();
+			}
+		}
+
+		// Stop loading image files for the textures that are about to be destroyed
+		_texture_loader.cancel();
+		_reload_remaining_textures = 0;
+
 		_textures.clear();
 		_uniforms.clear();
 		_techniques.clear();
 		_uniform_data_storage.clear();
+		_uniform_data_generations.clear();
+		_preset_images.clear();
+
+		for (auto &provider : _uniform_source_providers)
+		{
+			provider.updaters.clear();
+		}
+
+		_active_uniform_source_providers.clear();
 
 		_texture_count = 0;
 		_uniform_count = 0;
@@ -167,7 +220,11 @@ namespace reshade
 	{
 		// Get current time and date
 		time_t t = std::time(nullptr); tm tm;
+#ifdef _WIN32
 		localtime_s(&tm, &t);
+#else
+		localtime_r(&t, &tm);
+#endif
 		_date[0] = tm.tm_year + 1900;
 		_date[1] = tm.tm_mon + 1;
 		_date[2] = tm.tm_mday;
@@ -194,12 +251,17 @@ namespace reshade
 			save_screenshot();
 		}
 
+#if RESHADE_GUI
 		// Draw overlay
 		draw_overlay();
+#endif
 
 		// Reset input status
 		_input->next_frame();
 
+		// Upload image files that finished loading in the background
+		upload_loaded_textures();
+
 		// Update and compile next effect queued for reloading
 		if (_reload_remaining_effects != 0 && _framecount > 1)
 		{
@@ -212,16 +274,39 @@ namespace reshade
 			{
 				load_textures();
 
+				alias_transient_textures();
+
+				// Compile all presets in the list right away, so that switching between them later does not have to read them again
+				for (const auto &preset_file : _preset_files)
+				{
+					load_preset_image(preset_file);
+				}
+
 				load_current_preset();
 
+				// Start compiling techniques enabled by the preset right away, so they are ready as soon as possible
+				for (auto &technique : _techniques)
+				{
+					if (technique.enabled)
+					{
+						begin_compile_technique(technique);
+					}
+				}
+
+#if RESHADE_GUI
 				if (_effect_filter_buffer[0] != '\0' && strcmp(_effect_filter_buffer, "Search") != 0)
 				{
 					filter_techniques(_effect_filter_buffer);
 				}
+#endif
 			}
 		}
 
+		// Write configuration and preset files changed during this frame in one go
+		ini_file::flush_cache();
+
 		g_network_traffic = _drawcalls = _vertices = 0;
+		_uniform_uploads = _uniform_uploads_skipped = 0;
 	}
 	void runtime::on_present_effect()
 	{
@@ -235,25 +320,142 @@ namespace reshade
 			return;
 		}
 
-		// Update all uniform variables
-		for (auto &variable : _uniforms)
+		// Update all uniform variables that are bound to a source, skipping providers no loaded variable uses
+		for (const size_t index : _active_uniform_source_providers)
+		{
+			const auto &provider = _uniform_source_providers[index];
+
+			provider.update(provider.updaters);
+		}
+
+		// Render all enabled techniques
+		for (auto &technique : _techniques)
 		{
-			const auto it = variable.annotations.find("source");
+			if (technique.timeleft > 0)
+			{
+				technique.timeleft -= static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(_last_frame_duration).count());
 
-			if (it == variable.annotations.end())
+				if (technique.timeleft <= 0)
+				{
+					technique.enabled = false;
+					technique.timeleft = 0;
+					technique.average_cpu_duration.clear();
+					technique.average_gpu_duration.clear();
+				}
+			}
+			else if (!_toggle_key_setting_active &&
+				_input->is_key_pressed(technique.toggle_key_data[0], technique.toggle_key_data[1] != 0, technique.toggle_key_data[2] != 0, technique.toggle_key_data[3] != 0) ||
+				(technique.toggle_key_data[0] >= 0x01 && technique.toggle_key_data[0] <= 0x06 && _input->is_mouse_button_pressed(technique.toggle_key_data[0] - 1)))
 			{
+				technique.enabled = !technique.enabled;
+				technique.timeleft = technique.enabled ? technique.timeout : 0;
+			}
+
+			if (!technique.enabled)
+			{
+				technique.average_cpu_duration.clear();
+				technique.average_gpu_duration.clear();
 				continue;
 			}
 
-			const auto source = it->second.as<std::string>();
+			// Techniques are only compiled once they are first enabled, so skip them until that has finished
+			if (!technique.compiled && !finish_compile_technique(technique))
+			{
+				continue;
+			}
+
+			const auto time_technique_started = std::chrono::high_resolution_clock::now();
+
+			render_technique(technique);
+
+			const auto time_technique_finished = std::chrono::high_resolution_clock::now();
+
+			technique.average_cpu_duration.append(std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
+		}
+	}
+
+	void runtime::register_uniform_source(std::string name, std::function<bool(const uniform &, uniform_updater &)> validate, std::function<void(const std::vector<uniform_updater> &)> update)
+	{
+		assert(update != nullptr);
 
-			if (source == "frametime")
+		const auto it = std::find_if(_uniform_source_providers.begin(), _uniform_source_providers.end(),
+			[&name](const auto &provider)
 			{
-				const float value = _last_frame_duration.count() * 1e-6f;
-				set_uniform_value(variable, &value, 1);
+				return provider.name == name;
+			});
+
+		// Registering a source again replaces the previous provider
+		if (it != _uniform_source_providers.end())
+		{
+			it->validate = std::move(validate);
+			it->update = std::move(update);
+			return;
+		}
+
+		_uniform_source_providers.push_back({ std::move(name), std::move(validate), std::move(update) });
+	}
+	enum class input_source_mode
+	{
+		down,
+		press,
+		toggle
+	};
+
+	struct pingpong_source_data : base_object
+	{
+		float min, max, step_min, step_max, smoothing;
+	};
+	struct input_source_data : base_object
+	{
+		int keycode;
+		input_source_mode mode;
+	};
+	struct random_source_data : base_object
+	{
+		int min, max;
+	};
+
+	void runtime::register_builtin_uniform_sources()
+	{
+		const auto annotation = [](const uniform &variable, const char *name) -> variant
+		{
+			const auto it = variable.annotations.find(name);
+
+			return it != variable.annotations.end() ? it->second : variant();
+		};
+		const auto parse_input_mode = [annotation](const uniform &variable)
+		{
+			const std::string mode = annotation(variable, "mode").as<std::string>();
+
+			if (mode == "toggle" || annotation(variable, "toggle").as<bool>())
+			{
+				return input_source_mode::toggle;
+			}
+			else if (mode == "press")
+			{
+				return input_source_mode::press;
 			}
-			else if (source == "framecount")
+			else
 			{
+				return input_source_mode::down;
+			}
+		};
+
+		register_uniform_source("frametime", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			const float frametime = _last_frame_duration.count() * 1e-6f;
+
+			for (const auto &updater : updaters)
+			{
+				set_uniform_value(_uniforms[updater.uniform_index], &frametime, 1);
+			}
+		});
+		register_uniform_source("framecount", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			for (const auto &updater : updaters)
+			{
+				auto &variable = _uniforms[updater.uniform_index];
+
 				switch (variable.basetype)
 				{
 					case uniform_datatype::boolean:
@@ -277,48 +479,72 @@ namespace reshade
 					}
 				}
 			}
-			else if (source == "pingpong")
+		});
+		register_uniform_source("pingpong", [annotation](const uniform &variable, uniform_updater &updater)
+		{
+			auto data = std::make_unique<pingpong_source_data>();
+
+			data->min = annotation(variable, "min").as<float>();
+			data->max = annotation(variable, "max").as<float>();
+			data->step_min = annotation(variable, "step").as<float>(0);
+			data->step_max = annotation(variable, "step").as<float>(1);
+			data->smoothing = annotation(variable, "smoothing").as<float>();
+
+			updater.data = std::move(data);
+			return true;
+		}, [this](const std::vector<uniform_updater> &updaters)
+		{
+			for (const auto &updater : updaters)
 			{
+				auto &variable = _uniforms[updater.uniform_index];
+				// The data was created by the function above, so its type is known and does not have to be checked every frame
+				const auto &data = *static_cast<const pingpong_source_data *>(updater.data.get());
+
 				float value[2] = { 0, 0 };
 				get_uniform_value(variable, value, 2);
 
-				const float min = variable.annotations["min"].as<float>(), max = variable.annotations["max"].as<float>();
-				const float step_min = variable.annotations["step"].as<float>(0), step_max = variable.annotations["step"].as<float>(1);
-				float increment = step_max == 0 ? step_min : (step_min + std::fmodf(static_cast<float>(std::rand()), step_max - step_min + 1));
-				const float smoothing = variable.annotations["smoothing"].as<float>();
+				float increment = data.step_max == 0 ? data.step_min : (data.step_min + std::fmod(static_cast<float>(std::rand()), data.step_max - data.step_min + 1));
 
 				if (value[1] >= 0)
 				{
-					increment = std::max(increment - std::max(0.0f, smoothing - (max - value[0])), 0.05f);
+					increment = std::max(increment - std::max(0.0f, data.smoothing - (data.max - value[0])), 0.05f);
 					increment *= _last_frame_duration.count() * 1e-9f;
 
-					if ((value[0] += increment) >= max)
+					if ((value[0] += increment) >= data.max)
 					{
-						value[0] = max;
+						value[0] = data.max;
 						value[1] = -1;
 					}
 				}
 				else
 				{
-					increment = std::max(increment - std::max(0.0f, smoothing - (value[0] - min)), 0.05f);
+					increment = std::max(increment - std::max(0.0f, data.smoothing - (value[0] - data.min)), 0.05f);
 					increment *= _last_frame_duration.count() * 1e-9f;
 
-					if ((value[0] -= increment) <= min)
+					if ((value[0] -= increment) <= data.min)
 					{
-						value[0] = min;
+						value[0] = data.min;
 						value[1] = +1;
 					}
 				}
 
 				set_uniform_value(variable, value, 2);
 			}
-			else if (source == "date")
+		});
+		register_uniform_source("date", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			for (const auto &updater : updaters)
 			{
-				set_uniform_value(variable, _date, 4);
+				set_uniform_value(_uniforms[updater.uniform_index], _date, 4);
 			}
-			else if (source == "timer")
+		});
+		register_uniform_source("timer", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			const unsigned long long timer = std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count();
+
+			for (const auto &updater : updaters)
 			{
-				const unsigned long long timer = std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count();
+				auto &variable = _uniforms[updater.uniform_index];
 
 				switch (variable.basetype)
 				{
@@ -343,133 +569,241 @@ namespace reshade
 					}
 				}
 			}
-			else if (source == "key")
+		});
+		register_uniform_source("key", [annotation, parse_input_mode](const uniform &variable, uniform_updater &updater)
+		{
+			const int keycode = annotation(variable, "keycode").as<int>();
+
+			if (keycode <= 7 || keycode >= 256)
 			{
-				const int key = variable.annotations["keycode"].as<int>();
+				return false;
+			}
 
-				if (key > 7 && key < 256)
-				{
-					const std::string mode = variable.annotations["mode"].as<std::string>();
+			auto data = std::make_unique<input_source_data>();
 
-					if (mode == "toggle" || variable.annotations["toggle"].as<bool>())
-					{
-						bool current = false;
-						get_uniform_value(variable, &current, 1);
+			data->keycode = keycode;
+			data->mode = parse_input_mode(variable);
 
-						if (_input->is_key_pressed(key))
+			updater.data = std::move(data);
+			return true;
+		}, [this](const std::vector<uniform_updater> &updaters)
+		{
+			for (const auto &updater : updaters)
+			{
+				auto &variable = _uniforms[updater.uniform_index];
+				const auto &data = *static_cast<const input_source_data *>(updater.data.get());
+
+				switch (data.mode)
+				{
+					case input_source_mode::toggle:
+					{
+						if (_input->is_key_pressed(data.keycode))
 						{
+							bool current = false;
+							get_uniform_value(variable, &current, 1);
+
 							current = !current;
 
 							set_uniform_value(variable, &current, 1);
 						}
+						break;
 					}
-					else if (mode == "press")
+					case input_source_mode::press:
 					{
-						const bool state = _input->is_key_pressed(key);
+						const bool state = _input->is_key_pressed(data.keycode);
 
 						set_uniform_value(variable, &state, 1);
+						break;
 					}
-					else
+					case input_source_mode::down:
 					{
-						const bool state = _input->is_key_down(key);
+						const bool state = _input->is_key_down(data.keycode);
 
 						set_uniform_value(variable, &state, 1);
+						break;
 					}
 				}
 			}
-			else if (source == "mousepoint")
-			{
-				const float values[2] = { static_cast<float>(_input->mouse_position_x()), static_cast<float>(_input->mouse_position_y()) };
+		});
+		register_uniform_source("mousepoint", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			const float values[2] = { static_cast<float>(_input->mouse_position_x()), static_cast<float>(_input->mouse_position_y()) };
 
-				set_uniform_value(variable, values, 2);
+			for (const auto &updater : updaters)
+			{
+				set_uniform_value(_uniforms[updater.uniform_index], values, 2);
 			}
-			else if (source == "mousedelta")
+		});
+		register_uniform_source("mousedelta", nullptr, [this](const std::vector<uniform_updater> &updaters)
+		{
+			const float values[2] = { static_cast<float>(_input->mouse_movement_delta_x()), static_cast<float>(_input->mouse_movement_delta_y()) };
+
+			for (const auto &updater : updaters)
 			{
-				const float values[2] = { static_cast<float>(_input->mouse_movement_delta_x()), static_cast<float>(_input->mouse_movement_delta_y()) };
+				set_uniform_value(_uniforms[updater.uniform_index], values, 2);
+			}
+		});
+		register_uniform_source("mousebutton", [annotation, parse_input_mode](const uniform &variable, uniform_updater &updater)
+		{
+			const int keycode = annotation(variable, "keycode").as<int>();
 
-				set_uniform_value(variable, values, 2);
+			if (keycode < 0 || keycode >= 5)
+			{
+				return false;
 			}
-			else if (source == "mousebutton")
+
+			auto data = std::make_unique<input_source_data>();
+
+			data->keycode = keycode;
+			data->mode = parse_input_mode(variable);
+
+			updater.data = std::move(data);
+			return true;
+		}, [this](const std::vector<uniform_updater> &updaters)
+		{
+			for (const auto &updater : updaters)
 			{
-				const int index = variable.annotations["keycode"].as<int>();
+				auto &variable = _uniforms[updater.uniform_index];
+				const auto &data = *static_cast<const input_source_data *>(updater.data.get());
 
-				if (index >= 0 && index < 5)
+				switch (data.mode)
 				{
-					const std::string mode = variable.annotations["mode"].as<std::string>();
-
-					if (mode == "toggle" || variable.annotations["toggle"].as<bool>())
+					case input_source_mode::toggle:
 					{
-						bool current = false;
-						get_uniform_value(variable, &current, 1);
-
-						if (_input->is_mouse_button_pressed(index))
+						if (_input->is_mouse_button_pressed(data.keycode))
 						{
+							bool current = false;
+							get_uniform_value(variable, &current, 1);
+
 							current = !current;
 
 							set_uniform_value(variable, &current, 1);
 						}
+						break;
 					}
-					else if (mode == "press")
+					case input_source_mode::press:
 					{
-						const bool state = _input->is_mouse_button_pressed(index);
+						const bool state = _input->is_mouse_button_pressed(data.keycode);
 
 						set_uniform_value(variable, &state, 1);
+						break;
 					}
-					else
+					case input_source_mode::down:
 					{
-						const bool state = _input->is_mouse_button_down(index);
+						const bool state = _input->is_mouse_button_down(data.keycode);
 
 						set_uniform_value(variable, &state, 1);
+						break;
 					}
 				}
 			}
-			else if (source == "random")
-			{
-				const int min = variable.annotations["min"].as<int>(), max = variable.annotations["max"].as<int>();
-				const int value = min + (std::rand() % (max - min + 1));
+		});
+		register_uniform_source("random", [annotation](const uniform &variable, uniform_updater &updater)
+		{
+			auto data = std::make_unique<random_source_data>();
 
-				set_uniform_value(variable, &value, 1);
-			}
-		}
+			data->min = annotation(variable, "min").as<int>();
+			data->max = annotation(variable, "max").as<int>();
 
-		// Render all enabled techniques
-		for (auto &technique : _techniques)
+			updater.data = std::move(data);
+			return true;
+		}, [this](const std::vector<uniform_updater> &updaters)
 		{
-			if (technique.timeleft > 0)
+			for (const auto &updater : updaters)
 			{
-				technique.timeleft -= static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(_last_frame_duration).count());
+				const auto &data = *static_cast<const random_source_data *>(updater.data.get());
+				const int value = data.min + (std::rand() % (data.max - data.min + 1));
 
-				if (technique.timeleft <= 0)
-				{
-					technique.enabled = false;
-					technique.timeleft = 0;
-					technique.average_cpu_duration.clear();
-					technique.average_gpu_duration.clear();
-				}
-			}
-			else if (!_toggle_key_setting_active &&
-				_input->is_key_pressed(technique.toggle_key_data[0], technique.toggle_key_data[1] != 0, technique.toggle_key_data[2] != 0, technique.toggle_key_data[3] != 0) ||
-				(technique.toggle_key_data[0] >= 0x01 && technique.toggle_key_data[0] <= 0x06 && _input->is_mouse_button_pressed(technique.toggle_key_data[0] - 1)))
-			{
-				technique.enabled = !technique.enabled;
-				technique.timeleft = technique.enabled ? technique.timeout : 0;
+				set_uniform_value(_uniforms[updater.uniform_index], &value, 1);
 			}
+		});
+	}
+	void runtime::create_uniform_updater(size_t uniform_index)
+	{
+		const auto &variable = _uniforms[uniform_index];
 
-			if (!technique.enabled)
+		const auto it = variable.annotations.find("source");
+
+		if (it == variable.annotations.end())
+		{
+			return;
+		}
+
+		const auto source = it->second.as<std::string>();
+
+		const auto provider = std::find_if(_uniform_source_providers.begin(), _uniform_source_providers.end(),
+			[&source](const auto &provider)
 			{
-				technique.average_cpu_duration.clear();
-				technique.average_gpu_duration.clear();
-				continue;
-			}
+				return provider.name == source;
+			});
 
-			const auto time_technique_started = std::chrono::high_resolution_clock::now();
+		if (provider == _uniform_source_providers.end())
+		{
+			return;
+		}
 
-			render_technique(technique);
+		// Let the provider parse the parameters once here, so that updating them every frame does not need to look at any annotations
+		uniform_updater updater = { };
+		updater.uniform_index = uniform_index;
 
-			const auto time_technique_finished = std::chrono::high_resolution_clock::now();
+		if (provider->validate != nullptr && !provider->validate(variable, updater))
+		{
+			return;
+		}
 
-			technique.average_cpu_duration.append(std::chrono::duration_cast<std::chrono::nanoseconds>(time_technique_finished - time_technique_started).count());
+		if (provider->updaters.empty())
+		{
+			_active_uniform_source_providers.push_back(static_cast<size_t>(provider - _uniform_source_providers.begin()));
+		}
+
+		provider->updaters.push_back(std::move(updater));
+	}
+
+	void runtime::begin_compile_technique(technique &technique)
+	{
+		if (technique.compiled || technique.compile_task.valid())
+		{
+			return;
+		}
+
+		// The pass objects are heap allocated and therefore stay valid while the technique list is reordered
+		std::vector<base_object *> passes;
+		passes.reserve(technique.passes.size());
+
+		for (const auto &pass : technique.passes)
+		{
+			passes.push_back(pass.get());
+		}
+
+		// Compile on the worker pool, so that enabling many techniques at once does not start a thread for every single one
+		technique.compile_task = _compile_pool.submit([this, passes = std::move(passes)]() {
+			return compile_technique(passes);
+		});
+	}
+	bool runtime::finish_compile_technique(technique &technique)
+	{
+		begin_compile_technique(technique);
+
+		if (technique.compile_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return false;
+		}
+
+		if (!technique.compile_task.get() || !create_technique_shaders(technique))
+		{
+			LOG(ERROR) << "Failed to compile technique '" << technique.name << "' in " << technique.effect_filename << ". Disabling it.";
+
+			technique.enabled = false;
+			technique.timeleft = 0;
+
+			return false;
 		}
+
+		LOG(INFO) << "Successfully compiled technique '" << technique.name << "'.";
+
+		technique.compiled = true;
+
+		return true;
 	}
 
 	void runtime::reload()
@@ -629,6 +963,13 @@ namespace reshade
 			}
 		}
 
+		const size_t fused_count = reshadefx::fuse_passes(ast, _is_backbuffer_normalized);
+
+		if (fused_count != 0)
+		{
+			LOG(INFO) << "> Merged " << fused_count << " passes into the ones following them.";
+		}
+
 		std::string errors = parser.errors();
 
 		if (!load_effect(ast, errors))
@@ -648,11 +989,16 @@ namespace reshade
 			LOG(WARNING) << "> Successfully compiled with warnings:\n" << errors;
 		}
 
+		// Only code generation happened so far, the shaders themselves are compiled by begin_compile_technique and finish_compile_technique
+		LOG(INFO) << "> Deferred shader compilation of " << (_techniques.size() - _technique_count) << " techniques until they are first enabled.";
+
 		for (size_t i = _uniform_count, max = _uniform_count = _uniforms.size(); i < max; i++)
 		{
 			auto &variable = _uniforms[i];
 			variable.effect_filename = path.filename().string();
 			variable.hidden = variable.annotations["hidden"].as<bool>();
+
+			create_uniform_updater(i);
 		}
 		for (size_t i = _texture_count, max = _texture_count = _textures.size(); i < max; i++)
 		{
@@ -662,6 +1008,7 @@ namespace reshade
 		for (size_t i = _technique_count, max = _technique_count = _techniques.size(); i < max; i++)
 		{
 			auto &technique = _techniques[i];
+			technique.load_index = i;
 			technique.effect_filename = path.filename().string();
 			technique.enabled = technique.annotations["enabled"].as<bool>();
 			technique.hidden = technique.annotations["hidden"].as<bool>();
@@ -671,13 +1018,20 @@ namespace reshade
 			technique.toggle_key_data[2] = technique.annotations["toggleshift"].as<bool>() ? 1 : 0;
 			technique.toggle_key_data[3] = technique.annotations["togglealt"].as<bool>() ? 1 : 0;
 		}
+
+		// Preset images refer to uniforms and techniques by index, so they have to be compiled again to include the new ones
+		_preset_images.clear();
 	}
 	void runtime::load_textures()
 	{
 		LOG(INFO) << "Loading image files for textures ...";
 
-		for (auto &texture : _textures)
+		std::vector<texture_loader::request> requests;
+
+		for (size_t i = 0; i < _textures.size(); i++)
 		{
+			const auto &texture = _textures[i];
+
 			if (texture.impl_reference != texture_reference::none)
 			{
 				continue;
@@ -698,50 +1052,111 @@ namespace reshade
 				continue;
 			}
 
-			FILE *file;
-			unsigned char *filedata = nullptr;
-			int width = 0, height = 0, channels = 0;
-			bool success = false;
+			requests.push_back({ i, path, texture.width, texture.height, get_upload_layout(texture) });
+		}
 
-			if (_wfopen_s(&file, path.wstring().c_str(), L"rb") == 0)
+		// Reading, decoding, resizing, mipmap generation and format conversion happens on worker threads, only the upload is left to the render thread
+		_reload_remaining_textures = requests.size();
+		_texture_loader.start(std::move(requests));
+	}
+	void runtime::upload_loaded_textures()
+	{
+		if (_reload_remaining_textures == 0)
+		{
+			return;
+		}
+
+		const auto deadline = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(_texture_upload_budget);
+
+		// Always upload at least one image per frame, so that loading finishes even if the budget is exceeded by every single upload
+		for (decoded_image image; _texture_loader.pop(image);)
+		{
+			auto &texture = _textures[image.texture_index];
+
+			_reload_remaining_textures--;
+			// Keep the splash screen with the loading progress open
+			_last_reload_time = std::chrono::high_resolution_clock::now();
+
+			if (!image.pixels.empty() && (image.width != image.source_width || image.height != image.source_height))
 			{
-				if (stbi_dds_test_file(file))
-				{
-					filedata = stbi_dds_load_from_file(file, &width, &height, &channels, STBI_rgb_alpha);
-				}
-				else
-				{
-					filedata = stbi_load_from_file(file, &width, &height, &channels, STBI_rgb_alpha);
-				}
+				LOG(INFO) << "> Resized image data for texture '" << texture.name << "' from " << image.source_width << "x" << image.source_height << " to " << image.width << "x" << image.height << ".";
+			}
 
-				fclose(file);
+			if (image.pixels.empty() || !update_texture(texture, image.pixels.data(), image.levels))
+			{
+				LOG(ERROR) << "> Source " << image.path << " for texture '" << texture.name << "' could not be loaded! Make sure it is of a compatible file format.";
 			}
 
-			if (filedata != nullptr)
+			if (std::chrono::high_resolution_clock::now() >= deadline)
 			{
-				if (texture.width != static_cast<unsigned int>(width) ||
-					texture.height != static_cast<unsigned int>(height))
-				{
-					LOG(INFO) << "> Resizing image data for texture '" << texture.name << "' from " << width << "x" << height << " to " << texture.width << "x" << texture.height << " ...";
+				break;
+			}
+		}
+	}
+	void runtime::alias_transient_textures()
+	{
+		std::unordered_map<std::string, size_t> texture_indices;
+		std::vector<texture_alias_desc> descs;
 
-					std::vector<uint8_t> resized(texture.width * texture.height * 4);
-					stbir_resize_uint8(filedata, width, height, 0, resized.data(), texture.width, texture.height, 0, 4);
-					success = update_texture(texture, resized.data());
-				}
-				else
+		for (const auto &texture : _textures)
+		{
+			texture_alias_desc desc;
+			desc.width = texture.width;
+			desc.height = texture.height;
+			desc.levels = texture.levels;
+			desc.format = texture.format;
+			// Back and depth buffer references have no memory of their own and the contents of textures loaded from image files have to be kept
+			desc.pinned = texture.impl_reference != texture_reference::none || texture.annotations.count("source") != 0;
+
+			texture_indices[texture.unique_name] = descs.size();
+			descs.push_back(desc);
+		}
+
+		const auto find_indices = [&texture_indices](const std::vector<std::string> &names) {
+			std::vector<size_t> indices;
+
+			for (const auto &name : names)
+			{
+				const auto it = texture_indices.find(name);
+
+				if (it != texture_indices.end())
 				{
-					success = update_texture(texture, filedata);
+					indices.push_back(it->second);
 				}
+			}
+
+			return indices;
+		};
+
+		// All techniques are analyzed, not just the enabled ones, so that the plan stays valid when techniques are toggled later on
+		texture_alias_planner planner(std::move(descs));
 
-				stbi_image_free(filedata);
+		for (const auto &technique : _techniques)
+		{
+			planner.begin_technique();
+
+			for (const auto &access : technique.pass_texture_usage)
+			{
+				planner.add_pass(find_indices(access.reads), find_indices(access.writes), access.overwrites);
 			}
+		}
+
+		const auto owners = planner.plan();
+		size_t aliased_count = 0;
 
-			if (!success)
+		for (size_t i = 0; i < owners.size(); i++)
+		{
+			if (owners[i] != i && alias_texture(_textures[i], _textures[owners[i]]))
 			{
-				LOG(ERROR) << "> Source " << path << " for texture '" << texture.name << "' could not be loaded! Make sure it is of a compatible file format.";
-				continue;
+				_textures[i].aliased = true;
+				aliased_count++;
 			}
 		}
+
+		if (aliased_count != 0)
+		{
+			LOG(INFO) << "Shared memory of " << aliased_count << " transient textures with other textures.";
+		}
 	}
 
 	void runtime::load_config()
@@ -767,11 +1182,45 @@ namespace reshade
 		config.get("GENERAL", "ScreenshotIncludeConfiguration", _screenshot_include_configuration);
 		config.get("GENERAL", "ShowClock", _show_clock);
 		config.get("GENERAL", "ShowFPS", _show_framerate);
+#if RESHADE_GUI
 		config.get("GENERAL", "FontGlobalScale", _imgui_context->IO.FontGlobalScale);
+#endif
 		config.get("GENERAL", "NoFontScaling", _no_font_scaling);
 		config.get("GENERAL", "NoReloadOnInit", _no_reload_on_init);
 		config.get("GENERAL", "SaveWindowState", _save_imgui_window_state);
+		const filesystem::path previous_depth_buffer_trace_path = _depth_buffer_trace_path;
+		config.get("GENERAL", "DepthBufferTracePath", _depth_buffer_trace_path);
 
+		// Stream the statistics recorded for depth buffer detection to a file, so that the selection can be replayed outside the application without keeping every frame in memory
+		if (_depth_buffer_trace_path != previous_depth_buffer_trace_path)
+		{
+			_depth_buffer_trace.stream_to(nullptr);
+			_depth_buffer_trace.clear();
+			_depth_buffer_trace_file.close();
+
+			if (!_depth_buffer_trace_path.empty())
+			{
+				_depth_buffer_trace_file.open(_depth_buffer_trace_path.native(), std::ios::binary | std::ios::trunc);
+
+				if (!_depth_buffer_trace_file.is_open() || !_depth_buffer_trace.stream_to(&_depth_buffer_trace_file))
+				{
+					LOG(ERROR) << "Failed to open depth buffer trace file " << _depth_buffer_trace_path << " for writing.";
+
+					_depth_buffer_trace.stream_to(nullptr);
+					_depth_buffer_trace_file.close();
+				}
+			}
+		}
+
+		_depth_buffer_selector.record(_depth_buffer_trace_file.is_open() ? &_depth_buffer_trace : nullptr);
+
+		config.get("GENERAL", "TextureUploadBudget", _texture_upload_budget);
+
+		unsigned int log_flush_interval = reshade::log::flush_interval();
+		config.get("GENERAL", "LogFlushInterval", log_flush_interval);
+		reshade::log::set_flush_interval(log_flush_interval);
+
+#if RESHADE_GUI
 		_imgui_context->IO.IniFilename = _save_imgui_window_state ? "ReShadeGUI.ini" : nullptr;
 
 		config.get("STYLE", "Alpha", _imgui_context->Style.Alpha);
@@ -818,6 +1267,7 @@ namespace reshade
 		_imgui_context->Style.Colors[ImGuiCol_PlotHistogram] = ImVec4(_imgui_col_text[0], _imgui_col_text[1], _imgui_col_text[2], 0.63f);
 		_imgui_context->Style.Colors[ImGuiCol_PlotHistogramHovered] = ImVec4(_imgui_col_active[0], _imgui_col_active[1], _imgui_col_active[2], 1.00f);
 		_imgui_context->Style.Colors[ImGuiCol_TextSelectedBg] = ImVec4(_imgui_col_active[0], _imgui_col_active[1], _imgui_col_active[2], 0.43f);
+#endif
 
 		if (_current_preset >= static_cast<ptrdiff_t>(_preset_files.size()))
 		{
@@ -825,18 +1275,22 @@ namespace reshade
 		}
 
 		const filesystem::path parent_path = s_reshade_dll_path.parent_path();
-		auto preset_files2 = filesystem::list_files(parent_path, "*.ini");
-		auto preset_files3 = filesystem::list_files(parent_path, "*.txt");
+		auto preset_files2 = filesystem::list_files_with_info(parent_path, "*.ini");
+		auto preset_files3 = filesystem::list_files_with_info(parent_path, "*.txt");
 		preset_files2.insert(preset_files2.end(), std::make_move_iterator(preset_files3.begin()), std::make_move_iterator(preset_files3.end()));
 
-		for (const auto &preset_file : preset_files2)
-		{
-			const ini_file preset(preset_file);
+		// Remember which files are presets between runs, so that only new or changed files have to be read
+		preset_index index;
+		const filesystem::path index_path = parent_path / "ReShadePresets.cache";
 
-			std::vector<std::string> techniques;
-			preset.get("", "Techniques", techniques);
+		if (std::ifstream index_file(index_path.native(), std::ios::in | std::ios::binary); index_file.is_open())
+		{
+			index.load(index_file);
+		}
 
-			if (!techniques.empty() && std::find_if(_preset_files.begin(), _preset_files.end(),
+		for (const auto &preset_file : index.update(preset_files2))
+		{
+			if (std::find_if(_preset_files.begin(), _preset_files.end(),
 				[&preset_file, &parent_path](const auto &path) {
 					return preset_file.filename() == path.filename() && (path.parent_path() == parent_path || !path.is_absolute());
 				}) == _preset_files.end())
@@ -845,6 +1299,16 @@ namespace reshade
 			}
 		}
 
+		if (index.modified())
+		{
+			std::ofstream index_file(index_path.native(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+			if (!index.save(index_file))
+			{
+				LOG(WARNING) << "Failed to write preset index to " << index_path << ".";
+			}
+		}
+
 #if 0
 		auto to_absolute = [&parent_path](auto &paths) {
 			for (auto &path : paths)
@@ -888,16 +1352,20 @@ namespace reshade
 		config.set("GENERAL", "ScreenshotIncludeConfiguration", _screenshot_include_configuration);
 		config.set("GENERAL", "ShowClock", _show_clock);
 		config.set("GENERAL", "ShowFPS", _show_framerate);
+#if RESHADE_GUI
 		config.set("GENERAL", "FontGlobalScale", _imgui_context->IO.FontGlobalScale);
+#endif
 		config.set("GENERAL", "NoReloadOnInit", _no_reload_on_init);
 		config.set("GENERAL", "SaveWindowState", _save_imgui_window_state);
 
+#if RESHADE_GUI
 		config.set("STYLE", "Alpha", _imgui_context->Style.Alpha);
 		config.set("STYLE", "ColBackground", _imgui_col_background);
 		config.set("STYLE", "ColItemBackground", _imgui_col_item_background);
 		config.set("STYLE", "ColActive", _imgui_col_active);
 		config.set("STYLE", "ColText", _imgui_col_text);
 		config.set("STYLE", "ColFPSText", _imgui_col_text_fps);
+#endif
 
 		for (auto &function : _save_config_callables)
 		{
@@ -907,56 +1375,143 @@ namespace reshade
 
 	void runtime::load_preset(const filesystem::path &path)
 	{
-		ini_file preset(path);
+		apply_preset_image(load_preset_image(path));
+	}
+	auto runtime::load_preset_image(const filesystem::path &path) -> const preset_image &
+	{
+		const uint64_t write_time = filesystem::last_write_time(path);
+
+		auto &image = _preset_images[path.string()];
 
-		for (auto &variable : _uniforms)
+		// Reuse the compiled image as long as the preset file was not changed since, including changes that were saved but not written to disk yet
+		if (image.write_time == write_time && write_time != 0 && !ini_file::has_pending_changes(path))
 		{
+			return image;
+		}
+
+		const ini_file preset(path);
+
+		image = preset_image();
+		image.write_time = write_time;
+
+		for (size_t i = 0; i < _uniforms.size(); i++)
+		{
+			const auto &variable = _uniforms[i];
+
+			if (!preset.has(variable.effect_filename, variable.name))
+			{
+				continue;
+			}
+
 			int values_int[16] = {};
 			unsigned int values_uint[16] = {};
 			float values_float[16] = {};
+			const void *values = nullptr;
 
+			// The arrays match the base type of the uniform, so they already have the layout of the uniform storage
 			switch (variable.basetype)
 			{
 			case uniform_datatype::signed_integer:
-				get_uniform_value(variable, values_int, 16);
 				preset.get(variable.effect_filename, variable.name, values_int);
-				set_uniform_value(variable, values_int, 16);
+				values = values_int;
 				break;
 			case uniform_datatype::boolean:
 			case uniform_datatype::unsigned_integer:
-				get_uniform_value(variable, values_uint, 16);
 				preset.get(variable.effect_filename, variable.name, values_uint);
-				set_uniform_value(variable, values_uint, 16);
+				values = values_uint;
 				break;
 			case uniform_datatype::floating_point:
-				get_uniform_value(variable, values_float, 16);
 				preset.get(variable.effect_filename, variable.name, values_float);
-				set_uniform_value(variable, values_float, 16);
+				values = values_float;
 				break;
 			}
+
+			const size_t size = std::min(variable.storage_size, 16 * sizeof(float));
+			const size_t data_offset = image.uniform_data.size();
+
+			image.uniform_data.resize(data_offset + size);
+			std::memcpy(image.uniform_data.data() + data_offset, values, size);
+			image.uniform_values.push_back({ i, data_offset, size });
 		}
 
-		// Reorder techniques
-		std::vector<std::string> technique_list;
+		// The names point into the preset file contents, which stay alive until the end of this function
+		std::vector<std::string_view> technique_list;
 		preset.get("", "Techniques", technique_list);
-		std::vector<std::string> technique_sorting_list;
+		std::vector<std::string_view> technique_sorting_list;
 		preset.get("", "TechniqueSorting", technique_sorting_list);
 
 		if (technique_sorting_list.empty())
 			technique_sorting_list = technique_list;
 
-		std::sort(_techniques.begin(), _techniques.end(),
-			[&technique_sorting_list](const auto &lhs, const auto &rhs) {
-				return (std::find(technique_sorting_list.begin(), technique_sorting_list.end(), lhs.name) - technique_sorting_list.begin()) <
-					   (std::find(technique_sorting_list.begin(), technique_sorting_list.end(), rhs.name) - technique_sorting_list.begin());
-			});
+		// Look up the first position of every name only once, instead of searching the lists for every technique
+		std::unordered_map<std::string_view, size_t> technique_sorting_ranks;
+		for (size_t i = 0; i < technique_sorting_list.size(); i++)
+			technique_sorting_ranks.emplace(technique_sorting_list[i], i);
+		const std::unordered_set<std::string_view> enabled_techniques(technique_list.begin(), technique_list.end());
+
+		// Techniques the preset does not mention are sorted to the end
+		image.technique_ranks.assign(_techniques.size(), technique_sorting_list.size());
+		image.technique_enabled.assign(_techniques.size(), false);
 
 		for (auto &technique : _techniques)
 		{
+			assert(technique.load_index < _techniques.size());
+
+			if (const auto it = technique_sorting_ranks.find(technique.name); it != technique_sorting_ranks.end())
+			{
+				image.technique_ranks[technique.load_index] = it->second;
+			}
+
 			// Ignore preset if "enabled" annotation is set
-			technique.enabled = technique.annotations["enabled"].as<bool>() || std::find(technique_list.begin(), technique_list.end(), technique.name) != technique_list.end();
+			image.technique_enabled[technique.load_index] = technique.annotations["enabled"].as<bool>() || enabled_techniques.count(technique.name) != 0;
+
+			if (const std::string key = "Key" + technique.name; preset.has("", key))
+			{
+				preset_image::toggle_key toggle_key = { technique.load_index };
+				preset.get("", key, toggle_key.key_data);
+				image.toggle_keys.push_back(toggle_key);
+			}
+		}
+
+		return image;
+	}
+	void runtime::apply_preset_image(const preset_image &image)
+	{
+		for (const auto &value : image.uniform_values)
+		{
+			set_uniform_value(_uniforms[value.uniform_index], image.uniform_data.data() + value.data_offset, value.size);
+		}
+
+		// Reorder techniques by moving each one only once, keeping the current order of techniques with the same rank
+		std::vector<size_t> technique_order(_techniques.size());
+		for (size_t i = 0; i < technique_order.size(); i++)
+			technique_order[i] = i;
 
-			preset.get("", "Key" + technique.name, technique.toggle_key_data);
+		std::stable_sort(technique_order.begin(), technique_order.end(),
+			[this, &image](size_t lhs, size_t rhs) {
+				return image.technique_ranks[_techniques[lhs].load_index] < image.technique_ranks[_techniques[rhs].load_index];
+			});
+
+		std::vector<technique> techniques;
+		techniques.reserve(_techniques.size());
+
+		for (const size_t index : technique_order)
+		{
+			auto &technique = techniques.emplace_back(std::move(_techniques[index]));
+			technique.enabled = image.technique_enabled[technique.load_index];
+		}
+
+		// Reuse the order list to map the load index of every technique to its new position
+		for (size_t i = 0; i < techniques.size(); i++)
+		{
+			technique_order[techniques[i].load_index] = i;
+		}
+
+		_techniques = std::move(techniques);
+
+		for (const auto &toggle_key : image.toggle_keys)
+		{
+			std::copy_n(toggle_key.key_data, 4, _techniques[technique_order[toggle_key.technique_load_index]].toggle_key_data);
 		}
 	}
 	void runtime::load_current_preset()
@@ -1063,31 +1618,30 @@ namespace reshade
 		const int second = _date[3] - hour * 3600 - minute * 60;
 
 		char filename[25];
-		ImFormatString(filename, sizeof(filename), " %.4d-%.2d-%.2d %.2d-%.2d-%.2d", _date[0], _date[1], _date[2], hour, minute, second);
+		std::snprintf(filename, sizeof(filename), " %.4d-%.2d-%.2d %.2d-%.2d-%.2d", _date[0], _date[1], _date[2], hour, minute, second);
 		const auto path = _screenshot_path / (s_target_executable_path.filename_without_extension() + filename + (_screenshot_format == 0 ? ".bmp" : ".png"));
 
 		LOG(INFO) << "Saving screenshot to " << path << " ...";
 
-		FILE *file;
 		bool success = false;
 
-		if (_wfopen_s(&file, path.wstring().c_str(), L"wb") == 0)
+		if (std::ofstream file(path.native(), std::ios::out | std::ios::binary | std::ios::trunc); file.is_open())
 		{
 			stbi_write_func *const func = [](void *context, void *data, int size) {
-				fwrite(data, 1, size, static_cast<FILE *>(context));
+				static_cast<std::ofstream *>(context)->write(static_cast<const char *>(data), size);
 			};
 
 			switch (_screenshot_format)
 			{
 			case 0:
-				success = stbi_write_bmp_to_func(func, file, _width, _height, 4, data.data()) != 0;
+				success = stbi_write_bmp_to_func(func, &file, _width, _height, 4, data.data()) != 0;
 				break;
 			case 1:
-				success = stbi_write_png_to_func(func, file, _width, _height, 4, data.data(), 0) != 0;
+				success = stbi_write_png_to_func(func, &file, _width, _height, 4, data.data(), 0) != 0;
 				break;
 			}
 
-			fclose(file);
+			success = success && file.good();
 		}
 
 		if (!success)
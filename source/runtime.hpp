@@ -5,11 +5,16 @@
 
 #pragma once
 
+#include <deque>
 #include <chrono>
 #include <functional>
+#include <fstream>
 #include "filesystem.hpp"
 #include "ini_file.hpp"
 #include "runtime_objects.hpp"
+#include "texture_loader.hpp"
+#include "worker_pool.hpp"
+#include "depth_buffer_selector.hpp"
 
 #pragma region Forward Declarations
 struct ImDrawData;
@@ -70,7 +75,7 @@ namespace reshade
 		/// <summary>
 		/// Returns a boolean indicating whether any effects were loaded.
 		/// </summary>
-		bool is_effect_loaded() const { return _technique_count > 0 && _reload_remaining_effects == 0; }
+		bool is_effect_loaded() const { return _technique_count > 0 && _reload_remaining_effects == 0 && _reload_remaining_textures == 0; }
 
 		/// <summary>
 		/// Add a new texture.
@@ -120,6 +125,14 @@ namespace reshade
 		void set_uniform_value(uniform &variable, const unsigned int *values, size_t count);
 		void set_uniform_value(uniform &variable, const float *values, size_t count);
 
+		/// <summary>
+		/// Register a provider for uniform variables with the specified "source" annotation. Effects loaded afterwards make use of it.
+		/// </summary>
+		/// <param name="name">Value of the "source" annotation handled by this provider.</param>
+		/// <param name="validate">Function called once at effect load for each uniform variable using this source. It should parse the parameters of the variable into an object derived from "base_object", store it as data of the updater record and return whether the variable is valid. May be empty to accept every variable.</param>
+		/// <param name="update">Function called once per frame with the updater records of all loaded uniform variables using this source. It is never called if there are none.</param>
+		void register_uniform_source(std::string name, std::function<bool(const uniform &, uniform_updater &)> validate, std::function<void(const std::vector<uniform_updater> &)> update);
+
 		/// <summary>
 		/// Register a function to be called when the menu is drawn.
 		/// </summary>
@@ -189,15 +202,32 @@ namespace reshade
 		virtual bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) = 0;
 
 		/// <summary>
-		/// Loads image files and updates all textures with image data.
+		/// Start loading the image files of all textures in the background. The textures are updated with the image data by <see cref="upload_loaded_textures"/> as the files finish loading.
 		/// </summary>
 		void load_textures();
 		/// <summary>
+		/// Update textures with the image data that finished loading, until the time budget for this frame is used up.
+		/// </summary>
+		void upload_loaded_textures();
+		/// <summary>
+		/// Returns the layout <see cref="update_texture"/> expects the image data of a texture in. Image files are converted to it on the texture loader threads.
+		/// </summary>
+		/// <param name="texture">The texture that is going to be updated.</param>
+		virtual upload_layout get_upload_layout(const texture &texture) const { return { texture.levels }; }
+		/// <summary>
 		/// Update the image data of a texture.
 		/// </summary>
 		/// <param name="texture">The texture to update.</param>
-		/// <param name="data">The 32bpp RGBA image data to update the texture to.</param>
-		virtual bool update_texture(texture &texture, const uint8_t *data) = 0;
+		/// <param name="data">The image data of all mipmap levels to update the texture to, in the layout returned by <see cref="get_upload_layout"/>.</param>
+		/// <param name="levels">The location of each mipmap level in the image data.</param>
+		virtual bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) = 0;
+		/// <summary>
+		/// Make a texture use the memory of another texture with the same dimensions and format and release its own.
+		/// </summary>
+		/// <param name="texture">The texture whose memory is released.</param>
+		/// <param name="owner">The texture whose memory is shared.</param>
+		/// <returns>Returns if the texture uses the memory of the other one now.</returns>
+		virtual bool alias_texture(texture &/*texture*/, const texture &/*owner*/) { return false; }
 
 		/// <summary>
 		/// Load user configuration from disk.
@@ -213,39 +243,100 @@ namespace reshade
 		/// <param name="path">Output configuration path.</param>
 		void save_config(const filesystem::path &path) const;
 
+		/// <summary>
+		/// Compile the shaders of all passes in a technique. This is called on a worker thread, so it may only access the pass objects.
+		/// </summary>
+		/// <param name="passes">The passes of the technique to compile.</param>
+		/// <returns>Returns if the compilation succeeded.</returns>
+		virtual bool compile_technique(const std::vector<base_object *> &/*passes*/) const { return true; }
+		/// <summary>
+		/// Create the native shader objects of a technique after its compilation finished. This is called on the render thread.
+		/// </summary>
+		/// <param name="technique">The technique to finish.</param>
+		/// <returns>Returns if the shader objects were created successfully.</returns>
+		virtual bool create_technique_shaders(technique &/*technique*/) { return true; }
 		/// <summary>
 		/// Render all passes in a technique.
 		/// </summary>
 		/// <param name="technique">The technique to render.</param>
-		virtual void render_technique(const technique &technique) = 0;
+		virtual void render_technique(technique &technique) = 0;
+		/// <summary>
+		/// Find the parts of the constant block of a technique that changed since it was last uploaded and mark the block as up to date.
+		/// </summary>
+		/// <param name="technique">The technique to check.</param>
+		/// <param name="dirty_ranges">A list which is filled with the copy ranges that need to be uploaded again.</param>
+		/// <returns>Returns if the block needs to be uploaded at all.</returns>
+		bool update_uniform_block(technique &technique, std::vector<uniform_copy_range> &dirty_ranges);
+#if RESHADE_GUI
 		/// <summary>
 		/// Render command lists obtained from ImGui.
 		/// </summary>
 		/// <param name="data">The draw data to render.</param>
 		virtual void render_imgui_draw_data(ImDrawData *draw_data) = 0;
+#endif
 
 		unsigned int _width = 0, _height = 0;
+		bool _is_backbuffer_normalized = true;
 		unsigned int _vendor_id = 0, _device_id = 0;
 		uint64_t _framecount = 0;
 		unsigned int _drawcalls = 0, _vertices = 0;
+		unsigned int _uniform_uploads = 0, _uniform_uploads_skipped = 0;
 		std::shared_ptr<input> _input;
+#if RESHADE_GUI
 		ImGuiContext *_imgui_context = nullptr;
 		std::unique_ptr<base_object> _imgui_font_atlas_texture;
+#endif
 		std::vector<texture> _textures;
 		std::vector<uniform> _uniforms;
 		std::vector<technique> _techniques;
+		depth_buffer_selector _depth_buffer_selector;
 
 	private:
+		struct uniform_source_provider
+		{
+			std::string name;
+			std::function<bool(const uniform &, uniform_updater &)> validate;
+			std::function<void(const std::vector<uniform_updater> &)> update;
+			std::vector<uniform_updater> updaters;
+		};
+		// A preset compiled against the loaded effects, so that it can be applied without reading or parsing the preset file again
+		struct preset_image
+		{
+			struct uniform_value
+			{
+				size_t uniform_index, data_offset, size;
+			};
+			struct toggle_key
+			{
+				size_t technique_load_index;
+				uint32_t key_data[4];
+			};
+
+			uint64_t write_time = 0;
+			// Values of all uniforms the preset sets, packed one after another in the format of the uniform storage
+			std::vector<unsigned char> uniform_data;
+			std::vector<uniform_value> uniform_values;
+			// Position in the preset of every technique and whether it is enabled, indexed by the technique load index
+			std::vector<size_t> technique_ranks;
+			std::vector<bool> technique_enabled;
+			std::vector<toggle_key> toggle_keys;
+		};
+
+#if RESHADE_GUI
 		static bool check_for_update(unsigned long latest_version[3]);
+#endif
 
 		void reload();
 		void load_preset(const filesystem::path &path);
+		const preset_image &load_preset_image(const filesystem::path &path);
+		void apply_preset_image(const preset_image &image);
 		void load_current_preset();
 		void save_preset(const filesystem::path &path) const;
 		void save_preset(const filesystem::path &path, const filesystem::path &save_path) const;
 		void save_current_preset() const;
 		void save_screenshot() const;
 
+#if RESHADE_GUI
 		void draw_overlay();
 		void draw_overlay_menu();
 		void draw_overlay_menu_home();
@@ -255,20 +346,34 @@ namespace reshade
 		void draw_overlay_menu_about();
 		void draw_overlay_variable_editor();
 		void draw_overlay_technique_editor();
+#endif
 
 		void filter_techniques(const std::string &filter);
 
+		void alias_transient_textures();
+
+		void register_builtin_uniform_sources();
+		void create_uniform_updater(size_t uniform_index);
+
+		void begin_compile_technique(technique &technique);
+		bool finish_compile_technique(technique &technique);
+
 		const unsigned int _renderer_id;
 		bool _is_initialized = false;
 		std::vector<filesystem::path> _effect_files;
 		std::vector<filesystem::path> _preset_files;
+		std::unordered_map<std::string, preset_image> _preset_images;
 		std::vector<filesystem::path> _effect_search_paths;
 		std::vector<filesystem::path> _texture_search_paths;
 		std::chrono::high_resolution_clock::time_point _start_time;
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
 		std::chrono::high_resolution_clock::time_point _last_present_time;
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
+		std::vector<uniform_source_provider> _uniform_source_providers;
+		std::vector<size_t> _active_uniform_source_providers;
 		std::vector<unsigned char> _uniform_data_storage;
+		std::vector<uint64_t> _uniform_data_generations;
+		uint64_t _uniform_data_generation = 1;
 		int _date[4] = { };
 		std::vector<std::string> _preprocessor_definitions;
 		std::vector<std::pair<std::string, std::function<void()>>> _menu_callables;
@@ -285,6 +390,9 @@ namespace reshade
 		unsigned int _effects_key_data[4];
 		filesystem::path _configuration_path;
 		filesystem::path _screenshot_path;
+		filesystem::path _depth_buffer_trace_path;
+		depth_buffer_trace _depth_buffer_trace;
+		std::ofstream _depth_buffer_trace_file;
 		std::string _focus_effect;
 		bool _needs_update = false;
 		unsigned long _latest_version[3] = { };
@@ -303,6 +411,10 @@ namespace reshade
 		bool _screenshot_key_setting_active = false;
 		bool _toggle_key_setting_active = false;
 		bool _log_wordwrap = false;
+		std::string _log_filter_text;
+		// Indices of the log lines which pass the filter, and the index of the first line that was not filtered yet
+		std::deque<uint64_t> _log_filtered_lines;
+		uint64_t _log_filtered_end_index = 0;
 		unsigned char _switched_menu = 0;
 		float _imgui_col_background[3] = { 0.117647f, 0.117647f, 0.117647f };
 		float _imgui_col_item_background[3] = { 0.156863f, 0.156863f, 0.156863f };
@@ -314,6 +426,10 @@ namespace reshade
 		unsigned int _effects_expanded_state = 2;
 		char _effect_filter_buffer[64] = { };
 		size_t _reload_remaining_effects = 0;
+		size_t _reload_remaining_textures = 0;
+		texture_loader _texture_loader;
+		worker_pool _compile_pool;
+		unsigned int _texture_upload_budget = 4;
 		size_t _texture_count = 0;
 		size_t _uniform_count = 0;
 		size_t _technique_count = 0;
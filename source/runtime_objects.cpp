@@ -6,6 +6,7 @@
 #include "runtime.hpp"
 #include "runtime_objects.hpp"
 #include <assert.h>
+#include <cstring>
 #include <algorithm>
 
 namespace reshade
@@ -134,7 +135,28 @@ namespace reshade
 
 		assert(variable.storage_offset + size <= _uniform_data_storage.size());
 
+		// Only mark the value as changed when it actually did, so that techniques can skip uploading unchanged constant blocks
+		if (std::memcmp(&_uniform_data_storage[variable.storage_offset], data, size) == 0)
+		{
+			return;
+		}
+
 		std::memcpy(&_uniform_data_storage[variable.storage_offset], data, size);
+
+		// Generations are tracked in chunks of 16 bytes
+		const size_t chunk_begin = variable.storage_offset / 16, chunk_end = (variable.storage_offset + size + 15) / 16;
+
+		if (chunk_end > _uniform_data_generations.size())
+		{
+			_uniform_data_generations.resize((_uniform_data_storage.size() + 15) / 16);
+		}
+
+		const uint64_t generation = ++_uniform_data_generation;
+
+		for (size_t chunk = chunk_begin; chunk < chunk_end; chunk++)
+		{
+			_uniform_data_generations[chunk] = generation;
+		}
 	}
 	void runtime::set_uniform_value(uniform &variable, const bool *values, size_t count)
 	{
@@ -242,4 +264,42 @@ namespace reshade
 			}
 		}
 	}
+
+	bool runtime::update_uniform_block(technique &technique, std::vector<uniform_copy_range> &dirty_ranges)
+	{
+		dirty_ranges.clear();
+
+		// A generation of zero means the block was never uploaded, so everything has to be
+		if (technique.uniform_block_generation == 0)
+		{
+			dirty_ranges = technique.uniform_block_ranges;
+		}
+		else
+		{
+			for (const auto &range : technique.uniform_block_ranges)
+			{
+				const size_t chunk_begin = range.storage_offset / 16, chunk_end = std::min((range.storage_offset + range.size + 15) / 16, _uniform_data_generations.size());
+
+				for (size_t chunk = chunk_begin; chunk < chunk_end; chunk++)
+				{
+					if (_uniform_data_generations[chunk] > technique.uniform_block_generation)
+					{
+						dirty_ranges.push_back(range);
+						break;
+					}
+				}
+			}
+		}
+
+		technique.uniform_block_generation = _uniform_data_generation;
+
+		if (dirty_ranges.empty())
+		{
+			_uniform_uploads_skipped++;
+			return false;
+		}
+
+		_uniform_uploads++;
+		return true;
+	}
 }
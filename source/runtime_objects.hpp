@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <future>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -67,7 +68,6 @@ namespace reshade
 		unsigned_integer,
 		floating_point
 	};
-
 	class base_object abstract
 	{
 	public:
@@ -79,6 +79,20 @@ namespace reshade
 		const T *as() const { return dynamic_cast<const T *>(this); }
 	};
 
+	struct uniform_copy_range
+	{
+		size_t storage_offset, block_offset, size;
+	};
+	struct back_buffer_access
+	{
+		bool reads = false, writes = false, overwrites = false;
+	};
+	struct texture_access
+	{
+		std::vector<std::string> reads, writes;
+		bool overwrites = false;
+	};
+
 	struct texture final
 	{
 		#pragma region Constructors and Assignment Operators
@@ -95,6 +109,7 @@ namespace reshade
 		texture_format format = texture_format::unknown;
 		std::unordered_map<std::string, variant> annotations;
 		texture_reference impl_reference = texture_reference::none;
+		bool aliased = false;
 		std::unique_ptr<base_object> impl;
 	};
 	struct uniform final
@@ -116,6 +131,14 @@ namespace reshade
 		std::unordered_map<std::string, variant> annotations;
 		bool hidden = false;
 	};
+	struct uniform_updater
+	{
+		size_t uniform_index = 0;
+		/// <summary>
+		/// Parameters the provider of the source parsed from the annotations of the variable. Providers store their own type derived from <see cref="base_object"/> here.
+		/// </summary>
+		std::unique_ptr<base_object> data;
+	};
 	struct technique final
 	{
 		#pragma region Constructors and Assignment Operators
@@ -132,12 +155,20 @@ namespace reshade
 		std::unordered_map<std::string, variant> annotations;
 		bool hidden = false;
 		bool enabled = false;
+		bool compiled = false;
+		std::future<bool> compile_task;
 		int32_t timeout = 0;
 		int32_t timeleft = 0;
 		uint32_t toggle_key_data[4];
 		moving_average<uint64_t, 60> average_cpu_duration;
 		moving_average<uint64_t, 60> average_gpu_duration;
-		ptrdiff_t uniform_storage_offset = 0, uniform_storage_index = -1;
+		// Position in the list of techniques right after loading, which does not change when they are reordered
+		size_t load_index = 0;
+		ptrdiff_t uniform_storage_index = -1;
+		size_t uniform_block_size = 0;
+		std::vector<uniform_copy_range> uniform_block_ranges;
+		uint64_t uniform_block_generation = 0;
+		std::vector<texture_access> pass_texture_usage;
 		std::unique_ptr<base_object> impl;
 	};
 }
@@ -0,0 +1,1475 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "software_runtime.hpp"
+#include "software_effect_compiler.hpp"
+#include <assert.h>
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::software
+{
+	using namespace reshadefx;
+	using namespace reshadefx::nodes;
+
+	static unsigned int component_count(const type_node &type)
+	{
+		unsigned int count = 0;
+
+		if (type.is_struct())
+		{
+			for (auto field : type.definition->field_list)
+			{
+				count += component_count(field->type);
+			}
+		}
+		else if (type.is_sampler() || type.is_texture())
+		{
+			// Samplers are passed around as their index in the sampler list
+			count = 1;
+		}
+		else
+		{
+			count = type.rows * type.cols;
+		}
+
+		return count * std::max(1, type.array_length);
+	}
+	static scalar_type to_scalar_type(const type_node &type)
+	{
+		switch (type.basetype)
+		{
+			case type_node::datatype_bool:
+				return scalar_type::boolean;
+			case type_node::datatype_int:
+				return scalar_type::signed_integer;
+			case type_node::datatype_uint:
+			case type_node::datatype_sampler:
+				return scalar_type::unsigned_integer;
+			default:
+				return scalar_type::floating_point;
+		}
+	}
+	static type_node make_type(type_node::datatype basetype, unsigned int rows, unsigned int cols)
+	{
+		type_node type = { basetype, 0, rows, cols, 0, nullptr };
+		return type;
+	}
+	static type_node with_basetype(type_node type, type_node::datatype basetype)
+	{
+		type.basetype = basetype;
+		return type;
+	}
+	static std::vector<unsigned int> make_identity(unsigned int count)
+	{
+		std::vector<unsigned int> components(count);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			components[i] = i;
+		}
+
+		return components;
+	}
+	static std::string convert_semantic(const std::string &semantic)
+	{
+		if (semantic == "VERTEXID")
+		{
+			return "SV_VERTEXID";
+		}
+		else if (semantic == "POSITION" || semantic == "VPOS")
+		{
+			return "SV_POSITION";
+		}
+		else if (semantic.compare(0, 5, "COLOR") == 0)
+		{
+			return "SV_TARGET" + (semantic.size() > 5 ? semantic.substr(5) : "0");
+		}
+		else if (semantic == "SV_TARGET")
+		{
+			return "SV_TARGET0";
+		}
+		else if (semantic == "DEPTH")
+		{
+			return "SV_DEPTH";
+		}
+
+		return semantic;
+	}
+
+	software_effect_compiler::software_effect_compiler(software_runtime *runtime, const syntax_tree &ast, std::string &errors) :
+		_runtime(runtime),
+		_ast(ast),
+		_errors(errors),
+		_uniform_usage(ast),
+		_program(std::make_shared<shader_program>())
+	{
+	}
+
+	bool software_effect_compiler::run()
+	{
+		// Uniforms are read directly from uniform storage in units of 4 bytes, so keep them aligned
+		auto &uniform_storage = _runtime->get_uniform_value_storage();
+		_uniform_storage_offset = (uniform_storage.size() + 3) & ~size_t(3);
+		uniform_storage.resize(_uniform_storage_offset);
+
+		// Create all functions and assign storage to their parameters up front, so that calls can be translated before the callee
+		for (auto function : _ast.functions)
+		{
+			auto object = std::make_unique<shader_function>();
+			object->name = function->unique_name;
+
+			for (auto parameter : function->parameter_list)
+			{
+				allocate_variable(parameter);
+			}
+
+			_functions[function] = object.get();
+			_return_slots[function] = _program->variable_count;
+			_program->variable_count += component_count(function->return_type);
+			_program->functions.push_back(std::move(object));
+		}
+
+		auto global_initializers = std::make_unique<block_statement>();
+		_temporary_base = _temporary_cursor = _program->temporary_count;
+
+		for (auto variable : _ast.variables)
+		{
+			if (variable->type.is_texture())
+			{
+				visit_texture(variable);
+			}
+			else if (variable->type.is_sampler())
+			{
+				visit_sampler(variable);
+			}
+			else if (variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				visit_uniform(variable);
+			}
+			else
+			{
+				visit_global(variable, *global_initializers);
+			}
+		}
+
+		if (!global_initializers->statements.empty())
+		{
+			_program->global_initializers = std::move(global_initializers);
+		}
+
+		for (auto function : _ast.functions)
+		{
+			visit(function);
+		}
+		for (auto technique : _ast.techniques)
+		{
+			visit_technique(technique);
+		}
+
+		return _success;
+	}
+
+	void software_effect_compiler::error(const location &location, const std::string &message)
+	{
+		_success = false;
+
+		_errors += location.source + "(" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): error: " + message + '\n';
+	}
+	void software_effect_compiler::warning(const location &location, const std::string &message)
+	{
+		_errors += location.source + "(" + std::to_string(location.line) + ", " + std::to_string(location.column) + "): warning: " + message + '\n';
+	}
+
+	unsigned int software_effect_compiler::allocate_temporaries(unsigned int count)
+	{
+		const unsigned int index = _temporary_cursor;
+
+		_temporary_cursor += count;
+		_program->temporary_count = std::max(_program->temporary_count, _temporary_cursor);
+
+		return index;
+	}
+	unsigned int software_effect_compiler::allocate_variable(const variable_declaration_node *node)
+	{
+		const auto it = _variable_slots.find(node);
+
+		if (it != _variable_slots.end())
+		{
+			return it->second;
+		}
+
+		const unsigned int slot = _program->variable_count;
+		_program->variable_count += component_count(node->type);
+		_variable_slots[node] = slot;
+
+		return slot;
+	}
+
+	std::unique_ptr<shader_expression> software_effect_compiler::make_constant(const type_node &type, uint32_t value)
+	{
+		auto expression = make_expression<constant_expression>(component_count(type));
+		expression->values.assign(expression->components, value);
+
+		return expression;
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::make_load(shader_lvalue &&lvalue)
+	{
+		auto expression = make_expression<load_expression>(static_cast<unsigned int>(lvalue.components.size()));
+		expression->source = std::move(lvalue);
+
+		return expression;
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::make_store(shader_lvalue &&lvalue, std::unique_ptr<shader_expression> value)
+	{
+		auto expression = std::make_unique<store_expression>();
+		expression->components = value->components;
+		expression->result = value->result;
+		expression->target = std::move(lvalue);
+		expression->value = std::move(value);
+
+		return expression;
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::make_conversion(std::unique_ptr<shader_expression> expression, const type_node &from, const type_node &to)
+	{
+		if (!from.is_numeric() || !to.is_numeric() || from.is_array() || to.is_array() || to.is_void())
+		{
+			return expression;
+		}
+
+		const unsigned int count = to.rows * to.cols;
+		const scalar_type from_type = to_scalar_type(from), to_type = to_scalar_type(to);
+
+		if (from_type == to_type && count == expression->components)
+		{
+			return expression;
+		}
+
+		// Scalars are broadcast to all components, larger vectors and matrices are truncated
+		std::vector<unsigned int> swizzle(count);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (expression->components == 1)
+			{
+				swizzle[i] = 0;
+			}
+			else if (from.is_matrix() && to.is_matrix())
+			{
+				swizzle[i] = (i / to.cols) * from.cols + (i % to.cols);
+			}
+			else
+			{
+				swizzle[i] = std::min(i, expression->components - 1);
+			}
+		}
+
+		if (from_type == to_type)
+		{
+			auto result = make_expression<swizzle_expression>(count);
+			result->operand = std::move(expression);
+			result->swizzle = std::move(swizzle);
+			return result;
+		}
+		else
+		{
+			auto result = make_expression<convert_expression>(count);
+			result->from = from_type;
+			result->to = to_type;
+			result->operand = std::move(expression);
+			result->swizzle = std::move(swizzle);
+			return result;
+		}
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::make_binary(unsigned int op, std::unique_ptr<shader_expression> left, std::unique_ptr<shader_expression> right, scalar_type type)
+	{
+		auto expression = make_expression<binary_expression>(left->components);
+		expression->op = static_cast<enum binary_expression::op>(op);
+		expression->type = type;
+		expression->operands[0] = std::move(left);
+		expression->operands[1] = std::move(right);
+
+		return expression;
+	}
+
+	bool software_effect_compiler::build_lvalue(const expression_node *node, shader_lvalue &lvalue)
+	{
+		switch (node->id)
+		{
+			case nodeid::lvalue_expression:
+			{
+				const auto reference = static_cast<const lvalue_expression_node *>(node)->reference;
+
+				if (const auto it = _uniform_offsets.find(reference); it != _uniform_offsets.end())
+				{
+					lvalue.uniform = true;
+					lvalue.base = it->second;
+				}
+				else if (const auto it2 = _variable_slots.find(reference); it2 != _variable_slots.end())
+				{
+					lvalue.uniform = false;
+					lvalue.base = it2->second;
+				}
+				else
+				{
+					return false;
+				}
+
+				lvalue.type = to_scalar_type(reference->type);
+				lvalue.components = make_identity(component_count(reference->type));
+				return true;
+			}
+			case nodeid::field_expression:
+			{
+				const auto field = static_cast<const field_expression_node *>(node);
+
+				if (!build_lvalue(field->operand, lvalue))
+				{
+					return false;
+				}
+
+				unsigned int offset = 0;
+
+				for (auto member : field->operand->type.definition->field_list)
+				{
+					if (member == field->field_reference)
+					{
+						break;
+					}
+
+					offset += component_count(member->type);
+				}
+
+				const unsigned int count = component_count(field->field_reference->type);
+
+				lvalue.type = to_scalar_type(field->field_reference->type);
+				lvalue.components = std::vector<unsigned int>(lvalue.components.begin() + offset, lvalue.components.begin() + offset + count);
+				return true;
+			}
+			case nodeid::swizzle_expression:
+			{
+				const auto swizzle = static_cast<const swizzle_expression_node *>(node);
+
+				if (!build_lvalue(swizzle->operand, lvalue))
+				{
+					return false;
+				}
+
+				std::vector<unsigned int> components;
+
+				for (unsigned int i = 0; i < 4 && swizzle->mask[i] >= 0; i++)
+				{
+					// Matrix swizzles encode the row and column of an element in two bits each
+					const unsigned int index = swizzle->operand->type.is_matrix() ? (swizzle->mask[i] / 4) * swizzle->operand->type.cols + (swizzle->mask[i] % 4) : swizzle->mask[i];
+
+					components.push_back(lvalue.components[index]);
+				}
+
+				lvalue.components = std::move(components);
+				return true;
+			}
+			case nodeid::binary_expression:
+			{
+				const auto extract = static_cast<const binary_expression_node *>(node);
+
+				if (extract->op != binary_expression_node::element_extract || !build_lvalue(extract->operands[0], lvalue))
+				{
+					return false;
+				}
+
+				const auto &type = extract->operands[0]->type;
+				const unsigned int stride = component_count(extract->type);
+				const unsigned int count = type.is_array() ? type.array_length : type.rows;
+
+				if (extract->operands[1]->id == nodeid::literal_expression)
+				{
+					const auto index = static_cast<unsigned int>(std::min(std::max(static_cast<const literal_expression_node *>(extract->operands[1])->value_int[0], 0), static_cast<int>(count) - 1));
+
+					lvalue.components = std::vector<unsigned int>(lvalue.components.begin() + index * stride, lvalue.components.begin() + (index + 1) * stride);
+					return true;
+				}
+
+				// A dynamic index moves the base, which only works if all elements are laid out the same way
+				for (size_t i = stride; i < lvalue.components.size(); i++)
+				{
+					if (lvalue.components[i] != lvalue.components[i % stride] + static_cast<unsigned int>(i / stride) * stride)
+					{
+						return false;
+					}
+				}
+
+				lvalue.indices.push_back({ visit(extract->operands[1], make_type(type_node::datatype_int, 1, 1)), stride, count });
+				lvalue.components.resize(stride);
+				return true;
+			}
+			default:
+				return false;
+		}
+	}
+
+	std::unique_ptr<shader_statement> software_effect_compiler::visit(const statement_node *node)
+	{
+		if (node == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Temporaries only have to live as long as the statement that uses them
+		_temporary_cursor = _temporary_base;
+
+		switch (node->id)
+		{
+			case nodeid::compound_statement:
+			{
+				auto statement = std::make_unique<block_statement>();
+
+				for (auto child : static_cast<const compound_statement_node *>(node)->statement_list)
+				{
+					if (auto translated = visit(child))
+					{
+						statement->statements.push_back(std::move(translated));
+					}
+				}
+
+				return statement;
+			}
+			case nodeid::declarator_list:
+				return visit(static_cast<const declarator_list_node *>(node));
+			case nodeid::expression_statement:
+			{
+				auto statement = std::make_unique<expression_statement>();
+				statement->expression = visit(static_cast<const expression_statement_node *>(node)->expression);
+				return statement;
+			}
+			case nodeid::if_statement:
+			{
+				const auto branch = static_cast<const if_statement_node *>(node);
+
+				auto statement = std::make_unique<if_statement>();
+				statement->condition = visit(branch->condition, make_type(type_node::datatype_bool, 1, 1));
+				statement->statement_when_true = visit(branch->statement_when_true);
+				statement->statement_when_false = visit(branch->statement_when_false);
+				return statement;
+			}
+			case nodeid::switch_statement:
+				return visit(static_cast<const switch_statement_node *>(node));
+			case nodeid::for_statement:
+			{
+				const auto loop = static_cast<const for_statement_node *>(node);
+
+				auto statement = std::make_unique<loop_statement>();
+				statement->init_statement = visit(loop->init_statement);
+				_temporary_cursor = _temporary_base;
+				statement->condition = loop->condition != nullptr ? visit(loop->condition, make_type(type_node::datatype_bool, 1, 1)) : nullptr;
+				statement->increment_expression = loop->increment_expression != nullptr ? visit(loop->increment_expression) : nullptr;
+				statement->statement_list = visit(loop->statement_list);
+				return statement;
+			}
+			case nodeid::while_statement:
+			{
+				const auto loop = static_cast<const while_statement_node *>(node);
+
+				auto statement = std::make_unique<loop_statement>();
+				statement->is_do_while = loop->is_do_while;
+				statement->condition = visit(loop->condition, make_type(type_node::datatype_bool, 1, 1));
+				statement->statement_list = visit(loop->statement_list);
+				return statement;
+			}
+			case nodeid::return_statement:
+				return visit(static_cast<const return_statement_node *>(node));
+			case nodeid::jump_statement:
+			{
+				auto statement = std::make_unique<jump_statement>();
+				statement->is_break = static_cast<const jump_statement_node *>(node)->is_break;
+				return statement;
+			}
+			default:
+				assert(false);
+				return nullptr;
+		}
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const expression_node *node)
+	{
+		assert(node != nullptr);
+
+		switch (node->id)
+		{
+			case nodeid::lvalue_expression:
+			case nodeid::field_expression:
+			case nodeid::swizzle_expression:
+			{
+				shader_lvalue lvalue;
+
+				if (build_lvalue(node, lvalue))
+				{
+					return make_load(std::move(lvalue));
+				}
+
+				if (node->id == nodeid::lvalue_expression)
+				{
+					const auto reference = static_cast<const lvalue_expression_node *>(node)->reference;
+					const auto it = _sampler_indices.find(reference);
+
+					if (it == _sampler_indices.end())
+					{
+						error(node->location, "'" + reference->name + "' cannot be used as a value");
+					}
+
+					return make_constant(make_type(type_node::datatype_uint, 1, 1), it != _sampler_indices.end() ? it->second : 0);
+				}
+
+				// Selecting components of a value that is not stored anywhere
+				std::vector<unsigned int> components;
+				std::unique_ptr<shader_expression> operand;
+
+				if (node->id == nodeid::field_expression)
+				{
+					const auto field = static_cast<const field_expression_node *>(node);
+					unsigned int offset = 0;
+
+					for (auto member : field->operand->type.definition->field_list)
+					{
+						if (member == field->field_reference)
+						{
+							break;
+						}
+
+						offset += component_count(member->type);
+					}
+
+					operand = visit(field->operand);
+					components = make_identity(component_count(field->field_reference->type));
+
+					for (auto &component : components)
+					{
+						component += offset;
+					}
+				}
+				else
+				{
+					const auto swizzle = static_cast<const swizzle_expression_node *>(node);
+
+					operand = visit(swizzle->operand);
+
+					for (unsigned int i = 0; i < 4 && swizzle->mask[i] >= 0; i++)
+					{
+						components.push_back(swizzle->operand->type.is_matrix() ? (swizzle->mask[i] / 4) * swizzle->operand->type.cols + (swizzle->mask[i] % 4) : swizzle->mask[i]);
+					}
+				}
+
+				auto expression = make_expression<swizzle_expression>(static_cast<unsigned int>(components.size()));
+				expression->operand = std::move(operand);
+				expression->swizzle = std::move(components);
+				return expression;
+			}
+			case nodeid::literal_expression:
+			{
+				const auto literal = static_cast<const literal_expression_node *>(node);
+
+				auto expression = make_expression<constant_expression>(literal->type.rows * literal->type.cols);
+
+				for (unsigned int i = 0; i < expression->components; i++)
+				{
+					expression->values.push_back(literal->type.is_boolean() ? (literal->value_uint[i] != 0 ? 1 : 0) : literal->value_uint[i]);
+				}
+
+				return expression;
+			}
+			case nodeid::unary_expression:
+				return visit(static_cast<const unary_expression_node *>(node));
+			case nodeid::binary_expression:
+				return visit(static_cast<const binary_expression_node *>(node));
+			case nodeid::intrinsic_expression:
+				return visit(static_cast<const intrinsic_expression_node *>(node));
+			case nodeid::conditional_expression:
+			{
+				const auto conditional = static_cast<const conditional_expression_node *>(node);
+				const type_node condition_type = conditional->type.is_numeric() && !conditional->type.is_array() ? with_basetype(conditional->type, type_node::datatype_bool) : make_type(type_node::datatype_bool, 1, 1);
+
+				auto expression = make_expression<conditional_expression>(component_count(conditional->type));
+				expression->condition = visit(conditional->condition, condition_type);
+				expression->expression_when_true = visit(conditional->expression_when_true, conditional->type);
+				expression->expression_when_false = visit(conditional->expression_when_false, conditional->type);
+				return expression;
+			}
+			case nodeid::assignment_expression:
+				return visit(static_cast<const assignment_expression_node *>(node));
+			case nodeid::expression_sequence:
+			{
+				auto expression = std::make_unique<sequence_expression>();
+
+				for (auto child : static_cast<const expression_sequence_node *>(node)->expression_list)
+				{
+					expression->expressions.push_back(visit(child));
+				}
+
+				expression->result = expression->expressions.back()->result;
+				expression->components = expression->expressions.back()->components;
+				return expression;
+			}
+			case nodeid::call_expression:
+				return visit(static_cast<const call_expression_node *>(node));
+			case nodeid::constructor_expression:
+			{
+				const auto constructor = static_cast<const constructor_expression_node *>(node);
+
+				auto expression = std::make_unique<construct_expression>();
+
+				for (auto argument : constructor->arguments)
+				{
+					expression->operands.push_back(visit(argument, with_basetype(argument->type, constructor->type.basetype)));
+					expression->components += expression->operands.back()->components;
+				}
+
+				expression->result = allocate_temporaries(expression->components);
+				return expression;
+			}
+			case nodeid::initializer_list:
+				return visit_initializer(node, node->type);
+			default:
+				assert(false);
+				return make_constant(node->type, 0);
+		}
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const expression_node *node, const type_node &type)
+	{
+		return make_conversion(visit(node), node->type, type);
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const unary_expression_node *node)
+	{
+		switch (node->op)
+		{
+			case unary_expression_node::negate:
+			case unary_expression_node::bitwise_not:
+			case unary_expression_node::logical_not:
+			{
+				auto expression = make_expression<unary_expression>(component_count(node->type));
+				expression->op = node->op == unary_expression_node::negate ? unary_expression::negate : node->op == unary_expression_node::bitwise_not ? unary_expression::bitwise_not : unary_expression::logical_not;
+				expression->type = to_scalar_type(node->type);
+				expression->operand = visit(node->operand, node->type);
+				return expression;
+			}
+			case unary_expression_node::pre_increase:
+			case unary_expression_node::pre_decrease:
+			case unary_expression_node::post_increase:
+			case unary_expression_node::post_decrease:
+			{
+				shader_lvalue target, source;
+
+				if (!build_lvalue(node->operand, target) || !build_lvalue(node->operand, source))
+				{
+					error(node->location, "expression is not an l-value");
+					return make_constant(node->type, 0);
+				}
+
+				const bool increase = node->op == unary_expression_node::pre_increase || node->op == unary_expression_node::post_increase;
+				const uint32_t one = node->type.is_floating_point() ? 0x3F800000 : 1;
+
+				auto store = make_store(std::move(target), make_binary(increase ? binary_expression::add : binary_expression::subtract, make_load(std::move(source)), make_constant(node->type, one), to_scalar_type(node->type)));
+
+				if (node->op == unary_expression_node::pre_increase || node->op == unary_expression_node::pre_decrease)
+				{
+					return store;
+				}
+
+				// The value before the modification is loaded separately, so that the store does not overwrite it
+				shader_lvalue previous;
+				build_lvalue(node->operand, previous);
+
+				auto expression = std::make_unique<previous_value_expression>();
+				expression->load = make_load(std::move(previous));
+				expression->modify = std::move(store);
+				expression->result = expression->load->result;
+				expression->components = expression->load->components;
+				return expression;
+			}
+			case unary_expression_node::cast:
+				return visit(node->operand, node->type);
+			default:
+				return visit(node->operand);
+		}
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const binary_expression_node *node)
+	{
+		if (node->op == binary_expression_node::element_extract)
+		{
+			shader_lvalue lvalue;
+
+			if (build_lvalue(node, lvalue))
+			{
+				return make_load(std::move(lvalue));
+			}
+
+			const auto &type = node->operands[0]->type;
+			const unsigned int stride = component_count(node->type);
+			const unsigned int count = type.is_array() ? type.array_length : type.rows;
+
+			auto operand = visit(node->operands[0]);
+
+			if (node->operands[1]->id == nodeid::literal_expression)
+			{
+				const auto index = static_cast<unsigned int>(std::min(std::max(static_cast<const literal_expression_node *>(node->operands[1])->value_int[0], 0), static_cast<int>(count) - 1));
+
+				auto expression = make_expression<swizzle_expression>(stride);
+				expression->operand = std::move(operand);
+				expression->swizzle = make_identity(stride);
+
+				for (auto &component : expression->swizzle)
+				{
+					component += index * stride;
+				}
+
+				return expression;
+			}
+
+			auto expression = make_expression<extract_expression>(stride);
+			expression->operand = std::move(operand);
+			expression->index = visit(node->operands[1], make_type(type_node::datatype_int, 1, 1));
+			expression->stride = stride;
+			expression->count = count;
+			return expression;
+		}
+
+		type_node type = node->type;
+
+		switch (node->op)
+		{
+			case binary_expression_node::less:
+			case binary_expression_node::greater:
+			case binary_expression_node::less_equal:
+			case binary_expression_node::greater_equal:
+			case binary_expression_node::equal:
+			case binary_expression_node::not_equal:
+				// Comparisons are done in the type of the higher ranked operand
+				type.basetype = std::max(node->operands[0]->type.basetype, node->operands[1]->type.basetype);
+				break;
+			case binary_expression_node::logical_or:
+			case binary_expression_node::logical_and:
+				type.basetype = type_node::datatype_bool;
+				break;
+		}
+
+		// The operators are declared in the same order in both enumerations
+		return make_binary(node->op - binary_expression_node::add, visit(node->operands[0], type), visit(node->operands[1], type), to_scalar_type(type));
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const intrinsic_expression_node *node)
+	{
+		const unsigned int components = component_count(node->type);
+		const type_node float_type = with_basetype(node->type, type_node::datatype_float);
+		const auto own_float_type = [](const expression_node *argument) { return with_basetype(argument->type, type_node::datatype_float); };
+
+		auto expression = std::make_unique<intrinsic_expression>();
+		expression->components = components;
+		expression->type = to_scalar_type(node->type);
+
+		const auto add_write_back = [this, expression = expression.get()](const expression_node *argument, unsigned int offset, unsigned int count, const type_node &type) {
+			shader_lvalue target;
+
+			if (!build_lvalue(argument, target))
+			{
+				error(argument->location, "output argument is not an l-value");
+				return;
+			}
+
+			auto value = std::make_unique<temporary_expression>();
+			value->result = offset;
+			value->components = count;
+
+			expression->write_backs.push_back(make_store(std::move(target), make_conversion(std::move(value), type, argument->type)));
+		};
+
+		switch (node->op)
+		{
+			case intrinsic_expression_node::abs:
+			case intrinsic_expression_node::acos:
+			case intrinsic_expression_node::asin:
+			case intrinsic_expression_node::atan:
+			case intrinsic_expression_node::ceil:
+			case intrinsic_expression_node::cos:
+			case intrinsic_expression_node::cosh:
+			case intrinsic_expression_node::ddx:
+			case intrinsic_expression_node::ddy:
+			case intrinsic_expression_node::degrees:
+			case intrinsic_expression_node::exp:
+			case intrinsic_expression_node::exp2:
+			case intrinsic_expression_node::floor:
+			case intrinsic_expression_node::frac:
+			case intrinsic_expression_node::fwidth:
+			case intrinsic_expression_node::isinf:
+			case intrinsic_expression_node::isnan:
+			case intrinsic_expression_node::log:
+			case intrinsic_expression_node::log10:
+			case intrinsic_expression_node::log2:
+			case intrinsic_expression_node::normalize:
+			case intrinsic_expression_node::radians:
+			case intrinsic_expression_node::rcp:
+			case intrinsic_expression_node::round:
+			case intrinsic_expression_node::rsqrt:
+			case intrinsic_expression_node::saturate:
+			case intrinsic_expression_node::sign:
+			case intrinsic_expression_node::sin:
+			case intrinsic_expression_node::sinh:
+			case intrinsic_expression_node::sqrt:
+			case intrinsic_expression_node::tan:
+			case intrinsic_expression_node::tanh:
+			case intrinsic_expression_node::trunc:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				break;
+			case intrinsic_expression_node::atan2:
+			case intrinsic_expression_node::ldexp:
+			case intrinsic_expression_node::max:
+			case intrinsic_expression_node::min:
+			case intrinsic_expression_node::pow:
+			case intrinsic_expression_node::reflect:
+			case intrinsic_expression_node::step:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				expression->arguments[1] = visit(node->arguments[1], float_type);
+				break;
+			case intrinsic_expression_node::clamp:
+			case intrinsic_expression_node::faceforward:
+			case intrinsic_expression_node::lerp:
+			case intrinsic_expression_node::mad:
+			case intrinsic_expression_node::smoothstep:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				expression->arguments[1] = visit(node->arguments[1], float_type);
+				expression->arguments[2] = visit(node->arguments[2], float_type);
+				break;
+			case intrinsic_expression_node::refract:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				expression->arguments[1] = visit(node->arguments[1], float_type);
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_float, 1, 1));
+				break;
+			case intrinsic_expression_node::all:
+			case intrinsic_expression_node::any:
+				expression->arguments[0] = visit(node->arguments[0], with_basetype(node->arguments[0]->type, type_node::datatype_bool));
+				break;
+			case intrinsic_expression_node::bitcast_int2float:
+				expression->arguments[0] = visit(node->arguments[0], with_basetype(node->type, type_node::datatype_int));
+				break;
+			case intrinsic_expression_node::bitcast_uint2float:
+				expression->arguments[0] = visit(node->arguments[0], with_basetype(node->type, type_node::datatype_uint));
+				break;
+			case intrinsic_expression_node::bitcast_float2int:
+			case intrinsic_expression_node::bitcast_float2uint:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				break;
+			case intrinsic_expression_node::cross:
+				expression->arguments[0] = visit(node->arguments[0], make_type(type_node::datatype_float, 3, 1));
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 3, 1));
+				break;
+			case intrinsic_expression_node::determinant:
+			case intrinsic_expression_node::length:
+			case intrinsic_expression_node::transpose:
+				expression->arguments[0] = visit(node->arguments[0], own_float_type(node->arguments[0]));
+				expression->rows[0] = node->arguments[0]->type.rows;
+				expression->cols[0] = node->arguments[0]->type.cols;
+				break;
+			case intrinsic_expression_node::distance:
+			case intrinsic_expression_node::dot:
+			{
+				const auto &larger = component_count(node->arguments[0]->type) >= component_count(node->arguments[1]->type) ? node->arguments[0] : node->arguments[1];
+
+				expression->arguments[0] = visit(node->arguments[0], own_float_type(larger));
+				expression->arguments[1] = visit(node->arguments[1], own_float_type(larger));
+				break;
+			}
+			case intrinsic_expression_node::frexp:
+			case intrinsic_expression_node::modf:
+				expression->arguments[0] = visit(node->arguments[0], float_type);
+				expression->secondary_result = allocate_temporaries(components);
+				add_write_back(node->arguments[1], expression->secondary_result, components, float_type);
+				break;
+			case intrinsic_expression_node::sincos:
+			{
+				const type_node type = own_float_type(node->arguments[0]);
+				const unsigned int count = component_count(type);
+
+				expression->arguments[0] = visit(node->arguments[0], type);
+				expression->secondary_result = allocate_temporaries(count * 2);
+				add_write_back(node->arguments[1], expression->secondary_result, count, type);
+				add_write_back(node->arguments[2], expression->secondary_result + count, count, type);
+				break;
+			}
+			case intrinsic_expression_node::mul:
+				for (unsigned int i = 0; i < 2; i++)
+				{
+					const auto &type = node->arguments[i]->type;
+
+					expression->arguments[i] = visit(node->arguments[i], own_float_type(node->arguments[i]));
+
+					// Vectors are treated as row vectors on the left side and as column vectors on the right side of a matrix
+					if (type.is_vector())
+					{
+						expression->rows[i] = i == 0 ? 1 : type.rows;
+						expression->cols[i] = i == 0 ? type.rows : 1;
+					}
+					else
+					{
+						expression->rows[i] = type.rows;
+						expression->cols[i] = type.cols;
+					}
+				}
+				break;
+			case intrinsic_expression_node::texture:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 2, 1));
+				break;
+			case intrinsic_expression_node::texture_fetch:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_int, 4, 1));
+				break;
+			case intrinsic_expression_node::texture_gather:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 2, 1));
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_int, 1, 1));
+				break;
+			case intrinsic_expression_node::texture_gather_offset:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 2, 1));
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_int, 2, 1));
+				expression->arguments[3] = visit(node->arguments[3], make_type(type_node::datatype_int, 1, 1));
+				break;
+			case intrinsic_expression_node::texture_gradient:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 2, 1));
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_float, 2, 1));
+				expression->arguments[3] = visit(node->arguments[3], make_type(type_node::datatype_float, 2, 1));
+				break;
+			case intrinsic_expression_node::texture_level:
+			case intrinsic_expression_node::texture_projection:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 4, 1));
+				break;
+			case intrinsic_expression_node::texture_level_offset:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 4, 1));
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_int, 2, 1));
+				break;
+			case intrinsic_expression_node::texture_offset:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_float, 2, 1));
+				expression->arguments[2] = visit(node->arguments[2], make_type(type_node::datatype_int, 2, 1));
+				break;
+			case intrinsic_expression_node::texture_size:
+				expression->arguments[0] = visit(node->arguments[0]);
+				expression->arguments[1] = visit(node->arguments[1], make_type(type_node::datatype_int, 1, 1));
+				break;
+			default:
+				error(node->location, "unsupported intrinsic function");
+				return make_constant(node->type, 0);
+		}
+
+		switch (node->op)
+		{
+			#define MAP_INTRINSIC(name) case intrinsic_expression_node::name: expression->op = intrinsic_expression::name; break;
+			MAP_INTRINSIC(abs) MAP_INTRINSIC(acos) MAP_INTRINSIC(all) MAP_INTRINSIC(any) MAP_INTRINSIC(asin) MAP_INTRINSIC(atan) MAP_INTRINSIC(atan2) MAP_INTRINSIC(ceil) MAP_INTRINSIC(clamp)
+			MAP_INTRINSIC(cos) MAP_INTRINSIC(cosh) MAP_INTRINSIC(cross) MAP_INTRINSIC(ddx) MAP_INTRINSIC(ddy) MAP_INTRINSIC(degrees) MAP_INTRINSIC(determinant) MAP_INTRINSIC(distance) MAP_INTRINSIC(dot)
+			MAP_INTRINSIC(exp) MAP_INTRINSIC(exp2) MAP_INTRINSIC(faceforward) MAP_INTRINSIC(floor) MAP_INTRINSIC(frac) MAP_INTRINSIC(frexp) MAP_INTRINSIC(fwidth) MAP_INTRINSIC(isinf) MAP_INTRINSIC(isnan)
+			MAP_INTRINSIC(ldexp) MAP_INTRINSIC(length) MAP_INTRINSIC(lerp) MAP_INTRINSIC(log) MAP_INTRINSIC(log10) MAP_INTRINSIC(log2) MAP_INTRINSIC(mad) MAP_INTRINSIC(max) MAP_INTRINSIC(min)
+			MAP_INTRINSIC(modf) MAP_INTRINSIC(mul) MAP_INTRINSIC(normalize) MAP_INTRINSIC(pow) MAP_INTRINSIC(radians) MAP_INTRINSIC(rcp) MAP_INTRINSIC(reflect) MAP_INTRINSIC(refract) MAP_INTRINSIC(round)
+			MAP_INTRINSIC(rsqrt) MAP_INTRINSIC(saturate) MAP_INTRINSIC(sign) MAP_INTRINSIC(sin) MAP_INTRINSIC(sincos) MAP_INTRINSIC(sinh) MAP_INTRINSIC(smoothstep) MAP_INTRINSIC(sqrt) MAP_INTRINSIC(step)
+			MAP_INTRINSIC(tan) MAP_INTRINSIC(tanh) MAP_INTRINSIC(transpose) MAP_INTRINSIC(trunc) MAP_INTRINSIC(texture) MAP_INTRINSIC(texture_fetch) MAP_INTRINSIC(texture_gather)
+			MAP_INTRINSIC(texture_gather_offset) MAP_INTRINSIC(texture_gradient) MAP_INTRINSIC(texture_level) MAP_INTRINSIC(texture_level_offset) MAP_INTRINSIC(texture_offset) MAP_INTRINSIC(texture_projection) MAP_INTRINSIC(texture_size)
+			#undef MAP_INTRINSIC
+			default:
+				// All bit casts only reinterpret the value
+				expression->op = intrinsic_expression::bitcast;
+				break;
+		}
+
+		expression->result = allocate_temporaries(components);
+
+		return expression;
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const assignment_expression_node *node)
+	{
+		shader_lvalue target;
+
+		if (!build_lvalue(node->left, target))
+		{
+			error(node->location, "expression is not an l-value");
+			return make_constant(node->type, 0);
+		}
+		if (target.uniform)
+		{
+			error(node->location, "cannot assign to a uniform variable");
+			return make_constant(node->type, 0);
+		}
+
+		if (node->op == assignment_expression_node::none)
+		{
+			return make_store(std::move(target), visit(node->right, node->left->type));
+		}
+
+		unsigned int op = binary_expression::add;
+
+		switch (node->op)
+		{
+			case assignment_expression_node::subtract:
+				op = binary_expression::subtract;
+				break;
+			case assignment_expression_node::multiply:
+				op = binary_expression::multiply;
+				break;
+			case assignment_expression_node::divide:
+				op = binary_expression::divide;
+				break;
+			case assignment_expression_node::modulo:
+				op = binary_expression::modulo;
+				break;
+			case assignment_expression_node::bitwise_and:
+				op = binary_expression::bitwise_and;
+				break;
+			case assignment_expression_node::bitwise_or:
+				op = binary_expression::bitwise_or;
+				break;
+			case assignment_expression_node::bitwise_xor:
+				op = binary_expression::bitwise_xor;
+				break;
+			case assignment_expression_node::left_shift:
+				op = binary_expression::left_shift;
+				break;
+			case assignment_expression_node::right_shift:
+				op = binary_expression::right_shift;
+				break;
+		}
+
+		// The operation is done in the higher ranked type and the result converted back, e.g. an integer multiplied by a float is truncated afterwards
+		shader_lvalue source;
+		build_lvalue(node->left, source);
+
+		const type_node type = with_basetype(node->left->type, std::max(node->left->type.basetype, node->right->type.basetype));
+
+		auto value = make_binary(op, make_conversion(make_load(std::move(source)), node->left->type, type), visit(node->right, type), to_scalar_type(type));
+
+		return make_store(std::move(target), make_conversion(std::move(value), type, node->left->type));
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit(const call_expression_node *node)
+	{
+		const auto callee = _functions.find(node->callee);
+
+		if (callee == _functions.end())
+		{
+			error(node->location, "function '" + node->callee_name + "' is not defined");
+			return make_constant(node->type, 0);
+		}
+		if (node->callee == _current_function)
+		{
+			error(node->location, "recursive function calls are not allowed");
+			return make_constant(node->type, 0);
+		}
+
+		auto expression = make_expression<call_expression>(component_count(node->callee->return_type));
+		expression->callee = callee->second;
+		expression->return_slot = _return_slots.at(node->callee);
+
+		for (size_t i = 0; i < node->arguments.size() && i < node->callee->parameter_list.size(); i++)
+		{
+			const auto parameter = node->callee->parameter_list[i];
+			const auto argument = node->arguments[i];
+			const unsigned int slot = _variable_slots.at(parameter);
+
+			// Output parameters start out zeroed, so that reading them before writing gives the same result every time
+			if (parameter->type.has_qualifier(type_node::qualifier_in) || !parameter->type.has_qualifier(type_node::qualifier_out))
+			{
+				expression->arguments.push_back({ visit(argument, parameter->type), slot });
+			}
+			else
+			{
+				expression->arguments.push_back({ make_constant(parameter->type, 0), slot });
+			}
+
+			if (parameter->type.has_qualifier(type_node::qualifier_out))
+			{
+				shader_lvalue target, source;
+
+				if (!build_lvalue(argument, target))
+				{
+					error(argument->location, "output argument is not an l-value");
+					continue;
+				}
+
+				source.base = slot;
+				source.type = to_scalar_type(parameter->type);
+				source.components = make_identity(component_count(parameter->type));
+
+				expression->write_backs.push_back(make_store(std::move(target), make_conversion(make_load(std::move(source)), parameter->type, argument->type)));
+			}
+		}
+
+		return expression;
+	}
+	std::unique_ptr<shader_expression> software_effect_compiler::visit_initializer(const expression_node *node, const type_node &type)
+	{
+		if (node->id != nodeid::initializer_list)
+		{
+			return visit(node, type);
+		}
+
+		const auto &values = static_cast<const initializer_list_node *>(node)->values;
+
+		auto expression = std::make_unique<construct_expression>();
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			type_node element_type = type;
+
+			if (type.is_array())
+			{
+				element_type.array_length = 0;
+			}
+			else if (type.is_struct() && i < type.definition->field_list.size())
+			{
+				element_type = type.definition->field_list[i]->type;
+			}
+			else
+			{
+				element_type.rows = element_type.cols = 1;
+			}
+
+			expression->operands.push_back(visit_initializer(values[i], element_type));
+			expression->components += expression->operands.back()->components;
+		}
+
+		expression->result = allocate_temporaries(expression->components);
+
+		return expression;
+	}
+	std::unique_ptr<shader_statement> software_effect_compiler::visit(const declarator_list_node *node)
+	{
+		auto statement = std::make_unique<block_statement>();
+
+		for (auto variable : node->declarator_list)
+		{
+			_temporary_cursor = _temporary_base;
+
+			shader_lvalue target;
+			target.base = allocate_variable(variable);
+			target.type = to_scalar_type(variable->type);
+			target.components = make_identity(component_count(variable->type));
+
+			auto initialization = std::make_unique<expression_statement>();
+			initialization->expression = make_store(std::move(target), variable->initializer_expression != nullptr ? visit_initializer(variable->initializer_expression, variable->type) : make_constant(variable->type, 0));
+
+			statement->statements.push_back(std::move(initialization));
+		}
+
+		return statement;
+	}
+	std::unique_ptr<shader_statement> software_effect_compiler::visit(const switch_statement_node *node)
+	{
+		auto statement = std::make_unique<switch_statement>();
+		statement->test_expression = visit(node->test_expression, with_basetype(node->test_expression->type, node->test_expression->type.is_floating_point() ? type_node::datatype_int : node->test_expression->type.basetype));
+
+		for (auto case_node : node->case_list)
+		{
+			std::vector<switch_statement::case_label> labels;
+
+			for (auto label : case_node->labels)
+			{
+				labels.push_back({ label == nullptr, label != nullptr ? label->value_uint[0] : 0 });
+			}
+
+			statement->case_labels.push_back(std::move(labels));
+			statement->case_statements.push_back(visit(case_node->statement_list));
+		}
+
+		return statement;
+	}
+	std::unique_ptr<shader_statement> software_effect_compiler::visit(const return_statement_node *node)
+	{
+		auto statement = std::make_unique<return_statement>();
+		statement->is_discard = node->is_discard;
+
+		if (node->return_value != nullptr && !_current_function->return_type.is_void())
+		{
+			shader_lvalue target;
+			target.base = _return_slots.at(_current_function);
+			target.type = to_scalar_type(_current_function->return_type);
+			target.components = make_identity(component_count(_current_function->return_type));
+
+			statement->return_value = make_store(std::move(target), visit(node->return_value, _current_function->return_type));
+		}
+
+		return statement;
+	}
+	void software_effect_compiler::visit(const function_declaration_node *node)
+	{
+		_current_function = node;
+
+		// Each function gets its own range of temporaries, since a call happens in the middle of an expression of the caller
+		_temporary_base = _temporary_cursor = _program->temporary_count;
+
+		_functions.at(node)->body = visit(node->definition);
+
+		_current_function = nullptr;
+	}
+
+	void software_effect_compiler::visit_texture(const variable_declaration_node *node)
+	{
+		const auto existing_texture = _runtime->find_texture(node->unique_name);
+
+		if (existing_texture != nullptr)
+		{
+			if (!node->semantic.empty() && node->semantic != "COLOR" && node->semantic != "SV_TARGET" && node->semantic != "DEPTH" && node->semantic != "SV_DEPTH")
+			{
+				error(node->location, "invalid semantic");
+			}
+			else if (node->semantic.empty() && (
+				existing_texture->width != node->properties.width ||
+				existing_texture->height != node->properties.height ||
+				existing_texture->levels != node->properties.levels ||
+				existing_texture->format != node->properties.format))
+			{
+				error(node->location, existing_texture->effect_filename + " already created a texture with the same name but different dimensions; textures are shared across all effects, so either rename the variable or adjust the dimensions so they match");
+			}
+			return;
+		}
+
+		texture obj;
+		obj.name = node->name;
+		obj.unique_name = node->unique_name;
+		obj.annotations = node->annotation_list;
+		obj.width = node->properties.width;
+		obj.height = node->properties.height;
+		obj.levels = node->properties.levels;
+		obj.format = node->properties.format;
+
+		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
+		{
+			obj.width = _runtime->frame_width();
+			obj.height = _runtime->frame_height();
+			obj.impl_reference = texture_reference::back_buffer;
+		}
+		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		{
+			obj.width = _runtime->frame_width();
+			obj.height = _runtime->frame_height();
+			obj.impl_reference = texture_reference::depth_buffer;
+		}
+		else if (!node->semantic.empty())
+		{
+			error(node->location, "invalid semantic");
+			return;
+		}
+		else
+		{
+			obj.impl = std::make_unique<software_tex_data>();
+
+			resize_texture(*obj.impl->as<software_tex_data>(), obj.width, obj.height, obj.levels, obj.format);
+		}
+
+		_runtime->add_texture(std::move(obj));
+	}
+	void software_effect_compiler::visit_sampler(const variable_declaration_node *node)
+	{
+		const auto texture = _runtime->find_texture(node->properties.texture->unique_name);
+
+		if (texture == nullptr)
+		{
+			error(node->location, "texture '" + node->properties.texture->name + "' for sampler '" + node->name + "' is missing due to previous error");
+			return;
+		}
+
+		software_sampler sampler;
+		sampler.filter = node->properties.filter;
+		sampler.address_u = node->properties.address_u;
+		sampler.address_v = node->properties.address_v;
+		sampler.min_lod = node->properties.min_lod;
+		sampler.max_lod = node->properties.max_lod;
+		sampler.lod_bias = node->properties.lod_bias;
+
+		switch (texture->impl_reference)
+		{
+			case texture_reference::back_buffer:
+				sampler.texture = &_runtime->_backbuffer_texture;
+				break;
+			case texture_reference::depth_buffer:
+				sampler.texture = &_runtime->_depth_texture;
+				break;
+			default:
+				sampler.texture = texture->impl->as<software_tex_data>();
+				break;
+		}
+
+		sampler.srgb = node->properties.srgb_texture && is_srgb_capable(sampler.texture->format);
+
+		_sampler_indices[node] = static_cast<unsigned int>(_samplers.size());
+		_samplers.push_back(sampler);
+	}
+	void software_effect_compiler::visit_uniform(const variable_declaration_node *node)
+	{
+		uniform obj;
+		obj.name = node->name;
+		obj.unique_name = node->unique_name;
+		obj.basetype = obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
+		obj.rows = node->type.rows;
+		obj.columns = node->type.cols;
+		obj.elements = node->type.array_length;
+		obj.storage_size = node->type.rows * node->type.cols * std::max(1u, obj.elements) * 4;
+		obj.storage_offset = _uniform_storage_offset + _uniform_storage_size;
+		obj.annotations = node->annotation_list;
+
+		// Uniforms are packed tightly, since they are read per component anyway
+		_uniform_storage_size += obj.storage_size;
+
+		auto &uniform_storage = _runtime->get_uniform_value_storage();
+		uniform_storage.resize(_uniform_storage_offset + _uniform_storage_size);
+
+		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
+		{
+			std::memcpy(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, std::min(obj.storage_size, sizeof(literal_expression_node::value_float)));
+		}
+		else
+		{
+			std::memset(uniform_storage.data() + obj.storage_offset, 0, obj.storage_size);
+		}
+
+		_uniform_offsets[node] = static_cast<unsigned int>(obj.storage_offset / 4);
+
+		_runtime->add_uniform(std::move(obj));
+	}
+	void software_effect_compiler::visit_global(const variable_declaration_node *node, block_statement &initializers)
+	{
+		_temporary_cursor = _temporary_base;
+
+		shader_lvalue target;
+		target.base = allocate_variable(node);
+		target.type = to_scalar_type(node->type);
+		target.components = make_identity(component_count(node->type));
+
+		// Global variables are initialized again before every invocation, since each invocation has its own copy of them
+		auto initialization = std::make_unique<expression_statement>();
+		initialization->expression = make_store(std::move(target), node->initializer_expression != nullptr ? visit_initializer(node->initializer_expression, node->type) : make_constant(node->type, 0));
+
+		initializers.statements.push_back(std::move(initialization));
+	}
+	void software_effect_compiler::visit_technique(const technique_declaration_node *node)
+	{
+		technique obj;
+		obj.name = node->name;
+		obj.annotations = node->annotation_list;
+
+		for (auto pass : node->pass_list)
+		{
+			obj.passes.emplace_back(std::make_unique<software_pass_data>());
+			visit_pass(pass, *static_cast<software_pass_data *>(obj.passes.back().get()));
+			obj.pass_texture_usage.push_back(analyze_texture_access(_uniform_usage, pass));
+		}
+
+		_runtime->add_technique(std::move(obj));
+	}
+	void software_effect_compiler::visit_pass(const pass_declaration_node *node, software_pass_data &pass)
+	{
+		pass.program = _program;
+		pass.samplers = _samplers;
+		pass.clear_render_targets = node->clear_render_targets;
+		pass.srgb_write_enable = node->srgb_write_enable;
+		pass.blend_enable = node->blend_enable;
+		pass.stencil_enable = node->stencil_enable;
+		pass.color_write_mask = node->color_write_mask;
+		pass.stencil_read_mask = node->stencil_read_mask;
+		pass.stencil_write_mask = node->stencil_write_mask;
+		pass.blend_op = node->blend_op;
+		pass.blend_op_alpha = node->blend_op_alpha;
+		pass.src_blend = node->src_blend;
+		pass.dest_blend = node->dest_blend;
+		pass.src_blend_alpha = node->src_blend_alpha;
+		pass.dest_blend_alpha = node->dest_blend_alpha;
+		pass.stencil_comparison_func = node->stencil_comparison_func;
+		pass.stencil_reference_value = node->stencil_reference_value;
+		pass.stencil_op_pass = node->stencil_op_pass;
+		pass.stencil_op_fail = node->stencil_op_fail;
+		pass.back_buffer_usage = analyze_back_buffer_access(_uniform_usage, node);
+
+		if (node->vertex_shader != nullptr)
+		{
+			visit_pass_shader(node->vertex_shader, pass.vertex_shader);
+		}
+		if (node->pixel_shader != nullptr)
+		{
+			visit_pass_shader(node->pixel_shader, pass.pixel_shader);
+		}
+
+		pass.render_targets[0] = &_runtime->_backbuffer;
+
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (node->render_targets[i] == nullptr)
+			{
+				continue;
+			}
+
+			const auto texture = _runtime->find_texture(node->render_targets[i]->unique_name);
+
+			if (texture == nullptr || texture->impl == nullptr)
+			{
+				error(node->location, "texture not found");
+				return;
+			}
+
+			if (pass.viewport_width != 0 && pass.viewport_height != 0 && (texture->width != pass.viewport_width || texture->height != pass.viewport_height))
+			{
+				error(node->location, "cannot use multiple rendertargets with different sized textures");
+				return;
+			}
+
+			pass.viewport_width = texture->width;
+			pass.viewport_height = texture->height;
+			pass.render_targets[i] = texture->impl->as<software_tex_data>();
+		}
+
+		if (pass.viewport_width == 0 && pass.viewport_height == 0)
+		{
+			pass.viewport_width = _runtime->frame_width();
+			pass.viewport_height = _runtime->frame_height();
+		}
+
+		// Textures cannot be sampled while they are rendered to, they read as zero instead
+		for (auto &sampler : pass.samplers)
+		{
+			if (std::find(std::begin(pass.render_targets), std::end(pass.render_targets), sampler.texture) != std::end(pass.render_targets))
+			{
+				sampler.texture = nullptr;
+			}
+		}
+	}
+	void software_effect_compiler::visit_pass_shader(const function_declaration_node *node, shader_entry_point &entry_point)
+	{
+		entry_point.function = _functions.at(node);
+
+		for (auto parameter : node->parameter_list)
+		{
+			const unsigned int slot = _variable_slots.at(parameter);
+
+			if (parameter->type.has_qualifier(type_node::qualifier_in) || !parameter->type.has_qualifier(type_node::qualifier_out))
+			{
+				add_signature_element(parameter->type, parameter->semantic, slot, entry_point.inputs);
+			}
+			if (parameter->type.has_qualifier(type_node::qualifier_out))
+			{
+				add_signature_element(parameter->type, parameter->semantic, slot, entry_point.outputs);
+			}
+		}
+
+		add_signature_element(node->return_type, node->return_semantic, _return_slots.at(node), entry_point.outputs);
+	}
+	void software_effect_compiler::add_signature_element(const type_node &type, const std::string &semantic, unsigned int slot, std::vector<shader_signature_element> &elements)
+	{
+		if (type.is_struct())
+		{
+			for (auto field : type.definition->field_list)
+			{
+				add_signature_element(field->type, field->semantic, slot, elements);
+
+				slot += component_count(field->type);
+			}
+		}
+		else if (!semantic.empty() && type.is_numeric())
+		{
+			elements.push_back({ convert_semantic(semantic), slot, component_count(type), to_scalar_type(type), type.qualifiers });
+		}
+	}
+}
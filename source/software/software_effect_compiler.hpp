@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "effect_uniform_usage.hpp"
+#include "software_shader.hpp"
+
+namespace reshade::software
+{
+	#pragma region Forward Declarations
+	struct software_pass_data;
+	class software_runtime;
+	#pragma endregion
+
+	/// <summary>
+	/// Translates an effect into the intermediate representation executed by the software runtime and creates its textures, uniforms and techniques.
+	/// </summary>
+	class software_effect_compiler
+	{
+	public:
+		software_effect_compiler(software_runtime *runtime, const reshadefx::syntax_tree &ast, std::string &errors);
+
+		bool run();
+
+	private:
+		void error(const reshadefx::location &location, const std::string &message);
+		void warning(const reshadefx::location &location, const std::string &message);
+
+		unsigned int allocate_temporaries(unsigned int count);
+		unsigned int allocate_variable(const reshadefx::nodes::variable_declaration_node *node);
+
+		template <typename T>
+		std::unique_ptr<T> make_expression(unsigned int components)
+		{
+			auto expression = std::make_unique<T>();
+			expression->components = components;
+			expression->result = allocate_temporaries(components);
+			return expression;
+		}
+		std::unique_ptr<shader_expression> make_constant(const reshadefx::nodes::type_node &type, uint32_t value);
+		std::unique_ptr<shader_expression> make_load(shader_lvalue &&lvalue);
+		std::unique_ptr<shader_expression> make_store(shader_lvalue &&lvalue, std::unique_ptr<shader_expression> value);
+		std::unique_ptr<shader_expression> make_conversion(std::unique_ptr<shader_expression> expression, const reshadefx::nodes::type_node &from, const reshadefx::nodes::type_node &to);
+		std::unique_ptr<shader_expression> make_binary(unsigned int op, std::unique_ptr<shader_expression> left, std::unique_ptr<shader_expression> right, scalar_type type);
+
+		bool build_lvalue(const reshadefx::nodes::expression_node *node, shader_lvalue &lvalue);
+
+		std::unique_ptr<shader_statement> visit(const reshadefx::nodes::statement_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::expression_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::expression_node *node, const reshadefx::nodes::type_node &type);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::unary_expression_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::binary_expression_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::intrinsic_expression_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::assignment_expression_node *node);
+		std::unique_ptr<shader_expression> visit(const reshadefx::nodes::call_expression_node *node);
+		std::unique_ptr<shader_expression> visit_initializer(const reshadefx::nodes::expression_node *node, const reshadefx::nodes::type_node &type);
+		std::unique_ptr<shader_statement> visit(const reshadefx::nodes::declarator_list_node *node);
+		std::unique_ptr<shader_statement> visit(const reshadefx::nodes::switch_statement_node *node);
+		std::unique_ptr<shader_statement> visit(const reshadefx::nodes::return_statement_node *node);
+		void visit(const reshadefx::nodes::function_declaration_node *node);
+
+		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
+		void visit_global(const reshadefx::nodes::variable_declaration_node *node, block_statement &initializers);
+		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
+		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, software_pass_data &pass);
+		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, shader_entry_point &entry_point);
+		void add_signature_element(const reshadefx::nodes::type_node &type, const std::string &semantic, unsigned int slot, std::vector<shader_signature_element> &elements);
+
+		software_runtime *_runtime;
+		bool _success = true;
+		const reshadefx::syntax_tree &_ast;
+		std::string &_errors;
+		reshadefx::uniform_usage _uniform_usage;
+		std::shared_ptr<shader_program> _program;
+		std::vector<software_sampler> _samplers;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, unsigned int> _variable_slots, _uniform_offsets, _sampler_indices;
+		std::unordered_map<const reshadefx::nodes::function_declaration_node *, unsigned int> _return_slots;
+		std::unordered_map<const reshadefx::nodes::function_declaration_node *, shader_function *> _functions;
+		const reshadefx::nodes::function_declaration_node *_current_function = nullptr;
+		unsigned int _temporary_base = 0, _temporary_cursor = 0;
+		size_t _uniform_storage_offset = 0, _uniform_storage_size = 0;
+	};
+}
@@ -0,0 +1,757 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "input.hpp"
+#include "software_runtime.hpp"
+#include "software_effect_compiler.hpp"
+#include <assert.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <algorithm>
+#if RESHADE_GUI
+#include <imgui.h>
+#endif
+
+namespace reshade::software
+{
+	namespace
+	{
+		/// <summary>
+		/// A vertex shader output, which is interpolated across the triangle into a pixel shader input.
+		/// </summary>
+		struct interpolant
+		{
+			enum mode
+			{
+				perspective,
+				linear,
+				flat
+			};
+
+			unsigned int slot, components;
+			mode mode;
+			std::vector<uint32_t> values[3];
+		};
+
+		const unsigned int tile_size = 64;
+	}
+
+	static bool is_float_format(texture_format format)
+	{
+		switch (format)
+		{
+			case texture_format::r16f:
+			case texture_format::r32f:
+			case texture_format::rg16f:
+			case texture_format::rg32f:
+			case texture_format::rgba16f:
+			case texture_format::rgba32f:
+				return true;
+			default:
+				return false;
+		}
+	}
+	static float edge_function(const float a[2], const float b[2], float x, float y)
+	{
+		return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+	}
+	static bool is_top_left_edge(const float a[2], const float b[2])
+	{
+		// Triangles are ordered so that their area is positive, in which case top edges point right and left edges point up
+		return (a[1] == b[1] && b[0] > a[0]) || b[1] < a[1];
+	}
+	static float blend_factor(unsigned int factor, unsigned int c, const float src[4], const float dst[4])
+	{
+		switch (factor)
+		{
+			default:
+			case 0: // ZERO
+				return 0.0f;
+			case 1: // ONE
+				return 1.0f;
+			case 2: // SRCCOLOR
+				return src[c];
+			case 3: // INVSRCCOLOR
+				return 1.0f - src[c];
+			case 4: // SRCALPHA
+				return src[3];
+			case 5: // INVSRCALPHA
+				return 1.0f - src[3];
+			case 6: // DESTALPHA
+				return dst[3];
+			case 7: // INVDESTALPHA
+				return 1.0f - dst[3];
+			case 8: // DESTCOLOR
+				return dst[c];
+			case 9: // INVDESTCOLOR
+				return 1.0f - dst[c];
+		}
+	}
+	static float blend_operation(unsigned int op, float src, float dst)
+	{
+		switch (op)
+		{
+			default:
+			case 1: // ADD
+				return src + dst;
+			case 2: // SUBTRACT
+				return src - dst;
+			case 3: // REVSUBTRACT
+				return dst - src;
+			case 4: // MIN
+				return std::min(src, dst);
+			case 5: // MAX
+				return std::max(src, dst);
+		}
+	}
+	static bool stencil_test(unsigned int func, unsigned int reference, unsigned int value)
+	{
+		switch (func)
+		{
+			case 1: // NEVER
+				return false;
+			case 2: // LESS
+				return reference < value;
+			case 3: // EQUAL
+				return reference == value;
+			case 4: // LESSEQUAL
+				return reference <= value;
+			case 5: // GREATER
+				return reference > value;
+			case 6: // NOTEQUAL
+				return reference != value;
+			case 7: // GREATEREQUAL
+				return reference >= value;
+			default:
+			case 8: // ALWAYS
+				return true;
+		}
+	}
+	static uint8_t stencil_operation(unsigned int op, uint8_t reference, uint8_t value)
+	{
+		switch (op)
+		{
+			case 0: // ZERO
+				return 0;
+			default:
+			case 1: // KEEP
+				return value;
+			case 3: // REPLACE
+				return reference;
+			case 4: // INCRSAT
+				return value == 0xFF ? value : value + 1;
+			case 5: // DECRSAT
+				return value == 0 ? value : value - 1;
+			case 6: // INVERT
+				return ~value;
+			case 7: // INCR
+				return value + 1;
+			case 8: // DECR
+				return value - 1;
+		}
+	}
+
+	software_runtime::software_runtime() : runtime(0xb000)
+	{
+		_input = std::make_shared<input>(nullptr);
+	}
+
+	bool software_runtime::on_init(unsigned int width, unsigned int height)
+	{
+		_width = width;
+		_height = height;
+
+		resize_texture(_backbuffer, width, height, 1, texture_format::rgba8);
+		resize_texture(_backbuffer_texture, width, height, 1, texture_format::rgba8);
+		resize_texture(_depth_texture, width, height, 1, texture_format::r32f);
+
+		// Nothing was rendered yet, so the depth buffer is at the far plane everywhere
+		for (size_t i = 0; i < _depth_texture.levels[0].texels.size(); i += 4)
+		{
+			_depth_texture.levels[0].texels[i] = 1.0f;
+		}
+
+		_stencil_buffer.assign(width * height, 0);
+
+#if RESHADE_GUI
+		int font_atlas_width, font_atlas_height;
+		unsigned char *font_atlas_pixels;
+
+		ImGui::SetCurrentContext(_imgui_context);
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&font_atlas_pixels, &font_atlas_width, &font_atlas_height);
+
+		auto font_atlas = std::make_unique<software_tex_data>();
+		resize_texture(*font_atlas, font_atlas_width, font_atlas_height, 1, texture_format::rgba8);
+		update_texture_data(*font_atlas, font_atlas_pixels);
+
+		_imgui_font_atlas_texture = std::move(font_atlas);
+#endif
+
+		return runtime::on_init();
+	}
+	void software_runtime::on_reset()
+	{
+		runtime::on_reset();
+
+		_backbuffer.levels.clear();
+		_backbuffer_texture.levels.clear();
+		_depth_texture.levels.clear();
+		_stencil_buffer.clear();
+	}
+	void software_runtime::on_present()
+	{
+		if (!is_initialized())
+			return;
+
+		// There are no application draw calls, so the statistics only count the effect passes
+		_vertices = 0;
+		_drawcalls = 0;
+
+		// Apply post processing
+		if (is_effect_loaded())
+		{
+			_back_buffer_planner.begin_frame();
+
+			on_present_effect();
+
+			const int final_surface = _back_buffer_planner.end_frame();
+
+			if (final_surface > 0)
+			{
+				_backbuffer.levels[0].texels = _backbuffer_texture.levels[0].texels;
+			}
+		}
+
+		// Apply presenting
+		runtime::on_present();
+	}
+
+	void software_runtime::update_back_buffer(const uint8_t *data)
+	{
+		assert(data != nullptr);
+
+		update_texture_data(_backbuffer, data);
+	}
+	void software_runtime::update_depth_buffer(const float *data)
+	{
+		assert(data != nullptr);
+
+		auto &texels = _depth_texture.levels[0].texels;
+
+		for (size_t i = 0, k = 0; i < texels.size(); i += 4, k++)
+		{
+			texels[i] = data[k];
+		}
+	}
+
+	void software_runtime::capture_frame(uint8_t *buffer) const
+	{
+		const auto &texels = _backbuffer.levels[0].texels;
+
+		for (size_t i = 0; i < texels.size(); i += 4)
+		{
+			for (size_t c = 0; c < 3; c++)
+			{
+				buffer[i + c] = static_cast<uint8_t>(std::nearbyint(std::min(std::max(texels[i + c], 0.0f), 1.0f) * 255.0f));
+			}
+
+			buffer[i + 3] = 0xFF;
+		}
+	}
+	bool software_runtime::load_effect(const reshadefx::syntax_tree &ast, std::string &errors)
+	{
+		return software_effect_compiler(this, ast, errors).run();
+	}
+	upload_layout software_runtime::get_upload_layout(const texture &texture) const
+	{
+		upload_layout layout;
+		layout.levels = texture.levels;
+
+		return layout;
+	}
+	bool software_runtime::update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels)
+	{
+		if (texture.impl_reference != texture_reference::none)
+		{
+			return false;
+		}
+
+		const auto texture_impl = texture.impl->as<software_tex_data>();
+
+		assert(data != nullptr);
+		assert(texture_impl != nullptr);
+
+		// The texture loader already generated all mipmap levels, so they are copied instead of downsampled again
+		for (unsigned int level = 0; level < std::min(static_cast<unsigned int>(levels.size()), static_cast<unsigned int>(texture_impl->levels.size())); level++)
+		{
+			update_texture_level(*texture_impl, level, data + levels[level].offset);
+		}
+
+		return true;
+	}
+
+	void software_runtime::render_technique(technique &technique)
+	{
+		bool is_stencil_cleared = false;
+
+		for (const auto &pass_object : technique.passes)
+		{
+			const software_pass_data &pass = *pass_object->as<software_pass_data>();
+
+			// Passes always render to the back buffer, so the planner only asks for a copy into the texture when the pass samples it
+			const auto step = _back_buffer_planner.plan_pass(pass.back_buffer_usage);
+
+			software_tex_data *const surfaces[2] = { &_backbuffer, &_backbuffer_texture };
+
+			if (step.copy_source >= 0)
+			{
+				surfaces[step.copy_destination]->levels[0].texels = surfaces[step.copy_source]->levels[0].texels;
+			}
+
+			// The stencil buffer is only bound to passes that render at the size of the frame, like the default depth-stencil buffer of the other renderers
+			const bool use_stencil = pass.viewport_width == _width && pass.viewport_height == _height;
+
+			if (use_stencil && !is_stencil_cleared)
+			{
+				is_stencil_cleared = true;
+
+				std::fill(_stencil_buffer.begin(), _stencil_buffer.end(), 0);
+			}
+
+			if (pass.clear_render_targets)
+			{
+				for (const auto target : pass.render_targets)
+				{
+					if (target != nullptr)
+					{
+						clear_texture(*target);
+					}
+				}
+			}
+
+			render_pass(pass, use_stencil);
+
+			_vertices += 3;
+			_drawcalls += 1;
+
+			// Update shader resources
+			for (const auto target : pass.render_targets)
+			{
+				if (target != nullptr && target->levels.size() > 1)
+				{
+					generate_mipmaps(*target);
+				}
+			}
+		}
+	}
+	void software_runtime::render_pass(const software_pass_data &pass, bool use_stencil)
+	{
+		if (pass.vertex_shader.function == nullptr || pass.pixel_shader.function == nullptr)
+		{
+			return;
+		}
+
+		const uint8_t *const uniform_data = get_uniform_value_storage().data();
+
+		// Run the vertex shader for all three vertices at once, one per lane
+		shader_context vertex_context;
+		vertex_context.reset(*pass.program, pass.samplers.data(), pass.samplers.size(), uniform_data);
+
+		for (const auto &input : pass.vertex_shader.inputs)
+		{
+			for (unsigned int c = 0; c < input.components; c++)
+			{
+				auto &value = vertex_context.variables[input.slot + c];
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					if (input.semantic == "SV_VERTEXID" && c == 0)
+					{
+						if (input.type == scalar_type::floating_point)
+							value.f[l] = static_cast<float>(l);
+						else
+							value.u[l] = l;
+					}
+					else
+					{
+						value.u[l] = 0;
+					}
+				}
+			}
+		}
+		for (const auto &output : pass.vertex_shader.outputs)
+		{
+			for (unsigned int c = 0; c < output.components; c++)
+			{
+				vertex_context.variables[output.slot + c] = { };
+			}
+		}
+
+		vertex_context.execute_entry_point(*pass.vertex_shader.function, 0x7);
+
+		const auto position = std::find_if(pass.vertex_shader.outputs.begin(), pass.vertex_shader.outputs.end(),
+			[](const shader_signature_element &element) { return element.semantic == "SV_POSITION" && element.components == 4 && element.type == scalar_type::floating_point; });
+
+		if (position == pass.vertex_shader.outputs.end())
+		{
+			return;
+		}
+
+		// Map the vertices to the viewport
+		float screen[3][2], depth[3], inverse_w[3];
+
+		for (unsigned int v = 0; v < 3; v++)
+		{
+			const float x = vertex_context.variables[position->slot + 0].f[v];
+			const float y = vertex_context.variables[position->slot + 1].f[v];
+			const float z = vertex_context.variables[position->slot + 2].f[v];
+			const float w = vertex_context.variables[position->slot + 3].f[v];
+
+			// Triangles are not clipped, so skip those that reach behind the camera
+			if (!(w > 0.0f))
+			{
+				return;
+			}
+
+			inverse_w[v] = 1.0f / w;
+			screen[v][0] = (x * inverse_w[v] * 0.5f + 0.5f) * pass.viewport_width;
+			screen[v][1] = (0.5f - y * inverse_w[v] * 0.5f) * pass.viewport_height;
+			depth[v] = z * inverse_w[v];
+		}
+
+		unsigned int order[3] = { 0, 1, 2 };
+
+		// Both windings are rasterized, since there is no culling
+		if (edge_function(screen[0], screen[1], screen[2][0], screen[2][1]) < 0.0f)
+		{
+			std::swap(order[1], order[2]);
+		}
+
+		const float *const v0 = screen[order[0]], *const v1 = screen[order[1]], *const v2 = screen[order[2]];
+		const float area = edge_function(v0, v1, v2[0], v2[1]);
+
+		if (!(area > 0.0f))
+		{
+			return;
+		}
+
+		const bool top_left[3] = { is_top_left_edge(v1, v2), is_top_left_edge(v2, v0), is_top_left_edge(v0, v1) };
+
+		// Collect the vertex shader outputs the pixel shader reads
+		std::vector<interpolant> interpolants;
+		interpolants.reserve(pass.pixel_shader.inputs.size());
+
+		for (const auto &input : pass.pixel_shader.inputs)
+		{
+			if (input.semantic == "SV_POSITION")
+			{
+				continue;
+			}
+
+			const auto output = std::find_if(pass.vertex_shader.outputs.begin(), pass.vertex_shader.outputs.end(),
+				[&input](const shader_signature_element &element) { return element.semantic == input.semantic; });
+
+			interpolant value;
+			value.slot = input.slot;
+			value.components = input.components;
+			value.mode = interpolant::perspective;
+
+			if (input.type != scalar_type::floating_point || (input.qualifiers & reshadefx::nodes::type_node::qualifier_nointerpolation) != 0)
+			{
+				value.mode = interpolant::flat;
+			}
+			else if ((input.qualifiers & reshadefx::nodes::type_node::qualifier_noperspective) != 0)
+			{
+				value.mode = interpolant::linear;
+			}
+
+			for (unsigned int v = 0; v < 3; v++)
+			{
+				value.values[v].assign(input.components, 0);
+
+				for (unsigned int c = 0; output != pass.vertex_shader.outputs.end() && c < std::min(input.components, output->components); c++)
+				{
+					value.values[v][c] = vertex_context.variables[output->slot + c].u[order[v]];
+				}
+			}
+
+			interpolants.push_back(std::move(value));
+		}
+
+		const auto ps_position = std::find_if(pass.pixel_shader.inputs.begin(), pass.pixel_shader.inputs.end(),
+			[](const shader_signature_element &element) { return element.semantic == "SV_POSITION"; });
+
+		const float ordered_depth[3] = { depth[order[0]], depth[order[1]], depth[order[2]] };
+		const float ordered_inverse_w[3] = { inverse_w[order[0]], inverse_w[order[1]], inverse_w[order[2]] };
+
+		// Rasterize only the bounding box of the triangle, in tiles that are distributed across worker threads
+		const unsigned int min_x = static_cast<unsigned int>(std::max(0.0f, std::floor(std::min({ v0[0], v1[0], v2[0] }))));
+		const unsigned int min_y = static_cast<unsigned int>(std::max(0.0f, std::floor(std::min({ v0[1], v1[1], v2[1] }))));
+		const unsigned int max_x = static_cast<unsigned int>(std::min(static_cast<float>(pass.viewport_width), std::ceil(std::max({ v0[0], v1[0], v2[0] }))));
+		const unsigned int max_y = static_cast<unsigned int>(std::min(static_cast<float>(pass.viewport_height), std::ceil(std::max({ v0[1], v1[1], v2[1] }))));
+
+		if (min_x >= max_x || min_y >= max_y)
+		{
+			return;
+		}
+
+		const unsigned int tiles_x = (max_x - min_x + tile_size - 1) / tile_size;
+		const unsigned int tiles_y = (max_y - min_y + tile_size - 1) / tile_size;
+
+		std::atomic<unsigned int> next_tile(0);
+
+		const auto render_tiles = [&]() {
+			shader_context context;
+			context.reset(*pass.program, pass.samplers.data(), pass.samplers.size(), uniform_data);
+
+			for (unsigned int tile = next_tile++; tile < tiles_x * tiles_y; tile = next_tile++)
+			{
+				const unsigned int tile_x = min_x + (tile % tiles_x) * tile_size;
+				const unsigned int tile_y = min_y + (tile / tiles_x) * tile_size;
+
+				// Pixels are shaded in blocks of 4x2, with the x coordinate in the lower two bits of the lane index and the y coordinate in the third
+				for (unsigned int block_y = tile_y; block_y < std::min(tile_y + tile_size, max_y); block_y += 2)
+				{
+					for (unsigned int block_x = tile_x; block_x < std::min(tile_x + tile_size, max_x); block_x += 4)
+					{
+						lane_mask coverage = 0;
+						float weights[lane_count][3], linear_weights[lane_count][3], z[lane_count], w[lane_count];
+
+						for (unsigned int l = 0; l < lane_count; l++)
+						{
+							const unsigned int x = block_x + (l & 3), y = block_y + (l >> 2);
+							const float px = x + 0.5f, py = y + 0.5f;
+
+							const float e[3] = { edge_function(v1, v2, px, py), edge_function(v2, v0, px, py), edge_function(v0, v1, px, py) };
+
+							if (x < max_x && y < max_y &&
+								(e[0] > 0.0f || (e[0] == 0.0f && top_left[0])) &&
+								(e[1] > 0.0f || (e[1] == 0.0f && top_left[1])) &&
+								(e[2] > 0.0f || (e[2] == 0.0f && top_left[2])))
+							{
+								coverage |= 1u << l;
+							}
+
+							// Helper lanes outside the triangle are still interpolated, so that derivatives work at its edges
+							float perspective_sum = 0.0f;
+
+							for (unsigned int v = 0; v < 3; v++)
+							{
+								linear_weights[l][v] = e[v] / area;
+								weights[l][v] = linear_weights[l][v] * ordered_inverse_w[v];
+								perspective_sum += weights[l][v];
+							}
+							for (unsigned int v = 0; v < 3; v++)
+							{
+								weights[l][v] /= perspective_sum;
+							}
+
+							z[l] = linear_weights[l][0] * ordered_depth[0] + linear_weights[l][1] * ordered_depth[1] + linear_weights[l][2] * ordered_depth[2];
+							w[l] = 1.0f / perspective_sum;
+						}
+
+						if (coverage == 0)
+						{
+							continue;
+						}
+
+						// Write pixel shader inputs
+						if (ps_position != pass.pixel_shader.inputs.end())
+						{
+							for (unsigned int l = 0; l < lane_count; l++)
+							{
+								context.variables[ps_position->slot + 0].f[l] = block_x + (l & 3) + 0.5f;
+								context.variables[ps_position->slot + 1].f[l] = block_y + (l >> 2) + 0.5f;
+								context.variables[ps_position->slot + 2].f[l] = z[l];
+								context.variables[ps_position->slot + 3].f[l] = w[l];
+							}
+						}
+
+						for (const auto &value : interpolants)
+						{
+							for (unsigned int c = 0; c < value.components; c++)
+							{
+								auto &target = context.variables[value.slot + c];
+
+								if (value.mode == interpolant::flat)
+								{
+									for (unsigned int l = 0; l < lane_count; l++)
+										target.u[l] = value.values[0][c];
+									continue;
+								}
+
+								float a, b, d;
+								std::memcpy(&a, &value.values[0][c], sizeof(float));
+								std::memcpy(&b, &value.values[1][c], sizeof(float));
+								std::memcpy(&d, &value.values[2][c], sizeof(float));
+
+								const auto &blend = value.mode == interpolant::perspective ? weights : linear_weights;
+
+								for (unsigned int l = 0; l < lane_count; l++)
+								{
+									target.f[l] = blend[l][0] * a + blend[l][1] * b + blend[l][2] * d;
+								}
+							}
+						}
+
+						for (const auto &output : pass.pixel_shader.outputs)
+						{
+							for (unsigned int c = 0; c < output.components; c++)
+							{
+								context.variables[output.slot + c] = { };
+							}
+						}
+
+						context.execute_entry_point(*pass.pixel_shader.function, all_lanes);
+
+						lane_mask write_mask = coverage & ~context.discard_mask;
+
+						// Stencil test
+						if (use_stencil && pass.stencil_enable)
+						{
+							for (unsigned int l = 0; l < lane_count; l++)
+							{
+								if ((write_mask & (1u << l)) == 0)
+								{
+									continue;
+								}
+
+								uint8_t &stencil = _stencil_buffer[(block_y + (l >> 2)) * _width + block_x + (l & 3)];
+
+								const bool passed = stencil_test(pass.stencil_comparison_func, pass.stencil_reference_value & pass.stencil_read_mask, stencil & pass.stencil_read_mask);
+								const uint8_t value = stencil_operation(passed ? pass.stencil_op_pass : pass.stencil_op_fail, static_cast<uint8_t>(pass.stencil_reference_value), stencil);
+
+								stencil = static_cast<uint8_t>((stencil & ~pass.stencil_write_mask) | (value & pass.stencil_write_mask));
+
+								if (!passed)
+								{
+									write_mask &= ~(1u << l);
+								}
+							}
+						}
+
+						// Output merger
+						for (const auto &output : pass.pixel_shader.outputs)
+						{
+							if (output.semantic.compare(0, 9, "SV_TARGET") != 0)
+							{
+								continue;
+							}
+
+							const unsigned int index = static_cast<unsigned int>(std::strtoul(output.semantic.c_str() + 9, nullptr, 10));
+
+							if (index >= 8 || pass.render_targets[index] == nullptr)
+							{
+								continue;
+							}
+
+							software_tex_data &target = *pass.render_targets[index];
+							const bool is_float = is_float_format(target.format);
+							const bool srgb = pass.srgb_write_enable && is_srgb_capable(target.format);
+
+							for (unsigned int l = 0; l < lane_count; l++)
+							{
+								if ((write_mask & (1u << l)) == 0)
+								{
+									continue;
+								}
+
+								float src[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, dst[4], result[4];
+
+								for (unsigned int c = 0; c < std::min(output.components, 4u); c++)
+								{
+									const auto &value = context.variables[output.slot + c];
+
+									switch (output.type)
+									{
+										case scalar_type::floating_point:
+											src[c] = value.f[l];
+											break;
+										case scalar_type::signed_integer:
+											src[c] = static_cast<float>(value.i[l]);
+											break;
+										default:
+											src[c] = static_cast<float>(value.u[l]);
+											break;
+									}
+
+									if (!is_float)
+									{
+										src[c] = std::min(std::max(src[c], 0.0f), 1.0f);
+									}
+								}
+
+								float *const texel = &target.levels[0].texels[((block_y + (l >> 2)) * target.levels[0].width + block_x + (l & 3)) * 4];
+
+								for (unsigned int c = 0; c < 4; c++)
+								{
+									dst[c] = srgb && c < 3 ? srgb_to_linear(texel[c]) : texel[c];
+								}
+
+								for (unsigned int c = 0; c < 4; c++)
+								{
+									if (pass.blend_enable)
+									{
+										const bool alpha = c == 3;
+
+										result[c] = blend_operation(alpha ? pass.blend_op_alpha : pass.blend_op,
+											src[c] * blend_factor(alpha ? pass.src_blend_alpha : pass.src_blend, c, src, dst),
+											dst[c] * blend_factor(alpha ? pass.dest_blend_alpha : pass.dest_blend, c, src, dst));
+									}
+									else
+									{
+										result[c] = src[c];
+									}
+
+									if (srgb && c < 3)
+									{
+										result[c] = linear_to_srgb(std::min(std::max(result[c], 0.0f), 1.0f));
+									}
+								}
+
+								quantize_texel(target.format, result);
+
+								for (unsigned int c = 0; c < 4; c++)
+								{
+									if ((pass.color_write_mask & (1u << c)) != 0)
+									{
+										texel[c] = result[c];
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		};
+
+		// Tiles never overlap, so the workers only share the stencil buffer and render targets at disjoint pixels
+		const unsigned int worker_count = std::max(1u, std::min(std::thread::hardware_concurrency(), tiles_x * tiles_y));
+
+		std::vector<std::future<void>> workers;
+
+		for (unsigned int i = 1; i < worker_count; i++)
+		{
+			workers.push_back(std::async(std::launch::async, render_tiles));
+		}
+
+		render_tiles();
+
+		for (auto &worker : workers)
+		{
+			worker.get();
+		}
+	}
+#if RESHADE_GUI
+	void software_runtime::render_imgui_draw_data(ImDrawData */*data*/)
+	{
+		// The overlay is not drawn, since the software runtime only produces the effect output
+	}
+#endif
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "runtime.hpp"
+#include "render_graph.hpp"
+#include "software_shader.hpp"
+
+namespace reshade::software
+{
+	struct software_pass_data : base_object
+	{
+		std::shared_ptr<const shader_program> program;
+		shader_entry_point vertex_shader, pixel_shader;
+		software_tex_data *render_targets[8] = { };
+		unsigned int viewport_width = 0, viewport_height = 0;
+		std::vector<software_sampler> samplers;
+		bool clear_render_targets = true, srgb_write_enable = false, blend_enable = false, stencil_enable = false;
+		unsigned char color_write_mask = 0xF, stencil_read_mask = 0xFF, stencil_write_mask = 0xFF;
+		unsigned int blend_op = 1, blend_op_alpha = 1, src_blend = 1, dest_blend = 0, src_blend_alpha = 1, dest_blend_alpha = 0;
+		unsigned int stencil_comparison_func = 8, stencil_reference_value = 0, stencil_op_pass = 1, stencil_op_fail = 1;
+		back_buffer_access back_buffer_usage;
+	};
+
+	/// <summary>
+	/// A runtime which executes effects on the CPU instead of a graphics device. It produces reference images for the other renderers to be compared against and runs where no graphics device is available.
+	/// </summary>
+	class software_runtime : public runtime
+	{
+	public:
+		software_runtime();
+
+		bool on_init(unsigned int width, unsigned int height);
+		void on_reset();
+		void on_present();
+
+		/// <summary>
+		/// Replace the contents of the back buffer before effects are applied.
+		/// </summary>
+		/// <param name="data">The 32bpp RGBA image data, which has to be the size of the frame.</param>
+		void update_back_buffer(const uint8_t *data);
+		/// <summary>
+		/// Replace the contents of the depth buffer before effects are applied.
+		/// </summary>
+		/// <param name="data">The depth values, one per pixel.</param>
+		void update_depth_buffer(const float *data);
+
+		void capture_frame(uint8_t *buffer) const override;
+		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
+		upload_layout get_upload_layout(const texture &texture) const override;
+		bool update_texture(texture &texture, const uint8_t *data, const std::vector<upload_level> &levels) override;
+
+		void render_technique(technique &technique) override;
+#if RESHADE_GUI
+		void render_imgui_draw_data(ImDrawData *data) override;
+#endif
+
+		/// <summary>
+		/// The back buffer effects render to, and the copy of it they sample from.
+		/// </summary>
+		software_tex_data _backbuffer, _backbuffer_texture;
+		software_tex_data _depth_texture;
+		back_buffer_planner _back_buffer_planner { 1, false };
+
+	private:
+		void render_pass(const software_pass_data &pass, bool use_stencil);
+
+		std::vector<uint8_t> _stencil_buffer;
+	};
+}
@@ -0,0 +1,1382 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "software_shader.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::software
+{
+	static inline lane_mask to_mask(const lane_value &value)
+	{
+		lane_mask mask = 0;
+
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			mask |= (value.u[l] != 0 ? 1u : 0u) << l;
+		}
+
+		return mask;
+	}
+	static inline void copy_masked(lane_value &target, const lane_value &source, lane_mask mask)
+	{
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			target.u[l] = (mask >> l) & 1 ? source.u[l] : target.u[l];
+		}
+	}
+	static inline int32_t float_to_int(float value)
+	{
+		if (!(value > -2147483648.0f))
+			return value != value ? 0 : INT32_MIN;
+		if (value >= 2147483648.0f)
+			return INT32_MAX;
+		return static_cast<int32_t>(value);
+	}
+	static inline uint32_t float_to_uint(float value)
+	{
+		if (!(value > 0.0f))
+			return 0;
+		if (value >= 4294967296.0f)
+			return UINT32_MAX;
+		return static_cast<uint32_t>(value);
+	}
+
+	template <typename R, typename T, typename F>
+	static inline void for_each_lane(R *result, const T *operand, F function)
+	{
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			result[l] = function(operand[l]);
+		}
+	}
+	template <typename R, typename T, typename F>
+	static inline void for_each_lane(R *result, const T *operand1, const T *operand2, F function)
+	{
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			result[l] = function(operand1[l], operand2[l]);
+		}
+	}
+	template <typename F>
+	static inline void for_each_component(lane_value *result, const lane_value *operand, unsigned int components, F function)
+	{
+		for (unsigned int c = 0; c < components; c++)
+		{
+			for_each_lane(result[c].f, operand[c].f, function);
+		}
+	}
+	template <typename F>
+	static inline void for_each_component(lane_value *result, const lane_value *operand1, const lane_value *operand2, unsigned int components, F function)
+	{
+		for (unsigned int c = 0; c < components; c++)
+		{
+			for_each_lane(result[c].f, operand1[c].f, operand2[c].f, function);
+		}
+	}
+	template <typename F>
+	static inline void for_each_component(lane_value *result, const lane_value *operand1, const lane_value *operand2, const lane_value *operand3, unsigned int components, F function)
+	{
+		for (unsigned int c = 0; c < components; c++)
+		{
+			for (unsigned int l = 0; l < lane_count; l++)
+			{
+				result[c].f[l] = function(operand1[c].f[l], operand2[c].f[l], operand3[c].f[l]);
+			}
+		}
+	}
+
+	static void resolve_indices(shader_context &context, const shader_lvalue &lvalue, lane_mask mask, uint32_t bases[lane_count])
+	{
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			bases[l] = lvalue.base;
+		}
+
+		for (const auto &index : lvalue.indices)
+		{
+			index.index->evaluate(context, mask);
+
+			const lane_value &value = context.temporaries[index.index->result];
+
+			for (unsigned int l = 0; l < lane_count; l++)
+			{
+				// Indices outside the bounds are clamped, so that they cannot access storage of other variables
+				bases[l] += static_cast<uint32_t>(std::min(std::max(value.i[l], 0), static_cast<int32_t>(index.count) - 1)) * index.stride;
+			}
+		}
+	}
+	static uint32_t read_uniform(const shader_context &context, scalar_type type, uint32_t offset)
+	{
+		uint32_t value;
+		std::memcpy(&value, context.uniform_data() + offset * 4, sizeof(value));
+
+		// Booleans are stored as all bits set in the uniform data
+		if (type == scalar_type::boolean)
+		{
+			value = value != 0 ? 1 : 0;
+		}
+
+		return value;
+	}
+
+	#pragma region Texture Sampling
+	static const float *srgb_table()
+	{
+		static const struct table
+		{
+			table()
+			{
+				for (unsigned int i = 0; i < 256; i++)
+				{
+					values[i] = srgb_to_linear(i / 255.0f);
+				}
+			}
+
+			float values[256];
+		} s_table;
+
+		return s_table.values;
+	}
+	static inline int address_coordinate(int coordinate, int size, texture_address_mode mode)
+	{
+		switch (mode)
+		{
+			case texture_address_mode::wrap:
+				coordinate %= size;
+				return coordinate < 0 ? coordinate + size : coordinate;
+			case texture_address_mode::mirror:
+				coordinate %= 2 * size;
+				coordinate = coordinate < 0 ? coordinate + 2 * size : coordinate;
+				return coordinate >= size ? 2 * size - 1 - coordinate : coordinate;
+			case texture_address_mode::border:
+				return coordinate < 0 || coordinate >= size ? -1 : coordinate;
+			default:
+				return std::min(std::max(coordinate, 0), size - 1);
+		}
+	}
+	static inline int float_to_coordinate(float value)
+	{
+		// Keep the coordinate in a range where the addressing arithmetic cannot overflow
+		return static_cast<int>(std::min(std::max(value, -16777216.0f), 16777216.0f));
+	}
+	static void read_texel(const software_sampler &sampler, const software_mip_level &mip, int x, int y, float texel[4])
+	{
+		x = address_coordinate(x, static_cast<int>(mip.width), sampler.address_u);
+		y = address_coordinate(y, static_cast<int>(mip.height), sampler.address_v);
+
+		if (x < 0 || y < 0)
+		{
+			texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+			return;
+		}
+
+		std::memcpy(texel, &mip.texels[(static_cast<size_t>(y) * mip.width + x) * 4], 4 * sizeof(float));
+
+		if (sampler.srgb)
+		{
+			const float *const table = srgb_table();
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				texel[c] = table[static_cast<unsigned int>(texel[c] * 255.0f + 0.5f) & 0xFF];
+			}
+		}
+	}
+	static void sample_level(const software_sampler &sampler, size_t level, float u, float v, bool linear, int offset_x, int offset_y, float texel[4])
+	{
+		const auto &mip = sampler.texture->levels[level];
+
+		if (!linear)
+		{
+			read_texel(sampler, mip, float_to_coordinate(std::floor(u * mip.width)) + offset_x, float_to_coordinate(std::floor(v * mip.height)) + offset_y, texel);
+			return;
+		}
+
+		const float x = u * mip.width - 0.5f, y = v * mip.height - 0.5f;
+		const float x0 = std::floor(x), y0 = std::floor(y);
+		const float fx = x - x0, fy = y - y0;
+		const int ix = float_to_coordinate(x0) + offset_x, iy = float_to_coordinate(y0) + offset_y;
+
+		float t00[4], t10[4], t01[4], t11[4];
+		read_texel(sampler, mip, ix, iy, t00);
+		read_texel(sampler, mip, ix + 1, iy, t10);
+		read_texel(sampler, mip, ix, iy + 1, t01);
+		read_texel(sampler, mip, ix + 1, iy + 1, t11);
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			const float top = t00[c] + (t10[c] - t00[c]) * fx;
+			const float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+
+			texel[c] = top + (bottom - top) * fy;
+		}
+	}
+	static void sample(const software_sampler *sampler, float u, float v, float lod, int offset_x, int offset_y, float texel[4])
+	{
+		if (sampler == nullptr || sampler->texture == nullptr || sampler->texture->levels.empty())
+		{
+			texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+			return;
+		}
+
+		if (!std::isfinite(u)) u = 0.0f;
+		if (!std::isfinite(v)) v = 0.0f;
+
+		lod = lod + sampler->lod_bias;
+		lod = lod != lod ? 0.0f : std::min(std::max(lod, sampler->min_lod), sampler->max_lod);
+
+		const unsigned int filter = static_cast<unsigned int>(sampler->filter);
+		const bool linear = (filter & (lod <= 0.0f ? 0x4 : 0x10)) != 0;
+		const size_t last_level = sampler->texture->levels.size() - 1;
+
+		if (lod <= 0.0f || last_level == 0)
+		{
+			sample_level(*sampler, 0, u, v, linear, offset_x, offset_y, texel);
+		}
+		else if ((filter & 0x1) != 0)
+		{
+			const float level = std::min(lod, static_cast<float>(last_level));
+			const size_t level0 = static_cast<size_t>(level), level1 = std::min(level0 + 1, last_level);
+			const float weight = level - static_cast<float>(level0);
+
+			float texel1[4];
+			sample_level(*sampler, level0, u, v, linear, offset_x, offset_y, texel);
+			sample_level(*sampler, level1, u, v, linear, offset_x, offset_y, texel1);
+
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				texel[c] += (texel1[c] - texel[c]) * weight;
+			}
+		}
+		else
+		{
+			sample_level(*sampler, std::min(static_cast<size_t>(lod + 0.5f), last_level), u, v, linear, offset_x, offset_y, texel);
+		}
+	}
+	static void compute_lod(const software_sampler *sampler, const float ddx_u[lane_count], const float ddx_v[lane_count], const float ddy_u[lane_count], const float ddy_v[lane_count], float lod[lane_count])
+	{
+		const float width = sampler != nullptr && sampler->texture != nullptr && !sampler->texture->levels.empty() ? static_cast<float>(sampler->texture->levels[0].width) : 1.0f;
+		const float height = sampler != nullptr && sampler->texture != nullptr && !sampler->texture->levels.empty() ? static_cast<float>(sampler->texture->levels[0].height) : 1.0f;
+
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			const float dx_u = ddx_u[l] * width, dx_v = ddx_v[l] * height;
+			const float dy_u = ddy_u[l] * width, dy_v = ddy_v[l] * height;
+
+			lod[l] = 0.5f * std::log2(std::max(dx_u * dx_u + dx_v * dx_v, dy_u * dy_u + dy_v * dy_v));
+		}
+	}
+	static void compute_implicit_lod(const software_sampler *sampler, const lane_value &u, const lane_value &v, float lod[lane_count])
+	{
+		float ddx_u[lane_count], ddx_v[lane_count], ddy_u[lane_count], ddy_v[lane_count];
+
+		// Lanes form two 2x2 quads, the x coordinate is in the lower two bits of the lane index and the y coordinate in the third
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			ddx_u[l] = u.f[l | 1] - u.f[l & ~1u];
+			ddx_v[l] = v.f[l | 1] - v.f[l & ~1u];
+			ddy_u[l] = u.f[l | 4] - u.f[l & ~4u];
+			ddy_v[l] = v.f[l | 4] - v.f[l & ~4u];
+		}
+
+		compute_lod(sampler, ddx_u, ddx_v, ddy_u, ddy_v, lod);
+	}
+	#pragma endregion
+
+	static float determinant(const float *matrix, unsigned int size)
+	{
+		if (size == 1)
+		{
+			return matrix[0];
+		}
+
+		float result = 0.0f, minor[9];
+
+		for (unsigned int column = 0; column < size; column++)
+		{
+			for (unsigned int i = 1, k = 0; i < size; i++)
+			{
+				for (unsigned int j = 0; j < size; j++)
+				{
+					if (j != column)
+					{
+						minor[k++] = matrix[i * size + j];
+					}
+				}
+			}
+
+			const float cofactor = matrix[column] * determinant(minor, size - 1);
+
+			result += column % 2 == 0 ? cofactor : -cofactor;
+		}
+
+		return result;
+	}
+
+	void shader_context::reset(const shader_program &program, const software_sampler *samplers, size_t sampler_count, const uint8_t *uniform_data)
+	{
+		_program = &program;
+		_samplers = samplers;
+		_sampler_count = sampler_count;
+		_uniform_data = uniform_data;
+
+		if (variables.size() < program.variable_count)
+		{
+			variables.resize(program.variable_count);
+		}
+		if (temporaries.size() < program.temporary_count)
+		{
+			temporaries.resize(program.temporary_count);
+		}
+	}
+	void shader_context::execute_entry_point(const shader_function &function, lane_mask mask)
+	{
+		break_mask = continue_mask = discard_mask = 0;
+
+		if (_program->global_initializers != nullptr)
+		{
+			lane_mask initializer_mask = all_lanes;
+
+			_program->global_initializers->execute(*this, initializer_mask);
+		}
+
+		call(function, mask);
+	}
+	void shader_context::call(const shader_function &function, lane_mask mask)
+	{
+		if (function.body != nullptr)
+		{
+			function.body->execute(*this, mask);
+		}
+	}
+
+	#pragma region Expressions
+	void constant_expression::evaluate(shader_context &context, lane_mask) const
+	{
+		for (unsigned int c = 0; c < components; c++)
+		{
+			std::fill_n(context.temporaries[result + c].u, lane_count, values[c]);
+		}
+	}
+	void load_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		lane_value *const target = &context.temporaries[result];
+
+		if (source.indices.empty())
+		{
+			for (unsigned int c = 0; c < components; c++)
+			{
+				if (source.uniform)
+				{
+					std::fill_n(target[c].u, lane_count, read_uniform(context, source.type, source.base + source.components[c]));
+				}
+				else
+				{
+					target[c] = context.variables[source.base + source.components[c]];
+				}
+			}
+			return;
+		}
+
+		uint32_t bases[lane_count];
+		resolve_indices(context, source, mask, bases);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			for (unsigned int l = 0; l < lane_count; l++)
+			{
+				target[c].u[l] = source.uniform ? read_uniform(context, source.type, bases[l] + source.components[c]) : context.variables[bases[l] + source.components[c]].u[l];
+			}
+		}
+	}
+	void store_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		value->evaluate(context, mask);
+
+		const lane_value *const source = &context.temporaries[value->result];
+
+		if (target.indices.empty())
+		{
+			for (unsigned int c = 0; c < components; c++)
+			{
+				copy_masked(context.variables[target.base + target.components[c]], source[c], mask);
+			}
+			return;
+		}
+
+		uint32_t bases[lane_count];
+		resolve_indices(context, target, mask, bases);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			for (unsigned int l = 0; l < lane_count; l++)
+			{
+				if ((mask >> l) & 1)
+				{
+					context.variables[bases[l] + target.components[c]].u[l] = source[c].u[l];
+				}
+			}
+		}
+	}
+	void previous_value_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		load->evaluate(context, mask);
+		modify->evaluate(context, mask);
+	}
+	void convert_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		operand->evaluate(context, mask);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			const lane_value &value = context.temporaries[operand->result + swizzle[c]];
+			lane_value &target = context.temporaries[result + c];
+
+			if (from == to || (from == scalar_type::boolean && to != scalar_type::floating_point) || (from != scalar_type::floating_point && to != scalar_type::floating_point && to != scalar_type::boolean))
+			{
+				target = value;
+				continue;
+			}
+
+			switch (to)
+			{
+				case scalar_type::boolean:
+					if (from == scalar_type::floating_point)
+						for_each_lane(target.u, value.f, [](float x) { return x != 0.0f ? 1u : 0u; });
+					else
+						for_each_lane(target.u, value.u, [](uint32_t x) { return x != 0 ? 1u : 0u; });
+					break;
+				case scalar_type::signed_integer:
+					for_each_lane(target.i, value.f, float_to_int);
+					break;
+				case scalar_type::unsigned_integer:
+					for_each_lane(target.u, value.f, float_to_uint);
+					break;
+				case scalar_type::floating_point:
+					if (from == scalar_type::signed_integer)
+						for_each_lane(target.f, value.i, [](int32_t x) { return static_cast<float>(x); });
+					else
+						for_each_lane(target.f, value.u, [](uint32_t x) { return static_cast<float>(x); });
+					break;
+			}
+		}
+	}
+	void unary_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		operand->evaluate(context, mask);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			const lane_value &value = context.temporaries[operand->result + c];
+			lane_value &target = context.temporaries[result + c];
+
+			switch (op)
+			{
+				case negate:
+					if (type == scalar_type::floating_point)
+						for_each_lane(target.f, value.f, [](float x) { return -x; });
+					else
+						for_each_lane(target.u, value.u, [](uint32_t x) { return 0u - x; });
+					break;
+				case bitwise_not:
+					for_each_lane(target.u, value.u, [](uint32_t x) { return ~x; });
+					break;
+				case logical_not:
+					for_each_lane(target.u, value.u, [](uint32_t x) { return x == 0 ? 1u : 0u; });
+					break;
+			}
+		}
+	}
+	void binary_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		operands[0]->evaluate(context, mask);
+		operands[1]->evaluate(context, mask);
+
+		const bool is_float = type == scalar_type::floating_point;
+		const bool is_signed = type == scalar_type::signed_integer;
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			const lane_value &a = context.temporaries[operands[0]->result + c];
+			const lane_value &b = context.temporaries[operands[1]->result + c];
+			lane_value &target = context.temporaries[result + c];
+
+			switch (op)
+			{
+				case add:
+					if (is_float)
+						for_each_lane(target.f, a.f, b.f, [](float x, float y) { return x + y; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x + y; });
+					break;
+				case subtract:
+					if (is_float)
+						for_each_lane(target.f, a.f, b.f, [](float x, float y) { return x - y; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x - y; });
+					break;
+				case multiply:
+					if (is_float)
+						for_each_lane(target.f, a.f, b.f, [](float x, float y) { return x * y; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x * y; });
+					break;
+				case divide:
+					// Integer division by zero returns all bits set like on the GPU instead of trapping
+					if (is_float)
+						for_each_lane(target.f, a.f, b.f, [](float x, float y) { return x / y; });
+					else if (is_signed)
+						for_each_lane(target.i, a.i, b.i, [](int32_t x, int32_t y) { return y == 0 ? -1 : y == -1 ? static_cast<int32_t>(0u - static_cast<uint32_t>(x)) : x / y; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return y == 0 ? UINT32_MAX : x / y; });
+					break;
+				case modulo:
+					if (is_float)
+						for_each_lane(target.f, a.f, b.f, [](float x, float y) { return std::fmod(x, y); });
+					else if (is_signed)
+						for_each_lane(target.i, a.i, b.i, [](int32_t x, int32_t y) { return y == 0 ? -1 : y == -1 ? 0 : x % y; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return y == 0 ? UINT32_MAX : x % y; });
+					break;
+				case less:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x < y ? 1u : 0u; });
+					else if (is_signed)
+						for_each_lane(target.u, a.i, b.i, [](int32_t x, int32_t y) { return x < y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x < y ? 1u : 0u; });
+					break;
+				case greater:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x > y ? 1u : 0u; });
+					else if (is_signed)
+						for_each_lane(target.u, a.i, b.i, [](int32_t x, int32_t y) { return x > y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x > y ? 1u : 0u; });
+					break;
+				case less_equal:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x <= y ? 1u : 0u; });
+					else if (is_signed)
+						for_each_lane(target.u, a.i, b.i, [](int32_t x, int32_t y) { return x <= y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x <= y ? 1u : 0u; });
+					break;
+				case greater_equal:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x >= y ? 1u : 0u; });
+					else if (is_signed)
+						for_each_lane(target.u, a.i, b.i, [](int32_t x, int32_t y) { return x >= y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x >= y ? 1u : 0u; });
+					break;
+				case equal:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x == y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x == y ? 1u : 0u; });
+					break;
+				case not_equal:
+					if (is_float)
+						for_each_lane(target.u, a.f, b.f, [](float x, float y) { return x != y ? 1u : 0u; });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x != y ? 1u : 0u; });
+					break;
+				case left_shift:
+					for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x << (y & 31); });
+					break;
+				case right_shift:
+					if (is_signed)
+						for_each_lane(target.i, a.i, b.i, [](int32_t x, int32_t y) { return x >> (y & 31); });
+					else
+						for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x >> (y & 31); });
+					break;
+				case bitwise_or:
+				case logical_or:
+					for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x | y; });
+					break;
+				case bitwise_xor:
+					for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x ^ y; });
+					break;
+				case bitwise_and:
+				case logical_and:
+					for_each_lane(target.u, a.u, b.u, [](uint32_t x, uint32_t y) { return x & y; });
+					break;
+			}
+		}
+	}
+	void conditional_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		// Both sides are always evaluated, like in HLSL
+		condition->evaluate(context, mask);
+		expression_when_true->evaluate(context, mask);
+		expression_when_false->evaluate(context, mask);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			const lane_value &test = context.temporaries[condition->result + (condition->components == 1 ? 0 : c)];
+			const lane_value &a = context.temporaries[expression_when_true->result + c];
+			const lane_value &b = context.temporaries[expression_when_false->result + c];
+			lane_value &target = context.temporaries[result + c];
+
+			for (unsigned int l = 0; l < lane_count; l++)
+			{
+				target.u[l] = test.u[l] != 0 ? a.u[l] : b.u[l];
+			}
+		}
+	}
+	void sequence_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		for (const auto &expression : expressions)
+		{
+			expression->evaluate(context, mask);
+		}
+	}
+	void construct_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		unsigned int offset = result;
+
+		for (const auto &operand : operands)
+		{
+			operand->evaluate(context, mask);
+
+			for (unsigned int c = 0; c < operand->components; c++)
+			{
+				context.temporaries[offset++] = context.temporaries[operand->result + c];
+			}
+		}
+	}
+	void swizzle_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		operand->evaluate(context, mask);
+
+		for (unsigned int c = 0; c < components; c++)
+		{
+			context.temporaries[result + c] = context.temporaries[operand->result + swizzle[c]];
+		}
+	}
+	void extract_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		operand->evaluate(context, mask);
+		index->evaluate(context, mask);
+
+		const lane_value &indices = context.temporaries[index->result];
+
+		for (unsigned int l = 0; l < lane_count; l++)
+		{
+			const unsigned int offset = static_cast<unsigned int>(std::min(std::max(indices.i[l], 0), static_cast<int32_t>(count) - 1)) * stride;
+
+			for (unsigned int c = 0; c < components; c++)
+			{
+				context.temporaries[result + c].u[l] = context.temporaries[operand->result + offset + c].u[l];
+			}
+		}
+	}
+	void call_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		// Evaluate all arguments before writing any parameter, since an argument may call the same function again
+		for (const auto &argument : arguments)
+		{
+			argument.value->evaluate(context, mask);
+		}
+		for (const auto &argument : arguments)
+		{
+			std::copy_n(&context.temporaries[argument.value->result], argument.value->components, &context.variables[argument.parameter_slot]);
+		}
+
+		// Lanes which do not reach a return statement get a defined result
+		for (unsigned int c = 0; c < components; c++)
+		{
+			std::fill_n(context.variables[return_slot + c].u, lane_count, 0u);
+		}
+
+		context.call(*callee, mask);
+
+		std::copy_n(&context.variables[return_slot], components, &context.temporaries[result]);
+
+		for (const auto &write_back : write_backs)
+		{
+			write_back->evaluate(context, mask);
+		}
+	}
+	void intrinsic_expression::evaluate(shader_context &context, lane_mask mask) const
+	{
+		for (const auto &argument : arguments)
+		{
+			if (argument != nullptr)
+			{
+				argument->evaluate(context, mask);
+			}
+		}
+
+		lane_value *const target = &context.temporaries[result];
+		lane_value *const secondary = &context.temporaries[secondary_result];
+		const lane_value *const a = arguments[0] != nullptr ? &context.temporaries[arguments[0]->result] : nullptr;
+		const lane_value *const b = arguments[1] != nullptr ? &context.temporaries[arguments[1]->result] : nullptr;
+		const lane_value *const c = arguments[2] != nullptr ? &context.temporaries[arguments[2]->result] : nullptr;
+		const lane_value *const d = arguments[3] != nullptr ? &context.temporaries[arguments[3]->result] : nullptr;
+		const unsigned int argument_components = arguments[0] != nullptr ? arguments[0]->components : 0;
+
+		switch (op)
+		{
+			case abs:
+				for_each_component(target, a, components, [](float x) { return std::fabs(x); });
+				break;
+			case acos:
+				for_each_component(target, a, components, [](float x) { return std::acos(x); });
+				break;
+			case all:
+			case any:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					bool value = op == all;
+
+					for (unsigned int k = 0; k < argument_components; k++)
+					{
+						value = op == all ? value && a[k].u[l] != 0 : value || a[k].u[l] != 0;
+					}
+
+					target[0].u[l] = value ? 1 : 0;
+				}
+				break;
+			case asin:
+				for_each_component(target, a, components, [](float x) { return std::asin(x); });
+				break;
+			case atan:
+				for_each_component(target, a, components, [](float x) { return std::atan(x); });
+				break;
+			case atan2:
+				for_each_component(target, a, b, components, [](float y, float x) { return std::atan2(y, x); });
+				break;
+			case bitcast:
+				std::copy_n(a, components, target);
+				break;
+			case ceil:
+				for_each_component(target, a, components, [](float x) { return std::ceil(x); });
+				break;
+			case clamp:
+				for_each_component(target, a, b, c, components, [](float x, float min, float max) { return std::fmin(std::fmax(x, min), max); });
+				break;
+			case cos:
+				for_each_component(target, a, components, [](float x) { return std::cos(x); });
+				break;
+			case cosh:
+				for_each_component(target, a, components, [](float x) { return std::cosh(x); });
+				break;
+			case cross:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					target[0].f[l] = a[1].f[l] * b[2].f[l] - a[2].f[l] * b[1].f[l];
+					target[1].f[l] = a[2].f[l] * b[0].f[l] - a[0].f[l] * b[2].f[l];
+					target[2].f[l] = a[0].f[l] * b[1].f[l] - a[1].f[l] * b[0].f[l];
+				}
+				break;
+			case ddx:
+			case fwidth:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						target[k].f[l] = a[k].f[l | 1] - a[k].f[l & ~1u];
+					}
+				}
+				if (op == ddx)
+				{
+					break;
+				}
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						target[k].f[l] = std::fabs(target[k].f[l]) + std::fabs(a[k].f[l | 4] - a[k].f[l & ~4u]);
+					}
+				}
+				break;
+			case ddy:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						target[k].f[l] = a[k].f[l | 4] - a[k].f[l & ~4u];
+					}
+				}
+				break;
+			case degrees:
+				for_each_component(target, a, components, [](float x) { return x * 57.29577951f; });
+				break;
+			case determinant:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float matrix[16];
+
+					for (unsigned int k = 0; k < argument_components; k++)
+					{
+						matrix[k] = a[k].f[l];
+					}
+
+					target[0].f[l] = software::determinant(matrix, rows[0]);
+				}
+				break;
+			case distance:
+			case dot:
+			case length:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float sum = 0.0f;
+
+					for (unsigned int k = 0; k < argument_components; k++)
+					{
+						const float x = op == distance ? a[k].f[l] - b[k].f[l] : a[k].f[l];
+						const float y = op == dot ? b[k].f[l] : x;
+
+						sum += x * y;
+					}
+
+					target[0].f[l] = op == dot ? sum : std::sqrt(sum);
+				}
+				break;
+			case exp:
+				for_each_component(target, a, components, [](float x) { return std::exp(x); });
+				break;
+			case exp2:
+				for_each_component(target, a, components, [](float x) { return std::exp2(x); });
+				break;
+			case faceforward:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float sum = 0.0f;
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						sum += b[k].f[l] * c[k].f[l];
+					}
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						target[k].f[l] = sum < 0.0f ? a[k].f[l] : -a[k].f[l];
+					}
+				}
+				break;
+			case floor:
+				for_each_component(target, a, components, [](float x) { return std::floor(x); });
+				break;
+			case frac:
+				for_each_component(target, a, components, [](float x) { return x - std::floor(x); });
+				break;
+			case frexp:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						int exponent = 0;
+						target[k].f[l] = std::frexp(a[k].f[l], &exponent);
+						secondary[k].f[l] = static_cast<float>(exponent);
+					}
+				}
+				break;
+			case isinf:
+			case isnan:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						const bool value = op == isinf ? std::isinf(a[k].f[l]) : std::isnan(a[k].f[l]);
+
+						if (type == scalar_type::floating_point)
+							target[k].f[l] = value ? 1.0f : 0.0f;
+						else
+							target[k].u[l] = value ? 1 : 0;
+					}
+				}
+				break;
+			case ldexp:
+				for_each_component(target, a, b, components, [](float x, float e) { return x * std::exp2(e); });
+				break;
+			case lerp:
+				for_each_component(target, a, b, c, components, [](float x, float y, float s) { return x + (y - x) * s; });
+				break;
+			case log:
+				for_each_component(target, a, components, [](float x) { return std::log(x); });
+				break;
+			case log10:
+				for_each_component(target, a, components, [](float x) { return std::log10(x); });
+				break;
+			case log2:
+				for_each_component(target, a, components, [](float x) { return std::log2(x); });
+				break;
+			case mad:
+				for_each_component(target, a, b, c, components, [](float x, float y, float z) { return x * y + z; });
+				break;
+			case max:
+				for_each_component(target, a, b, components, [](float x, float y) { return std::fmax(x, y); });
+				break;
+			case min:
+				for_each_component(target, a, b, components, [](float x, float y) { return std::fmin(x, y); });
+				break;
+			case modf:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						target[k].f[l] = std::modf(a[k].f[l], &secondary[k].f[l]);
+					}
+				}
+				break;
+			case mul:
+				if (rows[0] * cols[0] == 1 || rows[1] * cols[1] == 1)
+				{
+					// Multiplication with a scalar is done per component
+					const bool scalar_first = rows[0] * cols[0] == 1;
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						const lane_value &x = scalar_first ? a[0] : a[k], &y = scalar_first ? b[k] : b[0];
+
+						for_each_lane(target[k].f, x.f, y.f, [](float s, float t) { return s * t; });
+					}
+				}
+				else
+				{
+					for (unsigned int i = 0; i < rows[0]; i++)
+					{
+						for (unsigned int j = 0; j < cols[1]; j++)
+						{
+							lane_value &element = target[i * cols[1] + j];
+							std::fill_n(element.f, lane_count, 0.0f);
+
+							for (unsigned int k = 0; k < cols[0]; k++)
+							{
+								const lane_value &x = a[i * cols[0] + k], &y = b[k * cols[1] + j];
+
+								for (unsigned int l = 0; l < lane_count; l++)
+								{
+									element.f[l] += x.f[l] * y.f[l];
+								}
+							}
+						}
+					}
+				}
+				break;
+			case normalize:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float sum = 0.0f;
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						sum += a[k].f[l] * a[k].f[l];
+					}
+
+					const float scale = 1.0f / std::sqrt(sum);
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						target[k].f[l] = a[k].f[l] * scale;
+					}
+				}
+				break;
+			case pow:
+				for_each_component(target, a, b, components, [](float x, float y) { return std::pow(x, y); });
+				break;
+			case radians:
+				for_each_component(target, a, components, [](float x) { return x * 0.01745329252f; });
+				break;
+			case rcp:
+				for_each_component(target, a, components, [](float x) { return 1.0f / x; });
+				break;
+			case reflect:
+			case refract:
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float sum = 0.0f;
+
+					for (unsigned int k = 0; k < components; k++)
+					{
+						sum += a[k].f[l] * b[k].f[l];
+					}
+
+					if (op == reflect)
+					{
+						for (unsigned int k = 0; k < components; k++)
+						{
+							target[k].f[l] = a[k].f[l] - 2.0f * sum * b[k].f[l];
+						}
+					}
+					else
+					{
+						const float eta = c[0].f[l];
+						const float k2 = 1.0f - eta * eta * (1.0f - sum * sum);
+
+						for (unsigned int k = 0; k < components; k++)
+						{
+							target[k].f[l] = k2 < 0.0f ? 0.0f : eta * a[k].f[l] - (eta * sum + std::sqrt(k2)) * b[k].f[l];
+						}
+					}
+				}
+				break;
+			case round:
+				for_each_component(target, a, components, [](float x) { return std::nearbyint(x); });
+				break;
+			case rsqrt:
+				for_each_component(target, a, components, [](float x) { return 1.0f / std::sqrt(x); });
+				break;
+			case saturate:
+				for_each_component(target, a, components, [](float x) { return x > 0.0f ? std::min(x, 1.0f) : 0.0f; });
+				break;
+			case sign:
+				for (unsigned int k = 0; k < components; k++)
+				{
+					for_each_lane(target[k].i, a[k].f, [](float x) { return static_cast<int32_t>(x > 0.0f) - static_cast<int32_t>(x < 0.0f); });
+				}
+				break;
+			case sin:
+				for_each_component(target, a, components, [](float x) { return std::sin(x); });
+				break;
+			case sincos:
+				for_each_component(secondary, a, argument_components, [](float x) { return std::sin(x); });
+				for_each_component(secondary + argument_components, a, argument_components, [](float x) { return std::cos(x); });
+				break;
+			case sinh:
+				for_each_component(target, a, components, [](float x) { return std::sinh(x); });
+				break;
+			case smoothstep:
+				for_each_component(target, a, b, c, components, [](float min, float max, float x) {
+					float t = (x - min) / (max - min);
+					t = t > 0.0f ? std::min(t, 1.0f) : 0.0f;
+					return t * t * (3.0f - 2.0f * t);
+				});
+				break;
+			case sqrt:
+				for_each_component(target, a, components, [](float x) { return std::sqrt(x); });
+				break;
+			case step:
+				for_each_component(target, a, b, components, [](float y, float x) { return x >= y ? 1.0f : 0.0f; });
+				break;
+			case tan:
+				for_each_component(target, a, components, [](float x) { return std::tan(x); });
+				break;
+			case tanh:
+				for_each_component(target, a, components, [](float x) { return std::tanh(x); });
+				break;
+			case transpose:
+				for (unsigned int i = 0; i < rows[0]; i++)
+				{
+					for (unsigned int j = 0; j < cols[0]; j++)
+					{
+						target[j * rows[0] + i] = a[i * cols[0] + j];
+					}
+				}
+				break;
+			case trunc:
+				for_each_component(target, a, components, [](float x) { return std::trunc(x); });
+				break;
+			case texture:
+			case texture_offset:
+			case texture_projection:
+			case texture_level:
+			case texture_level_offset:
+			case texture_gradient:
+			{
+				const software_sampler *const sampler = context.sampler(a[0].u[0]);
+
+				lane_value u = b[0], v = b[1];
+				float lod[lane_count];
+				int offset_x = 0, offset_y = 0;
+
+				if (op == texture_projection)
+				{
+					for (unsigned int l = 0; l < lane_count; l++)
+					{
+						u.f[l] /= b[3].f[l];
+						v.f[l] /= b[3].f[l];
+					}
+				}
+
+				if (op == texture_level || op == texture_level_offset)
+				{
+					std::copy_n(b[3].f, lane_count, lod);
+				}
+				else if (op == texture_gradient)
+				{
+					compute_lod(sampler, c[0].f, c[1].f, d[0].f, d[1].f, lod);
+				}
+				else
+				{
+					compute_implicit_lod(sampler, u, v, lod);
+				}
+
+				// Offsets have to be constant, so they are the same in all lanes
+				if (op == texture_offset || op == texture_level_offset)
+				{
+					offset_x = c[0].i[0];
+					offset_y = c[1].i[0];
+				}
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float texel[4];
+					software::sample(sampler, u.f[l], v.f[l], lod[l], offset_x, offset_y, texel);
+
+					for (unsigned int k = 0; k < 4; k++)
+					{
+						target[k].f[l] = texel[k];
+					}
+				}
+				break;
+			}
+			case texture_fetch:
+			{
+				const software_sampler *const sampler = context.sampler(a[0].u[0]);
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+					// Loads outside the texture return zero, regardless of the address mode
+					if (sampler != nullptr && sampler->texture != nullptr && b[3].u[l] < sampler->texture->levels.size())
+					{
+						const auto &mip = sampler->texture->levels[b[3].u[l]];
+
+						if (b[0].u[l] < mip.width && b[1].u[l] < mip.height)
+						{
+							read_texel(*sampler, mip, b[0].i[l], b[1].i[l], texel);
+						}
+					}
+
+					for (unsigned int k = 0; k < 4; k++)
+					{
+						target[k].f[l] = texel[k];
+					}
+				}
+				break;
+			}
+			case texture_gather:
+			case texture_gather_offset:
+			{
+				const software_sampler *const sampler = context.sampler(a[0].u[0]);
+				const unsigned int component = std::min(op == texture_gather ? c[0].u[0] : d[0].u[0], 3u);
+				const int offset_x = op == texture_gather_offset ? c[0].i[0] : 0;
+				const int offset_y = op == texture_gather_offset ? c[1].i[0] : 0;
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					float texels[4][4] = { };
+
+					if (sampler != nullptr && sampler->texture != nullptr && !sampler->texture->levels.empty())
+					{
+						const auto &mip = sampler->texture->levels[0];
+						const float x = (std::isfinite(b[0].f[l]) ? b[0].f[l] : 0.0f) * mip.width - 0.5f;
+						const float y = (std::isfinite(b[1].f[l]) ? b[1].f[l] : 0.0f) * mip.height - 0.5f;
+						const int ix = float_to_coordinate(std::floor(x)) + offset_x, iy = float_to_coordinate(std::floor(y)) + offset_y;
+
+						// Gather returns the texels of the bilinear footprint in counter-clockwise order, starting at the lower left
+						read_texel(*sampler, mip, ix, iy + 1, texels[0]);
+						read_texel(*sampler, mip, ix + 1, iy + 1, texels[1]);
+						read_texel(*sampler, mip, ix + 1, iy, texels[2]);
+						read_texel(*sampler, mip, ix, iy, texels[3]);
+					}
+
+					for (unsigned int k = 0; k < 4; k++)
+					{
+						target[k].f[l] = texels[k][component];
+					}
+				}
+				break;
+			}
+			case texture_size:
+			{
+				const software_sampler *const sampler = context.sampler(a[0].u[0]);
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					const bool valid = sampler != nullptr && sampler->texture != nullptr && b[0].u[l] < sampler->texture->levels.size();
+
+					target[0].u[l] = valid ? sampler->texture->levels[b[0].u[l]].width : 0;
+					target[1].u[l] = valid ? sampler->texture->levels[b[0].u[l]].height : 0;
+				}
+				break;
+			}
+		}
+
+		for (const auto &write_back : write_backs)
+		{
+			write_back->evaluate(context, mask);
+		}
+	}
+	#pragma endregion
+
+	#pragma region Statements
+	void block_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		for (const auto &statement : statements)
+		{
+			if (mask == 0)
+			{
+				break;
+			}
+
+			statement->execute(context, mask);
+		}
+	}
+	void expression_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		expression->evaluate(context, mask);
+	}
+	void if_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		condition->evaluate(context, mask);
+
+		const lane_mask test = to_mask(context.temporaries[condition->result]);
+		lane_mask mask_when_true = mask & test, mask_when_false = mask & ~test;
+
+		if (mask_when_true != 0 && statement_when_true != nullptr)
+		{
+			statement_when_true->execute(context, mask_when_true);
+		}
+		if (mask_when_false != 0 && statement_when_false != nullptr)
+		{
+			statement_when_false->execute(context, mask_when_false);
+		}
+
+		mask = mask_when_true | mask_when_false;
+	}
+	void switch_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		test_expression->evaluate(context, mask);
+
+		// Match all labels before executing any case, since the cases reuse the temporary storage of the test expression
+		const lane_value &test = context.temporaries[test_expression->result];
+		std::vector<lane_mask> case_masks(case_labels.size());
+		lane_mask matched = 0;
+		size_t default_case = case_labels.size();
+
+		for (size_t i = 0; i < case_labels.size(); i++)
+		{
+			for (const auto &label : case_labels[i])
+			{
+				if (label.is_default)
+				{
+					default_case = i;
+					continue;
+				}
+
+				for (unsigned int l = 0; l < lane_count; l++)
+				{
+					case_masks[i] |= (test.u[l] == label.value ? 1u : 0u) << l;
+				}
+			}
+
+			case_masks[i] &= mask & ~matched;
+			matched |= case_masks[i];
+		}
+
+		if (default_case < case_labels.size())
+		{
+			case_masks[default_case] |= mask & ~matched;
+		}
+
+		const lane_mask previous_break_mask = context.break_mask;
+		context.break_mask = 0;
+
+		// Lanes which do not leave a case fall through to the next one
+		lane_mask active = 0;
+
+		for (size_t i = 0; i < case_statements.size(); i++)
+		{
+			active |= case_masks[i];
+
+			if (active != 0 && case_statements[i] != nullptr)
+			{
+				case_statements[i]->execute(context, active);
+			}
+		}
+
+		mask = active | context.break_mask;
+		context.break_mask = previous_break_mask;
+	}
+	void loop_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		if (init_statement != nullptr)
+		{
+			init_statement->execute(context, mask);
+		}
+
+		const lane_mask previous_break_mask = context.break_mask, previous_continue_mask = context.continue_mask;
+		context.break_mask = context.continue_mask = 0;
+
+		lane_mask active = mask, finished = 0;
+
+		for (unsigned int iteration = 0; active != 0; iteration++)
+		{
+			if (condition != nullptr && (iteration != 0 || !is_do_while))
+			{
+				condition->evaluate(context, active);
+
+				const lane_mask passed = active & to_mask(context.temporaries[condition->result]);
+
+				finished |= active & ~passed;
+				active = passed;
+
+				if (active == 0)
+				{
+					break;
+				}
+			}
+
+			if (iteration == max_iterations)
+			{
+				finished |= active;
+				break;
+			}
+
+			if (statement_list != nullptr)
+			{
+				statement_list->execute(context, active);
+			}
+
+			active |= context.continue_mask;
+			finished |= context.break_mask;
+			context.break_mask = context.continue_mask = 0;
+
+			if (increment_expression != nullptr && active != 0)
+			{
+				increment_expression->evaluate(context, active);
+			}
+		}
+
+		mask = finished;
+		context.break_mask = previous_break_mask;
+		context.continue_mask = previous_continue_mask;
+	}
+	void return_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		if (is_discard)
+		{
+			context.discard_mask |= mask;
+		}
+		else if (return_value != nullptr)
+		{
+			return_value->evaluate(context, mask);
+		}
+
+		mask = 0;
+	}
+	void jump_statement::execute(shader_context &context, lane_mask &mask) const
+	{
+		if (is_break)
+		{
+			context.break_mask |= mask;
+		}
+		else
+		{
+			context.continue_mask |= mask;
+		}
+
+		mask = 0;
+	}
+	#pragma endregion
+}
@@ -0,0 +1,421 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cfloat>
+#include <memory>
+#include "software_texture.hpp"
+
+namespace reshade::software
+{
+	#pragma region Forward Declarations
+	class shader_context;
+	struct shader_function;
+	#pragma endregion
+
+	/// <summary>
+	/// Number of invocations a shader is evaluated for at once. For pixel shaders they form a block of 4x2 pixels, which consists of two 2x2 quads to compute derivatives in.
+	/// </summary>
+	const unsigned int lane_count = 8;
+
+	/// <summary>
+	/// A bit mask with one bit per lane.
+	/// </summary>
+	typedef unsigned int lane_mask;
+	const lane_mask all_lanes = (1u << lane_count) - 1;
+
+	/// <summary>
+	/// A single scalar component of a value in all lanes. Booleans are stored as unsigned integers which are either zero or one, samplers as their index in the sampler list.
+	/// All operations loop over the lanes of a component, so that the compiler can turn them into vector instructions.
+	/// </summary>
+	union alignas(32) lane_value
+	{
+		float f[lane_count];
+		int32_t i[lane_count];
+		uint32_t u[lane_count];
+	};
+
+	enum class scalar_type
+	{
+		boolean,
+		signed_integer,
+		unsigned_integer,
+		floating_point
+	};
+
+	struct software_sampler
+	{
+		const software_tex_data *texture = nullptr;
+		texture_filter filter = texture_filter::min_mag_mip_linear;
+		texture_address_mode address_u = texture_address_mode::clamp;
+		texture_address_mode address_v = texture_address_mode::clamp;
+		bool srgb = false;
+		float min_lod = 0.0f, max_lod = FLT_MAX, lod_bias = 0.0f;
+	};
+
+	/// <summary>
+	/// An expression in the intermediate representation. Evaluating it writes its value to a fixed range of temporary slots.
+	/// Expressions are evaluated for all lanes, the mask only limits which lanes their side effects apply to.
+	/// </summary>
+	struct shader_expression abstract
+	{
+		virtual ~shader_expression() { }
+
+		virtual void evaluate(shader_context &context, lane_mask mask) const = 0;
+
+		unsigned int result = 0, components = 0;
+	};
+	/// <summary>
+	/// A statement in the intermediate representation.
+	/// </summary>
+	struct shader_statement abstract
+	{
+		virtual ~shader_statement() { }
+
+		/// <summary>
+		/// Execute the statement.
+		/// </summary>
+		/// <param name="context">The execution context.</param>
+		/// <param name="mask">The lanes that execute the statement. Lanes that leave it through a jump, return or discard are removed.</param>
+		virtual void execute(shader_context &context, lane_mask &mask) const = 0;
+	};
+
+	/// <summary>
+	/// A reference to variable storage or uniform data, which can be indexed dynamically.
+	/// </summary>
+	struct shader_lvalue
+	{
+		struct dynamic_index
+		{
+			std::unique_ptr<shader_expression> index;
+			unsigned int stride, count;
+		};
+
+		/// <summary>
+		/// Whether this references the uniform data instead of a variable. The base and components are counted in 4 byte units then.
+		/// </summary>
+		bool uniform = false;
+		scalar_type type = scalar_type::floating_point;
+		unsigned int base = 0;
+		std::vector<dynamic_index> indices;
+		/// <summary>
+		/// The offsets of the referenced components relative to the base after applying all dynamic indices.
+		/// </summary>
+		std::vector<unsigned int> components;
+	};
+
+	struct shader_function
+	{
+		std::string name;
+		std::unique_ptr<shader_statement> body;
+	};
+	/// <summary>
+	/// A signature element of an entry point, which is a parameter, a field of a structure parameter or the return value with a semantic.
+	/// </summary>
+	struct shader_signature_element
+	{
+		std::string semantic;
+		unsigned int slot, components;
+		scalar_type type;
+		unsigned int qualifiers;
+	};
+	struct shader_entry_point
+	{
+		const shader_function *function = nullptr;
+		std::vector<shader_signature_element> inputs, outputs;
+	};
+
+	/// <summary>
+	/// All functions and global variables of an effect in the intermediate representation, with a fixed storage layout. Recursion is not allowed in effects, so every variable can be assigned fixed storage.
+	/// </summary>
+	struct shader_program
+	{
+		unsigned int variable_count = 0, temporary_count = 0;
+		std::vector<std::unique_ptr<shader_function>> functions;
+		std::unique_ptr<shader_statement> global_initializers;
+	};
+
+	/// <summary>
+	/// The state of a shader invocation. Each thread executing shaders needs its own context.
+	/// </summary>
+	class shader_context
+	{
+	public:
+		/// <summary>
+		/// Prepare the context for executing a program.
+		/// </summary>
+		/// <param name="program">The program to execute.</param>
+		/// <param name="samplers">The samplers the program accesses through their index.</param>
+		/// <param name="uniform_data">The uniform storage of the runtime.</param>
+		void reset(const shader_program &program, const software_sampler *samplers, size_t sampler_count, const uint8_t *uniform_data);
+
+		/// <summary>
+		/// Invoke an entry point after its inputs were written to the variable storage. This runs the global variable initializers first.
+		/// </summary>
+		/// <param name="function">The entry point function.</param>
+		/// <param name="mask">The lanes to execute.</param>
+		void execute_entry_point(const shader_function &function, lane_mask mask);
+		/// <summary>
+		/// Call a function after its parameters were written to the variable storage.
+		/// </summary>
+		/// <param name="function">The function to call.</param>
+		/// <param name="mask">The lanes to execute.</param>
+		void call(const shader_function &function, lane_mask mask);
+
+		const software_sampler *sampler(uint32_t index) const { return index < _sampler_count ? &_samplers[index] : nullptr; }
+		const uint8_t *uniform_data() const { return _uniform_data; }
+
+		std::vector<lane_value> variables, temporaries;
+		lane_mask break_mask = 0, continue_mask = 0, discard_mask = 0;
+
+	private:
+		const shader_program *_program = nullptr;
+		const software_sampler *_samplers = nullptr;
+		size_t _sampler_count = 0;
+		const uint8_t *_uniform_data = nullptr;
+	};
+
+	#pragma region Expressions
+	struct constant_expression : shader_expression
+	{
+		std::vector<uint32_t> values;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	/// <summary>
+	/// Refers to the value already stored in other temporary slots, e.g. a secondary result of an intrinsic.
+	/// </summary>
+	struct temporary_expression : shader_expression
+	{
+		void evaluate(shader_context &, lane_mask) const override { }
+	};
+	struct load_expression : shader_expression
+	{
+		shader_lvalue source;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct store_expression : shader_expression
+	{
+		shader_lvalue target;
+		std::unique_ptr<shader_expression> value;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	/// <summary>
+	/// Evaluates to the value an l-value had before an expression modified it, for post increment and decrement.
+	/// </summary>
+	struct previous_value_expression : shader_expression
+	{
+		std::unique_ptr<shader_expression> load, modify;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct convert_expression : shader_expression
+	{
+		scalar_type from, to;
+		std::unique_ptr<shader_expression> operand;
+		/// <summary>
+		/// The operand component each result component is read from, which implements scalar broadcast and vector truncation.
+		/// </summary>
+		std::vector<unsigned int> swizzle;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct unary_expression : shader_expression
+	{
+		enum op
+		{
+			negate,
+			bitwise_not,
+			logical_not
+		};
+
+		op op;
+		scalar_type type;
+		std::unique_ptr<shader_expression> operand;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct binary_expression : shader_expression
+	{
+		enum op
+		{
+			add,
+			subtract,
+			multiply,
+			divide,
+			modulo,
+			less,
+			greater,
+			less_equal,
+			greater_equal,
+			equal,
+			not_equal,
+			left_shift,
+			right_shift,
+			bitwise_or,
+			bitwise_xor,
+			bitwise_and,
+			logical_or,
+			logical_and
+		};
+
+		op op;
+		/// <summary>
+		/// The type of the operands. Comparisons produce booleans regardless.
+		/// </summary>
+		scalar_type type;
+		std::unique_ptr<shader_expression> operands[2];
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct conditional_expression : shader_expression
+	{
+		std::unique_ptr<shader_expression> condition, expression_when_true, expression_when_false;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct sequence_expression : shader_expression
+	{
+		std::vector<std::unique_ptr<shader_expression>> expressions;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	/// <summary>
+	/// Concatenates the components of its operands, for constructors and initializer lists.
+	/// </summary>
+	struct construct_expression : shader_expression
+	{
+		std::vector<std::unique_ptr<shader_expression>> operands;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	/// <summary>
+	/// Selects components of a value that is not an l-value, for swizzles, fields and constant indices.
+	/// </summary>
+	struct swizzle_expression : shader_expression
+	{
+		std::unique_ptr<shader_expression> operand;
+		std::vector<unsigned int> swizzle;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	/// <summary>
+	/// Selects an element of a value that is not an l-value with a dynamic index.
+	/// </summary>
+	struct extract_expression : shader_expression
+	{
+		std::unique_ptr<shader_expression> operand, index;
+		unsigned int stride, count;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct call_expression : shader_expression
+	{
+		struct argument
+		{
+			std::unique_ptr<shader_expression> value;
+			unsigned int parameter_slot;
+		};
+
+		const shader_function *callee = nullptr;
+		unsigned int return_slot = 0;
+		std::vector<argument> arguments;
+		/// <summary>
+		/// Stores that copy output parameters back to the arguments after the call.
+		/// </summary>
+		std::vector<std::unique_ptr<shader_expression>> write_backs;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	struct intrinsic_expression : shader_expression
+	{
+		enum op
+		{
+			abs, acos, all, any, asin, atan, atan2, bitcast, ceil, clamp, cos, cosh, cross, ddx, ddy, degrees, determinant, distance, dot, exp, exp2, faceforward, floor, frac, frexp, fwidth, isinf, isnan, ldexp, length, lerp, log, log10, log2, mad, max, min, modf, mul, normalize, pow, radians, rcp, reflect, refract, round, rsqrt, saturate, sign, sin, sincos, sinh, smoothstep, sqrt, step, tan, tanh, transpose, trunc,
+			texture, texture_fetch, texture_gather, texture_gather_offset, texture_gradient, texture_level, texture_level_offset, texture_offset, texture_projection, texture_size
+		};
+
+		op op;
+		scalar_type type = scalar_type::floating_point;
+		std::unique_ptr<shader_expression> arguments[4];
+		/// <summary>
+		/// The matrix dimensions of the first two arguments, for intrinsics that depend on them.
+		/// </summary>
+		unsigned int rows[2] = { }, cols[2] = { };
+		/// <summary>
+		/// First temporary slot of the secondary results of "frexp", "modf" and "sincos".
+		/// </summary>
+		unsigned int secondary_result = 0;
+		std::vector<std::unique_ptr<shader_expression>> write_backs;
+
+		void evaluate(shader_context &context, lane_mask mask) const override;
+	};
+	#pragma endregion
+
+	#pragma region Statements
+	struct block_statement : shader_statement
+	{
+		std::vector<std::unique_ptr<shader_statement>> statements;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	struct expression_statement : shader_statement
+	{
+		std::unique_ptr<shader_expression> expression;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	struct if_statement : shader_statement
+	{
+		std::unique_ptr<shader_expression> condition;
+		std::unique_ptr<shader_statement> statement_when_true, statement_when_false;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	struct switch_statement : shader_statement
+	{
+		struct case_label
+		{
+			bool is_default;
+			uint32_t value;
+		};
+
+		std::unique_ptr<shader_expression> test_expression;
+		std::vector<std::vector<case_label>> case_labels;
+		std::vector<std::unique_ptr<shader_statement>> case_statements;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	/// <summary>
+	/// A for, while or do-while loop. Loops are aborted after a fixed amount of iterations, so that a broken effect cannot hang the runtime.
+	/// </summary>
+	struct loop_statement : shader_statement
+	{
+		static const unsigned int max_iterations = 65536;
+
+		bool is_do_while = false;
+		std::unique_ptr<shader_statement> init_statement, statement_list;
+		std::unique_ptr<shader_expression> condition, increment_expression;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	struct return_statement : shader_statement
+	{
+		bool is_discard = false;
+		std::unique_ptr<shader_expression> return_value;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	struct jump_statement : shader_statement
+	{
+		bool is_break = false;
+
+		void execute(shader_context &context, lane_mask &mask) const override;
+	};
+	#pragma endregion
+}
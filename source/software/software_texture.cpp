@@ -0,0 +1,250 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "software_texture.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::software
+{
+	static float round_to_unorm(float value, float scale)
+	{
+		if (!(value > 0.0f))
+		{
+			return 0.0f;
+		}
+		if (value >= 1.0f)
+		{
+			return 1.0f;
+		}
+
+		return std::nearbyint(value * scale) / scale;
+	}
+	static float round_to_half(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign = bits & 0x80000000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+
+		if (magnitude >= 0x7F800000)
+		{
+			// Infinity and NaN are kept as they are
+			return value;
+		}
+		else if (magnitude >= 0x477FF000)
+		{
+			// Values above the largest half float (65504) round to infinity
+			magnitude = 0x7F800000;
+		}
+		else if (magnitude < 0x38800000)
+		{
+			// Denormal half floats are spaced evenly in steps of 2^-24
+			const float denormal = std::nearbyint(std::fabs(value) * 16777216.0f) / 16777216.0f;
+			std::memcpy(&magnitude, &denormal, sizeof(magnitude));
+		}
+		else
+		{
+			// Round the mantissa to 10 bits, ties to even
+			magnitude = (magnitude + 0xFFF + ((magnitude >> 13) & 1)) & ~0x1FFFu;
+		}
+
+		bits = sign | magnitude;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	void resize_texture(software_tex_data &texture, unsigned int width, unsigned int height, unsigned int levels, texture_format format)
+	{
+		unsigned int max_levels = 1;
+
+		while ((std::max(width, height) >> max_levels) != 0)
+		{
+			max_levels++;
+		}
+
+		if (levels == 0 || levels > max_levels)
+		{
+			levels = max_levels;
+		}
+
+		texture.format = format;
+		texture.levels.resize(levels);
+
+		for (unsigned int level = 0; level < levels; level++)
+		{
+			auto &mip = texture.levels[level];
+			mip.width = std::max(1u, width >> level);
+			mip.height = std::max(1u, height >> level);
+			mip.texels.assign(mip.width * mip.height * 4, 0.0f);
+		}
+
+		clear_texture(texture);
+		generate_mipmaps(texture);
+	}
+	void clear_texture(software_tex_data &texture)
+	{
+		if (texture.levels.empty())
+		{
+			return;
+		}
+
+		float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		quantize_texel(texture.format, texel);
+
+		auto &texels = texture.levels[0].texels;
+
+		for (size_t i = 0; i < texels.size(); i += 4)
+		{
+			std::memcpy(&texels[i], texel, sizeof(texel));
+		}
+	}
+	void update_texture_data(software_tex_data &texture, const uint8_t *data)
+	{
+		if (texture.levels.empty())
+		{
+			return;
+		}
+
+		update_texture_level(texture, 0, data);
+
+		generate_mipmaps(texture);
+	}
+	void update_texture_level(software_tex_data &texture, unsigned int level, const uint8_t *data)
+	{
+		if (level >= texture.levels.size())
+		{
+			return;
+		}
+
+		auto &texels = texture.levels[level].texels;
+
+		for (size_t i = 0; i < texels.size(); i += 4)
+		{
+			for (size_t c = 0; c < 4; c++)
+			{
+				texels[i + c] = data[i + c] / 255.0f;
+			}
+
+			quantize_texel(texture.format, &texels[i]);
+		}
+	}
+	void generate_mipmaps(software_tex_data &texture)
+	{
+		for (size_t level = 1; level < texture.levels.size(); level++)
+		{
+			const auto &source = texture.levels[level - 1];
+			auto &target = texture.levels[level];
+
+			for (unsigned int y = 0; y < target.height; y++)
+			{
+				const unsigned int y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+
+				for (unsigned int x = 0; x < target.width; x++)
+				{
+					const unsigned int x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+
+					float *const texel = &target.texels[(y * target.width + x) * 4];
+
+					for (unsigned int c = 0; c < 4; c++)
+					{
+						texel[c] = 0.25f * (
+							source.texels[(y0 * source.width + x0) * 4 + c] +
+							source.texels[(y0 * source.width + x1) * 4 + c] +
+							source.texels[(y1 * source.width + x0) * 4 + c] +
+							source.texels[(y1 * source.width + x1) * 4 + c]);
+					}
+
+					quantize_texel(texture.format, texel);
+				}
+			}
+		}
+	}
+
+	void quantize_texel(texture_format format, float texel[4])
+	{
+		unsigned int channels = 4;
+
+		switch (format)
+		{
+			case texture_format::r8:
+			case texture_format::latc1:
+				channels = 1;
+				texel[0] = round_to_unorm(texel[0], 255.0f);
+				break;
+			case texture_format::r16f:
+				channels = 1;
+				texel[0] = round_to_half(texel[0]);
+				break;
+			case texture_format::r32f:
+				channels = 1;
+				break;
+			case texture_format::rg8:
+			case texture_format::latc2:
+				channels = 2;
+				texel[0] = round_to_unorm(texel[0], 255.0f);
+				texel[1] = round_to_unorm(texel[1], 255.0f);
+				break;
+			case texture_format::rg16:
+				channels = 2;
+				texel[0] = round_to_unorm(texel[0], 65535.0f);
+				texel[1] = round_to_unorm(texel[1], 65535.0f);
+				break;
+			case texture_format::rg16f:
+				channels = 2;
+				texel[0] = round_to_half(texel[0]);
+				texel[1] = round_to_half(texel[1]);
+				break;
+			case texture_format::rg32f:
+				channels = 2;
+				break;
+			case texture_format::rgba16:
+				for (unsigned int c = 0; c < 4; c++)
+					texel[c] = round_to_unorm(texel[c], 65535.0f);
+				break;
+			case texture_format::rgba16f:
+				for (unsigned int c = 0; c < 4; c++)
+					texel[c] = round_to_half(texel[c]);
+				break;
+			case texture_format::rgba32f:
+				break;
+			default:
+				// Block compressed formats are kept uncompressed, so they only lose the precision of their end points
+				for (unsigned int c = 0; c < 4; c++)
+					texel[c] = round_to_unorm(texel[c], 255.0f);
+				break;
+		}
+
+		for (unsigned int c = channels; c < 4; c++)
+		{
+			texel[c] = c == 3 ? 1.0f : 0.0f;
+		}
+	}
+	bool is_srgb_capable(texture_format format)
+	{
+		switch (format)
+		{
+			case texture_format::rgba8:
+			case texture_format::dxt1:
+			case texture_format::dxt3:
+			case texture_format::dxt5:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	float srgb_to_linear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+	float linear_to_srgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+}
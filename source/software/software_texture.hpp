@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "runtime_objects.hpp"
+
+namespace reshade::software
+{
+	/// <summary>
+	/// A single mipmap level of a texture. Texels are always stored as four floats, already rounded to the precision of the texture format.
+	/// </summary>
+	struct software_mip_level
+	{
+		unsigned int width = 0, height = 0;
+		std::vector<float> texels;
+	};
+
+	struct software_tex_data : base_object
+	{
+		texture_format format = texture_format::rgba8;
+		std::vector<software_mip_level> levels;
+	};
+
+	/// <summary>
+	/// Allocate storage for all mipmap levels of a texture and clear it to zero.
+	/// </summary>
+	/// <param name="texture">The texture to allocate.</param>
+	/// <param name="width">The width of the first level in texels.</param>
+	/// <param name="height">The height of the first level in texels.</param>
+	/// <param name="levels">The number of mipmap levels. It is reduced to the amount the dimensions allow.</param>
+	/// <param name="format">The format the contents are rounded to.</param>
+	void resize_texture(software_tex_data &texture, unsigned int width, unsigned int height, unsigned int levels, texture_format format);
+	/// <summary>
+	/// Clear the first level of a texture to zero, like clearing a render target.
+	/// </summary>
+	/// <param name="texture">The texture to clear.</param>
+	void clear_texture(software_tex_data &texture);
+	/// <summary>
+	/// Fill the first level of a texture with 32bpp RGBA image data and generate the other levels from it.
+	/// </summary>
+	/// <param name="texture">The texture to update.</param>
+	/// <param name="data">The image data, which has to match the dimensions of the first level.</param>
+	void update_texture_data(software_tex_data &texture, const uint8_t *data);
+	/// <summary>
+	/// Fill a single level of a texture with 32bpp RGBA image data, without touching the other levels.
+	/// </summary>
+	/// <param name="texture">The texture to update.</param>
+	/// <param name="level">The mipmap level to update.</param>
+	/// <param name="data">The image data, which has to match the dimensions of the level.</param>
+	void update_texture_level(software_tex_data &texture, unsigned int level, const uint8_t *data);
+	/// <summary>
+	/// Downsample the first level of a texture into all other levels with a box filter.
+	/// </summary>
+	/// <param name="texture">The texture to update.</param>
+	void generate_mipmaps(software_tex_data &texture);
+
+	/// <summary>
+	/// Round a color to the precision of a texture format. Channels the format does not have read as zero and alpha as one.
+	/// </summary>
+	/// <param name="format">The texture format to round to.</param>
+	/// <param name="texel">The color to round.</param>
+	void quantize_texel(texture_format format, float texel[4]);
+	/// <summary>
+	/// Returns whether a texture format has an sRGB variant that is decoded on sampling and encoded on rendering.
+	/// </summary>
+	/// <param name="format">The texture format to check.</param>
+	bool is_srgb_capable(texture_format format);
+
+	/// <summary>
+	/// Convert a color value from sRGB to linear space.
+	/// </summary>
+	float srgb_to_linear(float value);
+	/// <summary>
+	/// Convert a color value from linear to sRGB space.
+	/// </summary>
+	float linear_to_srgb(float value);
+}
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "texture_loader.hpp"
+#include <limits>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <stb_image.h>
+#include <stb_image_dds.h>
+#include <stb_image_resize.h>
+
+namespace reshade
+{
+	static bool read_file(const filesystem::path &path, std::vector<uint8_t> &data)
+	{
+		std::ifstream file(path.native(), std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+
+		return file.read(reinterpret_cast<char *>(data.data()), data.size()).good();
+	}
+
+	bool decode_image(const uint8_t *file_data, size_t file_size, decoded_image &image)
+	{
+		image.pixels.clear();
+
+		// The decoders take the size as an integer
+		if (file_size > static_cast<size_t>(std::numeric_limits<int>::max()))
+		{
+			return false;
+		}
+
+		int width = 0, height = 0, channels = 0;
+		stbi_uc *filedata = nullptr;
+
+		if (stbi_dds_test_memory(file_data, static_cast<int>(file_size)))
+		{
+			filedata = stbi_dds_load_from_memory(file_data, static_cast<int>(file_size), &width, &height, &channels, STBI_rgb_alpha);
+		}
+		else
+		{
+			filedata = stbi_load_from_memory(file_data, static_cast<int>(file_size), &width, &height, &channels, STBI_rgb_alpha);
+		}
+
+		if (filedata == nullptr)
+		{
+			return false;
+		}
+
+		image.source_width = width;
+		image.source_height = height;
+		image.pixels.resize(image.width * image.height * 4);
+
+		if (image.width != image.source_width || image.height != image.source_height)
+		{
+			stbir_resize_uint8(filedata, width, height, 0, image.pixels.data(), image.width, image.height, 0, 4);
+		}
+		else
+		{
+			std::memcpy(image.pixels.data(), filedata, image.pixels.size());
+		}
+
+		stbi_image_free(filedata);
+
+		return true;
+	}
+
+	texture_loader::texture_loader(size_t max_queued_images) : _max_queued_images(std::max<size_t>(max_queued_images, 1))
+	{
+	}
+	texture_loader::~texture_loader()
+	{
+		cancel();
+	}
+
+	void texture_loader::start(std::vector<request> &&requests, unsigned int num_threads)
+	{
+		cancel();
+
+		_requests = std::move(requests);
+		_next_request = 0;
+		_cancel = false;
+
+		if (num_threads == 0)
+		{
+			// Leave one processor to the render thread
+			num_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+
+		num_threads = static_cast<unsigned int>(std::min<size_t>(num_threads, _requests.size()));
+
+		for (unsigned int i = 0; i < num_threads; i++)
+		{
+			_threads.emplace_back(&texture_loader::worker_main, this);
+		}
+	}
+	void texture_loader::cancel()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			_cancel = true;
+		}
+
+		_queue_not_full.notify_all();
+
+		for (auto &thread : _threads)
+		{
+			thread.join();
+		}
+
+		_threads.clear();
+		_queue.clear();
+		_requests.clear();
+	}
+
+	bool texture_loader::pop(decoded_image &image)
+	{
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			if (_queue.empty())
+			{
+				return false;
+			}
+
+			image = std::move(_queue.front());
+			_queue.pop_front();
+		}
+
+		_queue_not_full.notify_one();
+
+		return true;
+	}
+
+	void texture_loader::worker_main()
+	{
+		std::vector<uint8_t> file_data;
+
+		for (size_t index; !_cancel.load(std::memory_order_relaxed) && (index = _next_request.fetch_add(1)) < _requests.size();)
+		{
+			const request &request = _requests[index];
+
+			decoded_image image;
+			image.texture_index = request.texture_index;
+			image.path = request.path;
+			image.width = request.width;
+			image.height = request.height;
+
+			// Leave the pixels empty on failure, so that the render thread can report the error
+			if (read_file(request.path, file_data) && decode_image(file_data.data(), file_data.size(), image))
+			{
+				std::vector<uint8_t> data;
+				convert_for_upload(image.pixels.data(), image.width, image.height, request.layout, data, image.levels);
+				image.pixels = std::move(data);
+			}
+
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			_queue_not_full.wait(lock, [this]() { return _cancel.load(std::memory_order_relaxed) || _queue.size() < _max_queued_images; });
+
+			if (_cancel.load(std::memory_order_relaxed))
+			{
+				break;
+			}
+
+			_queue.push_back(std::move(image));
+		}
+	}
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+#include "filesystem.hpp"
+#include "texture_upload.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// An image file decoded to RGBA pixels with the dimensions of the texture it is loaded into.
+	/// </summary>
+	struct decoded_image
+	{
+		size_t texture_index = 0;
+		filesystem::path path;
+		unsigned int width = 0, height = 0;
+		/// <summary>
+		/// Dimensions of the image in the file, which differ from the ones above if it had to be resized.
+		/// </summary>
+		unsigned int source_width = 0, source_height = 0;
+		/// <summary>
+		/// The pixels in RGBA format, or empty if the file could not be read or decoded.
+		/// Images popped from a <see cref="texture_loader"/> instead hold the data of all mipmap levels, already converted to the upload layout of the request.
+		/// </summary>
+		std::vector<uint8_t> pixels;
+		/// <summary>
+		/// Location of each mipmap level in the pixels of images popped from a <see cref="texture_loader"/>.
+		/// </summary>
+		std::vector<upload_level> levels;
+	};
+
+	/// <summary>
+	/// Decode the contents of an image file to RGBA pixels and resize them to the dimensions set in the image. This does not depend on any platform specific functionality.
+	/// </summary>
+	/// <param name="file_data">The contents of the image file.</param>
+	/// <param name="file_size">The size of the image file in bytes.</param>
+	/// <param name="image">The image to decode to, with its width and height set to the dimensions of the texture.</param>
+	/// <returns><c>true</c> on success, <c>false</c> if the file is not of a supported format.</returns>
+	bool decode_image(const uint8_t *file_data, size_t file_size, decoded_image &image);
+
+	/// <summary>
+	/// Reads, decodes and converts image files on a pool of worker threads and hands the results to the render thread through a bounded queue, so that the decoded images waiting for upload never take up more than a few images worth of memory.
+	/// The mipmap levels are generated and converted to the layout the runtime uploads on the worker threads as well, so that the render thread only has to copy the data to the texture.
+	/// </summary>
+	class texture_loader
+	{
+	public:
+		struct request
+		{
+			size_t texture_index;
+			filesystem::path path;
+			unsigned int width, height;
+			upload_layout layout;
+		};
+
+		/// <summary>
+		/// Construct a new texture loader.
+		/// </summary>
+		/// <param name="max_queued_images">The maximum number of decoded images waiting to be popped. Worker threads wait until there is space again.</param>
+		explicit texture_loader(size_t max_queued_images = 4);
+		~texture_loader();
+
+		/// <summary>
+		/// Start reading and decoding the specified image files in the background, after canceling any that are still pending.
+		/// </summary>
+		/// <param name="requests">The image files to load, together with the texture they are loaded into.</param>
+		/// <param name="num_threads">The number of worker threads, or zero to use one less than the number of processors.</param>
+		void start(std::vector<request> &&requests, unsigned int num_threads = 0);
+		/// <summary>
+		/// Stop all worker threads and discard all images which were not popped yet.
+		/// </summary>
+		void cancel();
+
+		/// <summary>
+		/// Remove the next decoded image from the queue, without waiting for one to become available.
+		/// </summary>
+		/// <returns><c>true</c> if an image was removed, <c>false</c> if none is ready yet.</returns>
+		bool pop(decoded_image &image);
+
+	private:
+		void worker_main();
+
+		const size_t _max_queued_images;
+		std::vector<request> _requests;
+		std::atomic<size_t> _next_request = 0;
+		std::atomic<bool> _cancel = false;
+		std::mutex _mutex;
+		std::condition_variable _queue_not_full;
+		std::deque<decoded_image> _queue;
+		std::vector<std::thread> _threads;
+	};
+}
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "texture_upload.hpp"
+#include <algorithm>
+
+namespace reshade
+{
+	static void convert_level(const uint8_t *pixels, const upload_layout &layout, const upload_level &level, uint8_t *data)
+	{
+		const unsigned int bytes_per_pixel = std::min(layout.bytes_per_pixel, 4u);
+
+		for (unsigned int y = 0; y < level.height; y++)
+		{
+			const uint8_t *const source_row = pixels + size_t(y) * level.width * 4;
+			uint8_t *const target_row = data + size_t(layout.flip_vertically ? level.height - 1 - y : y) * level.row_pitch;
+
+			for (unsigned int x = 0; x < level.width; x++)
+			{
+				for (unsigned int b = 0; b < bytes_per_pixel; b++)
+				{
+					const int channel = layout.channels[b];
+
+					target_row[x * bytes_per_pixel + b] = channel >= 0 && channel < 4 ? source_row[x * 4 + channel] : 0;
+				}
+			}
+		}
+	}
+	static void downsample_level(const uint8_t *source, unsigned int source_width, unsigned int source_height, uint8_t *target, unsigned int target_width, unsigned int target_height)
+	{
+		for (unsigned int y = 0; y < target_height; y++)
+		{
+			// Odd dimensions repeat the last row and column, which is what the software runtime does too
+			const unsigned int y0 = std::min(y * 2, source_height - 1), y1 = std::min(y * 2 + 1, source_height - 1);
+
+			for (unsigned int x = 0; x < target_width; x++)
+			{
+				const unsigned int x0 = std::min(x * 2, source_width - 1), x1 = std::min(x * 2 + 1, source_width - 1);
+
+				for (unsigned int c = 0; c < 4; c++)
+				{
+					const unsigned int sum =
+						source[(size_t(y0) * source_width + x0) * 4 + c] +
+						source[(size_t(y0) * source_width + x1) * 4 + c] +
+						source[(size_t(y1) * source_width + x0) * 4 + c] +
+						source[(size_t(y1) * source_width + x1) * 4 + c];
+
+					target[(size_t(y) * target_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	void convert_for_upload(const uint8_t *pixels, unsigned int width, unsigned int height, const upload_layout &layout, std::vector<uint8_t> &data, std::vector<upload_level> &levels)
+	{
+		data.clear();
+		levels.clear();
+
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
+
+		const unsigned int bytes_per_pixel = std::min(layout.bytes_per_pixel, 4u);
+
+		// Compute where each level goes first, so that the data is only allocated once
+		size_t size = 0;
+		for (unsigned int level_width = width, level_height = height; levels.size() < std::max(layout.levels, 1u); level_width = std::max(level_width / 2, 1u), level_height = std::max(level_height / 2, 1u))
+		{
+			upload_level &level = levels.emplace_back();
+			level.width = level_width;
+			level.height = level_height;
+			level.offset = size;
+			level.row_pitch = size_t(level_width) * bytes_per_pixel;
+
+			size += level.row_pitch * level_height;
+
+			if (level_width == 1 && level_height == 1)
+			{
+				break;
+			}
+		}
+
+		data.resize(size);
+
+		convert_level(pixels, layout, levels[0], data.data());
+
+		// Each level is downsampled from the RGBA pixels of the previous one, since the converted data may be missing channels or be flipped
+		std::vector<uint8_t> previous, current;
+
+		for (size_t i = 1; i < levels.size(); i++)
+		{
+			const upload_level &source = levels[i - 1];
+			const upload_level &target = levels[i];
+
+			current.resize(size_t(target.width) * target.height * 4);
+			downsample_level(i == 1 ? pixels : previous.data(), source.width, source.height, current.data(), target.width, target.height);
+
+			convert_level(current.data(), layout, target, data.data() + target.offset);
+
+			previous.swap(current);
+		}
+	}
+}
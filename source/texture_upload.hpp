@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// Describes how a runtime expects the image data it uploads to a texture to be laid out in memory, so that the conversion to it can happen before the data reaches the render thread.
+	/// </summary>
+	struct upload_layout
+	{
+		/// <summary>
+		/// The number of mipmap levels to generate. It is reduced to the amount the dimensions allow.
+		/// </summary>
+		unsigned int levels = 1;
+		/// <summary>
+		/// The number of bytes each pixel takes up.
+		/// </summary>
+		unsigned int bytes_per_pixel = 4;
+		/// <summary>
+		/// The RGBA channel each byte of a pixel is taken from, or -1 to set that byte to zero.
+		/// </summary>
+		int channels[4] = { 0, 1, 2, 3 };
+		/// <summary>
+		/// Store the rows of each level from bottom to top, as OpenGL expects them.
+		/// </summary>
+		bool flip_vertically = false;
+	};
+
+	/// <summary>
+	/// Location of a single mipmap level in image data converted with <see cref="convert_for_upload"/>.
+	/// </summary>
+	struct upload_level
+	{
+		unsigned int width = 0, height = 0;
+		/// <summary>
+		/// Offset of the first byte of the level in the data.
+		/// </summary>
+		size_t offset = 0;
+		/// <summary>
+		/// Number of bytes between the start of two rows. Rows are tightly packed.
+		/// </summary>
+		size_t row_pitch = 0;
+	};
+
+	/// <summary>
+	/// Generate all mipmap levels of an image with a box filter and convert each of them to the layout a runtime uploads. This does not depend on any graphics API.
+	/// </summary>
+	/// <param name="pixels">The 32bpp RGBA pixels of the first level.</param>
+	/// <param name="width">The width of the first level in pixels.</param>
+	/// <param name="height">The height of the first level in pixels.</param>
+	/// <param name="layout">The layout to convert to.</param>
+	/// <param name="data">The resulting data of all levels, which are stored one after another.</param>
+	/// <param name="levels">The resulting location of each level in the data.</param>
+	void convert_for_upload(const uint8_t *pixels, unsigned int width, unsigned int height, const upload_layout &layout, std::vector<uint8_t> &data, std::vector<upload_level> &levels);
+}
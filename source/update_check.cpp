@@ -1,3 +1,5 @@
+#if RESHADE_GUI
+
 #include "version.h"
 #include "runtime.hpp"
 #include <Windows.h>
@@ -62,3 +64,5 @@ bool reshade::runtime::check_for_update(unsigned long latest_version[3])
 
 	return false;
 }
+
+#endif
@@ -18,35 +18,15 @@ namespace reshade
 		variant(const char *value) : _values(1, value) { }
 		template <typename T>
 		variant(const T &value) : variant(std::to_string(value)) { }
-		template <>
-		variant(const bool &value) : variant(value ? "1" : "0") { }
-		template <>
-		variant(const std::string &value) : _values(1, value) { }
-		template <>
-		variant(const std::vector<std::string> &values) : _values(values) { }
 		variant(const std::vector<std::string> &&values) : _values(std::move(values)) { }
 		template<class InputIt>
 		variant(InputIt first, InputIt last) : _values(first, last) { }
-		template <>
-		variant(const filesystem::path &value) : variant(value.string()) { }
-		template <>
-		variant(const std::vector<filesystem::path> &values) : _values(values.size())
-		{
-			for (size_t i = 0; i < values.size(); i++)
-				_values[i] = values[i].string();
-		}
 		template <typename T>
 		variant(const T *values, size_t count) : _values(count)
 		{
 			for (size_t i = 0; i < count; i++)
 				_values[i] = std::to_string(values[i]);
 		}
-		template <>
-		variant(const bool *values, size_t count) : _values(count)
-		{
-			for (size_t i = 0; i < count; i++)
-				_values[i] = values[i] ? "1" : "0";
-		}
 		template <typename T, size_t COUNT>
 		variant(const T(&values)[COUNT]) : variant(values, COUNT) { }
 		template <typename T>
@@ -63,73 +43,94 @@ namespace reshade
 
 		template <typename T>
 		const T as(size_t index = 0) const;
-		template <>
-		const bool as(size_t i) const
-		{
-			return as<int>(i) != 0 || i < _values.size() && (_values[i] == "true" || _values[i] == "True" || _values[i] == "TRUE");
-		}
-		template <>
-		const int as(size_t i) const
-		{
-			return static_cast<int>(as<long>(i));
-		}
-		template <>
-		const unsigned int as(size_t i) const
-		{
-			return static_cast<unsigned int>(as<unsigned long>(i));
-		}
-		template <>
-		const long as(size_t i) const
-		{
-			if (i >= _values.size())
-			{
-				return 0l;
-			}
 
-			return std::strtol(_values[i].c_str(), nullptr, 10);
-		}
-		template <>
-		const unsigned long as(size_t i) const
-		{
-			if (i >= _values.size())
-			{
-				return 0ul;
-			}
+	private:
+		std::vector<std::string> _values;
+	};
 
-			return std::strtoul(_values[i].c_str(), nullptr, 10);
-		}
-		template <>
-		const float as(size_t i) const
+	template <>
+	inline variant::variant(const bool &value) : variant(value ? "1" : "0") { }
+	template <>
+	inline variant::variant(const std::string &value) : _values(1, value) { }
+	template <>
+	inline variant::variant(const std::vector<std::string> &values) : _values(values) { }
+	template <>
+	inline variant::variant(const filesystem::path &value) : variant(value.string()) { }
+	template <>
+	inline variant::variant(const std::vector<filesystem::path> &values) : _values(values.size())
+	{
+		for (size_t i = 0; i < values.size(); i++)
+			_values[i] = values[i].string();
+	}
+	template <>
+	inline variant::variant(const bool *values, size_t count) : _values(count)
+	{
+		for (size_t i = 0; i < count; i++)
+			_values[i] = values[i] ? "1" : "0";
+	}
+	template <>
+	inline const long variant::as<long>(size_t i) const
+	{
+		if (i >= _values.size())
 		{
-			return static_cast<float>(as<double>(i));
+			return 0l;
 		}
-		template <>
-		const double as(size_t i) const
-		{
-			if (i >= _values.size())
-			{
-				return 0.0;
-			}
 
-			return std::strtod(_values[i].c_str(), nullptr);
-		}
-		template <>
-		const std::string as(size_t i) const
+		return std::strtol(_values[i].c_str(), nullptr, 10);
+	}
+	template <>
+	inline const unsigned long variant::as<unsigned long>(size_t i) const
+	{
+		if (i >= _values.size())
 		{
-			if (i >= _values.size())
-			{
-				return std::string();
-			}
+			return 0ul;
+		}
 
-			return _values[i];
+		return std::strtoul(_values[i].c_str(), nullptr, 10);
+	}
+	template <>
+	inline const int variant::as<int>(size_t i) const
+	{
+		return static_cast<int>(as<long>(i));
+	}
+	template <>
+	inline const unsigned int variant::as<unsigned int>(size_t i) const
+	{
+		return static_cast<unsigned int>(as<unsigned long>(i));
+	}
+	template <>
+	inline const bool variant::as<bool>(size_t i) const
+	{
+		return as<int>(i) != 0 || i < _values.size() && (_values[i] == "true" || _values[i] == "True" || _values[i] == "TRUE");
+	}
+	template <>
+	inline const double variant::as<double>(size_t i) const
+	{
+		if (i >= _values.size())
+		{
+			return 0.0;
 		}
-		template <>
-		const filesystem::path as(size_t i) const
+
+		return std::strtod(_values[i].c_str(), nullptr);
+	}
+	template <>
+	inline const float variant::as<float>(size_t i) const
+	{
+		return static_cast<float>(as<double>(i));
+	}
+	template <>
+	inline const std::string variant::as<std::string>(size_t i) const
+	{
+		if (i >= _values.size())
 		{
-			return as<std::string>(i);
+			return std::string();
 		}
 
-	private:
-		std::vector<std::string> _values;
-	};
+		return _values[i];
+	}
+	template <>
+	inline const filesystem::path variant::as<filesystem::path>(size_t i) const
+	{
+		return as<std::string>(i);
+	}
 }
@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "worker_pool.hpp"
+#include <algorithm>
+
+namespace reshade
+{
+	// Leave one processor to the render thread, like the texture loader does
+	worker_pool::worker_pool(unsigned int num_threads) : _num_threads(num_threads != 0 ? num_threads : std::max(std::thread::hardware_concurrency(), 2u) - 1)
+	{
+	}
+	worker_pool::~worker_pool()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			_stop = true;
+		}
+
+		_task_available.notify_all();
+
+		for (auto &thread : _threads)
+		{
+			thread.join();
+		}
+	}
+
+	void worker_pool::push(std::function<void()> &&task)
+	{
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			_tasks.push_back(std::move(task));
+
+			// Only start another thread if all existing ones are busy, up to the limit
+			if (_threads.size() < _num_threads && _tasks.size() > _num_idle_threads)
+			{
+				_threads.emplace_back(&worker_pool::worker_main, this);
+			}
+		}
+
+		_task_available.notify_one();
+	}
+
+	void worker_pool::worker_main()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		while (true)
+		{
+			_num_idle_threads++;
+			_task_available.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+			_num_idle_threads--;
+
+			// Finish all queued tasks before stopping, since someone may be waiting on their results
+			if (_tasks.empty())
+			{
+				break;
+			}
+
+			std::function<void()> task = std::move(_tasks.front());
+			_tasks.pop_front();
+
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace reshade
+{
+	/// <summary>
+	/// A fixed number of worker threads that run queued tasks in the order they were submitted, so that submitting many tasks at once does not start a thread for each of them.
+	/// The threads are only started once the first task is submitted.
+	/// </summary>
+	class worker_pool
+	{
+	public:
+		/// <summary>
+		/// Construct a new worker pool.
+		/// </summary>
+		/// <param name="num_threads">The number of worker threads, or zero to use one less than the number of processors.</param>
+		explicit worker_pool(unsigned int num_threads = 0);
+		/// <summary>
+		/// Run all tasks that are still queued and stop the worker threads.
+		/// </summary>
+		~worker_pool();
+
+		/// <summary>
+		/// Returns the number of worker threads tasks are distributed to.
+		/// </summary>
+		unsigned int num_threads() const { return _num_threads; }
+
+		/// <summary>
+		/// Queue a task to run on one of the worker threads.
+		/// </summary>
+		/// <param name="task">The function to run.</param>
+		/// <returns>A future which receives the return value of the function once it ran.</returns>
+		template <typename F>
+		auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+		{
+			// Packaged tasks cannot be copied, which 'std::function' requires, so they are shared instead
+			const auto packaged_task = std::make_shared<std::packaged_task<std::invoke_result_t<std::decay_t<F>>()>>(std::forward<F>(task));
+			auto future = packaged_task->get_future();
+
+			push([packaged_task]() { (*packaged_task)(); });
+
+			return future;
+		}
+
+	private:
+		void push(std::function<void()> &&task);
+		void worker_main();
+
+		const unsigned int _num_threads;
+		bool _stop = false;
+		size_t _num_idle_threads = 0;
+		std::mutex _mutex;
+		std::condition_variable _task_available;
+		std::deque<std::function<void()>> _tasks;
+		std::vector<std::thread> _threads;
+	};
+}
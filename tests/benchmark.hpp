@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace reshade::benchmarks
+{
+	/// <summary>
+	/// Returns the number of iterations to run, which can be overridden with the first command-line argument.
+	/// </summary>
+	inline size_t iterations(int argc, char *argv[], size_t default_iterations)
+	{
+		return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : default_iterations;
+	}
+
+	/// <summary>
+	/// Call a function the specified number of times in each of several runs and print the time per call of the fastest and the median run.
+	/// </summary>
+	template <typename F>
+	double measure(const char *name, size_t iterations, F func, unsigned int runs = 5)
+	{
+		std::vector<double> results;
+
+		for (unsigned int run = 0; run < runs; run++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < iterations; i++)
+			{
+				func(i);
+			}
+
+			const auto duration = std::chrono::steady_clock::now() - start;
+
+			results.push_back(std::chrono::duration<double, std::nano>(duration).count() / std::max<size_t>(iterations, 1));
+		}
+
+		std::sort(results.begin(), results.end());
+
+		std::printf("%-48s %12.1f ns (median %12.1f ns) per call, %zu calls x %u runs\n", name, results.front(), results[results.size() / 2], iterations, runs);
+
+		return results[results.size() / 2];
+	}
+
+	/// <summary>
+	/// Keep the compiler from optimizing away a computation whose result is otherwise unused.
+	/// </summary>
+	template <typename T>
+	inline void do_not_optimize(const T &value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const T *sink;
+		sink = &value;
+#endif
+	}
+}
@@ -0,0 +1,59 @@
+// Several passes which all sample and write the back buffer, with the same states, followed by a pass into an intermediate texture
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+texture HalfTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA8; };
+sampler Half { Texture = HalfTex; };
+
+uniform float Strength = 0.5;
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float4 BrightenPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(BackBuffer, texcoord) * (1.0 + Strength * 0.1);
+}
+float4 DownsamplePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(BackBuffer, texcoord);
+}
+float4 CombinePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return lerp(tex2D(BackBuffer, texcoord), tex2D(Half, texcoord), Strength);
+}
+
+technique Chain < enabled = true; >
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = BrightenPS;
+	}
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = BrightenPS;
+	}
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = BrightenPS;
+	}
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget = HalfTex;
+	}
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+	}
+}
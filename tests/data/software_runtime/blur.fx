@@ -0,0 +1,70 @@
+// Downsamples the back buffer into a texture with a mipmap chain and blurs it with two separable passes
+// Covers render targets of a different size than the frame, linear filtering, mipmap generation and explicit level sampling
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+texture HalfTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; MipLevels = 3; };
+sampler Half { Texture = HalfTex; MinFilter = LINEAR; MagFilter = LINEAR; MipFilter = LINEAR; };
+texture BlurTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA8; };
+sampler Blur { Texture = BlurTex; MinFilter = LINEAR; MagFilter = LINEAR; AddressU = MIRROR; AddressV = CLAMP; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float4 DownsamplePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(BackBuffer, texcoord);
+}
+float4 BlurHorizontalPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float Weights[3] = { 0.38774, 0.24477, 0.06136 };
+
+	// Mix in the second level of the mipmap chain, which the runtime generated after the previous pass
+	float4 color = tex2Dlod(Half, float4(texcoord, 0, 0)) * Weights[0];
+	for (int i = 1; i < 3; i++)
+	{
+		const float2 offset = float2(i * 2.0 / (BUFFER_WIDTH / 2), 0.0);
+		color += tex2Dlod(Half, float4(texcoord + offset, 0, 0)) * Weights[i];
+		color += tex2Dlod(Half, float4(texcoord - offset, 0, 0)) * Weights[i];
+	}
+	return lerp(color, tex2Dlod(Half, float4(texcoord, 0, 1)), 0.25);
+}
+float4 BlurVerticalPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float Weights[3] = { 0.38774, 0.24477, 0.06136 };
+
+	float4 color = tex2D(Blur, texcoord) * Weights[0];
+	[unroll] for (int i = 1; i < 3; i++)
+	{
+		const float2 offset = float2(0.0, i * 2.0 / (BUFFER_HEIGHT / 2));
+		color += tex2D(Blur, texcoord + offset) * Weights[i];
+		color += tex2D(Blur, texcoord - offset) * Weights[i];
+	}
+	return float4(color.rgb, 1.0);
+}
+
+technique Blur < enabled = true; >
+{
+	pass Downsample
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget = HalfTex;
+	}
+	pass Horizontal
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = BlurHorizontalPS;
+		RenderTarget = BlurTex;
+	}
+	pass Vertical
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = BlurVerticalPS;
+	}
+}
@@ -0,0 +1,25 @@
+// Inverts the colors of the back buffer, so every pixel of the output can be checked against the input
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float4 InvertPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return float4(1.0 - tex2D(BackBuffer, texcoord).rgb, 1.0);
+}
+
+technique Invert < enabled = true; >
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = InvertPS;
+	}
+}
@@ -0,0 +1,67 @@
+// Procedural shading that exercises the shader language rather than the fixed function state
+// Covers uniforms with initial values, structs, arrays, matrices, loops with early exits, integer math, derivatives and sRGB writes
+
+#define ITERATIONS 24
+
+uniform float Scale < ui_type = "drag"; > = 2.5;
+uniform float3 Tint < ui_type = "color"; > = float3(0.9, 0.7, 0.4);
+uniform int Bands = 5;
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+struct Ray
+{
+	float2 origin;
+	float2 direction;
+};
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float Escape(float2 c)
+{
+	float2 z = 0.0;
+	for (int i = 0; i < ITERATIONS; i++)
+	{
+		z = float2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;
+		if (dot(z, z) > 4.0)
+			return i / float(ITERATIONS);
+	}
+	return 1.0;
+}
+
+float4 ShadingPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float2x2 rotation = float2x2(cos(0.5), -sin(0.5), sin(0.5), cos(0.5));
+
+	Ray ray;
+	ray.origin = float2(-0.6, 0.0);
+	ray.direction = mul(rotation, (texcoord - 0.5) * Scale);
+
+	const float value = Escape(ray.origin + ray.direction);
+
+	// Quantize into bands with integer math, and outline the band edges with screen space derivatives
+	const int band = int(value * Bands) % Bands;
+	const float edge = saturate(fwidth(value) * 8.0);
+
+	const float3 palette[3] = { float3(0.1, 0.2, 0.6), Tint, float3(1.0, 1.0, 1.0) };
+	float3 color = lerp(palette[band & 1], palette[2], smoothstep(0.0, 1.0, pow(value, 0.75)));
+	color = lerp(color, tex2D(BackBuffer, texcoord).rgb, (uint(position.x) / 4 + uint(position.y) / 4) % 3 == 0 ? 0.3 : 0.0);
+
+	return float4(color * (1.0 - edge), 1.0);
+}
+
+technique Shading < enabled = true; >
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = ShadingPS;
+		SRGBWriteEnable = true;
+	}
+}
@@ -0,0 +1,55 @@
+// Marks a pattern in the stencil buffer, then tints only the marked pixels with alpha blending and masks out a color channel
+// Covers discarding pixels, stencil writes and tests, blending and the color write mask
+
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+
+float4 MarkPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	// Keep a circle in the middle of the frame
+	const float2 center = texcoord - 0.5;
+	if (dot(center, center) > 0.09)
+		discard;
+	return 0.0;
+}
+float4 TintPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return float4(1.0, 0.5, 0.0, texcoord.x);
+}
+
+technique StencilBlend < enabled = true; >
+{
+	pass Mark
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = MarkPS;
+		// Keep the back buffer, which is otherwise cleared before the pass
+		ClearRenderTargets = false;
+		ColorWriteMask = 0;
+		StencilEnable = true;
+		StencilRef = 1;
+		StencilFunc = ALWAYS;
+		StencilPassOp = REPLACE;
+	}
+	pass Tint
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = TintPS;
+		ClearRenderTargets = false;
+		// Only write red and green
+		ColorWriteMask = 0x3;
+		BlendEnable = true;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+		StencilEnable = true;
+		StencilRef = 1;
+		StencilFunc = EQUAL;
+	}
+}
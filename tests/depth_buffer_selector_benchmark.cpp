@@ -0,0 +1,75 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "benchmark.hpp"
+#include <sstream>
+#include "depth_buffer_selector.hpp"
+
+using namespace reshade;
+
+int main(int argc, char *argv[])
+{
+	const size_t iterations = benchmarks::iterations(argc, argv, 20000);
+
+	// A long trace with a few stable depth buffers per frame and some that are recreated every few frames, like render targets of a streaming or resizing renderer
+	depth_buffer_trace trace;
+
+	for (uint32_t frame = 0; frame < 1000; frame++)
+	{
+		trace.begin_frame(1920, 1080);
+
+		for (uint32_t i = 0; i < 24; i++)
+		{
+			depth_buffer_stats stats;
+			stats.handle = 0x10000 + i * 0x100 + (i >= 16 ? (frame / 8) * 0x1000000 : 0);
+			stats.width = i % 3 == 0 ? 2048 : 1920;
+			stats.height = i % 3 == 0 ? 2048 : 1080;
+			stats.drawcalls = 10 + (i * 37 + frame) % 200;
+			stats.vertices = stats.drawcalls * (100 + (i * 13 + frame * 7) % 900);
+			trace.add_depth_buffer(stats);
+		}
+
+		trace.end_frame(4000);
+	}
+
+	depth_buffer_selector selector;
+	selector.settings().min_scale = 0.95f;
+	selector.settings().max_scale = 1.05f;
+
+	// Every call replays one frame of the trace
+	size_t frame_index = 0;
+	benchmarks::measure("depth_buffer_selector frame with 24 depth buffers", iterations, [&](size_t) {
+		const depth_buffer_trace::frame &frame = trace.frames()[frame_index++ % trace.frames().size()];
+
+		selector.begin_frame(frame.width, frame.height);
+		for (uint32_t i = 0; i < frame.num_depth_buffers; i++)
+			selector.add_depth_buffer(trace.depth_buffers(frame)[i]);
+		selector.end_frame(frame.total_drawcalls);
+
+		benchmarks::do_not_optimize(selector.selected());
+	});
+
+	// Writing the statistics to a trace while selecting, as the runtime does when 'DepthBufferTracePath' is set
+	std::ostringstream stream;
+	depth_buffer_trace recording;
+	recording.stream_to(&stream);
+	selector.record(&recording);
+
+	benchmarks::measure("depth_buffer_selector frame while streaming a trace", iterations, [&](size_t) {
+		const depth_buffer_trace::frame &frame = trace.frames()[frame_index++ % trace.frames().size()];
+
+		selector.begin_frame(frame.width, frame.height);
+		for (uint32_t i = 0; i < frame.num_depth_buffers; i++)
+			selector.add_depth_buffer(trace.depth_buffers(frame)[i]);
+		selector.end_frame(frame.total_drawcalls);
+
+		if (stream.tellp() > (64 << 20))
+			stream.str(std::string());
+	});
+
+	selector.record(nullptr);
+
+	return 0;
+}
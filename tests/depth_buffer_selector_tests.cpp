@@ -0,0 +1,311 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "depth_buffer_selector.hpp"
+#include <fstream>
+
+using namespace reshade;
+
+static depth_buffer_stats make_stats(uint64_t handle, uint32_t width, uint32_t height, uint32_t drawcalls, uint32_t vertices)
+{
+	depth_buffer_stats stats;
+	stats.handle = handle;
+	stats.width = width;
+	stats.height = height;
+	stats.format = 0x88F0;
+	stats.drawcalls = drawcalls;
+	stats.vertices = vertices;
+	return stats;
+}
+
+static void add_frame(depth_buffer_trace &trace, std::initializer_list<depth_buffer_stats> depth_buffers, uint32_t total_drawcalls = 1000)
+{
+	trace.begin_frame(1920, 1080);
+	for (const depth_buffer_stats &stats : depth_buffers)
+		trace.add_depth_buffer(stats);
+	trace.end_frame(total_drawcalls);
+}
+
+static bool equal(const depth_buffer_trace &a, const depth_buffer_trace &b)
+{
+	if (a.frames().size() != b.frames().size())
+		return false;
+
+	for (size_t i = 0; i < a.frames().size(); i++)
+	{
+		const depth_buffer_trace::frame &frame_a = a.frames()[i], &frame_b = b.frames()[i];
+
+		if (frame_a.width != frame_b.width || frame_a.height != frame_b.height || frame_a.total_drawcalls != frame_b.total_drawcalls || frame_a.num_depth_buffers != frame_b.num_depth_buffers)
+			return false;
+
+		for (uint32_t k = 0; k < frame_a.num_depth_buffers; k++)
+		{
+			const depth_buffer_stats &stats_a = a.depth_buffers(frame_a)[k], &stats_b = b.depth_buffers(frame_b)[k];
+
+			if (stats_a.handle != stats_b.handle || stats_a.width != stats_b.width || stats_a.height != stats_b.height ||
+				stats_a.format != stats_b.format || stats_a.drawcalls != stats_b.drawcalls || stats_a.vertices != stats_b.vertices)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+TEST_CASE(trace_round_trip)
+{
+	depth_buffer_trace trace;
+	add_frame(trace, { make_stats(0x123456789ABCDEF0ull, 1920, 1080, 900, 1500000), make_stats(2, 2048, 2048, 250, 600000) }, 1400);
+	add_frame(trace, { }, 10);
+	add_frame(trace, { make_stats(3, 0, 0, 1, 3) }, 0);
+
+	std::stringstream stream;
+	REQUIRE(trace.save(stream));
+
+	depth_buffer_trace loaded;
+	REQUIRE(loaded.load(stream));
+	CHECK(equal(trace, loaded));
+	CHECK_EQUAL(loaded.depth_buffers(loaded.frames()[0])[0].handle, 0x123456789ABCDEF0ull);
+}
+
+TEST_CASE(trace_load_rejects_invalid_data)
+{
+	depth_buffer_trace trace;
+	add_frame(trace, { make_stats(1, 1920, 1080, 900, 1500000) });
+
+	std::stringstream stream;
+	trace.save(stream);
+	const std::string data = stream.str();
+
+	depth_buffer_trace loaded;
+
+	std::istringstream wrong_magic("RSDX" + data.substr(4));
+	CHECK(!loaded.load(wrong_magic));
+
+	std::string wrong_version_data = data;
+	wrong_version_data[4] = 2;
+	std::istringstream wrong_version(wrong_version_data);
+	CHECK(!loaded.load(wrong_version));
+
+	// A frame which is cut off in the middle of a depth buffer
+	std::istringstream truncated(data.substr(0, data.size() - 3));
+	CHECK(!loaded.load(truncated));
+	CHECK(loaded.frames().empty());
+
+	// Just the header is a valid trace without any frames
+	std::istringstream header_only(data.substr(0, 8));
+	CHECK(loaded.load(header_only));
+	CHECK(loaded.frames().empty());
+}
+
+TEST_CASE(trace_streaming_matches_save)
+{
+	depth_buffer_trace expected;
+	add_frame(expected, { make_stats(1, 1920, 1080, 900, 1500000) });
+	add_frame(expected, { make_stats(1, 1920, 1080, 905, 1500100), make_stats(2, 960, 540, 4, 12) });
+	add_frame(expected, { make_stats(2, 960, 540, 5, 15) });
+
+	std::stringstream expected_stream;
+	expected.save(expected_stream);
+
+	// Start streaming after the first frame was already recorded in memory
+	depth_buffer_trace streamed;
+	add_frame(streamed, { make_stats(1, 1920, 1080, 900, 1500000) });
+
+	std::stringstream stream;
+	REQUIRE(streamed.stream_to(&stream));
+	CHECK(streamed.frames().empty());
+
+	add_frame(streamed, { make_stats(1, 1920, 1080, 905, 1500100), make_stats(2, 960, 540, 4, 12) });
+	// Finished frames are not kept in memory while streaming
+	CHECK(streamed.frames().empty());
+	add_frame(streamed, { make_stats(2, 960, 540, 5, 15) });
+
+	streamed.stream_to(nullptr);
+	add_frame(streamed, { make_stats(3, 1, 1, 1, 1) });
+	CHECK_EQUAL(streamed.frames().size(), 1u);
+
+	CHECK(stream.str() == expected_stream.str());
+}
+
+TEST_CASE(recording_while_selecting)
+{
+	depth_buffer_trace trace;
+	depth_buffer_selector selector;
+	selector.record(&trace);
+
+	selector.begin_frame(1920, 1080);
+	selector.add_depth_buffer(make_stats(1, 1920, 1080, 10, 100));
+	selector.end_frame(20);
+	selector.record(nullptr);
+	selector.begin_frame(1920, 1080);
+	selector.end_frame(20);
+
+	REQUIRE(trace.frames().size() == 1);
+	CHECK_EQUAL(trace.frames()[0].total_drawcalls, 20u);
+	CHECK_EQUAL(trace.depth_buffers(trace.frames()[0])[0].handle, 1u);
+}
+
+TEST_CASE(replay_sample_trace)
+{
+	// Synthetic recording of a deferred renderer at 1920x1080 with a 2048x2048 shadow map (0x1000), the scene depth (0x2000) and a user interface pass (0x3000).
+	// After 80 frames the window is resized to 1280x720, which replaces the screen sized depth buffers with new ones (0x4000 and 0x5000).
+	std::ifstream file(tests::data_path("depth_buffer_trace_sample.bin"), std::ios::binary);
+
+	depth_buffer_trace trace;
+	REQUIRE(trace.load(file));
+	REQUIRE(trace.frames().size() == 120);
+
+	// Same settings as the OpenGL runtime, which only accepts depth buffers of the size of the back buffer
+	depth_buffer_selector selector;
+	selector.settings().min_scale = 0.95f;
+	selector.settings().max_scale = 1.05f;
+
+	std::vector<uint64_t> selections;
+	selector.replay(trace, &selections);
+	REQUIRE(selections.size() == 120);
+
+	// The shadow map has more vertices per draw call, but does not match the back buffer dimensions
+	for (size_t i = 0; i < 80; i++)
+		CHECK_EQUAL(selections[i], 0x2000u);
+	// The old scene depth buffer is no longer used, so its score starts to fade in the next frame and the new one takes over once it was ahead for 'switch_frames' frames
+	CHECK_EQUAL(selections[80], 0x2000u);
+	CHECK_EQUAL(selections[81], 0x2000u);
+	for (size_t i = 82; i < 120; i++)
+		CHECK_EQUAL(selections[i], 0x4000u);
+}
+
+TEST_CASE(replay_is_deterministic)
+{
+	std::ifstream file(tests::data_path("depth_buffer_trace_sample.bin"), std::ios::binary);
+
+	depth_buffer_trace trace;
+	REQUIRE(trace.load(file));
+
+	std::vector<uint64_t> selections_a, selections_b;
+	depth_buffer_selector().replay(trace, &selections_a);
+	depth_buffer_selector().replay(trace, &selections_b);
+
+	CHECK(selections_a == selections_b);
+}
+
+TEST_CASE(hysteresis_needs_consecutive_frames)
+{
+	depth_buffer_selector_settings settings;
+	settings.smoothing = 1.0f; // No smoothing, so that scores equal the statistics of the current frame
+	settings.switch_threshold = 1.5f;
+	settings.switch_frames = 3;
+
+	depth_buffer_trace trace;
+	// Frame 0: A is the only depth buffer, so it is selected right away
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000) });
+	// Frames 1 and 2: B is better, but not for long enough
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 20000) });
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 20000) });
+	// Frame 3: B falls back, which resets its streak
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 10000) });
+	// Frames 4 to 6: B is better for three consecutive frames
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 20000) });
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 20000) });
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 20000) });
+	// Frames 7 to 9: C is better than B, but not by the threshold
+	add_frame(trace, { make_stats(2, 1920, 1080, 100, 20000), make_stats(3, 1920, 1080, 100, 29000) });
+	add_frame(trace, { make_stats(2, 1920, 1080, 100, 20000), make_stats(3, 1920, 1080, 100, 29000) });
+	add_frame(trace, { make_stats(2, 1920, 1080, 100, 20000), make_stats(3, 1920, 1080, 100, 29000) });
+
+	std::vector<uint64_t> selections;
+	depth_buffer_selector(settings).replay(trace, &selections);
+
+	const std::vector<uint64_t> expected = { 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 };
+	CHECK(selections == expected);
+}
+
+TEST_CASE(filters_by_scale_and_aspect_ratio)
+{
+	depth_buffer_selector_settings settings;
+	settings.max_aspect_ratio_difference = 0.1f;
+	settings.min_scale = 1.0f;
+	settings.max_scale = 2.0f;
+
+	depth_buffer_trace trace;
+	add_frame(trace, {
+		make_stats(1, 2048, 2048, 10, 90000), // Wrong aspect ratio
+		make_stats(2, 3840, 2160, 10, 80000), // Larger than the back buffer
+		make_stats(3, 480, 270, 10, 70000), // Less than half the size of the back buffer
+		make_stats(4, 960, 540, 10, 10000),
+		make_stats(5, 0, 0, 10, 5000), // Unknown dimensions are not filtered
+	});
+
+	std::vector<uint64_t> selections;
+	depth_buffer_selector(settings).replay(trace, &selections);
+
+	CHECK_EQUAL(selections[0], 4u);
+}
+
+TEST_CASE(expiry_forgets_unused_depth_buffers)
+{
+	// B is seen once, disappears and comes back with a score which is between the smoothed score it would have if it was still remembered and its actual score.
+	// Only a selector which forgot about B in the meantime takes its score as is and switches right away.
+	depth_buffer_trace trace;
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 1000) });
+	for (int i = 0; i < 8; i++)
+		add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000) });
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000), make_stats(2, 1920, 1080, 100, 14000) });
+
+	depth_buffer_selector_settings settings;
+	settings.smoothing = 0.5f;
+	settings.switch_threshold = 1.1f;
+	settings.switch_frames = 1;
+
+	settings.expire_frames = 4;
+	std::vector<uint64_t> selections_with_expiry;
+	depth_buffer_selector(settings).replay(trace, &selections_with_expiry);
+
+	settings.expire_frames = 0;
+	std::vector<uint64_t> selections_without_expiry;
+	depth_buffer_selector(settings).replay(trace, &selections_without_expiry);
+
+	CHECK_EQUAL(selections_with_expiry.back(), 2u);
+	CHECK_EQUAL(selections_without_expiry.back(), 1u);
+}
+
+TEST_CASE(expiry_keeps_the_selection)
+{
+	depth_buffer_selector_settings settings;
+	settings.expire_frames = 2;
+
+	depth_buffer_trace trace;
+	add_frame(trace, { make_stats(1, 1920, 1080, 100, 10000) });
+	for (int i = 0; i < 10; i++)
+		add_frame(trace, { });
+
+	std::vector<uint64_t> selections;
+	depth_buffer_selector(settings).replay(trace, &selections);
+
+	CHECK_EQUAL(selections.back(), 1u);
+}
+
+TEST_CASE(remove_deselects)
+{
+	depth_buffer_selector selector;
+	selector.begin_frame(1920, 1080);
+	for (uint64_t handle = 1; handle <= 100; handle++)
+		selector.add_depth_buffer(make_stats(handle, 1920, 1080, 10, handle == 42 ? 100000 : 1000));
+	selector.end_frame(1000);
+
+	REQUIRE(selector.has_selection());
+	CHECK_EQUAL(selector.selected(), 42u);
+
+	selector.remove_depth_buffer(7);
+	CHECK_EQUAL(selector.selected(), 42u);
+	selector.remove_depth_buffer(42);
+	CHECK(!selector.has_selection());
+
+	// The remaining depth buffers can still be found after the table was rebuilt
+	selector.begin_frame(1920, 1080);
+	selector.add_depth_buffer(make_stats(100, 1920, 1080, 10, 50000));
+	selector.end_frame(1000);
+	CHECK_EQUAL(selector.selected(), 100u);
+}
@@ -0,0 +1,292 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "effect_parser.hpp"
+#include "effect_uniform_usage.hpp"
+
+using namespace reshadefx;
+
+// Parses the uniform declarations and returns them in declaration order, which is the order the layout functions put them into the block
+static std::vector<const nodes::variable_declaration_node *> parse_uniforms(syntax_tree &ast, const std::string &source)
+{
+	parser parser(ast);
+	CHECK(parser.run(source));
+
+	return std::vector<const nodes::variable_declaration_node *>(ast.variables.begin(), ast.variables.end());
+}
+
+// Uniform storage is packed tightly, so every variable follows directly after the previous one
+static std::vector<size_t> tight_storage_offsets(const std::vector<const nodes::variable_declaration_node *> &uniforms)
+{
+	std::vector<size_t> offsets;
+	size_t offset = 0;
+
+	for (auto uniform : uniforms)
+	{
+		offsets.push_back(offset);
+		offset += uniform_storage_size(uniform);
+	}
+
+	return offsets;
+}
+
+static bool equal(const reshade::uniform_copy_range &range, size_t storage_offset, size_t block_offset, size_t size)
+{
+	return range.storage_offset == storage_offset && range.block_offset == block_offset && range.size == size;
+}
+
+TEST_CASE(storage_size)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float3 b; uniform float2 c[3]; uniform float3x3 d; uniform int4 e;");
+
+	CHECK_EQUAL(uniform_storage_size(uniforms[0]), 4u);
+	CHECK_EQUAL(uniform_storage_size(uniforms[1]), 12u);
+	CHECK_EQUAL(uniform_storage_size(uniforms[2]), 24u);
+	CHECK_EQUAL(uniform_storage_size(uniforms[3]), 36u);
+	CHECK_EQUAL(uniform_storage_size(uniforms[4]), 16u);
+}
+
+TEST_CASE(constant_buffer_float3_and_scalar)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float3 a; uniform float b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	// The scalar fills the remaining component of the register
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 12u);
+	CHECK_EQUAL(layout.size, 16u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 1);
+	CHECK(equal(ranges[0], 0, 0, 16));
+}
+
+TEST_CASE(constant_buffer_straddling_vector)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float2 a; uniform float3 b; uniform float c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	// The vector would cross into the next register, so it has to start a new one
+	REQUIRE(layout.offsets.size() == 3);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.offsets[2], 28u);
+	CHECK_EQUAL(layout.size, 32u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 2);
+	CHECK(equal(ranges[0], 0, 0, 8));
+	CHECK(equal(ranges[1], 8, 16, 16));
+}
+
+TEST_CASE(constant_buffer_array)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float2 b[3]; uniform float c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	// Every array element starts a new register, but the scalar after it may use the rest of the last one
+	REQUIRE(layout.offsets.size() == 3);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.offsets[2], 56u);
+	CHECK_EQUAL(layout.size, 64u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 4);
+	CHECK(equal(ranges[0], 0, 0, 4));
+	CHECK(equal(ranges[1], 4, 16, 8));
+	CHECK(equal(ranges[2], 12, 32, 8));
+	CHECK(equal(ranges[3], 20, 48, 12));
+}
+
+TEST_CASE(constant_buffer_single_element_array)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float b[1];");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.size, 32u);
+}
+
+TEST_CASE(constant_buffer_full_registers)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float4 a[2]; uniform float4x4 b; uniform float c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	REQUIRE(layout.offsets.size() == 3);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 32u);
+	CHECK_EQUAL(layout.offsets[2], 96u);
+	CHECK_EQUAL(layout.size, 112u);
+
+	// Registers without padding are copied in one go
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 1);
+	CHECK(equal(ranges[0], 0, 0, 100));
+}
+
+TEST_CASE(constant_buffer_matrix)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float3x3 a; uniform float b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 44u);
+	CHECK_EQUAL(layout.size, 48u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 3);
+	CHECK(equal(ranges[0], 0, 0, 12));
+	CHECK(equal(ranges[1], 12, 16, 12));
+	CHECK(equal(ranges[2], 24, 32, 16));
+}
+
+TEST_CASE(constant_registers_float3_and_scalar)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float3 a; uniform float b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_registers);
+
+	// Every variable gets a register of its own
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.size, 32u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 2);
+	CHECK(equal(ranges[0], 0, 0, 12));
+	CHECK(equal(ranges[1], 12, 16, 4));
+}
+
+TEST_CASE(constant_registers_array)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float2 b[3]; uniform float c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_registers);
+
+	REQUIRE(layout.offsets.size() == 3);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.offsets[2], 64u);
+	CHECK_EQUAL(layout.size, 80u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 5);
+	CHECK(equal(ranges[1], 4, 16, 8));
+	CHECK(equal(ranges[3], 20, 48, 8));
+	CHECK(equal(ranges[4], 28, 64, 4));
+}
+
+TEST_CASE(constant_registers_matrix)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float4x4 a; uniform float4 b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_registers);
+
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[1], 64u);
+	CHECK_EQUAL(layout.size, 80u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 1);
+	CHECK(equal(ranges[0], 0, 0, 80));
+}
+
+TEST_CASE(std140_float3_and_scalar)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float3 a; uniform float b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::std140);
+
+	// A scalar may follow a three-component vector in the same register
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 12u);
+	CHECK_EQUAL(layout.size, 16u);
+}
+
+TEST_CASE(std140_vector_alignment)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float2 b; uniform float c; uniform float3 d; uniform float4 e;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::std140);
+
+	REQUIRE(layout.offsets.size() == 5);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 8u);
+	CHECK_EQUAL(layout.offsets[2], 16u);
+	CHECK_EQUAL(layout.offsets[3], 32u);
+	CHECK_EQUAL(layout.offsets[4], 48u);
+	CHECK_EQUAL(layout.size, 64u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 4);
+	CHECK(equal(ranges[0], 0, 0, 4));
+	CHECK(equal(ranges[1], 4, 8, 12));
+	CHECK(equal(ranges[2], 16, 32, 12));
+	CHECK(equal(ranges[3], 28, 48, 16));
+}
+
+TEST_CASE(std140_array)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float a; uniform float2 b[3]; uniform float c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::std140);
+
+	// Arrays are padded to a whole number of registers, so the scalar after it cannot use the rest of the last one
+	REQUIRE(layout.offsets.size() == 3);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 16u);
+	CHECK_EQUAL(layout.offsets[2], 64u);
+	CHECK_EQUAL(layout.size, 68u);
+
+	const auto ranges = build_uniform_copy_ranges(layout, tight_storage_offsets(uniforms));
+	REQUIRE(ranges.size() == 5);
+	CHECK(equal(ranges[1], 4, 16, 8));
+	CHECK(equal(ranges[2], 12, 32, 8));
+	CHECK(equal(ranges[3], 20, 48, 8));
+	CHECK(equal(ranges[4], 28, 64, 4));
+}
+
+TEST_CASE(std140_matrix)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float3x3 a; uniform float b;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::std140);
+
+	REQUIRE(layout.offsets.size() == 2);
+	CHECK_EQUAL(layout.offsets[0], 0u);
+	CHECK_EQUAL(layout.offsets[1], 48u);
+	CHECK_EQUAL(layout.size, 52u);
+}
+
+TEST_CASE(copy_ranges_follow_storage_order)
+{
+	syntax_tree ast;
+	const auto uniforms = parse_uniforms(ast, "uniform float4 a; uniform float4 b; uniform float4 c;");
+	const auto layout = layout_uniform_block(uniforms, uniform_packing::constant_buffer);
+
+	// A technique that only references some uniforms gets a block whose variables are not adjacent in storage
+	const auto ranges = build_uniform_copy_ranges(layout, { 0, 32, 48 });
+	REQUIRE(ranges.size() == 2);
+	CHECK(equal(ranges[0], 0, 0, 16));
+	CHECK(equal(ranges[1], 32, 16, 32));
+
+	// Variables adjacent in the block but not in storage order are copied separately
+	const auto reversed_ranges = build_uniform_copy_ranges(layout, { 32, 16, 0 });
+	CHECK_EQUAL(reversed_ranges.size(), 3u);
+}
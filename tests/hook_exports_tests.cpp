@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "hook_exports.hpp"
+#include <string>
+
+using namespace reshade;
+using namespace reshade::hooks;
+
+// Fake function addresses, which are only compared and never called
+static hook::address address_of(uintptr_t value)
+{
+	return reinterpret_cast<hook::address>(value);
+}
+
+TEST_CASE(match_by_name)
+{
+	const std::vector<module_export> target_exports = {
+		{ address_of(0x1000), "CreateDXGIFactory", 1 },
+		{ address_of(0x1010), "CreateDXGIFactory1", 2 },
+		{ address_of(0x1020), "CreateDXGIFactory2", 3 },
+		{ address_of(0x1030), "DXGIGetDebugInterface1", 4 },
+	};
+	// Export tables are sorted by name, but the matching must not rely on it
+	const std::vector<module_export> replacement_exports = {
+		{ address_of(0x2020), "CreateDXGIFactory2", 7 },
+		{ address_of(0x2000), "CreateDXGIFactory", 5 },
+		{ address_of(0x2030), "D3D11CreateDevice", 8 },
+		{ address_of(0x2010), "CreateDXGIFactory1", 6 },
+	};
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	// Matches are returned in the order of the target export table
+	REQUIRE(matches.size() == 3);
+	CHECK(std::string(matches[0].first.name) == "CreateDXGIFactory");
+	CHECK(matches[0].first.address == address_of(0x1000));
+	CHECK(matches[0].second == address_of(0x2000));
+	CHECK(std::string(matches[1].first.name) == "CreateDXGIFactory1");
+	CHECK(matches[1].second == address_of(0x2010));
+	CHECK(std::string(matches[2].first.name) == "CreateDXGIFactory2");
+	CHECK(matches[2].first.ordinal == 3);
+	CHECK(matches[2].second == address_of(0x2020));
+}
+
+TEST_CASE(skip_null_names_and_addresses)
+{
+	const std::vector<module_export> target_exports = {
+		{ address_of(0x1000), nullptr, 1 },
+		{ nullptr, "Direct3DCreate9", 2 },
+		{ address_of(0x1020), "Direct3DCreate9Ex", 3 },
+	};
+	// Exports by ordinal only have no name
+	const std::vector<module_export> replacement_exports = {
+		{ address_of(0x2000), nullptr, 1 },
+		{ address_of(0x2010), "Direct3DCreate9", 2 },
+		{ address_of(0x2020), nullptr, 3 },
+		{ address_of(0x2030), "Direct3DCreate9Ex", 4 },
+	};
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	REQUIRE(matches.size() == 1);
+	CHECK(std::string(matches[0].first.name) == "Direct3DCreate9Ex");
+	CHECK(matches[0].second == address_of(0x2030));
+}
+
+TEST_CASE(skip_filtered_functions)
+{
+	const std::vector<module_export> target_exports = {
+		{ address_of(0x1000), "CreateDXGIFactory", 1 },
+		{ address_of(0x1010), "DXGIDumpJournal", 2 },
+		{ address_of(0x1020), "DXGIReportAdapterConfiguration", 3 },
+	};
+	const std::vector<module_export> replacement_exports = {
+		{ address_of(0x2000), "DXGIReportAdapterConfiguration", 1 },
+		{ address_of(0x2010), "DXGIDumpJournal", 2 },
+		{ address_of(0x2020), "CreateDXGIFactory", 3 },
+	};
+
+	// These two are exported by the replacement too, but must never be hooked
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	REQUIRE(matches.size() == 1);
+	CHECK(std::string(matches[0].first.name) == "CreateDXGIFactory");
+}
+
+TEST_CASE(no_partial_name_matches)
+{
+	const std::vector<module_export> target_exports = {
+		{ address_of(0x1000), "glBegin", 1 },
+		{ address_of(0x1010), "glBindTexture", 2 },
+		{ address_of(0x1020), "glZ", 3 },
+	};
+	const std::vector<module_export> replacement_exports = {
+		{ address_of(0x2000), "glBeginQuery", 1 },
+		{ address_of(0x2010), "glBind", 2 },
+	};
+
+	CHECK(match_exports(target_exports, replacement_exports).empty());
+	CHECK(match_exports(target_exports, {}).empty());
+	CHECK(match_exports({}, replacement_exports).empty());
+}
+
+TEST_CASE(many_exports)
+{
+	// An export table the size of the OpenGL one, with a replacement for every other function in reverse order
+	std::vector<std::string> names;
+	for (unsigned int i = 0; i < 400; i++)
+		names.push_back("glFunction" + std::to_string(i));
+
+	std::vector<module_export> target_exports, replacement_exports;
+	for (unsigned int i = 0; i < names.size(); i++)
+		target_exports.push_back({ address_of(0x10000 + i), names[i].c_str(), static_cast<unsigned short>(i) });
+	for (unsigned int i = static_cast<unsigned int>(names.size()); i-- > 0;)
+		if (i % 2 == 0)
+			replacement_exports.push_back({ address_of(0x20000 + i), names[i].c_str(), static_cast<unsigned short>(i) });
+
+	const auto matches = match_exports(target_exports, replacement_exports);
+
+	REQUIRE(matches.size() == 200);
+	bool all_correct = true;
+	for (size_t k = 0; k < matches.size(); k++)
+		all_correct &= matches[k].first.ordinal == k * 2 && matches[k].second == address_of(0x20000 + k * 2);
+	CHECK(all_correct);
+}
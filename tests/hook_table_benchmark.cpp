@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "benchmark.hpp"
+#include "hook_table.hpp"
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+using namespace reshade;
+using namespace reshade::hooks;
+
+// ReShade replaces 371 OpenGL functions, so use as many distinct functions as replacements
+static const size_t num_stubs = 371;
+
+template <size_t I>
+static void stub()
+{
+	benchmarks::do_not_optimize(I);
+}
+template <size_t... I>
+static std::vector<hook::address> make_stubs(std::index_sequence<I...>)
+{
+	return { reinterpret_cast<hook::address>(&stub<I>)... };
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t iterations = benchmarks::iterations(argc, argv, 2000000);
+
+	const std::vector<hook::address> replacements = make_stubs(std::make_index_sequence<num_stubs>());
+
+	std::vector<hook> hooks;
+	hook_table table;
+	for (size_t i = 0; i < num_stubs; i++)
+	{
+		const hook hook = { reinterpret_cast<hook::address>(0x10000 + i * 16), reinterpret_cast<hook::address>(0x20000 + i * 16), replacements[i] };
+		hooks.push_back(hook);
+		table.insert(hook);
+	}
+
+	// Stubs are called in an order unrelated to their installation, e.g. whatever the application calls next
+	std::vector<size_t> order(4096);
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = (i * 7919) % num_stubs;
+
+	// What 'reshade::hooks::call' did before the table, for comparison: lock and search the list of installed hooks
+	std::mutex mutex;
+	benchmarks::measure("hooks locked linear search", iterations / 10, [&](size_t i) {
+		const hook::address replacement = replacements[order[i % order.size()]];
+		const std::lock_guard<std::mutex> lock(mutex);
+		const auto it = std::find_if(hooks.begin(), hooks.end(), [replacement](const hook &hook) { return hook.replacement == replacement; });
+		benchmarks::do_not_optimize(it->trampoline);
+	});
+
+	benchmarks::measure("hook_table find", iterations, [&](size_t i) {
+		benchmarks::do_not_optimize(table.find(replacements[order[i % order.size()]]).trampoline);
+	});
+
+	// Several threads resolving trampolines at once, which all update the counter of running lookups
+	for (unsigned int num_threads : { 2u, 4u })
+	{
+		char name[64];
+		std::snprintf(name, sizeof(name), "hook_table find on %u threads", num_threads);
+
+		const double duration = benchmarks::measure(name, 1, [&](size_t) {
+			std::vector<std::thread> threads;
+			for (unsigned int thread = 0; thread < num_threads; thread++)
+			{
+				threads.emplace_back([&, thread]() {
+					for (size_t i = 0; i < iterations; i++)
+						benchmarks::do_not_optimize(table.find(replacements[order[(i + thread * 1000) % order.size()]]).trampoline);
+				});
+			}
+			for (std::thread &thread : threads)
+				thread.join();
+		});
+
+		std::printf("%-48s %12.1f ns per lookup on each thread\n", "", duration / iterations);
+	}
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "hook_table.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace reshade;
+using namespace reshade::hooks;
+
+// Fake function addresses, which are only compared and never called
+static hook::address address_of(uintptr_t value)
+{
+	return reinterpret_cast<hook::address>(value);
+}
+static hook make_hook(uintptr_t index)
+{
+	return hook { address_of(0x10000 + index * 16), address_of(0x20000 + index * 16), address_of(0x30000 + index * 16) };
+}
+
+TEST_CASE(find_inserted_hooks)
+{
+	hook_table table;
+	CHECK(table.find(address_of(0x30000)).replacement == nullptr);
+
+	for (uintptr_t i = 0; i < 10; i++)
+		CHECK(table.insert(make_hook(i)));
+	CHECK_EQUAL(table.size(), size_t(10));
+
+	const hook result = table.find(make_hook(7).replacement);
+	CHECK(result.target == make_hook(7).target);
+	CHECK(result.trampoline == make_hook(7).trampoline);
+	CHECK(result.replacement == make_hook(7).replacement);
+
+	// Replacements that were never installed are not found
+	CHECK(table.find(address_of(0x12345)).trampoline == nullptr);
+}
+
+TEST_CASE(first_hook_for_replacement_wins)
+{
+	hook_table table;
+
+	hook second = make_hook(1);
+	second.trampoline = address_of(0x99990);
+
+	CHECK(table.insert(make_hook(1)));
+	CHECK(!table.insert(second));
+	CHECK_EQUAL(table.size(), size_t(1));
+	CHECK(table.find(second.replacement).trampoline == make_hook(1).trampoline);
+}
+
+TEST_CASE(grow_keeps_all_hooks)
+{
+	hook_table table;
+
+	// More than fits into the initial table at half load, so it has to be copied into larger ones several times
+	for (uintptr_t i = 0; i < 3000; i++)
+		table.insert(make_hook(i));
+
+	bool all_found = true;
+	for (uintptr_t i = 0; i < 3000; i++)
+		all_found &= table.find(make_hook(i).replacement).trampoline == make_hook(i).trampoline;
+	CHECK(all_found);
+	CHECK_EQUAL(table.size(), size_t(3000));
+}
+
+TEST_CASE(clear_and_reuse)
+{
+	hook_table table;
+
+	for (uintptr_t i = 0; i < 100; i++)
+		table.insert(make_hook(i));
+
+	table.clear();
+	CHECK_EQUAL(table.size(), size_t(0));
+	CHECK(table.find(make_hook(5).replacement).trampoline == nullptr);
+
+	// Installing again after uninstalling starts a new table
+	CHECK(table.insert(make_hook(5)));
+	CHECK(table.find(make_hook(5).replacement).trampoline == make_hook(5).trampoline);
+}
+
+TEST_CASE(lookups_while_growing_and_clearing)
+{
+	hook_table table;
+	for (uintptr_t i = 0; i < 64; i++)
+		table.insert(make_hook(i));
+
+	// Hooked calls keep resolving their trampolines on other threads while hooks are installed and uninstalled
+	std::atomic<bool> stop = false, wrong_result = false;
+	std::vector<std::thread> readers;
+	for (int thread = 0; thread < 3; thread++)
+	{
+		readers.emplace_back([&]() {
+			for (uintptr_t i = 0; !stop.load(std::memory_order_relaxed); i = (i + 1) % 64)
+			{
+				// A lookup either finds the right hook or none at all after the table was cleared
+				const hook result = table.find(make_hook(i).replacement);
+				if (result.trampoline != nullptr && result.trampoline != make_hook(i).trampoline)
+					wrong_result = true;
+			}
+		});
+	}
+
+	for (int pass = 0; pass < 20; pass++)
+	{
+		for (uintptr_t i = 0; i < 2000; i++)
+			table.insert(make_hook(i));
+		table.clear();
+		for (uintptr_t i = 0; i < 64; i++)
+			table.insert(make_hook(i));
+	}
+
+	stop = true;
+	for (std::thread &reader : readers)
+		reader.join();
+
+	CHECK(!wrong_result);
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "benchmark.hpp"
+#include "ini_file.hpp"
+#include <fstream>
+#include <filesystem>
+
+using namespace reshade;
+
+int main(int argc, char *argv[])
+{
+	const size_t iterations = benchmarks::iterations(argc, argv, 2000);
+
+	// 500 presets for 40 effects with 30 variables each, like a large preset collection
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_ini_file_benchmark";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	std::vector<filesystem::path> presets;
+	for (int i = 0; i < 500; i++)
+	{
+		presets.push_back((directory / ("Preset" + std::to_string(i) + ".ini")).string());
+
+		std::ofstream file(presets.back().string());
+		file << "Techniques=";
+		for (int effect = 0; effect < 40; effect++)
+			file << (effect != 0 ? "," : "") << "Technique" << effect;
+		file << "\nKeyTechnique3=46,0,0,0\n\n";
+
+		for (int effect = 0; effect < 40; effect++)
+		{
+			file << "[Effect" << effect << ".fx]\n";
+			for (int variable = 0; variable < 30; variable++)
+				file << "Variable" << variable << '=' << (i + variable) * 0.125f << ',' << effect << ",1.000000\n";
+			file << '\n';
+		}
+	}
+
+	std::vector<std::string> sections, keys;
+	for (int effect = 0; effect < 40; effect++)
+		sections.push_back("Effect" + std::to_string(effect) + ".fx");
+	for (int variable = 0; variable < 30; variable++)
+		keys.push_back("Variable" + std::to_string(variable));
+
+	// Read every value of a preset, as the runtime does when compiling a preset image
+	const auto read_preset = [&sections, &keys](const ini_file &preset) {
+		std::vector<std::string_view> techniques;
+		preset.get("", "Techniques", techniques);
+		benchmarks::do_not_optimize(techniques);
+
+		for (const std::string &section : sections)
+		{
+			for (const std::string &key : keys)
+			{
+				float values[16];
+				preset.get(section, key, values);
+				benchmarks::do_not_optimize(values);
+			}
+		}
+	};
+
+	// Switching through all presets, which is more than the cache holds, so every file is read from disk again
+	benchmarks::measure("ini_file open preset (not cached)", iterations, [&](size_t i) {
+		const ini_file preset(presets[i % presets.size()]);
+		benchmarks::do_not_optimize(preset);
+	});
+	benchmarks::measure("ini_file open preset (cached)", iterations, [&](size_t) {
+		const ini_file preset(presets[0]);
+		benchmarks::do_not_optimize(preset);
+	});
+
+	const ini_file preset(presets[0]);
+	benchmarks::measure("ini_file read 1200 values", iterations, [&](size_t) {
+		read_preset(preset);
+	});
+
+	// Changing a value and saving, which writes the file on the next flush
+	benchmarks::measure("ini_file save changed preset", iterations / 10, [&](size_t i) {
+		ini_file preset(presets[i % 10]);
+		preset.set("Effect0.fx", "Variable0", static_cast<int>(i));
+	});
+	benchmarks::measure("ini_file save changed preset and flush", iterations / 10, [&](size_t i) {
+		{
+			ini_file preset(presets[i % 10]);
+			preset.set("Effect0.fx", "Variable0", static_cast<int>(i));
+		}
+		ini_file::flush_cache();
+	});
+	// Saving the same preset several times per frame, e.g. while dragging a slider, only writes it once
+	benchmarks::measure("ini_file save 8 times per frame and flush", iterations / 10, [&](size_t i) {
+		for (int k = 0; k < 8; k++)
+		{
+			ini_file preset(presets[0]);
+			preset.set("Effect0.fx", "Variable0", static_cast<int>(i * 8 + k));
+		}
+		ini_file::flush_cache();
+	});
+
+	ini_file::clear_cache();
+	std::filesystem::remove_all(directory);
+}
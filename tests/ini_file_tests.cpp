@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "log.hpp"
+#include "ini_file.hpp"
+#include <fstream>
+#include <sstream>
+
+using namespace reshade;
+
+static void write_file(const std::string &path, const std::string &text)
+{
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	file << text;
+}
+static std::string read_file(const std::string &path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	std::ostringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+TEST_CASE(read_values)
+{
+	const std::string path = tests::temp_path("read_values.ini");
+	write_file(path,
+		"Global=1\n"
+		"; A comment\n"
+		"[GENERAL]\n"
+		"Count = 42 \n"
+		"Negative=-7\r\n"
+		"Scale=0.5\n"
+		"Enabled=true\n"
+		"Name=Hello World\n"
+		"Keys=112,0,1\n"
+		"Paths=C:\\a,C:\\b\n"
+		"Flag\n"
+		"Empty=\n"
+		"Count=43\n");
+
+	const ini_file file(path);
+
+	int global = 0, count = 0, negative = 0, flag = 1;
+	float scale = 0.0f;
+	bool enabled = false;
+	std::string name;
+	unsigned int keys[4] = { 9, 9, 9, 9 };
+	std::vector<filesystem::path> paths;
+	std::vector<std::string> empty = { "x" };
+	file.get("", "Global", global);
+	file.get("GENERAL", "Count", count);
+	file.get("GENERAL", "Negative", negative);
+	file.get("GENERAL", "Scale", scale);
+	file.get("GENERAL", "Enabled", enabled);
+	file.get("GENERAL", "Name", name);
+	file.get("GENERAL", "Keys", keys);
+	file.get("GENERAL", "Paths", paths);
+	file.get("GENERAL", "Flag", flag);
+	file.get("GENERAL", "Empty", empty);
+
+	CHECK_EQUAL(global, 1);
+	// The last occurrence of a key wins
+	CHECK_EQUAL(count, 43);
+	CHECK_EQUAL(negative, -7);
+	CHECK_EQUAL(scale, 0.5f);
+	CHECK(enabled);
+	CHECK(name == "Hello World");
+	// Elements missing from the value are reset
+	CHECK_EQUAL(keys[0], 112u);
+	CHECK_EQUAL(keys[2], 1u);
+	CHECK_EQUAL(keys[3], 0u);
+	REQUIRE(paths.size() == 2);
+	CHECK(paths[1].string() == "C:\\b");
+	// Keys without a value count as zero
+	CHECK_EQUAL(flag, 0);
+	CHECK(empty.empty());
+
+	// Missing keys leave the value untouched
+	int missing = 5;
+	file.get("GENERAL", "Missing", missing);
+	file.get("OTHER", "Count", missing);
+	CHECK_EQUAL(missing, 5);
+	CHECK(file.has("GENERAL", "Scale"));
+	CHECK(!file.has("", "Scale"));
+}
+
+TEST_CASE(read_views)
+{
+	const std::string path = tests::temp_path("read_views.ini");
+	write_file(path, "Techniques=Bloom,Tonemap,Vignette\n");
+
+	ini_file file(path);
+
+	// Views point into the file contents, which this instance keeps alive
+	std::vector<std::string_view> techniques;
+	file.get("", "Techniques", techniques);
+	REQUIRE(techniques.size() == 3);
+	CHECK(techniques[0] == "Bloom");
+	CHECK(techniques[2] == "Vignette");
+
+	std::string_view first;
+	file.get("", "Techniques", first);
+	CHECK(first == "Bloom");
+
+	// Values that were set are read back from this instance
+	file.set("", "Techniques", std::vector<std::string> { "Sharpen", "Grain" });
+	file.get("", "Techniques", techniques);
+	REQUIRE(techniques.size() == 2);
+	CHECK(techniques[1] == "Grain");
+}
+
+TEST_CASE(write_is_deferred_until_flush)
+{
+	const std::string path = tests::temp_path("deferred.ini");
+	const std::string original = "[GENERAL]\nA=1\nB=2\n\n";
+	write_file(path, original);
+
+	{
+		ini_file file(path);
+		file.set("GENERAL", "B", 3);
+		file.set("GENERAL", "C", 4);
+		file.set("NEW", "D", std::vector<std::string> { "x", "y" });
+		// Setting a key several times only keeps the last value
+		file.set("GENERAL", "C", 5);
+	}
+
+	// Nothing was written yet, but opening the file again already sees the changes
+	CHECK(read_file(path) == original);
+	CHECK(ini_file::has_pending_changes(path));
+	{
+		const ini_file file(path);
+		int b = 0, c = 0;
+		file.get("GENERAL", "B", b);
+		file.get("GENERAL", "C", c);
+		CHECK_EQUAL(b, 3);
+		CHECK_EQUAL(c, 5);
+	}
+
+	ini_file::flush_cache();
+
+	CHECK(!ini_file::has_pending_changes(path));
+	// Existing keys keep their position, new keys are added to the end of their section
+	CHECK(read_file(path) == "[GENERAL]\nA=1\nB=3\nC=5\n\n[NEW]\nD=x,y\n\n");
+}
+
+TEST_CASE(unchanged_contents_are_not_written)
+{
+	const std::string path = tests::temp_path("unchanged.ini");
+	write_file(path, "[GENERAL]\nA=1\n\n");
+
+	{
+		ini_file file(path);
+		file.set("GENERAL", "A", 1);
+	}
+
+	CHECK(!ini_file::has_pending_changes(path));
+}
+
+TEST_CASE(save_to_other_path)
+{
+	const std::string path = tests::temp_path("source.ini");
+	const std::string save_path = tests::temp_path("target.ini");
+	write_file(path, "A=1\n");
+
+	{
+		ini_file file(path, save_path);
+		file.set("", "B", 2);
+	}
+
+	ini_file::flush_cache();
+
+	CHECK(read_file(path) == "A=1\n");
+	CHECK(read_file(save_path) == "A=1\nB=2\n\n");
+}
+
+TEST_CASE(reload_after_external_change)
+{
+	const std::string path = tests::temp_path("external.ini");
+	write_file(path, "A=1\n");
+
+	int value = 0;
+	ini_file(path).get("", "A", value);
+	CHECK_EQUAL(value, 1);
+
+	// Another program changes the file, so the cached contents are outdated
+	write_file(path, "A=22\n");
+	ini_file(path).get("", "A", value);
+	CHECK_EQUAL(value, 22);
+}
+
+TEST_CASE(many_files)
+{
+	// More files than the cache holds, so older ones are dropped and read again
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool all_correct = true;
+
+		for (int i = 0; i < 200; i++)
+		{
+			const std::string path = tests::temp_path("many" + std::to_string(i) + ".ini");
+			if (pass == 0)
+				write_file(path, "Index=" + std::to_string(i) + '\n');
+
+			int value = -1;
+			ini_file(path).get("", "Index", value);
+			all_correct &= value == i;
+		}
+
+		CHECK(all_correct);
+	}
+
+	ini_file::clear_cache();
+}
+
+TEST_CASE(failed_write_is_logged)
+{
+	const std::string path = tests::temp_path("missing_directory/file.ini");
+
+	{
+		ini_file file(path);
+		file.set("", "A", 1);
+	}
+
+	const size_t errors = log::lines.count(log::level::error);
+
+	ini_file::flush_cache();
+
+	CHECK_EQUAL(log::lines.count(log::level::error), errors + 1);
+	CHECK(!ini_file::has_pending_changes(path));
+}
@@ -0,0 +1,199 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "input_queue.hpp"
+#include <memory>
+#include <thread>
+
+using namespace reshade;
+
+static input_event make_event(input_event_type type, int32_t value, int32_t x = 0, int32_t y = 0)
+{
+	return { type, value, x, y };
+}
+
+TEST_CASE(queue_keeps_order)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+
+	CHECK(queue->push(make_event(input_event_type::key_down, 1)));
+	CHECK(queue->push(make_event(input_event_type::key_up, 2)));
+
+	input_event event;
+	REQUIRE(queue->pop(event));
+	CHECK(event.type == input_event_type::key_down);
+	CHECK_EQUAL(event.value, 1);
+	REQUIRE(queue->pop(event));
+	CHECK(event.type == input_event_type::key_up);
+	CHECK_EQUAL(event.value, 2);
+	CHECK(!queue->pop(event));
+}
+
+TEST_CASE(queue_overflow)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+
+	for (uint32_t i = 0; i < input_event_queue::capacity; i++)
+	{
+		CHECK(queue->push(make_event(input_event_type::character, static_cast<int32_t>(i))));
+	}
+
+	CHECK(!queue->check_and_reset_overflow());
+
+	// The queue is full, so the next event is dropped and the overflow is reported once
+	CHECK(!queue->push(make_event(input_event_type::character, -1)));
+	CHECK(queue->check_and_reset_overflow());
+	CHECK(!queue->check_and_reset_overflow());
+
+	input_event event;
+	REQUIRE(queue->pop(event));
+	CHECK_EQUAL(event.value, 0);
+	CHECK(queue->push(make_event(input_event_type::character, -2)));
+}
+
+TEST_CASE(queue_wraps_around)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+
+	// Push and pop more events than the queue can hold at once, so that the indices wrap around the buffer several times
+	input_event event;
+	for (int32_t i = 0; i < static_cast<int32_t>(input_event_queue::capacity) * 3; i++)
+	{
+		REQUIRE(queue->push(make_event(input_event_type::character, i)));
+		REQUIRE(queue->pop(event));
+		CHECK_EQUAL(event.value, i);
+	}
+
+	CHECK(!queue->pop(event));
+}
+
+TEST_CASE(queue_clear)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+
+	queue->push(make_event(input_event_type::key_down, 1));
+	for (uint32_t i = 0; i < input_event_queue::capacity; i++)
+		queue->push(make_event(input_event_type::key_down, 1));
+
+	queue->clear();
+
+	input_event event;
+	CHECK(!queue->pop(event));
+	CHECK(!queue->check_and_reset_overflow());
+}
+
+TEST_CASE(queue_single_producer_single_consumer)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+	const int32_t count = 1000000;
+
+	std::thread producer([&queue]() {
+		for (int32_t i = 0; i < count;)
+		{
+			if (queue->push(make_event(input_event_type::character, i)))
+				i++;
+			else
+				std::this_thread::yield();
+		}
+	});
+
+	// Every event arrives exactly once and in order
+	int32_t expected = 0;
+	bool in_order = true;
+	for (input_event event; expected < count;)
+	{
+		if (queue->pop(event))
+			in_order &= event.value == expected++;
+		else
+			std::this_thread::yield();
+	}
+
+	producer.join();
+
+	CHECK(in_order);
+	CHECK_EQUAL(expected, count);
+}
+
+TEST_CASE(state_keys)
+{
+	input_state state;
+
+	state.apply(make_event(input_event_type::key_down, 0x41));
+	CHECK_EQUAL(state.keys[0x41], 0x88);
+
+	// The change bit only applies to the frame the event arrived in
+	state.next_frame();
+	CHECK_EQUAL(state.keys[0x41], 0x80);
+
+	state.apply(make_event(input_event_type::key_up, 0x41));
+	CHECK_EQUAL(state.keys[0x41], 0x08);
+	state.next_frame();
+	CHECK_EQUAL(state.keys[0x41], 0x00);
+
+	// Out of range values are ignored
+	state.apply(make_event(input_event_type::key_down, 256));
+	state.apply(make_event(input_event_type::key_down, -1));
+	state.apply(make_event(input_event_type::mouse_button_down, 5));
+}
+
+TEST_CASE(state_folds_events_of_a_frame)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+	input_state state;
+
+	// A click that starts and ends within one frame leaves the button up, but marked as changed
+	queue->push(make_event(input_event_type::mouse_button_down, 0));
+	queue->push(make_event(input_event_type::mouse_button_up, 0));
+	queue->push(make_event(input_event_type::mouse_wheel, 1));
+	queue->push(make_event(input_event_type::mouse_wheel, 2));
+	queue->push(make_event(input_event_type::mouse_move, 0, 10, 20));
+	queue->push(make_event(input_event_type::mouse_move, 0, 30, 40));
+	queue->push(make_event(input_event_type::character, 'a'));
+	queue->push(make_event(input_event_type::character, 'b'));
+
+	state.apply(*queue);
+
+	CHECK_EQUAL(state.mouse_buttons[0], 0x08);
+	CHECK_EQUAL(state.mouse_wheel_delta, 3);
+	CHECK_EQUAL(state.mouse_position[0], 30u);
+	CHECK_EQUAL(state.mouse_position[1], 40u);
+	CHECK(state.text_input == L"ab");
+
+	state.next_frame();
+
+	CHECK_EQUAL(state.mouse_buttons[0], 0x00);
+	CHECK_EQUAL(state.mouse_wheel_delta, 0);
+	CHECK(state.text_input.empty());
+	CHECK_EQUAL(state.last_mouse_position[0], 30u);
+	CHECK_EQUAL(state.last_mouse_position[1], 40u);
+}
+
+TEST_CASE(state_releases_keys_after_overflow)
+{
+	const auto queue = std::make_unique<input_event_queue>();
+	input_state state;
+
+	state.apply(make_event(input_event_type::key_down, 0x10));
+	state.apply(make_event(input_event_type::mouse_button_down, 1));
+	state.next_frame();
+
+	// The release events may have been among the dropped ones, so nothing is left held down
+	for (uint32_t i = 0; i <= input_event_queue::capacity; i++)
+		queue->push(make_event(input_event_type::mouse_move, 0, i, i));
+
+	state.apply(*queue);
+
+	CHECK_EQUAL(state.keys[0x10], 0x08);
+	CHECK_EQUAL(state.mouse_buttons[1], 0x08);
+	CHECK_EQUAL(state.mouse_position[0], input_event_queue::capacity - 1);
+
+	// Without another overflow, held keys stay down
+	queue->push(make_event(input_event_type::key_down, 0x11));
+	state.apply(*queue);
+	state.next_frame();
+	state.apply(*queue);
+	CHECK_EQUAL(state.keys[0x11], 0x80);
+}
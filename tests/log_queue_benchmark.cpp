@@ -0,0 +1,105 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "benchmark.hpp"
+#include "log_queue.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace reshade;
+using namespace reshade::log;
+
+int main(int argc, char *argv[])
+{
+	const size_t iterations = benchmarks::iterations(argc, argv, 1000000);
+
+	const auto queue = std::make_unique<record_queue>();
+	const std::string message = "Compiling effect \"qUINT_bloom.fx\" took 12 ms.";
+
+	// A single thread logging while the consumer is idle, emptying the queue whenever it fills up, as the writer thread does
+	benchmarks::measure("record_queue enqueue with one thread", iterations, [&](size_t) {
+		record record = { level::info, 0, 0, message };
+		if (!queue->try_enqueue(record))
+		{
+			while (queue->front() != nullptr)
+				queue->pop_front();
+			queue->try_enqueue(record);
+		}
+	});
+	while (queue->front() != nullptr)
+		queue->pop_front();
+
+	// Several threads logging at once while the consumer keeps writing records to the line buffer
+	for (uint32_t num_threads : { 2u, 4u })
+	{
+		const size_t count = iterations / num_threads;
+		line_buffer lines(4096);
+
+		char name[64];
+		std::snprintf(name, sizeof(name), "record_queue enqueue with %u threads", num_threads);
+		const double duration = benchmarks::measure(name, 1, [&](size_t) {
+			std::atomic<uint32_t> num_running = num_threads;
+			std::vector<std::thread> producers;
+			for (uint32_t thread_id = 0; thread_id < num_threads; thread_id++)
+			{
+				producers.emplace_back([&, thread_id]() {
+					for (size_t i = 0; i < count;)
+					{
+						record record = { level::info, 0, thread_id, message };
+						if (queue->try_enqueue(record))
+							i++;
+						else
+							std::this_thread::yield();
+					}
+					num_running--;
+				});
+			}
+
+			while (num_running != 0 || queue->front() != nullptr)
+			{
+				if (const record *const record = queue->front())
+				{
+					lines.push_back(record->level, record->text);
+					queue->pop_front();
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			for (std::thread &producer : producers)
+				producer.join();
+		});
+
+		std::printf("%-48s %12.1f ns per record\n", "", duration / (count * num_threads));
+	}
+
+	line_buffer lines(4096);
+
+	benchmarks::measure("line_buffer push_back", iterations, [&](size_t) {
+		lines.push_back(level::info, message);
+	});
+
+	// Reading the lines the overlay shows while another thread keeps logging
+	std::atomic<bool> stop = false;
+	std::thread writer([&]() {
+		while (!stop.load(std::memory_order_relaxed))
+			lines.push_back(level::warning, message);
+	});
+
+	benchmarks::measure("line_buffer read 64 lines while writing", iterations / 64, [&](size_t) {
+		size_t length = 0;
+		lines.for_each(lines.end_index() - 64, [&length](uint64_t, const line &line) { length += line.text.size(); });
+		benchmarks::do_not_optimize(length);
+	});
+	benchmarks::measure("line_buffer count while writing", iterations, [&](size_t) {
+		benchmarks::do_not_optimize(lines.count(level::warning));
+	});
+
+	stop = true;
+	writer.join();
+}
@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "log_queue.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace reshade;
+using namespace reshade::log;
+
+static record make_record(std::string text, level level = level::info, uint32_t thread_id = 0)
+{
+	return { level, 0, thread_id, std::move(text) };
+}
+
+static std::vector<line> read_lines(const line_buffer &buffer, uint64_t first_index = 0)
+{
+	std::vector<line> lines;
+	buffer.for_each(first_index, [&lines](uint64_t, const line &line) { lines.push_back(line); });
+	return lines;
+}
+
+TEST_CASE(queue_keeps_order)
+{
+	const auto queue = std::make_unique<record_queue>();
+
+	CHECK(queue->front() == nullptr);
+
+	record first = make_record("first", level::error), second = make_record("second");
+	CHECK(queue->try_enqueue(first));
+	CHECK(queue->try_enqueue(second));
+	CHECK_EQUAL(queue->size(), 2u);
+
+	REQUIRE(queue->front() != nullptr);
+	CHECK(queue->front()->text == "first");
+	CHECK(queue->front()->level == level::error);
+	queue->pop_front();
+	REQUIRE(queue->front() != nullptr);
+	CHECK(queue->front()->text == "second");
+	queue->pop_front();
+	CHECK(queue->front() == nullptr);
+	CHECK_EQUAL(queue->size(), 0u);
+}
+
+TEST_CASE(queue_full)
+{
+	const auto queue = std::make_unique<record_queue>();
+
+	for (size_t i = 0; i < record_queue::capacity; i++)
+	{
+		record record = make_record(std::to_string(i));
+		CHECK(queue->try_enqueue(record));
+	}
+
+	// A record that does not fit is left with the caller, so it can try again later
+	record overflow = make_record("overflow");
+	CHECK(!queue->try_enqueue(overflow));
+	CHECK(overflow.text == "overflow");
+
+	queue->pop_front();
+	CHECK(queue->try_enqueue(overflow));
+
+	bool in_order = true;
+	for (size_t i = 1; i < record_queue::capacity; i++)
+	{
+		in_order &= queue->front() != nullptr && queue->front()->text == std::to_string(i);
+		queue->pop_front();
+	}
+	CHECK(in_order);
+	REQUIRE(queue->front() != nullptr);
+	CHECK(queue->front()->text == "overflow");
+	queue->pop_front();
+
+	// Go around the queue a few more times, so that the positions wrap into later laps
+	for (size_t i = 0; i < record_queue::capacity * 3; i++)
+	{
+		record record = make_record(std::to_string(i));
+		in_order &= queue->try_enqueue(record);
+		in_order &= queue->front() != nullptr && queue->front()->text == std::to_string(i);
+		queue->pop_front();
+	}
+	CHECK(in_order);
+	CHECK(queue->front() == nullptr);
+}
+
+TEST_CASE(queue_multiple_producers)
+{
+	const auto queue = std::make_unique<record_queue>();
+	const uint32_t num_threads = 4;
+	const uint32_t count = 100000;
+
+	std::vector<std::thread> producers;
+	for (uint32_t thread_id = 0; thread_id < num_threads; thread_id++)
+	{
+		producers.emplace_back([&queue, thread_id]() {
+			for (uint32_t i = 0; i < count;)
+			{
+				record record = make_record(std::to_string(i), level::info, thread_id);
+				if (queue->try_enqueue(record))
+					i++;
+				else
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	// Records of different threads interleave, but the ones of each thread arrive exactly once and in order
+	uint32_t next[num_threads] = {};
+	uint32_t received = 0;
+	bool in_order = true;
+	while (received < num_threads * count)
+	{
+		if (const record *const record = queue->front())
+		{
+			in_order &= record->thread_id < num_threads && record->text == std::to_string(next[record->thread_id]++);
+			queue->pop_front();
+			received++;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	for (std::thread &producer : producers)
+		producer.join();
+
+	CHECK(in_order);
+	CHECK(queue->front() == nullptr);
+}
+
+TEST_CASE(lines_split_messages)
+{
+	line_buffer buffer(16);
+
+	buffer.push_back(level::warning, "first\nsecond\n");
+	buffer.push_back(level::error, "");
+
+	const auto lines = read_lines(buffer);
+	REQUIRE(lines.size() == 3);
+	CHECK(lines[0].text == "WARN  | first");
+	CHECK(lines[0].level == level::warning);
+	CHECK(lines[1].text == "WARN  | second");
+	CHECK(lines[2].text == "ERROR | ");
+	CHECK(lines[2].level == level::error);
+}
+
+TEST_CASE(lines_truncate_long_lines)
+{
+	line_buffer buffer(4);
+
+	buffer.push_back(level::info, std::string(line_buffer::max_line_length * 2, 'x'));
+
+	const auto lines = read_lines(buffer);
+	REQUIRE(lines.size() == 1);
+	CHECK_EQUAL(lines[0].text.size(), line_buffer::max_line_length);
+	CHECK(lines[0].text.compare(0, 8, "INFO  | ") == 0);
+	CHECK(lines[0].text.back() == 'x');
+}
+
+TEST_CASE(lines_drop_oldest)
+{
+	line_buffer buffer(4);
+
+	for (int i = 0; i < 6; i++)
+		buffer.push_back(i % 2 ? level::error : level::info, std::to_string(i));
+
+	CHECK_EQUAL(buffer.begin_index(), 2u);
+	CHECK_EQUAL(buffer.end_index(), 6u);
+	CHECK_EQUAL(buffer.count(level::error), 2u);
+	CHECK_EQUAL(buffer.count(level::info), 2u);
+	CHECK_EQUAL(buffer.count(level::warning), 0u);
+
+	// Indices stay the same after older lines were dropped
+	const auto lines = read_lines(buffer, 3);
+	REQUIRE(lines.size() == 3);
+	CHECK(lines[0].text == "ERROR | 3");
+	CHECK(lines[2].text == "ERROR | 5");
+
+	std::vector<uint64_t> visited;
+	const uint64_t indices[] = { 0, 1, 4, 5 };
+	buffer.for_each(indices, 4, [&visited](uint64_t index, const line &) { visited.push_back(index); });
+	REQUIRE(visited.size() == 2);
+	CHECK_EQUAL(visited[0], 4u);
+	CHECK_EQUAL(visited[1], 5u);
+}
+
+TEST_CASE(lines_clear)
+{
+	line_buffer buffer(8);
+
+	buffer.push_back(level::error, "a\nb\nc");
+	buffer.clear();
+
+	CHECK_EQUAL(buffer.begin_index(), 3u);
+	CHECK_EQUAL(buffer.end_index(), 3u);
+	CHECK_EQUAL(buffer.count(level::error), 0u);
+	CHECK(read_lines(buffer).empty());
+
+	// Lines added after clearing continue the numbering
+	buffer.push_back(level::error, "d");
+	CHECK_EQUAL(buffer.count(level::error), 1u);
+	const auto lines = read_lines(buffer);
+	REQUIRE(lines.size() == 1);
+	CHECK(lines[0].text == "ERROR | d");
+}
+
+TEST_CASE(lines_concurrent_reader)
+{
+	line_buffer buffer(64);
+	const int count = 200000;
+
+	std::thread writer([&buffer]() {
+		for (int i = 0; i < count; i++)
+			buffer.push_back(level::info, std::to_string(i) + ' ' + std::string(i % 300, static_cast<char>('a' + i % 26)));
+	});
+
+	// Lines that are replaced while being copied are skipped, so every line read has to be intact and belong to its index
+	bool consistent = true;
+	size_t num_read = 0;
+	for (uint64_t next_index = 0; next_index < static_cast<uint64_t>(count);)
+	{
+		buffer.for_each(next_index, [&](uint64_t index, const line &line) {
+			const int i = static_cast<int>(index);
+			consistent &= line.text == "INFO  | " + std::to_string(i) + ' ' + std::string(i % 300, static_cast<char>('a' + i % 26));
+			num_read++;
+		});
+
+		next_index = buffer.end_index();
+	}
+
+	writer.join();
+
+	CHECK(consistent);
+	CHECK(num_read != 0);
+	CHECK_EQUAL(buffer.count(level::info), 64u);
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "null/null_command_stream.hpp"
+#include <vector>
+
+using namespace reshade::null;
+
+static size_t count_of(const null_frame_statistics &statistics, null_command_type type)
+{
+	return statistics.command_counts[static_cast<size_t>(type)];
+}
+
+TEST_CASE(record_and_replay_frames)
+{
+	null_command_stream stream;
+	CHECK_EQUAL(stream.frame_count(), size_t(0));
+
+	stream.begin_frame();
+	stream.record(null_command_type::bind_shaders, 1, 2);
+	stream.record(null_command_type::draw, 3, 0);
+	stream.begin_frame();
+	stream.record(null_command_type::set_viewport, 640, 480);
+	CHECK_EQUAL(stream.frame_count(), size_t(2));
+
+	size_t count;
+	const null_command *const commands = stream.frame(0, count);
+	REQUIRE(count == 2);
+	CHECK(commands[0].type == null_command_type::bind_shaders);
+	CHECK_EQUAL(commands[0].args[0], uint32_t(1));
+	CHECK_EQUAL(commands[0].args[1], uint32_t(2));
+	CHECK(commands[1].type == null_command_type::draw);
+	CHECK_EQUAL(commands[1].args[0], uint32_t(3));
+
+	// Replay only visits the commands of the requested frame, in the order they were recorded
+	std::vector<null_command_type> replayed;
+	stream.replay(1, [&replayed](const null_command &command) { replayed.push_back(command.type); });
+	REQUIRE(replayed.size() == 1);
+	CHECK(replayed[0] == null_command_type::set_viewport);
+
+	stream.clear();
+	CHECK_EQUAL(stream.frame_count(), size_t(0));
+}
+
+TEST_CASE(lists_are_stored_in_payload)
+{
+	null_command_stream stream;
+	stream.begin_frame();
+
+	const uint32_t first[3] = { 10, 11, 12 }, second[2] = { 20, 21 };
+	stream.record_list(null_command_type::bind_shader_resources, first, 3, 4);
+	stream.record_list(null_command_type::bind_render_targets, second, 2, 99);
+
+	size_t count;
+	const null_command *const commands = stream.frame(0, count);
+	REQUIRE(count == 2);
+
+	CHECK_EQUAL(commands[0].args[1], uint32_t(3));
+	CHECK_EQUAL(commands[0].args[2], uint32_t(4));
+	CHECK_EQUAL(stream.payload(commands[0])[0], uint32_t(10));
+	CHECK_EQUAL(stream.payload(commands[0])[2], uint32_t(12));
+
+	CHECK_EQUAL(commands[1].args[1], uint32_t(2));
+	CHECK_EQUAL(commands[1].args[2], uint32_t(99));
+	CHECK_EQUAL(stream.payload(commands[1])[0], uint32_t(20));
+	CHECK_EQUAL(stream.payload(commands[1])[1], uint32_t(21));
+}
+
+TEST_CASE(analyze_counts_redundant_binds)
+{
+	null_command_stream stream;
+	stream.begin_frame();
+
+	// The first bind of each kind is never redundant, repeating the same arguments is
+	stream.record(null_command_type::bind_blend_state, 5);
+	stream.record(null_command_type::bind_blend_state, 5);
+	stream.record(null_command_type::bind_blend_state, 6);
+	stream.record(null_command_type::bind_depth_stencil_state, 7, 1);
+	stream.record(null_command_type::bind_depth_stencil_state, 7, 2);
+	stream.record(null_command_type::bind_depth_stencil_state, 7, 2);
+
+	// Lists are only redundant when the objects, their count and their first slot all match, objects past the count are not part of the bind
+	const uint32_t views[2] = { 1, 2 }, other_views[2] = { 1, 3 };
+	stream.record_list(null_command_type::bind_shader_resources, views, 2, 0);
+	stream.record_list(null_command_type::bind_shader_resources, views, 2, 0);
+	stream.record_list(null_command_type::bind_shader_resources, views, 2, 1);
+	stream.record_list(null_command_type::bind_shader_resources, views, 1, 1);
+	stream.record_list(null_command_type::bind_shader_resources, other_views, 1, 1);
+
+	// Draws do not change bound state
+	stream.record(null_command_type::draw, 3, 0);
+	stream.record(null_command_type::draw, 3, 0);
+
+	const null_frame_statistics statistics = stream.analyze(0);
+	CHECK_EQUAL(statistics.redundant_binds, size_t(4));
+	CHECK_EQUAL(count_of(statistics, null_command_type::bind_blend_state), size_t(3));
+	CHECK_EQUAL(count_of(statistics, null_command_type::bind_shader_resources), size_t(5));
+	CHECK_EQUAL(count_of(statistics, null_command_type::draw), size_t(2));
+}
+
+TEST_CASE(analyze_starts_each_frame_unbound)
+{
+	null_command_stream stream;
+	stream.begin_frame();
+	stream.record(null_command_type::bind_rasterizer_state, 1);
+	stream.begin_frame();
+	stream.record(null_command_type::bind_rasterizer_state, 1);
+
+	// Binding the state again in the next frame is not redundant, since the application may have changed it in between
+	CHECK_EQUAL(stream.analyze(0).redundant_binds, size_t(0));
+	CHECK_EQUAL(stream.analyze(1).redundant_binds, size_t(0));
+}
+
+TEST_CASE(analyze_counts_copies_and_uploads)
+{
+	null_command_stream stream;
+	stream.begin_frame();
+	stream.record(null_command_type::copy_texture, 1, 2);
+	stream.record(null_command_type::copy_texture, 2, 1);
+	stream.record(null_command_type::update_buffer, 3, 0, 256);
+	stream.record(null_command_type::update_buffer, 3, 256, 64);
+	stream.record(null_command_type::update_texture, 4, 1024, 0);
+
+	const null_frame_statistics statistics = stream.analyze(0);
+	CHECK_EQUAL(statistics.copies, size_t(2));
+	CHECK_EQUAL(statistics.bytes_uploaded, size_t(256 + 64 + 1024));
+	CHECK_EQUAL(statistics.redundant_binds, size_t(0));
+}
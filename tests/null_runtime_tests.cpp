@@ -0,0 +1,188 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "log.hpp"
+#include "null/null_runtime.hpp"
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+
+using namespace reshade;
+using namespace reshade::null;
+
+static const unsigned int frame_width = 1280, frame_height = 720;
+
+class test_runtime : public null_runtime
+{
+public:
+	// Effects are loaded one per frame and techniques are compiled on worker threads, so it takes several frames until they are rendered
+	bool is_ready() const
+	{
+		return is_effect_loaded() && std::all_of(_techniques.begin(), _techniques.end(),
+			[](const technique &technique) { return !technique.enabled || technique.compiled; });
+	}
+};
+
+// The runtime loads all effect files next to its module and reads its configuration when it is constructed, so give each effect a directory of its own before creating a runtime for it
+static void use_effect(const std::string &effect_name)
+{
+	const std::string directory = tests::temp_path(effect_name);
+	std::filesystem::create_directories(directory);
+	std::filesystem::copy_file(tests::data_path("null_runtime/" + effect_name + ".fx"), directory + '/' + effect_name + ".fx", std::filesystem::copy_options::overwrite_existing);
+
+	runtime::s_reshade_dll_path = directory + "/ReShade.dll";
+	runtime::s_target_executable_path = directory + "/null_runtime_tests";
+}
+
+// Present frames until the effect was loaded and all its techniques were compiled, then record the specified number of frames
+static bool record_frames(test_runtime &runtime, size_t num_frames)
+{
+	if (!runtime.on_init(frame_width, frame_height))
+		return false;
+
+	bool ready = false;
+	for (unsigned int frame = 0; frame < 1000 && !ready; frame++)
+	{
+		runtime.on_present();
+
+		ready = runtime.is_ready();
+		if (!ready)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	if (!ready)
+	{
+		// Print why the effect did not load, e.g. compiler errors
+		log::lines.for_each(0, [](uint64_t, const log::line &line) {
+			if (line.level == log::level::error || line.level == log::level::warning)
+				std::cerr << line.text << std::endl;
+		});
+		return false;
+	}
+
+	runtime.clear_commands();
+
+	for (size_t frame = 0; frame < num_frames; frame++)
+		runtime.on_present();
+
+	return true;
+}
+
+TEST_CASE(records_one_frame_per_present)
+{
+	use_effect("chain");
+
+	test_runtime runtime;
+	REQUIRE(record_frames(runtime, 3));
+	REQUIRE(runtime.commands().frame_count() == 3);
+
+	// Every pass draws a single triangle
+	for (size_t frame = 0; frame < 3; frame++)
+	{
+		const null_frame_statistics statistics = runtime.commands().analyze(frame);
+		CHECK_EQUAL(statistics.command_counts[static_cast<size_t>(null_command_type::draw)], size_t(5));
+	}
+
+	runtime.on_reset();
+}
+
+TEST_CASE(recordings_are_deterministic)
+{
+	use_effect("chain");
+
+	test_runtime first, second;
+	REQUIRE(record_frames(first, 2));
+	REQUIRE(record_frames(second, 2));
+
+	// Objects are numbered in creation order, so the same effect records the same commands in another runtime
+	size_t first_count, second_count;
+	const null_command *const first_commands = first.commands().frame(1, first_count);
+	const null_command *const second_commands = second.commands().frame(1, second_count);
+	REQUIRE(first_count == second_count);
+
+	size_t num_mismatches = 0;
+	for (size_t i = 0; i < first_count; i++)
+	{
+		num_mismatches += first_commands[i].type != second_commands[i].type;
+		if (first_commands[i].type == null_command_type::bind_samplers ||
+			first_commands[i].type == null_command_type::bind_shader_resources ||
+			first_commands[i].type == null_command_type::bind_render_targets)
+			num_mismatches += !std::equal(first.commands().payload(first_commands[i]), first.commands().payload(first_commands[i]) + first_commands[i].args[1], second.commands().payload(second_commands[i]));
+		else
+			num_mismatches += !std::equal(first_commands[i].args, first_commands[i].args + 4, second_commands[i].args);
+	}
+	CHECK_EQUAL(num_mismatches, size_t(0));
+
+	first.on_reset();
+	second.on_reset();
+}
+
+TEST_CASE(no_redundant_binds_or_copies)
+{
+	use_effect("chain");
+
+	test_runtime runtime;
+	REQUIRE(record_frames(runtime, 3));
+
+	for (size_t frame = 0; frame < 3; frame++)
+	{
+		const null_frame_statistics statistics = runtime.commands().analyze(frame);
+
+		// The state cache skips binding what is already bound, so that passes with the same states only bind their new targets
+		CHECK_EQUAL(statistics.redundant_binds, size_t(0));
+
+		// Passes ping-pong between the back buffer textures, so the back buffer is copied once into a texture at the start and once back at the end, however many passes sample it
+		CHECK_EQUAL(statistics.copies, size_t(2));
+	}
+
+	runtime.on_reset();
+}
+
+TEST_CASE(replay_finds_no_read_write_hazards)
+{
+	use_effect("chain");
+
+	test_runtime runtime;
+	REQUIRE(record_frames(runtime, 1));
+
+	// Track the bound render targets and shader resources while replaying, and check that no draw samples a resource it renders to
+	std::vector<uint32_t> render_targets, shader_resources;
+	size_t num_draws = 0, num_hazards = 0;
+
+	runtime.commands().replay(0, [&](const null_command &command) {
+		const uint32_t *const objects = runtime.commands().payload(command);
+
+		switch (command.type)
+		{
+		case null_command_type::bind_render_targets:
+			render_targets.assign(objects, objects + command.args[1]);
+			break;
+		case null_command_type::bind_shader_resources:
+			if (shader_resources.size() < command.args[2] + command.args[1])
+				shader_resources.resize(command.args[2] + command.args[1]);
+			std::copy_n(objects, command.args[1], shader_resources.begin() + command.args[2]);
+			break;
+		case null_command_type::draw:
+			num_draws++;
+			for (const uint32_t target : render_targets)
+			{
+				for (const uint32_t view : shader_resources)
+				{
+					if (target != 0 && view != 0 && runtime.get_view_resource(target) == runtime.get_view_resource(view))
+						num_hazards++;
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	});
+
+	CHECK_EQUAL(num_draws, size_t(5));
+	CHECK_EQUAL(num_hazards, size_t(0));
+
+	runtime.on_reset();
+}
@@ -0,0 +1,245 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "render_graph.hpp"
+
+using namespace reshade;
+
+static texture_alias_desc make_desc(unsigned int width, unsigned int height, texture_format format = texture_format::rgba8, bool pinned = false)
+{
+	texture_alias_desc desc;
+	desc.width = width;
+	desc.height = height;
+	desc.levels = 1;
+	desc.format = format;
+	desc.pinned = pinned;
+	return desc;
+}
+
+TEST_CASE(alias_sequential_lifetimes)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// A blur chain: 0 -> 1 -> 2 -> back buffer, every texture is dead once the next pass has sampled it
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, { 1 }, true);
+	planner.add_pass({ 1 }, { 2 }, true);
+	planner.add_pass({ 2 }, {}, true);
+
+	const auto owners = planner.plan();
+	REQUIRE(owners.size() == 3);
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+	// Texture 2 is written in pass 3, after texture 0 was last sampled in pass 2
+	CHECK_EQUAL(owners[2], 0u);
+}
+
+TEST_CASE(alias_overlapping_lifetimes)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// Texture 0 is still sampled by the last pass, so it overlaps with both others
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, { 1 }, true);
+	planner.add_pass({ 1 }, { 2 }, true);
+	planner.add_pass({ 0, 2 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+	CHECK_EQUAL(owners[2], 2u);
+}
+
+TEST_CASE(alias_same_pass_read_and_write)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// A texture that is last sampled in the pass which first renders to another one cannot share memory with it
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+}
+
+TEST_CASE(alias_requires_compatible_desc)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(960, 540), make_desc(1920, 1080, texture_format::rgba16f), make_desc(1920, 1080) });
+
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, {}, true);
+	planner.add_pass({}, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+	planner.add_pass({}, { 2 }, true);
+	planner.add_pass({ 2 }, {}, true);
+	planner.add_pass({}, { 3 }, true);
+	planner.add_pass({ 3 }, {}, true);
+
+	// Only the texture with the same size and format may reuse the memory
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[1], 1u);
+	CHECK_EQUAL(owners[2], 2u);
+	CHECK_EQUAL(owners[3], 0u);
+}
+
+TEST_CASE(alias_across_techniques)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, {}, true);
+	planner.begin_technique();
+	planner.add_pass({}, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+
+	// Intermediate textures of different techniques do not live at the same time
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[1], 0u);
+}
+
+TEST_CASE(alias_skips_pinned_textures)
+{
+	// The runtime pins textures with a "source" annotation and ones that reference the back or depth buffer, since their contents do not come from a pass
+	texture_alias_planner planner({ make_desc(1920, 1080, texture_format::rgba8, true), make_desc(1920, 1080), make_desc(1920, 1080, texture_format::rgba8, true) });
+
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, {}, true);
+	planner.add_pass({}, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+	planner.add_pass({}, { 2 }, true);
+	planner.add_pass({ 2 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+	CHECK_EQUAL(owners[2], 2u);
+}
+
+TEST_CASE(alias_skips_textures_sampled_across_frames)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// Texture 0 is sampled before it is rendered to, so it holds the result of the previous frame, e.g. for temporal accumulation
+	planner.begin_technique();
+	planner.add_pass({ 0 }, { 1 }, true);
+	planner.add_pass({ 1 }, { 0 }, true);
+	planner.add_pass({}, { 2 }, true);
+	planner.add_pass({ 2 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	// Texture 2 may reuse the memory of texture 1, but not of texture 0
+	CHECK_EQUAL(owners[1], 1u);
+	CHECK_EQUAL(owners[2], 1u);
+}
+
+TEST_CASE(alias_skips_textures_shared_by_techniques)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// Texture 0 is passed from one technique to the next, which may be disabled while the first one still renders
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.begin_technique();
+	planner.add_pass({ 0 }, {}, true);
+	planner.add_pass({}, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+}
+
+TEST_CASE(alias_skips_partially_written_textures)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	// A blended pass keeps the previous contents, so the texture cannot start out with the contents of another one
+	planner.begin_technique();
+	planner.add_pass({}, { 0 }, true);
+	planner.add_pass({ 0 }, {}, true);
+	planner.add_pass({}, { 1 }, false);
+	planner.add_pass({ 1 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[1], 1u);
+}
+
+TEST_CASE(alias_ignores_unused_textures)
+{
+	texture_alias_planner planner({ make_desc(1920, 1080), make_desc(1920, 1080) });
+
+	planner.begin_technique();
+	planner.add_pass({}, { 1 }, true);
+	planner.add_pass({ 1 }, {}, true);
+
+	const auto owners = planner.plan();
+	CHECK_EQUAL(owners[0], 0u);
+	CHECK_EQUAL(owners[1], 1u);
+}
+
+TEST_CASE(back_buffer_ping_pong)
+{
+	back_buffer_planner planner(2, true);
+	planner.begin_frame();
+
+	back_buffer_access read_write;
+	read_write.reads = true;
+	read_write.writes = true;
+	read_write.overwrites = true;
+
+	// Only the first pass that samples the back buffer needs a copy, the others alternate between the two textures
+	const auto first = planner.plan_pass(read_write);
+	CHECK_EQUAL(first.copy_source, 0);
+	CHECK_EQUAL(first.copy_destination, 1);
+	CHECK_EQUAL(first.read_surface, 1);
+	CHECK_EQUAL(first.write_surface, 2);
+
+	for (int i = 0; i < 3; i++)
+	{
+		const auto step = planner.plan_pass(read_write);
+		CHECK_EQUAL(step.copy_source, -1);
+		CHECK_EQUAL(step.read_surface, 2 - i % 2);
+		CHECK_EQUAL(step.write_surface, 1 + i % 2);
+	}
+
+	// The result of the last pass ends up in texture 1 and has to be copied back once
+	CHECK_EQUAL(planner.end_frame(), 1);
+	CHECK_EQUAL(planner.copies(), 2u);
+	CHECK_EQUAL(planner.elided_copies(), 2u);
+}
+
+TEST_CASE(back_buffer_blending_restores_contents)
+{
+	back_buffer_planner planner(1, true);
+	planner.begin_frame();
+
+	back_buffer_access overwrite;
+	overwrite.writes = true;
+	overwrite.overwrites = true;
+	back_buffer_access blend;
+	blend.reads = true;
+	blend.writes = true;
+
+	CHECK_EQUAL(planner.plan_pass(overwrite).write_surface, 1);
+
+	// The only texture holding the contents is sampled, so they are copied back to the back buffer to blend with them there
+	const auto step = planner.plan_pass(blend);
+	CHECK_EQUAL(step.read_surface, 1);
+	CHECK_EQUAL(step.copy_source, 1);
+	CHECK_EQUAL(step.copy_destination, 0);
+	CHECK_EQUAL(step.write_surface, 0);
+
+	CHECK_EQUAL(planner.end_frame(), -1);
+}
@@ -0,0 +1,165 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "render_state_cache.hpp"
+
+using namespace reshade;
+
+TEST_CASE(filters_redundant_state)
+{
+	render_state_cache cache;
+
+	// Nothing is known after construction, so the first binds always go through
+	CHECK(cache.set_shaders(1, 2));
+	CHECK(!cache.set_shaders(1, 2));
+	CHECK(cache.set_shaders(1, 3));
+
+	CHECK(cache.set_state_block(10));
+	CHECK(!cache.set_state_block(10));
+	CHECK(cache.set_state_block(11));
+
+	CHECK(cache.set_blend_state(0));
+	CHECK(!cache.set_blend_state(0));
+	CHECK(cache.set_depth_stencil_state(5, 0));
+	CHECK(!cache.set_depth_stencil_state(5, 0));
+	CHECK(cache.set_depth_stencil_state(5, 1));
+	CHECK(cache.set_constant_buffer(7));
+	CHECK(!cache.set_constant_buffer(7));
+	CHECK(cache.set_viewport(1920, 1080));
+	CHECK(!cache.set_viewport(1920, 1080));
+	CHECK(cache.set_viewport(1080, 1920));
+
+	CHECK(cache.set_sampler_state(0, 1, 3));
+	CHECK(!cache.set_sampler_state(0, 1, 3));
+	CHECK(cache.set_sampler_state(1, 1, 3));
+}
+
+TEST_CASE(invalidate_forgets_state)
+{
+	render_state_cache cache;
+
+	cache.set_shaders(1, 2);
+	cache.set_state_block(10);
+	cache.set_shader_resource(0, 100);
+	cache.set_render_target(0, 200);
+	cache.set_depth_stencil(0);
+
+	cache.invalidate();
+
+	// Something else may have changed the device state, so even binds of the same objects have to go through
+	CHECK(cache.set_shaders(1, 2));
+	CHECK(cache.set_state_block(10));
+	CHECK(cache.set_shader_resource(0, 100));
+	CHECK(cache.set_render_target(0, 200));
+	CHECK(cache.set_depth_stencil(0));
+}
+
+TEST_CASE(shader_resource_range)
+{
+	render_state_cache cache;
+
+	const uintptr_t views[] = { 100, 101, 102, 103 };
+	const uintptr_t resources[] = { 1000, 1001, 1002, 1003 };
+	bool unbound_render_targets = false;
+
+	auto range = cache.set_shader_resources(views, resources, 4, unbound_render_targets);
+	CHECK_EQUAL(range.first, 0u);
+	CHECK_EQUAL(range.count, 4u);
+	CHECK(!unbound_render_targets);
+
+	// Only the slots that changed have to be bound again
+	const uintptr_t new_views[] = { 100, 111, 102, 113 };
+	range = cache.set_shader_resources(new_views, resources, 4, unbound_render_targets);
+	CHECK_EQUAL(range.first, 1u);
+	CHECK_EQUAL(range.count, 3u);
+
+	range = cache.set_shader_resources(new_views, resources, 4, unbound_render_targets);
+	CHECK_EQUAL(range.count, 0u);
+}
+
+TEST_CASE(render_targets_unbind_sampled_resources)
+{
+	render_state_cache cache;
+
+	const uintptr_t views[] = { 100, 101, 102 };
+	const uintptr_t resources[] = { 1000, 1001, 1002 };
+	bool unbound_render_targets = false;
+	cache.set_shader_resources(views, resources, 3, unbound_render_targets);
+
+	// Rendering to the resource behind slot 1 requires it to be unbound from input first
+	const uintptr_t target_views[] = { 200 };
+	const uintptr_t target_resources[] = { 1001 };
+	state_slot_range unbound_shader_resources;
+	CHECK(cache.set_render_targets(target_views, target_resources, 1, 0, unbound_shader_resources));
+	CHECK_EQUAL(unbound_shader_resources.first, 1u);
+	CHECK_EQUAL(unbound_shader_resources.count, 1u);
+	CHECK_EQUAL(cache.shader_resources()[0], 100u);
+	CHECK_EQUAL(cache.shader_resources()[1], 0u);
+	CHECK_EQUAL(cache.shader_resources()[2], 102u);
+
+	CHECK(!cache.set_render_targets(target_views, target_resources, 1, 0, unbound_shader_resources));
+	CHECK_EQUAL(unbound_shader_resources.count, 0u);
+}
+
+TEST_CASE(shader_resources_unbind_render_targets)
+{
+	render_state_cache cache;
+
+	const uintptr_t target_views[] = { 200, 201 };
+	const uintptr_t target_resources[] = { 1000, 1001 };
+	state_slot_range unbound_shader_resources;
+	cache.set_render_targets(target_views, target_resources, 2, 300, unbound_shader_resources);
+
+	// Sampling the resource behind render target 0 requires it to be unbound from output first
+	const uintptr_t views[] = { 100 };
+	const uintptr_t resources[] = { 1000 };
+	bool unbound_render_targets = false;
+	const auto range = cache.set_shader_resources(views, resources, 1, unbound_render_targets);
+	CHECK(unbound_render_targets);
+	CHECK_EQUAL(range.count, 1u);
+	CHECK_EQUAL(cache.render_targets()[0], 0u);
+	CHECK_EQUAL(cache.render_targets()[1], 201u);
+	CHECK_EQUAL(cache.depth_stencil(), 300u);
+
+	// Binding a different resource does not touch the render targets
+	const uintptr_t other_views[] = { 101 };
+	const uintptr_t other_resources[] = { 1002 };
+	cache.set_shader_resources(other_views, other_resources, 1, unbound_render_targets);
+	CHECK(!unbound_render_targets);
+}
+
+TEST_CASE(unknown_slots_end_up_unbound)
+{
+	render_state_cache cache;
+
+	const uintptr_t views[] = { 100, 0, 0, 103 };
+	const uintptr_t resources[] = { 1000, 0, 0, 1003 };
+	bool unbound_render_targets = false;
+
+	// The caller binds the whole range, so the slots in between that were unknown are now known to be empty
+	const auto range = cache.set_shader_resources(views, resources, 4, unbound_render_targets);
+	CHECK_EQUAL(range.count, 4u);
+	CHECK_EQUAL(cache.shader_resources()[1], 0u);
+	CHECK_EQUAL(cache.shader_resources()[2], 0u);
+	CHECK(!cache.set_shader_resource(1, 0));
+}
+
+TEST_CASE(unbind_render_target_resource)
+{
+	render_state_cache cache;
+
+	const uintptr_t target_views[] = { 200 };
+	const uintptr_t target_resources[] = { 1000 };
+	state_slot_range unbound_shader_resources;
+	cache.set_render_targets(target_views, target_resources, 1, 0, unbound_shader_resources);
+
+	CHECK(!cache.unbind_render_target_resource(1001));
+	CHECK(cache.unbind_render_target_resource(1000));
+	CHECK_EQUAL(cache.render_targets()[0], 0u);
+
+	// Binding the same render target again after the unbind has to go through
+	CHECK(cache.set_render_targets(target_views, target_resources, 1, 0, unbound_shader_resources));
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "benchmark.hpp"
+#include "software/software_runtime.hpp"
+#include <thread>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+
+using namespace reshade;
+using namespace reshade::software;
+
+class benchmark_runtime : public software_runtime
+{
+public:
+	bool is_ready() const
+	{
+		return is_effect_loaded() && std::all_of(_techniques.begin(), _techniques.end(),
+			[](const technique &technique) { return !technique.enabled || technique.compiled; });
+	}
+};
+
+int main(int argc, char *argv[])
+{
+	const size_t iterations = benchmarks::iterations(argc, argv, 10);
+
+	// The benchmark runs the effects in the test data directory, from a scratch directory so that no configuration is written next to them
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_software_runtime_benchmark";
+
+	for (const char *const effect_name : { "invert", "blur", "shading" })
+	{
+		for (const auto &[width, height] : { std::make_pair(640u, 360u), std::make_pair(1280u, 720u) })
+		{
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+			std::filesystem::copy_file(std::string(RESHADE_TEST_DATA_DIRECTORY "/software_runtime/") + effect_name + ".fx", directory / (std::string(effect_name) + ".fx"));
+
+			runtime::s_reshade_dll_path = (directory / "ReShade.dll").string();
+			runtime::s_target_executable_path = (directory / "software_runtime_benchmark").string();
+
+			std::vector<uint8_t> input(width * height * 4);
+			for (size_t i = 0; i < input.size(); i++)
+				input[i] = static_cast<uint8_t>(i * 7);
+
+			benchmark_runtime runtime;
+			runtime.on_init(width, height);
+
+			// Present frames until the effect was loaded and compiled, which is not part of the measurement
+			for (unsigned int frame = 0; frame < 1000 && !runtime.is_ready(); frame++)
+			{
+				runtime.on_present();
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+
+			char name[64];
+			std::snprintf(name, sizeof(name), "%s at %ux%u", effect_name, width, height);
+
+			const double duration = benchmarks::measure(name, iterations, [&](size_t) {
+				runtime.update_back_buffer(input.data());
+				runtime.on_present();
+			}, 3);
+
+			std::printf("%-48s %12.1f ms per frame, %.1f megapixels per second\n", "", duration / 1e6, width * height / (duration / 1e3));
+
+			runtime.on_reset();
+		}
+	}
+
+	std::filesystem::remove_all(directory);
+}
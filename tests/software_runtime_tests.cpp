@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "log.hpp"
+#include "software/software_runtime.hpp"
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+using namespace reshade;
+using namespace reshade::software;
+
+static const unsigned int frame_width = 80, frame_height = 48;
+
+class test_runtime : public software_runtime
+{
+public:
+	// Effects are loaded one per frame and techniques are compiled on worker threads, so it takes several frames until they are rendered
+	bool is_ready() const
+	{
+		return is_effect_loaded() && std::all_of(_techniques.begin(), _techniques.end(),
+			[](const technique &technique) { return !technique.enabled || technique.compiled; });
+	}
+};
+
+// Horizontal and vertical gradients with a checkerboard, so that effects which move, filter or mix pixels all change the image
+static std::vector<uint8_t> make_input_image(unsigned int width, unsigned int height)
+{
+	std::vector<uint8_t> pixels(width * height * 4);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			uint8_t *const pixel = &pixels[(y * width + x) * 4];
+			pixel[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+			pixel[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+			pixel[2] = ((x / 8 + y / 8) % 2) != 0 ? 200 : 40;
+			pixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+// Run the effect file from the data directory on the input image, until it was loaded and all its techniques were compiled
+static bool render_effect(const std::string &effect_name, const std::vector<uint8_t> &input, std::vector<uint8_t> &output)
+{
+	// The runtime loads all effect files next to its module, so give each effect a directory of its own
+	const std::string directory = tests::temp_path(effect_name);
+	std::filesystem::create_directories(directory);
+	std::filesystem::copy_file(tests::data_path("software_runtime/" + effect_name + ".fx"), directory + '/' + effect_name + ".fx", std::filesystem::copy_options::overwrite_existing);
+
+	runtime::s_reshade_dll_path = directory + "/ReShade.dll";
+	runtime::s_target_executable_path = directory + "/software_runtime_tests";
+
+	test_runtime runtime;
+	if (!runtime.on_init(frame_width, frame_height))
+		return false;
+
+	bool ready = false;
+	for (unsigned int frame = 0; frame < 1000 && !ready; frame++)
+	{
+		runtime.update_back_buffer(input.data());
+		runtime.on_present();
+
+		ready = runtime.is_ready();
+		if (!ready)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	if (!ready)
+	{
+		// Print why the effect did not load, e.g. compiler errors
+		log::lines.for_each(0, [](uint64_t, const log::line &line) {
+			if (line.level == log::level::error || line.level == log::level::warning)
+				std::cerr << line.text << std::endl;
+		});
+	}
+	else
+	{
+		runtime.update_back_buffer(input.data());
+		runtime.on_present();
+
+		output.resize(frame_width * frame_height * 4);
+		runtime.capture_frame(output.data());
+	}
+
+	runtime.on_reset();
+
+	return ready;
+}
+
+// Golden images are binary PPM files, which only store the color channels, since the alpha channel of a captured frame is always opaque
+static bool read_ppm(const std::string &path, unsigned int width, unsigned int height, std::vector<uint8_t> &rgb)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	std::string magic;
+	unsigned int file_width = 0, file_height = 0, max_value = 0;
+	if (!(file >> magic >> file_width >> file_height >> max_value) || magic != "P6" || file_width != width || file_height != height || max_value != 255)
+		return false;
+	file.get();
+
+	rgb.resize(width * height * 3);
+	return file.read(reinterpret_cast<char *>(rgb.data()), rgb.size()).good();
+}
+static void write_ppm(const std::string &path, unsigned int width, unsigned int height, const std::vector<uint8_t> &rgba)
+{
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	file << "P6\n" << width << ' ' << height << "\n255\n";
+	for (size_t i = 0; i < rgba.size(); i += 4)
+		file.write(reinterpret_cast<const char *>(&rgba[i]), 3);
+}
+
+// Render an effect and compare the result against its golden image, allowing for one step of rounding difference per channel
+// Any mismatch writes the rendered image to the scratch directory, which can be inspected and copied over the golden image after an intended change
+static void check_golden_image(const std::string &effect_name)
+{
+	std::vector<uint8_t> output;
+	if (!CHECK(render_effect(effect_name, make_input_image(frame_width, frame_height), output)))
+		return;
+
+	std::vector<uint8_t> expected;
+	const bool has_expected = CHECK(read_ppm(tests::data_path("software_runtime/" + effect_name + ".ppm"), frame_width, frame_height, expected));
+
+	size_t num_mismatches = 0;
+	for (size_t i = 0, k = 0; has_expected && i < output.size(); i += 4, k += 3)
+	{
+		for (size_t c = 0; c < 3; c++)
+		{
+			if (std::abs(int(output[i + c]) - int(expected[k + c])) > 1)
+			{
+				num_mismatches++;
+				break;
+			}
+		}
+	}
+	CHECK_EQUAL(num_mismatches, size_t(0));
+
+	if (!has_expected || num_mismatches != 0)
+	{
+		const std::string actual_path = tests::temp_path(effect_name + ".ppm");
+		write_ppm(actual_path, frame_width, frame_height, output);
+		std::cerr << "Rendered image was written to " << actual_path << std::endl;
+	}
+}
+
+TEST_CASE(invert_matches_input)
+{
+	const std::vector<uint8_t> input = make_input_image(frame_width, frame_height);
+
+	std::vector<uint8_t> output;
+	REQUIRE(render_effect("invert", input, output));
+
+	// Every texel of the back buffer is sampled at its center, so the inverse is exact
+	size_t num_mismatches = 0;
+	for (size_t i = 0; i < output.size(); i += 4)
+	{
+		for (size_t c = 0; c < 3; c++)
+			num_mismatches += output[i + c] != 255 - input[i + c];
+	}
+	CHECK_EQUAL(num_mismatches, size_t(0));
+
+	check_golden_image("invert");
+}
+
+TEST_CASE(blur_matches_golden_image)
+{
+	check_golden_image("blur");
+}
+
+TEST_CASE(stencil_blend_matches_golden_image)
+{
+	check_golden_image("stencil_blend");
+}
+
+TEST_CASE(shading_matches_golden_image)
+{
+	check_golden_image("shading");
+}
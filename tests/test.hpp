@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+#include <sstream>
+#include <iostream>
+
+// Minimal test framework for the parts of ReShade that do not depend on a graphics API or on Windows.
+// Every test file is its own executable, which runs all test cases defined in it and returns a non-zero exit code if any check failed.
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static const reshade::tests::test_case name##_registration(#name, &name); \
+	static void name()
+
+#define CHECK(expression) \
+	reshade::tests::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected) \
+	reshade::tests::check_equal((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+#define CHECK_NEAR(actual, expected, tolerance) \
+	reshade::tests::check_near((actual), (expected), (tolerance), #actual, #expected, __FILE__, __LINE__)
+// Stops the current test case if the check fails, for checks that later ones depend on
+#define REQUIRE(expression) \
+	do { if (!CHECK(expression)) return; } while (false)
+
+namespace reshade::tests
+{
+	using test_function = void(*)();
+
+	struct test_case
+	{
+		test_case(const char *name, test_function function);
+
+		const char *name;
+		test_function function;
+		const test_case *next;
+	};
+
+	void report_failure(const std::string &message, const char *file, int line);
+
+	inline bool check(bool condition, const char *expression, const char *file, int line)
+	{
+		if (!condition)
+		{
+			report_failure(std::string("CHECK(") + expression + ") failed", file, line);
+		}
+
+		return condition;
+	}
+
+	template <typename T>
+	std::string to_string(const T &value)
+	{
+		std::ostringstream stream;
+		if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>)
+			stream << static_cast<int>(value);
+		else
+			stream << value;
+		return stream.str();
+	}
+
+	template <typename A, typename E>
+	bool check_equal(const A &actual, const E &expected, const char *actual_expression, const char *expected_expression, const char *file, int line)
+	{
+		const bool condition = actual == expected;
+
+		if (!condition)
+		{
+			report_failure(std::string("CHECK_EQUAL(") + actual_expression + ", " + expected_expression + ") failed: " + to_string(actual) + " != " + to_string(expected), file, line);
+		}
+
+		return condition;
+	}
+
+	inline bool check_near(double actual, double expected, double tolerance, const char *actual_expression, const char *expected_expression, const char *file, int line)
+	{
+		const bool condition = std::abs(actual - expected) <= tolerance;
+
+		if (!condition)
+		{
+			report_failure(std::string("CHECK_NEAR(") + actual_expression + ", " + expected_expression + ") failed: " + to_string(actual) + " != " + to_string(expected), file, line);
+		}
+
+		return condition;
+	}
+
+	/// <summary>
+	/// Returns the path to the directory with the data files the tests use.
+	/// </summary>
+	std::string data_path(const std::string &filename);
+	/// <summary>
+	/// Returns a path in a scratch directory that is removed and created again before the tests of an executable run.
+	/// </summary>
+	std::string temp_path(const std::string &filename);
+}
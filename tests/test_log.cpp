@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Replaces the log file writer for tests and benchmarks of sources that log, which is Windows specific
+// Messages only end up in 'reshade::log::lines', so tests can check which errors were logged
+
+#include "log.hpp"
+#include <mutex>
+
+namespace reshade::log
+{
+	line_buffer lines(4096);
+	static std::mutex s_lines_mutex;
+
+	message::message(level level) : _level(level), _time(0)
+	{
+		_nested_stream = std::make_unique<std::ostringstream>();
+		_stream = _nested_stream.get();
+	}
+	message::~message()
+	{
+		// The line buffer only supports a single writer at a time
+		const std::lock_guard<std::mutex> lock(s_lines_mutex);
+
+		lines.push_back(_level, _stream->str());
+	}
+
+	message &message::operator<<(const std::wstring &message)
+	{
+		return operator<<(filesystem::path(message).string());
+	}
+	message &message::operator<<(const wchar_t *message)
+	{
+		return operator<<(std::wstring(message));
+	}
+
+	bool open(const filesystem::path &)
+	{
+		return true;
+	}
+	void flush()
+	{
+	}
+	void close()
+	{
+	}
+
+	unsigned int flush_interval()
+	{
+		return 0;
+	}
+	void set_flush_interval(unsigned int)
+	{
+	}
+}
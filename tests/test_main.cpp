@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+namespace reshade::tests
+{
+	static const test_case *s_test_cases = nullptr;
+	static const char *s_current_test_case = nullptr;
+	static unsigned int s_num_failures = 0;
+	static std::string s_temp_directory;
+
+	test_case::test_case(const char *name, test_function function) :
+		name(name), function(function), next(s_test_cases)
+	{
+		s_test_cases = this;
+	}
+
+	void report_failure(const std::string &message, const char *file, int line)
+	{
+		s_num_failures++;
+
+		std::cerr << file << '(' << line << "): " << s_current_test_case << ": " << message << std::endl;
+	}
+
+	std::string data_path(const std::string &filename)
+	{
+		return std::string(RESHADE_TEST_DATA_DIRECTORY) + '/' + filename;
+	}
+	std::string temp_path(const std::string &filename)
+	{
+		return s_temp_directory + '/' + filename;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	using namespace reshade::tests;
+
+	// Test cases register themselves in reverse order during static initialization
+	std::vector<const test_case *> test_cases;
+	for (const test_case *test = s_test_cases; test != nullptr; test = test->next)
+		test_cases.insert(test_cases.begin(), test);
+
+	const std::filesystem::path executable_path(argv[0]);
+	s_temp_directory = (std::filesystem::temp_directory_path() / ("reshade_" + executable_path.stem().string())).string();
+	std::filesystem::remove_all(s_temp_directory);
+	std::filesystem::create_directories(s_temp_directory);
+
+	unsigned int num_run = 0, num_failed = 0;
+
+	for (const test_case *test : test_cases)
+	{
+		// Optionally only run the test cases whose name contains one of the arguments
+		if (argc > 1 && std::none_of(argv + 1, argv + argc, [test](const char *filter) { return std::strstr(test->name, filter) != nullptr; }))
+			continue;
+
+		s_current_test_case = test->name;
+
+		const unsigned int num_failures_before = s_num_failures;
+		test->function();
+
+		num_run++;
+		if (s_num_failures != num_failures_before)
+			num_failed++;
+	}
+
+	std::cout << num_run - num_failed << " of " << num_run << " test cases passed." << std::endl;
+
+	return num_failed == 0 && num_run != 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+// Replaces the Windows specific parts the runtime base links against, for tests and benchmarks of the runtimes that do not need a graphics device
+// There are no windows, so input never receives any events and every key and mouse button stays up
+
+#include "input.hpp"
+
+volatile long g_network_traffic = 0;
+
+namespace reshade
+{
+	input::input(window_handle window) : _window(window)
+	{
+	}
+	input::~input()
+	{
+	}
+
+	void input::register_window_with_raw_input(window_handle, bool, bool)
+	{
+	}
+	std::shared_ptr<input> input::register_window(window_handle window)
+	{
+		return std::make_shared<input>(window);
+	}
+	void input::uninstall()
+	{
+	}
+
+	bool input::is_key_down(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_key_down(unsigned int, bool, bool, bool) const
+	{
+		return false;
+	}
+	bool input::is_key_pressed(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_key_pressed(unsigned int, bool, bool, bool) const
+	{
+		return false;
+	}
+	bool input::is_key_released(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_any_key_down() const
+	{
+		return false;
+	}
+	bool input::is_any_key_pressed() const
+	{
+		return false;
+	}
+	bool input::is_any_key_released() const
+	{
+		return false;
+	}
+	unsigned int input::last_key_pressed() const
+	{
+		return 0;
+	}
+	unsigned int input::last_key_released() const
+	{
+		return 0;
+	}
+	bool input::is_mouse_button_down(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_mouse_button_pressed(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_mouse_button_released(unsigned int) const
+	{
+		return false;
+	}
+	bool input::is_any_mouse_button_down() const
+	{
+		return false;
+	}
+	bool input::is_any_mouse_button_pressed() const
+	{
+		return false;
+	}
+	bool input::is_any_mouse_button_released() const
+	{
+		return false;
+	}
+
+	void input::block_mouse_input(bool enable)
+	{
+		_block_mouse = enable;
+	}
+	void input::block_keyboard_input(bool enable)
+	{
+		_block_keyboard = enable;
+	}
+
+	void input::next_frame()
+	{
+	}
+
+	bool input::handle_window_message(const void *)
+	{
+		return false;
+	}
+}
@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "texture_loader.hpp"
+#include <chrono>
+#include <fstream>
+
+using namespace reshade;
+
+// Binary PPM files are the simplest format the decoder supports, so test images can be written without an encoder
+static std::string make_ppm(unsigned int width, unsigned int height, const uint8_t rgb[3])
+{
+	std::string file = "P6\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n";
+	for (unsigned int i = 0; i < width * height; i++)
+		file.append(reinterpret_cast<const char *>(rgb), 3);
+	return file;
+}
+static bool decode(const std::string &file, unsigned int width, unsigned int height, decoded_image &image)
+{
+	image.width = width;
+	image.height = height;
+	return decode_image(reinterpret_cast<const uint8_t *>(file.data()), file.size(), image);
+}
+
+TEST_CASE(decode_without_resize)
+{
+	std::string file = "P6\n2 1\n255\n";
+	file += { char(255), char(0), char(0), char(0), char(128), char(64) };
+
+	decoded_image image;
+	REQUIRE(decode(file, 2, 1, image));
+
+	CHECK_EQUAL(image.source_width, 2u);
+	CHECK_EQUAL(image.source_height, 1u);
+	// Missing channels are filled in, with alpha set to opaque
+	CHECK(image.pixels == std::vector<uint8_t>({ 255, 0, 0, 255, 0, 128, 64, 255 }));
+}
+
+TEST_CASE(decode_and_resize)
+{
+	const uint8_t color[3] = { 200, 100, 50 };
+
+	for (const auto &[source_size, target_size] : { std::make_pair(8u, 2u), std::make_pair(2u, 5u) })
+	{
+		decoded_image image;
+		REQUIRE(decode(make_ppm(source_size, source_size, color), target_size, target_size, image));
+
+		CHECK_EQUAL(image.source_width, source_size);
+		CHECK_EQUAL(image.source_height, source_size);
+		REQUIRE(image.pixels.size() == target_size * target_size * 4);
+
+		// Resizing a uniform image keeps its color, apart from rounding
+		for (size_t i = 0; i < image.pixels.size(); i += 4)
+		{
+			CHECK_NEAR(int(image.pixels[i + 0]), int(color[0]), 1);
+			CHECK_NEAR(int(image.pixels[i + 1]), int(color[1]), 1);
+			CHECK_NEAR(int(image.pixels[i + 2]), int(color[2]), 1);
+			CHECK_NEAR(int(image.pixels[i + 3]), 255, 1);
+		}
+	}
+}
+
+TEST_CASE(decode_invalid_file)
+{
+	decoded_image image;
+	image.pixels.resize(16);
+
+	CHECK(!decode("not an image", 2, 2, image));
+	CHECK(image.pixels.empty());
+	CHECK(!decode(std::string(), 2, 2, image));
+}
+
+TEST_CASE(load_converts_on_worker_threads)
+{
+	const uint8_t color[3] = { 10, 20, 30 };
+
+	std::vector<texture_loader::request> requests;
+	for (size_t i = 0; i < 6; i++)
+	{
+		const std::string path = tests::temp_path("image" + std::to_string(i) + ".ppm");
+		std::ofstream(path, std::ios::out | std::ios::binary) << make_ppm(4, 4, color);
+
+		// The layout OpenGL uses for a texture with mipmaps
+		upload_layout layout;
+		layout.levels = 3;
+		layout.flip_vertically = true;
+
+		requests.push_back({ i, path, 4, 4, layout });
+	}
+	requests.push_back({ 6, tests::temp_path("missing.ppm"), 4, 4 });
+
+	// Fewer queue entries than requests, so that workers have to wait for the render thread to pop images
+	texture_loader loader(2);
+	loader.start(std::move(requests), 2);
+
+	std::vector<decoded_image> images;
+	for (const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10); images.size() < 7 && std::chrono::steady_clock::now() < deadline;)
+	{
+		if (decoded_image image; loader.pop(image))
+			images.push_back(std::move(image));
+	}
+
+	REQUIRE(images.size() == 7);
+
+	for (const decoded_image &image : images)
+	{
+		if (image.texture_index == 6)
+		{
+			// Files which cannot be read are handed to the render thread without pixels, so that it can report the error
+			CHECK(image.pixels.empty());
+			continue;
+		}
+
+		REQUIRE(image.levels.size() == 3);
+		CHECK_EQUAL(image.levels[2].width, 1u);
+		CHECK_EQUAL(image.levels[2].offset, size_t(80));
+		REQUIRE(image.pixels.size() == 84);
+		CHECK(image.pixels[80] == color[0] && image.pixels[81] == color[1] && image.pixels[82] == color[2] && image.pixels[83] == 255);
+	}
+}
+
+TEST_CASE(cancel_discards_pending_images)
+{
+	const std::string path = tests::temp_path("cancel.ppm");
+	const uint8_t color[3] = { 1, 2, 3 };
+	std::ofstream(path, std::ios::out | std::ios::binary) << make_ppm(16, 16, color);
+
+	std::vector<texture_loader::request> requests;
+	for (size_t i = 0; i < 32; i++)
+		requests.push_back({ i, path, 16, 16 });
+
+	texture_loader loader(1);
+	loader.start(std::move(requests), 2);
+	loader.cancel();
+
+	decoded_image image;
+	CHECK(!loader.pop(image));
+}
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "texture_upload.hpp"
+#include <algorithm>
+
+using namespace reshade;
+
+// Pixels with a distinct value in every channel, so that swizzling and flipping can be told apart
+static std::vector<uint8_t> make_pixels(unsigned int width, unsigned int height)
+{
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++)
+			for (unsigned int c = 0; c < 4; c++)
+				pixels[(size_t(y) * width + x) * 4 + c] = static_cast<uint8_t>(y * 64 + x * 4 + c);
+	return pixels;
+}
+
+TEST_CASE(rgba_is_copied_unchanged)
+{
+	const std::vector<uint8_t> pixels = make_pixels(3, 2);
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 3, 2, upload_layout(), data, levels);
+
+	REQUIRE(levels.size() == 1);
+	CHECK_EQUAL(levels[0].width, 3u);
+	CHECK_EQUAL(levels[0].height, 2u);
+	CHECK_EQUAL(levels[0].offset, size_t(0));
+	CHECK_EQUAL(levels[0].row_pitch, size_t(12));
+	CHECK(data == pixels);
+}
+
+TEST_CASE(swizzle_to_bgra)
+{
+	const std::vector<uint8_t> pixels = make_pixels(2, 2);
+
+	// The layout D3D9 uses for RG8 textures, which are created as 32bpp BGRA
+	upload_layout layout;
+	layout.channels[0] = -1;
+	layout.channels[1] = 1;
+	layout.channels[2] = 0;
+	layout.channels[3] = -1;
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 2, 2, layout, data, levels);
+
+	REQUIRE(data.size() == pixels.size());
+	for (size_t i = 0; i < data.size(); i += 4)
+	{
+		CHECK_EQUAL(data[i + 0], uint8_t(0));
+		CHECK_EQUAL(data[i + 1], pixels[i + 1]);
+		CHECK_EQUAL(data[i + 2], pixels[i + 0]);
+		CHECK_EQUAL(data[i + 3], uint8_t(0));
+	}
+}
+
+TEST_CASE(pack_single_channel)
+{
+	const std::vector<uint8_t> pixels = make_pixels(3, 3);
+
+	upload_layout layout;
+	layout.bytes_per_pixel = 1;
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 3, 3, layout, data, levels);
+
+	REQUIRE(levels.size() == 1);
+	CHECK_EQUAL(levels[0].row_pitch, size_t(3));
+	REQUIRE(data.size() == 9);
+	for (size_t i = 0; i < data.size(); i++)
+		CHECK_EQUAL(data[i], pixels[i * 4]);
+}
+
+TEST_CASE(flip_vertically)
+{
+	const std::vector<uint8_t> pixels = make_pixels(2, 3);
+
+	upload_layout layout;
+	layout.flip_vertically = true;
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 2, 3, layout, data, levels);
+
+	REQUIRE(data.size() == pixels.size());
+	CHECK(std::equal(data.begin(), data.begin() + 8, pixels.begin() + 16));
+	CHECK(std::equal(data.begin() + 8, data.begin() + 16, pixels.begin() + 8));
+	CHECK(std::equal(data.begin() + 16, data.end(), pixels.begin()));
+}
+
+TEST_CASE(mipmap_chain)
+{
+	const std::vector<uint8_t> pixels = make_pixels(5, 2);
+
+	upload_layout layout;
+	layout.levels = 16;
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 5, 2, layout, data, levels);
+
+	// The level count is reduced to what the dimensions allow: 5x2, 2x1, 1x1
+	REQUIRE(levels.size() == 3);
+	CHECK_EQUAL(levels[1].width, 2u);
+	CHECK_EQUAL(levels[1].height, 1u);
+	CHECK_EQUAL(levels[1].offset, size_t(40));
+	CHECK_EQUAL(levels[2].width, 1u);
+	CHECK_EQUAL(levels[2].height, 1u);
+	CHECK_EQUAL(levels[2].offset, size_t(48));
+	CHECK_EQUAL(data.size(), size_t(52));
+
+	// Every texel of the second level is the rounded average of a 2x2 block of the first
+	for (unsigned int x = 0; x < 2; x++)
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			const unsigned int sum = pixels[(x * 2) * 4 + c] + pixels[(x * 2 + 1) * 4 + c] + pixels[(5 + x * 2) * 4 + c] + pixels[(5 + x * 2 + 1) * 4 + c];
+			CHECK_EQUAL(data[40 + x * 4 + c], static_cast<uint8_t>((sum + 2) / 4));
+		}
+	}
+	// The last level is downsampled from the second one
+	for (unsigned int c = 0; c < 4; c++)
+		CHECK_EQUAL(data[48 + c], static_cast<uint8_t>((data[40 + c] + data[44 + c] + 1) / 2));
+}
+
+TEST_CASE(mipmaps_of_converted_layout)
+{
+	// A uniform image makes every level the same color, regardless of the filter
+	const std::vector<uint8_t> pixels = { 10, 20, 30, 40, 10, 20, 30, 40, 10, 20, 30, 40, 10, 20, 30, 40 };
+
+	// The layout D3D10 and D3D11 use for R8 textures, with the mipmap levels they are created with
+	upload_layout layout;
+	layout.levels = 2;
+	layout.bytes_per_pixel = 1;
+
+	std::vector<uint8_t> data;
+	std::vector<upload_level> levels;
+	convert_for_upload(pixels.data(), 2, 2, layout, data, levels);
+
+	REQUIRE(levels.size() == 2);
+	CHECK_EQUAL(levels[1].offset, size_t(4));
+	CHECK_EQUAL(levels[1].row_pitch, size_t(1));
+	CHECK(data == std::vector<uint8_t>(5, 10));
+}
+
+TEST_CASE(empty_image)
+{
+	std::vector<uint8_t> data = { 1 };
+	std::vector<upload_level> levels(1);
+	convert_for_upload(nullptr, 0, 0, upload_layout(), data, levels);
+
+	CHECK(data.empty());
+	CHECK(levels.empty());
+}
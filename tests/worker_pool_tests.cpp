@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "test.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace reshade;
+
+TEST_CASE(results_are_returned)
+{
+	worker_pool pool(2);
+
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 50; i++)
+		results.push_back(pool.submit([i]() { return i * i; }));
+
+	bool all_correct = true;
+	for (int i = 0; i < 50; i++)
+		all_correct &= results[i].get() == i * i;
+	CHECK(all_correct);
+}
+
+TEST_CASE(thread_count_is_bounded)
+{
+	worker_pool pool(3);
+	CHECK_EQUAL(pool.num_threads(), 3u);
+
+	std::mutex mutex;
+	std::set<std::thread::id> thread_ids;
+	std::atomic<int> running = 0, max_running = 0;
+
+	// Far more tasks than threads, as when a preset enables many techniques at once
+	std::vector<std::future<void>> results;
+	for (int i = 0; i < 64; i++)
+	{
+		results.push_back(pool.submit([&]() {
+			const int current = ++running;
+			for (int max = max_running; current > max && !max_running.compare_exchange_weak(max, current);)
+				continue;
+
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+			{
+				const std::lock_guard<std::mutex> lock(mutex);
+				thread_ids.insert(std::this_thread::get_id());
+			}
+
+			running--;
+		}));
+	}
+
+	for (auto &result : results)
+		result.wait();
+
+	CHECK(thread_ids.size() <= 3);
+	CHECK(max_running <= 3);
+	CHECK(thread_ids.count(std::this_thread::get_id()) == 0);
+}
+
+TEST_CASE(default_leaves_one_processor)
+{
+	const worker_pool pool;
+
+	CHECK_EQUAL(pool.num_threads(), std::max(std::thread::hardware_concurrency(), 2u) - 1);
+}
+
+TEST_CASE(destructor_runs_queued_tasks)
+{
+	std::atomic<int> count = 0;
+	std::future<void> last;
+
+	{
+		worker_pool pool(1);
+		for (int i = 0; i < 20; i++)
+			last = pool.submit([&count]() { std::this_thread::sleep_for(std::chrono::microseconds(100)); count++; });
+	}
+
+	// Someone may still wait on the results of tasks which were queued when the pool was destroyed
+	CHECK_EQUAL(count.load(), 20);
+	CHECK(last.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+TEST_CASE(exceptions_reach_the_future)
+{
+	worker_pool pool(1);
+
+	auto result = pool.submit([]() -> bool { throw std::runtime_error("failed"); });
+
+	bool thrown = false;
+	try
+	{
+		result.get();
+	}
+	catch (const std::runtime_error &)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+
+	// The worker thread keeps running after a task threw
+	CHECK(pool.submit([]() { return true; }).get());
+}